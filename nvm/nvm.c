@@ -1,5 +1,8 @@
 #include "nvm.h"
+#include "nvm_maze_journal.h"
+#include "nvm_param_store.h"
 #include "nvm_trace_log.h"
+#include "nvm_write_queue.h"
 
 #include <string.h>
 
@@ -8,23 +11,8 @@
 #endif
 
 #if defined(STM32F413xx)
+/* SPI2 は IMU と共用。FRAM の転送は f413_control.c のバス時間割（制御周期の IMU スロット以外の窓）で行う */
 #include "f413_control.h"
-/* SPI2 バス排他: 1kHz 割り込みの IMU 読取が終わるまで待機 */
-static inline void nvm_wait_spi2_free(void) {
-    while (f413_ctrl_spi2_busy()) { /* spin */ }
-}
-static inline uint32_t nvm_stm32f413_spi2_lock_irq(void) {
-    uint32_t tim5_enabled = NVIC_GetEnableIRQ(TIM5_IRQn);
-    HAL_NVIC_DisableIRQ(TIM5_IRQn);
-    return tim5_enabled;
-}
-static inline void nvm_stm32f413_spi2_unlock_irq(uint32_t tim5_enabled) {
-    if (tim5_enabled != 0U) {
-        HAL_NVIC_EnableIRQ(TIM5_IRQn);
-    }
-}
-#else
-static inline void nvm_wait_spi2_free(void) { }
 #endif
 
 typedef enum {
@@ -43,6 +31,14 @@ static nvm_status_t nvm_stm32f413_fram_write_area(const nvm_area_info_t* info,
                                                    const void* data,
                                                    size_t len);
 static nvm_status_t nvm_stm32f413_fram_erase_area(const nvm_area_info_t* info);
+static nvm_status_t nvm_stm32f413_fram_write_async(const nvm_area_info_t* info,
+                                                   uint32_t offset,
+                                                   const void* data,
+                                                   size_t len,
+                                                   nvm_write_done_fn done,
+                                                   void* ctx);
+static nvm_status_t nvm_stm32f413_fram_barrier(uint32_t timeout_ms, uint8_t take_error);
+static void nvm_stm32f413_fram_kick(void);
 #endif
 
 static nvm_backend_t nvm_get_backend(nvm_area_t area) {
@@ -52,6 +48,7 @@ static nvm_backend_t nvm_get_backend(nvm_area_t area) {
         case NVM_AREA_DISTANCE_PARAMS:
         case NVM_AREA_FLASH_PARAMS:
         case NVM_AREA_MAZE_MAP:
+        case NVM_AREA_MAZE_JOURNAL:
             return NVM_BACKEND_INTERNAL_FLASH;
         default:
             return NVM_BACKEND_NONE;
@@ -64,6 +61,7 @@ static nvm_backend_t nvm_get_backend(nvm_area_t area) {
         case NVM_AREA_FLASH_PARAMS:
         case NVM_AREA_MAZE_MAP:
         case NVM_AREA_TRACE_LOG:
+        case NVM_AREA_TUNE_PARAMS:
             return NVM_BACKEND_EXTERNAL_FRAM;
         default:
             return NVM_BACKEND_NONE;
@@ -76,6 +74,7 @@ static nvm_backend_t nvm_get_backend(nvm_area_t area) {
 
 #if defined(STM32F405xx)
 
+#define NVM_STM32F405_MAZE_JOURNAL_BASE (0x08060000UL)
 #define NVM_STM32F405_IDENTITY_BASE (0x08080000UL)
 #define NVM_STM32F405_DISTANCE_PARAMS_BASE (0x080A0000UL)
 #define NVM_STM32F405_FLASH_PARAMS_BASE (0x080C0000UL)
@@ -89,6 +88,8 @@ static const nvm_area_info_t g_nvm_area_table[NVM_AREA_COUNT] = {
     {NVM_AREA_FLASH_PARAMS, NVM_STM32F405_FLASH_PARAMS_BASE, NVM_STM32F405_SECTOR_SIZE_BYTES, 0x00010001UL},
     {NVM_AREA_MAZE_MAP, NVM_STM32F405_MAZE_MAP_BASE, NVM_STM32F405_SECTOR_SIZE_BYTES, 0x00000000UL},
     {NVM_AREA_TRACE_LOG, 0x00000000UL, 0U, 0U},
+    {NVM_AREA_TUNE_PARAMS, 0x00000000UL, 0U, 0U},
+    {NVM_AREA_MAZE_JOURNAL, NVM_STM32F405_MAZE_JOURNAL_BASE, NVM_STM32F405_SECTOR_SIZE_BYTES, NVM_MAZE_JOURNAL_VERSION},
 };
 
 #elif defined(STM32F413xx)
@@ -105,6 +106,10 @@ static const nvm_area_info_t g_nvm_area_table[NVM_AREA_COUNT] = {
 #define NVM_STM32F413_FRAM_AREA_SIZE_BYTES (128U * 1024U)
 #define NVM_STM32F413_FRAM_DISTANCE_PARAMS_BASE (0x00000000UL)
 #define NVM_STM32F413_FRAM_FLASH_PARAMS_BASE (0x00020000UL)
+/* FLASH_PARAMS（センサ blob は先頭の数十バイト）の後半 64KB を実行時パラメータストアに充てる */
+#define NVM_STM32F413_FRAM_FLASH_PARAMS_SIZE_BYTES (64U * 1024U)
+#define NVM_STM32F413_FRAM_TUNE_PARAMS_BASE (0x00030000UL)
+#define NVM_STM32F413_FRAM_TUNE_PARAMS_SIZE_BYTES (64U * 1024U)
 #define NVM_STM32F413_FRAM_MAZE_MAP_BASE (0x00040000UL)
 #define NVM_STM32F413_FRAM_TRACE_LOG_BASE (0x00060000UL)
 #define NVM_STM32F413_FRAM_TRACE_LOG_SIZE_BYTES \
@@ -115,14 +120,43 @@ static const nvm_area_info_t g_nvm_area_table[NVM_AREA_COUNT] = {
 #define NVM_STM32F413_FRAM_CMD_WRITE (0x02U)
 #define NVM_STM32F413_FRAM_SPI_TIMEOUT_MS (100U)
 
+/* 書き込みキュー: 0 なら同期転送（SPI2 の窓ごとにポーリングで送る）で書く */
+#ifndef NVM_STM32F413_FRAM_WRITE_ASYNC
+#define NVM_STM32F413_FRAM_WRITE_ASYNC (1)
+#endif
+/* SPI2 は 50MHz/32 = 1.56MHz（1 バイト約 5us）。IMU バースト（約 70us）後の残り時間に
+   WREN + コマンド/アドレス + chunk が余裕を持って収まる長さにする */
+#ifndef NVM_STM32F413_FRAM_CHUNK_BYTES
+#define NVM_STM32F413_FRAM_CHUNK_BYTES (128U)
+#endif
+/* 同期書き込み・barrier・読み出し前にキューの完了を待つ上限 */
+#define NVM_STM32F413_FRAM_QUEUE_TIMEOUT_MS (1000U)
+/* SPI2 の占有時間の見積り: 1 バイト 5.12us。ポーリング転送が割り込みで引き延ばされる分を 1/8 見込み、
+   CS 操作等の固定分を足す。見積りが窓（制御周期の残り）に収まるときだけバスを取る */
+#define NVM_STM32F413_FRAM_SETUP_US (10U)
+#define NVM_STM32F413_FRAM_XFER_US(bytes) \
+    (((((uint32_t)(bytes) * 512U + 99U) / 100U) * 9U) / 8U + NVM_STM32F413_FRAM_SETUP_US)
+#define NVM_STM32F413_FRAM_CHUNK_COST_US NVM_STM32F413_FRAM_XFER_US(NVM_STM32F413_FRAM_CHUNK_BYTES + 5U)
+/* 同期読み書きを窓に合わせて切る長さの下限（これ未満しか入らない窓は見送る）と上限 */
+#define NVM_STM32F413_FRAM_SYNC_MIN_BYTES (16U)
+#define NVM_STM32F413_FRAM_SYNC_MAX_BYTES (0x8000U)
+
+/* SPI2_TX = DMA1 Stream4 / Channel0（IMU バーストの TX と共用。SPI2 の占有で排他する） */
+#define NVM_STM32F413_FRAM_DMA_STREAM DMA1_Stream4
+#define NVM_STM32F413_FRAM_DMA_IRQn DMA1_Stream4_IRQn
+#define NVM_STM32F413_FRAM_DMA_CLEAR_FLAGS \
+    (DMA_HIFCR_CTCIF4 | DMA_HIFCR_CHTIF4 | DMA_HIFCR_CTEIF4 | DMA_HIFCR_CDMEIF4 | DMA_HIFCR_CFEIF4)
+
 extern SPI_HandleTypeDef hspi2;
 
 static const nvm_area_info_t g_nvm_area_table[NVM_AREA_COUNT] = {
     {NVM_AREA_IDENTITY, NVM_STM32F413_IDENTITY_BASE, NVM_STM32F413_SECTOR_SIZE_BYTES, 0x00010000UL},
     {NVM_AREA_DISTANCE_PARAMS, NVM_STM32F413_FRAM_DISTANCE_PARAMS_BASE, NVM_STM32F413_FRAM_AREA_SIZE_BYTES, 0x00010000UL},
-    {NVM_AREA_FLASH_PARAMS, NVM_STM32F413_FRAM_FLASH_PARAMS_BASE, NVM_STM32F413_FRAM_AREA_SIZE_BYTES, 0x00010001UL},
+    {NVM_AREA_FLASH_PARAMS, NVM_STM32F413_FRAM_FLASH_PARAMS_BASE, NVM_STM32F413_FRAM_FLASH_PARAMS_SIZE_BYTES, 0x00010001UL},
     {NVM_AREA_MAZE_MAP, NVM_STM32F413_FRAM_MAZE_MAP_BASE, NVM_STM32F413_FRAM_AREA_SIZE_BYTES, 0x00010000UL},
     {NVM_AREA_TRACE_LOG, NVM_STM32F413_FRAM_TRACE_LOG_BASE, NVM_STM32F413_FRAM_TRACE_LOG_SIZE_BYTES, NVM_TRACE_LOG_SCHEMA_VERSION},
+    {NVM_AREA_TUNE_PARAMS, NVM_STM32F413_FRAM_TUNE_PARAMS_BASE, NVM_STM32F413_FRAM_TUNE_PARAMS_SIZE_BYTES, NVM_PARAM_STORE_SCHEMA_VERSION},
+    {NVM_AREA_MAZE_JOURNAL, 0x00000000UL, 0U, 0U},
 };
 
 #else
@@ -133,11 +167,17 @@ static const nvm_area_info_t g_nvm_area_table[NVM_AREA_COUNT] = {
     {NVM_AREA_FLASH_PARAMS, 0x00000000UL, 0U, 0U},
     {NVM_AREA_MAZE_MAP, 0x00000000UL, 0U, 0U},
     {NVM_AREA_TRACE_LOG, 0x00000000UL, 0U, 0U},
+    {NVM_AREA_TUNE_PARAMS, 0x00000000UL, 0U, 0U},
+    {NVM_AREA_MAZE_JOURNAL, 0x00000000UL, 0U, 0U},
 };
 
 #endif
 
 nvm_status_t nvm_init(void) {
+#if defined(STM32F413xx) && NVM_STM32F413_FRAM_WRITE_ASYNC
+    /* IMU 読取が終わるたびに FRAM 書き込みキューの次の chunk を起動する */
+    f413_ctrl_set_spi2_idle_hook(nvm_stm32f413_fram_kick);
+#endif
     return NVM_STATUS_OK;
 }
 
@@ -186,6 +226,11 @@ nvm_status_t nvm_read(nvm_area_t area, uint32_t offset, void* out, size_t len) {
 
         case NVM_BACKEND_EXTERNAL_FRAM:
 #if defined(STM32F413xx)
+            /* 投入済みの書き込みを追い越して古い内容を読まないよう、キューの完了を待つ */
+            st = nvm_stm32f413_fram_barrier(NVM_STM32F413_FRAM_QUEUE_TIMEOUT_MS, 0U);
+            if (st != NVM_STATUS_OK) {
+                return st;
+            }
             return nvm_stm32f413_fram_read_area(&info, offset, out, len);
 #else
             return NVM_STATUS_UNSUPPORTED;
@@ -216,6 +261,9 @@ static nvm_status_t nvm_stm32f405_sector_from_base(uint32_t base_address, uint32
         case NVM_STM32F405_MAZE_MAP_BASE:
             *out_sector = FLASH_SECTOR_11;
             return NVM_STATUS_OK;
+        case NVM_STM32F405_MAZE_JOURNAL_BASE:
+            *out_sector = FLASH_SECTOR_7;
+            return NVM_STATUS_OK;
         default:
             return NVM_STATUS_UNSUPPORTED;
     }
@@ -332,80 +380,83 @@ static nvm_status_t nvm_stm32f405_write_area(const nvm_area_info_t* info,
 
 #elif defined(STM32F413xx)
 
-static HAL_StatusTypeDef nvm_stm32f413_fram_write_enable(void) {
-    uint8_t cmd = NVM_STM32F413_FRAM_CMD_WREN;
-    uint32_t tim5_enabled;
-    HAL_StatusTypeDef result = HAL_OK;
+/* 窓（制御周期の IMU スロット以外の残り時間）に入る同期転送のバイト数。overhead はコマンド分 */
+static uint32_t nvm_stm32f413_fram_fit_bytes(uint32_t window_us, uint32_t overhead) {
+    uint32_t bytes;
 
-    if (hspi2.Instance == NULL) {
-        return HAL_ERROR;
+    if (window_us == UINT32_MAX) {
+        return NVM_STM32F413_FRAM_SYNC_MAX_BYTES;
     }
+    if (window_us <= NVM_STM32F413_FRAM_SETUP_US) {
+        return 0U;
+    }
+    bytes = ((((window_us - NVM_STM32F413_FRAM_SETUP_US) * 8U) / 9U) * 100U) / 512U;
+    return (bytes > overhead) ? (bytes - overhead) : 0U;
+}
 
-    nvm_wait_spi2_free();
-    tim5_enabled = nvm_stm32f413_spi2_lock_irq();
-    HAL_GPIO_WritePin(IMU_CS_GPIO_Port, IMU_CS_Pin, GPIO_PIN_SET);
-    HAL_GPIO_WritePin(FRAM_CS_GPIO_Port, FRAM_CS_Pin, GPIO_PIN_SET);
-    HAL_GPIO_WritePin(FRAM_CS_GPIO_Port, FRAM_CS_Pin, GPIO_PIN_RESET);
+/* SPI2 の窓を待って、len 以下で窓に収まる長さ分だけバスを取る（取れた長さを返す。時間切れは 0）。
+   収まる長さが下限未満の窓は見送り、次の周期の IMU 読取が終わるのを待つ。 */
+static uint32_t nvm_stm32f413_fram_acquire(uint32_t len, uint32_t overhead, uint32_t start_tick) {
+    const uint32_t min_len = (len < NVM_STM32F413_FRAM_SYNC_MIN_BYTES) ? len : NVM_STM32F413_FRAM_SYNC_MIN_BYTES;
 
-    if (HAL_SPI_Transmit(&hspi2, &cmd, 1U, NVM_STM32F413_FRAM_SPI_TIMEOUT_MS) != HAL_OK) {
-        result = HAL_ERROR;
+    for (;;) {
+        uint32_t n = nvm_stm32f413_fram_fit_bytes(f413_ctrl_spi2_fram_window_us(), overhead);
+        if (n > len) {
+            n = len;
+        }
+        if ((n >= min_len) && f413_ctrl_spi2_fram_begin(NVM_STM32F413_FRAM_XFER_US(n + overhead))) {
+            return n;
+        }
+        if ((HAL_GetTick() - start_tick) > NVM_STM32F413_FRAM_SPI_TIMEOUT_MS) {
+            return 0U;
+        }
     }
-
-    HAL_GPIO_WritePin(FRAM_CS_GPIO_Port, FRAM_CS_Pin, GPIO_PIN_SET);
-    nvm_stm32f413_spi2_unlock_irq(tim5_enabled);
-    return result;
 }
 
-static HAL_StatusTypeDef nvm_stm32f413_fram_read_raw(uint32_t address, void* out, size_t len) {
+/* SPI2 を取った状態で 1 回分を読む（READ）/ 書く（WREN + WRITE） */
+static HAL_StatusTypeDef nvm_stm32f413_fram_xfer_chunk(uint8_t opcode, uint32_t address, uint8_t* buf, uint32_t len) {
     uint8_t cmd[4];
-    uint32_t tim5_enabled;
     HAL_StatusTypeDef result = HAL_OK;
 
-    if ((out == NULL) && (len > 0U)) {
-        return HAL_ERROR;
-    }
-    if ((size_t)address + len > (size_t)NVM_STM32F413_FRAM_TOTAL_BYTES) {
-        return HAL_ERROR;
-    }
-    if (hspi2.Instance == NULL) {
-        return HAL_ERROR;
-    }
-    if (len == 0U) {
-        return HAL_OK;
+    HAL_GPIO_WritePin(IMU_CS_GPIO_Port, IMU_CS_Pin, GPIO_PIN_SET);
+    HAL_GPIO_WritePin(FRAM_CS_GPIO_Port, FRAM_CS_Pin, GPIO_PIN_SET);
+
+    if (opcode == NVM_STM32F413_FRAM_CMD_WRITE) {
+        uint8_t wren = NVM_STM32F413_FRAM_CMD_WREN;
+        HAL_GPIO_WritePin(FRAM_CS_GPIO_Port, FRAM_CS_Pin, GPIO_PIN_RESET);
+        result = HAL_SPI_Transmit(&hspi2, &wren, 1U, NVM_STM32F413_FRAM_SPI_TIMEOUT_MS);
+        HAL_GPIO_WritePin(FRAM_CS_GPIO_Port, FRAM_CS_Pin, GPIO_PIN_SET);
+        if (result != HAL_OK) {
+            return HAL_ERROR;
+        }
     }
 
-    nvm_wait_spi2_free();
-    tim5_enabled = nvm_stm32f413_spi2_lock_irq();
-    cmd[0] = NVM_STM32F413_FRAM_CMD_READ;
+    cmd[0] = opcode;
     cmd[1] = (uint8_t)(address >> 16);
     cmd[2] = (uint8_t)(address >> 8);
     cmd[3] = (uint8_t)address;
 
-    HAL_GPIO_WritePin(IMU_CS_GPIO_Port, IMU_CS_Pin, GPIO_PIN_SET);
-    HAL_GPIO_WritePin(FRAM_CS_GPIO_Port, FRAM_CS_Pin, GPIO_PIN_SET);
     HAL_GPIO_WritePin(FRAM_CS_GPIO_Port, FRAM_CS_Pin, GPIO_PIN_RESET);
-
     if (HAL_SPI_Transmit(&hspi2, cmd, sizeof(cmd), NVM_STM32F413_FRAM_SPI_TIMEOUT_MS) != HAL_OK) {
         result = HAL_ERROR;
-        goto done;
-    }
-
-    if (HAL_SPI_Receive(&hspi2, (uint8_t*)out, (uint16_t)len, NVM_STM32F413_FRAM_SPI_TIMEOUT_MS) != HAL_OK) {
-        result = HAL_ERROR;
+    } else if (opcode == NVM_STM32F413_FRAM_CMD_READ) {
+        if (HAL_SPI_Receive(&hspi2, buf, (uint16_t)len, NVM_STM32F413_FRAM_SPI_TIMEOUT_MS) != HAL_OK) {
+            result = HAL_ERROR;
+        }
+    } else {
+        if (HAL_SPI_Transmit(&hspi2, buf, (uint16_t)len, NVM_STM32F413_FRAM_SPI_TIMEOUT_MS) != HAL_OK) {
+            result = HAL_ERROR;
+        }
     }
-
-done:
     HAL_GPIO_WritePin(FRAM_CS_GPIO_Port, FRAM_CS_Pin, GPIO_PIN_SET);
-    nvm_stm32f413_spi2_unlock_irq(tim5_enabled);
     return result;
 }
 
-static HAL_StatusTypeDef nvm_stm32f413_fram_write_raw(uint32_t address, const void* data, size_t len) {
-    uint8_t cmd[4];
-    uint32_t tim5_enabled;
-    HAL_StatusTypeDef result = HAL_OK;
+/* 同期転送: 制御 tick を止めずに、SPI2 の窓に収まる長さずつポーリングで送受信する */
+static HAL_StatusTypeDef nvm_stm32f413_fram_xfer(uint8_t opcode, uint32_t address, uint8_t* buf, size_t len) {
+    const uint32_t overhead = (opcode == NVM_STM32F413_FRAM_CMD_WRITE) ? 5U : 4U;
 
-    if ((data == NULL) && (len > 0U)) {
+    if ((buf == NULL) && (len > 0U)) {
         return HAL_ERROR;
     }
     if ((size_t)address + len > (size_t)NVM_STM32F413_FRAM_TOTAL_BYTES) {
@@ -414,54 +465,327 @@ static HAL_StatusTypeDef nvm_stm32f413_fram_write_raw(uint32_t address, const vo
     if (hspi2.Instance == NULL) {
         return HAL_ERROR;
     }
-    if (len == 0U) {
-        return HAL_OK;
+
+    while (len > 0U) {
+        uint32_t want = (len > NVM_STM32F413_FRAM_SYNC_MAX_BYTES) ? NVM_STM32F413_FRAM_SYNC_MAX_BYTES : (uint32_t)len;
+        uint32_t n = nvm_stm32f413_fram_acquire(want, overhead, HAL_GetTick());
+        HAL_StatusTypeDef result;
+
+        if (n == 0U) {
+            return HAL_TIMEOUT;
+        }
+        result = nvm_stm32f413_fram_xfer_chunk(opcode, address, buf, n);
+        f413_ctrl_spi2_fram_end();
+        if (result != HAL_OK) {
+            return result;
+        }
+        address += n;
+        buf += n;
+        len -= n;
     }
+    return HAL_OK;
+}
 
-    if (nvm_stm32f413_fram_write_enable() != HAL_OK) {
-        return HAL_ERROR;
+static HAL_StatusTypeDef nvm_stm32f413_fram_read_raw(uint32_t address, void* out, size_t len) {
+    return nvm_stm32f413_fram_xfer(NVM_STM32F413_FRAM_CMD_READ, address, (uint8_t*)out, len);
+}
+
+static HAL_StatusTypeDef nvm_stm32f413_fram_write_raw(uint32_t address, const void* data, size_t len) {
+    return nvm_stm32f413_fram_xfer(NVM_STM32F413_FRAM_CMD_WRITE, address, (uint8_t*)data, len);
+}
+
+static nvm_status_t nvm_stm32f413_fram_read_area(const nvm_area_info_t* info,
+                                                  uint32_t offset,
+                                                  void* out,
+                                                  size_t len) {
+    if (info == NULL) {
+        return NVM_STATUS_INVALID_ARG;
+    }
+    if ((out == NULL) && (len > 0U)) {
+        return NVM_STATUS_INVALID_ARG;
     }
 
-    cmd[0] = NVM_STM32F413_FRAM_CMD_WRITE;
-    cmd[1] = (uint8_t)(address >> 16);
-    cmd[2] = (uint8_t)(address >> 8);
-    cmd[3] = (uint8_t)address;
+    if (nvm_stm32f413_fram_read_raw(info->base_address + offset, out, len) != HAL_OK) {
+        return NVM_STATUS_HW_ERROR;
+    }
+    return NVM_STATUS_OK;
+}
+
+/* ---- 非同期書き込みキュー ----
+   要求を NVM_STM32F413_FRAM_CHUNK_BYTES ごとに分け、SPI2 を取れたときに 1 chunk を
+   WREN + WRITE ヘッダ（ポーリング）+ データ（DMA）で送る。走行中（制御 tick が毎周期 IMU を
+   読む間）は IMU 読取の完了通知から、chunk が次の IMU スロットまでに終わる窓でだけ 1 tick に
+   1 chunk、停止中は完了割り込みから続けて送る。 */
+#if NVM_STM32F413_FRAM_WRITE_ASYNC
+
+typedef struct {
+    volatile uint8_t done;
+    volatile nvm_status_t status;
+} nvm_stm32f413_fram_wait_t;
+
+static nvm_write_queue_t g_nvm_fram_queue;
+static volatile uint8_t g_nvm_fram_queue_ready = 0U;
+static volatile uint8_t g_nvm_fram_dma_active = 0U;
+
+static inline uint32_t nvm_stm32f413_irq_save(void) {
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    return primask;
+}
+
+static inline void nvm_stm32f413_irq_restore(uint32_t primask) {
+    __set_PRIMASK(primask);
+}
+
+/* SPI2 の初期化後に最初の非同期書き込みで DMA を準備する（nvm_init は MX_SPI2_Init より前） */
+static uint8_t nvm_stm32f413_fram_queue_prepare(void) {
+    if (g_nvm_fram_queue_ready != 0U) {
+        return 1U;
+    }
+    if ((hspi2.Instance == NULL) || (hspi2.State == HAL_SPI_STATE_RESET)) {
+        return 0U;
+    }
+
+    nvm_write_queue_init(&g_nvm_fram_queue, NVM_STM32F413_FRAM_CHUNK_BYTES);
+    __HAL_RCC_DMA1_CLK_ENABLE();
+    NVM_STM32F413_FRAM_DMA_STREAM->CR &= ~DMA_SxCR_EN;
+    while ((NVM_STM32F413_FRAM_DMA_STREAM->CR & DMA_SxCR_EN) != 0U) { }
+    DMA1->HIFCR = NVM_STM32F413_FRAM_DMA_CLEAR_FLAGS;
+    /* chunk 完了で SPI2 を早く返すよう IMU の DMA と同じ最高優先度 */
+    HAL_NVIC_SetPriority(NVM_STM32F413_FRAM_DMA_IRQn, 0, 0);
+    HAL_NVIC_EnableIRQ(NVM_STM32F413_FRAM_DMA_IRQn);
+    g_nvm_fram_queue_ready = 1U;
+    return 1U;
+}
+
+static void nvm_stm32f413_spi2_put(uint8_t b) {
+    while ((SPI2->SR & SPI_SR_TXE) == 0U) { }
+    *(volatile uint8_t*)&SPI2->DR = b;
+}
+
+/* 送信完了まで待ち、送信のみで溜まった RXNE/OVR を捨てる */
+static void nvm_stm32f413_spi2_drain(void) {
+    while ((SPI2->SR & SPI_SR_TXE) == 0U) { }
+    while ((SPI2->SR & SPI_SR_BSY) != 0U) { }
+    (void)SPI2->DR;
+    (void)SPI2->SR;
+}
 
-    nvm_wait_spi2_free();
-    tim5_enabled = nvm_stm32f413_spi2_lock_irq();
+/* SPI2 を占有した状態で呼ぶ */
+static void nvm_stm32f413_fram_chunk_start(uint32_t address, const uint8_t* data, uint32_t len) {
+    SPI2->CR1 |= SPI_CR1_SPE;
     HAL_GPIO_WritePin(IMU_CS_GPIO_Port, IMU_CS_Pin, GPIO_PIN_SET);
+
+    HAL_GPIO_WritePin(FRAM_CS_GPIO_Port, FRAM_CS_Pin, GPIO_PIN_RESET);
+    nvm_stm32f413_spi2_put(NVM_STM32F413_FRAM_CMD_WREN);
+    nvm_stm32f413_spi2_drain();
     HAL_GPIO_WritePin(FRAM_CS_GPIO_Port, FRAM_CS_Pin, GPIO_PIN_SET);
+
     HAL_GPIO_WritePin(FRAM_CS_GPIO_Port, FRAM_CS_Pin, GPIO_PIN_RESET);
+    nvm_stm32f413_spi2_put(NVM_STM32F413_FRAM_CMD_WRITE);
+    nvm_stm32f413_spi2_put((uint8_t)(address >> 16));
+    nvm_stm32f413_spi2_put((uint8_t)(address >> 8));
+    nvm_stm32f413_spi2_put((uint8_t)address);
+    nvm_stm32f413_spi2_drain();
+
+    DMA1->HIFCR = NVM_STM32F413_FRAM_DMA_CLEAR_FLAGS;
+    NVM_STM32F413_FRAM_DMA_STREAM->PAR = (uint32_t)&SPI2->DR;
+    NVM_STM32F413_FRAM_DMA_STREAM->M0AR = (uint32_t)data;
+    NVM_STM32F413_FRAM_DMA_STREAM->NDTR = len;
+    NVM_STM32F413_FRAM_DMA_STREAM->FCR = 0U; /* ダイレクトモード */
+    NVM_STM32F413_FRAM_DMA_STREAM->CR = DMA_SxCR_PL_1 | /* Channel0, メモリ→ペリフェラル */
+                                        DMA_SxCR_DIR_0 |
+                                        DMA_SxCR_MINC |
+                                        DMA_SxCR_TCIE |
+                                        DMA_SxCR_TEIE;
+    NVM_STM32F413_FRAM_DMA_STREAM->CR |= DMA_SxCR_EN;
+    SPI2->CR2 |= SPI_CR2_TXDMAEN;
+}
 
-    if (HAL_SPI_Transmit(&hspi2, cmd, sizeof(cmd), NVM_STM32F413_FRAM_SPI_TIMEOUT_MS) != HAL_OK) {
-        result = HAL_ERROR;
-        goto done;
+/* DMA 完了（またはエラー）: CS を上げて SPI2 を返し、キューを進める */
+static void nvm_stm32f413_fram_chunk_finish(nvm_status_t status) {
+    SPI2->CR2 &= ~SPI_CR2_TXDMAEN;
+    NVM_STM32F413_FRAM_DMA_STREAM->CR &= ~(DMA_SxCR_EN | DMA_SxCR_TCIE | DMA_SxCR_TEIE);
+    while ((NVM_STM32F413_FRAM_DMA_STREAM->CR & DMA_SxCR_EN) != 0U) { }
+    DMA1->HIFCR = NVM_STM32F413_FRAM_DMA_CLEAR_FLAGS;
+    nvm_stm32f413_spi2_drain();
+    HAL_GPIO_WritePin(FRAM_CS_GPIO_Port, FRAM_CS_Pin, GPIO_PIN_SET);
+
+    g_nvm_fram_dma_active = 0U;
+    nvm_write_queue_chunk_done(&g_nvm_fram_queue, status);
+    f413_ctrl_spi2_fram_end();
+}
+
+/* 次の chunk を起動する（SPI2 が使用中・窓に収まらない・キューが空なら何もしない）。割り込みからも呼ぶ。 */
+static void nvm_stm32f413_fram_kick(void) {
+    uint32_t address;
+    uint32_t len;
+    const uint8_t* data;
+    uint32_t primask;
+
+    if ((g_nvm_fram_queue_ready == 0U) || (g_nvm_fram_dma_active != 0U)) {
+        return;
     }
 
-    if (HAL_SPI_Transmit(&hspi2, (uint8_t*)data, (uint16_t)len, NVM_STM32F413_FRAM_SPI_TIMEOUT_MS) != HAL_OK) {
-        result = HAL_ERROR;
+    primask = nvm_stm32f413_irq_save();
+    if ((g_nvm_fram_dma_active != 0U) || nvm_write_queue_idle(&g_nvm_fram_queue) ||
+        !f413_ctrl_spi2_fram_begin(NVM_STM32F413_FRAM_CHUNK_COST_US)) {
+        nvm_stm32f413_irq_restore(primask);
+        return;
     }
+    if (!nvm_write_queue_next_chunk(&g_nvm_fram_queue, &address, &data, &len)) {
+        /* 長さ 0 の要求だけが残っていた（next_chunk 内で完了済み） */
+        f413_ctrl_spi2_fram_end();
+        nvm_stm32f413_irq_restore(primask);
+        return;
+    }
+    g_nvm_fram_dma_active = 1U;
+    nvm_stm32f413_irq_restore(primask);
 
-done:
-    HAL_GPIO_WritePin(FRAM_CS_GPIO_Port, FRAM_CS_Pin, GPIO_PIN_SET);
-    nvm_stm32f413_spi2_unlock_irq(tim5_enabled);
-    return result;
+    nvm_stm32f413_fram_chunk_start(address, data, len);
 }
 
-static nvm_status_t nvm_stm32f413_fram_read_area(const nvm_area_info_t* info,
-                                                  uint32_t offset,
-                                                  void* out,
-                                                  size_t len) {
+void nvm_fram_dma_irq_handler(void) {
+    uint32_t hisr = DMA1->HISR;
+
+    if ((g_nvm_fram_dma_active == 0U) || ((hisr & (DMA_HISR_TCIF4 | DMA_HISR_TEIF4)) == 0U)) {
+        return;
+    }
+    nvm_stm32f413_fram_chunk_finish(((hisr & DMA_HISR_TEIF4) != 0U) ? NVM_STATUS_HW_ERROR
+                                                                     : NVM_STATUS_OK);
+    /* 走行中は次の IMU 読取が終わるまで待つ。停止中は続けて送る。 */
+    if (!f413_ctrl_spi2_imu_scheduled()) {
+        nvm_stm32f413_fram_kick();
+    }
+}
+
+/* 時間切れ: 転送中の chunk を打ち切り、残りの要求をすべて失敗として完了させる */
+static void nvm_stm32f413_fram_fail_all(void) {
+    uint32_t address;
+    uint32_t len;
+    const uint8_t* data;
+    uint32_t primask = nvm_stm32f413_irq_save();
+
+    if (g_nvm_fram_dma_active != 0U) {
+        nvm_stm32f413_fram_chunk_finish(NVM_STATUS_HW_ERROR);
+    }
+    while (nvm_write_queue_next_chunk(&g_nvm_fram_queue, &address, &data, &len)) {
+        nvm_write_queue_chunk_done(&g_nvm_fram_queue, NVM_STATUS_HW_ERROR);
+    }
+    nvm_stm32f413_irq_restore(primask);
+}
+
+static nvm_status_t nvm_stm32f413_fram_barrier(uint32_t timeout_ms, uint8_t take_error) {
+    uint32_t start = HAL_GetTick();
+    nvm_status_t st = NVM_STATUS_OK;
+    uint32_t primask;
+
+    if (g_nvm_fram_queue_ready == 0U) {
+        return NVM_STATUS_OK;
+    }
+    while (!nvm_write_queue_idle(&g_nvm_fram_queue)) {
+        nvm_stm32f413_fram_kick();
+        if ((HAL_GetTick() - start) > timeout_ms) {
+            nvm_stm32f413_fram_fail_all();
+            st = NVM_STATUS_BUSY;
+            break;
+        }
+    }
+    if (take_error != 0U) {
+        primask = nvm_stm32f413_irq_save();
+        nvm_status_t err = nvm_write_queue_take_error(&g_nvm_fram_queue);
+        nvm_stm32f413_irq_restore(primask);
+        if (st == NVM_STATUS_OK) {
+            st = err;
+        }
+    }
+    return st;
+}
+
+static void nvm_stm32f413_fram_wait_done(nvm_status_t status, void* ctx) {
+    nvm_stm32f413_fram_wait_t* w = (nvm_stm32f413_fram_wait_t*)ctx;
+    w->status = status;
+    w->done = 1U;
+}
+
+static nvm_status_t nvm_stm32f413_fram_write_async(const nvm_area_info_t* info,
+                                                   uint32_t offset,
+                                                   const void* data,
+                                                   size_t len,
+                                                   nvm_write_done_fn done,
+                                                   void* ctx) {
+    uint32_t start = HAL_GetTick();
+    uint32_t primask;
+    bool queued;
+
+    if (nvm_stm32f413_fram_queue_prepare() == 0U) {
+        nvm_status_t st = NVM_STATUS_OK;
+        if (nvm_stm32f413_fram_write_raw(info->base_address + offset, data, len) != HAL_OK) {
+            st = NVM_STATUS_HW_ERROR;
+        }
+        if (done != NULL) {
+            done(st, ctx);
+        }
+        return st;
+    }
+
+    for (;;) {
+        primask = nvm_stm32f413_irq_save();
+        queued = nvm_write_queue_push(&g_nvm_fram_queue, info->base_address + offset, data,
+                                      (uint32_t)len, done, ctx, NULL);
+        nvm_stm32f413_irq_restore(primask);
+        nvm_stm32f413_fram_kick();
+        if (queued) {
+            return NVM_STATUS_OK;
+        }
+        if ((HAL_GetTick() - start) > NVM_STM32F413_FRAM_QUEUE_TIMEOUT_MS) {
+            return NVM_STATUS_BUSY;
+        }
+    }
+}
+
+/* 同期書き込み: キューに積んで自分の要求の完了を待つ（先行する要求との順序を保つ） */
+static nvm_status_t nvm_stm32f413_fram_write_area(const nvm_area_info_t* info,
+                                                   uint32_t offset,
+                                                   const void* data,
+                                                   size_t len) {
+    nvm_stm32f413_fram_wait_t w = {0U, NVM_STATUS_OK};
+    uint32_t start;
+    nvm_status_t st;
+
     if (info == NULL) {
         return NVM_STATUS_INVALID_ARG;
     }
-    if ((out == NULL) && (len > 0U)) {
+    if ((data == NULL) && (len > 0U)) {
         return NVM_STATUS_INVALID_ARG;
     }
 
-    if (nvm_stm32f413_fram_read_raw(info->base_address + offset, out, len) != HAL_OK) {
-        return NVM_STATUS_HW_ERROR;
+    st = nvm_stm32f413_fram_write_async(info, offset, data, len, nvm_stm32f413_fram_wait_done, &w);
+    if (st != NVM_STATUS_OK) {
+        return st;
     }
+    start = HAL_GetTick();
+    while (w.done == 0U) {
+        nvm_stm32f413_fram_kick();
+        if ((HAL_GetTick() - start) > NVM_STM32F413_FRAM_QUEUE_TIMEOUT_MS) {
+            /* data はスタック上のことがあるため、戻る前に転送を必ず終わらせる */
+            nvm_stm32f413_fram_fail_all();
+        }
+    }
+    return w.status;
+}
+
+#else
+
+void nvm_fram_dma_irq_handler(void) {
+}
+
+static void nvm_stm32f413_fram_kick(void) {
+}
+
+static nvm_status_t nvm_stm32f413_fram_barrier(uint32_t timeout_ms, uint8_t take_error) {
+    (void)timeout_ms;
+    (void)take_error;
     return NVM_STATUS_OK;
 }
 
@@ -482,6 +806,21 @@ static nvm_status_t nvm_stm32f413_fram_write_area(const nvm_area_info_t* info,
     return NVM_STATUS_OK;
 }
 
+static nvm_status_t nvm_stm32f413_fram_write_async(const nvm_area_info_t* info,
+                                                   uint32_t offset,
+                                                   const void* data,
+                                                   size_t len,
+                                                   nvm_write_done_fn done,
+                                                   void* ctx) {
+    nvm_status_t st = nvm_stm32f413_fram_write_area(info, offset, data, len);
+    if (done != NULL) {
+        done(st, ctx);
+    }
+    return st;
+}
+
+#endif
+
 static nvm_status_t nvm_stm32f413_fram_erase_area(const nvm_area_info_t* info) {
     (void)info;
     return NVM_STATUS_OK;
@@ -692,3 +1031,53 @@ nvm_status_t nvm_erase(nvm_area_t area) {
 
     return NVM_STATUS_UNSUPPORTED;
 }
+
+nvm_status_t nvm_write_async(nvm_area_t area,
+                             uint32_t offset,
+                             const void* data,
+                             size_t len,
+                             nvm_write_done_fn done,
+                             void* ctx) {
+    nvm_area_info_t info;
+    nvm_status_t st;
+
+    st = nvm_get_area_info(area, &info);
+    if (st != NVM_STATUS_OK) {
+        return st;
+    }
+    if ((data == NULL) && (len > 0U)) {
+        return NVM_STATUS_INVALID_ARG;
+    }
+    if ((size_t)offset > (size_t)info.size_bytes) {
+        return NVM_STATUS_INVALID_ARG;
+    }
+    if (len > ((size_t)info.size_bytes - (size_t)offset)) {
+        return NVM_STATUS_INVALID_ARG;
+    }
+
+#if defined(STM32F413xx)
+    if ((nvm_get_backend(area) == NVM_BACKEND_EXTERNAL_FRAM) && (len > 0U)) {
+        return nvm_stm32f413_fram_write_async(&info, offset, data, len, done, ctx);
+    }
+#endif
+
+    st = nvm_write(area, offset, data, len);
+    if (done != NULL) {
+        done(st, ctx);
+    }
+    return st;
+}
+
+nvm_status_t nvm_write_barrier(uint32_t timeout_ms) {
+#if defined(STM32F413xx)
+    return nvm_stm32f413_fram_barrier(timeout_ms, 1U);
+#else
+    (void)timeout_ms;
+    return NVM_STATUS_OK;
+#endif
+}
+
+#if !defined(STM32F413xx)
+void nvm_fram_dma_irq_handler(void) {
+}
+#endif
@@ -15,6 +15,7 @@ typedef enum {
     NVM_STATUS_NOT_FOUND,
     NVM_STATUS_INTEGRITY_ERROR,
     NVM_STATUS_HW_ERROR,
+    NVM_STATUS_BUSY,
 } nvm_status_t;
 
 typedef enum {
@@ -23,6 +24,8 @@ typedef enum {
     NVM_AREA_FLASH_PARAMS,
     NVM_AREA_MAZE_MAP,
     NVM_AREA_TRACE_LOG,
+    NVM_AREA_TUNE_PARAMS, // 実行時パラメータストア（nvm_param_store.h）
+    NVM_AREA_MAZE_JOURNAL, // 迷路ジャーナルのもう一方のセクタ（F405。nvm_maze_journal.h）
     NVM_AREA_COUNT,
 } nvm_area_t;
 
@@ -39,6 +42,23 @@ nvm_status_t nvm_read(nvm_area_t area, uint32_t offset, void* out, size_t len);
 nvm_status_t nvm_write(nvm_area_t area, uint32_t offset, const void* data, size_t len);
 nvm_status_t nvm_erase(nvm_area_t area);
 
+/* 非同期書き込み（F413 の FRAM 領域: 書き込みキューに積んで戻り、IMU 読取の合間に DMA で送出）
+ * - data は done が呼ばれるまで呼び出し側で保持すること。done は割り込みから呼ばれることがある
+ * - FRAM 以外の領域・キュー未初期化時は同期で書いてから done を呼ぶ
+ * - キューが満杯なら空くまで待つ（時間切れは NVM_STATUS_BUSY） */
+typedef void (*nvm_write_done_fn)(nvm_status_t status, void* ctx);
+nvm_status_t nvm_write_async(nvm_area_t area,
+                             uint32_t offset,
+                             const void* data,
+                             size_t len,
+                             nvm_write_done_fn done,
+                             void* ctx);
+/* それまでに投入した非同期書き込みがすべて完了するまで待つ（迷路保存などの区切り）。
+ * 前回の barrier 以降に失敗した書き込みがあればその状態を返す。 */
+nvm_status_t nvm_write_barrier(uint32_t timeout_ms);
+/* FRAM 書き込み用 DMA（DMA1 Stream4, SPI2 TX）の割り込み（stm32f4xx_it.c から呼ぶ） */
+void nvm_fram_dma_irq_handler(void);
+
 #ifdef __cplusplus
 }
 #endif
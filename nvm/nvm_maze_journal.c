@@ -0,0 +1,401 @@
+#include "nvm_maze_journal.h"
+
+#include <stddef.h>
+#include <string.h>
+
+#define NVM_MAZE_JOURNAL_IO_WORDS (32U) // 1 回の nvm_read / nvm_write で扱う語数
+#define NVM_MAZE_JOURNAL_ERASED (0xFFFFFFFFUL)
+#define NVM_MAZE_JOURNAL_TAG_SHIFT (30U)
+#define NVM_MAZE_JOURNAL_TAG_ENTRY (2U)  // 10
+#define NVM_MAZE_JOURNAL_TAG_COMMIT (1U) // 01
+
+static uint32_t nvm_maze_journal_crc32(uint32_t crc, const uint8_t* data, uint32_t len) {
+    uint32_t i;
+    uint32_t b;
+
+    crc = ~crc;
+    for (i = 0U; i < len; ++i) {
+        crc ^= data[i];
+        for (b = 0U; b < 8U; ++b) {
+            crc = ((crc & 1U) != 0U) ? ((crc >> 1) ^ 0xEDB88320UL) : (crc >> 1);
+        }
+    }
+    return ~crc;
+}
+
+// CRC-16/CCITT-FALSE（初期値は呼び出し側。新しく始めるときは 0xFFFF）
+uint16_t nvm_maze_journal_crc16(uint16_t crc, const uint8_t* data, uint32_t len) {
+    uint32_t i;
+    uint32_t b;
+
+    for (i = 0U; i < len; ++i) {
+        crc ^= (uint16_t)((uint16_t)data[i] << 8);
+        for (b = 0U; b < 8U; ++b) {
+            crc = ((crc & 0x8000U) != 0U) ? (uint16_t)((crc << 1) ^ 0x1021U) : (uint16_t)(crc << 1);
+        }
+    }
+    return crc;
+}
+
+static uint32_t nvm_maze_journal_start(const nvm_maze_journal_t* j) {
+    return ((uint32_t)sizeof(nvm_maze_journal_header_t) + j->cell_count * 2U + 3U) & ~3UL;
+}
+
+static uint32_t nvm_maze_journal_entry(uint32_t index, uint16_t value) {
+    return (NVM_MAZE_JOURNAL_TAG_ENTRY << NVM_MAZE_JOURNAL_TAG_SHIFT) | (index << 16) | value;
+}
+
+static uint32_t nvm_maze_journal_commit(uint32_t count, uint16_t crc) {
+    return (NVM_MAZE_JOURNAL_TAG_COMMIT << NVM_MAZE_JOURNAL_TAG_SHIFT) | (count << 16) | crc;
+}
+
+static uint32_t nvm_maze_journal_header_crc(const nvm_maze_journal_header_t* h) {
+    return nvm_maze_journal_crc32(0U, (const uint8_t*)h, (uint32_t)offsetof(nvm_maze_journal_header_t, header_crc));
+}
+
+nvm_status_t nvm_maze_journal_init(nvm_maze_journal_t* j, nvm_area_t area0, nvm_area_t area1, uint32_t cell_count) {
+    nvm_area_info_t info[NVM_MAZE_JOURNAL_SECTORS];
+    nvm_status_t st;
+    uint32_t i;
+
+    if (j == NULL || cell_count == 0U || cell_count > NVM_MAZE_JOURNAL_MAX_CELLS ||
+        cell_count > NVM_MAZE_JOURNAL_MAX_INDEX + 1U || area0 == area1) {
+        return NVM_STATUS_INVALID_ARG;
+    }
+    memset(j, 0, sizeof(*j));
+    j->area[0] = area0;
+    j->area[1] = area1;
+    j->cell_count = cell_count;
+    for (i = 0U; i < NVM_MAZE_JOURNAL_SECTORS; ++i) {
+        st = nvm_get_area_info(j->area[i], &info[i]);
+        if (st != NVM_STATUS_OK) {
+            return st;
+        }
+        j->sector_bytes[i] = info[i].size_bytes & ~3UL;
+    }
+    // 切り替え先でも同じ位置に書くので同じ大きさを要求する。エントリ 1 件 + コミットは入ること
+    if (j->sector_bytes[0] != j->sector_bytes[1] || j->sector_bytes[0] < nvm_maze_journal_start(j) + 8U) {
+        return NVM_STATUS_INVALID_ARG;
+    }
+    return NVM_STATUS_OK;
+}
+
+// ヘッダとスナップショットの CRC を確かめる
+static nvm_status_t nvm_maze_journal_check_sector(const nvm_maze_journal_t* j,
+                                                  uint32_t sector,
+                                                  nvm_maze_journal_header_t* h) {
+    uint32_t buf[NVM_MAZE_JOURNAL_IO_WORDS];
+    uint32_t offset = (uint32_t)sizeof(*h);
+    uint32_t left = j->cell_count * 2U;
+    uint32_t crc = 0U;
+    nvm_status_t st;
+
+    st = nvm_read(j->area[sector], 0U, h, sizeof(*h));
+    if (st != NVM_STATUS_OK) {
+        return st;
+    }
+    if (h->magic != NVM_MAZE_JOURNAL_MAGIC) {
+        return NVM_STATUS_NOT_FOUND;
+    }
+    if (nvm_maze_journal_header_crc(h) != h->header_crc ||
+        (h->version >> 16) != (NVM_MAZE_JOURNAL_VERSION >> 16) || h->cell_count != j->cell_count) {
+        return NVM_STATUS_INTEGRITY_ERROR;
+    }
+    while (left > 0U) {
+        uint32_t n = (left < sizeof(buf)) ? left : (uint32_t)sizeof(buf);
+
+        st = nvm_read(j->area[sector], offset, buf, n);
+        if (st != NVM_STATUS_OK) {
+            return st;
+        }
+        crc = nvm_maze_journal_crc32(crc, (const uint8_t*)buf, n);
+        offset += n;
+        left -= n;
+    }
+    return (crc == h->snapshot_crc) ? NVM_STATUS_OK : NVM_STATUS_INTEGRITY_ERROR;
+}
+
+/* コミット語の直前 count 語が揃っているか確かめ、揃っていれば控えに反映する。
+ * 検証と反映は分けて 2 回読む（途中までの反映を残さない） */
+static nvm_status_t nvm_maze_journal_apply_batch(nvm_maze_journal_t* j,
+                                                 uint32_t commit_offset,
+                                                 uint32_t count,
+                                                 uint16_t expect_crc,
+                                                 bool* out_ok) {
+    uint32_t buf[NVM_MAZE_JOURNAL_IO_WORDS];
+    uint32_t pass;
+
+    *out_ok = false;
+    for (pass = 0U; pass < 2U; ++pass) {
+        uint32_t offset = commit_offset - count * 4U;
+        uint32_t left = count;
+        uint16_t crc = 0xFFFFU;
+
+        while (left > 0U) {
+            uint32_t n = (left < NVM_MAZE_JOURNAL_IO_WORDS) ? left : NVM_MAZE_JOURNAL_IO_WORDS;
+            uint32_t i;
+            nvm_status_t st = nvm_read(j->area[j->active], offset, buf, n * 4U);
+
+            if (st != NVM_STATUS_OK) {
+                return st;
+            }
+            if (pass == 0U) {
+                crc = nvm_maze_journal_crc16(crc, (const uint8_t*)buf, n * 4U);
+            } else {
+                for (i = 0U; i < n; ++i) {
+                    j->shadow[(buf[i] >> 16) & NVM_MAZE_JOURNAL_MAX_INDEX] = (uint16_t)buf[i];
+                }
+            }
+            offset += n * 4U;
+            left -= n;
+        }
+        if (pass == 0U && crc != expect_crc) {
+            return NVM_STATUS_OK;
+        }
+    }
+    *out_ok = true;
+    return NVM_STATUS_OK;
+}
+
+// 有効なセクタのスナップショットにジャーナルを順に反映して控えを作り、追記位置を決める
+static nvm_status_t nvm_maze_journal_scan(nvm_maze_journal_t* j, nvm_maze_journal_load_result_t* res) {
+    nvm_maze_journal_header_t h[NVM_MAZE_JOURNAL_SECTORS];
+    nvm_status_t st[NVM_MAZE_JOURNAL_SECTORS];
+    uint32_t buf[NVM_MAZE_JOURNAL_IO_WORDS];
+    uint32_t sector = NVM_MAZE_JOURNAL_SECTORS;
+    uint32_t offset;
+    uint32_t end;
+    uint32_t pending = 0U; // 直前のコミット以降のエントリ語の数
+    nvm_status_t rst;
+    uint32_t i;
+
+    j->scanned = false;
+    j->valid = false;
+    memset(res, 0, sizeof(*res));
+    for (i = 0U; i < NVM_MAZE_JOURNAL_SECTORS; ++i) {
+        st[i] = nvm_maze_journal_check_sector(j, i, &h[i]);
+        if (st[i] == NVM_STATUS_OK && (sector == NVM_MAZE_JOURNAL_SECTORS ||
+                                       (int32_t)(h[i].generation - h[sector].generation) > 0)) {
+            sector = i;
+        }
+    }
+    if (sector == NVM_MAZE_JOURNAL_SECTORS) {
+        for (i = 0U; i < NVM_MAZE_JOURNAL_SECTORS; ++i) {
+            if (st[i] == NVM_STATUS_HW_ERROR) {
+                return st[i];
+            }
+        }
+        j->scanned = true;
+        for (i = 0U; i < NVM_MAZE_JOURNAL_SECTORS; ++i) {
+            if (st[i] != NVM_STATUS_NOT_FOUND) {
+                return st[i];
+            }
+        }
+        return NVM_STATUS_NOT_FOUND;
+    }
+
+    j->active = sector;
+    j->generation = h[sector].generation;
+    rst = nvm_read(j->area[sector], (uint32_t)sizeof(h[sector]), j->shadow, j->cell_count * 2U);
+    if (rst != NVM_STATUS_OK) {
+        return rst;
+    }
+
+    offset = nvm_maze_journal_start(j);
+    end = j->sector_bytes[sector];
+    j->append_offset = end;
+    while (offset < end) {
+        uint32_t n = (end - offset) / 4U;
+
+        if (n > NVM_MAZE_JOURNAL_IO_WORDS) {
+            n = NVM_MAZE_JOURNAL_IO_WORDS;
+        }
+        rst = nvm_read(j->area[sector], offset, buf, n * 4U);
+        if (rst != NVM_STATUS_OK) {
+            return rst;
+        }
+        for (i = 0U; i < n; ++i, offset += 4U) {
+            uint32_t w = buf[i];
+            uint32_t tag = w >> NVM_MAZE_JOURNAL_TAG_SHIFT;
+            uint32_t field = (w >> 16) & NVM_MAZE_JOURNAL_MAX_INDEX;
+
+            // 書き込みは先頭から順なので、消去済みの語から後ろは未使用
+            if (w == NVM_MAZE_JOURNAL_ERASED) {
+                j->append_offset = offset;
+                break;
+            }
+            if (tag == NVM_MAZE_JOURNAL_TAG_ENTRY && field < j->cell_count) {
+                pending++;
+                continue;
+            }
+            if (tag == NVM_MAZE_JOURNAL_TAG_COMMIT && field > 0U && field <= pending) {
+                bool ok = false;
+
+                rst = nvm_maze_journal_apply_batch(j, offset, field, (uint16_t)w, &ok);
+                if (rst != NVM_STATUS_OK) {
+                    return rst;
+                }
+                if (ok) {
+                    // コミットの前に途切れた追記が残っていれば、その分だけ読み飛ばし
+                    res->torn_words += pending - field;
+                    res->commits++;
+                    res->entries += field;
+                    pending = 0U;
+                    continue;
+                }
+            }
+            // 途切れた語・合わないコミット: それまでのエントリごと捨てる
+            res->torn_words += pending + 1U;
+            pending = 0U;
+        }
+        if (j->append_offset != end) {
+            break;
+        }
+    }
+    res->torn_words += pending;
+    res->sector = sector;
+    res->generation = j->generation;
+    res->free_bytes = end - j->append_offset;
+    j->valid = true;
+    j->scanned = true;
+    return NVM_STATUS_OK;
+}
+
+nvm_status_t nvm_maze_journal_load(nvm_maze_journal_t* j, uint16_t* cells, nvm_maze_journal_load_result_t* out) {
+    nvm_maze_journal_load_result_t res;
+    nvm_status_t st;
+
+    if (j == NULL || cells == NULL || j->cell_count == 0U) {
+        return NVM_STATUS_INVALID_ARG;
+    }
+    st = nvm_maze_journal_scan(j, &res);
+    if (st != NVM_STATUS_OK) {
+        return st;
+    }
+    memcpy(cells, j->shadow, j->cell_count * sizeof(cells[0]));
+    if (out != NULL) {
+        *out = res;
+    }
+    return NVM_STATUS_OK;
+}
+
+// もう一方のセクタを消去してスナップショットを書き、最後にヘッダを書いて切り替える
+static nvm_status_t nvm_maze_journal_compact(nvm_maze_journal_t* j, const uint16_t* cells, uint32_t* bytes) {
+    nvm_maze_journal_header_t h;
+    uint32_t dst = j->valid ? ((j->active + 1U) % NVM_MAZE_JOURNAL_SECTORS) : 0U;
+    nvm_status_t st;
+
+    h.magic = NVM_MAZE_JOURNAL_MAGIC;
+    h.version = NVM_MAZE_JOURNAL_VERSION;
+    h.generation = j->valid ? (j->generation + 1U) : 1U;
+    h.cell_count = j->cell_count;
+    h.snapshot_crc = nvm_maze_journal_crc32(0U, (const uint8_t*)cells, j->cell_count * 2U);
+    h.header_crc = nvm_maze_journal_header_crc(&h);
+
+    st = nvm_erase(j->area[dst]);
+    if (st != NVM_STATUS_OK) {
+        return st;
+    }
+    st = nvm_write(j->area[dst], (uint32_t)sizeof(h), cells, j->cell_count * 2U);
+    if (st != NVM_STATUS_OK) {
+        return st;
+    }
+    st = nvm_write(j->area[dst], 0U, &h, sizeof(h));
+    if (st != NVM_STATUS_OK) {
+        return st;
+    }
+    memcpy(j->shadow, cells, j->cell_count * sizeof(cells[0]));
+    j->valid = true;
+    j->active = dst;
+    j->generation = h.generation;
+    j->append_offset = nvm_maze_journal_start(j);
+    *bytes = (uint32_t)sizeof(h) + j->cell_count * 2U;
+    return NVM_STATUS_OK;
+}
+
+// 変わったセルのエントリ語を追記してからコミット語を書く
+static nvm_status_t nvm_maze_journal_append(nvm_maze_journal_t* j, const uint16_t* cells, uint32_t changed) {
+    uint32_t buf[NVM_MAZE_JOURNAL_IO_WORDS];
+    uint32_t offset = j->append_offset;
+    uint32_t fill = 0U;
+    uint16_t crc = 0xFFFFU;
+    uint32_t commit;
+    nvm_status_t st;
+    uint32_t i;
+
+    for (i = 0U; i < j->cell_count; ++i) {
+        if (cells[i] == j->shadow[i]) {
+            continue;
+        }
+        buf[fill++] = nvm_maze_journal_entry(i, cells[i]);
+        if (fill == NVM_MAZE_JOURNAL_IO_WORDS) {
+            st = nvm_write(j->area[j->active], offset, buf, fill * 4U);
+            if (st != NVM_STATUS_OK) {
+                return st;
+            }
+            crc = nvm_maze_journal_crc16(crc, (const uint8_t*)buf, fill * 4U);
+            offset += fill * 4U;
+            fill = 0U;
+        }
+    }
+    if (fill > 0U) {
+        st = nvm_write(j->area[j->active], offset, buf, fill * 4U);
+        if (st != NVM_STATUS_OK) {
+            return st;
+        }
+        crc = nvm_maze_journal_crc16(crc, (const uint8_t*)buf, fill * 4U);
+        offset += fill * 4U;
+    }
+    commit = nvm_maze_journal_commit(changed, crc);
+    st = nvm_write(j->area[j->active], offset, &commit, sizeof(commit));
+    if (st != NVM_STATUS_OK) {
+        return st;
+    }
+    memcpy(j->shadow, cells, j->cell_count * sizeof(cells[0]));
+    j->append_offset = offset + 4U;
+    return NVM_STATUS_OK;
+}
+
+nvm_status_t nvm_maze_journal_save(nvm_maze_journal_t* j,
+                                   const uint16_t* cells,
+                                   nvm_maze_journal_save_result_t* out) {
+    nvm_maze_journal_save_result_t res = {0U, 0U, false};
+    nvm_maze_journal_load_result_t scan;
+    nvm_status_t st;
+    uint32_t i;
+
+    if (j == NULL || cells == NULL || j->cell_count == 0U) {
+        return NVM_STATUS_INVALID_ARG;
+    }
+    // 追記位置と控えは Flash の内容から決める（読まずに書くと有効なセクタを消しかねない）
+    if (!j->scanned) {
+        st = nvm_maze_journal_scan(j, &scan);
+        if (!j->scanned) {
+            return st;
+        }
+    }
+    for (i = 0U; i < j->cell_count; ++i) {
+        if (cells[i] != j->shadow[i]) {
+            res.changed++;
+        }
+    }
+
+    if (j->valid && res.changed == 0U) {
+        st = NVM_STATUS_OK;
+    } else if (j->valid && j->append_offset + (res.changed + 1U) * 4U <= j->sector_bytes[j->active]) {
+        st = nvm_maze_journal_append(j, cells, res.changed);
+        res.bytes = (res.changed + 1U) * 4U;
+    } else {
+        st = nvm_maze_journal_compact(j, cells, &res.bytes);
+        res.compacted = true;
+    }
+    if (st != NVM_STATUS_OK) {
+        // どこまで書けたか分からないので、次の保存の前に読み直す
+        j->scanned = false;
+        return st;
+    }
+    if (out != NULL) {
+        *out = res;
+    }
+    return NVM_STATUS_OK;
+}
@@ -0,0 +1,89 @@
+#ifndef NIGHTFALL_NVM_MAZE_JOURNAL_H_
+#define NIGHTFALL_NVM_MAZE_JOURNAL_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "nvm.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * 迷路マップの追記型ジャーナル（HAL 非依存。F405 の nvm_params.c と tests のホスト試験から利用）
+ *
+ * 内蔵 Flash の 2 セクタを交互に使う。各セクタは
+ *   [ヘッダ][全セルのスナップショット][ジャーナル（1 語 = 1 レコード）...][消去済み 0xFF...]
+ * で、保存は前回から変わったセルだけをエントリ語として消去済みの領域に追記し、最後にコミット語を書く。
+ *   - エントリ語: tag=10 | セル番号 14bit | セル値 16bit
+ *   - コミット語: tag=01 | 件数 14bit | 直前の件数分のエントリ語の CRC-16
+ * 読込はヘッダの世代が新しく CRC の合うセクタのスナップショットに、コミットの合うエントリだけを順に反映する。
+ * 途中で電源が切れた追記（コミットが無い・合わない）は読み飛ばし、次の保存はその後ろから続ける。
+ * セクタが埋まったら、もう一方を消去して現在のマップのスナップショットを書き、ヘッダを最後に書いて切り替える
+ * （ヘッダが書けるまでは元のセクタが有効なまま）。2 セクタを交互に消去するので消耗も分散する。
+ */
+
+#define NVM_MAZE_JOURNAL_MAGIC (0x4D5A4A31UL) // "1JZM"（旧 1 セクタ形式の "1EZM" と区別）
+#define NVM_MAZE_JOURNAL_VERSION (0x00010000UL)
+#define NVM_MAZE_JOURNAL_SECTORS (2U)
+#define NVM_MAZE_JOURNAL_MAX_INDEX (0x3FFFU) // エントリ語のセル番号・コミット語の件数の上限
+
+#ifndef NVM_MAZE_JOURNAL_MAX_CELLS
+#define NVM_MAZE_JOURNAL_MAX_CELLS (1024U) // 32x32（控えの大きさ）
+#endif
+
+typedef struct __attribute__((packed)) {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t generation;   // 切り替えのたびに +1（新しいセクタの判定）
+    uint32_t cell_count;
+    uint32_t snapshot_crc; // スナップショット（cell_count 個の uint16_t）の CRC-32
+    uint32_t header_crc;   // ここまでの CRC-32（最後に書く語。揃っていればヘッダ全体が書けている）
+} nvm_maze_journal_header_t;
+
+typedef struct {
+    uint32_t sector;     // 読んだセクタ（0/1）
+    uint32_t generation;
+    uint32_t commits;    // 反映したコミット数
+    uint32_t entries;    // 反映したエントリ数
+    uint32_t torn_words; // 読み飛ばした語（電源断で途切れた追記）
+    uint32_t free_bytes; // セクタの残り
+} nvm_maze_journal_load_result_t;
+
+typedef struct {
+    uint32_t changed;   // 前回の保存から変わったセル数
+    uint32_t bytes;     // 書いたバイト数
+    bool compacted;     // セクタを切り替えた（消去 + スナップショット）
+} nvm_maze_journal_save_result_t;
+
+typedef struct {
+    nvm_area_t area[NVM_MAZE_JOURNAL_SECTORS];
+    uint32_t sector_bytes[NVM_MAZE_JOURNAL_SECTORS];
+    uint32_t cell_count;
+    bool scanned;           // Flash の内容を読んだか（保存の前に必ず読む）
+    bool valid;             // 有効なセクタがあるか
+    uint32_t active;        // 有効なセクタ
+    uint32_t generation;
+    uint32_t append_offset; // 次のエントリ語を書く位置（セクタ先頭から）
+    uint16_t shadow[NVM_MAZE_JOURNAL_MAX_CELLS]; // 最後にコミットした内容
+} nvm_maze_journal_t;
+
+/* 2 つの領域を使うジャーナルを用意する（Flash はまだ読まない）。
+ * 領域の大きさが違う・cell_count が上限を超える・スナップショットが入らない場合は INVALID_ARG。 */
+nvm_status_t nvm_maze_journal_init(nvm_maze_journal_t* j, nvm_area_t area0, nvm_area_t area1, uint32_t cell_count);
+/* 最新の内容を cells に読む。有効なセクタが無ければ NOT_FOUND（cells は変えない）。
+ * ヘッダはあるが壊れている・セル数が違うだけなら INTEGRITY_ERROR。 */
+nvm_status_t nvm_maze_journal_load(nvm_maze_journal_t* j, uint16_t* cells, nvm_maze_journal_load_result_t* out);
+// 前回の保存から変わったセルを追記する（入らなければセクタを切り替える）
+nvm_status_t nvm_maze_journal_save(nvm_maze_journal_t* j,
+                                   const uint16_t* cells,
+                                   nvm_maze_journal_save_result_t* out);
+
+uint16_t nvm_maze_journal_crc16(uint16_t crc, const uint8_t* data, uint32_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,561 @@
+#include "nvm_param_store.h"
+
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define NVM_PARAM_STORE_HEADER_CRC_OFFSET (16U) // CRC は seq から
+#define NVM_PARAM_STORE_IO_ENTRIES (32U)        // 1 回の nvm_read / nvm_write で扱う要素数
+#define NVM_PARAM_STORE_MAX_ENTRIES \
+    ((NVM_PARAM_STORE_SLOT_BYTES - sizeof(nvm_param_blob_header_t)) / sizeof(nvm_param_blob_entry_t))
+
+static uint32_t nvm_param_type_size(uint8_t type) {
+    switch (type) {
+        case NVM_PARAM_U16:
+            return 2U;
+        case NVM_PARAM_U8:
+            return 1U;
+        default:
+            return 4U;
+    }
+}
+
+static uint8_t* nvm_param_elem(const nvm_param_desc_t* d, uint32_t index) {
+    return (uint8_t*)d->ptr + (size_t)index * d->stride;
+}
+
+static uint32_t nvm_param_read_raw(const nvm_param_desc_t* d, uint32_t index) {
+    const uint8_t* p = nvm_param_elem(d, index);
+    uint32_t v32;
+    uint16_t v16;
+
+    switch (d->type) {
+        case NVM_PARAM_U16:
+            memcpy(&v16, p, sizeof(v16));
+            return v16;
+        case NVM_PARAM_U8:
+            return *p;
+        default:
+            memcpy(&v32, p, sizeof(v32));
+            return v32;
+    }
+}
+
+static void nvm_param_write_raw(const nvm_param_desc_t* d, uint32_t index, uint32_t raw) {
+    uint8_t* p = nvm_param_elem(d, index);
+    uint16_t v16;
+
+    switch (d->type) {
+        case NVM_PARAM_U16:
+            v16 = (uint16_t)raw;
+            memcpy(p, &v16, sizeof(v16));
+            break;
+        case NVM_PARAM_U8:
+            *p = (uint8_t)raw;
+            break;
+        default:
+            memcpy(p, &raw, sizeof(raw));
+            break;
+    }
+}
+
+static float nvm_param_raw_to_float(uint8_t type, uint32_t raw) {
+    float f;
+
+    switch (type) {
+        case NVM_PARAM_F32:
+            memcpy(&f, &raw, sizeof(f));
+            return f;
+        case NVM_PARAM_I32:
+            return (float)(int32_t)raw;
+        default:
+            return (float)raw;
+    }
+}
+
+// 型の幅に収まり、NaN でなく、範囲内か
+static bool nvm_param_raw_valid(const nvm_param_desc_t* d, uint32_t raw) {
+    float v;
+
+    if ((d->type == NVM_PARAM_U16 && raw > 0xFFFFU) || (d->type == NVM_PARAM_U8 && raw > 0xFFU)) {
+        return false;
+    }
+    v = nvm_param_raw_to_float(d->type, raw);
+    return (v == v) && (v >= d->min) && (v <= d->max);
+}
+
+// 範囲を確かめた値をビット列にする（整数型で端数があれば false）
+static bool nvm_param_float_to_raw(uint8_t type, float value, uint32_t* raw) {
+    int32_t i;
+
+    if (type == NVM_PARAM_F32) {
+        memcpy(raw, &value, sizeof(*raw));
+        return true;
+    }
+    i = (int32_t)value;
+    if ((float)i != value) {
+        return false;
+    }
+    *raw = (uint32_t)i;
+    return true;
+}
+
+static bool nvm_param_desc_valid(const nvm_param_desc_t* d) {
+    float lo = -2147483648.0f;
+    float hi = 2147483520.0f; // int32 に収まる最大の float
+
+    if (d->type >= (uint8_t)NVM_PARAM_TYPE_COUNT || d->count == 0U || d->name == NULL || d->ptr == NULL) {
+        return false;
+    }
+    if (d->count > 1U && d->stride < nvm_param_type_size(d->type)) {
+        return false;
+    }
+    if (strlen(d->name) + 5U > NVM_PARAM_STORE_NAME_MAX) {
+        return false;
+    }
+    if (d->type == NVM_PARAM_U16) {
+        lo = 0.0f;
+        hi = 65535.0f;
+    } else if (d->type == NVM_PARAM_U8) {
+        lo = 0.0f;
+        hi = 255.0f;
+    }
+    if (d->type != NVM_PARAM_F32 && (d->min < lo || d->max > hi)) {
+        return false;
+    }
+    return !(d->min > d->max);
+}
+
+// 表の中で d の先頭要素が何番目の要素か（既定値の控えの位置）
+static uint32_t nvm_param_value_base(const nvm_param_store_t* s, const nvm_param_desc_t* d) {
+    uint32_t base = 0U;
+    const nvm_param_desc_t* p;
+
+    for (p = s->table; p != d; ++p) {
+        base += p->count;
+    }
+    return base;
+}
+
+static const nvm_param_desc_t* nvm_param_find_id(const nvm_param_store_t* s, uint16_t id) {
+    uint32_t i;
+
+    for (i = 0U; i < s->count; ++i) {
+        if (s->table[i].id == id) {
+            return &s->table[i];
+        }
+    }
+    return NULL;
+}
+
+nvm_status_t nvm_param_store_init(nvm_param_store_t* s,
+                                  nvm_area_t area,
+                                  const nvm_param_desc_t* table,
+                                  uint32_t count) {
+    uint32_t values = 0U;
+    uint32_t i;
+    uint32_t k;
+
+    if (s == NULL || (table == NULL && count > 0U)) {
+        return NVM_STATUS_INVALID_ARG;
+    }
+    memset(s, 0, sizeof(*s));
+    for (i = 0U; i < count; ++i) {
+        const nvm_param_desc_t* d = &table[i];
+
+        if (!nvm_param_desc_valid(d)) {
+            return NVM_STATUS_INVALID_ARG;
+        }
+        for (k = 0U; k < i; ++k) {
+            if (table[k].id == d->id || strcmp(table[k].name, d->name) == 0) {
+                return NVM_STATUS_INVALID_ARG;
+            }
+        }
+        if (values + d->count > NVM_PARAM_STORE_MAX_VALUES) {
+            return NVM_STATUS_INVALID_ARG;
+        }
+        for (k = 0U; k < d->count; ++k) {
+            uint32_t raw = nvm_param_read_raw(d, k);
+
+            // コンパイル時の値が範囲外なら表の誤り
+            if (!nvm_param_raw_valid(d, raw)) {
+                return NVM_STATUS_INVALID_ARG;
+            }
+            s->defaults[values + k] = raw;
+        }
+        values += d->count;
+    }
+    s->area = area;
+    s->table = table;
+    s->count = count;
+    s->values = values;
+    return NVM_STATUS_OK;
+}
+
+const nvm_param_desc_t* nvm_param_store_find(const nvm_param_store_t* s,
+                                             const char* name,
+                                             uint32_t* out_index) {
+    const char* bracket;
+    size_t name_len;
+    uint32_t index = 0U;
+    uint32_t i;
+
+    if (s == NULL || name == NULL) {
+        return NULL;
+    }
+    bracket = strchr(name, '[');
+    name_len = (bracket != NULL) ? (size_t)(bracket - name) : strlen(name);
+    if (bracket != NULL) {
+        const char* p = bracket + 1;
+
+        if (*p < '0' || *p > '9') {
+            return NULL;
+        }
+        while (*p >= '0' && *p <= '9') {
+            index = index * 10U + (uint32_t)(*p - '0');
+            if (index > 255U) {
+                return NULL;
+            }
+            p++;
+        }
+        if (p[0] != ']' || p[1] != '\0') {
+            return NULL;
+        }
+    }
+    for (i = 0U; i < s->count; ++i) {
+        const nvm_param_desc_t* d = &s->table[i];
+
+        if (strlen(d->name) != name_len || strncmp(d->name, name, name_len) != 0) {
+            continue;
+        }
+        // 配列は添字が要る。スカラは省略か [0]
+        if (index >= d->count || (bracket == NULL && d->count > 1U)) {
+            return NULL;
+        }
+        if (out_index != NULL) {
+            *out_index = index;
+        }
+        return d;
+    }
+    return NULL;
+}
+
+float nvm_param_store_get(const nvm_param_desc_t* d, uint32_t index) {
+    return nvm_param_raw_to_float(d->type, nvm_param_read_raw(d, index));
+}
+
+nvm_status_t nvm_param_store_set(const nvm_param_desc_t* d, uint32_t index, float value) {
+    uint32_t raw;
+
+    if (d == NULL || index >= d->count) {
+        return NVM_STATUS_INVALID_ARG;
+    }
+    if (!(value >= d->min && value <= d->max)) {
+        return NVM_STATUS_INVALID_ARG;
+    }
+    if (!nvm_param_float_to_raw(d->type, value, &raw)) {
+        return NVM_STATUS_INVALID_ARG;
+    }
+    nvm_param_write_raw(d, index, raw);
+    return NVM_STATUS_OK;
+}
+
+nvm_status_t nvm_param_store_set_text(const nvm_param_store_t* s, const char* name, const char* text) {
+    const nvm_param_desc_t* d;
+    uint32_t index = 0U;
+    char* end = NULL;
+    float value;
+
+    d = nvm_param_store_find(s, name, &index);
+    if (d == NULL) {
+        return NVM_STATUS_NOT_FOUND;
+    }
+    if (text == NULL || *text == '\0') {
+        return NVM_STATUS_INVALID_ARG;
+    }
+    if (d->type == NVM_PARAM_F32) {
+        value = strtof(text, &end);
+    } else {
+        long v = strtol(text, &end, 0);
+
+        // 範囲外は float にしても min/max の検査で落ちる
+        value = (float)v;
+    }
+    while (end != NULL && (*end == ' ' || *end == '\t')) {
+        end++;
+    }
+    if (end == text || end == NULL || *end != '\0') {
+        return NVM_STATUS_INVALID_ARG;
+    }
+    return nvm_param_store_set(d, index, value);
+}
+
+float nvm_param_store_default(const nvm_param_store_t* s, const nvm_param_desc_t* d, uint32_t index) {
+    return nvm_param_raw_to_float(d->type, s->defaults[nvm_param_value_base(s, d) + index]);
+}
+
+bool nvm_param_store_is_default(const nvm_param_store_t* s, const nvm_param_desc_t* d, uint32_t index) {
+    return nvm_param_read_raw(d, index) == s->defaults[nvm_param_value_base(s, d) + index];
+}
+
+uint32_t nvm_param_store_changed_count(const nvm_param_store_t* s) {
+    uint32_t n = 0U;
+    uint32_t base = 0U;
+    uint32_t i;
+    uint32_t k;
+
+    for (i = 0U; i < s->count; ++i) {
+        const nvm_param_desc_t* d = &s->table[i];
+
+        for (k = 0U; k < d->count; ++k) {
+            if (nvm_param_read_raw(d, k) != s->defaults[base + k]) {
+                n++;
+            }
+        }
+        base += d->count;
+    }
+    return n;
+}
+
+void nvm_param_store_reset_defaults(const nvm_param_store_t* s) {
+    uint32_t base = 0U;
+    uint32_t i;
+    uint32_t k;
+
+    for (i = 0U; i < s->count; ++i) {
+        const nvm_param_desc_t* d = &s->table[i];
+
+        for (k = 0U; k < d->count; ++k) {
+            nvm_param_write_raw(d, k, s->defaults[base + k]);
+        }
+        base += d->count;
+    }
+}
+
+uint32_t nvm_param_store_format(const nvm_param_desc_t* d, uint32_t index, char* buf, uint32_t size) {
+    char name[NVM_PARAM_STORE_NAME_MAX];
+    int n;
+
+    if (size == 0U) {
+        return 0U;
+    }
+    if (d->count > 1U) {
+        (void)snprintf(name, sizeof(name), "%s[%lu]", d->name, (unsigned long)index);
+    } else {
+        (void)snprintf(name, sizeof(name), "%s", d->name);
+    }
+    if (d->type == NVM_PARAM_F32) {
+        n = snprintf(buf, size, "%s=%.7g", name, (double)nvm_param_store_get(d, index));
+    } else if (d->type == NVM_PARAM_I32) {
+        n = snprintf(buf, size, "%s=%ld", name, (long)(int32_t)nvm_param_read_raw(d, index));
+    } else {
+        n = snprintf(buf, size, "%s=%lu", name, (unsigned long)nvm_param_read_raw(d, index));
+    }
+    if (n < 0) {
+        buf[0] = '\0';
+        return 0U;
+    }
+    return ((uint32_t)n < size) ? (uint32_t)n : size - 1U;
+}
+
+uint32_t nvm_param_store_crc32(uint32_t crc, const uint8_t* data, uint32_t len) {
+    uint32_t i;
+    uint32_t b;
+
+    crc = ~crc;
+    for (i = 0U; i < len; ++i) {
+        crc ^= data[i];
+        for (b = 0U; b < 8U; ++b) {
+            crc = ((crc & 1U) != 0U) ? ((crc >> 1) ^ 0xEDB88320UL) : (crc >> 1);
+        }
+    }
+    return ~crc;
+}
+
+static uint32_t nvm_param_slot_offset(uint32_t slot) {
+    return slot * NVM_PARAM_STORE_SLOT_BYTES;
+}
+
+// スロットのヘッダと CRC を確かめる（本体は読み捨てる）
+static nvm_status_t nvm_param_check_slot(const nvm_param_store_t* s,
+                                         uint32_t slot,
+                                         nvm_param_blob_header_t* h) {
+    nvm_param_blob_entry_t buf[NVM_PARAM_STORE_IO_ENTRIES];
+    uint32_t offset = nvm_param_slot_offset(slot) + (uint32_t)sizeof(*h);
+    uint32_t left;
+    uint32_t crc;
+    nvm_status_t st;
+
+    st = nvm_read(s->area, nvm_param_slot_offset(slot), h, sizeof(*h));
+    if (st != NVM_STATUS_OK) {
+        return st;
+    }
+    if (h->magic != NVM_PARAM_STORE_MAGIC) {
+        return NVM_STATUS_NOT_FOUND;
+    }
+    // 同じ major の間は後方互換（要素を id で照合するので minor の違いは読める）
+    if ((h->schema_version >> 16) != (NVM_PARAM_STORE_SCHEMA_VERSION >> 16)) {
+        return NVM_STATUS_INTEGRITY_ERROR;
+    }
+    if (h->count > NVM_PARAM_STORE_MAX_ENTRIES ||
+        h->length != (uint32_t)sizeof(*h) + h->count * (uint32_t)sizeof(nvm_param_blob_entry_t)) {
+        return NVM_STATUS_INTEGRITY_ERROR;
+    }
+    crc = nvm_param_store_crc32(0U,
+                                (const uint8_t*)h + NVM_PARAM_STORE_HEADER_CRC_OFFSET,
+                                (uint32_t)sizeof(*h) - NVM_PARAM_STORE_HEADER_CRC_OFFSET);
+    for (left = h->count; left > 0U;) {
+        uint32_t n = (left < NVM_PARAM_STORE_IO_ENTRIES) ? left : NVM_PARAM_STORE_IO_ENTRIES;
+        uint32_t bytes = n * (uint32_t)sizeof(buf[0]);
+
+        st = nvm_read(s->area, offset, buf, bytes);
+        if (st != NVM_STATUS_OK) {
+            return st;
+        }
+        crc = nvm_param_store_crc32(crc, (const uint8_t*)buf, bytes);
+        offset += bytes;
+        left -= n;
+    }
+    return (crc == h->crc) ? NVM_STATUS_OK : NVM_STATUS_INTEGRITY_ERROR;
+}
+
+nvm_status_t nvm_param_store_load(nvm_param_store_t* s, nvm_param_load_result_t* out) {
+    nvm_param_blob_header_t h[NVM_PARAM_STORE_SLOT_COUNT];
+    nvm_status_t st[NVM_PARAM_STORE_SLOT_COUNT];
+    nvm_param_blob_entry_t buf[NVM_PARAM_STORE_IO_ENTRIES];
+    nvm_param_load_result_t res = {0U, 0U, 0U, 0U};
+    uint32_t slot = NVM_PARAM_STORE_SLOT_COUNT;
+    uint32_t offset;
+    uint32_t left;
+    uint32_t i;
+
+    if (s == NULL) {
+        return NVM_STATUS_INVALID_ARG;
+    }
+    for (i = 0U; i < NVM_PARAM_STORE_SLOT_COUNT; ++i) {
+        st[i] = nvm_param_check_slot(s, i, &h[i]);
+        if (st[i] == NVM_STATUS_OK &&
+            (slot == NVM_PARAM_STORE_SLOT_COUNT || (int32_t)(h[i].seq - h[slot].seq) > 0)) {
+            slot = i;
+        }
+    }
+    if (slot == NVM_PARAM_STORE_SLOT_COUNT) {
+        // 読めない・壊れているスロットがあればそれを、どちらも空なら NOT_FOUND を返す
+        for (i = 0U; i < NVM_PARAM_STORE_SLOT_COUNT; ++i) {
+            if (st[i] != NVM_STATUS_NOT_FOUND) {
+                return st[i];
+            }
+        }
+        return NVM_STATUS_NOT_FOUND;
+    }
+
+    nvm_param_store_reset_defaults(s);
+    offset = nvm_param_slot_offset(slot) + (uint32_t)sizeof(h[slot]);
+    for (left = h[slot].count; left > 0U;) {
+        uint32_t n = (left < NVM_PARAM_STORE_IO_ENTRIES) ? left : NVM_PARAM_STORE_IO_ENTRIES;
+        nvm_status_t rst = nvm_read(s->area, offset, buf, n * sizeof(buf[0]));
+
+        if (rst != NVM_STATUS_OK) {
+            // CRC を確かめた後に読めなくなった: 途中まで反映した値は捨てる
+            nvm_param_store_reset_defaults(s);
+            return rst;
+        }
+        for (i = 0U; i < n; ++i) {
+            const nvm_param_desc_t* d = nvm_param_find_id(s, buf[i].id);
+
+            if (d == NULL || buf[i].index >= d->count || buf[i].type != d->type ||
+                !nvm_param_raw_valid(d, buf[i].raw)) {
+                res.skipped++;
+                continue;
+            }
+            nvm_param_write_raw(d, buf[i].index, buf[i].raw);
+            res.applied++;
+        }
+        offset += n * (uint32_t)sizeof(buf[0]);
+        left -= n;
+    }
+    s->seq = h[slot].seq;
+    s->slot = slot;
+    res.slot = slot;
+    res.seq = h[slot].seq;
+    if (out != NULL) {
+        *out = res;
+    }
+    return NVM_STATUS_OK;
+}
+
+nvm_status_t nvm_param_store_save(nvm_param_store_t* s) {
+    nvm_param_blob_header_t h;
+    nvm_param_blob_entry_t buf[NVM_PARAM_STORE_IO_ENTRIES];
+    uint32_t slot;
+    uint32_t offset;
+    uint32_t fill = 0U;
+    uint32_t base = 0U;
+    uint32_t crc;
+    uint32_t i;
+    uint32_t k;
+    nvm_status_t st;
+
+    if (s == NULL) {
+        return NVM_STATUS_INVALID_ARG;
+    }
+    memset(&h, 0, sizeof(h));
+    h.magic = NVM_PARAM_STORE_MAGIC;
+    h.schema_version = NVM_PARAM_STORE_SCHEMA_VERSION;
+    // seq 0 は「保存なし」に使うので、一周したら 1 に飛ばす
+    h.seq = (s->seq == 0xFFFFFFFFUL) ? 1U : (s->seq + 1U);
+    h.count = nvm_param_store_changed_count(s);
+    if (h.count > NVM_PARAM_STORE_MAX_ENTRIES) {
+        return NVM_STATUS_INVALID_ARG;
+    }
+    h.length = (uint32_t)sizeof(h) + h.count * (uint32_t)sizeof(nvm_param_blob_entry_t);
+    slot = (s->seq == 0U) ? 0U : ((s->slot + 1U) % NVM_PARAM_STORE_SLOT_COUNT);
+    offset = nvm_param_slot_offset(slot) + (uint32_t)sizeof(h);
+    crc = nvm_param_store_crc32(0U,
+                                (const uint8_t*)&h + NVM_PARAM_STORE_HEADER_CRC_OFFSET,
+                                (uint32_t)sizeof(h) - NVM_PARAM_STORE_HEADER_CRC_OFFSET);
+
+    // 本体 → ヘッダの順に書く（ヘッダが古いままのスロットは CRC が合わず無効になる）
+    for (i = 0U; i < s->count; ++i) {
+        const nvm_param_desc_t* d = &s->table[i];
+
+        for (k = 0U; k < d->count; ++k) {
+            uint32_t raw = nvm_param_read_raw(d, k);
+
+            if (raw == s->defaults[base + k]) {
+                continue;
+            }
+            buf[fill].id = d->id;
+            buf[fill].index = (uint8_t)k;
+            buf[fill].type = d->type;
+            buf[fill].raw = raw;
+            fill++;
+            if (fill == NVM_PARAM_STORE_IO_ENTRIES) {
+                st = nvm_write(s->area, offset, buf, fill * sizeof(buf[0]));
+                if (st != NVM_STATUS_OK) {
+                    return st;
+                }
+                crc = nvm_param_store_crc32(crc, (const uint8_t*)buf, fill * (uint32_t)sizeof(buf[0]));
+                offset += fill * (uint32_t)sizeof(buf[0]);
+                fill = 0U;
+            }
+        }
+        base += d->count;
+    }
+    if (fill > 0U) {
+        st = nvm_write(s->area, offset, buf, fill * sizeof(buf[0]));
+        if (st != NVM_STATUS_OK) {
+            return st;
+        }
+        crc = nvm_param_store_crc32(crc, (const uint8_t*)buf, fill * (uint32_t)sizeof(buf[0]));
+    }
+    h.crc = crc;
+    st = nvm_write(s->area, nvm_param_slot_offset(slot), &h, sizeof(h));
+    if (st != NVM_STATUS_OK) {
+        return st;
+    }
+    s->seq = h.seq;
+    s->slot = slot;
+    return NVM_STATUS_OK;
+}
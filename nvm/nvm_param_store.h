@@ -0,0 +1,128 @@
+#ifndef NIGHTFALL_NVM_PARAM_STORE_H_
+#define NIGHTFALL_NVM_PARAM_STORE_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "nvm.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * 実行時パラメータストア（HAL 非依存。F413 の f413_param_table.c と tests のホスト試験から利用）
+ *
+ * 調整値（PID ゲイン・壁しきい値・ゴール座標・最短走行パラメータなど）を名前・id・型・範囲・実体への
+ * ポインタの表（nvm_param_desc_t）で公開し、UART から読み書きできるようにする。
+ * 既定値は nvm_param_store_init() の時点で実体が持っている値（= コンパイル時の値）を控えたもの。
+ *
+ * 保存先は NVM の 1 領域で、先頭から NVM_PARAM_STORE_SLOT_BYTES ずつの 2 スロットを交互に使う。
+ * 各スロットは nvm_param_blob_header_t + 既定値から変えた要素だけの nvm_param_blob_entry_t 列。
+ *   - 本体を書いてからヘッダを書く。途中で止まったスロットは CRC が合わず、もう一方（前回の保存）が残る
+ *   - 読込は CRC の合うスロットのうち seq の新しい方を使う。どちらも無効なら既定値のまま
+ *   - 要素は id + index で照合する。表に無い id・型違い・範囲外の要素は読み飛ばす（表の増減に耐える）
+ * 既定値との差分だけを保存するので、触っていない値はファームウェアの既定値の変更がそのまま効く。
+ */
+
+#define NVM_PARAM_STORE_MAGIC (0x4E465450UL) // "PTFN"
+#define NVM_PARAM_STORE_SCHEMA_VERSION (0x00010000UL)
+#define NVM_PARAM_STORE_SLOT_BYTES (8192U)
+#define NVM_PARAM_STORE_SLOT_COUNT (2U)
+#define NVM_PARAM_STORE_NAME_MAX (48U) // "name[index]" を含む名前の最大長
+
+#ifndef NVM_PARAM_STORE_MAX_VALUES
+#define NVM_PARAM_STORE_MAX_VALUES (768U) // 表の全要素数の上限（既定値の控えの大きさ）
+#endif
+
+typedef enum {
+    NVM_PARAM_F32 = 0,
+    NVM_PARAM_I32,
+    NVM_PARAM_U16,
+    NVM_PARAM_U8,
+    NVM_PARAM_TYPE_COUNT
+} nvm_param_type_t;
+
+typedef struct {
+    uint16_t id;     // 保存ブロブのキー（一度使った id は別の値に使い回さない）
+    uint8_t type;    // nvm_param_type_t
+    uint8_t count;   // 要素数（1 = スカラ。配列は "name[i]" で指定する）
+    uint16_t stride; // 要素の間隔 [byte]（構造体配列の 1 フィールドを指せる）
+    const char* name;
+    float min;
+    float max;
+    void* ptr;       // 先頭要素
+} nvm_param_desc_t;
+
+typedef struct __attribute__((packed)) {
+    uint32_t magic;
+    uint32_t schema_version;
+    uint32_t length; // ヘッダ込みのバイト数
+    uint32_t crc;    // CRC-32（ヘッダの seq 以降 length まで）
+    uint32_t seq;    // 保存の通し番号（新しいスロットの判定）
+    uint32_t count;  // 要素数
+    uint32_t reserved[2];
+} nvm_param_blob_header_t;
+
+typedef struct __attribute__((packed)) {
+    uint16_t id;
+    uint8_t index;
+    uint8_t type;
+    uint32_t raw; // 値のビット列（整数は符号拡張・ゼロ拡張した 32bit）
+} nvm_param_blob_entry_t;
+
+typedef struct {
+    uint32_t applied; // 反映した要素数
+    uint32_t skipped; // 表に無い・型違い・範囲外で読み飛ばした要素数
+    uint32_t slot;
+    uint32_t seq;
+} nvm_param_load_result_t;
+
+typedef struct {
+    nvm_area_t area;
+    const nvm_param_desc_t* table;
+    uint32_t count;  // 表の項目数
+    uint32_t values; // 表の全要素数
+    uint32_t seq;    // 最後に読み書きした保存の通し番号（0 = まだ無い）
+    uint32_t slot;   // 同、スロット
+    uint32_t defaults[NVM_PARAM_STORE_MAX_VALUES];
+} nvm_param_store_t;
+
+/* 表を検査して既定値を控える（id の重複・要素数 0・型・範囲の誤り、全要素数の超過は INVALID_ARG）。
+ * table は store より長く生きること。 */
+nvm_status_t nvm_param_store_init(nvm_param_store_t* s,
+                                  nvm_area_t area,
+                                  const nvm_param_desc_t* table,
+                                  uint32_t count);
+
+// "name" または "name[i]" を探す（見つからない・添字が範囲外なら NULL）
+const nvm_param_desc_t* nvm_param_store_find(const nvm_param_store_t* s,
+                                             const char* name,
+                                             uint32_t* out_index);
+float nvm_param_store_get(const nvm_param_desc_t* d, uint32_t index);
+// 範囲外・整数型に端数・NaN は INVALID_ARG で値を変えない
+nvm_status_t nvm_param_store_set(const nvm_param_desc_t* d, uint32_t index, float value);
+// 値の文字列を型に合わせて解釈して設定する（名前が無ければ NOT_FOUND）
+nvm_status_t nvm_param_store_set_text(const nvm_param_store_t* s, const char* name, const char* text);
+float nvm_param_store_default(const nvm_param_store_t* s, const nvm_param_desc_t* d, uint32_t index);
+bool nvm_param_store_is_default(const nvm_param_store_t* s, const nvm_param_desc_t* d, uint32_t index);
+// 既定値から変えている要素数
+uint32_t nvm_param_store_changed_count(const nvm_param_store_t* s);
+void nvm_param_store_reset_defaults(const nvm_param_store_t* s);
+
+// "name[i]=value" を書いて長さを返す（収まらなければ切り詰める）
+uint32_t nvm_param_store_format(const nvm_param_desc_t* d, uint32_t index, char* buf, uint32_t size);
+
+/* 新しい方の有効なスロットを反映する。有効なスロットが無ければ NOT_FOUND（blank）か
+ * INTEGRITY_ERROR（壊れている）で、値は変えない（既定値のまま）。 */
+nvm_status_t nvm_param_store_load(nvm_param_store_t* s, nvm_param_load_result_t* out);
+// 既定値から変えた要素を、最後に読み書きしたのと反対のスロットへ保存する
+nvm_status_t nvm_param_store_save(nvm_param_store_t* s);
+
+uint32_t nvm_param_store_crc32(uint32_t crc, const uint8_t* data, uint32_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
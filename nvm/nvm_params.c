@@ -9,6 +9,7 @@
 #include "distance_params.h"
 #include "eeprom.h"
 #include "flash_params.h"
+#include "nvm_maze_journal.h"
 
 #define NVM_MAZE_BLOB_MAGIC (0x4D5A4531UL)
 #define NVM_MAZE_BLOB_VERSION (0x00010000UL)
@@ -17,6 +18,27 @@
 #define NVM_MAZE_BLOB_HEADER_HALFWWORDS (NVM_MAZE_BLOB_HEADER_BYTES / 2U)
 #define NVM_MAZE_MAX_HALFWWORDS_IN_SECTOR (65536U)
 
+/* 迷路マップは sector 7（NVM_AREA_MAZE_JOURNAL）と sector 11（NVM_AREA_MAZE_MAP）の追記型ジャーナル
+ * （nvm_maze_journal.h）。保存は変わったセルだけを追記するので、セクタ消去は埋まったときだけ。
+ * ジャーナルが無いときだけ sector 11 の旧形式（ヘッダ + 全セル）を読む。 */
+static nvm_maze_journal_t g_nvm_maze_journal;
+static bool g_nvm_maze_journal_ready = false;
+
+static nvm_status_t nvm_maze_journal_prepare(uint32_t cell_count)
+{
+    nvm_status_t st;
+
+    if (g_nvm_maze_journal_ready && g_nvm_maze_journal.cell_count == cell_count) {
+        return NVM_STATUS_OK;
+    }
+    g_nvm_maze_journal_ready = false;
+    st = nvm_maze_journal_init(&g_nvm_maze_journal, NVM_AREA_MAZE_JOURNAL, NVM_AREA_MAZE_MAP, cell_count);
+    if (st == NVM_STATUS_OK) {
+        g_nvm_maze_journal_ready = true;
+    }
+    return st;
+}
+
 static uint32_t nvm_maze_payload_checksum(const uint16_t* cells, uint32_t cell_count)
 {
     uint32_t sum = 0U;
@@ -100,41 +122,13 @@ uint32_t nvm_maze_read_word(uint32_t address)
 
 HAL_StatusTypeDef nvm_maze_save_map(const uint16_t* cells, uint32_t cell_count)
 {
-    HAL_StatusTypeDef st;
-    uint32_t i;
-    uint32_t header[NVM_MAZE_BLOB_HEADER_WORDS];
-
-    if (!nvm_maze_is_args_valid(cells, cell_count)) {
+    if ((cells == NULL) || (cell_count == 0U)) {
         return HAL_ERROR;
     }
-
-    header[0] = NVM_MAZE_BLOB_MAGIC;
-    header[1] = NVM_MAZE_BLOB_VERSION;
-    header[2] = NVM_MAZE_BLOB_HEADER_BYTES + cell_count * 2U;
-    header[3] = nvm_maze_payload_checksum(cells, cell_count);
-
-    st = eeprom_enable_write();
-    if (st != HAL_OK) {
-        return st;
-    }
-
-    for (i = 0U; i < NVM_MAZE_BLOB_HEADER_WORDS; i++) {
-        st = eeprom_write_word(i, header[i]);
-        if (st != HAL_OK) {
-            (void)eeprom_disable_write();
-            return st;
-        }
-    }
-
-    for (i = 0U; i < cell_count; i++) {
-        st = eeprom_write_halfword(NVM_MAZE_BLOB_HEADER_HALFWWORDS + i, cells[i]);
-        if (st != HAL_OK) {
-            (void)eeprom_disable_write();
-            return st;
-        }
+    if (nvm_maze_journal_prepare(cell_count) != NVM_STATUS_OK) {
+        return HAL_ERROR;
     }
-
-    return eeprom_disable_write();
+    return (nvm_maze_journal_save(&g_nvm_maze_journal, cells, NULL) == NVM_STATUS_OK) ? HAL_OK : HAL_ERROR;
 }
 
 bool nvm_maze_load_map(uint16_t* cells, uint32_t cell_count)
@@ -151,6 +145,19 @@ bool nvm_maze_load_map(uint16_t* cells, uint32_t cell_count)
         return false;
     }
 
+    if ((cell_count > 0U) && (nvm_maze_journal_prepare(cell_count) == NVM_STATUS_OK)) {
+        nvm_status_t st = nvm_maze_journal_load(&g_nvm_maze_journal, cells, NULL);
+        if (st == NVM_STATUS_OK) {
+            return true;
+        }
+        /* sector 11 がジャーナルなのに読めない（壊れている・セル数が違う）: 旧形式として読むと誤ったマップになる。
+         * sector 7 だけ壊れている（最初の切り替えのヘッダ書き込み中の電源断）なら sector 11 の旧形式はまだ残っている */
+        if ((st != NVM_STATUS_NOT_FOUND) && (eeprom_read_word(0U) == NVM_MAZE_JOURNAL_MAGIC)) {
+            memset(cells, 0, cell_count * sizeof(cells[0]));
+            return false;
+        }
+    }
+
     magic = eeprom_read_word(0U);
     if (magic == NVM_MAZE_BLOB_MAGIC) {
         version = eeprom_read_word(1U);
@@ -196,6 +203,7 @@ bool nvm_maze_load_map(uint16_t* cells, uint32_t cell_count)
 #define NVM_MAZE_BLOB_HEADER_WORDS (NVM_MAZE_BLOB_HEADER_BYTES / 4U)
 #define NVM_MAZE_BLOB_HEADER_HALFWWORDS (NVM_MAZE_BLOB_HEADER_BYTES / 2U)
 #define NVM_MAZE_MAX_HALFWWORDS_IN_SECTOR (65536U)
+#define NVM_MAZE_SAVE_TIMEOUT_MS (1000U)
 
 #define NVM_DISTANCE_BLOB_MAGIC (0x44495354UL)
 #define NVM_DISTANCE_BLOB_VERSION (0x00010000UL)
@@ -443,10 +451,20 @@ uint32_t nvm_maze_read_word(uint32_t address)
     return value;
 }
 
+/* 非同期書き込みの完了を集計する（最初の失敗を残す） */
+static void nvm_maze_write_done(nvm_status_t status, void* ctx)
+{
+    volatile nvm_status_t* result = (volatile nvm_status_t*)ctx;
+    if ((status != NVM_STATUS_OK) && (*result == NVM_STATUS_OK)) {
+        *result = status;
+    }
+}
+
 HAL_StatusTypeDef nvm_maze_save_map(const uint16_t* cells, uint32_t cell_count)
 {
-    HAL_StatusTypeDef st;
-    uint32_t i;
+    HAL_StatusTypeDef hal_st;
+    nvm_status_t st;
+    volatile nvm_status_t result = NVM_STATUS_OK;
     uint32_t header[NVM_MAZE_BLOB_HEADER_WORDS];
 
     if (!nvm_maze_is_args_valid(cells, cell_count)) {
@@ -458,27 +476,27 @@ HAL_StatusTypeDef nvm_maze_save_map(const uint16_t* cells, uint32_t cell_count)
     header[2] = NVM_MAZE_BLOB_HEADER_BYTES + cell_count * 2U;
     header[3] = nvm_maze_payload_checksum(cells, cell_count);
 
-    st = nvm_maze_enable_write();
-    if (st != HAL_OK) {
-        return st;
+    hal_st = nvm_maze_enable_write();
+    if (hal_st != HAL_OK) {
+        return hal_st;
     }
 
-    for (i = 0U; i < NVM_MAZE_BLOB_HEADER_WORDS; i++) {
-        st = nvm_maze_write_word(i, header[i]);
-        if (st != HAL_OK) {
-            (void)nvm_maze_disable_write();
-            return st;
-        }
+    /* 本体・ヘッダの 2 要求を FRAM 書き込みキューへ積み（IMU 読取の合間に chunk 単位で送出）、
+       barrier で完了を待つ。ヘッダを後に書くので、途中で失敗しても magic が古いまま残る。 */
+    st = nvm_write_async(NVM_AREA_MAZE_MAP, NVM_MAZE_BLOB_HEADER_BYTES, cells, cell_count * 2U,
+                         nvm_maze_write_done, (void*)&result);
+    if (st == NVM_STATUS_OK) {
+        st = nvm_write_async(NVM_AREA_MAZE_MAP, 0U, header, sizeof(header),
+                             nvm_maze_write_done, (void*)&result);
     }
-
-    for (i = 0U; i < cell_count; i++) {
-        st = nvm_maze_write_halfword(NVM_MAZE_BLOB_HEADER_HALFWWORDS + i, cells[i]);
-        if (st != HAL_OK) {
-            (void)nvm_maze_disable_write();
-            return st;
-        }
+    (void)nvm_write_barrier(NVM_MAZE_SAVE_TIMEOUT_MS);
+    if (st == NVM_STATUS_OK) {
+        st = result;
+    }
+    if (st != NVM_STATUS_OK) {
+        (void)nvm_maze_disable_write();
+        return HAL_ERROR;
     }
-
     return nvm_maze_disable_write();
 }
 
@@ -0,0 +1,360 @@
+#include "nvm_trace_codec.h"
+
+#include <stddef.h>
+#include <string.h>
+
+#define NVM_TRACE_CODEC_PRED_DELTA (0U)  // 直前の値
+#define NVM_TRACE_CODEC_PRED_LINEAR (1U) // 直前 2 件の傾きで延長
+
+typedef struct {
+    uint8_t offset;
+    uint8_t size;
+    uint8_t is_signed;
+    uint8_t pred;
+} nvm_trace_codec_field_t;
+
+#define NVM_TRACE_CODEC_FIELD(name, sgn, pred)                                                    \
+    {(uint8_t)offsetof(nvm_trace_log_record_t, name),                                             \
+     (uint8_t)sizeof(((nvm_trace_log_record_t*)0)->name), (uint8_t)(sgn), (uint8_t)(pred)}
+
+/* 符号化の順序。8 フィールドごとに 1 グループで、走行中に毎回変わるものを前のグループに、
+ * 操作番号・予備のようにほとんど変わらないものを後ろのグループにまとめる
+ * （変化のないグループはフィールドマスクごと省かれる）。
+ * tools/logging/trace_bin_dump.py の CODEC_FIELDS と同じ並びにすること。 */
+static const nvm_trace_codec_field_t k_nvm_trace_codec_fields[NVM_TRACE_CODEC_FIELD_COUNT] = {
+    NVM_TRACE_CODEC_FIELD(target_distance_x1000, 1, NVM_TRACE_CODEC_PRED_LINEAR),
+    NVM_TRACE_CODEC_FIELD(distance_mm, 1, NVM_TRACE_CODEC_PRED_LINEAR),
+    NVM_TRACE_CODEC_FIELD(angle_mdeg, 1, NVM_TRACE_CODEC_PRED_LINEAR),
+    NVM_TRACE_CODEC_FIELD(target_velocity_mm_s, 1, NVM_TRACE_CODEC_PRED_LINEAR),
+    NVM_TRACE_CODEC_FIELD(real_velocity_mm_s, 1, NVM_TRACE_CODEC_PRED_DELTA),
+    NVM_TRACE_CODEC_FIELD(accel_velocity_mm_s, 1, NVM_TRACE_CODEC_PRED_DELTA),
+    NVM_TRACE_CODEC_FIELD(real_omega_mdps, 1, NVM_TRACE_CODEC_PRED_DELTA),
+    NVM_TRACE_CODEC_FIELD(gyro_z_raw_mdps, 1, NVM_TRACE_CODEC_PRED_DELTA),
+
+    NVM_TRACE_CODEC_FIELD(motor_out_l, 1, NVM_TRACE_CODEC_PRED_DELTA),
+    NVM_TRACE_CODEC_FIELD(motor_out_r, 1, NVM_TRACE_CODEC_PRED_DELTA),
+    NVM_TRACE_CODEC_FIELD(encoder_l, 1, NVM_TRACE_CODEC_PRED_DELTA),
+    NVM_TRACE_CODEC_FIELD(encoder_r, 1, NVM_TRACE_CODEC_PRED_DELTA),
+    NVM_TRACE_CODEC_FIELD(accel_forward_mm_s2, 1, NVM_TRACE_CODEC_PRED_DELTA),
+    NVM_TRACE_CODEC_FIELD(target_omega_mdps, 1, NVM_TRACE_CODEC_PRED_LINEAR),
+    NVM_TRACE_CODEC_FIELD(target_angle_mdeg, 1, NVM_TRACE_CODEC_PRED_LINEAR),
+    NVM_TRACE_CODEC_FIELD(isr_tick_max_us_x10, 0, NVM_TRACE_CODEC_PRED_DELTA),
+
+    NVM_TRACE_CODEC_FIELD(isr_period_max_us_x10, 0, NVM_TRACE_CODEC_PRED_DELTA),
+    NVM_TRACE_CODEC_FIELD(adc_fr, 0, NVM_TRACE_CODEC_PRED_DELTA),
+    NVM_TRACE_CODEC_FIELD(adc_r, 0, NVM_TRACE_CODEC_PRED_DELTA),
+    NVM_TRACE_CODEC_FIELD(adc_fl, 0, NVM_TRACE_CODEC_PRED_DELTA),
+    NVM_TRACE_CODEC_FIELD(adc_l, 0, NVM_TRACE_CODEC_PRED_DELTA),
+    NVM_TRACE_CODEC_FIELD(adc_vbat, 0, NVM_TRACE_CODEC_PRED_DELTA),
+    NVM_TRACE_CODEC_FIELD(seq, 0, NVM_TRACE_CODEC_PRED_LINEAR),
+    NVM_TRACE_CODEC_FIELD(timestamp_ms, 0, NVM_TRACE_CODEC_PRED_LINEAR),
+
+    NVM_TRACE_CODEC_FIELD(reserved_i32_0, 1, NVM_TRACE_CODEC_PRED_DELTA),
+    NVM_TRACE_CODEC_FIELD(reserved_i32_1, 1, NVM_TRACE_CODEC_PRED_DELTA),
+    NVM_TRACE_CODEC_FIELD(reserved_i32_2, 1, NVM_TRACE_CODEC_PRED_DELTA),
+    NVM_TRACE_CODEC_FIELD(reserved_i32_3, 1, NVM_TRACE_CODEC_PRED_DELTA),
+    NVM_TRACE_CODEC_FIELD(reserved_u16_0, 0, NVM_TRACE_CODEC_PRED_DELTA),
+    NVM_TRACE_CODEC_FIELD(reserved_u16_1, 0, NVM_TRACE_CODEC_PRED_DELTA),
+    NVM_TRACE_CODEC_FIELD(flags, 0, NVM_TRACE_CODEC_PRED_DELTA),
+    NVM_TRACE_CODEC_FIELD(wall_read_fr, 0, NVM_TRACE_CODEC_PRED_DELTA),
+
+    NVM_TRACE_CODEC_FIELD(wall_read_r, 0, NVM_TRACE_CODEC_PRED_DELTA),
+    NVM_TRACE_CODEC_FIELD(wall_read_fl, 0, NVM_TRACE_CODEC_PRED_DELTA),
+    NVM_TRACE_CODEC_FIELD(wall_read_l, 0, NVM_TRACE_CODEC_PRED_DELTA),
+    NVM_TRACE_CODEC_FIELD(op_mode, 0, NVM_TRACE_CODEC_PRED_DELTA),
+    NVM_TRACE_CODEC_FIELD(op_case, 0, NVM_TRACE_CODEC_PRED_DELTA),
+    NVM_TRACE_CODEC_FIELD(op_sub, 0, NVM_TRACE_CODEC_PRED_DELTA),
+    NVM_TRACE_CODEC_FIELD(test_id, 0, NVM_TRACE_CODEC_PRED_DELTA),
+};
+
+// フィールドを 32bit に広げる（符号付きは符号拡張）。差分は 32bit の周回で取る。
+static uint32_t nvm_trace_codec_load(const nvm_trace_log_record_t* rec, const nvm_trace_codec_field_t* f) {
+    const uint8_t* p = ((const uint8_t*)rec) + f->offset;
+    uint8_t v8;
+    uint16_t v16;
+    uint32_t v32;
+
+    switch (f->size) {
+        case 1U:
+            memcpy(&v8, p, sizeof(v8));
+            return (f->is_signed != 0U) ? (uint32_t)(int32_t)(int8_t)v8 : (uint32_t)v8;
+        case 2U:
+            memcpy(&v16, p, sizeof(v16));
+            return (f->is_signed != 0U) ? (uint32_t)(int32_t)(int16_t)v16 : (uint32_t)v16;
+        default:
+            memcpy(&v32, p, sizeof(v32));
+            return v32;
+    }
+}
+
+static void nvm_trace_codec_store(nvm_trace_log_record_t* rec, const nvm_trace_codec_field_t* f, uint32_t value) {
+    uint8_t* p = ((uint8_t*)rec) + f->offset;
+    uint8_t v8;
+    uint16_t v16;
+
+    switch (f->size) {
+        case 1U:
+            v8 = (uint8_t)value;
+            memcpy(p, &v8, sizeof(v8));
+            break;
+        case 2U:
+            v16 = (uint16_t)value;
+            memcpy(p, &v16, sizeof(v16));
+            break;
+        default:
+            memcpy(p, &value, sizeof(value));
+            break;
+    }
+}
+
+// 書き戻した値を読み直したときと同じ 32bit 値（狭いフィールドは切り詰めてから拡張）
+static uint32_t nvm_trace_codec_narrow(const nvm_trace_codec_field_t* f, uint32_t value) {
+    switch (f->size) {
+        case 1U:
+            return (f->is_signed != 0U) ? (uint32_t)(int32_t)(int8_t)(uint8_t)value : (value & 0xFFU);
+        case 2U:
+            return (f->is_signed != 0U) ? (uint32_t)(int32_t)(int16_t)(uint16_t)value : (value & 0xFFFFU);
+        default:
+            return value;
+    }
+}
+
+static uint32_t nvm_trace_codec_predict(const nvm_trace_codec_state_t* st, uint32_t i) {
+    if ((k_nvm_trace_codec_fields[i].pred == NVM_TRACE_CODEC_PRED_LINEAR) && (st->records >= 2U)) {
+        return (2U * st->prev[i]) - st->prev2[i];
+    }
+    return st->prev[i];
+}
+
+static uint32_t nvm_trace_codec_zigzag(uint32_t residual) {
+    return (residual << 1) ^ (uint32_t)(-(int32_t)(residual >> 31));
+}
+
+static uint32_t nvm_trace_codec_unzigzag(uint32_t z) {
+    return (z >> 1) ^ (uint32_t)(-(int32_t)(z & 1U));
+}
+
+static uint32_t nvm_trace_codec_varint_len(uint32_t v) {
+    uint32_t n = 1U;
+
+    while (v >= 0x80U) {
+        v >>= 7;
+        n++;
+    }
+    return n;
+}
+
+void nvm_trace_codec_reset(nvm_trace_codec_state_t* st) {
+    memset(st, 0, sizeof(*st));
+}
+
+uint32_t nvm_trace_codec_encode(nvm_trace_codec_state_t* st,
+                                const nvm_trace_log_record_t* rec,
+                                uint8_t* out,
+                                uint32_t out_size) {
+    uint32_t value[NVM_TRACE_CODEC_FIELD_COUNT];
+    uint32_t zz[NVM_TRACE_CODEC_FIELD_COUNT];
+    uint8_t field_mask[NVM_TRACE_CODEC_GROUP_COUNT];
+    uint8_t group_mask = 0U;
+    uint32_t len = 1U;
+    uint32_t pos;
+    uint32_t g;
+    uint32_t i;
+
+    memset(field_mask, 0, sizeof(field_mask));
+    for (i = 0U; i < NVM_TRACE_CODEC_FIELD_COUNT; ++i) {
+        value[i] = nvm_trace_codec_load(rec, &k_nvm_trace_codec_fields[i]);
+        zz[i] = nvm_trace_codec_zigzag(value[i] - nvm_trace_codec_predict(st, i));
+        if (zz[i] != 0U) {
+            field_mask[i / 8U] |= (uint8_t)(1U << (i % 8U));
+            len += nvm_trace_codec_varint_len(zz[i]);
+        }
+    }
+    for (g = 0U; g < NVM_TRACE_CODEC_GROUP_COUNT; ++g) {
+        if (field_mask[g] != 0U) {
+            group_mask |= (uint8_t)(1U << g);
+            len++;
+        }
+    }
+    if (len > out_size) {
+        return 0U;
+    }
+
+    out[0] = group_mask;
+    pos = 1U;
+    for (g = 0U; g < NVM_TRACE_CODEC_GROUP_COUNT; ++g) {
+        if (field_mask[g] == 0U) {
+            continue;
+        }
+        out[pos++] = field_mask[g];
+        for (i = g * 8U; (i < (g + 1U) * 8U) && (i < NVM_TRACE_CODEC_FIELD_COUNT); ++i) {
+            uint32_t v = zz[i];
+
+            if (v == 0U) {
+                continue;
+            }
+            while (v >= 0x80U) {
+                out[pos++] = (uint8_t)(v | 0x80U);
+                v >>= 7;
+            }
+            out[pos++] = (uint8_t)v;
+        }
+    }
+
+    memcpy(st->prev2, st->prev, sizeof(st->prev2));
+    memcpy(st->prev, value, sizeof(st->prev));
+    st->records++;
+    return pos;
+}
+
+uint32_t nvm_trace_codec_decode(nvm_trace_codec_state_t* st,
+                                const uint8_t* in,
+                                uint32_t in_len,
+                                nvm_trace_log_record_t* out) {
+    uint32_t value[NVM_TRACE_CODEC_FIELD_COUNT];
+    uint8_t group_mask;
+    uint8_t field_mask = 0U;
+    uint32_t pos = 1U;
+    uint32_t i;
+
+    if (in_len == 0U) {
+        return 0U;
+    }
+    group_mask = in[0];
+    if ((group_mask >> NVM_TRACE_CODEC_GROUP_COUNT) != 0U) {
+        return 0U;
+    }
+
+    for (i = 0U; i < NVM_TRACE_CODEC_FIELD_COUNT; ++i) {
+        uint32_t z = 0U;
+
+        if ((i % 8U) == 0U) {
+            field_mask = 0U;
+            if ((group_mask & (1U << (i / 8U))) != 0U) {
+                if (pos >= in_len) {
+                    return 0U;
+                }
+                field_mask = in[pos++];
+                if (field_mask == 0U) {
+                    return 0U;
+                }
+            }
+        }
+        if ((field_mask & (1U << (i % 8U))) != 0U) {
+            uint32_t shift = 0U;
+            uint8_t b;
+
+            do {
+                if ((pos >= in_len) || (shift > 28U)) {
+                    return 0U;
+                }
+                b = in[pos++];
+                z |= (uint32_t)(b & 0x7FU) << shift;
+                shift += 7U;
+            } while ((b & 0x80U) != 0U);
+        }
+        value[i] = nvm_trace_codec_narrow(&k_nvm_trace_codec_fields[i],
+                                          nvm_trace_codec_predict(st, i) + nvm_trace_codec_unzigzag(z));
+    }
+
+    memset(out, 0, sizeof(*out));
+    for (i = 0U; i < NVM_TRACE_CODEC_FIELD_COUNT; ++i) {
+        nvm_trace_codec_store(out, &k_nvm_trace_codec_fields[i], value[i]);
+    }
+    memcpy(st->prev2, st->prev, sizeof(st->prev2));
+    memcpy(st->prev, value, sizeof(st->prev));
+    st->records++;
+    return pos;
+}
+
+uint32_t nvm_trace_block_checksum(const uint8_t* data, uint32_t len) {
+    uint32_t sum = 0U;
+    uint32_t i;
+
+    for (i = 0U; i < len; ++i) {
+        sum += data[i];
+    }
+    return sum;
+}
+
+void nvm_trace_block_init(nvm_trace_codec_state_t* st, uint8_t* image) {
+    nvm_trace_block_header_t header;
+
+    memset(&header, 0, sizeof(header));
+    header.used_bytes = (uint16_t)sizeof(header);
+    memcpy(image, &header, sizeof(header));
+    nvm_trace_codec_reset(st);
+}
+
+bool nvm_trace_block_append(nvm_trace_codec_state_t* st,
+                            uint8_t* image,
+                            uint32_t block_size,
+                            const nvm_trace_log_record_t* rec,
+                            uint32_t* out_offset,
+                            uint32_t* out_len) {
+    nvm_trace_block_header_t header;
+    uint32_t len;
+
+    memcpy(&header, image, sizeof(header));
+    if ((header.records >= NVM_TRACE_CODEC_KEYFRAME_INTERVAL) || (header.used_bytes >= block_size)) {
+        return false;
+    }
+    len = nvm_trace_codec_encode(st, rec, image + header.used_bytes, block_size - header.used_bytes);
+    if (len == 0U) {
+        return false;
+    }
+
+    *out_offset = header.used_bytes;
+    *out_len = len;
+    header.checksum += nvm_trace_block_checksum(image + header.used_bytes, len);
+    header.used_bytes = (uint16_t)(header.used_bytes + len);
+    header.records++;
+    memcpy(image, &header, sizeof(header));
+    return true;
+}
+
+bool nvm_trace_block_header_valid(const nvm_trace_block_header_t* header, uint32_t block_size) {
+    if ((header->records == 0U) || (header->records > NVM_TRACE_CODEC_KEYFRAME_INTERVAL)) {
+        return false;
+    }
+    return (header->used_bytes > sizeof(*header)) && (header->used_bytes <= block_size);
+}
+
+bool nvm_trace_block_cursor_init(nvm_trace_block_cursor_t* cur, const uint8_t* image, uint32_t len) {
+    nvm_trace_block_header_t header;
+
+    memset(cur, 0, sizeof(*cur));
+    if (len < sizeof(header)) {
+        return false;
+    }
+    memcpy(&header, image, sizeof(header));
+    if (!nvm_trace_block_header_valid(&header, len)) {
+        return false;
+    }
+    if (nvm_trace_block_checksum(image + sizeof(header), header.used_bytes - (uint32_t)sizeof(header)) !=
+        header.checksum) {
+        return false;
+    }
+
+    cur->image = image;
+    cur->pos = sizeof(header);
+    cur->end = header.used_bytes;
+    cur->records = header.records;
+    return true;
+}
+
+bool nvm_trace_block_cursor_next(nvm_trace_block_cursor_t* cur, nvm_trace_log_record_t* out) {
+    uint32_t used;
+
+    if ((cur->image == NULL) || (cur->index >= cur->records)) {
+        return false;
+    }
+    used = nvm_trace_codec_decode(&cur->codec, cur->image + cur->pos, cur->end - cur->pos, out);
+    if (used == 0U) {
+        cur->image = NULL;
+        return false;
+    }
+    cur->pos += used;
+    cur->index++;
+    return true;
+}
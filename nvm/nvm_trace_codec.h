@@ -0,0 +1,91 @@
+#ifndef NIGHTFALL_NVM_TRACE_CODEC_H_
+#define NIGHTFALL_NVM_TRACE_CODEC_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "nvm_trace_log.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * トレースレコードの差分圧縮（HAL 非依存。nvm_trace_log.c と tests のホスト試験から利用）
+ *
+ * レコードはブロック単位で保存する。ブロック先頭のレコードはキーフレーム（全フィールドを 0 からの差分）で、
+ * 以降はフィールドごとに直前レコードからの予測との差を zigzag + varint で書く。値の変わらないフィールドは
+ * 書かず、変化したフィールドだけを 2 段のビットマスク（8 フィールドごとのグループ / グループ内）で示す。
+ * 距離・時刻のように一定の傾きで進むフィールドは直前 2 件からの直線予測を使う。
+ * ブロックは他のブロックに依存せずに復号できるため、壊れたブロックがあっても次のブロックから読み直せる。
+ *
+ * ブロック像: nvm_trace_block_header_t + 符号化レコード列（used_bytes まで）
+ */
+
+#define NVM_TRACE_CODEC_BLOCK_BYTES (1024U)
+#define NVM_TRACE_CODEC_KEYFRAME_INTERVAL (64U) // 1 ブロックの最大レコード数（= キーフレームの間隔）
+#define NVM_TRACE_CODEC_FIELD_COUNT (39U)
+#define NVM_TRACE_CODEC_GROUP_COUNT ((NVM_TRACE_CODEC_FIELD_COUNT + 7U) / 8U)
+// 1 レコードの最大長（グループマスク + フィールドマスク + 全フィールド 5 バイト varint）
+#define NVM_TRACE_CODEC_RECORD_MAX_BYTES \
+    (1U + NVM_TRACE_CODEC_GROUP_COUNT + (NVM_TRACE_CODEC_FIELD_COUNT * 5U))
+
+typedef struct __attribute__((packed)) {
+    uint16_t records;    // ブロック内のレコード数
+    uint16_t used_bytes; // ブロックヘッダ込みの使用バイト数
+    uint32_t checksum;   // ヘッダ以降 used_bytes までの加算チェックサム
+} nvm_trace_block_header_t;
+
+typedef struct {
+    uint32_t prev[NVM_TRACE_CODEC_FIELD_COUNT];
+    uint32_t prev2[NVM_TRACE_CODEC_FIELD_COUNT];
+    uint32_t records; // キーフレーム以降に符号化・復号したレコード数
+} nvm_trace_codec_state_t;
+
+// 次のレコードをキーフレームにする
+void nvm_trace_codec_reset(nvm_trace_codec_state_t* st);
+// out に符号化して長さを返す。out_size に収まらなければ 0 を返し、状態は変えない。
+uint32_t nvm_trace_codec_encode(nvm_trace_codec_state_t* st,
+                                const nvm_trace_log_record_t* rec,
+                                uint8_t* out,
+                                uint32_t out_size);
+// in から 1 レコードを復号して消費したバイト数を返す（壊れていれば 0）
+uint32_t nvm_trace_codec_decode(nvm_trace_codec_state_t* st,
+                                const uint8_t* in,
+                                uint32_t in_len,
+                                nvm_trace_log_record_t* out);
+
+uint32_t nvm_trace_block_checksum(const uint8_t* data, uint32_t len);
+// image（block_size バイト）を空のブロックにして符号化状態をキーフレームに戻す
+void nvm_trace_block_init(nvm_trace_codec_state_t* st, uint8_t* image);
+/* ブロックにレコードを追記し、追記したバイト列のブロック内オフセットと長さを返す。
+ * レコード数が NVM_TRACE_CODEC_KEYFRAME_INTERVAL に達しているか block_size に収まらなければ false
+ * （ブロックを閉じて次のブロックをキーフレームから始める）。 */
+bool nvm_trace_block_append(nvm_trace_codec_state_t* st,
+                            uint8_t* image,
+                            uint32_t block_size,
+                            const nvm_trace_log_record_t* rec,
+                            uint32_t* out_offset,
+                            uint32_t* out_len);
+// ブロックヘッダの値が範囲内か（チェックサムは見ない）
+bool nvm_trace_block_header_valid(const nvm_trace_block_header_t* header, uint32_t block_size);
+
+typedef struct {
+    nvm_trace_codec_state_t codec;
+    const uint8_t* image;
+    uint32_t pos;
+    uint32_t end;
+    uint32_t index;   // 次に復号するレコード番号（ブロック内、古い順）
+    uint32_t records;
+} nvm_trace_block_cursor_t;
+
+// ヘッダとチェックサムを確かめて先頭レコードに位置付ける（len はブロック像の有効長）
+bool nvm_trace_block_cursor_init(nvm_trace_block_cursor_t* cur, const uint8_t* image, uint32_t len);
+// 次のレコードを復号する（末尾または壊れていれば false）
+bool nvm_trace_block_cursor_next(nvm_trace_block_cursor_t* cur, nvm_trace_log_record_t* out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
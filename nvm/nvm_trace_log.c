@@ -1,8 +1,74 @@
 #include "nvm_trace_log.h"
 
+#include <stdbool.h>
 #include <string.h>
 
+#include "nvm_trace_codec.h"
+
 #define NVM_TRACE_LOG_HEADER_PREFIX_BYTES (16U)
+#define NVM_TRACE_LOG_HEADER_WAIT_MS (200U)
+#define NVM_TRACE_LOG_BLOCK_BYTES (NVM_TRACE_CODEC_BLOCK_BYTES)
+#define NVM_TRACE_LOG_MIN_BLOCKS (2U)
+#define NVM_TRACE_LOG_STREAM_BLOCKS (4U) // 範囲読み出しで 1 回の SPI 転送にまとめるブロック数
+
+/* 非同期のヘッダ書き込み用。書き込み完了まで内容を保持する必要があるため静的に置く */
+static nvm_trace_log_header_t g_nvm_trace_log_header_stage;
+static volatile uint8_t g_nvm_trace_log_header_pending = 0U;
+static volatile nvm_status_t g_nvm_trace_log_header_status = NVM_STATUS_OK;
+
+/* 追記側の符号化状態と追記中ブロックの像。非同期書き込みは像を直接指すので、閉じたブロックの
+ * ヘッダ書き込み（投入順に完了するので、その前の記録も書き終わっている）が済むまで次の面を使う。 */
+typedef struct {
+    nvm_trace_codec_state_t codec;
+    uint8_t image[2][NVM_TRACE_LOG_BLOCK_BYTES];
+    volatile uint8_t image_busy[2];
+    uint8_t active;
+    uint8_t valid;
+    uint32_t write_block;
+    uint32_t total_blocks;
+} nvm_trace_log_writer_t;
+
+/* read_latest の位置の控え。同じヘッダの間は前回のブロックから前後にたどる */
+typedef struct {
+    uint8_t valid;
+    uint8_t image_valid;
+    uint32_t total_records;
+    uint32_t total_blocks;
+    uint32_t age;        // 新しい方から何番目のブロックか（0 が追記中）
+    uint32_t tail_first; // ブロック内で最も新しいレコードの newest_index_from_tail
+    uint32_t records;
+    uint32_t image_len;
+    uint8_t image[NVM_TRACE_LOG_BLOCK_BYTES];
+} nvm_trace_log_reader_t;
+
+/* 範囲読み出し（ダンプ用）。連続するブロックをまとめて読み、古い順に復号して返す */
+typedef struct {
+    uint8_t active;
+    nvm_trace_log_header_t header; // 開いた時点のヘッダ
+    uint32_t age;                  // 次に読むブロック（新しい方から何番目か）
+    uint32_t blocks_left;          // age から追記中のブロックまでの残りブロック数
+    uint32_t skip;                 // 最初のブロックで読み飛ばすレコード数
+    uint32_t remaining;            // まだ返していないレコード数
+    uint32_t slot;                 // burst 内で処理中のブロック
+    uint32_t slots;                // burst に読んだブロック数
+    uint8_t cursor_valid;
+    nvm_trace_block_cursor_t cur;
+    uint8_t burst[NVM_TRACE_LOG_STREAM_BLOCKS][NVM_TRACE_LOG_BLOCK_BYTES];
+} nvm_trace_log_stream_t;
+
+typedef struct {
+    nvm_trace_log_header_t next;
+    uint8_t closed;         // 前のブロックを閉じた（そのヘッダを FRAM へ書く）
+    uint8_t closed_image;
+    uint32_t closed_offset;
+    const uint8_t* data;    // 今回の符号化バイト列（書き込み完了まで像の中に残る）
+    uint32_t offset;
+    uint32_t len;
+} nvm_trace_log_append_plan_t;
+
+static nvm_trace_log_writer_t g_nvm_trace_log_writer;
+static nvm_trace_log_reader_t g_nvm_trace_log_reader;
+static nvm_trace_log_stream_t g_nvm_trace_log_stream;
 
 static uint32_t nvm_trace_log_checksum(const uint8_t* data, uint32_t len) {
     uint32_t sum = 0U;
@@ -31,13 +97,25 @@ static nvm_status_t nvm_trace_log_get_area(nvm_area_info_t* out) {
     return NVM_STATUS_OK;
 }
 
+static uint32_t nvm_trace_log_block_count(const nvm_area_info_t* area) {
+    return (area->size_bytes - (uint32_t)sizeof(nvm_trace_log_header_t)) / NVM_TRACE_LOG_BLOCK_BYTES;
+}
+
+static uint32_t nvm_trace_log_block_offset(uint32_t block) {
+    return (uint32_t)sizeof(nvm_trace_log_header_t) + block * NVM_TRACE_LOG_BLOCK_BYTES;
+}
+
+static uint32_t nvm_trace_log_stored_blocks(const nvm_trace_log_header_t* header) {
+    return (header->total_blocks < header->block_count) ? header->total_blocks : header->block_count;
+}
+
 static nvm_status_t nvm_trace_log_validate_header(const nvm_trace_log_header_t* header,
                                                   const nvm_area_info_t* area,
-                                                  uint32_t* out_capacity) {
+                                                  uint32_t* out_block_count) {
     const uint8_t* payload;
     uint32_t payload_len;
     uint32_t calc_crc;
-    uint32_t expected_capacity;
+    uint32_t expected_blocks;
 
     if ((header == NULL) || (area == NULL)) {
         return NVM_STATUS_INVALID_ARG;
@@ -52,19 +130,25 @@ static nvm_status_t nvm_trace_log_validate_header(const nvm_trace_log_header_t*
     if (header->length != sizeof(nvm_trace_log_header_t)) {
         return NVM_STATUS_INTEGRITY_ERROR;
     }
-    if (header->record_size != sizeof(nvm_trace_log_record_t)) {
+    if ((header->record_size != sizeof(nvm_trace_log_record_t)) ||
+        (header->block_size != NVM_TRACE_LOG_BLOCK_BYTES)) {
         return NVM_STATUS_INTEGRITY_ERROR;
     }
 
-    expected_capacity =
-        (area->size_bytes - (uint32_t)sizeof(nvm_trace_log_header_t)) / (uint32_t)sizeof(nvm_trace_log_record_t);
-    if (expected_capacity == 0U) {
+    expected_blocks = nvm_trace_log_block_count(area);
+    if (expected_blocks < NVM_TRACE_LOG_MIN_BLOCKS) {
         return NVM_STATUS_UNSUPPORTED;
     }
-    if (header->record_capacity != expected_capacity) {
+    if (header->block_count != expected_blocks) {
         return NVM_STATUS_INTEGRITY_ERROR;
     }
-    if (header->write_index >= header->record_capacity) {
+    if ((header->write_block >= header->block_count) || (header->total_blocks == 0U)) {
+        return NVM_STATUS_INTEGRITY_ERROR;
+    }
+    if ((header->open_records > NVM_TRACE_CODEC_KEYFRAME_INTERVAL) ||
+        (header->open_used < sizeof(nvm_trace_block_header_t)) ||
+        (header->open_used > NVM_TRACE_LOG_BLOCK_BYTES) ||
+        ((header->open_records == 0U) != (header->open_used == sizeof(nvm_trace_block_header_t)))) {
         return NVM_STATUS_INTEGRITY_ERROR;
     }
 
@@ -75,8 +159,8 @@ static nvm_status_t nvm_trace_log_validate_header(const nvm_trace_log_header_t*
         return NVM_STATUS_INTEGRITY_ERROR;
     }
 
-    if (out_capacity != NULL) {
-        *out_capacity = expected_capacity;
+    if (out_block_count != NULL) {
+        *out_block_count = expected_blocks;
     }
     return NVM_STATUS_OK;
 }
@@ -91,6 +175,163 @@ static void nvm_trace_log_finalize_header(nvm_trace_log_header_t* header) {
     header->crc = nvm_trace_log_checksum(payload, payload_len);
 }
 
+static void nvm_trace_log_open_block_header(const nvm_trace_log_header_t* header, nvm_trace_block_header_t* out) {
+    out->records = header->open_records;
+    out->used_bytes = header->open_used;
+    out->checksum = header->open_checksum;
+}
+
+/* 新しい方から age 番目のブロックのヘッダ（追記中はログヘッダから）。
+ * 範囲外・空・壊れたヘッダは records = 0 で返す（そのブロックを飛ばして古い方を読む）。 */
+static nvm_status_t nvm_trace_log_read_block_header(const nvm_trace_log_header_t* header,
+                                                    uint32_t age,
+                                                    nvm_trace_block_header_t* out) {
+    uint32_t block;
+    nvm_status_t st;
+
+    if (age == 0U) {
+        nvm_trace_log_open_block_header(header, out);
+    } else {
+        block = (header->write_block + header->block_count - age) % header->block_count;
+        st = nvm_read(NVM_AREA_TRACE_LOG, nvm_trace_log_block_offset(block), out, sizeof(*out));
+        if (st != NVM_STATUS_OK) {
+            return st;
+        }
+    }
+    if (!nvm_trace_block_header_valid(out, NVM_TRACE_LOG_BLOCK_BYTES)) {
+        memset(out, 0, sizeof(*out));
+    }
+    return NVM_STATUS_OK;
+}
+
+static void nvm_trace_log_wait_images(void) {
+    if ((g_nvm_trace_log_writer.image_busy[0] != 0U) || (g_nvm_trace_log_writer.image_busy[1] != 0U)) {
+        (void)nvm_write_barrier(NVM_TRACE_LOG_HEADER_WAIT_MS);
+    }
+}
+
+static bool nvm_trace_log_writer_matches(const nvm_trace_log_header_t* header) {
+    const nvm_trace_log_writer_t* w = &g_nvm_trace_log_writer;
+    nvm_trace_block_header_t block;
+
+    if ((w->valid == 0U) || (w->write_block != header->write_block) || (w->total_blocks != header->total_blocks)) {
+        return false;
+    }
+    memcpy(&block, w->image[w->active], sizeof(block));
+    return (block.records == header->open_records) && (block.used_bytes == header->open_used) &&
+           (block.checksum == header->open_checksum);
+}
+
+// 電源再投入後などは FRAM の追記中ブロックを読み直して符号化状態を復元する
+static nvm_status_t nvm_trace_log_writer_load(const nvm_trace_log_header_t* header) {
+    nvm_trace_log_writer_t* w = &g_nvm_trace_log_writer;
+    nvm_trace_block_cursor_t cur;
+    nvm_trace_block_header_t block;
+    nvm_trace_log_record_t rec;
+    nvm_status_t st;
+
+    nvm_trace_log_wait_images();
+    if ((w->image_busy[0] != 0U) || (w->image_busy[1] != 0U)) {
+        return NVM_STATUS_BUSY;
+    }
+
+    w->valid = 0U;
+    w->active = 0U;
+    nvm_trace_block_init(&w->codec, w->image[0]);
+    if (header->open_records != 0U) {
+        st = nvm_read(NVM_AREA_TRACE_LOG, nvm_trace_log_block_offset(header->write_block), w->image[0],
+                      header->open_used);
+        if (st != NVM_STATUS_OK) {
+            return st;
+        }
+        nvm_trace_log_open_block_header(header, &block);
+        memcpy(w->image[0], &block, sizeof(block));
+        if (!nvm_trace_block_cursor_init(&cur, w->image[0], header->open_used)) {
+            return NVM_STATUS_INTEGRITY_ERROR;
+        }
+        while (nvm_trace_block_cursor_next(&cur, &rec)) {
+            // 末尾まで復号して符号化側と同じ予測状態にする
+        }
+        if (cur.index != cur.records) {
+            return NVM_STATUS_INTEGRITY_ERROR;
+        }
+        w->codec = cur.codec;
+    }
+    w->write_block = header->write_block;
+    w->total_blocks = header->total_blocks;
+    w->valid = 1U;
+    return NVM_STATUS_OK;
+}
+
+/* record を追記中ブロックへ符号化し、書き込むバイト列と次のヘッダを決める。
+ * ブロックに入らなければ閉じて、次のブロックをキーフレームから始める。 */
+static nvm_status_t nvm_trace_log_plan_append(const nvm_trace_log_header_t* header,
+                                              const nvm_trace_log_record_t* record,
+                                              nvm_trace_log_append_plan_t* plan) {
+    nvm_trace_log_writer_t* w = &g_nvm_trace_log_writer;
+    nvm_trace_block_header_t block;
+    nvm_area_info_t area;
+    uint32_t offset;
+    uint32_t len;
+    uint8_t next_image;
+    nvm_status_t st;
+
+    st = nvm_trace_log_get_area(&area);
+    if (st != NVM_STATUS_OK) {
+        return st;
+    }
+    st = nvm_trace_log_validate_header(header, &area, NULL);
+    if (st != NVM_STATUS_OK) {
+        return st;
+    }
+    if (!nvm_trace_log_writer_matches(header)) {
+        st = nvm_trace_log_writer_load(header);
+        if (st != NVM_STATUS_OK) {
+            return st;
+        }
+    }
+
+    memset(plan, 0, sizeof(*plan));
+    g_nvm_trace_log_reader.valid = 0U;
+    if (!nvm_trace_block_append(&w->codec, w->image[w->active], NVM_TRACE_LOG_BLOCK_BYTES, record, &offset, &len)) {
+        next_image = (uint8_t)(w->active ^ 1U);
+        if (w->image_busy[next_image] != 0U) {
+            (void)nvm_write_barrier(NVM_TRACE_LOG_HEADER_WAIT_MS);
+            if (w->image_busy[next_image] != 0U) {
+                return NVM_STATUS_BUSY;
+            }
+        }
+        plan->closed = 1U;
+        plan->closed_image = w->active;
+        plan->closed_offset = nvm_trace_log_block_offset(w->write_block);
+
+        w->active = next_image;
+        w->write_block = (w->write_block + 1U) % header->block_count;
+        w->total_blocks += 1U;
+        nvm_trace_block_init(&w->codec, w->image[w->active]);
+        if (!nvm_trace_block_append(&w->codec, w->image[w->active], NVM_TRACE_LOG_BLOCK_BYTES, record, &offset,
+                                    &len)) {
+            w->valid = 0U;
+            return NVM_STATUS_INTEGRITY_ERROR;
+        }
+    }
+
+    memcpy(&block, w->image[w->active], sizeof(block));
+    plan->next = *header;
+    plan->next.write_block = w->write_block;
+    plan->next.total_blocks = w->total_blocks;
+    plan->next.total_records += 1U;
+    plan->next.open_records = block.records;
+    plan->next.open_used = block.used_bytes;
+    plan->next.open_checksum = block.checksum;
+    nvm_trace_log_finalize_header(&plan->next);
+
+    plan->data = w->image[w->active] + offset;
+    plan->offset = nvm_trace_log_block_offset(w->write_block) + offset;
+    plan->len = len;
+    return NVM_STATUS_OK;
+}
+
 nvm_status_t nvm_trace_log_format(void) {
     nvm_area_info_t area;
     nvm_trace_log_header_t header;
@@ -100,24 +341,37 @@ nvm_status_t nvm_trace_log_format(void) {
     if (st != NVM_STATUS_OK) {
         return st;
     }
+    if (nvm_trace_log_block_count(&area) < NVM_TRACE_LOG_MIN_BLOCKS) {
+        return NVM_STATUS_UNSUPPORTED;
+    }
 
     memset(&header, 0, sizeof(header));
     header.magic = NVM_TRACE_LOG_MAGIC;
     header.version = NVM_TRACE_LOG_SCHEMA_VERSION;
     header.length = sizeof(header);
     header.record_size = sizeof(nvm_trace_log_record_t);
-    header.record_capacity =
-        (area.size_bytes - (uint32_t)sizeof(nvm_trace_log_header_t)) / (uint32_t)sizeof(nvm_trace_log_record_t);
-    header.write_index = 0U;
+    header.block_size = NVM_TRACE_LOG_BLOCK_BYTES;
+    header.block_count = nvm_trace_log_block_count(&area);
+    header.write_block = 0U;
     header.total_records = 0U;
+    header.total_blocks = 1U;
+    header.open_records = 0U;
+    header.open_used = (uint16_t)sizeof(nvm_trace_block_header_t);
+    header.open_checksum = 0U;
     nvm_trace_log_finalize_header(&header);
 
+    g_nvm_trace_log_writer.valid = 0U;
+    g_nvm_trace_log_reader.valid = 0U;
     st = nvm_erase(NVM_AREA_TRACE_LOG);
     if (st != NVM_STATUS_OK) {
         return st;
     }
 
-    return nvm_write(NVM_AREA_TRACE_LOG, 0U, &header, sizeof(header));
+    st = nvm_write(NVM_AREA_TRACE_LOG, 0U, &header, sizeof(header));
+    if (st != NVM_STATUS_OK) {
+        return st;
+    }
+    return nvm_trace_log_writer_load(&header);
 }
 
 nvm_status_t nvm_trace_log_get_header(nvm_trace_log_header_t* out) {
@@ -183,57 +437,131 @@ nvm_status_t nvm_trace_log_commit_header(const nvm_trace_log_header_t* header) {
 nvm_status_t nvm_trace_log_append_cached(nvm_trace_log_header_t* header,
                                          const nvm_trace_log_record_t* record,
                                          uint8_t commit_header) {
-    nvm_area_info_t area;
-    nvm_trace_log_header_t next;
-    uint32_t write_pos;
-    uint32_t record_offset;
+    nvm_trace_log_append_plan_t plan;
     nvm_status_t st;
 
     if ((header == NULL) || (record == NULL)) {
         return NVM_STATUS_INVALID_ARG;
     }
 
-    st = nvm_trace_log_get_area(&area);
+    st = nvm_trace_log_plan_append(header, record, &plan);
     if (st != NVM_STATUS_OK) {
         return st;
     }
 
-    st = nvm_trace_log_validate_header(header, &area, NULL);
+    if (plan.closed != 0U) {
+        st = nvm_write(NVM_AREA_TRACE_LOG, plan.closed_offset, g_nvm_trace_log_writer.image[plan.closed_image],
+                       sizeof(nvm_trace_block_header_t));
+        if (st != NVM_STATUS_OK) {
+            g_nvm_trace_log_writer.valid = 0U;
+            return st;
+        }
+    }
+    st = nvm_write(NVM_AREA_TRACE_LOG, plan.offset, plan.data, plan.len);
     if (st != NVM_STATUS_OK) {
+        g_nvm_trace_log_writer.valid = 0U;
         return st;
     }
 
-    write_pos = header->write_index;
-    record_offset = (uint32_t)sizeof(nvm_trace_log_header_t) + write_pos * (uint32_t)sizeof(nvm_trace_log_record_t);
+    if (commit_header != 0U) {
+        st = nvm_write(NVM_AREA_TRACE_LOG, 0U, &plan.next, sizeof(plan.next));
+        if (st != NVM_STATUS_OK) {
+            g_nvm_trace_log_writer.valid = 0U;
+            return st;
+        }
+    }
+
+    *header = plan.next;
+    return NVM_STATUS_OK;
+}
+
+nvm_status_t nvm_trace_log_read_block(const nvm_trace_log_header_t* header,
+                                      uint32_t block_from_tail,
+                                      uint8_t* out,
+                                      uint32_t out_size,
+                                      uint32_t* out_len,
+                                      uint32_t* out_records) {
+    nvm_trace_block_header_t block;
+    uint32_t block_index;
+    nvm_status_t st;
 
-    st = nvm_write(NVM_AREA_TRACE_LOG, record_offset, record, sizeof(*record));
+    if ((header == NULL) || (out == NULL) || (out_len == NULL) || (out_records == NULL) ||
+        (out_size < NVM_TRACE_LOG_BLOCK_BYTES)) {
+        return NVM_STATUS_INVALID_ARG;
+    }
+    *out_len = 0U;
+    *out_records = 0U;
+    if (block_from_tail >= nvm_trace_log_stored_blocks(header)) {
+        return NVM_STATUS_NOT_FOUND;
+    }
+
+    st = nvm_trace_log_read_block_header(header, block_from_tail, &block);
     if (st != NVM_STATUS_OK) {
         return st;
     }
+    if (block.records == 0U) {
+        // 追記中で空、またはヘッダが壊れたブロック
+        return (block_from_tail == 0U) ? NVM_STATUS_OK : NVM_STATUS_INTEGRITY_ERROR;
+    }
 
-    next = *header;
-    next.write_index = (write_pos + 1U) % next.record_capacity;
-    next.total_records += 1U;
-    nvm_trace_log_finalize_header(&next);
+    block_index = (header->write_block + header->block_count - block_from_tail) % header->block_count;
+    st = nvm_read(NVM_AREA_TRACE_LOG, nvm_trace_log_block_offset(block_index), out, block.used_bytes);
+    if (st != NVM_STATUS_OK) {
+        return st;
+    }
+    memcpy(out, &block, sizeof(block));
+    if (nvm_trace_block_checksum(out + sizeof(block), block.used_bytes - (uint32_t)sizeof(block)) != block.checksum) {
+        return NVM_STATUS_INTEGRITY_ERROR;
+    }
 
-    if (commit_header != 0U) {
-        st = nvm_write(NVM_AREA_TRACE_LOG, 0U, &next, sizeof(next));
+    *out_len = block.used_bytes;
+    *out_records = block.records;
+    return NVM_STATUS_OK;
+}
+
+nvm_status_t nvm_trace_log_get_stored(const nvm_trace_log_header_t* header,
+                                      uint32_t* out_records,
+                                      uint32_t* out_bytes) {
+    nvm_trace_block_header_t block;
+    uint32_t stored_blocks;
+    uint32_t records = 0U;
+    uint32_t bytes = 0U;
+    uint32_t age;
+    nvm_status_t st;
+
+    if (header == NULL) {
+        return NVM_STATUS_INVALID_ARG;
+    }
+
+    stored_blocks = nvm_trace_log_stored_blocks(header);
+    for (age = 0U; age < stored_blocks; ++age) {
+        st = nvm_trace_log_read_block_header(header, age, &block);
         if (st != NVM_STATUS_OK) {
             return st;
         }
+        records += block.records;
+        bytes += (block.records != 0U) ? block.used_bytes : 0U;
     }
 
-    *header = next;
+    if (out_records != NULL) {
+        *out_records = records;
+    }
+    if (out_bytes != NULL) {
+        *out_bytes = bytes;
+    }
     return NVM_STATUS_OK;
 }
 
 nvm_status_t nvm_trace_log_read_latest(uint32_t newest_index_from_tail,
                                        nvm_trace_log_record_t* out) {
+    nvm_trace_log_reader_t* r = &g_nvm_trace_log_reader;
     nvm_area_info_t area;
     nvm_trace_log_header_t header;
-    uint32_t available;
-    uint32_t logical_index;
-    uint32_t record_offset;
+    nvm_trace_block_header_t block;
+    nvm_trace_block_cursor_t cur;
+    uint32_t stored_blocks;
+    uint32_t skip;
+    uint32_t records;
     nvm_status_t st;
 
     if (out == NULL) {
@@ -254,18 +582,380 @@ nvm_status_t nvm_trace_log_read_latest(uint32_t newest_index_from_tail,
     if (st != NVM_STATUS_OK) {
         return st;
     }
+    if (newest_index_from_tail >= header.total_records) {
+        return NVM_STATUS_NOT_FOUND;
+    }
 
-    available = header.total_records;
-    if (available > header.record_capacity) {
-        available = header.record_capacity;
+    if ((r->valid == 0U) || (r->total_records != header.total_records) || (r->total_blocks != header.total_blocks)) {
+        r->valid = 0U;
+        r->image_valid = 0U;
+        r->total_records = header.total_records;
+        r->total_blocks = header.total_blocks;
+        r->age = 0U;
+        r->tail_first = 0U;
+        r->records = header.open_records;
+        r->valid = 1U;
     }
-    if (newest_index_from_tail >= available) {
+
+    // 目的のレコードを含むブロックまで、控えの位置から新しい方・古い方へたどる
+    stored_blocks = nvm_trace_log_stored_blocks(&header);
+    while ((newest_index_from_tail < r->tail_first) && (r->age > 0U)) {
+        st = nvm_trace_log_read_block_header(&header, r->age - 1U, &block);
+        if (st != NVM_STATUS_OK) {
+            r->valid = 0U;
+            return st;
+        }
+        if (block.records > r->tail_first) {
+            r->valid = 0U;
+            return NVM_STATUS_INTEGRITY_ERROR;
+        }
+        r->age--;
+        r->records = block.records;
+        r->tail_first -= block.records;
+        r->image_valid = 0U;
+    }
+    while (newest_index_from_tail >= (r->tail_first + r->records)) {
+        if ((r->age + 1U) >= stored_blocks) {
+            return NVM_STATUS_NOT_FOUND;
+        }
+        st = nvm_trace_log_read_block_header(&header, r->age + 1U, &block);
+        if (st != NVM_STATUS_OK) {
+            r->valid = 0U;
+            return st;
+        }
+        r->tail_first += r->records;
+        r->age++;
+        r->records = block.records;
+        r->image_valid = 0U;
+    }
+
+    if (r->image_valid == 0U) {
+        st = nvm_trace_log_read_block(&header, r->age, r->image, sizeof(r->image), &r->image_len, &records);
+        if (st != NVM_STATUS_OK) {
+            return st;
+        }
+        if (records != r->records) {
+            r->valid = 0U;
+            return NVM_STATUS_INTEGRITY_ERROR;
+        }
+        r->image_valid = 1U;
+    }
+
+    // ブロックの先頭（キーフレーム）から目的のレコードまで復号する
+    if (!nvm_trace_block_cursor_init(&cur, r->image, r->image_len)) {
+        return NVM_STATUS_INTEGRITY_ERROR;
+    }
+    skip = r->records - 1U - (newest_index_from_tail - r->tail_first);
+    do {
+        if (!nvm_trace_block_cursor_next(&cur, out)) {
+            return NVM_STATUS_INTEGRITY_ERROR;
+        }
+    } while (cur.index <= skip);
+    return NVM_STATUS_OK;
+}
+
+/* 次の burst を読む。age から新しい方へ連続するブロックを、リングの末尾で折り返さない範囲で
+ * 1 回の nvm_read にまとめる（追記中のブロックはヘッダをログヘッダから補う）。 */
+static nvm_status_t nvm_trace_log_stream_fill(nvm_trace_log_stream_t* s) {
+    uint32_t block;
+    uint32_t count;
+    uint32_t i;
+    nvm_status_t st;
+
+    block = (s->header.write_block + s->header.block_count - s->age) % s->header.block_count;
+    count = s->blocks_left;
+    if (count > NVM_TRACE_LOG_STREAM_BLOCKS) {
+        count = NVM_TRACE_LOG_STREAM_BLOCKS;
+    }
+    if (count > (s->header.block_count - block)) {
+        count = s->header.block_count - block;
+    }
+
+    st = nvm_read(NVM_AREA_TRACE_LOG, nvm_trace_log_block_offset(block), s->burst[0],
+                  (size_t)count * NVM_TRACE_LOG_BLOCK_BYTES);
+    if (st != NVM_STATUS_OK) {
+        return st;
+    }
+    for (i = 0U; i < count; ++i) {
+        if (s->age == i) {
+            nvm_trace_block_header_t open;
+            nvm_trace_log_open_block_header(&s->header, &open);
+            memcpy(s->burst[i], &open, sizeof(open));
+        }
+    }
+    s->slot = 0U;
+    s->slots = count;
+    return NVM_STATUS_OK;
+}
+
+/* burst 内の次のブロックを返して age を進める。追記中のブロックまで読んだら NOT_FOUND。
+ * 空の追記中ブロックは records = 0 で返す。チェックサムが合わなければ INTEGRITY_ERROR で、
+ * ヘッダが読めればそのレコード数を out_records に返す（件数の勘定用）。 */
+static nvm_status_t nvm_trace_log_stream_take_block(nvm_trace_log_stream_t* s,
+                                                    const uint8_t** out_image,
+                                                    uint32_t* out_len,
+                                                    uint32_t* out_records) {
+    nvm_trace_block_header_t block;
+    const uint8_t* image;
+    nvm_status_t st;
+
+    if (s->blocks_left == 0U) {
+        return NVM_STATUS_NOT_FOUND;
+    }
+    if (s->slot >= s->slots) {
+        st = nvm_trace_log_stream_fill(s);
+        if (st != NVM_STATUS_OK) {
+            return st;
+        }
+    }
+
+    image = s->burst[s->slot];
+    s->slot++;
+    memcpy(&block, image, sizeof(block));
+    *out_image = image;
+    *out_len = 0U;
+    *out_records = 0U;
+    s->blocks_left--;
+    if (s->age > 0U) {
+        s->age--;
+    }
+
+    if ((block.records == 0U) && (block.used_bytes == sizeof(block))) {
+        return NVM_STATUS_OK;
+    }
+    if (!nvm_trace_block_header_valid(&block, NVM_TRACE_LOG_BLOCK_BYTES)) {
+        return NVM_STATUS_INTEGRITY_ERROR;
+    }
+    if (nvm_trace_block_checksum(image + sizeof(block), block.used_bytes - (uint32_t)sizeof(block)) !=
+        block.checksum) {
+        *out_records = block.records;
+        return NVM_STATUS_INTEGRITY_ERROR;
+    }
+    *out_len = block.used_bytes;
+    *out_records = block.records;
+    return NVM_STATUS_OK;
+}
+
+nvm_status_t nvm_trace_log_stream_open(uint32_t count, uint32_t* out_count) {
+    nvm_trace_log_stream_t* s = &g_nvm_trace_log_stream;
+    nvm_area_info_t area;
+    nvm_trace_block_header_t block;
+    uint32_t stored_blocks;
+    uint32_t covered = 0U;
+    uint32_t age = 0U;
+    nvm_status_t st;
+
+    s->active = 0U;
+    if (out_count != NULL) {
+        *out_count = 0U;
+    }
+
+    st = nvm_trace_log_get_area(&area);
+    if (st != NVM_STATUS_OK) {
+        return st;
+    }
+    st = nvm_read(NVM_AREA_TRACE_LOG, 0U, &s->header, sizeof(s->header));
+    if (st != NVM_STATUS_OK) {
+        return st;
+    }
+    st = nvm_trace_log_validate_header(&s->header, &area, NULL);
+    if (st != NVM_STATUS_OK) {
+        return st;
+    }
+
+    // 新しい方からブロックヘッダをたどり、count 件を含む最も古いブロックを探す
+    stored_blocks = nvm_trace_log_stored_blocks(&s->header);
+    while (age < stored_blocks) {
+        st = nvm_trace_log_read_block_header(&s->header, age, &block);
+        if (st != NVM_STATUS_OK) {
+            return st;
+        }
+        covered += block.records;
+        if ((count != 0U) && (covered >= count)) {
+            break;
+        }
+        age++;
+    }
+    if (age == stored_blocks) {
+        age = stored_blocks - 1U;
+    }
+    if ((count == 0U) || (count > covered)) {
+        count = covered;
+    }
+
+    s->age = age;
+    s->blocks_left = age + 1U;
+    s->skip = covered - count;
+    s->remaining = count;
+    s->slot = 0U;
+    s->slots = 0U;
+    s->cursor_valid = 0U;
+    s->active = 1U;
+    if (out_count != NULL) {
+        *out_count = count;
+    }
+    return NVM_STATUS_OK;
+}
+
+nvm_status_t nvm_trace_log_stream_next(nvm_trace_log_record_t* out) {
+    nvm_trace_log_stream_t* s = &g_nvm_trace_log_stream;
+    const uint8_t* image;
+    uint32_t len;
+    uint32_t records;
+    nvm_status_t st;
+
+    if (out == NULL) {
+        return NVM_STATUS_INVALID_ARG;
+    }
+    if ((s->active == 0U) || (s->remaining == 0U)) {
+        return NVM_STATUS_NOT_FOUND;
+    }
+
+    while ((s->cursor_valid == 0U) || (s->cur.index >= s->cur.records)) {
+        s->cursor_valid = 0U;
+        st = nvm_trace_log_stream_take_block(s, &image, &len, &records);
+        if (st == NVM_STATUS_INTEGRITY_ERROR) {
+            // 壊れたブロックの分は返さずに次のブロックへ進む（呼び出し側は続けて読める）
+            records = (records > s->skip) ? (records - s->skip) : 0U;
+            s->remaining = (records < s->remaining) ? (s->remaining - records) : 0U;
+            s->skip = 0U;
+            return st;
+        }
+        if (st != NVM_STATUS_OK) {
+            return st;
+        }
+        if (records == 0U) {
+            continue;
+        }
+        if (!nvm_trace_block_cursor_init(&s->cur, image, len)) {
+            return NVM_STATUS_INTEGRITY_ERROR;
+        }
+        s->cursor_valid = 1U;
+    }
+
+    for (;;) {
+        if (!nvm_trace_block_cursor_next(&s->cur, out)) {
+            s->cursor_valid = 0U;
+            return NVM_STATUS_INTEGRITY_ERROR;
+        }
+        if (s->skip == 0U) {
+            break;
+        }
+        s->skip--;
+    }
+    s->remaining--;
+    return NVM_STATUS_OK;
+}
+
+nvm_status_t nvm_trace_log_stream_next_block(const uint8_t** out_image, uint32_t* out_len, uint32_t* out_records) {
+    nvm_trace_log_stream_t* s = &g_nvm_trace_log_stream;
+    nvm_status_t st;
+
+    if ((out_image == NULL) || (out_len == NULL) || (out_records == NULL)) {
+        return NVM_STATUS_INVALID_ARG;
+    }
+    if ((s->active == 0U) || (s->remaining == 0U)) {
         return NVM_STATUS_NOT_FOUND;
     }
 
-    logical_index = (header.write_index + header.record_capacity - 1U - newest_index_from_tail) % header.record_capacity;
-    record_offset =
-        (uint32_t)sizeof(nvm_trace_log_header_t) + logical_index * (uint32_t)sizeof(nvm_trace_log_record_t);
+    do {
+        st = nvm_trace_log_stream_take_block(s, out_image, out_len, out_records);
+    } while ((st == NVM_STATUS_OK) && (*out_records == 0U));
+    if ((st == NVM_STATUS_OK) || (st == NVM_STATUS_INTEGRITY_ERROR)) {
+        // 最初のブロックは要求より古いレコードを含むことがある（件数に揃えるのは受け取る側）
+        uint32_t left = s->remaining + s->skip;
+        s->remaining = (*out_records < left) ? (left - *out_records) : 0U;
+        s->skip = 0U;
+    }
+    return st;
+}
+
+void nvm_trace_log_stream_close(void) {
+    g_nvm_trace_log_stream.active = 0U;
+}
+
+static void nvm_trace_log_header_write_done(nvm_status_t status, void* ctx) {
+    (void)ctx;
+    if (status != NVM_STATUS_OK) {
+        g_nvm_trace_log_header_status = status;
+    }
+    g_nvm_trace_log_header_pending = 0U;
+}
+
+// 閉じたブロックのヘッダの書き込み完了（投入順に完了するので、そのブロックの記録も書き終わっている）
+static void nvm_trace_log_block_write_done(nvm_status_t status, void* ctx) {
+    volatile uint8_t* busy = (volatile uint8_t*)ctx;
 
-    return nvm_read(NVM_AREA_TRACE_LOG, record_offset, out, sizeof(*out));
+    if (status != NVM_STATUS_OK) {
+        g_nvm_trace_log_header_status = status;
+    }
+    *busy = 0U;
+}
+
+nvm_status_t nvm_trace_log_append_cached_async(nvm_trace_log_header_t* header,
+                                               const nvm_trace_log_record_t* record,
+                                               uint8_t commit_header,
+                                               nvm_write_done_fn done,
+                                               void* ctx) {
+    nvm_trace_log_writer_t* w = &g_nvm_trace_log_writer;
+    nvm_trace_log_append_plan_t plan;
+    nvm_status_t st;
+
+    if ((header == NULL) || (record == NULL)) {
+        return NVM_STATUS_INVALID_ARG;
+    }
+
+    /* 前回の非同期ヘッダ書き込みの失敗はここで返す */
+    st = g_nvm_trace_log_header_status;
+    if (st != NVM_STATUS_OK) {
+        g_nvm_trace_log_header_status = NVM_STATUS_OK;
+        return st;
+    }
+
+    /* record は符号化してブロック像に写すので、呼び出し側はこの関数から戻れば再利用できる
+     * （done は従来どおり、このレコードの FRAM 書き込み完了で呼ぶ） */
+    st = nvm_trace_log_plan_append(header, record, &plan);
+    if (st != NVM_STATUS_OK) {
+        return st;
+    }
+
+    if (plan.closed != 0U) {
+        w->image_busy[plan.closed_image] = 1U;
+        st = nvm_write_async(NVM_AREA_TRACE_LOG, plan.closed_offset, w->image[plan.closed_image],
+                             sizeof(nvm_trace_block_header_t), nvm_trace_log_block_write_done,
+                             (void*)&w->image_busy[plan.closed_image]);
+        if (st != NVM_STATUS_OK) {
+            w->image_busy[plan.closed_image] = 0U;
+            w->valid = 0U;
+            return st;
+        }
+    }
+    st = nvm_write_async(NVM_AREA_TRACE_LOG, plan.offset, plan.data, plan.len, done, ctx);
+    if (st != NVM_STATUS_OK) {
+        w->valid = 0U;
+        return st;
+    }
+
+    if (commit_header != 0U) {
+        /* 前のヘッダがまだ送出待ちなら終わるまで待つ（通常は記録数本ぶん前に完了している） */
+        if (g_nvm_trace_log_header_pending != 0U) {
+            (void)nvm_write_barrier(NVM_TRACE_LOG_HEADER_WAIT_MS);
+            if (g_nvm_trace_log_header_pending != 0U) {
+                w->valid = 0U;
+                return NVM_STATUS_BUSY;
+            }
+        }
+        g_nvm_trace_log_header_stage = plan.next;
+        g_nvm_trace_log_header_pending = 1U;
+        st = nvm_write_async(NVM_AREA_TRACE_LOG, 0U, &g_nvm_trace_log_header_stage,
+                             sizeof(g_nvm_trace_log_header_stage), nvm_trace_log_header_write_done, NULL);
+        if (st != NVM_STATUS_OK) {
+            g_nvm_trace_log_header_pending = 0U;
+            w->valid = 0U;
+            return st;
+        }
+    }
+
+    *header = plan.next;
+    return NVM_STATUS_OK;
 }
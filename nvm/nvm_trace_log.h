@@ -10,17 +10,24 @@ extern "C" {
 #endif
 
 #define NVM_TRACE_LOG_MAGIC (0x544C4F47UL)
-#define NVM_TRACE_LOG_SCHEMA_VERSION (0x00060000UL)
+#define NVM_TRACE_LOG_SCHEMA_VERSION (0x00080000UL)
 
+/* ヘッダの後ろは block_size バイトのブロックのリング（nvm_trace_codec.h の差分圧縮）。
+ * 追記中のブロックのヘッダは FRAM 上のブロックには閉じるときまで書かず、open_* に持つ。 */
 typedef struct __attribute__((packed)) {
     uint32_t magic;
     uint32_t version;
     uint32_t length;
     uint32_t crc;
-    uint32_t record_size;
-    uint32_t record_capacity;
-    uint32_t write_index;
-    uint32_t total_records;
+    uint32_t record_size;   // 復号後の nvm_trace_log_record_t の長さ
+    uint32_t block_size;
+    uint32_t block_count;
+    uint32_t write_block;   // 追記中のブロック
+    uint32_t total_records; // format 後に追記した総レコード数
+    uint32_t total_blocks;  // format 後に開いたブロック数（block_count を超えた分は古い順に上書き済み）
+    uint16_t open_records;  // 追記中ブロックのレコード数
+    uint16_t open_used;     // 追記中ブロックの使用バイト数（ブロックヘッダ込み）
+    uint32_t open_checksum; // 追記中ブロックのペイロード加算チェックサム
 } nvm_trace_log_header_t;
 
 typedef struct __attribute__((packed)) {
@@ -61,6 +68,8 @@ typedef struct __attribute__((packed)) {
     uint8_t test_id;
     uint16_t reserved_u16_0;
     uint16_t reserved_u16_1;
+    uint16_t isr_tick_max_us_x10;   // 前の記録以降の制御 tick 最大所要時間（0.1us）
+    uint16_t isr_period_max_us_x10; // 前の記録以降の制御 tick 最大起動間隔（0.1us）
 } nvm_trace_log_record_t;
 
 nvm_status_t nvm_trace_log_format(void);
@@ -70,8 +79,42 @@ nvm_status_t nvm_trace_log_append_cached(nvm_trace_log_header_t* header,
                                          const nvm_trace_log_record_t* record,
                                          uint8_t commit_header);
 nvm_status_t nvm_trace_log_commit_header(const nvm_trace_log_header_t* header);
+/* nvm_trace_log_append_cached の非同期版（F413 FRAM: 書き込みキューに積んで戻る）。
+ * record は呼び出し中に内部のブロック像へ符号化する。done はその符号化バイト列の書き込み完了で呼ぶ。
+ * ヘッダは内部の領域にコピーして書く。 */
+nvm_status_t nvm_trace_log_append_cached_async(nvm_trace_log_header_t* header,
+                                               const nvm_trace_log_record_t* record,
+                                               uint8_t commit_header,
+                                               nvm_write_done_fn done,
+                                               void* ctx);
 nvm_status_t nvm_trace_log_read_latest(uint32_t newest_index_from_tail,
                                        nvm_trace_log_record_t* out);
+/* 上書きされていないブロックに残っているレコード数と、それらが占めるバイト数
+ * （ブロックヘッダをたどるだけで中身のチェックサムは見ない） */
+nvm_status_t nvm_trace_log_get_stored(const nvm_trace_log_header_t* header,
+                                      uint32_t* out_records,
+                                      uint32_t* out_bytes);
+/* 新しい方から block_from_tail 番目のブロック像（ブロックヘッダ + 符号化レコード）を読み出す。
+ * 追記中のブロックもヘッダを補って返す。out_size は block_size 以上にすること。 */
+nvm_status_t nvm_trace_log_read_block(const nvm_trace_log_header_t* header,
+                                      uint32_t block_from_tail,
+                                      uint8_t* out,
+                                      uint32_t out_size,
+                                      uint32_t* out_len,
+                                      uint32_t* out_records);
+
+/* ダンプ用の範囲読み出し。保存済みの新しい方 count 件（0 は全件）を古い順に返す。
+ * 連続するブロックをまとめて 1 回の nvm_read で読み（リングの末尾で分ける）、ブロック内は順に復号するので、
+ * read_latest を件数分呼ぶよりヘッダの読み直しとキーフレームからの復号がない。
+ * 開いた時点のヘッダで読むので、読み出し中に追記しないこと。 */
+nvm_status_t nvm_trace_log_stream_open(uint32_t count, uint32_t* out_count);
+/* 次のレコード。読み終えたら NOT_FOUND。
+ * 壊れたブロックは INTEGRITY_ERROR を 1 回返してその分を飛ばす（続けて呼べば次のブロックから読める）。 */
+nvm_status_t nvm_trace_log_stream_next(nvm_trace_log_record_t* out);
+/* 次のブロック像（ブロックヘッダ + 符号化レコード）をそのまま返す（バイナリダンプ用。next と混ぜない）。
+ * 最初のブロックは count より古いレコードを含むことがある。像は次の呼び出しまで有効。 */
+nvm_status_t nvm_trace_log_stream_next_block(const uint8_t** out_image, uint32_t* out_len, uint32_t* out_records);
+void nvm_trace_log_stream_close(void);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,114 @@
+#include "nvm_write_queue.h"
+
+#include <stddef.h>
+#include <string.h>
+
+void nvm_write_queue_init(nvm_write_queue_t* q, uint32_t chunk_max) {
+    memset(q, 0, sizeof(*q));
+    q->chunk_max = (chunk_max > 0U) ? chunk_max : 1U;
+    q->next_seq = 1U;
+    q->done_seq = 0U;
+    q->error = NVM_STATUS_OK;
+}
+
+bool nvm_write_queue_push(nvm_write_queue_t* q, uint32_t address, const void* data, uint32_t len,
+                          nvm_write_done_fn done, void* ctx, uint32_t* out_seq) {
+    nvm_write_req_t* r;
+
+    if (q->count >= NVM_WRITE_QUEUE_DEPTH) {
+        return false;
+    }
+    r = &q->req[(q->head + q->count) % NVM_WRITE_QUEUE_DEPTH];
+    r->address = address;
+    r->data = (const uint8_t*)data;
+    r->len = len;
+    r->sent = 0U;
+    r->seq = q->next_seq++;
+    r->done = done;
+    r->ctx = ctx;
+    q->count++;
+    if (out_seq != NULL) {
+        *out_seq = r->seq;
+    }
+    return true;
+}
+
+// 先頭の要求を完了させて取り除く（長さ 0 の要求もここで完了する）
+static void nvm_write_queue_retire(nvm_write_queue_t* q, nvm_status_t status) {
+    nvm_write_req_t r = q->req[q->head];
+
+    q->head = (uint8_t)((q->head + 1U) % NVM_WRITE_QUEUE_DEPTH);
+    q->count--;
+    q->done_seq = r.seq;
+    if (status != NVM_STATUS_OK) {
+        if (q->error == NVM_STATUS_OK) {
+            q->error = status;
+        }
+        q->error_count++;
+    }
+    if (r.done != NULL) {
+        r.done(status, r.ctx);
+    }
+}
+
+bool nvm_write_queue_next_chunk(nvm_write_queue_t* q, uint32_t* address, const uint8_t** data,
+                                uint32_t* len) {
+    const nvm_write_req_t* r;
+    uint32_t remain;
+
+    if (q->chunk_inflight) {
+        return false;
+    }
+    while ((q->count > 0U) && (q->req[q->head].sent >= q->req[q->head].len)) {
+        nvm_write_queue_retire(q, NVM_STATUS_OK);
+    }
+    if (q->count == 0U) {
+        return false;
+    }
+
+    r = &q->req[q->head];
+    remain = r->len - r->sent;
+    q->chunk_len = (remain < q->chunk_max) ? remain : q->chunk_max;
+    q->chunk_inflight = true;
+    *address = r->address + r->sent;
+    *data = r->data + r->sent;
+    *len = q->chunk_len;
+    return true;
+}
+
+void nvm_write_queue_chunk_done(nvm_write_queue_t* q, nvm_status_t status) {
+    nvm_write_req_t* r;
+
+    if (!q->chunk_inflight || (q->count == 0U)) {
+        return;
+    }
+    q->chunk_inflight = false;
+    r = &q->req[q->head];
+    if (status != NVM_STATUS_OK) {
+        nvm_write_queue_retire(q, status);
+        return;
+    }
+    r->sent += q->chunk_len;
+    if (r->sent >= r->len) {
+        nvm_write_queue_retire(q, NVM_STATUS_OK);
+    }
+}
+
+bool nvm_write_queue_idle(const nvm_write_queue_t* q) {
+    return (q->count == 0U) && !q->chunk_inflight;
+}
+
+bool nvm_write_queue_full(const nvm_write_queue_t* q) {
+    return q->count >= NVM_WRITE_QUEUE_DEPTH;
+}
+
+bool nvm_write_queue_reached(const nvm_write_queue_t* q, uint32_t seq) {
+    // 通し番号の周回を考慮して差で比較する
+    return (int32_t)(q->done_seq - seq) >= 0;
+}
+
+nvm_status_t nvm_write_queue_take_error(nvm_write_queue_t* q) {
+    nvm_status_t st = q->error;
+    q->error = NVM_STATUS_OK;
+    return st;
+}
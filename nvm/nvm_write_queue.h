@@ -0,0 +1,69 @@
+#ifndef NIGHTFALL_NVM_WRITE_QUEUE_H_
+#define NIGHTFALL_NVM_WRITE_QUEUE_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "nvm.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * FRAM 書き込み要求のキュー（HAL 非依存。nvm.c の F413 FRAM backend と tests のホスト試験から利用）
+ *
+ * 要求は投入順に処理し、1 要求を chunk_max バイト以下の chunk に分けて取り出す。
+ * nvm.c は IMU 読取の合間に 1 chunk ずつ DMA で送出し、完了を nvm_write_queue_chunk_done() で返す。
+ * 要求の data は完了コールバックが呼ばれるまで呼び出し側が保持すること（コピーしない）。
+ * chunk が失敗した要求は残りを送らずに失敗として完了させ、後続の要求は続行する。
+ */
+
+#ifndef NVM_WRITE_QUEUE_DEPTH
+#define NVM_WRITE_QUEUE_DEPTH 16U // 同時に保持できる要求数
+#endif
+
+typedef struct {
+    uint32_t address;    // 書き込み先（FRAM 絶対アドレス）
+    const uint8_t* data;
+    uint32_t len;
+    uint32_t sent;       // 完了済みバイト数
+    uint32_t seq;        // 投入順の通し番号
+    nvm_write_done_fn done;
+    void* ctx;
+} nvm_write_req_t;
+
+typedef struct {
+    nvm_write_req_t req[NVM_WRITE_QUEUE_DEPTH];
+    uint8_t head;            // 処理中（先頭）の要求
+    uint8_t count;
+    bool chunk_inflight;
+    uint32_t chunk_len;      // 送出中の chunk 長
+    uint32_t chunk_max;
+    uint32_t next_seq;       // 次に割り当てる通し番号
+    uint32_t done_seq;       // 最後に完了した要求の通し番号
+    nvm_status_t error;      // nvm_write_queue_take_error() までに起きた最初の失敗
+    uint32_t error_count;
+} nvm_write_queue_t;
+
+void nvm_write_queue_init(nvm_write_queue_t* q, uint32_t chunk_max);
+// 要求を末尾に積む（満杯なら false）。out_seq には完了判定用の通し番号を返す。
+bool nvm_write_queue_push(nvm_write_queue_t* q, uint32_t address, const void* data, uint32_t len,
+                          nvm_write_done_fn done, void* ctx, uint32_t* out_seq);
+// 次に送る chunk を取り出して送出中にする（送出中・空なら false）
+bool nvm_write_queue_next_chunk(nvm_write_queue_t* q, uint32_t* address, const uint8_t** data,
+                                uint32_t* len);
+// 送出中の chunk の結果を反映する。要求が終わればその完了コールバックを呼ぶ。
+void nvm_write_queue_chunk_done(nvm_write_queue_t* q, nvm_status_t status);
+bool nvm_write_queue_idle(const nvm_write_queue_t* q);
+bool nvm_write_queue_full(const nvm_write_queue_t* q);
+// 通し番号 seq の要求（とそれ以前の全要求）が完了したか
+bool nvm_write_queue_reached(const nvm_write_queue_t* q, uint32_t seq);
+// 記録された最初の失敗を返して消去する（失敗がなければ NVM_STATUS_OK）
+nvm_status_t nvm_write_queue_take_error(nvm_write_queue_t* q);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -47,8 +47,9 @@
 #endif
 
 // ゴール後の探索で、何区画分の新規壁情報が判明したら次の180deg停止で保存するか
+// （迷路はジャーナルへの差分追記なので保存は数 ms。セクタ消去は埋まったときだけ）
 #ifndef SEARCH_POST_GOAL_SAVE_NEW_CELL_THRESHOLD
-#define SEARCH_POST_GOAL_SAVE_NEW_CELL_THRESHOLD 256u
+#define SEARCH_POST_GOAL_SAVE_NEW_CELL_THRESHOLD 32u
 #endif
 
 #define ALPHA_ROTATE_90   3000  // 超信地旋回の角加速度[deg/sec^2]
@@ -2,7 +2,7 @@
 #include "solver_params.h"
 
 // ========================= Mode 2 =========================
-const ShortestRunModeParams_t shortestRunModeParams2 = {
+SHORTEST_RUN_PARAMS_CONST ShortestRunModeParams_t shortestRunModeParams2 = {
     // 90deg
     .velocity_turn90 = 700.0f,
     .alpha_turn90 = 7500.0f,
@@ -66,7 +66,7 @@ const ShortestRunModeParams_t shortestRunModeParams2 = {
     .accel_switch_velocity = 2000.0f
 };
 
-const ShortestRunCaseParams_t shortestRunCaseParamsMode2[9] = {
+SHORTEST_RUN_PARAMS_CONST ShortestRunCaseParams_t shortestRunCaseParamsMode2[9] = {
     // case1 (index 0): independent (initially same as former case3)
     {
         .acceleration_straight = 3555.6f, .acceleration_straight_dash = 8000.0f,
@@ -132,7 +132,7 @@ const ShortestRunCaseParams_t shortestRunCaseParamsMode2[9] = {
 };
 
 // ========================= Mode 3 =========================
-const ShortestRunModeParams_t shortestRunModeParams3 = {
+SHORTEST_RUN_PARAMS_CONST ShortestRunModeParams_t shortestRunModeParams3 = {
     // 90deg
     .velocity_turn90    = 1200.0f,
     .alpha_turn90       = 29000.0f,
@@ -196,7 +196,7 @@ const ShortestRunModeParams_t shortestRunModeParams3 = {
     .accel_switch_velocity = 2000.0f
 };
 
-const ShortestRunCaseParams_t shortestRunCaseParamsMode3[9] = {
+SHORTEST_RUN_PARAMS_CONST ShortestRunCaseParams_t shortestRunCaseParamsMode3[9] = {
     // case1 (index 0): independent (initially same as former case3)
     {
         .acceleration_straight = 20000.0f, .acceleration_straight_dash = 12000.0f,
@@ -262,7 +262,7 @@ const ShortestRunCaseParams_t shortestRunCaseParamsMode3[9] = {
 };
 
 // ========================= Mode 4 =========================
-const ShortestRunModeParams_t shortestRunModeParams4 = {
+SHORTEST_RUN_PARAMS_CONST ShortestRunModeParams_t shortestRunModeParams4 = {
     // 90deg
     .velocity_turn90    = 1400.0f,
     .alpha_turn90       = 37000.0f,
@@ -325,7 +325,7 @@ const ShortestRunModeParams_t shortestRunModeParams4 = {
     .accel_switch_velocity = 1500.0f
 };
 
-const ShortestRunCaseParams_t shortestRunCaseParamsMode4[9] = {
+SHORTEST_RUN_PARAMS_CONST ShortestRunCaseParams_t shortestRunCaseParamsMode4[9] = {
     // case1 (index 0)
     {
         .acceleration_straight = 35000.0f, .acceleration_straight_dash = 20000.0f,
@@ -391,7 +391,7 @@ const ShortestRunCaseParams_t shortestRunCaseParamsMode4[9] = {
 };
 
 // ========================= Mode 5 =========================
-const ShortestRunModeParams_t shortestRunModeParams5 = {
+SHORTEST_RUN_PARAMS_CONST ShortestRunModeParams_t shortestRunModeParams5 = {
     // 90deg
     .velocity_turn90    = 1600.0f,
     .alpha_turn90       = 50000.0f,
@@ -424,7 +424,7 @@ const ShortestRunModeParams_t shortestRunModeParams5 = {
     .accel_switch_velocity = 3000.0f
 };
 
-const ShortestRunCaseParams_t shortestRunCaseParamsMode5[9] = {
+SHORTEST_RUN_PARAMS_CONST ShortestRunCaseParams_t shortestRunCaseParamsMode5[9] = {
     // case1 (index 0)
     {
         .acceleration_straight = 35000.0f, .acceleration_straight_dash = 20000.0f,
@@ -490,7 +490,7 @@ const ShortestRunCaseParams_t shortestRunCaseParamsMode5[9] = {
 };
 
 // ========================= Mode 6 =========================
-const ShortestRunModeParams_t shortestRunModeParams6 = {
+SHORTEST_RUN_PARAMS_CONST ShortestRunModeParams_t shortestRunModeParams6 = {
     // 90deg
     .velocity_turn90    = 1800.0f,
     .alpha_turn90       = 63000.0f,
@@ -523,7 +523,7 @@ const ShortestRunModeParams_t shortestRunModeParams6 = {
     .accel_switch_velocity = 4500.0f
 };
 
-const ShortestRunCaseParams_t shortestRunCaseParamsMode6[9] = {
+SHORTEST_RUN_PARAMS_CONST ShortestRunCaseParams_t shortestRunCaseParamsMode6[9] = {
     // case1 (index 0) - mode5と同じ値
     {
         .acceleration_straight = 40000.0f, .acceleration_straight_dash = 25000.0f,
@@ -589,7 +589,7 @@ const ShortestRunCaseParams_t shortestRunCaseParamsMode6[9] = {
 };
 
 // ========================= Mode 7 =========================
-const ShortestRunModeParams_t shortestRunModeParams7 = {
+SHORTEST_RUN_PARAMS_CONST ShortestRunModeParams_t shortestRunModeParams7 = {
     // 90deg
     .velocity_turn90    = 2000.0f,
     .alpha_turn90       = 85000.0f,
@@ -622,7 +622,7 @@ const ShortestRunModeParams_t shortestRunModeParams7 = {
     .accel_switch_velocity = 4500.0f
 };
 
-const ShortestRunCaseParams_t shortestRunCaseParamsMode7[9] = {
+SHORTEST_RUN_PARAMS_CONST ShortestRunCaseParams_t shortestRunCaseParamsMode7[9] = {
     {
         .acceleration_straight = 40000.0f, .acceleration_straight_dash = 25000.0f,
         .velocity_straight = 5000.0f, .kp_wall = 1.0f,
@@ -333,7 +333,9 @@
 ------------------------------------------------------------*/
 #define GOAL_X   1
 #define GOAL_Y   0
-#define MAZE_SIZE 16
+#ifndef MAZE_SIZE
+#define MAZE_SIZE 16 // 32x32 はビルド時に -DMAZE_SIZE=32（NIGHTFALL_F413_MAZE_SIZE）
+#endif
 #define START_X   0
 #define START_Y   0
 
@@ -2,7 +2,7 @@
 #include "solver_params.h"
 
 // ========================= Mode 2 =========================
-const ShortestRunModeParams_t shortestRunModeParams2 = {
+SHORTEST_RUN_PARAMS_CONST ShortestRunModeParams_t shortestRunModeParams2 = {
     // 90deg
     .velocity_turn90 = 300.0f,
     .alpha_turn90 = 8920.0f,
@@ -66,7 +66,7 @@ const ShortestRunModeParams_t shortestRunModeParams2 = {
     .accel_switch_velocity = 2000.0f
 };
 
-const ShortestRunCaseParams_t shortestRunCaseParamsMode2[9] = {
+SHORTEST_RUN_PARAMS_CONST ShortestRunCaseParams_t shortestRunCaseParamsMode2[9] = {
     // case1 (index 0): independent (initially same as former case3)
     {
         .acceleration_straight = 2000.0f, .acceleration_straight_dash = 2000.0f,
@@ -132,7 +132,7 @@ const ShortestRunCaseParams_t shortestRunCaseParamsMode2[9] = {
 };
 
 // ========================= Mode 3 =========================
-const ShortestRunModeParams_t shortestRunModeParams3 = {
+SHORTEST_RUN_PARAMS_CONST ShortestRunModeParams_t shortestRunModeParams3 = {
     // 90deg
     .velocity_turn90 = 600.0f,
     .alpha_turn90 = 36000.0f,
@@ -196,7 +196,7 @@ const ShortestRunModeParams_t shortestRunModeParams3 = {
     .accel_switch_velocity = 1500.0f
 };
 
-const ShortestRunCaseParams_t shortestRunCaseParamsMode3[9] = {
+SHORTEST_RUN_PARAMS_CONST ShortestRunCaseParams_t shortestRunCaseParamsMode3[9] = {
     // case1 (index 0): independent (initially same as former case3)
     {
         .acceleration_straight = 4000.0f, .acceleration_straight_dash = 4000.0f,
@@ -262,7 +262,7 @@ const ShortestRunCaseParams_t shortestRunCaseParamsMode3[9] = {
 };
 
 // ========================= Mode 4 =========================
-const ShortestRunModeParams_t shortestRunModeParams4 = {
+SHORTEST_RUN_PARAMS_CONST ShortestRunModeParams_t shortestRunModeParams4 = {
     // 90deg
     .velocity_turn90 = 800.0f,
     .alpha_turn90 = 51500.0f,
@@ -325,7 +325,7 @@ const ShortestRunModeParams_t shortestRunModeParams4 = {
     .accel_switch_velocity = 1500.0f
 };
 
-const ShortestRunCaseParams_t shortestRunCaseParamsMode4[9] = {
+SHORTEST_RUN_PARAMS_CONST ShortestRunCaseParams_t shortestRunCaseParamsMode4[9] = {
     // case1 (index 0)
     {
         .acceleration_straight = 6000.0f, .acceleration_straight_dash = 3000.0f,
@@ -391,7 +391,7 @@ const ShortestRunCaseParams_t shortestRunCaseParamsMode4[9] = {
 };
 
 // ========================= Mode 5 =========================
-const ShortestRunModeParams_t shortestRunModeParams5 = {
+SHORTEST_RUN_PARAMS_CONST ShortestRunModeParams_t shortestRunModeParams5 = {
     // 90deg
     .velocity_turn90 = 800.0f,
     .alpha_turn90 = 51500.0f,
@@ -424,7 +424,7 @@ const ShortestRunModeParams_t shortestRunModeParams5 = {
     .accel_switch_velocity = 1200.0f
 };
 
-const ShortestRunCaseParams_t shortestRunCaseParamsMode5[9] = {
+SHORTEST_RUN_PARAMS_CONST ShortestRunCaseParams_t shortestRunCaseParamsMode5[9] = {
     // case1 (index 0)
     {
         .acceleration_straight = 8000.0f, .acceleration_straight_dash = 5000.0f,
@@ -490,7 +490,7 @@ const ShortestRunCaseParams_t shortestRunCaseParamsMode5[9] = {
 };
 
 // ========================= Mode 6 =========================
-const ShortestRunModeParams_t shortestRunModeParams6 = {
+SHORTEST_RUN_PARAMS_CONST ShortestRunModeParams_t shortestRunModeParams6 = {
     // 90deg
     .velocity_turn90 = 1000.0f,
     .alpha_turn90 = 74000.0f,
@@ -523,7 +523,7 @@ const ShortestRunModeParams_t shortestRunModeParams6 = {
     .accel_switch_velocity = 1500.0f
 };
 
-const ShortestRunCaseParams_t shortestRunCaseParamsMode6[9] = {
+SHORTEST_RUN_PARAMS_CONST ShortestRunCaseParams_t shortestRunCaseParamsMode6[9] = {
     // case1 (index 0) - mode5と同じ値
     {
         .acceleration_straight = 11111.11f, .acceleration_straight_dash = 8000.0f,
@@ -589,7 +589,7 @@ const ShortestRunCaseParams_t shortestRunCaseParamsMode6[9] = {
 };
 
 // ========================= Mode 7 =========================
-const ShortestRunModeParams_t shortestRunModeParams7 = {
+SHORTEST_RUN_PARAMS_CONST ShortestRunModeParams_t shortestRunModeParams7 = {
     .velocity_turn90    = 1400.0f,
     .alpha_turn90       = 50000.0f,
     .acceleration_turn  = 0.0f,
@@ -619,7 +619,7 @@ const ShortestRunModeParams_t shortestRunModeParams7 = {
     .accel_switch_velocity = 2000.0f
 };
 
-const ShortestRunCaseParams_t shortestRunCaseParamsMode7[9] = {
+SHORTEST_RUN_PARAMS_CONST ShortestRunCaseParams_t shortestRunCaseParamsMode7[9] = {
     {
         .acceleration_straight = 14222.2f, .acceleration_straight_dash = 25000.0f,
         .velocity_straight = 2300.0f, .kp_wall = 0.065f,
@@ -0,0 +1,109 @@
+#include "spi_bus_sched.h"
+
+#include <string.h>
+
+void spi_bus_sched_init(spi_bus_sched_t* s, uint32_t period_us, uint32_t guard_us) {
+    memset(s, 0, sizeof(*s));
+    s->owner = (uint8_t)SPI_BUS_OWNER_NONE;
+    s->period_us = period_us;
+    s->guard_us = guard_us;
+}
+
+void spi_bus_sched_set_imu_scheduled(spi_bus_sched_t* s, bool scheduled) {
+    s->imu_scheduled = scheduled;
+    // 最初のスロットまでは FRAM を入れない（開始直後の tick を FRAM が塞がないように）
+    s->imu_slot_done = false;
+}
+
+bool spi_bus_sched_imu_begin(spi_bus_sched_t* s) {
+    s->period_seq++;
+    s->imu_slot_done = false;
+    s->stats.imu_slots++;
+    if (s->owner == (uint8_t)SPI_BUS_OWNER_FRAM) {
+        s->stats.imu_skipped++;
+        return false;
+    }
+    if (s->owner != (uint8_t)SPI_BUS_OWNER_NONE) {
+        s->stats.imu_late++;
+        return false;
+    }
+    s->owner = (uint8_t)SPI_BUS_OWNER_IMU;
+    return true;
+}
+
+void spi_bus_sched_imu_end(spi_bus_sched_t* s, bool ok) {
+    if (s->owner != (uint8_t)SPI_BUS_OWNER_IMU) {
+        return;
+    }
+    if (!ok) {
+        s->stats.imu_errors++;
+    }
+    s->owner = (uint8_t)SPI_BUS_OWNER_NONE;
+    s->imu_slot_done = true;
+}
+
+uint32_t spi_bus_sched_fram_window_us(const spi_bus_sched_t* s, uint32_t now_us) {
+    uint32_t end_us;
+
+    if (!s->imu_scheduled) {
+        return UINT32_MAX;
+    }
+    if (!s->imu_slot_done || (s->guard_us >= s->period_us)) {
+        return 0U;
+    }
+    end_us = s->period_us - s->guard_us;
+    return (now_us < end_us) ? (end_us - now_us) : 0U;
+}
+
+bool spi_bus_sched_fram_begin(spi_bus_sched_t* s, uint32_t now_us, uint32_t cost_us) {
+    if (s->owner != (uint8_t)SPI_BUS_OWNER_NONE) {
+        return false;
+    }
+    if (cost_us > spi_bus_sched_fram_window_us(s, now_us)) {
+        s->stats.fram_deferred++;
+        return false;
+    }
+    s->owner = (uint8_t)SPI_BUS_OWNER_FRAM;
+    s->fram_start_us = now_us;
+    s->fram_start_seq = s->period_seq;
+    s->stats.fram_grants++;
+    return true;
+}
+
+void spi_bus_sched_fram_end(spi_bus_sched_t* s, uint32_t now_us) {
+    uint32_t periods;
+    uint32_t hold_us;
+
+    if (s->owner != (uint8_t)SPI_BUS_OWNER_FRAM) {
+        return;
+    }
+    s->owner = (uint8_t)SPI_BUS_OWNER_NONE;
+    periods = s->period_seq - s->fram_start_seq;
+    if (s->imu_scheduled && (periods != 0U)) {
+        s->stats.fram_overruns++;
+    }
+    hold_us = periods * s->period_us + now_us - s->fram_start_us;
+    if (hold_us > s->stats.fram_max_hold_us) {
+        s->stats.fram_max_hold_us = hold_us;
+    }
+}
+
+bool spi_bus_sched_try_claim(spi_bus_sched_t* s, spi_bus_owner_t owner) {
+    if ((s->owner != (uint8_t)SPI_BUS_OWNER_NONE) || (owner == SPI_BUS_OWNER_NONE)) {
+        return false;
+    }
+    s->owner = (uint8_t)owner;
+    return true;
+}
+
+void spi_bus_sched_release(spi_bus_sched_t* s) {
+    s->owner = (uint8_t)SPI_BUS_OWNER_NONE;
+}
+
+uint32_t spi_bus_sched_imu_dropped(const spi_bus_sched_stats_t* st) {
+    return st->imu_skipped + st->imu_late + st->imu_errors;
+}
+
+void spi_bus_sched_reset_stats(spi_bus_sched_t* s) {
+    memset(&s->stats, 0, sizeof(s->stats));
+}
@@ -0,0 +1,81 @@
+#ifndef NIGHTFALL_SPI_BUS_SCHED_H_
+#define NIGHTFALL_SPI_BUS_SCHED_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * IMU と FRAM が共有する SPI バスの時間割（HAL 非依存。F413 の f413_control.c / nvm.c と
+ * tests のホスト試験から利用）
+ *
+ * 制御周期（period_us）の先頭は IMU のスロットで、制御 tick が毎周期バスを取る。
+ * FRAM の転送は、その周期の IMU 転送が終わった後、所要時間（cost_us）が次の IMU スロットの
+ * guard_us 手前までに収まるときだけ許可する。収まらない転送は次の周期の窓へ回す。
+ * IMU を周期的に読んでいない間（停止中）は時間の制約なしに空いていれば許可する。
+ *
+ * 時刻 now_us は周期の先頭（制御 tick の起動）からの経過時間。
+ * 関数はいずれも割り込み禁止中、または IMU スロットを進める割り込みと同じ優先度から呼ぶこと。
+ */
+
+typedef enum {
+    SPI_BUS_OWNER_NONE = 0,
+    SPI_BUS_OWNER_IMU,
+    SPI_BUS_OWNER_FRAM,
+} spi_bus_owner_t;
+
+typedef struct {
+    uint32_t imu_slots;        // IMU スロット（制御 tick）の数
+    uint32_t imu_skipped;      // FRAM がバスを持っていて IMU を読めなかったスロット
+    uint32_t imu_late;         // 前周期の IMU 転送が終わっておらず新しく読めなかったスロット
+    uint32_t imu_errors;       // 転送エラー・打ち切り
+    uint32_t fram_grants;      // 許可した FRAM 転送
+    uint32_t fram_deferred;    // 窓に収まらず断った要求
+    uint32_t fram_overruns;    // 次の IMU スロットを越えて解放された FRAM 転送
+    uint32_t fram_max_hold_us; // FRAM 転送の最長占有時間
+} spi_bus_sched_stats_t;
+
+typedef struct {
+    volatile uint8_t owner;    // spi_bus_owner_t
+    bool imu_scheduled;        // 毎周期 IMU スロットがある（走行中）
+    bool imu_slot_done;        // 今周期の IMU 転送が終わった（FRAM はこの後だけ）
+    uint32_t period_us;
+    uint32_t guard_us;         // 次の IMU スロットの前に空けておく余裕
+    uint32_t period_seq;       // IMU スロットの通し番号
+    uint32_t fram_start_us;
+    uint32_t fram_start_seq;
+    spi_bus_sched_stats_t stats;
+} spi_bus_sched_t;
+
+void spi_bus_sched_init(spi_bus_sched_t* s, uint32_t period_us, uint32_t guard_us);
+// 制御 tick が毎周期 IMU を読むかどうか（走行の開始・終了で切り替える）
+void spi_bus_sched_set_imu_scheduled(spi_bus_sched_t* s, bool scheduled);
+
+// 周期の先頭（制御 tick）で呼ぶ。バスを IMU に渡せれば true（転送後に imu_end を呼ぶ）。
+// FRAM が持っていれば skipped、前周期の IMU 転送が続いていれば late として数えて false。
+bool spi_bus_sched_imu_begin(spi_bus_sched_t* s);
+void spi_bus_sched_imu_end(spi_bus_sched_t* s, bool ok);
+
+// 周期内の now_us から始める FRAM 転送に使える残り時間（停止中は UINT32_MAX、使えなければ 0）
+uint32_t spi_bus_sched_fram_window_us(const spi_bus_sched_t* s, uint32_t now_us);
+// cost_us の FRAM 転送を now_us から始めてよければバスを渡して true
+bool spi_bus_sched_fram_begin(spi_bus_sched_t* s, uint32_t now_us, uint32_t cost_us);
+// now_us は解放時の周期内時刻（begin と同じ時計）
+void spi_bus_sched_fram_end(spi_bus_sched_t* s, uint32_t now_us);
+
+// 周期と無関係にバスを占有する（初期化時の IMU 設定など、スロットが動いていない間だけ使う）
+bool spi_bus_sched_try_claim(spi_bus_sched_t* s, spi_bus_owner_t owner);
+void spi_bus_sched_release(spi_bus_sched_t* s);
+
+// 新しい IMU サンプルを得られなかったスロットの数（skipped + late + errors）
+uint32_t spi_bus_sched_imu_dropped(const spi_bus_sched_stats_t* st);
+void spi_bus_sched_reset_stats(spi_bus_sched_t* s);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,27 @@
+#include "ism330_burst.h"
+
+#include <string.h>
+
+void ism330_burst_tx_frame(uint8_t tx[ISM330_BURST_XFER_LEN]) {
+    memset(tx, 0, ISM330_BURST_XFER_LEN);
+    tx[0] = (uint8_t)(ISM330_REG_OUTX_L_G | 0x80U); // 読み出し
+}
+
+static int16_t ism330_burst_le16(const uint8_t* p) {
+    return (int16_t)((uint16_t)p[1] << 8U | (uint16_t)p[0]);
+}
+
+void ism330_burst_decode(const uint8_t rx[ISM330_BURST_XFER_LEN], ism330_raw_t* raw) {
+    const uint8_t* d = &rx[1];
+    for (uint32_t i = 0U; i < 3U; i++) {
+        raw->gyro[i] = ism330_burst_le16(&d[2U * i]);        // 0x22..0x27
+        raw->accel[i] = ism330_burst_le16(&d[6U + 2U * i]);  // 0x28..0x2D
+    }
+}
+
+void ism330_burst_to_sample(const ism330_raw_t* raw, ism330_sample_t* out) {
+    for (uint32_t i = 0U; i < 3U; i++) {
+        out->gyro_dps[i] = (float)raw->gyro[i] * ISM330_GYRO_DPS_PER_LSB;
+        out->accel_g[i] = (float)raw->accel[i] * ISM330_ACCEL_G_PER_LSB;
+    }
+}
@@ -0,0 +1,41 @@
+#ifndef NIGHTFALL_ISM330_BURST_H_
+#define NIGHTFALL_ISM330_BURST_H_
+
+#include <stdint.h>
+
+/*
+ * ISM330DHCX の 6 軸出力を 1 回の SPI バーストで読むためのフレーム組立と復号。
+ * OUTX_L_G(0x22) から OUTZ_H_A(0x2D) までの 12 バイトは連続しており、
+ * CTRL3_C の IF_INC=1 で自動インクリメント、BDU=1 で読取中の上位/下位の取り違えが起きない。
+ * 転送はアドレス 1 バイト + データ 12 バイト = 13 バイト（rx[0] はアドレス送出中のダミー）。
+ * HAL に依存しないためホストでもレジスタダンプから復号を確認できる。
+ */
+
+#define ISM330_REG_OUTX_L_G      (0x22U)
+#define ISM330_BURST_DATA_LEN    (12U)
+#define ISM330_BURST_XFER_LEN    (ISM330_BURST_DATA_LEN + 1U)
+
+/* CTRL2_G=0x71 (FS=4000dps), CTRL1_XL=0x7C (FS=±16g) 設定時の感度 */
+#define ISM330_GYRO_DPS_PER_LSB  (0.14f)      /* 140 mdps/LSB */
+#define ISM330_ACCEL_G_PER_LSB   (0.000488f)  /* 0.488 mg/LSB */
+
+typedef struct {
+    int16_t gyro[3];  /* X, Y, Z [LSB] */
+    int16_t accel[3]; /* X, Y, Z [LSB] */
+} ism330_raw_t;
+
+typedef struct {
+    float gyro_dps[3]; /* X, Y, Z [deg/s] */
+    float accel_g[3];  /* X, Y, Z [g] */
+} ism330_sample_t;
+
+/* 送信フレームを作る（先頭=読み出しアドレス、残りはダミー 0x00）。 */
+void ism330_burst_tx_frame(uint8_t tx[ISM330_BURST_XFER_LEN]);
+
+/* 受信フレーム（rx[0] はダミー）を生値へ復号する。 */
+void ism330_burst_decode(const uint8_t rx[ISM330_BURST_XFER_LEN], ism330_raw_t* raw);
+
+/* 生値を物理量へ換算する（軸の符号・取付向きの補正は呼び出し側で行う）。 */
+void ism330_burst_to_sample(const ism330_raw_t* raw, ism330_sample_t* out);
+
+#endif
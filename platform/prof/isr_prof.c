@@ -0,0 +1,201 @@
+#include "isr_prof.h"
+
+#include <stdatomic.h>
+#include <stddef.h>
+#include <string.h>
+
+/* 単一コア上の割り込みとの受け渡しなので、コンパイラの並べ替えだけ防げばよい */
+#define ISR_PROF_FENCE() atomic_signal_fence(memory_order_seq_cst)
+
+static isr_prof_stat_t s_stat[ISR_PROF_SECTION_COUNT];
+static uint32_t s_budget_cycles[ISR_PROF_SECTION_COUNT];
+static uint32_t s_period_last[ISR_PROF_SECTION_COUNT];
+static uint8_t s_period_valid[ISR_PROF_SECTION_COUNT];
+static volatile uint8_t s_reset_req[ISR_PROF_SECTION_COUNT];
+static isr_prof_counter_fn s_counter = NULL;
+static uint32_t s_cycles_per_us = 1U;
+
+static const char* const s_section_name[ISR_PROF_SECTION_COUNT] = {
+    "ctrl_tick",
+    "ctrl_period",
+    "imu",
+    "encoder",
+    "pid",
+    "trace_sample",
+    "wall_sched",
+    "wall_update",
+};
+
+static void isr_prof_clear(isr_prof_stat_t* st) {
+    uint32_t gen = st->gen;
+
+    memset(st, 0, sizeof(*st));
+    st->gen = gen;
+    st->min_cycles = UINT32_MAX;
+}
+
+void isr_prof_init(isr_prof_counter_fn counter, uint32_t cycles_per_us) {
+    s_counter = NULL;
+    ISR_PROF_FENCE();
+    for (uint32_t i = 0U; i < (uint32_t)ISR_PROF_SECTION_COUNT; i++) {
+        isr_prof_clear(&s_stat[i]);
+        s_stat[i].gen = 0U;
+        s_period_valid[i] = 0U;
+        s_reset_req[i] = 0U;
+    }
+    s_cycles_per_us = (cycles_per_us > 0U) ? cycles_per_us : 1U;
+    ISR_PROF_FENCE();
+#if ISR_PROF_ENABLE
+    s_counter = counter;
+#else
+    (void)counter;
+#endif
+}
+
+void isr_prof_set_budget_us(isr_prof_section_t section, uint32_t budget_us) {
+    if ((uint32_t)section >= (uint32_t)ISR_PROF_SECTION_COUNT) {
+        return;
+    }
+    s_budget_cycles[section] = budget_us * s_cycles_per_us;
+}
+
+void isr_prof_reset(void) {
+    for (uint32_t i = 0U; i < (uint32_t)ISR_PROF_SECTION_COUNT; i++) {
+        s_reset_req[i] = 1U;
+    }
+}
+
+uint32_t isr_prof_begin(void) {
+    isr_prof_counter_fn counter = s_counter;
+    return (counter != NULL) ? counter() : 0U;
+}
+
+static uint32_t isr_prof_hist_bin(uint32_t cycles) {
+    uint32_t us = cycles / s_cycles_per_us;
+    uint32_t bin;
+
+    if (us == 0U) {
+        return 0U;
+    }
+    bin = 32U - (uint32_t)__builtin_clz(us);
+    return (bin < ISR_PROF_HIST_BINS) ? bin : (ISR_PROF_HIST_BINS - 1U);
+}
+
+void isr_prof_record(isr_prof_section_t section, uint32_t cycles) {
+    isr_prof_stat_t* st;
+
+    if ((s_counter == NULL) || ((uint32_t)section >= (uint32_t)ISR_PROF_SECTION_COUNT)) {
+        return;
+    }
+    st = &s_stat[section];
+    st->gen++;
+    ISR_PROF_FENCE();
+    if (s_reset_req[section] != 0U) {
+        s_reset_req[section] = 0U;
+        isr_prof_clear(st);
+    }
+    st->count++;
+    st->last_cycles = cycles;
+    st->sum_cycles += cycles;
+    if (cycles < st->min_cycles) {
+        st->min_cycles = cycles;
+    }
+    if (cycles > st->max_cycles) {
+        st->max_cycles = cycles;
+    }
+    if (cycles > st->window_max_cycles) {
+        st->window_max_cycles = cycles;
+    }
+    if ((s_budget_cycles[section] != 0U) && (cycles > s_budget_cycles[section])) {
+        st->over_budget++;
+    }
+    st->hist[isr_prof_hist_bin(cycles)]++;
+    ISR_PROF_FENCE();
+    st->gen++;
+}
+
+uint32_t isr_prof_end(isr_prof_section_t section, uint32_t start) {
+    isr_prof_counter_fn counter = s_counter;
+    uint32_t now;
+
+    if (counter == NULL) {
+        return 0U;
+    }
+    now = counter();
+    isr_prof_record(section, now - start);
+    return now;
+}
+
+void isr_prof_mark_period(isr_prof_section_t section) {
+    isr_prof_counter_fn counter = s_counter;
+    uint32_t now;
+
+    if ((counter == NULL) || ((uint32_t)section >= (uint32_t)ISR_PROF_SECTION_COUNT)) {
+        return;
+    }
+    now = counter();
+    if (s_period_valid[section] != 0U) {
+        isr_prof_record(section, now - s_period_last[section]);
+    }
+    s_period_last[section] = now;
+    s_period_valid[section] = 1U;
+}
+
+bool isr_prof_snapshot(isr_prof_section_t section, isr_prof_stat_t* out) {
+    const isr_prof_stat_t* st;
+    uint32_t gen;
+
+    if ((out == NULL) || (s_counter == NULL) ||
+        ((uint32_t)section >= (uint32_t)ISR_PROF_SECTION_COUNT)) {
+        return false;
+    }
+    st = &s_stat[section];
+    for (;;) {
+        gen = st->gen;
+        ISR_PROF_FENCE();
+        if ((gen & 1U) != 0U) {
+            continue;
+        }
+        memcpy(out, (const void*)st, sizeof(*out));
+        ISR_PROF_FENCE();
+        if (st->gen == gen) {
+            break;
+        }
+    }
+    if (s_reset_req[section] != 0U) {
+        /* 消去要求が未処理なら消去後の状態を返す */
+        isr_prof_clear(out);
+    }
+    return true;
+}
+
+uint32_t isr_prof_take_window_max(isr_prof_section_t section) {
+    uint32_t v;
+
+    if ((uint32_t)section >= (uint32_t)ISR_PROF_SECTION_COUNT) {
+        return 0U;
+    }
+    v = s_stat[section].window_max_cycles;
+    s_stat[section].window_max_cycles = 0U;
+    return v;
+}
+
+const char* isr_prof_section_name(isr_prof_section_t section) {
+    if ((uint32_t)section >= (uint32_t)ISR_PROF_SECTION_COUNT) {
+        return "?";
+    }
+    return s_section_name[section];
+}
+
+uint16_t isr_prof_cycles_to_us_x10(uint32_t cycles) {
+    uint64_t v = ((uint64_t)cycles * 10U) / s_cycles_per_us;
+    return (v > 0xFFFFU) ? 0xFFFFU : (uint16_t)v;
+}
+
+uint32_t isr_prof_cycles_to_us(uint32_t cycles) {
+    return cycles / s_cycles_per_us;
+}
+
+uint32_t isr_prof_hist_bin_floor_us(uint32_t bin) {
+    return (bin == 0U) ? 0U : (1UL << (bin - 1U));
+}
@@ -0,0 +1,77 @@
+#ifndef NIGHTFALL_ISR_PROF_H_
+#define NIGHTFALL_ISR_PROF_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * 割り込み処理の区間ごとの所要サイクル数の集計（min / mean / max / ヒストグラム）。
+ * - サイクル数はカウンタ関数（実機は DWT->CYCCNT、ホストは模擬カウンタ）から読む。
+ *   カウンタ未設定（isr_prof_init 前）の間は begin/end とも何もしない。
+ * - 1 区間を更新するのは 1 つの割り込み（優先度）だけとし、メインループ側の読み出しは
+ *   区間ごとの更新番号（奇数 = 更新中）で取り直して一貫したコピーを得る。
+ * - リセットは要求だけを立て、次にその区間を更新する割り込みが消去する。
+ * - ヒストグラムは log2 刻み: bin0 は 1us 未満、bin k は [2^(k-1), 2^k) us、最後の bin は上限なし。
+ * HAL に依存しないためホストでもビルドできる。
+ */
+
+#ifndef ISR_PROF_ENABLE
+#define ISR_PROF_ENABLE (1)
+#endif
+
+#define ISR_PROF_HIST_BINS (16U)
+
+typedef enum {
+    ISR_PROF_CTRL_TICK = 0, // 制御 tick 全体（TIM5、トレース採取を除く）
+    ISR_PROF_CTRL_PERIOD,   // 制御 tick の起動間隔（ジッタ）
+    ISR_PROF_IMU,           // IMU バースト受取・起動
+    ISR_PROF_ENCODER,       // エンコーダ読取・速度推定
+    ISR_PROF_PID,           // 目標生成・PID・モータ出力
+    ISR_PROF_TRACE_SAMPLE,  // トレース記録の採取（TIM5、制御 tick の直後）
+    ISR_PROF_WALL_SCHED,    // 壁センサ発光/ADC 起動（TIM6）
+    ISR_PROF_WALL_UPDATE,   // 壁センサ ADC 完了処理
+    ISR_PROF_SECTION_COUNT
+} isr_prof_section_t;
+
+typedef struct {
+    volatile uint32_t gen; // 更新番号（奇数の間は更新中）
+    uint32_t count;
+    uint32_t last_cycles;
+    uint32_t min_cycles;
+    uint32_t max_cycles;
+    uint64_t sum_cycles;
+    uint32_t window_max_cycles; // isr_prof_take_window_max() 以降の最大
+    uint32_t over_budget;       // budget を超えた回数
+    uint32_t hist[ISR_PROF_HIST_BINS];
+} isr_prof_stat_t;
+
+typedef uint32_t (*isr_prof_counter_fn)(void);
+
+/* counter: 32bit で周回するサイクルカウンタ。cycles_per_us: 1us あたりのカウント数（0 は 1 扱い） */
+void isr_prof_init(isr_prof_counter_fn counter, uint32_t cycles_per_us);
+/* 区間の予算（us）。超えた回数を over_budget に数える（0 で無効） */
+void isr_prof_set_budget_us(isr_prof_section_t section, uint32_t budget_us);
+/* 全区間の消去を要求する（各区間は次の更新時に消去される） */
+void isr_prof_reset(void);
+
+uint32_t isr_prof_begin(void);
+/* begin からの経過を記録し、今の時刻を返す（続く区間の begin として使える） */
+uint32_t isr_prof_end(isr_prof_section_t section, uint32_t start);
+/* 経過サイクル数を直接記録する */
+void isr_prof_record(isr_prof_section_t section, uint32_t cycles);
+/* 前回の mark からの間隔を記録する（初回は記録しない） */
+void isr_prof_mark_period(isr_prof_section_t section);
+
+/* 一貫したコピーを得る（更新中に読んだら取り直す）。false はカウンタ未設定 */
+bool isr_prof_snapshot(isr_prof_section_t section, isr_prof_stat_t* out);
+/* window_max を返して 0 に戻す。その区間を更新する割り込みと同じ優先度から呼ぶこと */
+uint32_t isr_prof_take_window_max(isr_prof_section_t section);
+
+const char* isr_prof_section_name(isr_prof_section_t section);
+/* サイクル数を 0.1us 単位へ換算する（uint16 に飽和） */
+uint16_t isr_prof_cycles_to_us_x10(uint32_t cycles);
+uint32_t isr_prof_cycles_to_us(uint32_t cycles);
+/* ヒストグラム bin k の下限（us） */
+uint32_t isr_prof_hist_bin_floor_us(uint32_t bin);
+
+#endif
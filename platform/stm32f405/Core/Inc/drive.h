@@ -27,6 +27,7 @@ volatile float velocity_straight;     // 直線の速度[mm/s]
 volatile float acceleration_straight; // 直線の加速度[mm/s^2]
 volatile float acceleration_straight_dash; // 直線の半区画当たりの加速量[mm/s]
 volatile float accel_switch_velocity;     // 加速度切り替え速度[mm/s]（低速/高速域切り替え）
+volatile float jerk_straight;     // 直線・斜め直線の加加速度[mm/s^3]（0 なら等加速度）
 volatile float velocity_d_straight;     // 斜め直線の速度[mm/s]
 volatile float acceleration_d_straight; // 斜め直線の加速度[mm/s^2]
 volatile float
@@ -194,6 +195,7 @@ extern volatile float acceleration_straight; // 直線の加速度[mm/s^2]
 extern volatile float
     acceleration_straight_dash; // 直線の半区画当たりの加速量[mm/s]
 extern volatile float accel_switch_velocity;     // 加速度切り替え速度[mm/s]
+extern volatile float jerk_straight;     // 直線・斜め直線の加加速度[mm/s^3]（0 なら等加速度）
 extern volatile float velocity_d_straight;     // 斜め直線の速度[mm/s]
 extern volatile float acceleration_d_straight; // 斜め直線の加速度[mm/s^2]
 extern volatile float
@@ -363,12 +365,64 @@ extern volatile uint16_t wall_end_count;
 
 #define drive_wait() HAL_Delay(200)
 
+//====走行コマンドキュー====
+// 最短走行の区間（直進・旋回）を積んでおき、1kHz 制御割り込みが順に実行する。
+// 区間の切り替えは割り込みの同じ tick 内で行う。次の区間へ持ち越すのは指令速度と目標距離だけで、
+// PID の状態（誤差・積分）と角度の目標は区間の始めに戻す（drive_queue_start()）。
+// メインループは積み込みと状態の確認だけを行う（待ちの間は background_replan_tick()）。
+#ifndef DRIVE_QUEUE_LEN
+#define DRIVE_QUEUE_LEN 16 // 2 のべき乗
+#endif
+
+typedef enum {
+    DRIVE_CMD_STRAIGHT = 0, // 加減速直進（v_in → v_out、dist_mm 進んだら終了。jerk > 0 なら S 字）
+    DRIVE_CMD_FWALL,        // ターン入口の直進（開始時に前壁が見えていれば前壁センサ値で終了）
+    DRIVE_CMD_WALLEND,      // 等速直進（壁切れ検知か dist_mm で終了）
+    DRIVE_CMD_TURN,         // スラローム旋回（角速度プロファイル、終了時に速度を v_out へ）
+} drive_cmd_type_t;
+
+// 区間中の MF.FLAG と実行条件
+#define DRIVE_CMD_CTRL 0x01u        // 壁制御（MF.FLAG.CTRL）
+#define DRIVE_CMD_CTRL_DIAG 0x02u   // 斜め制御（MF.FLAG.CTRL_DIAGONAL）
+#define DRIVE_CMD_SLALOM_R 0x04u    // MF.FLAG.SLALOM_R
+#define DRIVE_CMD_SLALOM_L 0x08u    // MF.FLAG.SLALOM_L
+#define DRIVE_CMD_IF_WALL_END 0x10u // 直前の WALLEND が壁切れを検知した場合のみ実行
+
+typedef struct {
+    uint8_t type;       // drive_cmd_type_t
+    uint8_t flags;      // DRIVE_CMD_*
+    int8_t sign;        // 旋回方向（-1: 右、+1: 左）
+    uint16_t tag;       // 呼び出し元の識別（run() は走行パスコード）
+    float dist_mm;      // 距離 [mm]
+    float v_in;         // 入口速度 [mm/s]（直進の開始時に与える）
+    float v_out;        // 出口速度 [mm/s]
+    float angle_deg;    // 旋回角 [deg]
+    float alpha_deg_s2; // 旋回の角加速度 [deg/s^2]
+    float jerk_mm_s3;   // 直進の加加速度 [mm/s^3]（0 なら等加速度）
+} drive_cmd_t;
+
+typedef struct {
+    uint8_t pending;      // 未実行のコマンド数
+    bool busy;            // 実行中のコマンドがある
+    uint32_t started;     // 実行を始めたコマンドの累計
+    uint8_t type;         // 最後に始めたコマンド
+    uint16_t tag;
+    uint16_t turn_skip;   // 旋回表が作れず飛ばした旋回の数
+    uint32_t underrun_ms; // 次のコマンドが無く速度を保持していた時間
+} drive_queue_status_t;
+
 /*============================================================
     関数プロトタイプ宣言
 ============================================================*/
 void drive_init(void);
 void drive_variable_reset(void);
 void drive_reset_before_run(void);
+void drive_turn_profile_tick(void); // 旋回プロファイルの割り込み処理
+void drive_queue_tick(void);        // 走行コマンドキューの割り込み処理
+void drive_queue_reset(void);
+bool drive_queue_push(const drive_cmd_t *cmd); // 満杯なら空くまで待つ（FAILED 等で false）
+bool drive_queue_wait_idle(void);              // 全コマンドの完了を待つ（FAILED 等で false）
+void drive_queue_get_status(drive_queue_status_t *st);
 void drive_enable_motor(void);
 void drive_disable_motor(void);
 void drive_start(void);
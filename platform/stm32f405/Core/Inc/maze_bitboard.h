@@ -0,0 +1,71 @@
+#ifndef INC_MAZE_BITBOARD_H_
+#define INC_MAZE_BITBOARD_H_
+
+#include <params.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// 壁情報の行ビットボードと、行単位のビット並列 BFS（波面展開）による歩数マップ作成
+//
+// map[][] の壁ビット（NESW）を向きごとに「行 y のビット x = 区画 (x, y) のその向きに壁あり」の
+// 行マスクへ並べ替え、歩数 k の区画集合（波面）から歩数 k+1 の集合を 1 行 1 語の演算で求める。
+// - 辺 u→v の通過可否は u 側の壁ビットで判定する（make_smap と同じ向き付き判定）
+// - 起点=0、隣接+1、未到達=0xffff。歩数は各区画の最短歩数なのでキュー BFS と同じ値になる
+// - 目標区画を指定した場合は、目標の歩数の波面まで書いたところで止める
+//   （キュー BFS は目標を書いた時点で止めるため、目標と同じ歩数の他区画の書き込み有無だけが異なる）
+// HAL に依存しないため tools/solver_host でも同じソースをビルドして検証する。
+
+#if MAZE_SIZE > 32
+#error "maze_bitboard supports MAZE_SIZE up to 32"
+#endif
+
+typedef uint32_t maze_row_t; // 1 行分のビット列（bit x = 区画 x）
+
+#define MAZE_BITBOARD_ROW_MASK \
+    ((MAZE_SIZE >= 32) ? (maze_row_t)0xffffffffu : (maze_row_t)((1u << (MAZE_SIZE & 31)) - 1u))
+#define MAZE_BITBOARD_UNREACHED 0xffff
+#define MAZE_BITBOARD_NO_TARGET 0xff // maze_bitboard_flood() で目標を指定しない
+
+typedef enum {
+    MAZE_BITBOARD_N = 0,
+    MAZE_BITBOARD_E,
+    MAZE_BITBOARD_S,
+    MAZE_BITBOARD_W,
+} maze_bitboard_dir_t;
+
+typedef struct {
+    maze_row_t wall[4][MAZE_SIZE]; // [NESW][y]: bit x = 区画 (x, y) のその向きに壁あり
+} maze_bitboard_t;
+
+// map[][] の (map >> shift) の下位4bit（N=0x08, E=0x04, S=0x02, W=0x01）から作る。
+// shift は探索中の壁なら 0、二次走行用（未知壁を壁とみなす上位4bit）なら 4。
+void maze_bitboard_build(maze_bitboard_t *bb, uint16_t map[MAZE_SIZE][MAZE_SIZE], uint8_t shift);
+// maze_bitboard_build() と同じものを作り、各区画の壁 4bit を cells[y * MAZE_SIZE + x] にも書く
+void maze_bitboard_build_cells(maze_bitboard_t *bb, uint16_t map[MAZE_SIZE][MAZE_SIZE], uint8_t shift,
+                               uint8_t cells[MAZE_SIZE * MAZE_SIZE]);
+// 区画 (x, y) の壁だけを map[][] から読み直して行マスクへ反映する（範囲外は無視）。
+// 壁を書いた区画ごとに呼べば、maze_bitboard_build() を作り直さずに map[][] と一致したまま保てる。
+void maze_bitboard_update_cell(maze_bitboard_t *bb, uint16_t map[MAZE_SIZE][MAZE_SIZE], uint8_t shift,
+                               uint8_t x, uint8_t y);
+
+// 行マスク seed[y] の区画を起点（歩数0）として smap[][] を作り、目標区画 (tx, ty) の歩数を返す
+// （未到達は MAZE_BITBOARD_UNREACHED）。tx == MAZE_BITBOARD_NO_TARGET なら全区画まで展開する。
+uint16_t maze_bitboard_flood(const maze_bitboard_t *bb, const maze_row_t seed[MAZE_SIZE],
+                             uint16_t smap[MAZE_SIZE][MAZE_SIZE], uint8_t tx, uint8_t ty);
+
+// 起点マスクの区画 (x, y) を立てる（範囲外は無視）
+static inline void maze_bitboard_seed_set(maze_row_t seed[MAZE_SIZE], uint8_t x, uint8_t y) {
+    if (x < MAZE_SIZE && y < MAZE_SIZE) {
+        seed[y] |= (maze_row_t)1u << x;
+    }
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* INC_MAZE_BITBOARD_H_ */
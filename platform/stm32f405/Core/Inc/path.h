@@ -8,6 +8,9 @@
 #ifndef INC_PATH_H_
 #define INC_PATH_H_
 
+#include <stdbool.h>
+#include <stdint.h>
+
 // 走行パスコード
 #define STRAIGHT 200
 #define TURN_R 300
@@ -15,10 +18,67 @@
 #define L_TURN_R 500
 #define L_TURN_L 600
 
+// 1: 旧実装（パス全体を段ごとに書き換える 4 関数）を比較用に残す（tools/solver_host 用）
+#ifndef PATH_ENABLE_LEGACY_PASSES
+#define PATH_ENABLE_LEGACY_PASSES 0
+#endif
+
+// 走行パスコンパイラ
+//
+// 区画ごとの動作（STRAIGHT / TURN_R / TURN_L）を 1 つずつ受け取り、最終的な走行パスコード
+// （直進の半区画数、小回り・大回り、45°/135°/V90、斜め直進）を path[] に直接書く。
+// 従来の 直進まとめ -> 大回り -> 斜め（入り・出・V90・斜め直進・連結）-> 先頭大回りの正規化 を
+// 小さな先読み窓を持つ段の連なりとして 1 回の走査で行い、path[] 全長の作業配列を持たない。
+// 出力は従来の段ごとの書き換えと同一（tools/solver_host の --path-compile-check で照合する）。
+#define PATH_STAGE_LARGE 0     // 大回り（0 番目の段）
+#define PATH_STAGE_DIAG_IN 1   // 斜め入り（45°/135°）
+#define PATH_STAGE_DIAG_OUT 2  // 斜め出（45°/135°）
+#define PATH_STAGE_DIAG_V90 3  // V90 と残りの小回りの斜め直進化
+#define PATH_STAGE_NUM 4
+
+typedef struct {
+    uint16_t w[4];   // 入力窓 [0]=直前 [1]=処理中 [2]=次 [3]=次の次
+    uint8_t fill;    // 窓に入った入力数（3 で処理開始）
+    uint8_t skip;    // まとめて消費したため処理しない入力数
+    bool active;     // false なら素通し
+    bool done;       // 終端（0）まで処理した
+    bool has_held;   // held が有効
+    uint16_t held;   // 直前の出力（次の出力までは書き換えられる）
+} path_stage_t;
+
+typedef struct {
+    // 直進まとめ
+    uint16_t run_action; // まとめ中の動作（0 = 未入力）
+    uint16_t run_count;  // まとめ中の直進区画数
+    bool run_first;      // まだ先頭要素を出していない（先頭は半区画短くする）
+    // 大回り・斜め
+    path_stage_t stage[PATH_STAGE_NUM];
+    // 斜め直進の連結
+    bool diag_active;
+    bool diag_in_seq;
+    uint16_t diag_sum;
+    // 出力（先頭大回りの正規化）
+    uint16_t out_num;    // 受け取った出力要素数
+    uint16_t out_first;  // 先頭の大回り（正規化待ち、0 = 無し）
+    uint8_t out_shift;   // 正規化で先頭に増えた要素数（0..2）
+} path_compiler_t;
+
+// path_type: 0 = 小回りのみ、1 = 大回りまで、2 以上 = 斜めまで（solver_path_type() と同じ）
+void path_compile_begin(path_compiler_t *pc, int path_type);
+// 1 区画分の動作を渡す（最初の動作は STRAIGHT であること。スタート区画は北にしか出られない）
+void path_compile_push(path_compiler_t *pc, uint16_t move);
+// 残りを出し切って path[] の残りを 0 で埋める。戻り値は path[] の要素数
+uint16_t path_compile_end(path_compiler_t *pc);
+
+#if PATH_ENABLE_LEGACY_PASSES
 void simplifyPath(void);
 void convertLTurn(void);
 void convertDiagonal(void);
 void normalizeStartLargeTurnException(void);
+
+// 従来の段ごとの書き換えで moves[0..n-1] を path[] に変換する（照合用）
+void path_compile_legacy(const uint16_t *moves, uint16_t n, int path_type);
+#endif
 // makePath()は削除済み - 経路導出はsolver_build_path()を使用
 
 #endif /* INC_PATH_H_ */
@@ -0,0 +1,115 @@
+#ifndef INC_PATH_SPEED_PLAN_H_
+#define INC_PATH_SPEED_PLAN_H_
+
+#include "shortest_run_params.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// 最短走行の経路全体の速度計画（F413 の f413_path_run_session_once() と tools/solver_host から利用）
+//
+// path[] を「先頭の半端区画 + 各コード」の区間列に展開し、区間の境界速度を
+//   - ターンの前後: ターン速度に固定
+//   - 走行開始: 0、ゴール: ゴール区画の進入速度
+//   - 直線どうし: 両側の最高速度の小さい方が上限
+// として前向き（加速で到達できる速度）・後ろ向き（減速で間に合う速度）の2パスで決める。
+// 直線・斜め区間は境界速度から加速→等速→減速の台形（低速/高速域の二段階加速度）を作る。
+// ターン速度はターン形状を決めるため変更しない。前後の直線で届かない場合は feasible=false とし、
+// その区間は区間全体で入口→出口の速度変化を行う（従来と同じく制御側の追従に任せる）。
+
+#ifndef PATH_SPEED_PLAN_MAX_CODES
+#define PATH_SPEED_PLAN_MAX_CODES 256 // 計画できる path[] のコード数
+#endif
+
+#define PATH_SPEED_PLAN_MAX_SEGS (PATH_SPEED_PLAN_MAX_CODES + 1) // 先頭の半端区画を含む
+#define PATH_SPEED_PLAN_KNOT_MAX 6 // 1区間の速度折れ点の最大数
+
+typedef enum {
+    PATH_SPEED_SEG_STRAIGHT = 0, // 直線（先頭の半端区画を含む）
+    PATH_SPEED_SEG_DIAGONAL,     // 斜め直線
+    PATH_SPEED_SEG_TURN,         // ターン（入りオフセット + 旋回 + 出オフセット）
+} path_speed_seg_kind_t;
+
+// ターンコードの諸元（モード共通パラメータから引く）
+typedef struct {
+    float signed_angle_deg; // 右旋回が負
+    float accum_angle_deg;  // 角度積算モードで使う理論角
+    float alpha_deg_s2;
+    float velocity_mm_s;
+    float dist_in_mm;
+    float dist_out_mm;
+    bool front_wall_entry;     // 入りオフセットを前壁補正で打ち切る（小回り90°）
+    bool wall_control_offsets; // 入り/出オフセットで壁制御を掛ける（小回り・大回り）
+} path_speed_turn_t;
+
+// 直線・斜めの加減速モデル（減速も同じ加速度で行う）
+typedef struct {
+    float v_max;
+    float accel_low;  // v_switch 未満の加速度 [mm/s^2]
+    float accel_high; // v_switch 以上の加速度 [mm/s^2]
+    float v_switch;   // 0 なら一段階（accel_high のみ）
+} path_speed_accel_t;
+
+typedef struct {
+    uint16_t code;     // path[] のコード（0: 先頭の半端区画）
+    uint8_t kind;      // path_speed_seg_kind_t
+    bool feasible;     // 入口→出口の速度変化が区間内の加減速で間に合う
+    float length_mm;   // 直線・斜め: 区間長、ターン: 入り+出オフセット
+    float v_entry;     // [mm/s]
+    float v_peak;
+    float v_exit;
+    float time_s;      // 見積もり所要時間
+} path_speed_seg_t;
+
+typedef struct {
+    path_speed_accel_t straight;
+    path_speed_accel_t diagonal;
+    path_speed_seg_t seg[PATH_SPEED_PLAN_MAX_SEGS];
+    uint16_t count;        // 区間数（先頭の半端区画を含む）
+    uint16_t infeasible;   // feasible=false の区間数
+    float total_time_s;
+    float total_length_mm; // 直線・斜め・ターンオフセットの合計（旋回中の移動は含まない）
+} path_speed_plan_t;
+
+// ターンコード（300/400/5xx/6xx/7xx/8xx/9xx）の諸元を返す（ターン以外は false）。
+// 角度・角加速度が未設定（0 以下）のパラメータは 90° / 10000deg/s^2 で置き換える。
+bool path_speed_turn_from_code(uint16_t code, const ShortestRunModeParams_t *mode_params,
+                               path_speed_turn_t *turn);
+
+// codes（0 終端）の速度計画を作る。turn_omega_cap_deg_s はターン所要時間の見積もりに使う
+// ピーク角速度の上限（0 で上限なし）。未対応コードや長すぎる経路では false。
+bool path_speed_plan_build(path_speed_plan_t *plan, const uint16_t *codes,
+                           const ShortestRunModeParams_t *mode_params,
+                           const ShortestRunCaseParams_t *case_params,
+                           float turn_omega_cap_deg_s);
+
+// 区間 i の速度折れ点（区間先頭からの距離 s[mm] と速度 v[mm/s]、点間は等加速度）を返す。
+// 戻り値は点数（直線・斜めは 2 以上、ターンは 0）。
+uint8_t path_speed_plan_knots(const path_speed_plan_t *plan, uint16_t i,
+                              float s[PATH_SPEED_PLAN_KNOT_MAX],
+                              float v[PATH_SPEED_PLAN_KNOT_MAX]);
+
+// ターン 1 回の所要時間の見積もり [s]（入り/出オフセット + 旋回）
+float path_speed_turn_time_s(const path_speed_turn_t *turn, float turn_omega_cap_deg_s);
+
+// 直線・斜めの加減速モデルをパラメータから作る（path_speed_plan_build() と同じ規則）
+void path_speed_accel_models(const ShortestRunModeParams_t *mode_params,
+                             const ShortestRunCaseParams_t *case_params,
+                             path_speed_accel_t *straight, path_speed_accel_t *diagonal);
+
+// 長さ length_mm を入口 v_entry・出口 v_exit で走る台形の所要時間 [s]。
+// 区間内の加減速で届かない側の速度は下げて扱う（ソルバの時間コスト見積もり用）。
+float path_speed_run_time_s(const path_speed_accel_t *m, float length_mm, float v_entry,
+                            float v_exit);
+
+// 折れ点列の距離 s_mm における速度（v^2 を距離で線形補間）
+float path_speed_knots_velocity_at(const float *s, const float *v, uint8_t knots, float s_mm);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* INC_PATH_SPEED_PLAN_H_ */
@@ -172,18 +172,42 @@ bool try_store_map_safely(void);
 void set_search_mode(search_mode_t mode);
 
 //==== 背景再計算（走行中に実行）====
-// 現在の移動内容（routeの要素: 0x88直進, 0x44右, 0x22U, 0x11左）から、
-// 次区画の予測座標をもとに make_smap/make_route を先行実行する
+// 区画の移動を始めるときに移動内容（0x88直進, 0x44右, 0x11左。0x22Uは対象外）を渡すと、
+// 次区画の予測座標を起点に歩数マップの差分更新と経路導出を走行中の待ちループで先行実行する。
+// 区画境界の conf_route() は、次区画の壁で結果が変わらない場合だけ先行経路を採用する。
 void arm_background_replan(uint16_t move_opcode);
 void background_replan_tick(void);
-extern volatile bool bg_plan_ready; // 先行計算が完了し、route[] が次区画起点で準備済み
+extern volatile bool bg_plan_ready; // 先行計算が完了し、次区画起点の経路が準備済み
+
+// 背景再計算の採用/見送りの回数（見送り時は区画境界で同期計算する）
+typedef struct {
+    uint32_t hits;                // 先行経路を採用した
+    uint32_t hits_reroute;        // 1手目が塞がれたが、先行した歩数マップで経路だけ作り直した
+    uint32_t fallback_unarmed;    // 先行計算していない（Uターン・探索開始直後・次区画が起点/到達不能）
+    uint32_t fallback_not_ready;  // 区画境界までに先行計算が終わらなかった
+    uint32_t fallback_mispredict; // 到着区画・向き・起点設定が予測と違った
+    uint32_t fallback_walls;      // 次区画の壁で経路が変わり得る（壁が消えた/1手目が塞がれた）
+} search_bg_replan_stats_t;
+
+// conf_route() の歩数マップを差分更新（step_map.c）で求める（0: 毎回 make_smap, 1: 差分更新）
+#ifndef SEARCH_INCREMENTAL_SMAP
+#define SEARCH_INCREMENTAL_SMAP 1
+#endif
+
+// 全面探索の起点（0: 全ての未探索区画, 1: 最短経路を変え得る未探索区画だけ。search_target.h 参照）
+// 1 のときは未知壁を無し/有りとみなした最短歩数が一致した時点で全面探索を終える
+#ifndef SEARCH_FULL_TARGETED
+#define SEARCH_FULL_TARGETED 1
+#endif
 
-// 背景再計算の有効/無効を切り替えるマクロ（0: 無効, 1: 有効）
+// 背景再計算の有効/無効を切り替えるマクロ（0: 無効, 1: 有効。有効時は SEARCH_INCREMENTAL_SMAP=1 が必要）
 #ifndef ENABLE_BG_REPLAN
-#define ENABLE_BG_REPLAN 0
+#define ENABLE_BG_REPLAN 1
 #endif
 
-#if !ENABLE_BG_REPLAN
+#if ENABLE_BG_REPLAN
+void search_get_bg_replan_stats(search_bg_replan_stats_t *out);
+#else
 // 無効化時はノーオペに展開
 #define background_replan_tick() ((void)0)
 #define arm_background_replan(move_opcode) ((void)(move_opcode))
@@ -0,0 +1,55 @@
+#ifndef INC_SEARCH_ROUTE_H_
+#define INC_SEARCH_ROUTE_H_
+
+#include <params.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// 探索走行の経路導出（search.c の make_route() と背景再計算から利用）
+//
+// 歩数マップを下りながら、区画 (x, y)・向き dir から起点（歩数0）までの動作列を作る。
+// - 次方向の優先順位は現在向きに対して直進→右→左→後退（make_route() と同じ）
+// - 動作は 0x88 直進, 0x44 右, 0x22 U, 0x11 左。下れる区画が無ければ 0x00 を書いて止める
+//
+// 背景再計算では、次区画の壁を書き込む前の map[][] で歩数マップと経路を先に作っておき、
+// 区画境界で壁を書き込んだあとに次の条件で使えるかを判定する。
+// - 次区画と隣接区画の壁が増えただけなら、次区画より歩数の小さい区画の歩数は変わらない
+//   （その区画の最短経路は次区画を通らないため）。次区画から歩数の小さい隣接区画へ抜けられれば
+//   次区画の歩数も変わらず、歩数マップをそのまま使って同期計算と同じ経路を作れる
+// - さらに先行経路の 1 手目の辺が開いたままなら、同期計算も同じ区画を同じ優先順で選ぶので
+//   先行経路そのものが同期計算の経路と一致する
+// HAL に依存しないため tools/solver_host でも同じソースをビルドして検証する。
+
+// 区画 (x, y) と隣接 4 区画（N, E, S, W の順）の壁ビット。範囲外は 0
+typedef struct {
+    uint8_t wall[5];
+} search_route_walls_t;
+
+// 歩数マップ smap[][] と壁 (map >> shift) の下位4bit から、route[0..cap) に経路を書く。
+// route[] は全要素を 0xffff で埋めてから書く。戻り値: 書いた動作数
+uint16_t search_route_build(uint16_t *route, uint16_t cap, uint16_t smap[MAZE_SIZE][MAZE_SIZE],
+                            uint16_t map[MAZE_SIZE][MAZE_SIZE], uint8_t shift, uint8_t x,
+                            uint8_t y, uint8_t dir);
+
+// 区画 (x, y) と隣接 4 区画の壁ビットを保存する
+void search_route_walls_save(search_route_walls_t *w, uint16_t map[MAZE_SIZE][MAZE_SIZE],
+                             uint8_t shift, uint8_t x, uint8_t y);
+
+// 保存時から (x, y) と隣接 4 区画の壁が増えただけ（消えた壁が無い）なら true
+bool search_route_walls_only_added(const search_route_walls_t *w,
+                                   uint16_t map[MAZE_SIZE][MAZE_SIZE], uint8_t shift, uint8_t x,
+                                   uint8_t y);
+
+// 区画 (x, y)・向き dir で route[0] の動作の辺に壁が無ければ true
+bool search_route_first_move_open(const uint16_t *route, uint16_t map[MAZE_SIZE][MAZE_SIZE],
+                                  uint8_t shift, uint8_t x, uint8_t y, uint8_t dir);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* INC_SEARCH_ROUTE_H_ */
@@ -0,0 +1,55 @@
+#ifndef INC_SEARCH_TARGET_H_
+#define INC_SEARCH_TARGET_H_
+
+#include <params.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "maze_bitboard.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// 全面探索の探索対象の選択（search.c の全面探索から利用）
+//
+// 最短経路（歩数）を変え得る未探索区画だけを探索対象（候補）にする。
+// - 下界 d_open: 未知壁を無しとみなした壁（map の下位4bit）でのスタート→ゴール歩数
+// - 上界 d_wall: 未知壁を有りとみなした壁（map の上位4bit）でのスタート→ゴール歩数
+// - 候補: 下位4bitの壁で「スタートからの歩数 + ゴールまでの歩数 == d_open」となる未探索区画
+//   （未知壁を無しとみなした最短経路のどれかに乗っている区画）と、到達し得る未探索のゴール区画
+//   （歩数は変えなくても、未探索のままだと最短走行のゴール進入と延長が既知の地図と変わる）
+// d_open == d_wall なら既知の壁だけで下界と同じ歩数の経路があり、それ以上探索しても最短歩数は縮まない。
+// さらに到達し得るゴール区画が全て探索済なら done を立てて全面探索を終える。
+// 探索済区画の壁は全て既知なので、候補が無くなれば必ず一致する
+// （背景再計算で到着前に探索済にした区画は壁が未知なので一致しないことがあるが、
+// 上界は未知壁を壁とみなすので done を誤って立てることはない）。
+// HAL に依存しないため tools/solver_host でも同じソースをビルドして検証する。
+
+typedef struct {
+    maze_row_t cand[MAZE_SIZE]; // 候補区画（行 y のビット x = 区画 (x, y)）
+    uint16_t cand_num;          // 候補区画の数
+    uint16_t d_open;            // 下界（未到達は MAZE_BITBOARD_UNREACHED）
+    uint16_t d_wall;            // 上界（未到達は MAZE_BITBOARD_UNREACHED）
+    bool done;                  // 上下界が一致し、ゴール区画も探索済（ゴールに届かない場合を含む）
+} search_target_t;
+
+// map[][] と visited[][] から候補と上下界を求める。
+// ゴールは行マスク goal_seed[] の区画、スタートは区画 (sx, sy)。
+void search_target_update(search_target_t *st, uint16_t map[MAZE_SIZE][MAZE_SIZE],
+                          bool visited[MAZE_SIZE][MAZE_SIZE], const maze_row_t goal_seed[MAZE_SIZE],
+                          uint8_t sx, uint8_t sy);
+
+// 区画 (x, y) が候補なら true（範囲外は false）
+static inline bool search_target_is_cand(const search_target_t *st, uint8_t x, uint8_t y) {
+    if (x >= MAZE_SIZE || y >= MAZE_SIZE) {
+        return false;
+    }
+    return ((st->cand[y] >> x) & 1u) != 0u;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* INC_SEARCH_TARGET_H_ */
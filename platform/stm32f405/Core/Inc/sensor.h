@@ -128,6 +128,9 @@ void ICM20689_DataUpdate(void);
 // ISM330DHCX
 void ISM330_Init(void);
 void ISM330_DataUpdate(void);
+// 6軸バースト読取の DMA 完了割り込み（DMA1 Stream0）と転送エラー数
+void IMU_BurstDmaIrqHandler(void);
+uint32_t IMU_BurstErrorCount(void);
 
 // 自動検出および共通アップデート
 void IMU_Init_Auto(void);
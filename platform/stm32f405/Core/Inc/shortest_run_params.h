@@ -8,6 +8,15 @@
 
 #include <stdint.h>
 
+// F413 は UART のパラメータストア（f413_param_table.c）で書き換えるため RAM に置く
+#ifndef SHORTEST_RUN_PARAMS_CONST
+#if defined(STM32F413xx)
+#define SHORTEST_RUN_PARAMS_CONST
+#else
+#define SHORTEST_RUN_PARAMS_CONST const
+#endif
+#endif
+
 /**
  * @brief モード共通（ターン＋オフセット＋ファン）パラメータ
  */
@@ -84,6 +93,7 @@ typedef struct {
     float acceleration_straight;      ///< 直線加速度 (mm/s^2)
     float acceleration_straight_dash; ///< 二段階直線加速度 (mm/s^2)
     float velocity_straight;          ///< 直線速度 (mm/s)
+    float jerk_straight;              ///< 直線・斜め直線の加加速度 (mm/s^3)、0 で等加速度（F405 の run() のみ）
     // 斜め直線
     float acceleration_d_straight;      ///< 斜め直線加速度 (mm/s^2)
     float acceleration_d_straight_dash; ///< 斜め直線 二段階加速度 (mm/s^2)
@@ -96,19 +106,19 @@ typedef struct {
 } ShortestRunCaseParams_t;
 
 // モード共通パラメータ
-extern const ShortestRunModeParams_t shortestRunModeParams2;
-extern const ShortestRunModeParams_t shortestRunModeParams3;
-extern const ShortestRunModeParams_t shortestRunModeParams4;
-extern const ShortestRunModeParams_t shortestRunModeParams5;
-extern const ShortestRunModeParams_t shortestRunModeParams6;
-extern const ShortestRunModeParams_t shortestRunModeParams7;
+extern SHORTEST_RUN_PARAMS_CONST ShortestRunModeParams_t shortestRunModeParams2;
+extern SHORTEST_RUN_PARAMS_CONST ShortestRunModeParams_t shortestRunModeParams3;
+extern SHORTEST_RUN_PARAMS_CONST ShortestRunModeParams_t shortestRunModeParams4;
+extern SHORTEST_RUN_PARAMS_CONST ShortestRunModeParams_t shortestRunModeParams5;
+extern SHORTEST_RUN_PARAMS_CONST ShortestRunModeParams_t shortestRunModeParams6;
+extern SHORTEST_RUN_PARAMS_CONST ShortestRunModeParams_t shortestRunModeParams7;
 
 // ケース個別パラメータ（case3..N の順、要素数は実装依存）
-extern const ShortestRunCaseParams_t shortestRunCaseParamsMode2[];
-extern const ShortestRunCaseParams_t shortestRunCaseParamsMode3[];
-extern const ShortestRunCaseParams_t shortestRunCaseParamsMode4[];
-extern const ShortestRunCaseParams_t shortestRunCaseParamsMode5[];
-extern const ShortestRunCaseParams_t shortestRunCaseParamsMode6[];
-extern const ShortestRunCaseParams_t shortestRunCaseParamsMode7[];
+extern SHORTEST_RUN_PARAMS_CONST ShortestRunCaseParams_t shortestRunCaseParamsMode2[];
+extern SHORTEST_RUN_PARAMS_CONST ShortestRunCaseParams_t shortestRunCaseParamsMode3[];
+extern SHORTEST_RUN_PARAMS_CONST ShortestRunCaseParams_t shortestRunCaseParamsMode4[];
+extern SHORTEST_RUN_PARAMS_CONST ShortestRunCaseParams_t shortestRunCaseParamsMode5[];
+extern SHORTEST_RUN_PARAMS_CONST ShortestRunCaseParams_t shortestRunCaseParamsMode6[];
+extern SHORTEST_RUN_PARAMS_CONST ShortestRunCaseParams_t shortestRunCaseParamsMode7[];
 
 #endif // SHORTEST_RUN_PARAMS_H
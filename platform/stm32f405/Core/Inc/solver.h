@@ -8,16 +8,67 @@
 extern "C" {
 #endif
 
+// 1: 旧実装（区画単位ノードの線形走査）を比較用に残す（tools/solver_host 用）
+#ifndef SOLVER_ENABLE_LEGACY_SCAN
+#define SOLVER_ENABLE_LEGACY_SCAN 0
+#endif
+
+// 複数ゴール（bottom-left 座標、(0,0) は未使用スロット）。既定は params.h の GOAL1..9。
+// 書き換えると次の solver_build_path() から効く（F413 は UART のパラメータストアから書き換える）
+#define SOLVER_GOAL_SLOTS 9
+extern uint8_t solver_goals[SOLVER_GOAL_SLOTS][2];
+
 // モード（2..7）とケース（3..7）を指定して新ソルバを実行し、
 // 結果を ASCII 迷路にオーバレイ（path_cell）して printMaze() で出力します。
 void solver_run(uint8_t mode, uint8_t case_index);
 
 // 最短走行で使用する経路を生成（path[] と path_cell[] を設定）
 // - map->maze の構築を内部で行います
-// - 生成後は simplifyPath(), convertLTurn(), convertDiagonal() など従来の後段処理を利用可能
+// - path[] は走行パスコンパイラ（path.h）で直進まとめ・大回り・斜め変換まで済ませた最終コード
 // - 経路生成成功時 true、失敗時 false を返す
 bool solver_build_path(uint8_t mode, uint8_t case_index);
 
+// 直近の solver_build_path() が採用したゴール区画（bottom-left 座標）を返す。
+// 経路が無かった場合は false。
+bool solver_get_last_goal(uint8_t *x, uint8_t *y);
+
+// 直近の探索の作業量と作業領域（tools/solver_host の容量・時間レポート用）
+typedef struct {
+    uint16_t heap_peak;   // 未確定集合（ヒープ）の最大件数
+    uint16_t heap_cap;    // ヒープ容量（SOLVER_HEAP_CAP）
+    uint32_t closed;      // 確定したノード数
+    uint32_t overflow;    // ヒープ溢れで登録できなかった回数（>0 なら最短の保証無し。時間最適は標準で引き直す）
+    uint8_t  fallback;    // 溢れたときに採った経路（SOLVER_FALLBACK_*）
+    uint32_t work_bytes;  // ソルバの静的作業領域 [byte]
+    uint32_t search_us;   // 迷路構築 + 探索（solver_set_clock() 設定時のみ）
+    uint32_t path_us;     // 方向列 -> 走行パス変換（同上）
+} solver_stats_t;
+
+// solver_stats_t.fallback: 未確定集合が溢れても経路無しにはせず、最短でない経路で代える
+#define SOLVER_FALLBACK_NONE    0U // 溢れ無し（最短）
+#define SOLVER_FALLBACK_PARTIAL 1U // 溢れた探索で確定できたゴールの経路（最短の保証無し）
+#define SOLVER_FALLBACK_BFS     2U // ゴールを確定できず、区画の幅優先探索で引き直した経路（区画数最小）
+
+typedef uint32_t (*solver_clock_fn)(void); // 単調増加する us カウンタ（32bit で周回してよい）
+
+void solver_get_stats(solver_stats_t *out);
+void solver_set_clock(solver_clock_fn now_us);
+
+#if SOLVER_ENABLE_LEGACY_SCAN
+// 比較用の探索実装（速度・経路比較用）
+typedef enum {
+    SOLVER_IMPL_MULTI_GOAL = 0,   // 全ゴール同時の単一パス探索（既定）
+    SOLVER_IMPL_PER_GOAL,         // ゴール毎に探索し、最適ゴールを再探索
+    SOLVER_IMPL_LEGACY_SCAN,      // ゴール毎ループ + 区画単位ノードの線形走査
+} solver_impl_t;
+
+void solver_set_impl(uint8_t impl);
+
+// 直近 solver_build_path() が走行パスコンパイラに渡した直進・右左折の列と path_type
+// （経路が無かった場合は 0 を返す）
+uint16_t solver_get_last_moves(const uint16_t **moves, int *path_type);
+#endif
+
 #ifdef __cplusplus
 }
 #endif
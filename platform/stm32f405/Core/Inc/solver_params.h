@@ -3,10 +3,42 @@
 
 #include <stdint.h>
 
+#include "shortest_run_params.h"
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+// 時間表の長さ（連続数 0..32、solver.c の連続数上限で飽和）
+#define SOLVER_TIME_TABLE_LEN 33
+
+// 時間最適プロファイルの移動コスト [s]。
+// 走行パスコンパイラ（path.c）が区画の直進・右左折の並びから作るコード（大回り・斜め入り/出・V90 など）と、
+// path_speed_plan.c の区間モデル（ターン速度で挟んだ直線・斜めの台形加減速とターン所要時間）から作る。
+// ターンのコードは前後の移動で決まるため、まず取り得るコードの最小値を積み、決まった時点で差分を足す。
+typedef struct {
+    float start[SOLVER_TIME_TABLE_LEN];    // スタートからの直進 n 区画目（[0] は初回移動、先頭の半端区画を含む）
+    float straight[SOLVER_TIME_TABLE_LEN]; // ターン後の直進 n 区画目の増分
+    float diagonal[SOLVER_TIME_TABLE_LEN]; // 斜め（ジグザグ）n 回目の増分
+    // ゴールで終わる直進 n 区画（ゴール後の延長を含む）の時間と、上の表の n 区画分の和との差
+    // （終端はゴール区画の進入速度まで減速し、ターンに半区画を使われない）
+    float goal_start[SOLVER_TIME_TABLE_LEN];
+    float goal_straight[SOLVER_TIME_TABLE_LEN];
+    float turn;           // 直進 → ターン（ターンのコードが決まるまでの最小値）
+    float single_exit;    // 直進 → ターン → 直進（大回り90° / 小回り）
+    float start_exit;     // スタートから 1 区画 → ターン → 直進（先頭の大回りは小回りに置き換わる）
+    float pair;           // 直進 → ターン → 同方向ターン
+    float pair_exit;      //   〃 → 直進（大回り180°）
+    float pair_diag;      //   〃 → 逆方向ターン（135°入り）
+    float diag_in;        // 直進 → ターン → 逆方向ターン（45°入り）
+    float diag_exit;      // 斜め → 直進（45°出）
+    float diag_pair;      // 斜め → 同方向ターン
+    float diag_pair_exit; //   〃 → 直進（135°出）
+    float diag_pair_v90;  //   〃 → 逆方向ターン（V90）
+    float s1_half;        // 1 区画の直進がターンに縮められず S1（半区画）として残るときの時間
+    float goal_diag_exit; // 斜め出でゴールに入り延長が無いとき、斜め出の後に付く S1 で止まるまでの時間
+} SolverTimeCosts_t;
+
 // 新しいソルバ（solver.c）のコストパラメータ
 typedef struct {
     float move_cost_normal;     // 通常移動
@@ -16,6 +48,8 @@ typedef struct {
     float straight_discount;    // 直線割引/step
     float diagonal_discount;    // 斜め割引/step
     float turn_penalty;         // 方向転換ペナルティ
+    // 時間最適プロファイルのみ: 移動コスト（NULL なら上の重みと割引で計算する）
+    const SolverTimeCosts_t *time;
 } SolverCaseParams_t;
 
 // プロファイルID
@@ -23,15 +57,33 @@ typedef enum {
     SOLVER_PROFILE_STANDARD = 0,      // 標準
     SOLVER_PROFILE_STRAIGHT_STRONG,   // 直進をより強く優先
     SOLVER_PROFILE_STRAIGHT_WEAK,     // 直進優先を弱め
+    SOLVER_PROFILE_TIME_OPTIMAL,      // 走行時間の見積もり（台形加減速・ターン時間）を最小化
+    SOLVER_PROFILE_NUM,
+    SOLVER_PROFILE_NONE = 0xFF,       // solver_force_profile() の解除
 } solver_profile_t;
 
 // 現在のプロファイルを設定/取得
 void solver_set_profile(uint8_t profile);
 uint8_t solver_get_profile(void);
 
+// ケースパラメータの solver_profile より優先するプロファイル（tools/solver_host の比較用）
+void solver_force_profile(uint8_t profile);
+
 // パラメータを取得（現在のプロファイルに基づく）
+// 時間最適プロファイルでは mode / case_index の最短走行パラメータから時間表を作る
 const SolverCaseParams_t* solver_get_case_params(uint8_t mode, uint8_t case_index);
 
+// 現在のプロファイルに関わらず、指定プロファイルのパラメータを取得
+const SolverCaseParams_t* solver_get_profile_params(uint8_t profile, uint8_t mode, uint8_t case_index);
+
+// モード（2..7）・ケース（1..9）の最短走行パラメータ（範囲外のモードは mode2 / 先頭ケース）
+void solver_get_shortest_params(uint8_t mode, uint8_t case_index,
+                                const ShortestRunModeParams_t **mode_params,
+                                const ShortestRunCaseParams_t **case_params);
+
+// solver_build_path() の後段処理の種別（0: 小回り, 1: 大回り, 2: 斜め）
+int solver_path_type(const ShortestRunModeParams_t *mode_params, uint8_t case_index);
+
 #ifdef __cplusplus
 }
 #endif
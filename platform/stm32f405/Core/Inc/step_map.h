@@ -0,0 +1,77 @@
+#ifndef INC_STEP_MAP_H_
+#define INC_STEP_MAP_H_
+
+#include <params.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// 差分更新型の歩数マップ（LPA*/D*-Lite と同様に、変化した区画だけを修復する）
+//
+// make_smap() と同じ規則（探索中の map[][] の壁ビット、起点=0、隣接+1、未到達=0xffff）で
+// 全区画の歩数を保持し、壁情報・起点集合の変化があった区画の周辺だけを再計算する。
+// - 辺 u→v の通過可否は u 側の壁ビットで判定する（make_smap と同じ向き付き判定）
+// - 壁が増えた／起点が外れた区画: 支えを失った区画を無効化してから再伝播（raise）
+// - 壁が減った／起点が増えた区画: 歩数が減る区画だけを伝播（lower）
+// 初回・無効化後・変化区画の記録が溢れた場合と、修復の処理量が STEP_MAP_WORK_CAP を超えた場合は
+// 行ビットボードの波面展開（maze_bitboard_flood）で全面再構築する。
+
+#ifndef STEP_MAP_DIRTY_CAP
+#define STEP_MAP_DIRTY_CAP 32 // 1回の更新で記録できる変化区画数（超えたら全面走査）
+#endif
+
+#ifndef STEP_MAP_WORK_CAP
+// 1回の修復で処理する区画数の上限（超えたら打ち切って全面再構築）。
+// 壁が閉じて遠くまで無効化が及ぶ更新は、区画数を超える処理量になり全面展開より遅いため
+#define STEP_MAP_WORK_CAP (MAZE_SIZE * MAZE_SIZE / 8)
+#endif
+
+#define STEP_MAP_UNREACHED 0xffff // 未到達区画の歩数
+
+// 歩数マップの起点
+typedef enum {
+    STEP_MAP_TARGET_GOAL = 0,  // params.h の GOAL1..9（往路）
+    STEP_MAP_TARGET_START,     // スタート区画（復路）
+    STEP_MAP_TARGET_UNVISITED, // 未探索区画（全面探索）。スタート区画は常に既知扱い
+} step_map_target_t;
+
+typedef struct {
+    uint16_t (*dist)[MAZE_SIZE];            // 歩数の格納先（smap[][] など）
+    uint8_t wall[MAZE_SIZE * MAZE_SIZE];    // 前回更新時の壁ビット（下位4bit、NESW）
+    uint8_t flag[MAZE_SIZE * MAZE_SIZE];    // 区画状態フラグ（step_map.c 参照）
+    uint16_t dirty[STEP_MAP_DIRTY_CAP];     // 前回更新後に変化した可能性のある区画
+    uint16_t dirty_len;
+    uint16_t bucket[MAZE_SIZE * MAZE_SIZE]; // 歩数別バケットキューの先頭
+    uint16_t next[MAZE_SIZE * MAZE_SIZE];   // バケット内の双方向リスト
+    uint16_t prev[MAZE_SIZE * MAZE_SIZE];
+    uint16_t raised[MAZE_SIZE * MAZE_SIZE]; // raise フェーズで無効化した区画
+    uint16_t raised_len;
+    uint16_t work;          // 直近の更新で処理した区画数（コスト計測用。全面再構築は区画数）
+    uint16_t aborts;        // 処理量の上限で修復を打ち切った回数（bind からの累計）
+    uint8_t target;         // 前回更新時の起点種別
+    bool second_run;        // 前回更新時の壁ビット選択（MF.FLAG.SCND）
+    bool valid;             // false なら次回は全面再構築
+    bool overflow;          // dirty[] が溢れた（全区画を差分走査する）
+} step_map_t;
+
+// 歩数の格納先を結び付け、状態を無効化する
+void step_map_bind(step_map_t *sm, uint16_t (*dist)[MAZE_SIZE]);
+// 次回 step_map_update() で全面再構築させる（map 初期化・格納先の上書き時など）
+void step_map_invalidate(step_map_t *sm);
+// 区画 (x, y) の壁ビットまたは探索済状態が変わった可能性を記録する（範囲外は無視）
+void step_map_touch(step_map_t *sm, uint8_t x, uint8_t y);
+// 記録された変化を反映して歩数マップを修復する。
+// 起点種別や壁ビット選択が前回と異なる場合は全面再構築する。
+// 戻り値: true=差分修復, false=全面再構築（処理量の上限での打ち切りを含む）
+bool step_map_update(step_map_t *sm, uint16_t walls[MAZE_SIZE][MAZE_SIZE],
+                     bool visited[MAZE_SIZE][MAZE_SIZE], step_map_target_t target,
+                     bool second_run);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* INC_STEP_MAP_H_ */
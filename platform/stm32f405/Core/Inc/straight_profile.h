@@ -0,0 +1,50 @@
+#ifndef INC_STRAIGHT_PROFILE_H_
+#define INC_STRAIGHT_PROFILE_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// 直線区間の加加速度（ジャーク）制限付き S 字速度プロファイル
+//
+// 従来の等加速度 a = (v_out^2 - v_in^2) / 2d と同じ区間長 d・所要時間 T = 2d / (v_in + v_out) のまま、
+// 加速度を 0 → a_peak → 0 とジャーク J で台形に変える。速度の形は区間の中点で点対称なので、
+// 平均速度は (v_in + v_out) / 2 のままで区間長も出口速度も変わらない。
+// 加速度の立ち上がりが無くなる代わりに、a_peak は平均加速度 |v_out - v_in| / T より大きくなる
+// （J が小さいほど大きい。J T^2 < 4|v_out - v_in| では作れない）。
+// 1kHz 制御割り込みは tick 番号で速度を引く。tick k の速度は区間 [k dt, (k+1) dt) の中点で評価するので、
+// 速度 × dt の積算（calculate_translation()）が区間長に一致する。
+
+#define STRAIGHT_PROFILE_DT_S 0.001f // tick の刻み [s]（制御周期）
+
+typedef struct {
+    float v_in;      // 入口速度 [mm/s]
+    float v_out;     // 出口速度 [mm/s]
+    float dist_mm;   // 区間長 [mm]
+    float jerk;      // 加加速度 [mm/s^3]（正）
+    float a_peak;    // 加速度の最大値 [mm/s^2]（減速は負）
+    float t_jerk_s;  // 加速度の立ち上がり・立ち下がりの時間
+    float t_total_s; // 所要時間 T
+    uint32_t n_total; // tick k < n_total がプロファイル内、以降は v_out
+} straight_profile_t;
+
+// v_in → v_out を区間長 dist_mm で結ぶプロファイルを作る。
+// 作れない条件（jerk <= 0、速度変化なし、区間が短すぎる等）では false を返し、呼び出し側は従来の等加速度にする。
+bool straight_profile_build(straight_profile_t *p, float v_in, float v_out, float dist_mm,
+                            float jerk_mm_s3);
+
+// 連続式での速度・加速度（t_s < 0 は v_in、t_s >= T は v_out）
+float straight_profile_velocity(const straight_profile_t *p, float t_s);
+float straight_profile_accel(const straight_profile_t *p, float t_s);
+
+// tick k の速度 [mm/s]（区間 [k dt, (k+1) dt) の中点で評価）
+float straight_profile_velocity_at(const straight_profile_t *p, uint32_t tick);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* INC_STRAIGHT_PROFILE_H_ */
@@ -0,0 +1,90 @@
+#ifndef INC_TURN_PROFILE_H_
+#define INC_TURN_PROFILE_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// スラローム旋回の角速度プロファイル（余弦ブレンド）を 1ms 刻みの表に展開したもの
+//
+// 従来の 1/3-1/3-1/3 位相から等価な ωmax, Ta, Tc を求め、
+//   加速: ω = ωmax/2 (1 - cos(π t/Ta))、等速: ω = ωmax、減速: ω = ωmax/2 (1 + cos(π td/Ta))
+// とする形は drive.c / F413 の従来実装と同じ。モードのパラメータ適用時に表を作っておき、
+// 1kHz 制御割り込みは tick 番号で表を引くだけにする（cosf もメインループの時刻監視も不要）。
+// 表は ω/ωmax を 16bit 固定小数で持つ。加減速区間が表に収まらない場合は連続式で代用する。
+
+#ifndef TURN_PROFILE_RAMP_MAX
+#define TURN_PROFILE_RAMP_MAX 320 // 加速・減速区間の最大 tick 数（Ta ≦ 320ms）
+#endif
+
+#define TURN_PROFILE_DT_S 0.001f // 表の刻み [s]（制御周期）
+
+typedef enum {
+    TURN_PROFILE_PHASE_ACCEL = 0,
+    TURN_PROFILE_PHASE_CRUISE,
+    TURN_PROFILE_PHASE_DECEL,
+    TURN_PROFILE_PHASE_DONE,
+} turn_profile_phase_t;
+
+typedef struct {
+    // 生成条件（キャッシュのキー）
+    float angle_abs_deg;
+    float alpha_deg_s2;
+    float rounding_scale;
+    float omega_cap_deg_s;
+    // 連続時間の形
+    float omega_peak_deg_s;
+    float t_acc_s;
+    float t_cruise_s;
+    float t_total_s;
+    // tick k (t = k*dt) の区間境界
+    uint16_t n_acc;       // k < n_acc: 加速
+    uint16_t n_dec_start; // k < n_dec_start: 等速
+    uint16_t n_total;     // k < n_total: 減速、以降は 0
+    bool tabulated;       // false なら表を使わず連続式で評価する
+    uint16_t acc[TURN_PROFILE_RAMP_MAX]; // ω/ωmax (0..65535)
+    uint16_t dec[TURN_PROFILE_RAMP_MAX];
+} turn_profile_t;
+
+// 旋回角 angle_deg（符号は無視）と角加速度 alpha からプロファイルを作る。
+// omega_cap_deg_s > 0 ならピーク角速度を制限する（角度は等速区間で保存）。
+// 作れない条件（角度 0 など）では t_total_s = 0, n_total = 0 になる。
+void turn_profile_build(turn_profile_t *p, float angle_deg, float alpha_deg_s2,
+                        float rounding_scale, float omega_cap_deg_s);
+
+// 表を作らずに所要時間 [s] だけを求める（経路の所要時間見積もり用）
+float turn_profile_duration_s(float angle_deg, float alpha_deg_s2, float rounding_scale,
+                              float omega_cap_deg_s);
+
+// 連続式での評価（従来実装と同じ式。表の検証と表に収まらない場合に使う）
+float turn_profile_sample(const turn_profile_t *p, float t_s);
+
+// tick k の角速度の絶対値 [deg/s]
+float turn_profile_omega_at(const turn_profile_t *p, uint32_t tick);
+
+// tick k の区間
+turn_profile_phase_t turn_profile_phase_at(const turn_profile_t *p, uint32_t tick);
+
+// 同じ条件のプロファイルを使い回す小さなキャッシュ
+typedef struct {
+    turn_profile_t *slots;
+    uint8_t count;
+    uint8_t used;
+    uint8_t next; // 満杯時に上書きする位置
+    uint8_t last; // 直前に返した枠（上書きしない）
+} turn_profile_cache_t;
+
+void turn_profile_cache_init(turn_profile_cache_t *c, turn_profile_t *slots, uint8_t count);
+// 条件が一致するプロファイルを返す。無ければ空き（無ければ古い順）に作って返す。
+const turn_profile_t *turn_profile_cache_get(turn_profile_cache_t *c, float angle_deg,
+                                             float alpha_deg_s2, float rounding_scale,
+                                             float omega_cap_deg_s);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* INC_TURN_PROFILE_H_ */
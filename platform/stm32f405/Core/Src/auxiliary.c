@@ -6,6 +6,7 @@
  */
 
 #include "global.h"
+#include "trace.h"
 #include "drive.h"
 
 //+++++++++++++++++++++++++++++++++++++++++++++++
@@ -190,7 +191,7 @@ int __io_putchar(int c) {
 #define PUTCHAR_PROTOTYPE int fputc(int ch, FILE *f)
 #endif /* __GNUC__ */
 
-void __io_putchar(int ch) { 
-    uint8_t temp = ch;
-    HAL_UART_Transmit(&huart1, &temp, 1, 1); 
+void __io_putchar(int ch) {
+    char temp = (char)ch;
+    trace_write(&temp, 1); // printf と同じ送信リングに積む（DMA 転送と混ざらないように）
 }
@@ -12,6 +12,8 @@
 #include "sensor.h"
 #include "interrupt.h"
 #include "logging.h"
+#include "straight_profile.h"
+#include "turn_profile.h"
 #include <math.h>
 #include <stdint.h>
 #include <stdlib.h>
@@ -20,6 +22,14 @@
 #define TURN_OMEGA_PROFILE_ROUNDING_SCALE 1.0f
 #endif
 
+#ifndef DRIVE_TURN_PROFILE_SLOTS
+#define DRIVE_TURN_PROFILE_SLOTS 8 // モードのターン種別数（90/大回り90/180/45入/45出/V90/135入/135出）
+#endif
+
+#ifndef DRIVE_TURN_PROFILE_TIMEOUT_MARGIN_MS
+#define DRIVE_TURN_PROFILE_TIMEOUT_MARGIN_MS 50U
+#endif
+
 #ifndef SUCTION_GAIN_ON_THRESHOLD_PERCENT
 #define SUCTION_GAIN_ON_THRESHOLD_PERCENT 50U
 #endif
@@ -131,115 +141,449 @@ static inline void failsafe_turn_angle_begin(float cmd_angle_deg) {
     failsafe_turn_angle_begin_dir(cmd_angle_deg, 0);
 }
 
-typedef struct {
-    float omega_peak_deg_s;
-    float t_acc_s;
-    float t_cruise_s;
-    float t_total_s;
-} smooth_turn_profile_t;
+// スラローム旋回の角速度プロファイル表（モードのパラメータ適用後に作成し、1kHz 制御割り込みで引く）
+static turn_profile_t s_turn_profile_slots[DRIVE_TURN_PROFILE_SLOTS];
+static turn_profile_cache_t s_turn_profile_cache;
+static bool s_turn_profile_cache_ready = false;
+
+// 割り込みで実行中の旋回（NULL なら停止）
+static const turn_profile_t *volatile s_turn_profile_active = NULL;
+static volatile uint32_t s_turn_profile_tick = 0;
+static volatile int8_t s_turn_profile_sign = 0;
+
+static const turn_profile_t *turn_profile_lookup(float angle_turn_deg, float alpha_turn_deg_s2) {
+    if (!s_turn_profile_cache_ready) {
+        turn_profile_cache_init(&s_turn_profile_cache, s_turn_profile_slots,
+                                DRIVE_TURN_PROFILE_SLOTS);
+        s_turn_profile_cache_ready = true;
+    }
+    // 表に無い条件（テストモード等）はここで作る。作成はメインループ側のみ
+    return turn_profile_cache_get(&s_turn_profile_cache, angle_turn_deg, alpha_turn_deg_s2,
+                                  TURN_OMEGA_PROFILE_ROUNDING_SCALE, 0.0f);
+}
 
-static inline smooth_turn_profile_t build_smooth_turn_profile(float angle_turn_deg,
-                                                              float alpha_turn_deg_s2) {
-    smooth_turn_profile_t p = {0.0f, 0.0f, 0.0f, 0.0f};
-    const float angle_abs = fabsf(angle_turn_deg);
+// 現在のモードのターン種別ごとに表を作り直す
+static void drive_compile_turn_profiles(void) {
+    s_turn_profile_active = NULL;
+    turn_profile_cache_init(&s_turn_profile_cache, s_turn_profile_slots,
+                            DRIVE_TURN_PROFILE_SLOTS);
+    s_turn_profile_cache_ready = true;
 
-    if (angle_abs <= 0.0f || alpha_turn_deg_s2 <= 0.0f) {
-        return p;
+    (void)turn_profile_lookup(angle_turn_90, alpha_turn90);
+    (void)turn_profile_lookup(angle_l_turn_90, alpha_l_turn_90);
+    (void)turn_profile_lookup(angle_l_turn_180, alpha_l_turn_180);
+    (void)turn_profile_lookup(angle_turn45in, alpha_turn45in);
+    (void)turn_profile_lookup(angle_turn45out, alpha_turn45out);
+    (void)turn_profile_lookup(angle_turnV90, alpha_turnV90);
+    (void)turn_profile_lookup(angle_turn135in, alpha_turn135in);
+    (void)turn_profile_lookup(angle_turn135out, alpha_turn135out);
+}
+
+//+++++++++++++++++++++++++++++++++++++++++++++++
+// drive_turn_profile_tick
+// 旋回プロファイルを1tick進め、角速度と並進減速度を与える（1kHz 制御割り込みから呼ぶ）
+// 引数：なし
+// 戻り値：なし
+//+++++++++++++++++++++++++++++++++++++++++++++++
+void drive_turn_profile_tick(void) {
+    const turn_profile_t *p = s_turn_profile_active;
+    if (p == NULL) {
+        return;
     }
 
-    // 従来の1/3-1/3-1/3位相から等価なωmax, Ta, Tcを算出し、
-    // 角速度を余弦ブレンド（C1連続）へ置換する。
-    const float omega_peak_base = sqrtf((2.0f * alpha_turn_deg_s2 * angle_abs) / 3.0f);
-    p.omega_peak_deg_s = omega_peak_base;
-    if (p.omega_peak_deg_s <= 0.0f) {
-        p.omega_peak_deg_s = 0.0f;
-        return p;
+    const uint32_t k = s_turn_profile_tick;
+    switch (turn_profile_phase_at(p, k)) {
+    case TURN_PROFILE_PHASE_ACCEL:
+        acceleration_interrupt = -acceleration_turn;
+        break;
+    case TURN_PROFILE_PHASE_CRUISE:
+        acceleration_interrupt = 0.0f;
+        break;
+    case TURN_PROFILE_PHASE_DECEL:
+        acceleration_interrupt = acceleration_turn;
+        break;
+    default:
+        s_turn_profile_active = NULL;
+        return;
     }
 
-    const float t_acc_base = omega_peak_base / alpha_turn_deg_s2;
-    float rounding_scale = TURN_OMEGA_PROFILE_ROUNDING_SCALE;
-    if (rounding_scale < 0.1f) {
-        rounding_scale = 0.1f;
+    omega_interrupt = (float)s_turn_profile_sign * turn_profile_omega_at(p, k);
+    s_turn_profile_tick = k + 1u;
+}
+
+static void run_smooth_turn_profile(float angle_turn_deg, float alpha_turn_deg_s2,
+                                    int8_t turn_dir_sign) {
+    const turn_profile_t *p = turn_profile_lookup(angle_turn_deg, alpha_turn_deg_s2);
+    if (p == NULL || p->n_total == 0u) {
+        omega_interrupt = 0.0f;
+        alpha_interrupt = 0.0f;
+        return;
     }
 
-    // 丸め係数:
-    //   >1.0 で加減速区間を長く（より滑らか）
-    //   <1.0 で加減速区間を短く（より鋭く）
-    p.t_acc_s = t_acc_base * rounding_scale;
+    alpha_interrupt = 0.0f;
+    omega_interrupt = 0.0f;
+    s_turn_profile_tick = 0;
+    s_turn_profile_sign = turn_dir_sign;
+    s_turn_profile_active = p;
 
-    // 角度保存条件（余弦ブレンド: angle = omega_peak * (t_acc + t_cruise)）
-    p.t_cruise_s = (angle_abs / p.omega_peak_deg_s) - p.t_acc_s;
-    if (p.t_cruise_s < 0.0f) {
-        // 丸めを強くし過ぎた場合は台形が成立しないため、等速区間なしの三角形へ遷移。
-        // その場合でも角度は一致するようにピーク角速度を再計算する。
-        p.t_cruise_s = 0.0f;
-        p.omega_peak_deg_s = angle_abs / p.t_acc_s;
+    // 旋回中の角速度は割り込みが与えるので、メインループは再計画に使える。
+    // 制御割り込みが止まった場合（RUNNING 解除等）に備えて所要時間+余裕で打ち切る
+    const uint32_t t_start_ms = HAL_GetTick();
+    const uint32_t timeout_ms = (uint32_t)p->n_total + DRIVE_TURN_PROFILE_TIMEOUT_MARGIN_MS;
+    while (s_turn_profile_active != NULL && !MF.FLAG.FAILED) {
+        if ((HAL_GetTick() - t_start_ms) > timeout_ms) {
+            break;
+        }
+        background_replan_tick();
     }
-    p.t_total_s = 2.0f * p.t_acc_s + p.t_cruise_s;
-    return p;
+    s_turn_profile_active = NULL;
 }
 
-static inline float sample_smooth_turn_omega(const smooth_turn_profile_t *p, float t_s) {
-    if (p->t_total_s <= 0.0f || p->omega_peak_deg_s <= 0.0f) {
-        return 0.0f;
-    }
-    if (t_s <= 0.0f) {
-        return 0.0f;
+/*==========================================================
+    走行コマンドキュー（メインループが積み、1kHz 制御割り込みが消費する）
+==========================================================*/
+#define DRIVE_QUEUE_MASK ((uint8_t)(DRIVE_QUEUE_LEN - 1u))
+
+typedef struct {
+    drive_cmd_t cmd;
+    const turn_profile_t *profile; // TURN: 積み込み時に表を引いておく（NULL なら飛ばす）
+} drive_queue_slot_t;
+
+static drive_queue_slot_t s_dq[DRIVE_QUEUE_LEN];
+static volatile uint8_t s_dq_head = 0; // 書き込み位置（メインループのみ更新）
+static volatile uint8_t s_dq_tail = 0; // 読み出し位置（割り込みのみ更新）
+
+// 以下は割り込みのみが更新する
+static drive_queue_slot_t s_dq_run;    // 実行中のコマンド
+static volatile bool s_dq_busy = false;
+static float s_dq_end_mm;              // 終了位置（target_distance 基準）
+static bool s_dq_fwall;                // FWALL: 開始時に前壁が見えていた
+static bool s_dq_extended;             // FWALL: 前壁待ちの延長に入った
+static bool s_dq_wall_end_found;       // 直前の WALLEND が壁切れを検知した
+static bool s_dq_hold;                 // キューが空になったとき速度を保持している
+static straight_profile_t s_dq_scurve; // STRAIGHT/FWALL: S 字速度プロファイル
+static bool s_dq_scurve_active;
+static uint32_t s_dq_scurve_tick;
+static volatile uint32_t s_dq_started = 0;
+static volatile uint16_t s_dq_turn_skip = 0;
+static volatile uint32_t s_dq_underrun_ms = 0;
+
+static inline bool drive_queue_empty(void) { return s_dq_head == s_dq_tail; }
+
+static void drive_queue_apply_flags(uint8_t flags) {
+    MF.FLAG.CTRL = (flags & DRIVE_CMD_CTRL) ? 1 : 0;
+    MF.FLAG.CTRL_DIAGONAL = (flags & DRIVE_CMD_CTRL_DIAG) ? 1 : 0;
+    MF.FLAG.SLALOM_R = (flags & DRIVE_CMD_SLALOM_R) ? 1 : 0;
+    MF.FLAG.SLALOM_L = (flags & DRIVE_CMD_SLALOM_L) ? 1 : 0;
+}
+
+// 区間を始める（指令速度と目標距離は前の区間から持ち越す）
+static void drive_queue_start(void) {
+    const drive_cmd_t *c = &s_dq_run.cmd;
+
+    s_dq_busy = true;
+    s_dq_hold = false;
+    s_dq_scurve_active = false;
+    s_dq_started++;
+    drive_queue_apply_flags(c->flags);
+
+    // PID の状態は従来の区間ごとの走行（drive_variable_reset()）と同じく区間の始めに戻す。
+    // 角度の目標と各ゲインはこの前提で合わせてあり、距離の誤差を持ち越すと高速域で
+    // 距離 PID が飽和して回転側の余裕がなくなる。持ち越すのは指令速度と目標距離だけにする
+    if (!g_angle_accum_mode) {
+        real_angle = 0;
+        IMU_angle = 0;
+        target_angle = 0;
     }
+    angle_error = 0;
+    previous_angle_error = 0;
+    angle_error_error = 0;
+    angle_integral = 0;
+    target_omega = 0;
+    omega_error = 0;
+    previous_omega_error = 0;
+    omega_error_error = 0;
+    omega_integral = 0;
+    encoder_distance_r += target_distance - real_distance;
+    encoder_distance_l += target_distance - real_distance;
+    real_distance = target_distance;
+    distance_error = 0;
+    previous_distance_error = 0;
+    distance_error_error = 0;
+    distance_integral = 0;
+    velocity_error = 0;
+    previous_velocity_error = 0;
+    velocity_error_error = 0;
+    velocity_integral = 0;
+    failsafe_turn_angle_begin_dir((c->type == DRIVE_CMD_TURN) ? c->angle_deg : 0.0f,
+                                  (c->type == DRIVE_CMD_TURN) ? c->sign : 0);
+    s_fail_turn_angle_armed_for_start = 0;
 
-    const float kPi = 3.14159265358979323846f;
+    switch (c->type) {
+    case DRIVE_CMD_TURN:
+        // 旋回は入る時点の速度の等速で行う（driveA() 後の drive_variable_reset() と同じ）。
+        // 前の直線の加速度を残すと、速度クランプのない旋回中も加減速し続けて角度が追従しない
+        acceleration_interrupt = 0.0f;
+        velocity_profile_clamp_enabled = 0;
+        alpha_interrupt = 0.0f;
+        omega_interrupt = 0.0f;
+        if (s_dq_run.profile == NULL) {
+            s_dq_turn_skip++;
+            break;
+        }
+        s_turn_profile_tick = 0;
+        s_turn_profile_sign = c->sign;
+        s_turn_profile_active = s_dq_run.profile;
+        break;
 
-    if (t_s < p->t_acc_s) {
-        const float x = kPi * (t_s / p->t_acc_s);
-        return 0.5f * p->omega_peak_deg_s * (1.0f - cosf(x));
+    case DRIVE_CMD_WALLEND:
+        s_dq_end_mm = c->dist_mm;
+        // 前の区間の出口速度と違うとき（旋回を飛ばした後など）は段差にせず直線の加速度で合わせる
+        velocity_profile_target = c->v_in;
+        velocity_profile_clamp_enabled = 1;
+        if (velocity_interrupt < c->v_in) {
+            acceleration_interrupt = acceleration_straight;
+        } else if (velocity_interrupt > c->v_in) {
+            acceleration_interrupt = -acceleration_straight;
+        } else {
+            acceleration_interrupt = 0.0f;
+        }
+        wall_end_reset();
+        MF.FLAG.WALL_END = 1;
+        break;
+
+    default: {
+        // 前区間の行き過ぎ分（target_distance の残り）を差し引いた距離で v_out に合わせる
+        const float remain = c->dist_mm - target_distance;
+        s_dq_end_mm = c->dist_mm;
+        s_dq_fwall = (c->type == DRIVE_CMD_FWALL) && MF.FLAG.F_WALL;
+        s_dq_extended = false;
+        velocity_interrupt = c->v_in;
+        target_velocity = c->v_in;
+        velocity_profile_target = c->v_out;
+        velocity_profile_clamp_enabled = 1;
+        acceleration_interrupt =
+            (remain > 1e-3f) ? (c->v_out * c->v_out - c->v_in * c->v_in) / (2.0f * remain) : 0.0f;
+        // ジャーク指定があれば同じ距離・所要時間の S 字にする（作れなければ上の等加速度のまま）
+        if (c->jerk_mm_s3 > 0.0f &&
+            straight_profile_build(&s_dq_scurve, c->v_in, c->v_out, remain, c->jerk_mm_s3)) {
+            s_dq_scurve_active = true;
+            s_dq_scurve_tick = 0;
+        }
+        break;
     }
+    }
+}
+
+// 実行中の区間が終わったか（この tick の積算の前に判定する）
+static bool drive_queue_done(void) {
+    const drive_cmd_t *c = &s_dq_run.cmd;
+
+    switch (c->type) {
+    case DRIVE_CMD_TURN:
+        if (s_dq_run.profile == NULL || s_turn_profile_active == NULL ||
+            s_turn_profile_tick >= s_dq_run.profile->n_total) {
+            s_turn_profile_active = NULL;
+            alpha_interrupt = 0.0f;
+            omega_interrupt = 0.0f;
+            velocity_interrupt = c->v_out;
+            return true;
+        }
+        return false;
 
-    if (t_s < (p->t_acc_s + p->t_cruise_s)) {
-        return p->omega_peak_deg_s;
+    case DRIVE_CMD_WALLEND:
+        if (wall_end_detected_r || wall_end_detected_l) {
+            s_dq_wall_end_found = true;
+        } else if (target_distance < s_dq_end_mm) {
+            return false;
+        }
+        MF.FLAG.WALL_END = 0;
+        return true;
+
+    case DRIVE_CMD_FWALL:
+        if (s_dq_fwall && MF.FLAG.F_WALL && (ad_fr + ad_fl) >= val_offset_in) {
+            velocity_interrupt = c->v_out;
+            return true;
+        }
+        if (target_distance < s_dq_end_mm) {
+            return false;
+        }
+        // 前壁しきい値に達していなければ等速で延長して待つ（上限: WALL_END_EXTEND_MAX_MM）
+        if (s_dq_fwall && !s_dq_extended && WALL_END_EXTEND_MAX_MM > 0.0f) {
+            s_dq_extended = true;
+            s_dq_end_mm += WALL_END_EXTEND_MAX_MM;
+            s_dq_scurve_active = false;
+            acceleration_interrupt = 0.0f;
+            velocity_interrupt = c->v_out;
+            return false;
+        }
+        velocity_interrupt = c->v_out;
+        return true;
+
+    default:
+        // driveA() と同じく実距離で終える。目標距離で終えると、急な加速区間では実速度が
+        // 追いつく前に次の旋回へ入ってしまう（出口の目標速度との差が旋回中の角度誤差になる）
+        if (real_distance >= s_dq_end_mm) {
+            return true;
+        }
+        if (s_dq_scurve_active ? (s_dq_scurve.a_peak <= 0.0f) : (acceleration_interrupt <= 0.0f)) {
+            // 停止区間は速度が 0 になった時点、前壁停止が有効なら前壁しきい値でも終える
+            if (c->v_out <= 0.0f && velocity_interrupt <= 0.0f) {
+                return true;
+            }
+            if (MF.FLAG.F_WALL_STOP && (ad_fl + ad_fr) >= thr_f_wall) {
+                return true;
+            }
+        }
+        return false;
     }
+}
+
+// 区間を終える。次の区間の距離は終了位置から数える（行き過ぎ分は持ち越す）
+static void drive_queue_finish(void) {
+    const drive_cmd_t *c = &s_dq_run.cmd;
+    float shift = target_distance;
 
-    if (t_s < p->t_total_s) {
-        const float td = t_s - (p->t_acc_s + p->t_cruise_s);
-        const float x = kPi * (td / p->t_acc_s);
-        return 0.5f * p->omega_peak_deg_s * (1.0f + cosf(x));
+    if (c->type != DRIVE_CMD_TURN && shift > s_dq_end_mm) {
+        shift = s_dq_end_mm;
     }
+    target_distance -= shift;
+    real_distance -= shift;
+    encoder_distance_r -= shift;
+    encoder_distance_l -= shift;
 
-    return 0.0f;
+    s_dq_busy = false;
+    s_dq_scurve_active = false;
 }
 
-static void run_smooth_turn_profile(float angle_turn_deg, float alpha_turn_deg_s2,
-                                    int8_t turn_dir_sign) {
-    const smooth_turn_profile_t p =
-        build_smooth_turn_profile(angle_turn_deg, alpha_turn_deg_s2);
-    if (p.t_total_s <= 0.0f) {
-        omega_interrupt = 0.0f;
-        alpha_interrupt = 0.0f;
+// S 字プロファイルの tick k の速度になるように、この tick の積算（calculate_translation()）の加速度を与える
+static void drive_queue_scurve_step(void) {
+    if (!s_dq_scurve_active) {
         return;
     }
+    const float v = straight_profile_velocity_at(&s_dq_scurve, s_dq_scurve_tick);
+    acceleration_interrupt = (v - velocity_interrupt) / g_ctrl_dt;
+    s_dq_scurve_tick++;
+}
 
-    alpha_interrupt = 0.0f;
-    omega_interrupt = 0.0f;
-    const uint32_t t_start_ms = HAL_GetTick();
-
-    while (!MF.FLAG.FAILED) {
-        const float t_s = (float)(HAL_GetTick() - t_start_ms) * 0.001f;
-        if (t_s >= p.t_total_s) {
-            break;
+//+++++++++++++++++++++++++++++++++++++++++++++++
+// drive_queue_tick
+// 走行コマンドキューを1tick進める（1kHz 制御割り込みから、drive_turn_profile_tick() の前に呼ぶ）
+// 区間が終わった tick に次の区間を始めるので、区間の境目で速度の指令が途切れない。
+// 引数：なし
+// 戻り値：なし
+//+++++++++++++++++++++++++++++++++++++++++++++++
+void drive_queue_tick(void) {
+    if (!s_dq_busy && drive_queue_empty()) {
+        if (s_dq_hold) {
+            s_dq_underrun_ms++;
         }
+        return;
+    }
+    if (MF.FLAG.FAILED) {
+        s_dq_tail = s_dq_head;
+        s_dq_busy = false;
+        s_dq_hold = false;
+        s_dq_scurve_active = false;
+        s_turn_profile_active = NULL;
+        MF.FLAG.WALL_END = 0;
+        return;
+    }
 
-        if (t_s < p.t_acc_s) {
-            acceleration_interrupt = -acceleration_turn;
-        } else if (t_s < (p.t_acc_s + p.t_cruise_s)) {
+    // 距離 0 の区間や実行条件を満たさない区間は同じ tick のうちに飛ばす
+    for (uint8_t n = 0; n <= DRIVE_QUEUE_LEN; n++) {
+        if (s_dq_busy) {
+            if (!drive_queue_done()) {
+                drive_queue_scurve_step();
+                return;
+            }
+            drive_queue_finish();
+        }
+        if (drive_queue_empty()) {
+            // 次が間に合わなければ出口速度を保ったまま待つ（停止区間の後は止める）
             acceleration_interrupt = 0.0f;
-        } else {
-            acceleration_interrupt = acceleration_turn;
+            velocity_profile_clamp_enabled = 0;
+            if (s_dq_run.cmd.v_out > 0.0f) {
+                s_dq_hold = true;
+            } else {
+                velocity_interrupt = 0.0f;
+                drive_queue_apply_flags(0);
+            }
+            return;
         }
+        s_dq_run = s_dq[s_dq_tail];
+        __DMB(); // スロットを読み終えてから解放する（解放後はメインループが上書きする）
+        s_dq_tail = (uint8_t)((s_dq_tail + 1u) & DRIVE_QUEUE_MASK);
+        if ((s_dq_run.cmd.flags & DRIVE_CMD_IF_WALL_END) && !s_dq_wall_end_found) {
+            continue;
+        }
+        s_dq_wall_end_found = false;
+        drive_queue_start();
+    }
+}
+
+void drive_queue_reset(void) {
+    s_dq_busy = false;
+    s_dq_tail = s_dq_head;
+    s_turn_profile_active = NULL;
+    s_dq_hold = false;
+    s_dq_scurve_active = false;
+    s_dq_wall_end_found = false;
+    s_dq_started = 0;
+    s_dq_turn_skip = 0;
+    s_dq_underrun_ms = 0;
+}
 
-        const float omega_abs = sample_smooth_turn_omega(&p, t_s);
-        omega_interrupt = (float)turn_dir_sign * omega_abs;
+//+++++++++++++++++++++++++++++++++++++++++++++++
+// drive_queue_push
+// コマンドを積む。満杯なら空くまで待つ（旋回の表引きはここで行う）
+// 引数：cmd …… 積むコマンド
+// 戻り値：積めたら true（走行が止まった・フェイルセーフ時は false）
+//+++++++++++++++++++++++++++++++++++++++++++++++
+bool drive_queue_push(const drive_cmd_t *cmd) {
+    drive_queue_slot_t slot;
 
+    slot.cmd = *cmd;
+    slot.profile = NULL;
+    if (cmd->type == DRIVE_CMD_TURN) {
+        // run() は drive_reset_before_run() で表を作ってから積むので、積んだ旋回の表は上書きされない
+        slot.profile = turn_profile_lookup(cmd->angle_deg, cmd->alpha_deg_s2);
+        if (slot.profile != NULL && slot.profile->n_total == 0u) {
+            slot.profile = NULL;
+        }
+    }
+
+    const uint8_t next = (uint8_t)((s_dq_head + 1u) & DRIVE_QUEUE_MASK);
+    while (next == s_dq_tail) {
+        if (MF.FLAG.FAILED || !MF.FLAG.RUNNING) {
+            return false;
+        }
         background_replan_tick();
     }
+    s_dq[s_dq_head] = slot;
+    __DMB(); // s_dq は volatile でないので、スロットを書き終えてから割り込みへ公開する
+    s_dq_head = next;
+    return true;
+}
+
+bool drive_queue_wait_idle(void) {
+    while (s_dq_busy || !drive_queue_empty()) {
+        if (MF.FLAG.FAILED || !MF.FLAG.RUNNING) {
+            return false;
+        }
+        background_replan_tick();
+    }
+    return !MF.FLAG.FAILED;
+}
+
+void drive_queue_get_status(drive_queue_status_t *st) {
+    st->pending = (uint8_t)((s_dq_head - s_dq_tail) & DRIVE_QUEUE_MASK);
+    st->busy = s_dq_busy;
+    st->started = s_dq_started;
+    st->type = s_dq_run.cmd.type;
+    st->tag = s_dq_run.cmd.tag;
+    st->turn_skip = s_dq_turn_skip;
+    st->underrun_ms = s_dq_underrun_ms;
 }
 
 /*==========================================================
@@ -1849,6 +2193,10 @@ void drive_reset_before_run(void) {
     s_fail_turn_angle_expected_dir = 0;
     s_failsafe_emergency_latched = 0;
 
+    // モードのパラメータは適用済みなので、ここで旋回プロファイル表を作る
+    drive_compile_turn_profiles();
+    drive_queue_reset();
+
     MF.FLAG.OVERRIDE = 0;
     MF.FLAG.FAILED = 0;
     MF.FLAG.CTRL = 0;
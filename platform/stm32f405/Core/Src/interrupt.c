@@ -295,6 +295,12 @@ void HAL_TIM_PeriodElapsedCallback(TIM_HandleTypeDef *htim) {
             wall_PID();
             diagonal_CTRL();
 
+            // 走行コマンドキュー（区間の切り替えはこの tick の積算の前に行う）
+            drive_queue_tick();
+
+            // 旋回プロファイルの表引き（旋回中のみ）
+            drive_turn_profile_tick();
+
             // 目標値の積算計算
             calculate_translation();
             calculate_rotation();
@@ -2,6 +2,7 @@
 #include "interrupt.h"
 #include "logging.h"
 #include "build_info.h"
+#include "trace.h"
 #include "stdio.h"
 
 // 現在のログプロファイル（取得内容の切替）
@@ -29,10 +30,22 @@ static void log_print_mm_columns(const char *cols) {
     printf("#mm_columns=%s\n", cols);
 }
 
+// CSV 出力中は送信リングが満杯でも破棄せずに待ち、最後に送出完了まで待つ
+static bool log_dump_begin(void) {
+    return trace_set_lossless(true);
+}
+
+static void log_dump_end(bool prev_lossless) {
+    fflush(stdout);
+    (void)trace_flush(NIGHTFALL_TRACE_FLUSH_TIMEOUT_MS);
+    (void)trace_set_lossless(prev_lossless);
+}
+
 void log_set_profile(LogProfile profile) { s_log_profile = profile; }
 
 // 速度ログ（log_buffer）をCSV出力
 void log_print_velocity_all(void) {
+    bool prev_lossless = log_dump_begin();
     printf("=== Micromouse Log Data (CSV Format, VELOCITY) ===\n");
     printf("Total entries: %d\n", log_buffer.count);
     printf("CSV Format: timestamp,param1,param2,param3,param4,param5,param6,param7\n");
@@ -59,9 +72,11 @@ void log_print_velocity_all(void) {
 
     printf("--- CSV Data End ---\n");
     printf("=== End of Log ===\n");
+    log_dump_end(prev_lossless);
 }
 
 void log_print_noise_all(void) {
+    bool prev_lossless = log_dump_begin();
     printf("=== Micromouse Log Data (CSV Format, NOISE) ===\n");
     printf("Total entries: %d\n", log_buffer.count);
     printf("CSV Format: timestamp,param1,param2,param3,param4,param5,param6,param7\n");
@@ -88,10 +103,12 @@ void log_print_noise_all(void) {
 
     printf("--- CSV Data End ---\n");
     printf("=== End of Log ===\n");
+    log_dump_end(prev_lossless);
 }
 
 // 距離ログ（log_buffer2）をCSV出力
 void log_print_distance_all(void) {
+    bool prev_lossless = log_dump_begin();
     printf("=== Micromouse Log Data (CSV Format, DISTANCE) ===\n");
     printf("Total entries: %d\n", log_buffer2.count);
     printf("CSV Format: timestamp,param1,param2,param3,param4,param5,param6,param7\n");
@@ -118,10 +135,12 @@ void log_print_distance_all(void) {
 
     printf("--- CSV Data End ---\n");
     printf("=== End of Log ===\n");
+    log_dump_end(prev_lossless);
 }
 
 // 角速度ログ（log_buffer）をCSV出力
 void log_print_omega_all(void) {
+    bool prev_lossless = log_dump_begin();
     printf("=== Micromouse Log Data (CSV Format, OMEGA) ===\n");
     printf("Total entries: %d\n", log_buffer.count);
     printf("CSV Format: timestamp,param1,param2,param3,param4,param5,param6,param7\n");
@@ -148,10 +167,12 @@ void log_print_omega_all(void) {
 
     printf("--- CSV Data End ---\n");
     printf("=== End of Log ===\n");
+    log_dump_end(prev_lossless);
 }
 
 // 角度ログ（log_buffer2）をCSV出力
 void log_print_angle_all(void) {
+    bool prev_lossless = log_dump_begin();
     printf("=== Micromouse Log Data (CSV Format, ANGLE) ===\n");
     printf("Total entries: %d\n", log_buffer2.count);
     printf("CSV Format: timestamp,param1,param2,param3,param4,param5,param6,param7\n");
@@ -178,6 +199,7 @@ void log_print_angle_all(void) {
 
     printf("--- CSV Data End ---\n");
     printf("=== End of Log ===\n");
+    log_dump_end(prev_lossless);
 }
 
 LogProfile log_get_profile(void) { return s_log_profile; }
@@ -431,6 +453,7 @@ void log_add_entry(uint16_t index, float target_omega, float actual_omega,
  * @brief ログデータをシリアルポートに出力する（micromouse_log_visualizer用CSV形式）
  */
 void log_print_all(void) {
+    bool prev_lossless = log_dump_begin();
     printf("=== Micromouse Log Data (CSV Format) ===\n");
     printf("Total entries: %d\n", log_buffer.count);
     printf("CSV Format: timestamp,target_omega,actual_omega,p_term_omega,i_term_omega,d_term_omega,motor_out_r,motor_out_l\n");
@@ -468,12 +491,14 @@ void log_print_all(void) {
     
     printf("--- CSV Data End ---\n");
     printf("=== End of Log ===\n");
+    log_dump_end(prev_lossless);
 }
 
 /**
  * @brief ログデータを純粋なCSV形式で出力する（可視化ツール貼り付け用）
  */
 void log_print_csv_only(void) {
+    bool prev_lossless = log_dump_begin();
     // 純粋なCSVデータのみを出力（説明行なし）
     // 可視化ツールのテキストエリアに直接貼り付け可能
     
@@ -496,4 +521,5 @@ void log_print_csv_only(void) {
                entry->motor_out_r,
                entry->motor_out_l);
     }
+    log_dump_end(prev_lossless);
 }
@@ -32,6 +32,7 @@
 #include "mode5.h"
 #include "nvm_identity.h"
 #include "nvm_params.h"
+#include "trace.h"
 
 /* Some build configurations missed the prototype; ensure it's visible */
 void mode5(void);
@@ -153,6 +154,7 @@ int main(void)
   MX_TIM1_Init();
   MX_TIM6_Init();
   /* USER CODE BEGIN 2 */
+  trace_init(); // printf を USART1 TX DMA のリング送出に切り替える
 
     if (g_boot_identity_status == NVM_STATUS_OK) {
         printf("[Boot] ID family=%lu board=%lu rev=%u.%u unit=%lu cap=0x%08lX\n",
@@ -0,0 +1,110 @@
+/*
+ * maze_bitboard.c
+ *
+ * 壁の行ビットボードとビット並列 BFS（search.c の make_smap()、F413 の探索ステップから利用）
+ * HAL に依存しないため tools/solver_host でも同じソースをビルドして検証する。
+ */
+
+#include "maze_bitboard.h"
+
+#include <stddef.h>
+
+// cells != NULL なら各区画の壁 4bit も cells[y * MAZE_SIZE + x] へ書く（step_map.c の全面再構築用）
+static inline void build_rows(maze_bitboard_t *bb, uint16_t map[MAZE_SIZE][MAZE_SIZE], uint8_t shift,
+                              uint8_t *cells) {
+    for (uint8_t y = 0; y < MAZE_SIZE; y++) {
+        maze_row_t n = 0;
+        maze_row_t e = 0;
+        maze_row_t s = 0;
+        maze_row_t w = 0;
+        for (uint8_t x = 0; x < MAZE_SIZE; x++) {
+            const maze_row_t cell = (maze_row_t)((map[y][x] >> shift) & 0x0f);
+            if (cells != NULL) {
+                cells[y * MAZE_SIZE + x] = (uint8_t)cell;
+            }
+            n |= ((cell >> 3) & 1u) << x;
+            e |= ((cell >> 2) & 1u) << x;
+            s |= ((cell >> 1) & 1u) << x;
+            w |= (cell & 1u) << x;
+        }
+        bb->wall[MAZE_BITBOARD_N][y] = n;
+        bb->wall[MAZE_BITBOARD_E][y] = e;
+        bb->wall[MAZE_BITBOARD_S][y] = s;
+        bb->wall[MAZE_BITBOARD_W][y] = w;
+    }
+}
+
+void maze_bitboard_build(maze_bitboard_t *bb, uint16_t map[MAZE_SIZE][MAZE_SIZE], uint8_t shift) {
+    build_rows(bb, map, shift, NULL);
+}
+
+void maze_bitboard_build_cells(maze_bitboard_t *bb, uint16_t map[MAZE_SIZE][MAZE_SIZE], uint8_t shift,
+                               uint8_t cells[MAZE_SIZE * MAZE_SIZE]) {
+    build_rows(bb, map, shift, cells);
+}
+
+void maze_bitboard_update_cell(maze_bitboard_t *bb, uint16_t map[MAZE_SIZE][MAZE_SIZE], uint8_t shift,
+                               uint8_t x, uint8_t y) {
+    if (x >= MAZE_SIZE || y >= MAZE_SIZE) {
+        return;
+    }
+    const maze_row_t cell = (maze_row_t)((map[y][x] >> shift) & 0x0f);
+    const maze_row_t bit = (maze_row_t)1u << x;
+    bb->wall[MAZE_BITBOARD_N][y] = (bb->wall[MAZE_BITBOARD_N][y] & ~bit) | (((cell >> 3) & 1u) << x);
+    bb->wall[MAZE_BITBOARD_E][y] = (bb->wall[MAZE_BITBOARD_E][y] & ~bit) | (((cell >> 2) & 1u) << x);
+    bb->wall[MAZE_BITBOARD_S][y] = (bb->wall[MAZE_BITBOARD_S][y] & ~bit) | (((cell >> 1) & 1u) << x);
+    bb->wall[MAZE_BITBOARD_W][y] = (bb->wall[MAZE_BITBOARD_W][y] & ~bit) | ((cell & 1u) << x);
+}
+
+// 行 y の立っているビットの区画に歩数 step を書く
+static inline void write_row(uint16_t row[MAZE_SIZE], maze_row_t bits, uint16_t step) {
+    while (bits != 0) {
+        row[__builtin_ctz(bits)] = step;
+        bits &= bits - 1u;
+    }
+}
+
+uint16_t maze_bitboard_flood(const maze_bitboard_t *bb, const maze_row_t seed[MAZE_SIZE],
+                             uint16_t smap[MAZE_SIZE][MAZE_SIZE], uint8_t tx, uint8_t ty) {
+    maze_row_t reached[MAZE_SIZE]; // 歩数を書いた区画
+    maze_row_t front[MAZE_SIZE];   // 直前に書いた歩数の区画（波面）
+    maze_row_t next[MAZE_SIZE];
+    const bool has_target = (tx < MAZE_SIZE) && (ty < MAZE_SIZE);
+    const maze_row_t target_bit = has_target ? ((maze_row_t)1u << tx) : 0;
+    maze_row_t any = 0;
+    uint16_t step = 0;
+
+    for (uint8_t y = 0; y < MAZE_SIZE; y++) {
+        for (uint8_t x = 0; x < MAZE_SIZE; x++) {
+            smap[y][x] = MAZE_BITBOARD_UNREACHED;
+        }
+        front[y] = seed[y] & MAZE_BITBOARD_ROW_MASK;
+        reached[y] = front[y];
+        any |= front[y];
+        write_row(smap[y], front[y], 0);
+    }
+
+    while (any != 0 && !(has_target && (reached[ty] & target_bit))) {
+        //====波面を 4 方向へ 1 歩広げる（u 側の壁ビットで通過可否を判定）====
+        for (uint8_t y = 0; y < MAZE_SIZE; y++) {
+            next[y] = ((front[y] & ~bb->wall[MAZE_BITBOARD_E][y]) << 1) |
+                      ((front[y] & ~bb->wall[MAZE_BITBOARD_W][y]) >> 1);
+        }
+        for (uint8_t y = 0; y + 1 < MAZE_SIZE; y++) {
+            next[y + 1] |= front[y] & ~bb->wall[MAZE_BITBOARD_N][y];
+            next[y] |= front[y + 1] & ~bb->wall[MAZE_BITBOARD_S][y + 1];
+        }
+
+        //====未記入の区画だけを次の波面にする====
+        step++;
+        any = 0;
+        for (uint8_t y = 0; y < MAZE_SIZE; y++) {
+            front[y] = next[y] & ~reached[y] & MAZE_BITBOARD_ROW_MASK;
+            reached[y] |= front[y];
+            any |= front[y];
+            write_row(smap[y], front[y], step);
+        }
+    }
+
+    return has_target ? smap[ty][tx] : (uint16_t)MAZE_BITBOARD_UNREACHED;
+}
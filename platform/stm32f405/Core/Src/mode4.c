@@ -15,6 +15,7 @@ static void apply_case_params_mode4_idx(int idx) {
     const ShortestRunCaseParams_t *c = &shortestRunCaseParamsMode4[idx];
     acceleration_straight = c->acceleration_straight;
     acceleration_straight_dash = c->acceleration_straight_dash;
+    jerk_straight              = c->jerk_straight;
     velocity_straight = c->velocity_straight;
     acceleration_d_straight = c->acceleration_d_straight;
     acceleration_d_straight_dash = c->acceleration_d_straight_dash;
@@ -15,6 +15,7 @@ static void apply_case_params_mode5_idx(int idx) {
     const ShortestRunCaseParams_t *c = &shortestRunCaseParamsMode5[idx];
     acceleration_straight = c->acceleration_straight;
     acceleration_straight_dash = c->acceleration_straight_dash;
+    jerk_straight              = c->jerk_straight;
     velocity_straight = c->velocity_straight;
     // mode5 のケースでは対角直線パラメータは未使用
     kp_wall = c->kp_wall;
@@ -17,6 +17,7 @@ static void apply_case_params_mode6_idx(int idx) {
     // 直線（caseごと）
     acceleration_straight      = pc->acceleration_straight;
     acceleration_straight_dash = pc->acceleration_straight_dash;
+    jerk_straight              = pc->jerk_straight;
     velocity_straight          = pc->velocity_straight;
     kp_wall                    = pc->kp_wall;
     // 斜め直線（caseごと）
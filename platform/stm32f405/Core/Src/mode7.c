@@ -19,6 +19,7 @@ static void apply_case_params_mode7_idx(int idx) {
 
     acceleration_straight      = pc->acceleration_straight;
     acceleration_straight_dash = pc->acceleration_straight_dash;
+    jerk_straight              = pc->jerk_straight;
     velocity_straight          = pc->velocity_straight;
     kp_wall                    = pc->kp_wall;
 
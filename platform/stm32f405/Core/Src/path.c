@@ -7,6 +7,348 @@
 
 #include "global.h"
 
+#include <string.h>
+
+//====走行パスコンパイラ====
+// 各段は従来の段ごとの書き換え（下の PATH_ENABLE_LEGACY_PASSES）の 1 関数 1 ループに対応し、
+// path[i-1]（w[0]）・path[i+1]（w[2]）・path[i+2]（w[3]）の参照と、
+// 直前の出力 convertedPath[j-1]（held）の書き換えを窓の中で同じ順に行う。
+
+static inline bool is_straight(uint16_t v) { return v > 200U && v < 300U; }
+static inline bool is_small_r(uint16_t v) { return v >= 300U && v < 400U; }
+static inline bool is_small_l(uint16_t v) { return v >= 400U && v < 500U; }
+
+static void stage_push(path_compiler_t *pc, uint8_t id, uint16_t v);
+
+// 出力: 先頭が大回り（501/601）なら normalizeStartLargeTurnException() と同じく
+// [S1, 小回り, 直進+1 or S1, ...] に置き換えて書く（置き換え後の長さが収まらなければ書き戻す）
+static void out_unshift(path_compiler_t *pc) {
+    const uint16_t n = pc->out_num - 1U; // 書き込み済みの要素数（置き換え前）
+    const bool has_straight = (pc->out_shift == 1U);
+    path[0] = pc->out_first;
+    for (uint16_t k = 1U; k < n; k++) {
+        path[k] = path[k + pc->out_shift];
+    }
+    if (has_straight) {
+        path[1] -= 1U;
+    }
+    pc->out_first = 0U;
+    pc->out_shift = 0U;
+}
+
+static void out_put(path_compiler_t *pc, uint16_t v) {
+    const uint16_t k = pc->out_num++;
+
+    if (k == 0U && (v == 501U || v == 601U)) {
+        pc->out_first = v; // 次の要素が直進かどうかで置き換えが決まる
+        return;
+    }
+    if (k == 1U && pc->out_first != 0U) {
+        path[0] = 201U;
+        path[1] = (pc->out_first == 501U) ? TURN_R : TURN_L;
+        if (is_straight(v)) {
+            path[2] = v + 1U;
+            pc->out_shift = 1U;
+        } else {
+            path[2] = 201U;
+            path[3] = v;
+            pc->out_shift = 2U;
+        }
+        return;
+    }
+    if (pc->out_shift != 0U && (uint32_t)k + 1U >= (uint32_t)ROUTE_MAX_LEN - pc->out_shift) {
+        out_unshift(pc); // 従来も空きが足りなければ置き換えない
+    }
+    const uint32_t pos = (uint32_t)k + pc->out_shift;
+    if (pos < ROUTE_MAX_LEN) {
+        path[pos] = v;
+    }
+}
+
+// 斜め直進の連結（1000 以上の連続を 1 要素にまとめる）
+static void diag_merge_push(path_compiler_t *pc, uint16_t v) {
+    if (!pc->diag_active) {
+        out_put(pc, v);
+        return;
+    }
+    if (v >= 1000U) {
+        if (!pc->diag_in_seq) {
+            pc->diag_in_seq = true;
+            pc->diag_sum = 0U;
+        }
+        pc->diag_sum += v - 1000U;
+    } else {
+        if (pc->diag_in_seq) {
+            out_put(pc, pc->diag_sum + 1000U);
+            pc->diag_in_seq = false;
+        }
+        out_put(pc, v);
+    }
+}
+
+static void stage_forward(path_compiler_t *pc, uint8_t id, uint16_t v) {
+    if (id == PATH_STAGE_LARGE && v == STRAIGHT) {
+        return; // 大回りで前後を半区画ずつ削って 0 になった直進は消す
+    }
+    stage_push(pc, id + 1U, v);
+}
+
+static void stage_emit(path_compiler_t *pc, uint8_t id, uint16_t v) {
+    path_stage_t *s = &pc->stage[id];
+    if (s->has_held) {
+        stage_forward(pc, id, s->held);
+    }
+    s->held = v;
+    s->has_held = true;
+}
+
+// 大回り（convertLTurn）
+static void stage_large(path_compiler_t *pc, path_stage_t *s) {
+    uint16_t *w = s->w;
+    uint16_t code = 0U;
+
+    if (w[1] == TURN_R && w[2] == TURN_R) {
+        if (is_straight(w[0]) && is_straight(w[3])) {
+            code = 502U;
+            w[3] -= 1U;
+            s->skip = 1U;
+        }
+    } else if (w[1] == TURN_L && w[2] == TURN_L) {
+        if (is_straight(w[0]) && is_straight(w[3])) {
+            code = 602U;
+            w[3] -= 1U;
+            s->skip = 1U;
+        }
+    } else if (w[1] == TURN_R) {
+        if (is_straight(w[0]) && is_straight(w[2])) {
+            code = 501U;
+            w[2] -= 1U;
+        }
+    } else if (w[1] == TURN_L) {
+        if (is_straight(w[0]) && is_straight(w[2])) {
+            code = 601U;
+            w[2] -= 1U;
+        }
+    }
+
+    if (code != 0U) {
+        s->held -= 1U; // 前後の直進を半区画ずつ縮める
+        stage_emit(pc, PATH_STAGE_LARGE, code);
+    } else {
+        stage_emit(pc, PATH_STAGE_LARGE, w[1]);
+    }
+}
+
+// 斜め入り（convertDiagonal の小回りの開始）
+static void stage_diag_in(path_compiler_t *pc, path_stage_t *s) {
+    const uint16_t *w = s->w;
+    uint16_t code = 0U;
+
+    if (is_small_r(w[1]) && w[0] < 300U) {
+        code = is_small_r(w[2]) ? 901U : 701U;
+    } else if (is_small_l(w[1]) && w[0] < 300U) {
+        code = is_small_l(w[2]) ? 902U : 702U;
+    }
+
+    if (code == 0U) {
+        stage_emit(pc, PATH_STAGE_DIAG_IN, w[1]);
+        return;
+    }
+    if ((int)w[0] - 200 > 1) {
+        s->held -= 1U; // 直前の直進を半区画縮める（S1 は保持）
+    }
+    stage_emit(pc, PATH_STAGE_DIAG_IN, code);
+    if (code >= 900U) {
+        s->skip = 1U; // 次の小回りとまとめた
+    }
+}
+
+// 斜め出（convertDiagonal の小回りの終了）
+static void stage_diag_out(path_compiler_t *pc, path_stage_t *s) {
+    const uint16_t *w = s->w;
+    const bool right = is_small_r(w[1]);
+
+    if (!(right || is_small_l(w[1])) || !(w[2] < 300U || w[2] > 500U)) {
+        stage_emit(pc, PATH_STAGE_DIAG_OUT, w[1]);
+        return;
+    }
+
+    // 直後の直進を半区画縮める（S1 は保持）
+    const uint16_t after = ((int)w[2] - 200 > 1) ? (uint16_t)(w[2] - 1U) : 201U;
+    if (right ? is_small_r(w[0]) : is_small_l(w[0])) {
+        // 小回り x2: 直前に出した小回りを 135° 出に上書き
+        s->held = right ? 903U : 904U;
+        stage_emit(pc, PATH_STAGE_DIAG_OUT, after);
+        s->skip = 1U;
+        return;
+    }
+    stage_emit(pc, PATH_STAGE_DIAG_OUT, right ? 703U : 704U);
+    if ((int)w[2] - 200 <= 1 && (w[3] == 701U || w[3] == 702U)) {
+        // [45°出, S1, 45°入] は S1 を挟まずに連結
+        stage_emit(pc, PATH_STAGE_DIAG_OUT, w[3]);
+        s->skip = 2U;
+    } else {
+        stage_emit(pc, PATH_STAGE_DIAG_OUT, after);
+        s->skip = 1U;
+    }
+}
+
+// V90 と、残った小回りの斜め直進化
+static void stage_diag_v90(path_compiler_t *pc, path_stage_t *s) {
+    const uint16_t *w = s->w;
+
+    if (is_small_r(w[1]) && is_small_r(w[2])) {
+        stage_emit(pc, PATH_STAGE_DIAG_V90, 801U);
+        s->skip = 1U;
+    } else if (is_small_l(w[1]) && is_small_l(w[2])) {
+        stage_emit(pc, PATH_STAGE_DIAG_V90, 802U);
+        s->skip = 1U;
+    } else {
+        stage_emit(pc, PATH_STAGE_DIAG_V90, (is_small_r(w[1]) || is_small_l(w[1])) ? 1001U : w[1]);
+    }
+}
+
+static void stage_push(path_compiler_t *pc, uint8_t id, uint16_t v) {
+    if (id >= PATH_STAGE_NUM) {
+        diag_merge_push(pc, v);
+        return;
+    }
+    path_stage_t *s = &pc->stage[id];
+    if (!s->active) {
+        stage_push(pc, id + 1U, v);
+        return;
+    }
+    if (s->done) {
+        return;
+    }
+
+    s->w[0] = s->w[1];
+    s->w[1] = s->w[2];
+    s->w[2] = s->w[3];
+    s->w[3] = v;
+    if (s->fill < 3U) {
+        s->fill++;
+        if (s->fill < 3U) {
+            return; // 先読み 2 要素が揃うまで待つ
+        }
+    }
+    if (s->skip > 0U) {
+        s->skip--;
+        return;
+    }
+    if (s->w[1] == 0U) {
+        s->done = true;
+        return;
+    }
+
+    switch (id) {
+    case PATH_STAGE_LARGE:
+        stage_large(pc, s);
+        break;
+    case PATH_STAGE_DIAG_IN:
+        stage_diag_in(pc, s);
+        break;
+    case PATH_STAGE_DIAG_OUT:
+        stage_diag_out(pc, s);
+        break;
+    default:
+        stage_diag_v90(pc, s);
+        break;
+    }
+}
+
+// 直進まとめ（simplifyPath）: 直進は区画数 x2 の半区画数にし、先頭要素は半区画短くする
+static void run_flush(path_compiler_t *pc) {
+    uint16_t v = (pc->run_action == STRAIGHT) ? (uint16_t)(STRAIGHT + pc->run_count * 2U) : pc->run_action;
+    if (pc->run_first) {
+        v -= 1U;
+        pc->run_first = false;
+    }
+    stage_push(pc, PATH_STAGE_LARGE, v);
+}
+
+void path_compile_begin(path_compiler_t *pc, int path_type) {
+    memset(pc, 0, sizeof(*pc));
+    pc->run_first = true;
+    pc->stage[PATH_STAGE_LARGE].active = (path_type > 0);
+    for (uint8_t id = PATH_STAGE_DIAG_IN; id < PATH_STAGE_NUM; id++) {
+        pc->stage[id].active = (path_type > 1);
+    }
+    pc->diag_active = (path_type > 1);
+}
+
+void path_compile_push(path_compiler_t *pc, uint16_t move) {
+    if (pc->run_action == 0U) {
+        pc->run_action = move;
+        pc->run_count = 1U;
+    } else if (move == pc->run_action && move == STRAIGHT) {
+        pc->run_count++;
+    } else {
+        run_flush(pc);
+        pc->run_action = move;
+        pc->run_count = 1U;
+    }
+}
+
+uint16_t path_compile_end(path_compiler_t *pc) {
+    run_flush(pc);
+
+    // 上流の段から順に、終端（0）を流して窓と直前の出力を出し切る
+    for (uint8_t id = 0U; id < PATH_STAGE_NUM; id++) {
+        path_stage_t *s = &pc->stage[id];
+        if (!s->active) {
+            continue;
+        }
+        for (uint8_t n = 0U; !s->done && n < 8U; n++) {
+            stage_push(pc, id, 0U);
+        }
+        if (s->has_held) {
+            s->has_held = false;
+            stage_forward(pc, id, s->held);
+        }
+    }
+    // 末尾まで続いた斜め直進は従来どおり出力しない（終端で連続が閉じない）
+
+    if (pc->out_first != 0U && pc->out_num == 1U) {
+        // 先頭の大回りだけの経路: 直後に直進が無いので [S1, 小回り, S1]
+        if (1 < ROUTE_MAX_LEN - 2) {
+            path[0] = 201U;
+            path[1] = (pc->out_first == 501U) ? TURN_R : TURN_L;
+            path[2] = 201U;
+            pc->out_shift = 2U;
+        } else {
+            path[0] = pc->out_first;
+        }
+    }
+
+    uint32_t len = (uint32_t)pc->out_num + pc->out_shift;
+    if (len > ROUTE_MAX_LEN) {
+        len = ROUTE_MAX_LEN;
+    }
+    for (uint32_t k = len; k < ROUTE_MAX_LEN; k++) {
+        path[k] = 0U;
+    }
+    return (uint16_t)len;
+}
+
+#if PATH_ENABLE_LEGACY_PASSES
+//====従来の段ごとの書き換え（照合用）====
+
+void path_compile_legacy(const uint16_t *moves, uint16_t n, int path_type) {
+    for (int i = 0; i < ROUTE_MAX_LEN; i++) {
+        path[i] = (i < n) ? moves[i] : 0U;
+    }
+    simplifyPath();
+    if (path_type > 0) {
+        convertLTurn();
+    }
+    if (path_type > 1) {
+        convertDiagonal();
+    }
+    normalizeStartLargeTurnException();
+}
+
+
 void simplifyPath(void) {
     static uint16_t simplifiedPath[ROUTE_MAX_LEN]; // 結果を格納するための配列
     int currentIndex = 0; // simplifiedPathにおける現在のインデックス
@@ -551,5 +893,6 @@ void convertDiagonal(void) {
     }
     printf("\n");
 }
+#endif
 
 // makePath()は削除済み - 経路導出はsolver_build_path()を使用
@@ -0,0 +1,491 @@
+/*
+ * path_speed_plan.c
+ *
+ * 最短走行の経路全体の速度計画（F413 の経路走行から利用）
+ * HAL に依存しないため tools/solver_host でも同じソースをビルドして検証する。
+ */
+
+#include "path_speed_plan.h"
+#include "turn_profile.h"
+
+#include <math.h>
+#include <params.h>
+#include <stddef.h>
+
+#ifndef TURN_OMEGA_PROFILE_ROUNDING_SCALE
+#define TURN_OMEGA_PROFILE_ROUNDING_SCALE 1.0f
+#endif
+
+#define PATH_SPEED_TURN_ANGLE_DEFAULT 90.0f    // 角度未設定のターン
+#define PATH_SPEED_TURN_ALPHA_DEFAULT 10000.0f // 角加速度未設定のターン
+#define PATH_SPEED_PEAK_ITER 24                // ピーク速度の二分探索回数
+#define PATH_SPEED_LEN_EPS_MM 0.01f            // 距離比較の丸め誤差の許容
+
+bool path_speed_turn_from_code(uint16_t code, const ShortestRunModeParams_t *p,
+                               path_speed_turn_t *turn) {
+    float angle;
+    bool right;
+
+    if (p == NULL || turn == NULL) {
+        return false;
+    }
+    turn->front_wall_entry = false;
+    turn->wall_control_offsets = false;
+
+    switch (code) {
+    case 300: // 小回り90°
+    case 400:
+        angle = p->angle_turn_90;
+        turn->accum_angle_deg = 90.0f;
+        turn->alpha_deg_s2 = p->alpha_turn90;
+        turn->velocity_mm_s = p->velocity_turn90;
+        turn->dist_in_mm = p->dist_offset_in;
+        turn->dist_out_mm = p->dist_offset_out;
+        turn->front_wall_entry = true;
+        turn->wall_control_offsets = true;
+        right = (code == 300);
+        break;
+    case 501: // 大回り90°
+    case 601:
+        angle = p->angle_l_turn_90;
+        turn->accum_angle_deg = 90.0f;
+        turn->alpha_deg_s2 = p->alpha_l_turn_90;
+        turn->velocity_mm_s = p->velocity_l_turn_90;
+        turn->dist_in_mm = p->dist_l_turn_in_90;
+        turn->dist_out_mm = p->dist_l_turn_out_90;
+        turn->wall_control_offsets = true;
+        right = (code == 501);
+        break;
+    case 502: // 大回り180°
+    case 602:
+        angle = p->angle_l_turn_180;
+        turn->accum_angle_deg = 180.0f;
+        turn->alpha_deg_s2 = p->alpha_l_turn_180;
+        turn->velocity_mm_s = p->velocity_l_turn_180;
+        turn->dist_in_mm = p->dist_l_turn_in_180;
+        turn->dist_out_mm = p->dist_l_turn_out_180;
+        turn->wall_control_offsets = true;
+        right = (code == 502);
+        break;
+    case 701: // 45°入り
+    case 702:
+        angle = p->angle_turn45in;
+        turn->accum_angle_deg = 45.0f;
+        turn->alpha_deg_s2 = p->alpha_turn45in;
+        turn->velocity_mm_s = p->velocity_turn45in;
+        turn->dist_in_mm = p->dist_turn45in_in;
+        turn->dist_out_mm = p->dist_turn45in_out;
+        right = (code == 701);
+        break;
+    case 703: // 45°出
+    case 704:
+        angle = p->angle_turn45out;
+        turn->accum_angle_deg = 45.0f;
+        turn->alpha_deg_s2 = p->alpha_turn45out;
+        turn->velocity_mm_s = p->velocity_turn45out;
+        turn->dist_in_mm = p->dist_turn45out_in;
+        turn->dist_out_mm = p->dist_turn45out_out;
+        right = (code == 703);
+        break;
+    case 801: // V90°
+    case 802:
+        angle = p->angle_turnV90;
+        turn->accum_angle_deg = 90.0f;
+        turn->alpha_deg_s2 = p->alpha_turnV90;
+        turn->velocity_mm_s = p->velocity_turnV90;
+        turn->dist_in_mm = p->dist_turnV90_in;
+        turn->dist_out_mm = p->dist_turnV90_out;
+        right = (code == 801);
+        break;
+    case 901: // 135°入り
+    case 902:
+        angle = p->angle_turn135in;
+        turn->accum_angle_deg = 135.0f;
+        turn->alpha_deg_s2 = p->alpha_turn135in;
+        turn->velocity_mm_s = p->velocity_turn135in;
+        turn->dist_in_mm = p->dist_turn135in_in;
+        turn->dist_out_mm = p->dist_turn135in_out;
+        right = (code == 901);
+        break;
+    case 903: // 135°出
+    case 904:
+        angle = p->angle_turn135out;
+        turn->accum_angle_deg = 135.0f;
+        turn->alpha_deg_s2 = p->alpha_turn135out;
+        turn->velocity_mm_s = p->velocity_turn135out;
+        turn->dist_in_mm = p->dist_turn135out_in;
+        turn->dist_out_mm = p->dist_turn135out_out;
+        right = (code == 903);
+        break;
+    default:
+        return false;
+    }
+
+    if (angle <= 0.0f) {
+        angle = PATH_SPEED_TURN_ANGLE_DEFAULT;
+    }
+    if (turn->alpha_deg_s2 <= 0.0f) {
+        turn->alpha_deg_s2 = PATH_SPEED_TURN_ALPHA_DEFAULT;
+    }
+    turn->signed_angle_deg = right ? -fabsf(angle) : fabsf(angle);
+    turn->velocity_mm_s = fabsf(turn->velocity_mm_s);
+    return true;
+}
+
+//====加減速モデル====
+static void accel_model(path_speed_accel_t *m, float v_max, float accel_low, float accel_high,
+                        float v_switch) {
+    m->v_max = v_max;
+    if (v_switch > 0.0f && v_switch < v_max && accel_low > 0.0f && accel_high > 0.0f) {
+        m->accel_low = accel_low;
+        m->accel_high = accel_high;
+        m->v_switch = v_switch;
+    } else {
+        const float a = (accel_high > 0.0f) ? accel_high : accel_low;
+        m->accel_low = a;
+        m->accel_high = a;
+        m->v_switch = 0.0f;
+    }
+}
+
+static inline float ramp_piece(float v_lo, float v_hi, float a) {
+    return ((v_hi * v_hi) - (v_lo * v_lo)) / (2.0f * a);
+}
+
+// va と vb の間の加速（減速）に要する距離（加速度 0 なら速度差があれば無限大）
+static float ramp_dist(const path_speed_accel_t *m, float va, float vb) {
+    const float lo = (va < vb) ? va : vb;
+    const float hi = (va < vb) ? vb : va;
+
+    if (hi <= lo) {
+        return 0.0f;
+    }
+    if (m->accel_high <= 0.0f) {
+        return INFINITY;
+    }
+    if (m->v_switch <= 0.0f || hi <= m->v_switch) {
+        return ramp_piece(lo, hi, (m->v_switch > 0.0f) ? m->accel_low : m->accel_high);
+    }
+    if (lo >= m->v_switch) {
+        return ramp_piece(lo, hi, m->accel_high);
+    }
+    return ramp_piece(lo, m->v_switch, m->accel_low) + ramp_piece(m->v_switch, hi, m->accel_high);
+}
+
+// 速度 v0 から距離 len で加速して到達できる速度（上限なし）
+static float ramp_reach(const path_speed_accel_t *m, float v0, float len) {
+    if (m->accel_high <= 0.0f || len <= 0.0f) {
+        return v0;
+    }
+    if (m->v_switch > 0.0f && v0 < m->v_switch) {
+        const float d1 = ramp_piece(v0, m->v_switch, m->accel_low);
+        if (len <= d1) {
+            return sqrtf((v0 * v0) + (2.0f * m->accel_low * len));
+        }
+        return sqrtf((m->v_switch * m->v_switch) + (2.0f * m->accel_high * (len - d1)));
+    }
+    return sqrtf((v0 * v0) + (2.0f * m->accel_high * len));
+}
+
+static inline float piece_time(float d, float v0, float v1) {
+    const float v_sum = v0 + v1;
+    return (d > 0.0f && v_sum > 0.0f) ? (2.0f * d / v_sum) : 0.0f;
+}
+
+static const path_speed_accel_t *seg_model(const path_speed_plan_t *plan,
+                                           const path_speed_seg_t *seg) {
+    return (seg->kind == PATH_SPEED_SEG_DIAGONAL) ? &plan->diagonal : &plan->straight;
+}
+
+// 入口・出口速度から区間内で到達できる最高速度を求める
+static void solve_peak(const path_speed_accel_t *m, path_speed_seg_t *seg) {
+    const float v_in = seg->v_entry;
+    const float v_out = seg->v_exit;
+    const float v_lo = (v_in > v_out) ? v_in : v_out;
+    float v_hi = (m->v_max > v_lo) ? m->v_max : v_lo;
+
+    seg->feasible = ramp_dist(m, v_in, v_out) <= (seg->length_mm + PATH_SPEED_LEN_EPS_MM);
+    if (!seg->feasible) {
+        seg->v_peak = v_lo;
+        return;
+    }
+    if ((ramp_dist(m, v_in, v_hi) + ramp_dist(m, v_out, v_hi)) <= seg->length_mm) {
+        seg->v_peak = v_hi;
+        return;
+    }
+    float lo = v_lo;
+    for (int i = 0; i < PATH_SPEED_PEAK_ITER; i++) {
+        const float mid = 0.5f * (lo + v_hi);
+        if ((ramp_dist(m, v_in, mid) + ramp_dist(m, v_out, mid)) <= seg->length_mm) {
+            lo = mid;
+        } else {
+            v_hi = mid;
+        }
+    }
+    seg->v_peak = lo;
+}
+
+// 直線・斜め区間の速度折れ点（solve_peak() 済みの区間）
+static uint8_t seg_knots(const path_speed_accel_t *m, const path_speed_seg_t *seg,
+                         float s[PATH_SPEED_PLAN_KNOT_MAX], float v[PATH_SPEED_PLAN_KNOT_MAX]) {
+    uint8_t n = 0;
+
+#define PUSH_KNOT(s_, v_)                                                                  \
+    do {                                                                                   \
+        if (n > 0 && (s_) <= s[n - 1]) {                                                   \
+            v[n - 1] = (v_); /* 長さ 0 の区間は畳む */                                   \
+        } else {                                                                           \
+            s[n] = (s_);                                                                   \
+            v[n] = (v_);                                                                   \
+            n++;                                                                           \
+        }                                                                                  \
+    } while (0)
+
+    s[n] = 0.0f;
+    v[n] = seg->v_entry;
+    n++;
+    if (!seg->feasible) {
+        // 間に合わない区間は全長で入口→出口へ変化させる
+        s[n] = seg->length_mm;
+        v[n] = seg->v_exit;
+        return (uint8_t)(n + 1);
+    }
+
+    const float d_up = ramp_dist(m, seg->v_entry, seg->v_peak);
+    const float d_down = ramp_dist(m, seg->v_exit, seg->v_peak);
+    const float s_dec = seg->length_mm - d_down;
+
+    if (m->v_switch > 0.0f && seg->v_entry < m->v_switch && m->v_switch < seg->v_peak) {
+        PUSH_KNOT(ramp_dist(m, seg->v_entry, m->v_switch), m->v_switch);
+    }
+    PUSH_KNOT(d_up, seg->v_peak);
+    PUSH_KNOT(s_dec, seg->v_peak);
+    if (m->v_switch > 0.0f && seg->v_exit < m->v_switch && m->v_switch < seg->v_peak) {
+        PUSH_KNOT(seg->length_mm - ramp_dist(m, seg->v_exit, m->v_switch), m->v_switch);
+    }
+    PUSH_KNOT(seg->length_mm, seg->v_exit);
+#undef PUSH_KNOT
+
+    if (n < 2) {
+        s[1] = seg->length_mm;
+        v[1] = seg->v_exit;
+        n = 2;
+    }
+    return n;
+}
+
+static float seg_time(const path_speed_accel_t *m, const path_speed_seg_t *seg) {
+    float ks[PATH_SPEED_PLAN_KNOT_MAX];
+    float kv[PATH_SPEED_PLAN_KNOT_MAX];
+    const uint8_t knots = seg_knots(m, seg, ks, kv);
+    float t = 0.0f;
+
+    for (uint8_t k = 1; k < knots; k++) {
+        t += piece_time(ks[k] - ks[k - 1], kv[k - 1], kv[k]);
+    }
+    return t;
+}
+
+uint8_t path_speed_plan_knots(const path_speed_plan_t *plan, uint16_t i,
+                              float s[PATH_SPEED_PLAN_KNOT_MAX],
+                              float v[PATH_SPEED_PLAN_KNOT_MAX]) {
+    const path_speed_seg_t *seg;
+
+    if (plan == NULL || i >= plan->count) {
+        return 0;
+    }
+    seg = &plan->seg[i];
+    if (seg->kind == PATH_SPEED_SEG_TURN) {
+        return 0;
+    }
+    return seg_knots(seg_model(plan, seg), seg, s, v);
+}
+
+float path_speed_turn_time_s(const path_speed_turn_t *turn, float turn_omega_cap_deg_s) {
+    if (turn == NULL) {
+        return 0.0f;
+    }
+    return piece_time(turn->dist_in_mm + turn->dist_out_mm, turn->velocity_mm_s,
+                      turn->velocity_mm_s) +
+           turn_profile_duration_s(turn->signed_angle_deg, turn->alpha_deg_s2,
+                                   TURN_OMEGA_PROFILE_ROUNDING_SCALE, turn_omega_cap_deg_s);
+}
+
+void path_speed_accel_models(const ShortestRunModeParams_t *mode_params,
+                             const ShortestRunCaseParams_t *case_params,
+                             path_speed_accel_t *straight, path_speed_accel_t *diagonal) {
+    accel_model(straight, case_params->velocity_straight, case_params->acceleration_straight,
+                case_params->acceleration_straight_dash, mode_params->accel_switch_velocity);
+    accel_model(diagonal, case_params->velocity_d_straight, 0.0f,
+                (case_params->acceleration_d_straight_dash > 0.0f)
+                    ? case_params->acceleration_d_straight_dash
+                    : case_params->acceleration_d_straight,
+                0.0f);
+}
+
+float path_speed_run_time_s(const path_speed_accel_t *m, float length_mm, float v_entry,
+                            float v_exit) {
+    path_speed_seg_t seg;
+    float v;
+
+    if (m == NULL || length_mm <= 0.0f) {
+        return 0.0f;
+    }
+    // 届かない側の速度を下げてから台形を作る
+    v = ramp_reach(m, v_entry, length_mm);
+    if (v_exit > v) {
+        v_exit = v;
+    }
+    v = ramp_reach(m, v_exit, length_mm);
+    if (v_entry > v) {
+        v_entry = v;
+    }
+    seg.kind = PATH_SPEED_SEG_STRAIGHT;
+    seg.length_mm = length_mm;
+    seg.v_entry = v_entry;
+    seg.v_exit = v_exit;
+    solve_peak(m, &seg);
+    return seg_time(m, &seg);
+}
+
+float path_speed_knots_velocity_at(const float *s, const float *v, uint8_t knots, float s_mm) {
+    if (knots == 0) {
+        return 0.0f;
+    }
+    if (s_mm <= s[0]) {
+        return v[0];
+    }
+    for (uint8_t k = 1; k < knots; k++) {
+        if (s_mm <= s[k]) {
+            const float span = s[k] - s[k - 1];
+            const float r = (span > 0.0f) ? ((s_mm - s[k - 1]) / span) : 1.0f;
+            const float v_sq = (v[k - 1] * v[k - 1]) + (((v[k] * v[k]) - (v[k - 1] * v[k - 1])) * r);
+            return sqrtf((v_sq > 0.0f) ? v_sq : 0.0f);
+        }
+    }
+    return v[knots - 1];
+}
+
+bool path_speed_plan_build(path_speed_plan_t *plan, const uint16_t *codes,
+                           const ShortestRunModeParams_t *mode_params,
+                           const ShortestRunCaseParams_t *case_params,
+                           float turn_omega_cap_deg_s) {
+    static float s_boundary[PATH_SPEED_PLAN_MAX_SEGS + 1];
+    static bool s_pinned[PATH_SPEED_PLAN_MAX_SEGS + 1];
+    path_speed_turn_t turn;
+    uint16_t n = 0;
+
+    if (plan == NULL || codes == NULL || mode_params == NULL || case_params == NULL) {
+        return false;
+    }
+
+    path_speed_accel_models(mode_params, case_params, &plan->straight, &plan->diagonal);
+    plan->count = 0;
+    plan->infeasible = 0;
+    plan->total_time_s = 0.0f;
+    plan->total_length_mm = 0.0f;
+
+    //====区間列の展開（先頭の半端区画 + 各コード）====
+    plan->seg[0].code = 0;
+    plan->seg[0].kind = PATH_SPEED_SEG_STRAIGHT;
+    plan->seg[0].length_mm = (float)DIST_FIRST_SEC;
+    n = 1;
+    for (uint16_t i = 0; codes[i] != 0; i++) {
+        const uint16_t code = codes[i];
+        path_speed_seg_t *seg;
+
+        if (n >= PATH_SPEED_PLAN_MAX_SEGS) {
+            return false;
+        }
+        seg = &plan->seg[n];
+        seg->code = code;
+        if (code > 200 && code < 300) {
+            seg->kind = PATH_SPEED_SEG_STRAIGHT;
+            seg->length_mm = (float)(code - 200) * (float)DIST_HALF_SEC;
+        } else if (code > 1000) {
+            seg->kind = PATH_SPEED_SEG_DIAGONAL;
+            seg->length_mm = (float)(code - 1000) * (float)DIST_D_HALF_SEC;
+        } else if (path_speed_turn_from_code(code, mode_params, &turn)) {
+            seg->kind = PATH_SPEED_SEG_TURN;
+            seg->length_mm = turn.dist_in_mm + turn.dist_out_mm;
+            seg->v_entry = turn.velocity_mm_s;
+            seg->v_peak = turn.velocity_mm_s;
+            seg->v_exit = turn.velocity_mm_s;
+            seg->feasible = true;
+            seg->time_s = path_speed_turn_time_s(&turn, turn_omega_cap_deg_s);
+        } else {
+            return false;
+        }
+        n++;
+    }
+    plan->count = n;
+
+    //====境界速度の上限（b[i] は区間 i の入口、b[n] は終端）====
+    {
+        // ゴール区画の進入速度（半区画で停止できる速度）
+        float v_goal = sqrtf(fmaxf(0.0f, 2.0f * case_params->acceleration_straight *
+                                             (float)DIST_HALF_SEC));
+        if (v_goal > case_params->velocity_straight) {
+            v_goal = case_params->velocity_straight;
+        }
+        s_boundary[0] = 0.0f;
+        s_pinned[0] = true;
+        s_boundary[n] = v_goal;
+        s_pinned[n] = true;
+    }
+    for (uint16_t i = 1; i <= n; i++) {
+        const path_speed_seg_t *prev = &plan->seg[i - 1];
+        const path_speed_seg_t *next = (i < n) ? &plan->seg[i] : NULL;
+
+        if (prev->kind == PATH_SPEED_SEG_TURN) {
+            s_boundary[i] = prev->v_exit;
+            s_pinned[i] = true;
+        } else if (next != NULL && next->kind == PATH_SPEED_SEG_TURN) {
+            s_boundary[i] = next->v_entry;
+            s_pinned[i] = true;
+        } else if (next != NULL) {
+            const float a = seg_model(plan, prev)->v_max;
+            const float b = seg_model(plan, next)->v_max;
+            s_boundary[i] = (a < b) ? a : b;
+            s_pinned[i] = false;
+        }
+    }
+
+    //====前向き（加速で届く速度）・後ろ向き（減速で間に合う速度）====
+    for (uint16_t i = 1; i < n; i++) {
+        if (!s_pinned[i]) {
+            const path_speed_seg_t *prev = &plan->seg[i - 1];
+            const float v = ramp_reach(seg_model(plan, prev), s_boundary[i - 1], prev->length_mm);
+            if (v < s_boundary[i]) {
+                s_boundary[i] = v;
+            }
+        }
+    }
+    for (uint16_t i = (uint16_t)(n - 1); i >= 1; i--) {
+        if (!s_pinned[i]) {
+            const path_speed_seg_t *next = &plan->seg[i];
+            const float v = ramp_reach(seg_model(plan, next), s_boundary[i + 1], next->length_mm);
+            if (v < s_boundary[i]) {
+                s_boundary[i] = v;
+            }
+        }
+    }
+
+    //====区間ごとの台形と所要時間====
+    for (uint16_t i = 0; i < n; i++) {
+        path_speed_seg_t *seg = &plan->seg[i];
+
+        if (seg->kind != PATH_SPEED_SEG_TURN) {
+            seg->v_entry = s_boundary[i];
+            seg->v_exit = s_boundary[i + 1];
+            solve_peak(seg_model(plan, seg), seg);
+            seg->time_s = seg_time(seg_model(plan, seg), seg);
+        }
+        if (!seg->feasible) {
+            plan->infeasible++;
+        }
+        plan->total_time_s += seg->time_s;
+        plan->total_length_mm += seg->length_mm;
+    }
+    return true;
+}
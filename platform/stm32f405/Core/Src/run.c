@@ -15,6 +15,227 @@
 #define TEST_FAILSAFE_HOLD_MS 3000u
 #endif
 
+// 1: run() の区間を走行コマンドキューに積み、制御割り込みに続けて実行させる
+// 0: 従来どおり drive.c の走行プリミティブを 1 つずつ待ちながら呼ぶ（比較用）
+#ifndef RUN_USE_DRIVE_QUEUE
+#define RUN_USE_DRIVE_QUEUE 1
+#endif
+
+/*============================================================
+    run() の 1 動作（キュー有効時は drive.c のプリミティブと同じ区間を積む）
+============================================================*/
+#if RUN_USE_DRIVE_QUEUE
+static void run_queue(uint8_t type, uint8_t flags, uint16_t tag, float dist, float v_in, float v_out) {
+    const drive_cmd_t cmd = {
+        .type = type, .flags = flags, .tag = tag, .dist_mm = dist, .v_in = v_in, .v_out = v_out,
+        .jerk_mm_s3 = jerk_straight, // 加減速する直進のみ使う（0 なら等加速度）
+    };
+    (void)drive_queue_push(&cmd);
+}
+
+// 旋回後の速度は driveSR/driveSL と同じく speed_now
+static void run_queue_turn(uint8_t flags, int8_t sign, uint16_t tag, float angle, float alpha) {
+    const drive_cmd_t cmd = {
+        .type = DRIVE_CMD_TURN, .flags = flags, .sign = sign, .tag = tag,
+        .v_out = speed_now, .angle_deg = angle, .alpha_deg_s2 = alpha,
+    };
+    (void)drive_queue_push(&cmd);
+}
+#endif
+
+static void run_seg_first(void) {
+#if RUN_USE_DRIVE_QUEUE
+    const float speed_out = sqrtf(speed_now * speed_now + 2.0f * acceleration_straight * DIST_FIRST_SEC);
+    run_queue(DRIVE_CMD_STRAIGHT, DRIVE_CMD_CTRL, 0, DIST_FIRST_SEC, speed_now, speed_out);
+    speed_now = speed_out;
+#else
+    first_sectionA();
+#endif
+}
+
+static void run_seg_straight(uint16_t tag, float section, float spd_out) {
+#if RUN_USE_DRIVE_QUEUE
+    run_queue(DRIVE_CMD_STRAIGHT, DRIVE_CMD_CTRL, tag, DIST_HALF_SEC * section, speed_now, spd_out);
+    speed_now = spd_out;
+#else
+    (void)tag;
+    run_straight(section, spd_out, 0);
+#endif
+}
+
+// 壁切れを探す等速区間。検知したら follow_mm 追加直進する（follow_mm <= 0 なら検知で終了）
+static void run_seg_wallend(uint16_t tag, float dist_max, float v, float follow_mm) {
+#if RUN_USE_DRIVE_QUEUE
+    run_queue(DRIVE_CMD_WALLEND, 0, tag, dist_max, v, v);
+    if (follow_mm > 0.0f) {
+        run_queue(DRIVE_CMD_STRAIGHT, DRIVE_CMD_CTRL | DRIVE_CMD_IF_WALL_END, tag, follow_mm, speed_now, v);
+    }
+#else
+    (void)tag;
+    if (driveC_wallend(dist_max, v) && follow_mm > 0.0f) {
+        run_straight(follow_mm / DIST_HALF_SEC, v, 0);
+    }
+#endif
+}
+
+static void run_seg_diagonal(uint16_t tag, float section, float spd_out) {
+#if RUN_USE_DRIVE_QUEUE
+    const uint8_t flags = (spd_out > 1) ? DRIVE_CMD_CTRL_DIAG : 0;
+    run_queue(DRIVE_CMD_STRAIGHT, flags, tag, DIST_D_HALF_SEC * section, speed_now, spd_out);
+    speed_now = spd_out;
+#else
+    (void)tag;
+    run_diagonal(section, spd_out);
+#endif
+}
+
+// 小回り 90°（turn_R90(1) / turn_L90(1)）
+static void run_seg_turn90(uint16_t code) {
+    const bool right = (code < 400);
+#if RUN_USE_DRIVE_QUEUE
+    const uint8_t slalom = right ? DRIVE_CMD_SLALOM_R : DRIVE_CMD_SLALOM_L;
+    // テスト動作中は前壁補正を使わない
+    const uint8_t type_in = g_test_mode_run ? DRIVE_CMD_STRAIGHT : DRIVE_CMD_FWALL;
+
+    run_queue(type_in, DRIVE_CMD_CTRL | slalom, code, dist_offset_in, speed_now, velocity_turn90);
+    run_queue_turn(slalom, right ? -1 : 1, code, angle_turn_90, alpha_turn90);
+    run_queue(DRIVE_CMD_STRAIGHT, DRIVE_CMD_CTRL | slalom, code, dist_offset_out, velocity_turn90,
+              speed_now);
+#else
+    if (right) {
+        turn_R90(1);
+    } else {
+        turn_L90(1);
+    }
+#endif
+}
+
+// 大回り 90°/180°（l_turn_R90 等）
+static void run_seg_l_turn(uint16_t code, bool next_is_large) {
+    const bool right = (code < 600);
+    const bool is_180 = ((code % 100u) == 2u);
+#if RUN_USE_DRIVE_QUEUE
+    const float v = is_180 ? velocity_l_turn_180 : velocity_l_turn_90;
+    const float dist_in = is_180 ? dist_l_turn_in_180 : dist_l_turn_in_90;
+    const float dist_out = is_180 ? dist_l_turn_out_180 : dist_l_turn_out_90;
+
+    if (dist_in > 0.0f) {
+        run_queue(DRIVE_CMD_STRAIGHT, DRIVE_CMD_CTRL, code, dist_in, speed_now, v);
+    }
+    run_queue_turn(right ? DRIVE_CMD_SLALOM_R : DRIVE_CMD_SLALOM_L, right ? -1 : 1, code,
+                   is_180 ? angle_l_turn_180 : angle_l_turn_90,
+                   is_180 ? alpha_l_turn_180 : alpha_l_turn_90);
+    // 出オフセット（次が大回りターンの場合のみ壁切れ補正）
+    if (next_is_large && !g_disable_wall_end_correction && dist_out > 0.0f) {
+        run_queue(DRIVE_CMD_WALLEND, DRIVE_CMD_CTRL, code, dist_out, v, v);
+        if (dist_wall_end > 0.0f) {
+            run_queue(DRIVE_CMD_STRAIGHT, DRIVE_CMD_CTRL | DRIVE_CMD_IF_WALL_END, code, dist_wall_end,
+                      speed_now, v);
+        }
+    } else {
+        run_queue(DRIVE_CMD_STRAIGHT, DRIVE_CMD_CTRL, code, dist_out, speed_now, v);
+    }
+#else
+    if (is_180 && right) {
+        l_turn_R180(next_is_large);
+    } else if (is_180) {
+        l_turn_L180(next_is_large);
+    } else if (right) {
+        l_turn_R90(next_is_large);
+    } else {
+        l_turn_L90(next_is_large);
+    }
+#endif
+}
+
+// 斜めのターン（45° 入り/出、V90、135° 入り/出）。奇数コードが右
+static void run_seg_diag_turn(uint16_t code) {
+#if RUN_USE_DRIVE_QUEUE
+    const bool right = (code & 1u) != 0u;
+    float dist_in, dist_out, v, angle, alpha;
+
+    switch (code) {
+    case 701:
+    case 702:
+        dist_in = dist_turn45in_in;
+        dist_out = dist_turn45in_out;
+        v = velocity_turn45in;
+        angle = angle_turn45in;
+        alpha = alpha_turn45in;
+        break;
+    case 703:
+    case 704:
+        dist_in = dist_turn45out_in;
+        dist_out = dist_turn45out_out;
+        v = velocity_turn45out;
+        angle = angle_turn45out;
+        alpha = alpha_turn45out;
+        break;
+    case 801:
+    case 802:
+        dist_in = dist_turnV90_in;
+        dist_out = dist_turnV90_out;
+        v = velocity_turnV90;
+        angle = angle_turnV90;
+        alpha = alpha_turnV90;
+        break;
+    case 901:
+    case 902:
+        dist_in = dist_turn135in_in;
+        dist_out = dist_turn135in_out;
+        v = velocity_turn135in;
+        angle = angle_turn135in;
+        alpha = alpha_turn135in;
+        break;
+    case 903:
+    case 904:
+        dist_in = dist_turn135out_in;
+        dist_out = dist_turn135out_out;
+        v = velocity_turn135out;
+        angle = angle_turn135out;
+        alpha = alpha_turn135out;
+        break;
+    default:
+        return;
+    }
+    // 壁制御・斜め制御なし
+    run_queue(DRIVE_CMD_STRAIGHT, 0, code, dist_in, speed_now, v);
+    run_queue_turn(0, right ? -1 : 1, code, angle, alpha);
+    run_queue(DRIVE_CMD_STRAIGHT, 0, code, dist_out, speed_now, v);
+#else
+    switch (code) {
+    case 701: turn_R45_In(); break;
+    case 702: turn_L45_In(); break;
+    case 703: turn_R45_Out(); break;
+    case 704: turn_L45_Out(); break;
+    case 801: turn_RV90(); break;
+    case 802: turn_LV90(); break;
+    case 901: turn_R135_In(); break;
+    case 902: turn_L135_In(); break;
+    case 903: turn_R135_Out(); break;
+    case 904: turn_L135_Out(); break;
+    default: break;
+    }
+#endif
+}
+
+// ゴールで半区画減速して停止する
+static void run_seg_stop(void) {
+#if RUN_USE_DRIVE_QUEUE
+    run_queue(DRIVE_CMD_STRAIGHT, DRIVE_CMD_CTRL, 0, DIST_HALF_SEC, speed_now, 0.0f);
+    speed_now = 0.0f;
+#else
+    half_sectionD(0);
+#endif
+}
+
+// 積んだ区間がすべて終わるまで待つ
+static void run_seg_wait(void) {
+#if RUN_USE_DRIVE_QUEUE
+    (void)drive_queue_wait_idle();
+#endif
+}
+
 static void shortest_no_path_error_halt(uint8_t mode, uint8_t case_index) {
     printf("[Shortest] ERROR: no path (mode=%u, case=%u).\n", (unsigned)mode, (unsigned)case_index);
     MF.FLAG.RUNNING = 0;
@@ -46,7 +267,7 @@ void run(void) {
     drive_start();
     get_base();
 
-    first_sectionA();
+    run_seg_first();
 
     // センサログ有効時: 走行開始時からログ取得開始
     if (g_sensor_log_enabled) {
@@ -209,148 +430,87 @@ void run(void) {
                     // 加速区間
                     if (d_acc > 0.0f) {
                         float acc_run = (d_acc < main_mm) ? d_acc : main_mm;
-                        run_straight(acc_run / DIST_HALF_SEC, max_reached_speed, 0);
+                        run_seg_straight(path[path_count], acc_run / DIST_HALF_SEC, max_reached_speed);
                     }
                     // 等速区間
                     float const_run = main_mm - d_acc;
                     if (const_run > 0.0f && d_constant > 0.0f) {
                         float run_dist = (const_run < d_constant) ? const_run : d_constant;
-                        run_straight(run_dist / DIST_HALF_SEC, max_reached_speed, 0);
+                        run_seg_straight(path[path_count], run_dist / DIST_HALF_SEC, max_reached_speed);
                     }
                     // 減速区間（メイン部分の残り）
                     float dec_in_main = main_mm - d_acc - d_constant;
                     if (dec_in_main > 0.0f) {
-                        run_straight(dec_in_main / DIST_HALF_SEC, v_next, 0);
+                        run_seg_straight(path[path_count], dec_in_main / DIST_HALF_SEC, v_next);
                     }
                 } else if (main_mm > 0.0f) {
                     // 短い直線: 前のターン速度から次のターン速度へ直接遷移
                     // speed_now（現在速度）からv_next（次のターン速度）への加減速
-                    run_straight(main_mm / DIST_HALF_SEC, v_next, 0);
+                    run_seg_straight(path[path_count], main_mm / DIST_HALF_SEC, v_next);
                 }
                 
                 // バッファ部分の走行（壁切れ検出付き、等速でターン速度を維持）
                 // 最大90mm走行し、壁切れ検出で即座に終了
-                bool wall_end_found = driveC_wallend(BUFFER_MAX, v_next);
-                
                 // 壁切れ検出後の処理
-                if (wall_end_found) {
-                    // 小回りターンの場合: 45mm + dist_wall_end 追加直進
-                    // 大回りターンの場合: dist_wall_end 追加直進
-                    float follow_dist = next_is_small_turn 
-                        ? (WALL_END_BUFFER + dist_wall_end) 
-                        : dist_wall_end;
-                    if (follow_dist > 0.0f) {
-                        run_straight(follow_dist / DIST_HALF_SEC, v_next, 0);
-                    }
-                }
+                // 小回りターンの場合: 45mm + dist_wall_end 追加直進
+                // 大回りターンの場合: dist_wall_end 追加直進
+                float follow_dist = next_is_small_turn 
+                    ? (WALL_END_BUFFER + dist_wall_end) 
+                    : dist_wall_end;
+                run_seg_wallend(path[path_count], BUFFER_MAX, v_next, follow_dist);
                 // 壁切れ未検出の場合（90mm走行完了）、そのままターン開始
                 
             } else {
                 // 次がターンでない場合、または壁切れ補正無効時の処理
                 if (d_acc_blocks > 0.0f) {
-                    run_straight(d_acc_blocks, max_reached_speed, 0);
+                    run_seg_straight(path[path_count], d_acc_blocks, max_reached_speed);
                 }
                 if (d_constant_blocks > 0.0f) {
-                    run_straight(d_constant_blocks, max_reached_speed, 0);
+                    run_seg_straight(path[path_count], d_constant_blocks, max_reached_speed);
                 }
                 if (d_dec_blocks > 0.0f) {
-                    run_straight(d_dec_blocks, v_next, 0);
+                    run_seg_straight(path[path_count], d_dec_blocks, v_next);
                 }
                 
                 // センサログ有効時: バッファ区間でセンサ値を記録（壁切れ補正は無効のまま）
                 if (g_sensor_log_enabled && (next_is_small_turn || next_is_large_turn)) {
                     const float BUFFER_MAX = (float)DIST_HALF_SEC;
-                    driveC_wallend(BUFFER_MAX, v_next);  // 壁切れ検出しても補正は行わない
+                    run_seg_wallend(path[path_count], BUFFER_MAX, v_next, 0.0f);  // 壁切れ検出しても補正は行わない
                 }
             }
 
         } else if (path[path_count] < 400) {
             // 右旋回
 
-            turn_R90(1);
+            run_seg_turn90(path[path_count]);
 
             turn_dir(DIR_TURN_R90); // マイクロマウス内部位置情報でも右回転処理
 
         } else if (path[path_count] < 500) {
             // 左旋回
 
-            turn_L90(1);
+            run_seg_turn90(path[path_count]);
 
             turn_dir(DIR_TURN_L90); // マイクロマウス内部位置情報でも右回転処理
 
         } else if (path[path_count] < 600) {
             // 右大回り旋回
-            uint8_t l_turn_sections = path[path_count] - 500;
             // 次が大回りターンかどうか判定（500-699が大回り）
             uint16_t next_code = path[path_count + 1];
             bool next_is_large = (next_code >= 500 && next_code < 700);
 
-            if (l_turn_sections == 2) {
-                l_turn_R180(next_is_large);
-            } else {
-                l_turn_R90(next_is_large);
-            }
+            run_seg_l_turn(path[path_count], next_is_large);
         } else if (path[path_count] < 700) {
             // 左大回り旋回
-            uint8_t l_turn_sections = path[path_count] - 600;
             // 次が大回りターンかどうか判定（500-699が大回り）
             uint16_t next_code = path[path_count + 1];
             bool next_is_large = (next_code >= 500 && next_code < 700);
 
-            if (l_turn_sections == 2) {
-                l_turn_L180(next_is_large);
-            } else {
-                l_turn_L90(next_is_large);
-            }
-        } else if (path[path_count] == 701) {
-            // 45degターン右入り
-
-            turn_R45_In();
-
-        } else if (path[path_count] == 702) {
-            // 45degターン左入り
-
-            turn_L45_In();
-
-        } else if (path[path_count] == 703) {
-            // 45degターン右出
-
-            turn_R45_Out();
-
-        } else if (path[path_count] == 704) {
-            // 45degターン左出
-
-            turn_L45_Out();
-
-        } else if (path[path_count] == 801) {
-            // V90degターン右
-
-            turn_RV90();
-
-        } else if (path[path_count] == 802) {
-            // V90degターン左
-
-            turn_LV90();
-
-        } else if (path[path_count] == 901) {
-            // 135degターン右入り
-
-            turn_R135_In();
-
-        } else if (path[path_count] == 902) {
-            // 135degターン左入り
-
-            turn_L135_In();
-
-        } else if (path[path_count] == 903) {
-            // 135degターン右出
-
-            turn_R135_Out();
-
-        } else if (path[path_count] == 904) {
-            // 135degターン左出
+            run_seg_l_turn(path[path_count], next_is_large);
+        } else if (700 < path[path_count] && path[path_count] < 1000) {
+            // 斜めのターン（701..704: 45°入り/出、801/802: V90、901..904: 135°入り/出）
 
-            turn_L135_Out();
+            run_seg_diag_turn(path[path_count]);
 
         } else if (1000 < path[path_count] && path[path_count] < 1100) {
             // 斜め直進
@@ -389,31 +549,32 @@ void run(void) {
             float d_dec_blocks = d_acc_blocks; // 減速距離は加速距離と等しい
 
             // 加速区間
-            run_diagonal(d_acc_blocks, max_reached_speed);
+            run_seg_diagonal(path[path_count], d_acc_blocks, max_reached_speed);
 
             // 等速区間
-            run_diagonal(d_constant_blocks, max_reached_speed);
+            run_seg_diagonal(path[path_count], d_constant_blocks, max_reached_speed);
 
             // 減速区間
             if (path[path_count + 1] < 800) {
                 // 次が45degターン
-                run_diagonal(d_dec_blocks, velocity_turn45out);
+                run_seg_diagonal(path[path_count], d_dec_blocks, velocity_turn45out);
             } else if (path[path_count + 1] < 900) {
                 // 次がV90degターン
-                run_diagonal(d_dec_blocks, velocity_turnV90);
+                run_seg_diagonal(path[path_count], d_dec_blocks, velocity_turnV90);
             } else if (path[path_count + 1] < 1000) {
                 // 次が135degターン
-                run_diagonal(d_dec_blocks, velocity_turn135out);
+                run_seg_diagonal(path[path_count], d_dec_blocks, velocity_turn135out);
             } else {
                 // 次が終了
-                run_diagonal(d_dec_blocks, 0);
+                run_seg_diagonal(path[path_count], d_dec_blocks, 0);
             }
         }
     }
 
     if (!MF.FLAG.FAILED) {
-        half_sectionD(0);
+        run_seg_stop();
     }
+    run_seg_wait();
 
     // センサログ停止
     if (g_sensor_log_enabled) {
@@ -488,6 +649,7 @@ void run_shortest(uint8_t mode, uint8_t case_index) {
     // 直線（caseごと）
     acceleration_straight      = p->acceleration_straight;
     acceleration_straight_dash = p->acceleration_straight_dash;
+    jerk_straight              = p->jerk_straight;
     velocity_straight          = p->velocity_straight;
     // 斜め直線（caseごと）
     acceleration_d_straight      = p->acceleration_d_straight;
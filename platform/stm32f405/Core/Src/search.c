@@ -6,9 +6,14 @@
  */
 
 #include "global.h"
+#include "maze_bitboard.h"
 #include "maze_grid.h"
 #include "nvm_params.h"
+#include "search_route.h"
+#include "search_target.h"
+#include "step_map.h"
 #include <math.h>
+#include <string.h>
 
 // 経路なし終了を検出する内部フラグ（adachi() 実行中のみ有効）
 static bool s_no_path_exit = false;
@@ -25,6 +30,31 @@ static uint16_t s_post_goal_newly_known_cells = 0;
 static uint8_t s_post_goal_known_snapshot[MAZE_SIZE][MAZE_SIZE];
 static bool s_post_goal_cell_counted[MAZE_SIZE][MAZE_SIZE];
 
+// conf_route() 用の差分更新歩数マップ（smap[][] に直接書き込む）
+static step_map_t s_step_map;
+static bool s_step_map_bound = false;
+
+// make_smap() 用の壁の行ビットボード（[0]: 下位4bit、[1]: 上位4bit = 二次走行用）。
+// map_Init() と地図の読込で全面を作り、write_map() では書いた区画だけ更新する。
+static maze_bitboard_t s_map_bb[2];
+
+static void map_bitboard_build(void) {
+    maze_bitboard_build(&s_map_bb[0], map, 0);
+    maze_bitboard_build(&s_map_bb[1], map, 4);
+}
+
+static void map_bitboard_update_cell(uint8_t x, uint8_t y) {
+    maze_bitboard_update_cell(&s_map_bb[0], map, 0, x, y);
+    maze_bitboard_update_cell(&s_map_bb[1], map, 4, x, y);
+}
+
+#if SEARCH_FULL_TARGETED
+// 全面探索の探索対象（候補区画と、未知壁を無し/有りとみなした最短歩数）
+static search_target_t s_full_target;
+// 全面探索の歩数マップで起点にしない区画（探索済または候補外）。step_map_update() の visited に渡す
+static bool s_full_seed_off[MAZE_SIZE][MAZE_SIZE];
+#endif
+
 static inline uint8_t get_cell_known_mask(uint16_t cell) {
     uint8_t mask = 0;
     if (((cell & 0x80u) != 0u) == ((cell & 0x08u) != 0u)) mask |= 0x08u; // N
@@ -179,7 +209,7 @@ static inline bool is_in_goal_cells(uint8_t x, uint8_t y) {
 }
 
 // 内部ヘルパ: smap に複数ゴールのゼロをシードする
-static inline void seed_goals_zero_in_smap(void) {
+static inline void seed_goals(maze_row_t seed[MAZE_SIZE]) {
     const uint8_t goals[9][2] = {
         {GOAL1_X, GOAL1_Y}, {GOAL2_X, GOAL2_Y}, {GOAL3_X, GOAL3_Y},
         {GOAL4_X, GOAL4_Y}, {GOAL5_X, GOAL5_Y}, {GOAL6_X, GOAL6_Y},
@@ -190,11 +220,217 @@ static inline void seed_goals_zero_in_smap(void) {
         uint8_t gy = goals[i][1];
         // (0,0) は未使用スロットとして無視
         if (gx == 0 && gy == 0) continue;
-        if (gx < MAZE_SIZE && gy < MAZE_SIZE) {
-            smap[gy][gx] = 0;
+        maze_bitboard_seed_set(seed, gx, gy);
+    }
+}
+
+#if SEARCH_FULL_TARGETED
+// 内部ヘルパ: 全面探索の候補区画を求め直し、起点の増減があった区画を差分更新側へ通知する
+static void full_target_update(void) {
+    maze_row_t goal_seed[MAZE_SIZE] = {0};
+
+    seed_goals(goal_seed);
+    search_target_update(&s_full_target, map, visited, goal_seed, START_X, START_Y);
+    for (uint8_t y = 0; y < MAZE_SIZE; y++) {
+        for (uint8_t x = 0; x < MAZE_SIZE; x++) {
+            const bool off = !search_target_is_cand(&s_full_target, x, y);
+            if (off != s_full_seed_off[y][x]) {
+                s_full_seed_off[y][x] = off;
+                step_map_touch(&s_step_map, x, y);
+            }
         }
     }
 }
+#endif
+
+// 内部ヘルパ: make_smap() と同じ起点で歩数マップを差分更新し、区画 (x, y) の歩数を返す
+// （到達不能時は make_smap() と同じく MAZE_SIZE*MAZE_SIZE-10）
+static int update_smap_incremental(uint8_t x, uint8_t y) {
+#if SEARCH_INCREMENTAL_SMAP
+    step_map_target_t target;
+
+    if (!s_step_map_bound) {
+        step_map_bind(&s_step_map, smap);
+        s_step_map_bound = true;
+    }
+
+    if (g_search_mode == SEARCH_MODE_GOAL) {
+        target = g_goal_is_start ? STEP_MAP_TARGET_START : STEP_MAP_TARGET_GOAL;
+    } else {
+        // スタート区画は強制的に既知扱い（make_smap と同じ）
+        visited[START_Y][START_X] = true;
+        target = STEP_MAP_TARGET_UNVISITED;
+    }
+#if SEARCH_FULL_TARGETED
+    if (target == STEP_MAP_TARGET_UNVISITED) {
+        // 候補区画だけを起点にする（候補外の区画は探索済と同じ扱いで渡す）
+        full_target_update();
+        step_map_update(&s_step_map, map, s_full_seed_off, target, MF.FLAG.SCND != 0);
+    } else {
+        step_map_update(&s_step_map, map, visited, target, MF.FLAG.SCND != 0);
+    }
+#else
+    step_map_update(&s_step_map, map, visited, target, MF.FLAG.SCND != 0);
+#endif
+
+    if (smap[y][x] == STEP_MAP_UNREACHED) {
+        return (MAZE_SIZE * MAZE_SIZE - 10);
+    }
+    return smap[y][x];
+#else
+    (void)x;
+    (void)y;
+    return make_smap(goal_x, goal_y);
+#endif
+}
+
+#if ENABLE_BG_REPLAN
+#if !SEARCH_INCREMENTAL_SMAP
+#error "ENABLE_BG_REPLAN requires SEARCH_INCREMENTAL_SMAP"
+#endif
+
+//====背景再計算（走行中に次区画起点の歩数マップと経路を先に作る）====
+// arm_background_replan() で次区画を予測し、background_replan_tick() を呼ぶたびに 1 段ずつ進める。
+//   BG_ARMED    : 歩数マップを差分更新する（前の区画境界で書いた壁を反映）
+//   BG_SMAP_DONE: 次区画から経路を作り、次区画まわりの壁を保存する
+//   BG_READY    : conf_route() で採用を待つ
+// 区画境界では search_route.h の条件を満たすときだけ先行結果を使い、それ以外は同期計算する。
+typedef enum {
+    BG_IDLE = 0,
+    BG_ARMED,
+    BG_SMAP_DONE,
+    BG_READY,
+} bg_state_t;
+
+volatile bool bg_plan_ready = false;
+
+static bg_state_t s_bg_state = BG_IDLE;
+static uint8_t s_bg_x, s_bg_y, s_bg_dir; // 予測した次区画と到着時の向き
+static search_mode_t s_bg_mode;          // 先行計算時の起点設定
+static bool s_bg_goal_is_start;
+static bool s_bg_scnd;
+static int s_bg_step;                    // 次区画の歩数
+static search_route_walls_t s_bg_walls;  // 先行計算時の次区画まわりの壁
+static uint16_t s_bg_route[ROUTE_MAX_LEN];
+static search_bg_replan_stats_t s_bg_stats;
+
+void arm_background_replan(uint16_t move_opcode) {
+    static const int8_t s_dx[4] = {0, 1, 0, -1};
+    static const int8_t s_dy[4] = {1, 0, -1, 0};
+    uint8_t dir = mouse.dir;
+
+    bg_plan_ready = false;
+    s_bg_state = BG_IDLE;
+
+    switch (move_opcode) {
+    case 0x88:
+        break;
+    case 0x44:
+        dir = (dir + DIR_TURN_R90) & 0x03;
+        break;
+    case 0x11:
+        dir = (dir + DIR_TURN_L90) & 0x03;
+        break;
+    default:
+        return; // Uターンは停止して向きを変えるので同期計算に任せる
+    }
+
+    const int16_t nx = (int16_t)mouse.x + s_dx[dir];
+    const int16_t ny = (int16_t)mouse.y + s_dy[dir];
+    if (nx < 0 || nx >= MAZE_SIZE || ny < 0 || ny >= MAZE_SIZE) {
+        return;
+    }
+    s_bg_x = (uint8_t)nx;
+    s_bg_y = (uint8_t)ny;
+    s_bg_dir = dir;
+    s_bg_state = BG_ARMED;
+}
+
+void background_replan_tick(void) {
+    switch (s_bg_state) {
+    case BG_ARMED:
+        // 全面探索では到着した区画が起点から外れるため、先に探索済にしておく
+        if (g_search_mode == SEARCH_MODE_FULL) {
+            markVisited(s_bg_x, s_bg_y);
+        }
+        s_bg_mode = g_search_mode;
+        s_bg_goal_is_start = g_goal_is_start;
+        s_bg_scnd = MF.FLAG.SCND != 0;
+        s_bg_step = update_smap_incremental(s_bg_x, s_bg_y);
+        search_route_walls_save(&s_bg_walls, map, s_bg_scnd ? 4 : 0, s_bg_x, s_bg_y);
+        s_bg_state = BG_SMAP_DONE;
+        break;
+    case BG_SMAP_DONE:
+        if (s_bg_step <= 0 || s_bg_step > (MAZE_SIZE * MAZE_SIZE - (MAZE_SIZE - 1))) {
+            // 次区画が起点または到達不能なら、区画境界の同期計算に任せる
+            s_bg_state = BG_IDLE;
+            break;
+        }
+        (void)search_route_build(s_bg_route, ROUTE_MAX_LEN, smap, map, s_bg_scnd ? 4 : 0, s_bg_x,
+                                 s_bg_y, s_bg_dir);
+        s_bg_state = BG_READY;
+        bg_plan_ready = true;
+        break;
+    default:
+        break;
+    }
+}
+
+// 区画境界（write_map() 後）で先行経路を route[] へ採用できれば true と現在地の歩数を返す
+static bool background_replan_commit(int *mstep) {
+    const bg_state_t state = s_bg_state;
+
+    s_bg_state = BG_IDLE;
+    bg_plan_ready = false;
+
+    if (state == BG_IDLE) {
+        s_bg_stats.fallback_unarmed++;
+        return false;
+    }
+    if (state != BG_READY) {
+        s_bg_stats.fallback_not_ready++;
+        return false;
+    }
+    if (mouse.x != s_bg_x || mouse.y != s_bg_y || mouse.dir != s_bg_dir ||
+        g_search_mode != s_bg_mode || g_goal_is_start != s_bg_goal_is_start ||
+        (MF.FLAG.SCND != 0) != s_bg_scnd) {
+        s_bg_stats.fallback_mispredict++;
+        return false;
+    }
+    if (!search_route_walls_only_added(&s_bg_walls, map, s_bg_scnd ? 4 : 0, mouse.x, mouse.y)) {
+        s_bg_stats.fallback_walls++;
+        return false;
+    }
+
+    // 歩数マップは次区画の壁を反映していないが、write_map() の通知が残るので次回の更新で直る
+    if (search_route_first_move_open(s_bg_route, map, s_bg_scnd ? 4 : 0, mouse.x, mouse.y,
+                                     mouse.dir)) {
+        memcpy(route, s_bg_route, sizeof(route));
+        s_bg_stats.hits++;
+    } else {
+        // 1手目は塞がれたが、歩数の小さい隣接区画へ抜けられれば歩数マップはそのまま使える
+        make_route();
+        if (route[0] == 0x00) {
+            s_bg_stats.fallback_walls++;
+            return false;
+        }
+        s_bg_stats.hits_reroute++;
+    }
+    *mstep = s_bg_step;
+    return true;
+}
+
+void search_get_bg_replan_stats(search_bg_replan_stats_t *out) {
+    if (out != NULL) {
+        *out = s_bg_stats;
+    }
+}
+#else
+static inline bool background_replan_commit(int *mstep) {
+    (void)mstep;
+    return false;
+}
+#endif
 
 //+++++++++++++++++++++++++++++++++++++++++++++++
 // search_init
@@ -222,6 +458,10 @@ void search_init(void) {
     s_post_goal_newly_known_cells = 0;
 
     g_search_coast_mm = 0.0f;
+#if ENABLE_BG_REPLAN
+    s_bg_state = BG_IDLE;
+    bg_plan_ready = false;
+#endif
 }
 
 //+++++++++++++++++++++++++++++++++++++++++++++++
@@ -404,6 +644,7 @@ void adachi(uint16_t fan_duty) {
             } else {
                 known_straight = false;
             }
+            arm_background_replan(0x88);
 
             led_write(1, 1, 0);
 
@@ -449,7 +690,7 @@ void adachi(uint16_t fan_duty) {
         //----右折----
         case 0x44:
             search_dual_wall_streak_reset();
-            arm_background_replan(route[r_cnt]);
+            arm_background_replan(0x44);
 
             led_write(0, 1, 0);
 
@@ -504,7 +745,7 @@ void adachi(uint16_t fan_duty) {
         //----左折----
         case 0x11:
             search_dual_wall_streak_reset();
-            arm_background_replan(route[r_cnt]);
+            arm_background_replan(0x11);
 
             led_write(1, 0, 0);
 
@@ -627,7 +868,12 @@ void conf_route() {
     write_map();
     track_post_goal_map_update_around_mouse();
 
-    int mstep = make_smap(goal_x, goal_y);
+    // 走行中に先行計算した経路が使えればそれを採用し、使えなければここで同期計算する
+    int mstep;
+    const bool bg_committed = background_replan_commit(&mstep);
+    if (!bg_committed) {
+        mstep = update_smap_incremental(mouse.x, mouse.y);
+    }
 
     if (g_search_mode == SEARCH_MODE_GOAL) {
         // ゴールに到達したら終了（複数ゴール対応）
@@ -649,15 +895,26 @@ void conf_route() {
             goto conf_route_end;
         }
 
-        make_route(); // 最短経路を更新
-        r_cnt = 0;    // 経路カウンタを0に
+        if (!bg_committed) {
+            make_route(); // 最短経路を更新
+        }
+        r_cnt = 0; // 経路カウンタを0に
     } else {
         // 全面探索モード（未探索セルに向かう）
-        if (mstep > (MAZE_SIZE * MAZE_SIZE - (MAZE_SIZE - 1))) {
+        bool full_end = (mstep > (MAZE_SIZE * MAZE_SIZE - (MAZE_SIZE - 1)));
+#if SEARCH_FULL_TARGETED
+        // 最短歩数の上下界が一致したら、残りの未探索区画では最短経路が変わらないので終了
+        // （先行経路を採用した区画では走行中の判定を使うので、終了は最大 1 区画遅れる）
+        full_end = full_end || s_full_target.done;
+#endif
+        if (full_end) {
             search_end = true;
         } else {
-            make_route(); // 最短経路を更新
-            r_cnt = 0;    // 経路カウンタを0に
+            findClosestUnvisitedCell(mouse.x, mouse.y);
+            if (!bg_committed) {
+                make_route(); // 最短経路を更新
+            }
+            r_cnt = 0; // 経路カウンタを0に
         }
     }
 
@@ -725,6 +982,9 @@ void map_Init() {
     if (START_X > 0) {
         map[START_Y][START_X - 1] |= 0x44; // 西隣の区画の東壁
     }
+
+    map_bitboard_build();
+    step_map_invalidate(&s_step_map);
 }
 
 //+++++++++++++++++++++++++++++++++++++++++++++++
@@ -800,6 +1060,23 @@ void write_map() {
     if ((START_X + 1) < MAZE_SIZE) {
         map[START_Y][START_X + 1] |= 0x11; // 隣マスから見た西壁あり
     }
+
+    //====行ビットボードと差分更新歩数マップへ変化区画を通知====
+    // 範囲外（最端の外側、uint8_t の折り返しを含む）は両方とも無視する
+    map_bitboard_update_cell(mouse.x, mouse.y);
+    map_bitboard_update_cell(mouse.x, (uint8_t)(mouse.y + 1));
+    map_bitboard_update_cell((uint8_t)(mouse.x + 1), mouse.y);
+    map_bitboard_update_cell(mouse.x, (uint8_t)(mouse.y - 1));
+    map_bitboard_update_cell((uint8_t)(mouse.x - 1), mouse.y);
+    map_bitboard_update_cell(START_X, START_Y);
+    map_bitboard_update_cell(START_X + 1, START_Y);
+    step_map_touch(&s_step_map, mouse.x, mouse.y);
+    step_map_touch(&s_step_map, mouse.x, (uint8_t)(mouse.y + 1));
+    step_map_touch(&s_step_map, (uint8_t)(mouse.x + 1), mouse.y);
+    step_map_touch(&s_step_map, mouse.x, (uint8_t)(mouse.y - 1));
+    step_map_touch(&s_step_map, (uint8_t)(mouse.x - 1), mouse.y);
+    step_map_touch(&s_step_map, START_X, START_Y);
+    step_map_touch(&s_step_map, START_X + 1, START_Y);
 }
 
 //+++++++++++++++++++++++++++++++++++++++++++++++
@@ -823,100 +1100,58 @@ int make_smap(uint8_t target_x, uint8_t target_y) {
     (void)target_x;
     (void)target_y;
 
+    // smap[][] を全面的に書き換えるため、差分更新側は次回に再構築させる
+    step_map_invalidate(&s_step_map);
+
     //====変数宣言====
     uint8_t x, y; // for文用変数
 
-    static uint16_t q[MAZE_SIZE * MAZE_SIZE];
-    uint16_t q_head = 0;
-    uint16_t q_tail = 0;
+    maze_row_t seed[MAZE_SIZE] = {0};
 
-    //====歩数マップのクリア====
-    for (y = 0; y <= (MAZE_SIZE - 1); y++) {     // 各Y座標で実行
-        for (x = 0; x <= (MAZE_SIZE - 1); x++) { // 各X座標で実行
-            smap[y][x] = 0xffff;    // 未記入部分は歩数最大とする
-        }
-    }
-
-    //====ゴール座標を0にする/未探索セルを0にする====
-    uint16_t m_step = 0; // 歩数カウンタを0にする
+    //====ゴール座標を起点にする/未探索セルを起点にする====
     if (g_search_mode == SEARCH_MODE_GOAL) {
         // ゴールモード
         if (g_goal_is_start) {
             // 復路: スタート座標を起点(0)にする（ゴール群は無視）
-            smap[START_Y][START_X] = 0;
-            q[q_tail++] = (uint16_t)(START_Y * MAZE_SIZE + START_X);
+            maze_bitboard_seed_set(seed, START_X, START_Y);
         } else {
             // 往路: params.h の複数ゴールを起点(0)にする
-            seed_goals_zero_in_smap();
-            for (y = 0; y <= (MAZE_SIZE - 1); y++) {     // 各Y座標で実行
-                for (x = 0; x <= (MAZE_SIZE - 1); x++) { // 各X座標で実行
-                    if (smap[y][x] == 0) {
-                        q[q_tail++] = (uint16_t)(y * MAZE_SIZE + x);
-                    }
-                }
-            }
+            seed_goals(seed);
         }
     } else {
         // 全面探索: 未探索セルを起点(0)にする
         // スタート区画は強制的に既知扱い（無駄な帰還を防止）
         visited[START_Y][START_X] = true;
+#if SEARCH_FULL_TARGETED
+        // 最短経路を変え得る未探索セル（候補）だけを起点にする
+        full_target_update();
         for (y = 0; y <= (MAZE_SIZE - 1); y++) {     // 各Y座標で実行
             for (x = 0; x <= (MAZE_SIZE - 1); x++) { // 各X座標で実行
-                if (visited[y][x] == false) {
-                    smap[y][x] = 0;
-                    q[q_tail++] = (uint16_t)(y * MAZE_SIZE + x);
+                if (search_target_is_cand(&s_full_target, x, y)) {
+                    maze_bitboard_seed_set(seed, x, y);
                 }
             }
         }
-    }
-
-    //====自分の座標にたどり着くまでループ====
-    while (q_head < q_tail && smap[mouse.y][mouse.x] == 0xffff) {
-        uint16_t idx = q[q_head++];
-        uint8_t cy = (uint8_t)(idx / MAZE_SIZE);
-        uint8_t cx = (uint8_t)(idx - (uint16_t)(cy * MAZE_SIZE));
-        m_step = smap[cy][cx];
-
-        uint8_t m_temp = (uint8_t)map[cy][cx];
-        if (MF.FLAG.SCND) { // 二次走行用のマップを作成する場合（二次走行時はMF.FLAG.SCNDが立っている）
-            m_temp >>= 4;   // 上位4bitを使うので4bit分右にシフトさせる
-        }
-
-        //----北壁についての処理----
-        if (!(m_temp & 0x08) && cy != (MAZE_SIZE - 1)) { // 北壁がなく現在最北端でないとき
-            if (smap[cy + 1][cx] == 0xffff) { // 北側が未記入なら
-                smap[cy + 1][cx] = (uint16_t)(m_step + 1); // 次の歩数を書き込む
-                q[q_tail++] = (uint16_t)((cy + 1) * MAZE_SIZE + cx);
-            }
-        }
-        //----東壁についての処理----
-        if (!(m_temp & 0x04) && cx != (MAZE_SIZE - 1)) { // 東壁がなく現在最東端でないとき
-            if (smap[cy][cx + 1] == 0xffff) { // 東側が未記入なら
-                smap[cy][cx + 1] = (uint16_t)(m_step + 1); // 次の歩数を書き込む
-                q[q_tail++] = (uint16_t)(cy * MAZE_SIZE + (cx + 1));
-            }
-        }
-        //----南壁についての処理----
-        if (!(m_temp & 0x02) && cy != 0) { // 南壁がなく現在最南端でないとき
-            if (smap[cy - 1][cx] == 0xffff) { // 南側が未記入なら
-                smap[cy - 1][cx] = (uint16_t)(m_step + 1); // 次の歩数を書き込む
-                q[q_tail++] = (uint16_t)((cy - 1) * MAZE_SIZE + cx);
-            }
-        }
-        //----西壁についての処理----
-        if (!(m_temp & 0x01) && cx != 0) { // 西壁がなく現在最西端でないとき
-            if (smap[cy][cx - 1] == 0xffff) { // 西側が未記入なら
-                smap[cy][cx - 1] = (uint16_t)(m_step + 1); // 次の歩数を書き込む
-                q[q_tail++] = (uint16_t)(cy * MAZE_SIZE + (cx - 1));
+#else
+        for (y = 0; y <= (MAZE_SIZE - 1); y++) {     // 各Y座標で実行
+            for (x = 0; x <= (MAZE_SIZE - 1); x++) { // 各X座標で実行
+                if (visited[y][x] == false) {
+                    maze_bitboard_seed_set(seed, x, y);
+                }
             }
         }
+#endif
     }
 
-    if (smap[mouse.y][mouse.x] == 0xffff) {
+    //====壁の行ビットボード（write_map() で更新済み）で、自分の座標の歩数まで波面展開====
+    // 二次走行用のマップを作成する場合（MF.FLAG.SCND）は上位4bitの壁を使う
+    uint16_t step = maze_bitboard_flood(&s_map_bb[MF.FLAG.SCND ? 1 : 0], seed, smap, mouse.x, mouse.y);
+
+    if (step == MAZE_BITBOARD_UNREACHED) {
         return (MAZE_SIZE * MAZE_SIZE - 10);
     }
 
-    return smap[mouse.y][mouse.x];
+    return step;
 }
 
 //+++++++++++++++++++++++++++++++++++++++++++++++
@@ -926,94 +1161,9 @@ int make_smap(uint8_t target_x, uint8_t target_y) {
 // 戻り値：なし
 //+++++++++++++++++++++++++++++++++++++++++++++++
 void make_route() {
-    //====変数宣言====
-    uint8_t x, y; // X，Y座標
-    uint8_t dir_temp =
-        mouse.dir; // マウスの方角を表すmouse.dirの値をdir_temp変数に退避させる
-
-    //====最短経路を初期化====
-    uint16_t i;
-    for (i = 0; i < ROUTE_MAX_LEN; i++) {
-        route[i] = 0xffff; // routeを0xffで初期化
-    }
-
-    //====歩数カウンタをセット====
-    uint16_t m_step = smap[mouse.y][mouse.x]; // 現在座標の歩数マップ値を取得
-
-    //====x, yに現在座標を書き込み====
-    x = mouse.x;
-    y = mouse.y;
-
-    //====最短経路を導出====
-    i = 0;
-
-    do {
-        uint8_t m_temp = map[y][x]; // 比較用マップ情報の格納
-
-        if (MF.FLAG
-                .SCND) { // 二次走行用のマップを作成する場合（二次走行時はMF.FLAG.SCNDが立っている）
-            m_temp >>= 4; // 上位4bitを使うので4bit分右にシフトさせる
-        }
-
-        // 次方向の優先順位: 方位固定ではなく、現在向きに対して直進→右→左→後退
-        {
-            static const uint8_t s_rel_priority[4] = {0x00, 0x01, 0x03, 0x02};
-            static const int8_t s_dx[4] = {0, 1, 0, -1};
-            static const int8_t s_dy[4] = {1, 0, -1, 0};
-            static const uint8_t s_wall_mask[4] = {0x08, 0x04, 0x02, 0x01};
-
-            for (uint8_t k = 0; k < 4; k++) {
-                uint8_t rel_dir = s_rel_priority[k];
-                uint8_t abs_dir = (mouse.dir + rel_dir) & 0x03;
-                int16_t nx = (int16_t)x + s_dx[abs_dir];
-                int16_t ny = (int16_t)y + s_dy[abs_dir];
-
-                if ((m_temp & s_wall_mask[abs_dir]) != 0) {
-                    continue;
-                }
-                if (nx < 0 || nx >= MAZE_SIZE || ny < 0 || ny >= MAZE_SIZE) {
-                    continue;
-                }
-                if (smap[ny][nx] < m_step) {
-                    route[i] = rel_dir;
-                    m_step = smap[ny][nx];
-                    x = (uint8_t)nx;
-                    y = (uint8_t)ny;
-                    break;
-                }
-            }
-        }
-
-        //----格納データ形式変更----
-        switch (route[i]) {  // route配列に格納した要素値で分岐
-        case 0x00:           // 前進する場合
-            route[i] = 0x88; // 格納データ形式を変更
-            break;
-        case 0x01:                  // 右折する場合
-            turn_dir(DIR_TURN_R90); // 内部情報の方向を90度右回転
-            route[i] = 0x44;        // 格納データ形式を変更
-
-            break;
-        case 0x02:                  // Uターンする場合
-            turn_dir(DIR_TURN_180); // 内部情報の方向を180度回転
-            route[i] = 0x22;        // 格納データ形式を変更
-
-            break;
-        case 0x03:                  // 左折する場合
-            turn_dir(DIR_TURN_L90); // 内部情報の方向を90度右回転
-            route[i] = 0x11;        // 格納データ形式を変更
-
-            break;
-        default:             // それ以外の場合
-            route[i] = 0x00; // 格納データ形式を変更
-
-            break;
-        }
-        i++; // カウンタをインクリメント
-    } while (smap[y][x] !=
-             0); // 進んだ先の歩数マップ値が0（=ゴール）になるまで実行
-
-    mouse.dir = dir_temp; // dir_tempに退避させた値をmouse.dirにリストア
+    // 現在座標・向きから歩数マップを下る（二次走行時は上位4bitの壁を使う）
+    (void)search_route_build(route, ROUTE_MAX_LEN, smap, map, MF.FLAG.SCND ? 4 : 0, mouse.x,
+                             mouse.y, mouse.dir);
 }
 
 //+++++++++++++++++++++++++++++++++++++++++++++++
@@ -1022,17 +1172,57 @@ void make_route() {
 // 引数：探索区画のXY座標(x,y)
 // 戻り値：なし
 //+++++++++++++++++++++++++++++++++++++++++++++++
-void markVisited(uint8_t x, uint8_t y) { visited[y][x] = true; }
+void markVisited(uint8_t x, uint8_t y) {
+    visited[y][x] = true;
+    step_map_touch(&s_step_map, x, y);
+}
 
 //+++++++++++++++++++++++++++++++++++++++++++++++
 // findClosestUnvisitedCell
 // 最近の未探索区画を選択
+// 全面探索の歩数マップ（起点=探索対象の未探索区画）を (x,y) から下り、
+// 到達した起点を closest_unvisited_x/y に格納する。到達できなければ MAZE_SIZE を格納する
 // 引数：探索区画のXY座標(x,y)
 // 戻り値：なし
 //+++++++++++++++++++++++++++++++++++++++++++++++
 void findClosestUnvisitedCell(uint8_t currentX, uint8_t currentY) {
-    (void)currentX;
-    (void)currentY;
+    static const int8_t s_dx[4] = {0, 1, 0, -1};
+    static const int8_t s_dy[4] = {1, 0, -1, 0};
+    static const uint8_t s_wall_mask[4] = {NORTH_WALL, EAST_WALL, SOUTH_WALL, WEST_WALL};
+    const uint8_t shift = MF.FLAG.SCND ? 4 : 0;
+    uint8_t x = currentX;
+    uint8_t y = currentY;
+
+    closest_unvisited_x = MAZE_SIZE;
+    closest_unvisited_y = MAZE_SIZE;
+    if (x >= MAZE_SIZE || y >= MAZE_SIZE || smap[y][x] == STEP_MAP_UNREACHED) {
+        return;
+    }
+
+    // 歩数は 1 手ごとに 1 ずつ減るので、歩数の回数だけ下れば起点に着く
+    while (smap[y][x] != 0) {
+        const uint8_t walls = (uint8_t)((map[y][x] >> shift) & 0x0f);
+        bool moved = false;
+        for (uint8_t d = 0; d < 4; d++) {
+            const int16_t nx = (int16_t)x + s_dx[d];
+            const int16_t ny = (int16_t)y + s_dy[d];
+            if ((walls & s_wall_mask[d]) != 0 || nx < 0 || nx >= MAZE_SIZE || ny < 0 ||
+                ny >= MAZE_SIZE) {
+                continue;
+            }
+            if (smap[ny][nx] < smap[y][x]) {
+                x = (uint8_t)nx;
+                y = (uint8_t)ny;
+                moved = true;
+                break;
+            }
+        }
+        if (!moved) {
+            return;
+        }
+    }
+    closest_unvisited_x = x;
+    closest_unvisited_y = y;
 }
 
 //+++++++++++++++++++++++++++++++++++++++++++++++
@@ -1069,4 +1259,7 @@ void load_map_from_eeprom(void) {
     if ((START_X + 1) < MAZE_SIZE) {
         map[START_Y][START_X + 1] |= 0x11; // 東隣の西壁も立てる
     }
+
+    map_bitboard_build();
+    step_map_invalidate(&s_step_map);
 }
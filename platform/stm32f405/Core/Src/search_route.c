@@ -0,0 +1,112 @@
+/*
+ * search_route.c
+ *
+ * 探索走行の経路導出と、背景再計算の経路を採用できるかの判定（search.c から利用）
+ * HAL に依存しないため tools/solver_host でも同じソースをビルドして検証する。
+ */
+
+#include "search_route.h"
+
+// 方位（N, E, S, W）ごとの移動量と壁ビット
+static const int8_t s_dx[4] = {0, 1, 0, -1};
+static const int8_t s_dy[4] = {1, 0, -1, 0};
+static const uint8_t s_wall_mask[4] = {0x08, 0x04, 0x02, 0x01};
+// 現在向きに対する相対方向（直進→右→左→後退）と、その動作コード
+static const uint8_t s_rel_priority[4] = {0x00, 0x01, 0x03, 0x02};
+static const uint16_t s_rel_opcode[4] = {0x88, 0x44, 0x22, 0x11};
+
+static inline uint8_t cell_wall(uint16_t map[MAZE_SIZE][MAZE_SIZE], uint8_t shift, int16_t x,
+                                int16_t y) {
+    if (x < 0 || x >= MAZE_SIZE || y < 0 || y >= MAZE_SIZE) {
+        return 0;
+    }
+    return (uint8_t)((map[y][x] >> shift) & 0x0f);
+}
+
+uint16_t search_route_build(uint16_t *route, uint16_t cap, uint16_t smap[MAZE_SIZE][MAZE_SIZE],
+                            uint16_t map[MAZE_SIZE][MAZE_SIZE], uint8_t shift, uint8_t x,
+                            uint8_t y, uint8_t dir) {
+    uint16_t i;
+
+    for (i = 0; i < cap; i++) {
+        route[i] = 0xffff;
+    }
+
+    uint16_t m_step = smap[y][x];
+    i = 0;
+    while (i < cap) {
+        const uint8_t m_temp = cell_wall(map, shift, x, y);
+        bool moved = false;
+
+        for (uint8_t k = 0; k < 4; k++) {
+            const uint8_t rel_dir = s_rel_priority[k];
+            const uint8_t abs_dir = (uint8_t)((dir + rel_dir) & 0x03);
+            const int16_t nx = (int16_t)x + s_dx[abs_dir];
+            const int16_t ny = (int16_t)y + s_dy[abs_dir];
+
+            if ((m_temp & s_wall_mask[abs_dir]) != 0) {
+                continue;
+            }
+            if (nx < 0 || nx >= MAZE_SIZE || ny < 0 || ny >= MAZE_SIZE) {
+                continue;
+            }
+            if (smap[ny][nx] < m_step) {
+                route[i] = s_rel_opcode[rel_dir];
+                dir = abs_dir;
+                m_step = smap[ny][nx];
+                x = (uint8_t)nx;
+                y = (uint8_t)ny;
+                moved = true;
+                break;
+            }
+        }
+
+        if (!moved) {
+            // 下れる区画が無い（歩数マップと壁が食い違っている）
+            route[i++] = 0x00;
+            break;
+        }
+        i++;
+        if (smap[y][x] == 0) {
+            break; // 起点に到達
+        }
+    }
+    return i;
+}
+
+void search_route_walls_save(search_route_walls_t *w, uint16_t map[MAZE_SIZE][MAZE_SIZE],
+                             uint8_t shift, uint8_t x, uint8_t y) {
+    w->wall[4] = cell_wall(map, shift, x, y);
+    for (uint8_t d = 0; d < 4; d++) {
+        w->wall[d] = cell_wall(map, shift, (int16_t)(x + s_dx[d]), (int16_t)(y + s_dy[d]));
+    }
+}
+
+bool search_route_walls_only_added(const search_route_walls_t *w,
+                                   uint16_t map[MAZE_SIZE][MAZE_SIZE], uint8_t shift, uint8_t x,
+                                   uint8_t y) {
+    search_route_walls_t now;
+
+    search_route_walls_save(&now, map, shift, x, y);
+    for (uint8_t k = 0; k < 5; k++) {
+        if ((w->wall[k] & (uint8_t)~now.wall[k]) != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool search_route_first_move_open(const uint16_t *route, uint16_t map[MAZE_SIZE][MAZE_SIZE],
+                                  uint8_t shift, uint8_t x, uint8_t y, uint8_t dir) {
+    uint8_t rel_dir;
+
+    for (rel_dir = 0; rel_dir < 4; rel_dir++) {
+        if (s_rel_opcode[rel_dir] == route[0]) {
+            break;
+        }
+    }
+    if (rel_dir >= 4) {
+        return false;
+    }
+    return (cell_wall(map, shift, x, y) & s_wall_mask[(dir + rel_dir) & 0x03]) == 0;
+}
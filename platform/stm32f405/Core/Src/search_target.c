@@ -0,0 +1,70 @@
+/*
+ * search_target.c
+ *
+ * 全面探索の探索対象（最短経路を変え得る未探索区画）と終了判定（search.c から利用）
+ * HAL に依存しないため tools/solver_host でも同じソースをビルドして検証する。
+ */
+
+#include "search_target.h"
+
+// 32x32 では歩数マップ 2 枚で 4KB になるため、呼び出し側のスタックではなく静的領域に置く
+static maze_bitboard_t s_bb;
+static uint16_t s_from_goal[MAZE_SIZE][MAZE_SIZE];
+static uint16_t s_from_start[MAZE_SIZE][MAZE_SIZE];
+
+void search_target_update(search_target_t *st, uint16_t map[MAZE_SIZE][MAZE_SIZE],
+                          bool visited[MAZE_SIZE][MAZE_SIZE], const maze_row_t goal_seed[MAZE_SIZE],
+                          uint8_t sx, uint8_t sy) {
+    maze_row_t start_seed[MAZE_SIZE] = {0};
+
+    for (uint8_t y = 0; y < MAZE_SIZE; y++) {
+        st->cand[y] = 0;
+    }
+    st->cand_num = 0;
+
+    //====下界: 未知壁を無しとみなした壁で、ゴール起点とスタート起点の歩数====
+    maze_bitboard_build(&s_bb, map, 0);
+    maze_bitboard_flood(&s_bb, goal_seed, s_from_goal, MAZE_BITBOARD_NO_TARGET, 0);
+    maze_bitboard_seed_set(start_seed, sx, sy);
+    maze_bitboard_flood(&s_bb, start_seed, s_from_start, MAZE_BITBOARD_NO_TARGET, 0);
+    st->d_open = (sx < MAZE_SIZE && sy < MAZE_SIZE) ? s_from_goal[sy][sx] : MAZE_BITBOARD_UNREACHED;
+
+    //====候補: 下界の最短経路に乗っている未探索区画====
+    if (st->d_open != MAZE_BITBOARD_UNREACHED) {
+        for (uint8_t y = 0; y < MAZE_SIZE; y++) {
+            for (uint8_t x = 0; x < MAZE_SIZE; x++) {
+                const uint16_t ds = s_from_start[y][x];
+                const uint16_t dg = s_from_goal[y][x];
+                if (visited[y][x] || ds == MAZE_BITBOARD_UNREACHED ||
+                    dg == MAZE_BITBOARD_UNREACHED || (uint32_t)ds + dg != st->d_open) {
+                    continue;
+                }
+                st->cand[y] |= (maze_row_t)1u << x;
+                st->cand_num++;
+            }
+        }
+    }
+
+    //====候補: 未探索のゴール区画（歩数は変えなくても最短走行のゴール進入・延長が決まらない）====
+    uint16_t goal_left = 0;
+    for (uint8_t y = 0; y < MAZE_SIZE; y++) {
+        for (uint8_t x = 0; x < MAZE_SIZE; x++) {
+            if (((goal_seed[y] >> x) & 1u) == 0u || visited[y][x] ||
+                s_from_start[y][x] == MAZE_BITBOARD_UNREACHED) {
+                continue;
+            }
+            goal_left++;
+            if (((st->cand[y] >> x) & 1u) == 0u) {
+                st->cand[y] |= (maze_row_t)1u << x;
+                st->cand_num++;
+            }
+        }
+    }
+
+    //====上界: 未知壁を壁とみなした壁で、ゴールからスタートまでの歩数====
+    // スタートの歩数が決まった波面で止める（s_from_start は候補を取り出したので作業領域に使う）
+    maze_bitboard_build(&s_bb, map, 4);
+    st->d_wall = maze_bitboard_flood(&s_bb, goal_seed, s_from_start, sx, sy);
+
+    st->done = (st->d_open == st->d_wall) && (goal_left == 0);
+}
@@ -8,6 +8,7 @@
 #include "global.h"
 #include "build_info.h"
 #include "nvm_params.h"
+#include "ism330_burst.h"
 
 #ifndef IMU_OFFSET_SETTLE_MS
 #define IMU_OFFSET_SETTLE_MS 400u
@@ -321,13 +322,154 @@ void get_wall_info() {
 // ISM330DHCX support
 //+++++++++++++++++++++++++++++++++++++++++++++++
 
-// 読み出しヘルパ（リトルエンディアン16bit）
-static int16_t read16_le(uint8_t reg_l) {
-    uint8_t lo = read_byte(reg_l);
-    uint8_t hi = read_byte(reg_l + 1);
-    return (int16_t)((int16_t)hi << 8 | lo);
+#ifndef IMU_BURST_USE_DMA
+#define IMU_BURST_USE_DMA 1 // 0: 1kHz 割り込み内でブロッキングのバースト読取
+#endif
+
+// 6軸出力（0x22..0x2D）を 1 回の CS サイクルでまとめて読む。
+// DMA 版は tick 先頭で次のバーストを起動し、制御は前 tick に完了したサンプルを使う（1ms 遅れ）。
+static uint8_t s_imu_burst_tx[ISM330_BURST_XFER_LEN];
+static uint8_t s_imu_burst_rx[ISM330_BURST_XFER_LEN];
+
+#if IMU_BURST_USE_DMA
+// SPI3_RX = DMA1 Stream0 / Channel0, SPI3_TX = DMA1 Stream5 / Channel0
+#define IMU_DMA_RX_STREAM DMA1_Stream0
+#define IMU_DMA_TX_STREAM DMA1_Stream5
+#define IMU_DMA_RX_IRQn DMA1_Stream0_IRQn
+#define IMU_DMA_RX_CLEAR_FLAGS \
+    (DMA_LIFCR_CTCIF0 | DMA_LIFCR_CHTIF0 | DMA_LIFCR_CTEIF0 | DMA_LIFCR_CDMEIF0 | DMA_LIFCR_CFEIF0)
+#define IMU_DMA_TX_CLEAR_FLAGS \
+    (DMA_HIFCR_CTCIF5 | DMA_HIFCR_CHTIF5 | DMA_HIFCR_CTEIF5 | DMA_HIFCR_CDMEIF5 | DMA_HIFCR_CFEIF5)
+#define IMU_DMA_STALL_TICKS 3u // 完了しないまま経過した tick 数がこれに達したら打ち切る
+
+static volatile uint8_t s_imu_burst_inflight; // DMA 転送中
+static volatile uint8_t s_imu_burst_ready;    // 未消費の完了サンプルあり
+static ism330_raw_t s_imu_burst_raw;
+static uint8_t s_imu_burst_stall;
+static volatile uint32_t s_imu_burst_errors;
+
+static void imu_burst_dma_stream_off(DMA_Stream_TypeDef *stream) {
+    stream->CR &= ~DMA_SxCR_EN;
+    while ((stream->CR & DMA_SxCR_EN) != 0U) {
+    }
+}
+
+static void imu_burst_dma_init(void) {
+    __HAL_RCC_DMA1_CLK_ENABLE();
+    imu_burst_dma_stream_off(IMU_DMA_RX_STREAM);
+    imu_burst_dma_stream_off(IMU_DMA_TX_STREAM);
+    DMA1->LIFCR = IMU_DMA_RX_CLEAR_FLAGS;
+    DMA1->HIFCR = IMU_DMA_TX_CLEAR_FLAGS;
+
+    IMU_DMA_RX_STREAM->PAR = (uint32_t)&SPI3->DR;
+    IMU_DMA_RX_STREAM->M0AR = (uint32_t)s_imu_burst_rx;
+    IMU_DMA_RX_STREAM->FCR = 0U; // ダイレクトモード
+    IMU_DMA_RX_STREAM->CR = DMA_SxCR_PL_1 | // ペリフェラル→メモリ, Channel0
+                            DMA_SxCR_MINC |
+                            DMA_SxCR_TCIE |
+                            DMA_SxCR_TEIE;
+
+    IMU_DMA_TX_STREAM->PAR = (uint32_t)&SPI3->DR;
+    IMU_DMA_TX_STREAM->M0AR = (uint32_t)s_imu_burst_tx;
+    IMU_DMA_TX_STREAM->FCR = 0U;
+    IMU_DMA_TX_STREAM->CR = DMA_SxCR_PL_1 | DMA_SxCR_DIR_0 | DMA_SxCR_MINC; // メモリ→ペリフェラル
+
+    s_imu_burst_inflight = 0;
+    s_imu_burst_ready = 0;
+    s_imu_burst_stall = 0;
+
+    // TIM5 と同じ優先度にして、1kHz 制御の途中でサンプルが差し替わらないようにする
+    HAL_NVIC_SetPriority(IMU_DMA_RX_IRQn, 0, 0);
+    HAL_NVIC_EnableIRQ(IMU_DMA_RX_IRQn);
+}
+
+// 転送を終えて CS を上げる（完了・エラー・打ち切り共通）
+static void imu_burst_dma_finish(void) {
+    SPI3->CR2 &= ~(SPI_CR2_RXDMAEN | SPI_CR2_TXDMAEN);
+    imu_burst_dma_stream_off(IMU_DMA_RX_STREAM);
+    imu_burst_dma_stream_off(IMU_DMA_TX_STREAM);
+    while ((SPI3->SR & SPI_SR_BSY) != 0U) {
+    }
+    HAL_GPIO_WritePin(CS_GPIO_Port, CS_Pin, GPIO_PIN_SET); // cs = 1;
+    s_imu_burst_stall = 0;
+    s_imu_burst_inflight = 0;
 }
 
+static void imu_burst_dma_start(void) {
+    if (s_imu_burst_inflight) {
+        // 前回のバーストが終わっていない: この tick は起動せず、長引けば打ち切る
+        if (++s_imu_burst_stall >= IMU_DMA_STALL_TICKS) {
+            s_imu_burst_errors++;
+            imu_burst_dma_finish();
+        }
+        return;
+    }
+
+    DMA1->LIFCR = IMU_DMA_RX_CLEAR_FLAGS;
+    DMA1->HIFCR = IMU_DMA_TX_CLEAR_FLAGS;
+    (void)SPI3->DR; // 残っている RXNE/OVR を捨てる
+    (void)SPI3->SR;
+    IMU_DMA_RX_STREAM->NDTR = ISM330_BURST_XFER_LEN;
+    IMU_DMA_TX_STREAM->NDTR = ISM330_BURST_XFER_LEN;
+
+    s_imu_burst_inflight = 1;
+    HAL_GPIO_WritePin(CS_GPIO_Port, CS_Pin, GPIO_PIN_RESET); // cs = 0;
+    SPI3->CR1 |= SPI_CR1_SPE;
+    IMU_DMA_RX_STREAM->CR |= DMA_SxCR_EN;
+    IMU_DMA_TX_STREAM->CR |= DMA_SxCR_EN;
+    SPI3->CR2 |= SPI_CR2_RXDMAEN | SPI_CR2_TXDMAEN;
+}
+
+// DMA1 Stream0（SPI3 RX）割り込みから呼ぶ。RX 完了 = 最終バイトまで受信済み。
+void IMU_BurstDmaIrqHandler(void) {
+    uint32_t lisr = DMA1->LISR;
+
+    DMA1->LIFCR = IMU_DMA_RX_CLEAR_FLAGS;
+    if (!s_imu_burst_inflight || (lisr & (DMA_LISR_TCIF0 | DMA_LISR_TEIF0)) == 0U) {
+        return;
+    }
+    if ((lisr & DMA_LISR_TEIF0) != 0U) {
+        s_imu_burst_errors++;
+    } else {
+        ism330_burst_decode(s_imu_burst_rx, &s_imu_burst_raw);
+        s_imu_burst_ready = 1;
+    }
+    imu_burst_dma_finish();
+}
+
+// 完了済みの未消費サンプルを取り出す（無ければ false）
+static bool imu_burst_take(ism330_raw_t *raw) {
+    bool fresh = false;
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    if (s_imu_burst_ready) {
+        *raw = s_imu_burst_raw;
+        s_imu_burst_ready = 0;
+        fresh = true;
+    }
+    __set_PRIMASK(primask);
+    return fresh;
+}
+
+uint32_t IMU_BurstErrorCount(void) { return s_imu_burst_errors; }
+#else
+static bool imu_burst_read_blocking(ism330_raw_t *raw) {
+    HAL_StatusTypeDef st;
+    HAL_GPIO_WritePin(CS_GPIO_Port, CS_Pin, GPIO_PIN_RESET); // cs = 0;
+    st = HAL_SPI_TransmitReceive(&hspi3, s_imu_burst_tx, s_imu_burst_rx,
+                                 ISM330_BURST_XFER_LEN, 10);
+    HAL_GPIO_WritePin(CS_GPIO_Port, CS_Pin, GPIO_PIN_SET); // cs = 1;
+    if (st != HAL_OK) {
+        return false;
+    }
+    ism330_burst_decode(s_imu_burst_rx, raw);
+    return true;
+}
+
+void IMU_BurstDmaIrqHandler(void) {}
+uint32_t IMU_BurstErrorCount(void) { return 0; }
+#endif
+
 // ISM330DHCX 初期化
 void ISM330_Init(void) {
     uint8_t who = read_byte(0x0F); // WHO_AM_I
@@ -357,40 +499,42 @@ void ISM330_Init(void) {
     write_byte(0x10, 0x7C);
     HAL_Delay(10);
 
-    set_flag = 1;
-}
+    ism330_burst_tx_frame(s_imu_burst_tx);
+#if IMU_BURST_USE_DMA
+    imu_burst_dma_init();
+#endif
 
-// 感度換算
-static inline float ism330_gyro_dps(int16_t raw) {
-    // FS=4000 dps => 140 mdps/LSB = 0.14 dps/LSB
-    return (float)raw * 0.14f; // [deg/s]
-    // 参考（以前の設定）: FS=2000 dps => 70 mdps/LSB
-    // return (float)raw * 0.07f; // [deg/s]
-}
-static inline float ism330_accel_g(int16_t raw) { // FS=16g => 0.488 mg/LSB
-    return (float)raw * 0.000488f; // [g]
+    set_flag = 1;
 }
 
 void ISM330_DataUpdate(void) {
     if (set_flag == 1) {
-        // Gyro OUT*_G: X 0x22/0x23, Y 0x24/0x25, Z 0x26/0x27
-        float gx = ism330_gyro_dps(read16_le(0x22));
-        float gy = ism330_gyro_dps(read16_le(0x24));
-        float gz = ism330_gyro_dps(read16_le(0x26));
-
-        // Accel OUT*_A: X 0x28/0x29, Y 0x2A/0x2B, Z 0x2C/0x2D
-        float ax = ism330_accel_g(read16_le(0x28));
-        float ay = ism330_accel_g(read16_le(0x2A));
-        float az = ism330_accel_g(read16_le(0x2C));
+        ism330_raw_t raw;
+        ism330_sample_t smp;
+
+#if IMU_BURST_USE_DMA
+        // 前 tick に起動したバーストの結果を取り出してから次を起動する
+        bool fresh = imu_burst_take(&raw);
+        imu_burst_dma_start();
+        if (!fresh) {
+            return; // 新しいサンプルが無い tick は前回値を維持
+        }
+#else
+        if (!imu_burst_read_blocking(&raw)) {
+            return;
+        }
+#endif
+        // Gyro: FS=4000 dps => 140 mdps/LSB, Accel: FS=16g => 0.488 mg/LSB
+        ism330_burst_to_sample(&raw, &smp);
 
         // 既存座標系との整合（ICM実装と同様の符号を暫定適用）
-        omega_x_raw = -gx;
-        omega_y_raw = gy;
-        omega_z_raw = gz;
+        omega_x_raw = -smp.gyro_dps[0];
+        omega_y_raw = smp.gyro_dps[1];
+        omega_z_raw = smp.gyro_dps[2];
 
-        accel_x_raw = -ax;
-        accel_y_raw = ay;
-        accel_z_raw = az;
+        accel_x_raw = -smp.accel_g[0];
+        accel_y_raw = smp.accel_g[1];
+        accel_z_raw = smp.accel_g[2];
 
         // オフセット補正
         omega_x_true = omega_x_raw - omega_x_offset;
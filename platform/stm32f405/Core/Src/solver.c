@@ -21,13 +21,135 @@ typedef enum {
     DIR_UNKNOWN = 4
 } Dir4;
 
-// 2次元座標
+// 2次元座標（迷路外の -1..MAZE_SIZE まで。経路バッファを小さくするため 8bit で持つ）
 typedef struct {
-    int x;
-    int y;
+    int8_t x;
+    int8_t y;
 } Pos2D;
 
-// ノード情報（コストと来歴）
+// 時間最適プロファイルでは、斜め中（ジグザグ）に入ったターンを別の進入状態にする。
+// 斜め中かどうかで以降のターンのコード（斜め出か大回りか）が変わり、同じノードの連続回数として
+// 持つと先に確定した側に上書きされるため。ノード毎の領域が 5/3 倍・来歴が 4bit になるので、
+// RAM に余裕の無い F405 の 32x32（CCM もログで埋まっている）では持たない。
+#ifndef SOLVER_TIME_ZIG_NODES
+#if defined(STM32F405xx) && (MAZE_SIZE > 16)
+#define SOLVER_TIME_ZIG_NODES 0
+#else
+#define SOLVER_TIME_ZIG_NODES 1
+#endif
+#endif
+
+#if SOLVER_TIME_ZIG_NODES
+#define SOLVER_RUN_STATES 5
+#else
+#define SOLVER_RUN_STATES 3
+#endif
+
+// 区画への進入状態（直進で入った / 右折で入った / 左折で入った）
+// 斜め継続（ジグザグ）判定は「直前の曲がり方向」だけで決まるため、
+// (区画, 進入方位, 進入状態) を1ノードとすれば到達方向ごとの候補が上書きされない。
+typedef enum {
+    RUN_STRAIGHT = 0,
+    RUN_TURN_R   = 1,
+    RUN_TURN_L   = 2,
+#if SOLVER_TIME_ZIG_NODES
+    RUN_ZIG_R    = 3,        // 時間最適プロファイル専用: 斜め中に右折で入った
+    RUN_ZIG_L    = 4,        // 同 左折
+#endif
+    RUN_STATE_NUM = SOLVER_RUN_STATES,
+    RUN_FROM_START = SOLVER_RUN_STATES // 来歴専用: 直前がスタート区画
+} RunState;
+
+#define SOLVER_NODE_NUM (MAZE_SIZE * MAZE_SIZE * 4 * RUN_STATE_NUM)
+#if SOLVER_NODE_NUM >= 0xFFFE
+#error "SOLVER_NODE_NUM must fit in uint16_t heap indices"
+#endif
+
+// 連続直進/連続斜めの回数上限（旧実装と同じ 32 で飽和）
+#define SOLVER_RUN_COUNT_MAX 32
+#define NODE_AUX_COUNT_MASK  0x3Fu
+#define NODE_AUX_PRED_SHIFT  6
+
+// 直前ノードの RunState（RUN_FROM_START を含む）の幅。未確定ノードではヒープの補助値に連続回数と並べる
+#if SOLVER_TIME_ZIG_NODES
+#define NODE_PRED_BITS 4
+typedef uint16_t heap_aux_t;
+#else
+#define NODE_PRED_BITS 2
+typedef uint8_t heap_aux_t;
+#endif
+#define NODE_PRED_PER_BYTE (8 / NODE_PRED_BITS)
+#define NODE_PRED_MASK     ((1u << NODE_PRED_BITS) - 1u)
+
+// 未確定集合（ヒープ）の容量。コスト・連続回数・来歴は未確定ノードにしか要らないため、
+// ノード毎ではなくヒープの要素と並べて持つ。最大件数は壁の無い迷路が最悪で
+// （実測 16x16: 269 件, 32x32: 1391 件）、区画数の 1.5 倍（384 / 1536 件）とする。
+// 時間最適プロファイルはターンのコストが直進 1 区画の十数倍あり未確定のノードが多く残るため
+// （斜め中のノードを分けて実測 16x16: 988 件, 32x32: 3235 件）、区画数の 4 倍とする。
+// 溢れた場合は最適性を保証できないが、確定できたゴールの経路か、区画の幅優先探索の経路を返す
+// （solver_stats_t.overflow / fallback で報告する）。
+#ifndef SOLVER_HEAP_CAP
+#if SOLVER_TIME_ZIG_NODES
+#define SOLVER_HEAP_CAP (MAZE_SIZE * MAZE_SIZE * 4)
+#else
+#define SOLVER_HEAP_CAP (MAZE_SIZE * MAZE_SIZE * 3 / 2)
+#endif
+#endif
+#if SOLVER_HEAP_CAP > (MAZE_SIZE * MAZE_SIZE * 4 * SOLVER_RUN_STATES) // RUN_STATE_NUM は enum のため #if では使えない
+#error "SOLVER_HEAP_CAP must not exceed SOLVER_NODE_NUM"
+#endif
+
+// 未確定ノード -> ヒープ内位置の開番地法ハッシュ（線形探査）。表の大きさは 2 のべき乗で、
+// 充填率が 3/4 を超えないようにヒープ容量の 4/3 倍以上を取る。
+#ifndef SOLVER_OPEN_HASH_BITS
+#if SOLVER_HEAP_CAP * 4 / 3 <= 1024
+#define SOLVER_OPEN_HASH_BITS 10
+#elif SOLVER_HEAP_CAP * 4 / 3 <= 2048
+#define SOLVER_OPEN_HASH_BITS 11
+#elif SOLVER_HEAP_CAP * 4 / 3 <= 4096
+#define SOLVER_OPEN_HASH_BITS 12
+#else
+#define SOLVER_OPEN_HASH_BITS 13
+#endif
+#endif
+#define SOLVER_OPEN_HASH_SIZE (1u << SOLVER_OPEN_HASH_BITS)
+#if SOLVER_HEAP_CAP * 4 / 3 > (1 << SOLVER_OPEN_HASH_BITS)
+#error "SOLVER_OPEN_HASH_BITS is too small for SOLVER_HEAP_CAP"
+#endif
+#define OPEN_SLOT_EMPTY 0xFFFFu
+
+// ノード毎に残すのは確定フラグ（1bit）と直前ノードの RunState（2bit。斜め中のノードを分けると 4bit）だけ
+// （32x32 で 4.5KB / 12.5KB）。F405 ではログと同じく CCM に置く（CPU からしか触らないため）
+#if defined(STM32F405xx) && (MAZE_SIZE > 16)
+#define SOLVER_NODE_ATTR __attribute__((section(".ccmram")))
+#else
+#define SOLVER_NODE_ATTR
+#endif
+
+// 大きなワーキング領域はスタックを避け、静的に確保
+SOLVER_NODE_ATTR static uint8_t g_node_closed[(SOLVER_NODE_NUM + 7) / 8];  // 確定済みビット
+SOLVER_NODE_ATTR static uint8_t g_node_pred[(SOLVER_NODE_NUM + NODE_PRED_PER_BYTE - 1) / NODE_PRED_PER_BYTE]; // 直前ノードの RunState
+static uint16_t g_heap[SOLVER_HEAP_CAP];        // 二分ヒープ（ノード番号）
+static float    g_heap_dist[SOLVER_HEAP_CAP];   // g_heap[] と同じ位置に、そのノードの暫定コスト
+static heap_aux_t g_heap_aux[SOLVER_HEAP_CAP];  // 同 bit0-5: 連続回数, bit6-: 直前ノードの RunState
+static uint16_t g_open_slot[SOLVER_OPEN_HASH_SIZE]; // 未確定ノードのヒープ内位置 / OPEN_SLOT_EMPTY
+static uint16_t g_heap_len;
+static solver_stats_t g_stats;                  // 直近の探索の統計（solver_get_stats）
+static solver_clock_fn g_clock = NULL;          // 段階ごとの時間計測（未設定なら測らない）
+static float    g_goal_cost;                    // 直近 shortest_path() のゴール到達コスト
+static const Pos2D *g_search_goals;             // 探索中のゴール区画（時間最適プロファイルの終端の時間用）
+static int      g_search_goal_num;
+static int      g_goal_index = -1;              // 直近の探索で選ばれたゴール（候補配列の添字）
+static Pos2D    g_last_goal_bl = { -1, -1 };    // 直近 solver_build_path() の採用ゴール（bottom-left）
+
+// 複数ゴールのスロット数（GOAL1..GOAL9）と、ゴール間のコスト同点判定幅
+#define SOLVER_GOAL_NUM        SOLVER_GOAL_SLOTS
+#define SOLVER_GOAL_COST_EPS   0.001f
+// 同点判定の連鎖（スロット順に比較）で採用コストが動き得る上限
+#define SOLVER_GOAL_TIE_WINDOW (SOLVER_GOAL_COST_EPS * (float)SOLVER_GOAL_NUM)
+
+#if SOLVER_ENABLE_LEGACY_SCAN
+// 旧実装のノード情報（コストと来歴）。ホスト比較用にのみ残す。
 typedef struct {
     float dist;              // スタートからの距離（コスト）
     bool visited;            // 訪問フラグ
@@ -38,8 +160,15 @@ typedef struct {
     int straight_count;      // 連続直線回数
 } NodeCost;
 
-// 大きなワーキング領域はスタックを避け、静的に確保
 static NodeCost g_nodes[MAZE_SIZE][MAZE_SIZE];
+static uint8_t g_solver_impl = SOLVER_IMPL_MULTI_GOAL;
+static int shortest_path_legacy_scan(Pos2D start, Pos2D goal, Pos2D *out_path, int out_cap, const SolverCaseParams_t* sp);
+// 直近 solver_build_path() の走行パスコンパイラへの入力（従来の段ごとの書き換えとの照合用）
+static uint16_t g_last_moves[ROUTE_MAX_LEN];
+static uint16_t g_last_move_num;
+static int g_last_path_type;
+static int shortest_path_per_goal(Pos2D start, const Pos2D *goals, int goal_num, const SolverCaseParams_t* sp);
+#endif
 
 #ifndef SOLVER_PATH_BUF_LEN
 #define SOLVER_PATH_BUF_LEN (MAZE_SIZE * MAZE_SIZE + MAZE_SIZE)
@@ -47,6 +176,12 @@ static NodeCost g_nodes[MAZE_SIZE][MAZE_SIZE];
 
 static Pos2D    g_path_buf[SOLVER_PATH_BUF_LEN];
 
+uint8_t solver_goals[SOLVER_GOAL_SLOTS][2] = {
+    {GOAL1_X, GOAL1_Y}, {GOAL2_X, GOAL2_Y}, {GOAL3_X, GOAL3_Y},
+    {GOAL4_X, GOAL4_Y}, {GOAL5_X, GOAL5_Y}, {GOAL6_X, GOAL6_Y},
+    {GOAL7_X, GOAL7_Y}, {GOAL8_X, GOAL8_Y}, {GOAL9_X, GOAL9_Y},
+};
+
 // 旧dijkstra.h への依存を避けるためのフォールバック定義
 #ifndef MOVE_NORTH
 #define MOVE_NORTH 100
@@ -86,6 +221,8 @@ static Pos2D    g_path_buf[SOLVER_PATH_BUF_LEN];
 static inline bool in_bounds(int x, int y);
 static bool can_move_cell(Pos2D cur, Pos2D nxt);
 static int shortest_path(Pos2D start, Pos2D goal, Pos2D *out_path, int out_cap, const SolverCaseParams_t* sp);
+static int shortest_path_multi_goal(Pos2D start, const Pos2D *goals, int goal_num,
+                                    Pos2D *out_path, int out_cap, const SolverCaseParams_t* sp);
 
 static inline Dir4 get_dir(Pos2D from, Pos2D to) {
     int dx = to.x - from.x;
@@ -102,48 +239,46 @@ static inline bool in_bounds(int x, int y) {
     return (x >= 0 && x < MAZE_SIZE && y >= 0 && y < MAZE_SIZE);
 }
 
-// dijkstra.c の convertPathCellToRun と同等の処理をローカルに実装
-static void convertDirectionTokensToRun(void) {
-    int8_t Direction = NORTH;
-    for (int i = 0; i < ROUTE_MAX_LEN; i++) {
-
-        if (path[i] - 100 == Direction) {
-            // 直進
-            path[i] = STRAIGHT;
-        } else if (path[i] == MOVE_EAST) {
-            if (Direction == NORTH) {
-                path[i] = TURN_R;
-            } else if (Direction == SOUTH) {
-                path[i] = TURN_L;
-            }
-            Direction = EAST;
-        } else if (path[i] == MOVE_SOUTH) {
-            if (Direction == EAST) {
-                path[i] = TURN_R;
-            } else if (Direction == WEST) {
-                path[i] = TURN_L;
-            }
-            Direction = SOUTH;
-        } else if (path[i] == MOVE_WEST) {
-            if (Direction == SOUTH) {
-                path[i] = TURN_R;
-            } else if (Direction == NORTH) {
-                path[i] = TURN_L;
-            }
-            Direction = WEST;
-        } else if (path[i] == MOVE_NORTH) {
-            if (Direction == WEST) {
-                path[i] = TURN_R;
-            } else if (Direction == EAST) {
-                path[i] = TURN_L;
-            }
-            Direction = NORTH;
-        } else {
-            // 0 or others
+// 区画の移動方向（MOVE_*）を直進・右左折（STRAIGHT / TURN_R / TURN_L）に変換する
+// （dijkstra.c の convertPathCellToRun と同等。逆走は起きないのでそのまま返す）
+static uint16_t move_to_run(uint16_t move, int8_t *direction) {
+    uint16_t run = move;
+    if (move - 100 == *direction) {
+        // 直進
+        return STRAIGHT;
+    } else if (move == MOVE_EAST) {
+        if (*direction == NORTH) {
+            run = TURN_R;
+        } else if (*direction == SOUTH) {
+            run = TURN_L;
+        }
+        *direction = EAST;
+    } else if (move == MOVE_SOUTH) {
+        if (*direction == EAST) {
+            run = TURN_R;
+        } else if (*direction == WEST) {
+            run = TURN_L;
+        }
+        *direction = SOUTH;
+    } else if (move == MOVE_WEST) {
+        if (*direction == SOUTH) {
+            run = TURN_R;
+        } else if (*direction == NORTH) {
+            run = TURN_L;
+        }
+        *direction = WEST;
+    } else if (move == MOVE_NORTH) {
+        if (*direction == WEST) {
+            run = TURN_R;
+        } else if (*direction == EAST) {
+            run = TURN_L;
         }
+        *direction = NORTH;
     }
+    return run;
 }
 
+#if SOLVER_ENABLE_LEGACY_SCAN
 // ゴール進入時の直進区画数を計算（経路の末尾から同じ方向が続く区画数）
 static int calc_goal_approach_straight(Pos2D *path_buf, int path_len) {
     if (path_len < 2) return 0;
@@ -165,33 +300,26 @@ static int calc_goal_approach_straight(Pos2D *path_buf, int path_len) {
     }
     return straight_count;
 }
+#endif
 
 bool solver_build_path(uint8_t mode, uint8_t case_index) {
     // 最短走行パラメータからソルバプロファイルを設定
-    const ShortestRunCaseParams_t* cp = NULL;
-    uint8_t idx = (case_index >= 1) ? (case_index - 1) : 0;
-    switch (mode) {
-        case 2: cp = &shortestRunCaseParamsMode2[idx > 8 ? 8 : idx]; break;
-        case 3: cp = &shortestRunCaseParamsMode3[idx > 8 ? 8 : idx]; break;
-        case 4: cp = &shortestRunCaseParamsMode4[idx > 8 ? 8 : idx]; break;
-        case 5: cp = &shortestRunCaseParamsMode5[idx > 8 ? 8 : idx]; break;
-        case 6: cp = &shortestRunCaseParamsMode6[idx > 8 ? 8 : idx]; break;
-        case 7: cp = &shortestRunCaseParamsMode7[idx > 8 ? 8 : idx]; break;
-        default: cp = &shortestRunCaseParamsMode2[0]; break;
-    }
+    const ShortestRunModeParams_t *pm = NULL;
+    const ShortestRunCaseParams_t *cp = NULL;
+    solver_get_shortest_params(mode, case_index, &pm, &cp);
     solver_set_profile(cp->solver_profile);
 
+    const uint32_t t_begin = (g_clock != NULL) ? g_clock() : 0U;
+
     // 壁・迷路を構築
+    // 確定壁（上位4bit）を top-left 原点の maze[][] へ直接写す
+    // （32x32 で 1KB になる作業用配列をスタックに取らない）
     load_map_from_eeprom();
-    uint8_t fixedMap[MAZE_SIZE][MAZE_SIZE];
-    initializeMaze(fixedMap);
     for (int y = 0; y < MAZE_SIZE; y++) {
         for (int x = 0; x < MAZE_SIZE; x++) {
-            fixedMap[y][x] = (map[y][x] >> 4) & 0x0F;
+            maze[MAZE_SIZE - 1 - y][x] = (uint8_t)((map[y][x] >> 4) & 0x0F);
         }
     }
-    reverseArrayYAxis(fixedMap);
-    setMazeWalls(fixedMap);
     correctWallInconsistencies();
 
     // 経路マーキング配列をクリア
@@ -208,70 +336,59 @@ bool solver_build_path(uint8_t mode, uint8_t case_index) {
     // ケースパラメータ取得
     const SolverCaseParams_t* sp = solver_get_case_params(mode, case_index);
 
-    // 複数ゴール座標を定義
-    const uint8_t goals[9][2] = {
-        {GOAL1_X, GOAL1_Y}, {GOAL2_X, GOAL2_Y}, {GOAL3_X, GOAL3_Y},
-        {GOAL4_X, GOAL4_Y}, {GOAL5_X, GOAL5_Y}, {GOAL6_X, GOAL6_Y},
-        {GOAL7_X, GOAL7_Y}, {GOAL8_X, GOAL8_Y}, {GOAL9_X, GOAL9_Y},
-    };
+    // 有効なゴール座標を列挙（bottom-left -> top-left）
+    Pos2D goal_list[SOLVER_GOAL_NUM];
+    int goal_num = 0;
+    for (int g = 0; g < SOLVER_GOAL_NUM; g++) {
+        uint8_t gx = solver_goals[g][0];
+        uint8_t gy = solver_goals[g][1];
 
-    // 全ゴール座標を探索し、最適な経路を選択
-    float best_cost = FLT_MAX;
-    int best_straight = 0;
-    Pos2D best_goal_tl = { -1, -1 };
-    
-    for (int g = 0; g < 9; g++) {
-        uint8_t gx = goals[g][0];
-        uint8_t gy = goals[g][1];
-        
         // (0,0) は未使用スロットとして無視
         if (gx == 0 && gy == 0) continue;
         if (gx >= MAZE_SIZE || gy >= MAZE_SIZE) continue;
-        
-        // ゴール座標を変換（bottom-left -> top-left）
-        Pos2D goal_tl = { gx, MAZE_SIZE - 1 - gy };
-        
-        // 経路探索
-        int path_len = shortest_path(start_tl, goal_tl, g_path_buf,
-                                     (int)(sizeof(g_path_buf) / sizeof(g_path_buf[0])), sp);
-        
-        if (path_len <= 0) continue;
-        
-        // このゴールへの経路コストを取得
-        float cost = g_nodes[goal_tl.y][goal_tl.x].dist;
-        
-        // ゴール進入時の直進区画数を計算
-        int approach_straight = calc_goal_approach_straight(g_path_buf, path_len);
-        
-        // 最適経路の選択：コストが小さい、または同じコストで直進距離が長い
-        bool is_better = false;
-        if (cost < best_cost - 0.001f) {
-            is_better = true;
-        } else if (cost < best_cost + 0.001f && approach_straight > best_straight) {
-            is_better = true;
-        }
-        
-        if (is_better) {
-            best_cost = cost;
-            best_straight = approach_straight;
-            best_goal_tl = goal_tl;
+
+        goal_list[goal_num].x = gx;
+        goal_list[goal_num].y = MAZE_SIZE - 1 - gy;
+        goal_num++;
+    }
+
+    // 全ゴール座標を1回の探索で評価し、最適なゴールと g_path_buf を確定させる
+    const int path_cap = (int)(sizeof(g_path_buf) / sizeof(g_path_buf[0]));
+    int path_len;
+#if SOLVER_ENABLE_LEGACY_SCAN
+    if (g_solver_impl != SOLVER_IMPL_MULTI_GOAL) {
+        path_len = shortest_path_per_goal(start_tl, goal_list, goal_num, sp);
+    } else
+#endif
+    {
+        path_len = shortest_path_multi_goal(start_tl, goal_list, goal_num, g_path_buf, path_cap, sp);
+        if (sp->time != NULL && g_stats.overflow > 0) {
+            // 時間最適プロファイルの未確定集合が溢れた（斜め中のノードを分けない構成の壁の少ない迷路）ときは、
+            // 容量に収まる標準プロファイルで引き直す
+            uint32_t overflow = g_stats.overflow;
+            sp = solver_get_profile_params(SOLVER_PROFILE_STANDARD, mode, case_index);
+            path_len = shortest_path_multi_goal(start_tl, goal_list, goal_num, g_path_buf, path_cap, sp);
+            g_stats.overflow += overflow;
         }
     }
+    const uint32_t t_search = (g_clock != NULL) ? g_clock() : 0U;
+    g_stats.search_us = t_search - t_begin;
+    g_stats.path_us = 0U;
 
     // 初期化
     for (int i = 0; i < ROUTE_MAX_LEN; i++) path[i] = 0;
+#if SOLVER_ENABLE_LEGACY_SCAN
+    g_last_move_num = 0;
+#endif
+    g_last_goal_bl.x = -1;
+    g_last_goal_bl.y = -1;
 
-    if (best_goal_tl.x < 0) {
+    if (path_len <= 0 || g_goal_index < 0) {
         // 経路無し
         return false;
     }
-
-    // 最適ゴールに対して再探索し、g_path_buf を確定させる（best_path_buf を持たない）
-    int path_len = shortest_path(start_tl, best_goal_tl, g_path_buf,
-                                 (int)(sizeof(g_path_buf) / sizeof(g_path_buf[0])), sp);
-    if (path_len <= 0) {
-        return false;
-    }
+    g_last_goal_bl.x = goal_list[g_goal_index].x;
+    g_last_goal_bl.y = MAZE_SIZE - 1 - goal_list[g_goal_index].y;
 
     // path_cell マーキング（bottom-leftで保持）
     for (int i = 0; i < path_len; i++) {
@@ -283,59 +400,42 @@ bool solver_build_path(uint8_t mode, uint8_t case_index) {
         }
     }
 
-    // 方向トークンを path[] に格納（MOVE_*）
+    // モード共通パラメータから path_type を決定（小回り / 大回り / 斜め）
+    int path_type = solver_path_type(pm, case_index);
+
+    // 区画の移動方向 -> 直進・右左折 を 1 つずつ走行パスコンパイラに渡し、
+    // 直進まとめ・大回り・斜め変換と、スタート直後の大回りの正規化
+    // （first_sectionA と組み合わせると加速要求が厳しいため小回り+半区画直進にする）を 1 回の走査で行う
+    path_compiler_t comp;
+    path_compile_begin(&comp, path_type);
+    int8_t direction = NORTH;
     uint16_t pc = 0;
     for (int i = 1; i < path_len; i++) {
         int dx = g_path_buf[i].x - g_path_buf[i-1].x;
         int dy = g_path_buf[i].y - g_path_buf[i-1].y; // top-left基準
+        uint16_t move;
         if (pc >= ROUTE_MAX_LEN) break;
-        if (dx == 1 && dy == 0)      path[pc++] = MOVE_EAST;
-        else if (dx == -1 && dy == 0)path[pc++] = MOVE_WEST;
-        else if (dx == 0 && dy == -1)path[pc++] = MOVE_NORTH; // 上へ
-        else if (dx == 0 && dy == 1) path[pc++] = MOVE_SOUTH; // 下へ
-    }
-
-    // 方向→走行パスへ変換
-    convertDirectionTokensToRun();
-
-    // makePath と同様の後段処理
-    // モード共通パラメータから path_type を決定
-    const ShortestRunModeParams_t *pm = NULL;
-    switch (mode) {
-        case 2: pm = &shortestRunModeParams2; break;
-        case 3: pm = &shortestRunModeParams3; break;
-        case 4: pm = &shortestRunModeParams4; break;
-        case 5: pm = &shortestRunModeParams5; break;
-        case 6: pm = &shortestRunModeParams6; break;
-        case 7: pm = &shortestRunModeParams7; break;
-        default: pm = &shortestRunModeParams2; break;
-    }
-    // case1 は小回り（makepath_type_case3）、case3 は大回り（makepath_type_case47）
-    int path_type = (case_index == 1) ? pm->makepath_type_case3 : pm->makepath_type_case47;
-    // case8/9 は斜め走行を有効化
-    if (case_index >= 8) {
-        path_type = 2;
-    }
-
-    simplifyPath();
-    if (path_type > 0) {
-        convertLTurn();
-    }
-
-    // デバッグ表示（必要に応じて）
-    for (int i = 0; i < ROUTE_MAX_LEN && path[i] != 0; i++) {
-        printf("%d ", path[i]);
+        if (dx == 1 && dy == 0)      move = MOVE_EAST;
+        else if (dx == -1 && dy == 0)move = MOVE_WEST;
+        else if (dx == 0 && dy == -1)move = MOVE_NORTH; // 上へ
+        else if (dx == 0 && dy == 1) move = MOVE_SOUTH; // 下へ
+        else continue;
+        const uint16_t run = move_to_run(move, &direction);
+#if SOLVER_ENABLE_LEGACY_SCAN
+        g_last_moves[pc] = run;
+#endif
+        pc++;
+        path_compile_push(&comp, run);
     }
-    printf("\n");
-
-    if (path_type > 1) {
-        convertDiagonal();
+    path_compile_end(&comp);
+#if SOLVER_ENABLE_LEGACY_SCAN
+    g_last_move_num = pc;
+    g_last_path_type = path_type;
+#endif
+    if (g_clock != NULL) {
+        g_stats.path_us = g_clock() - t_search;
     }
 
-    // スタート直後の大回りターンは first_sectionA と組み合わせると加速要求が厳しいため、
-    // 小回り+半区画直進へ正規化する。
-    normalizeStartLargeTurnException();
-
     printMaze();
 
     for (int i = 0; i < ROUTE_MAX_LEN && path[i] != 0; i++) {
@@ -413,6 +513,734 @@ static bool can_move_cell(Pos2D cur, Pos2D nxt) {
     return false;
 }
 
+// ゴール到達後、最後の方向に沿って壁に当たるまで延長（視認性向上用）
+static int extend_path_after_goal(Pos2D *path, int length, Dir4 last_dir) {
+    if (length <= 0 || last_dir == DIR_UNKNOWN) return length;
+    Pos2D cur = path[length - 1];
+    int extend = 0;
+    while (extend < MAZE_SIZE) {
+        Pos2D nxt = cur;
+        switch (last_dir) {
+            case DIR_NORTH: nxt.y -= 1; break; // 北はy-1
+            case DIR_EAST:  nxt.x += 1; break;
+            case DIR_SOUTH: nxt.y += 1; break; // 南はy+1
+            case DIR_WEST:  nxt.x -= 1; break;
+            default: return length;
+        }
+        if (!can_move_cell(cur, nxt)) break;
+        if (length < (SOLVER_PATH_BUF_LEN - 1)) {
+            path[length++] = nxt;
+        } else {
+            break;
+        }
+        cur = nxt;
+        extend++;
+    }
+    return length;
+}
+
+
+// ノード番号 <-> (区画, 進入方位, 進入状態)
+static inline uint16_t node_index(int x, int y, int dir, int run) {
+    return (uint16_t)((((y * MAZE_SIZE) + x) * 4 + dir) * RUN_STATE_NUM + run);
+}
+
+static inline void node_decode(uint16_t node, int *x, int *y, int *dir, int *run) {
+    int cell_dir = node / RUN_STATE_NUM;
+    int cell = cell_dir >> 2;
+    *run = node - cell_dir * RUN_STATE_NUM;
+    *dir = cell_dir & 0x03;
+    *y = cell / MAZE_SIZE;
+    *x = cell - (*y) * MAZE_SIZE;
+}
+
+// 曲がった方向（斜め中の進入状態も右折 / 左折に戻す）
+static inline int run_turn(int run) {
+#if SOLVER_TIME_ZIG_NODES
+    if (run >= RUN_ZIG_R) return run - (RUN_ZIG_R - RUN_TURN_R);
+#endif
+    return run;
+}
+
+// 進入状態から直前ノードの進入方位を求める（右折で入った = 直前は左隣の方位）
+static inline int pred_heading(int dir, int run) {
+    run = run_turn(run);
+    if (run == RUN_TURN_R) return (dir + 3) & 0x03;
+    if (run == RUN_TURN_L) return (dir + 1) & 0x03;
+    return dir;
+}
+
+static inline bool node_is_closed(uint16_t node) {
+    return (g_node_closed[node >> 3] & (1u << (node & 0x07))) != 0;
+}
+
+static inline int node_pred(uint16_t node) {
+    return (g_node_pred[node / NODE_PRED_PER_BYTE] >> ((node % NODE_PRED_PER_BYTE) * NODE_PRED_BITS)) & NODE_PRED_MASK;
+}
+
+static inline void node_close(uint16_t node, int pred_run) {
+    int shift = (node % NODE_PRED_PER_BYTE) * NODE_PRED_BITS;
+    uint8_t *p = &g_node_pred[node / NODE_PRED_PER_BYTE];
+    g_node_closed[node >> 3] |= (uint8_t)(1u << (node & 0x07));
+    *p = (uint8_t)((*p & ~(NODE_PRED_MASK << shift)) | ((unsigned)pred_run << shift));
+}
+
+// ノード番号の乗算ハッシュ（連番のノードが表全体に散るように）
+static inline uint16_t open_home(uint16_t node) {
+    return (uint16_t)(((uint32_t)node * 2654435761u) >> (32 - SOLVER_OPEN_HASH_BITS));
+}
+
+// 未確定ノードの表の位置を返す。無ければ空きスロット（登録先）を返す
+static uint16_t open_find(uint16_t node) {
+    uint16_t i = open_home(node);
+    while (g_open_slot[i] != OPEN_SLOT_EMPTY && g_heap[g_open_slot[i]] != node) {
+        i = (uint16_t)((i + 1) & (SOLVER_OPEN_HASH_SIZE - 1));
+    }
+    return i;
+}
+
+// 表から取り除き、後続の探査列を詰め直す（墓標を残さない線形探査の削除）
+static void open_remove(uint16_t slot) {
+    uint16_t i = slot;
+    uint16_t j = slot;
+    while (1) {
+        j = (uint16_t)((j + 1) & (SOLVER_OPEN_HASH_SIZE - 1));
+        if (g_open_slot[j] == OPEN_SLOT_EMPTY) break;
+        // j の要素の本来の位置が (i, j] にあれば動かさない
+        uint16_t home = open_home(g_heap[g_open_slot[j]]);
+        if (((j - home) & (SOLVER_OPEN_HASH_SIZE - 1)) < ((j - i) & (SOLVER_OPEN_HASH_SIZE - 1))) continue;
+        g_open_slot[i] = g_open_slot[j];
+        i = j;
+    }
+    g_open_slot[i] = OPEN_SLOT_EMPTY;
+}
+
+// ヒープ位置 pos に要素を置き、表の位置も合わせる（slot が既知なら探査しない）
+static inline void heap_place(uint16_t pos, uint16_t node, float dist, heap_aux_t aux, uint16_t slot) {
+    g_heap[pos] = node;
+    g_heap_dist[pos] = dist;
+    g_heap_aux[pos] = aux;
+    g_open_slot[slot] = pos;
+}
+
+// 比較・移動の順序は位置を入れ替えていく二分ヒープと同じ（穴を動かし、最後に 1 回だけ書く）
+static void heap_sift_up(uint16_t pos, uint16_t slot) {
+    uint16_t node = g_heap[pos];
+    float dist = g_heap_dist[pos];
+    heap_aux_t aux = g_heap_aux[pos];
+    while (pos > 0) {
+        uint16_t parent = (uint16_t)((pos - 1) >> 1);
+        if (!(dist < g_heap_dist[parent])) break;
+        uint16_t pnode = g_heap[parent];
+        heap_place(pos, pnode, g_heap_dist[parent], g_heap_aux[parent], open_find(pnode));
+        pos = parent;
+    }
+    heap_place(pos, node, dist, aux, slot);
+}
+
+static void heap_sift_down(uint16_t pos, uint16_t slot) {
+    uint16_t node = g_heap[pos];
+    float dist = g_heap_dist[pos];
+    heap_aux_t aux = g_heap_aux[pos];
+    while (1) {
+        uint16_t l = (uint16_t)(pos * 2 + 1);
+        uint16_t r = (uint16_t)(l + 1);
+        uint16_t m = pos;
+        float md = dist;
+        if (l < g_heap_len && g_heap_dist[l] < md) { m = l; md = g_heap_dist[l]; }
+        if (r < g_heap_len && g_heap_dist[r] < md) { m = r; md = g_heap_dist[r]; }
+        if (m == pos) break;
+        uint16_t mnode = g_heap[m];
+        heap_place(pos, mnode, md, g_heap_aux[m], open_find(mnode));
+        pos = m;
+    }
+    heap_place(pos, node, dist, aux, slot);
+}
+
+// 先頭ノードを確定させて返す（確定コストは *dist、連続回数は *count へ）
+static uint16_t heap_pop(float *dist, int *count) {
+    uint16_t top = g_heap[0];
+    heap_aux_t aux = g_heap_aux[0];
+    *dist = g_heap_dist[0];
+    *count = aux & NODE_AUX_COUNT_MASK;
+    open_remove(open_find(top));
+    g_heap_len--;
+    if (g_heap_len > 0) {
+        uint16_t last = g_heap[g_heap_len];
+        uint16_t slot = open_find(last);
+        heap_place(0, last, g_heap_dist[g_heap_len], g_heap_aux[g_heap_len], slot);
+        heap_sift_down(0, slot);
+    }
+    node_close(top, aux >> NODE_AUX_PRED_SHIFT);
+    g_stats.closed++;
+    return top;
+}
+
+// コストが下がる（同コストなら連続回数が伸びる）場合のみ更新し、ヒープへ登録/キー減少
+static void relax_node(uint16_t node, float nd, int count, int pred_run) {
+    if (node_is_closed(node)) return;
+    uint16_t slot = open_find(node);
+    uint16_t pos = g_open_slot[slot];
+    if (pos != OPEN_SLOT_EMPTY) {
+        float od = g_heap_dist[pos];
+        if (nd > od) return;
+        if (nd == od && count <= (int)(g_heap_aux[pos] & NODE_AUX_COUNT_MASK)) return;
+    } else {
+        if (g_heap_len >= SOLVER_HEAP_CAP) {
+            g_stats.overflow++;
+            return;
+        }
+        pos = g_heap_len++;
+        if (g_heap_len > g_stats.heap_peak) g_stats.heap_peak = g_heap_len;
+    }
+    heap_place(pos, node, nd, (heap_aux_t)(count | (pred_run << NODE_AUX_PRED_SHIFT)), slot);
+    heap_sift_up(pos, slot);
+}
+
+// top-left原点に合わせて dy を定義（Dir4順：N,E,S,W）
+static const int k_dx[4] = {0, 1, 0, -1};
+static const int k_dy[4] = {-1, 0, 1, 0};
+
+// 時間最適プロファイル（sp->time）の連続回数の使い方。ターンのコード（大回り・斜め入り/出・V90）は
+// 直前 2 回の移動で決まるため、ターン状態のノードでは連続回数の代わりに直前の並びの種類を持つ。
+//   直進: ターン後の直進区画数（1..32）、スタートからの直進は TIME_COUNT_START + 区画数 - 1。
+//         45°出 / 135°出の後の 1 区画目は TIME_COUNT_DIAG_S1 / TIME_COUNT_DIAG_PAIR_S1
+//   ターン: TIME_TURN_SINGLE（直進の後）/ TIME_TURN_PAIR（直進の後の同方向 2 回目）/
+//           TIME_TURN_DIAG_PAIR（斜めの後の同方向）/ TIME_TURN_DIAG + 斜め回数（斜め中）。
+//           1 区画だけの直進の後は、その直進が S1 として残るかどうかが次のターンのコードで決まるため
+//           TIME_TURN_START（スタートから）/ TIME_TURN_SINGLE_S1（大回りの後）/
+//           TIME_TURN_PAIR_S1（その同方向 2 回目）/ TIME_TURN_DIAG_S1（45°出の後）で区別する
+#define TIME_COUNT_START        (SOLVER_RUN_COUNT_MAX + 1)
+#define TIME_COUNT_START_MAX    ((int)NODE_AUX_COUNT_MASK - 2)
+#define TIME_COUNT_DIAG_S1      ((int)NODE_AUX_COUNT_MASK - 1)
+#define TIME_COUNT_DIAG_PAIR_S1 ((int)NODE_AUX_COUNT_MASK)
+#define TIME_TURN_SINGLE        1
+#define TIME_TURN_PAIR          2
+#define TIME_TURN_DIAG_PAIR     3
+#define TIME_TURN_START         4
+#define TIME_TURN_SINGLE_S1     5
+#define TIME_TURN_PAIR_S1       6
+#define TIME_TURN_DIAG_S1       7
+#define TIME_TURN_DIAG          8
+
+// 探索領域を初期化し、スタートからの初回移動（方位に関わらず通常コスト）を登録
+static void dijkstra_begin(Pos2D start, const SolverCaseParams_t* sp) {
+    memset(g_node_closed, 0, sizeof(g_node_closed));
+    memset(g_open_slot, 0xFF, sizeof(g_open_slot));
+    g_heap_len = 0;
+    g_stats.heap_peak = 0;
+    g_stats.closed = 0;
+    g_stats.overflow = 0;
+    g_stats.fallback = SOLVER_FALLBACK_NONE;
+
+    for (int d = 0; d < 4; d++) {
+        Pos2D nxt = { start.x + k_dx[d], start.y + k_dy[d] };
+        if (!can_move_cell(start, nxt)) continue;
+        relax_node(node_index(nxt.x, nxt.y, d, RUN_STRAIGHT), sp->move_cost_normal,
+                   (sp->time != NULL) ? TIME_COUNT_START : 0, RUN_FROM_START);
+    }
+}
+
+// 直進継続 / ジグザグ継続の 1 区画のコスト
+static inline float straight_move_cost(const SolverCaseParams_t* sp, int count) {
+    float cost = sp->move_cost_straight - sp->straight_discount * (float)count;
+    return (cost < sp->move_cost_min) ? sp->move_cost_min : cost;
+}
+
+static inline float diagonal_move_cost(const SolverCaseParams_t* sp, int count) {
+    float cost = sp->move_cost_diagonal - sp->diagonal_discount * (float)count;
+    return (cost < sp->move_cost_min) ? sp->move_cost_min : cost;
+}
+
+static inline float time_table(const float *table, int n) {
+    return table[(n < SOLVER_TIME_TABLE_LEN) ? n : (SOLVER_TIME_TABLE_LEN - 1)];
+}
+
+// ターンの後に直進へ出るときに決まるターンのコードの残り
+static float time_turn_exit(const SolverTimeCosts_t *tc, int count) {
+    switch (count) {
+        case TIME_TURN_SINGLE:
+        case TIME_TURN_SINGLE_S1: return tc->single_exit;
+        case TIME_TURN_START:     return tc->start_exit;
+        case TIME_TURN_PAIR:
+        case TIME_TURN_PAIR_S1:   return tc->pair_exit;
+        case TIME_TURN_DIAG_PAIR: return tc->diag_pair_exit;
+        case TIME_TURN_DIAG_S1:   return tc->single_exit + tc->s1_half; // [45°出, S1, 大回り]
+        default:                  return tc->diag_exit;
+    }
+}
+
+// ターン後の直進の区画数（45°出 / 135°出の後の 1 区画目も 1 区画）
+static inline int time_straight_count(int count) {
+    return (count > SOLVER_RUN_COUNT_MAX) ? 1 : count;
+}
+
+// 時間最適プロファイルの 1 移動のコストと、移動後の連続回数
+static float time_move_cost(const SolverTimeCosts_t *tc, int crun, int count, int nrun, int *ncount) {
+    if (crun == RUN_STRAIGHT) {
+        if (nrun != RUN_STRAIGHT) {
+            switch (count) {
+                case TIME_COUNT_START:        *ncount = TIME_TURN_START; break;
+                case 1:                       *ncount = TIME_TURN_SINGLE_S1; break;
+                case TIME_COUNT_DIAG_S1:      *ncount = TIME_TURN_DIAG_S1; break;
+                case TIME_COUNT_DIAG_PAIR_S1: *ncount = TIME_TURN_SINGLE; return tc->s1_half + tc->turn;
+                default:                      *ncount = TIME_TURN_SINGLE; break;
+            }
+            return tc->turn;
+        }
+        if (count >= TIME_COUNT_START && count <= TIME_COUNT_START_MAX) {
+            *ncount = (count < TIME_COUNT_START_MAX) ? (count + 1) : count;
+            return time_table(tc->start, count - TIME_COUNT_START + 1);
+        }
+        count = time_straight_count(count);
+        *ncount = (count < SOLVER_RUN_COUNT_MAX) ? (count + 1) : count;
+        return time_table(tc->straight, count);
+    }
+
+    if (nrun == RUN_STRAIGHT) {
+        if (count == TIME_TURN_DIAG_PAIR) {
+            *ncount = TIME_COUNT_DIAG_PAIR_S1;
+        } else {
+            *ncount = (count >= TIME_TURN_DIAG) ? TIME_COUNT_DIAG_S1 : 1;
+        }
+        return time_turn_exit(tc, count) + tc->straight[0];
+    }
+
+    if (nrun == crun) {
+        // 同方向に続けて曲がる
+        switch (count) {
+            case TIME_TURN_SINGLE:
+            case TIME_TURN_START:
+                *ncount = TIME_TURN_PAIR;
+                return tc->pair;
+            case TIME_TURN_SINGLE_S1:
+                *ncount = TIME_TURN_PAIR_S1;
+                return tc->pair;
+            case TIME_TURN_DIAG_S1:
+                *ncount = TIME_TURN_PAIR; // 大回り180° / 135°入りのどちらでも S1 が残る
+                return tc->pair + tc->s1_half;
+            case TIME_TURN_PAIR:
+                *ncount = TIME_TURN_DIAG_PAIR; // 3 回以上同方向は経路として稀なため斜め入りとして数える
+                return tc->pair_diag;
+            case TIME_TURN_PAIR_S1:
+                *ncount = TIME_TURN_DIAG_PAIR;
+                return tc->pair_diag + tc->s1_half;
+            case TIME_TURN_DIAG_PAIR:
+                *ncount = TIME_TURN_SINGLE;
+                return tc->diag_pair_exit + tc->turn;
+            default:
+                *ncount = TIME_TURN_DIAG_PAIR;
+                return tc->diag_pair;
+        }
+    }
+
+    // 逆方向に曲がる（斜め継続）
+    switch (count) {
+        case TIME_TURN_SINGLE:
+        case TIME_TURN_DIAG_S1: // [45°出, S1, 45°入] は S1 を挟まずに連結される
+            *ncount = TIME_TURN_DIAG;
+            return tc->diag_in;
+        case TIME_TURN_START:
+        case TIME_TURN_SINGLE_S1:
+            *ncount = TIME_TURN_DIAG;
+            return tc->diag_in + tc->s1_half;
+        case TIME_TURN_PAIR:
+            *ncount = TIME_TURN_DIAG;
+            return tc->pair_diag;
+        case TIME_TURN_PAIR_S1:
+            *ncount = TIME_TURN_DIAG;
+            return tc->pair_diag + tc->s1_half;
+        case TIME_TURN_DIAG_PAIR:
+            *ncount = TIME_TURN_DIAG;
+            return tc->diag_pair_v90;
+        default:
+            *ncount = (count < (int)NODE_AUX_COUNT_MASK) ? (count + 1) : count;
+            return time_table(tc->diagonal, count - TIME_TURN_DIAG);
+    }
+}
+
+// 時間最適プロファイルで移動後のノードの進入状態（斜め中のターンは RUN_ZIG_R / RUN_ZIG_L）
+static inline int time_run_state(int nrun, int ncount) {
+#if SOLVER_TIME_ZIG_NODES
+    if (nrun != RUN_STRAIGHT && ncount >= TIME_TURN_DIAG) return nrun + (RUN_ZIG_R - RUN_TURN_R);
+#else
+    (void)ncount;
+#endif
+    return nrun;
+}
+
+static bool is_search_goal(int x, int y) {
+    for (int i = 0; i < g_search_goal_num; i++) {
+        if (g_search_goals[i].x == x && g_search_goals[i].y == y) return true;
+    }
+    return false;
+}
+
+// 時間最適プロファイルでゴール区画のノードに足す時間: ゴール後の延長（extend_path_after_goal() と同じく
+// 壁まで直進）を含む最後の直進を、ゴール区画の進入速度まで減速する台形にした分
+static float time_goal_cost(const SolverTimeCosts_t *tc, int x, int y, int dir, int run, int count) {
+    const float *table = tc->straight;
+    const float *goal = tc->goal_straight;
+    Pos2D cur = { x, y };
+    float t = 0.0f;
+    int k = 0;
+    int n;
+
+    if (run != RUN_STRAIGHT) {
+        t = time_turn_exit(tc, count);
+    } else if (count >= TIME_COUNT_START && count <= TIME_COUNT_START_MAX) {
+        table = tc->start;
+        goal = tc->goal_start;
+        k = count - TIME_COUNT_START + 1;
+    } else {
+        k = time_straight_count(count);
+    }
+    for (n = k; n < k + MAZE_SIZE; n++) {
+        Pos2D nxt = { cur.x + k_dx[dir], cur.y + k_dy[dir] };
+        if (!can_move_cell(cur, nxt)) break;
+        t += time_table(table, n);
+        cur = nxt;
+    }
+    t += time_table(goal, n);
+    if (run != RUN_STRAIGHT && n == 0 && (count == TIME_TURN_DIAG_PAIR || count >= TIME_TURN_DIAG)) {
+        t += tc->goal_diag_exit; // 斜め出の直後は直進が無くても S1 が付く
+    }
+    return (t > 0.0f) ? t : 0.0f;
+}
+
+// 確定ノードから隣接ノードへ緩和する。コストモデルは旧実装と同一:
+//   初回移動: move_cost_normal
+//   直進継続: move_cost_straight - straight_discount * 連続直進数
+//   ジグザグ: move_cost_diagonal - diagonal_discount * 連続斜め数
+//   それ以外: move_cost_normal + turn_penalty
+// 時間最適プロファイルでは time_move_cost() で置き換える。
+static void dijkstra_expand(uint16_t cur, float cd, int count, const SolverCaseParams_t* sp) {
+    int cx, cy, cdir, crun;
+    node_decode(cur, &cx, &cy, &cdir, &crun);
+
+    Pos2D cpos = { cx, cy };
+    if (sp->time != NULL && is_search_goal(cx, cy)) {
+        cd -= time_goal_cost(sp->time, cx, cy, cdir, crun, count); // ゴールを通り抜ける経路には終端の時間を持ち越さない
+    }
+
+    for (int d = 0; d < 4; d++) {
+        if (d == ((cdir + 2) & 0x03)) continue; // Uターンは走行パスにできない
+        Pos2D nxt = { cx + k_dx[d], cy + k_dy[d] };
+        if (!can_move_cell(cpos, nxt)) continue;
+
+        float cost;
+        int nrun;
+        int ncount;
+        if (sp->time != NULL) {
+            nrun = (d == cdir) ? RUN_STRAIGHT : ((d == ((cdir + 1) & 0x03)) ? RUN_TURN_R : RUN_TURN_L);
+            cost = time_move_cost(sp->time, run_turn(crun), count, nrun, &ncount);
+            if (is_search_goal(nxt.x, nxt.y)) {
+                cost += time_goal_cost(sp->time, nxt.x, nxt.y, d, nrun, ncount);
+            }
+            relax_node(node_index(nxt.x, nxt.y, d, time_run_state(nrun, ncount)), cd + cost, ncount, crun);
+            continue;
+        }
+        if (d == cdir) {
+            // 直線継続（曲がった直後は連続数0から数える）
+            int sc = (crun == RUN_STRAIGHT) ? count : 0;
+            cost = straight_move_cost(sp, sc);
+            nrun = RUN_STRAIGHT;
+            ncount = sc + 1;
+        } else {
+            nrun = (d == ((cdir + 1) & 0x03)) ? RUN_TURN_R : RUN_TURN_L;
+            if (crun != RUN_STRAIGHT && nrun != crun) {
+                // 直前と逆向きに曲がる = 斜め継続パターン
+                cost = diagonal_move_cost(sp, count);
+                ncount = count + 1;
+            } else {
+                // 通常ターン（新しい斜めパターン開始）
+                cost = sp->move_cost_normal + sp->turn_penalty;
+                ncount = 1;
+            }
+        }
+        if (ncount > SOLVER_RUN_COUNT_MAX) ncount = SOLVER_RUN_COUNT_MAX;
+        relax_node(node_index(nxt.x, nxt.y, d, nrun), cd + cost, ncount, crun);
+    }
+}
+
+// 確定済みゴールノードから経路を復元し、最終方向で延長する
+static int build_path_from_node(uint16_t goal_node, Pos2D *out_path, int out_cap) {
+    int gx, gy, gdir, grun;
+    node_decode(goal_node, &gx, &gy, &gdir, &grun);
+
+    // 長さを数える
+    int length = 1;
+    uint16_t node = goal_node;
+    while (1) {
+        int x, y, dir, run;
+        node_decode(node, &x, &y, &dir, &run);
+        int pred = node_pred(node);
+        length++;
+        if (pred == RUN_FROM_START) break;
+        if (length > SOLVER_PATH_BUF_LEN) return 0;
+        node = node_index(x - k_dx[dir], y - k_dy[dir], pred_heading(dir, run), pred);
+    }
+
+    if (length > out_cap) length = out_cap; // 収まりきらない分は切り捨て
+
+    // 経路を後ろから順に格納
+    int idx = length - 1;
+    node = goal_node;
+    out_path[idx].x = gx;
+    out_path[idx].y = gy;
+    while (idx > 0) {
+        int x, y, dir, run;
+        node_decode(node, &x, &y, &dir, &run);
+        int pred = node_pred(node);
+        Pos2D p = { x - k_dx[dir], y - k_dy[dir] };
+        out_path[--idx] = p;
+        if (pred == RUN_FROM_START) break;
+        node = node_index(p.x, p.y, pred_heading(dir, run), pred);
+    }
+
+    // 最終方向で延長（視認性向上）
+    if (length >= 2) {
+        Dir4 last_dir = get_dir(out_path[length - 2], out_path[length - 1]);
+        length = extend_path_after_goal(out_path, length, last_dir);
+    }
+
+    return length;
+}
+
+// calc_goal_approach_straight() と同じ値を、経路を展開せずにノード来歴から求める
+static int calc_goal_approach_node(uint16_t goal_node) {
+    int x, y, dir, run;
+    node_decode(goal_node, &x, &y, &dir, &run);
+    int last_dir = dir;
+    Pos2D cur = { x, y };
+
+    int straight_count = 1;
+    uint16_t node = goal_node;
+    while (run == RUN_STRAIGHT) {
+        int pred = node_pred(node);
+        if (pred == RUN_FROM_START) break;
+        node = node_index(x - k_dx[dir], y - k_dy[dir], dir, pred);
+        node_decode(node, &x, &y, &dir, &run);
+        straight_count++;
+    }
+
+    // extend_path_after_goal() による延長分も直進に含まれる
+    for (int extend = 0; extend < MAZE_SIZE; extend++) {
+        Pos2D nxt = { cur.x + k_dx[last_dir], cur.y + k_dy[last_dir] };
+        if (!can_move_cell(cur, nxt)) break;
+        straight_count++;
+        cur = nxt;
+    }
+    return straight_count;
+}
+
+// 未確定集合が溢れてゴールを確定できなかったときの引き直し: 区画単位の幅優先探索で
+// 最初に届いたゴールへの区画数最小の経路を返す（コストモデルは使わない）。
+// 作業領域はダイクストラのものを流用する（g_node_pred の先頭を区画毎の進入方位、g_path_buf を待ち行列）
+#define CELL_BFS_UNSEEN 0xFFu
+static int shortest_path_cell_bfs(Pos2D start, const Pos2D *goals, int goal_num,
+                                  Pos2D *out_path, int out_cap, const SolverCaseParams_t* sp) {
+    uint8_t *from = g_node_pred;
+    int head = 0;
+    int tail = 0;
+    int found = -1;
+
+    memset(from, CELL_BFS_UNSEEN, MAZE_SIZE * MAZE_SIZE);
+    from[start.y * MAZE_SIZE + start.x] = 0;
+    g_path_buf[tail++] = start;
+    while (head < tail && found < 0) {
+        Pos2D cur = g_path_buf[head++];
+        for (int d = 0; d < 4; d++) {
+            Pos2D nxt = { cur.x + k_dx[d], cur.y + k_dy[d] };
+            if (!can_move_cell(cur, nxt)) continue;
+            if (from[nxt.y * MAZE_SIZE + nxt.x] != CELL_BFS_UNSEEN) continue;
+            from[nxt.y * MAZE_SIZE + nxt.x] = (uint8_t)d;
+            g_path_buf[tail++] = nxt;
+            for (int i = 0; i < goal_num; i++) {
+                if (nxt.x == goals[i].x && nxt.y == goals[i].y) {
+                    found = i;
+                    break;
+                }
+            }
+            if (found >= 0) break;
+        }
+    }
+    if (found < 0) {
+        return 0; // 壁で閉じていて届かない
+    }
+
+    // ゴールから進入方位を逆に辿って長さを数え、後ろから格納する（待ち行列はもう使わない）
+    int length = 1;
+    Pos2D p = goals[found];
+    while (p.x != start.x || p.y != start.y) {
+        int d = from[p.y * MAZE_SIZE + p.x];
+        p.x -= k_dx[d];
+        p.y -= k_dy[d];
+        length++;
+    }
+    if (length > out_cap) length = out_cap;
+    int idx = length - 1;
+    p = goals[found];
+    out_path[idx] = p;
+    while (idx > 0) {
+        int d = from[p.y * MAZE_SIZE + p.x];
+        p.x -= k_dx[d];
+        p.y -= k_dy[d];
+        out_path[--idx] = p;
+    }
+
+    g_goal_cost = sp->move_cost_normal * (float)(length - 1); // 目安（最短の比較には使わない）
+    g_goal_index = found;
+    if (length >= 2) {
+        length = extend_path_after_goal(out_path, length, get_dir(out_path[length - 2], out_path[length - 1]));
+    }
+    return length;
+}
+
+// 斜め優先ダイクストラ（4近傍・斜めはコストモデルで表現）
+// (区画, 進入方位, 進入状態) のノード上で二分ヒープにより探索する。
+// 全ゴール区画を同時に目標とし、1回の探索で最適ゴールと経路を確定させる。
+// ゴール毎に探索していた頃と同じ選択規則（コスト差 SOLVER_GOAL_COST_EPS 以内なら
+// ゴール進入直進の長い方、同条件ならスロット順で先の方）を保つため、最初のゴール確定後も
+// SOLVER_GOAL_TIE_WINDOW の範囲までは探索を続けて候補を集める。
+static int shortest_path_multi_goal(Pos2D start, const Pos2D *goals, int goal_num,
+                                    Pos2D *out_path, int out_cap, const SolverCaseParams_t* sp) {
+    int goal_node[SOLVER_GOAL_NUM];
+    float goal_cost[SOLVER_GOAL_NUM];
+
+    g_goal_cost = FLT_MAX;
+    g_goal_index = -1;
+    if (out_cap <= 0 || goal_num <= 0) return 0;
+    if (goal_num > SOLVER_GOAL_NUM) goal_num = SOLVER_GOAL_NUM;
+    for (int i = 0; i < goal_num; i++) {
+        if (start.x == goals[i].x && start.y == goals[i].y) {
+            g_goal_cost = 0.0f;
+            g_goal_index = i;
+            out_path[0] = start;
+            return 1;
+        }
+        goal_node[i] = -1;
+    }
+
+    g_search_goals = goals;
+    g_search_goal_num = goal_num;
+    dijkstra_begin(start, sp);
+
+    int reached = 0;
+    float first_cost = FLT_MAX;
+    while (g_heap_len > 0 && reached < goal_num) {
+        if (g_heap_dist[0] > first_cost + SOLVER_GOAL_TIE_WINDOW) break;
+        float cd;
+        int count;
+        uint16_t cur = heap_pop(&cd, &count);
+        int cx, cy, cdir, crun;
+        node_decode(cur, &cx, &cy, &cdir, &crun);
+
+        // ゴール区画は最初に確定した進入状態を採用（他ゴールへの経路のため展開は続ける）
+        for (int i = 0; i < goal_num; i++) {
+            if (goal_node[i] < 0 && cx == goals[i].x && cy == goals[i].y) {
+                goal_node[i] = cur;
+                goal_cost[i] = cd;
+                reached++;
+                if (first_cost == FLT_MAX) first_cost = cd;
+            }
+        }
+        dijkstra_expand(cur, cd, count, sp);
+    }
+    if (g_stats.overflow > 0) {
+        // 未確定集合が溢れた探索結果は最短の保証が無い。確定ノードの来歴は確定ノードだけを辿るので、
+        // 確定できたゴールがあればその経路を使い、無ければ区画の幅優先探索で引き直す
+        g_stats.fallback = SOLVER_FALLBACK_PARTIAL;
+        if (reached == 0) {
+            g_stats.fallback = SOLVER_FALLBACK_BFS;
+            return shortest_path_cell_bfs(start, goals, goal_num, out_path, out_cap, sp);
+        }
+    }
+
+    // 最適経路の選択：コストが小さい、または同じコストで直進距離が長い
+    float best_cost = FLT_MAX;
+    int best_straight = 0;
+    int best = -1;
+    for (int i = 0; i < goal_num; i++) {
+        if (goal_node[i] < 0) continue;
+        float cost = goal_cost[i];
+        int approach_straight = calc_goal_approach_node((uint16_t)goal_node[i]);
+        bool is_better = false;
+        if (cost < best_cost - SOLVER_GOAL_COST_EPS) {
+            is_better = true;
+        } else if (cost < best_cost + SOLVER_GOAL_COST_EPS && approach_straight > best_straight) {
+            is_better = true;
+        }
+        if (is_better) {
+            best_cost = cost;
+            best_straight = approach_straight;
+            best = i;
+        }
+    }
+    if (best < 0) {
+        return 0; // 見つからず
+    }
+
+    g_goal_cost = best_cost;
+    g_goal_index = best;
+    return build_path_from_node((uint16_t)goal_node[best], out_path, out_cap);
+}
+
+// 単一ゴール版（solver_run 用）
+static int shortest_path(Pos2D start, Pos2D goal, Pos2D *out_path, int out_cap, const SolverCaseParams_t* sp) {
+#if SOLVER_ENABLE_LEGACY_SCAN
+    if (g_solver_impl == SOLVER_IMPL_LEGACY_SCAN) {
+        return shortest_path_legacy_scan(start, goal, out_path, out_cap, sp);
+    }
+#endif
+    return shortest_path_multi_goal(start, &goal, 1, out_path, out_cap, sp);
+}
+
+#if SOLVER_ENABLE_LEGACY_SCAN
+void solver_set_impl(uint8_t impl) {
+    g_solver_impl = impl;
+}
+
+uint16_t solver_get_last_moves(const uint16_t **moves, int *path_type) {
+    *moves = g_last_moves;
+    *path_type = g_last_path_type;
+    return g_last_move_num;
+}
+
+// 旧来のゴール毎ループ: 各ゴールへ個別に探索し、最適ゴールに対して再探索する
+static int shortest_path_per_goal(Pos2D start, const Pos2D *goals, int goal_num, const SolverCaseParams_t* sp) {
+    float best_cost = FLT_MAX;
+    int best_straight = 0;
+    int best = -1;
+    const int cap = (int)(sizeof(g_path_buf) / sizeof(g_path_buf[0]));
+
+    for (int g = 0; g < goal_num; g++) {
+        int path_len = shortest_path(start, goals[g], g_path_buf, cap, sp);
+        if (path_len <= 0) continue;
+
+        float cost = g_goal_cost;
+        int approach_straight = calc_goal_approach_straight(g_path_buf, path_len);
+        bool is_better = false;
+        if (cost < best_cost - SOLVER_GOAL_COST_EPS) {
+            is_better = true;
+        } else if (cost < best_cost + SOLVER_GOAL_COST_EPS && approach_straight > best_straight) {
+            is_better = true;
+        }
+        if (is_better) {
+            best_cost = cost;
+            best_straight = approach_straight;
+            best = g;
+        }
+    }
+    if (best < 0) {
+        g_goal_index = -1;
+        return 0;
+    }
+    int path_len = shortest_path(start, goals[best], g_path_buf, cap, sp);
+    g_goal_index = best;
+    return path_len;
+}
+
 // 斜めパターン判定（N-E-N / E-N-E / N-W-N / W-N-W / S-E-S / E-S-E / S-W-S / W-S-W）
 static bool is_diagonal_pattern(Dir4 prev_dir, Dir4 cur_dir, Dir4 next_dir) {
     if ((prev_dir == DIR_NORTH && cur_dir == DIR_EAST && next_dir == DIR_NORTH) ||
@@ -437,15 +1265,13 @@ static float calc_move_cost(const NodeCost *cur_node, Dir4 next_dir, const Solve
     Dir4 cur_dir = cur_node->from_dir;
     if (cur_dir == next_dir) {
         // 直線継続
-        float cost = sp->move_cost_straight - sp->straight_discount * (float)(cur_node->straight_count);
-        return (cost < sp->move_cost_min) ? sp->move_cost_min : cost;
+        return straight_move_cost(sp, cur_node->straight_count);
     }
 
     if (cur_node->diagonal_count > 0) {
         Dir4 prev_dir = cur_node->prev_from_dir;
         if (is_diagonal_pattern(prev_dir, cur_dir, next_dir)) {
-            float cost = sp->move_cost_diagonal - sp->diagonal_discount * (float)(cur_node->diagonal_count);
-            return (cost < sp->move_cost_min) ? sp->move_cost_min : cost;
+            return diagonal_move_cost(sp, cur_node->diagonal_count);
         }
     }
 
@@ -477,34 +1303,8 @@ static int update_straight_count(const NodeCost *cur_node, Dir4 next_dir) {
     return 0;
 }
 
-// ゴール到達後、最後の方向に沿って壁に当たるまで延長（視認性向上用）
-static int extend_path_after_goal(Pos2D *path, int length, Dir4 last_dir) {
-    if (length <= 0 || last_dir == DIR_UNKNOWN) return length;
-    Pos2D cur = path[length - 1];
-    int extend = 0;
-    while (extend < MAZE_SIZE) {
-        Pos2D nxt = cur;
-        switch (last_dir) {
-            case DIR_NORTH: nxt.y -= 1; break; // 北はy-1
-            case DIR_EAST:  nxt.x += 1; break;
-            case DIR_SOUTH: nxt.y += 1; break; // 南はy+1
-            case DIR_WEST:  nxt.x -= 1; break;
-            default: return length;
-        }
-        if (!can_move_cell(cur, nxt)) break;
-        if (length < (SOLVER_PATH_BUF_LEN - 1)) {
-            path[length++] = nxt;
-        } else {
-            break;
-        }
-        cur = nxt;
-        extend++;
-    }
-    return length;
-}
-
-// 斜め優先ダイクストラ（4近傍・斜めはコストモデルで表現）
-static int shortest_path(Pos2D start, Pos2D goal, Pos2D *out_path, int out_cap, const SolverCaseParams_t* sp) {
+// 旧実装: 区画単位ノードの線形走査ダイクストラ
+static int shortest_path_legacy_scan(Pos2D start, Pos2D goal, Pos2D *out_path, int out_cap, const SolverCaseParams_t* sp) {
     for (int y = 0; y < MAZE_SIZE; y++) {
         for (int x = 0; x < MAZE_SIZE; x++) {
             g_nodes[y][x].dist = FLT_MAX;
@@ -564,6 +1364,7 @@ static int shortest_path(Pos2D start, Pos2D goal, Pos2D *out_path, int out_cap,
     }
 
     // 経路復元
+    g_goal_cost = g_nodes[goal.y][goal.x].dist;
     if (g_nodes[goal.y][goal.x].dist == FLT_MAX) {
         return 0; // 見つからず
     }
@@ -602,6 +1403,28 @@ static int shortest_path(Pos2D start, Pos2D goal, Pos2D *out_path, int out_cap,
     return length;
 }
 
+#endif
+
+void solver_set_clock(solver_clock_fn now_us) {
+    g_clock = now_us;
+}
+
+void solver_get_stats(solver_stats_t *out) {
+    if (out == NULL) return;
+    *out = g_stats;
+    out->heap_cap = SOLVER_HEAP_CAP;
+    out->work_bytes = (uint32_t)(sizeof(g_node_closed) + sizeof(g_node_pred) + sizeof(g_heap) +
+                                 sizeof(g_heap_dist) + sizeof(g_heap_aux) + sizeof(g_open_slot) +
+                                 sizeof(g_path_buf));
+}
+
+bool solver_get_last_goal(uint8_t *x, uint8_t *y) {
+    if (g_last_goal_bl.x < 0) return false;
+    if (x != NULL) *x = (uint8_t)g_last_goal_bl.x;
+    if (y != NULL) *y = (uint8_t)g_last_goal_bl.y;
+    return true;
+}
+
 void solver_run(uint8_t mode, uint8_t case_index) {
     printf("[Solver] Start (mode=%u, case=%u)\n", (unsigned)mode, (unsigned)case_index);
 
@@ -1,9 +1,21 @@
 #include "solver_params.h"
+#include "path_speed_plan.h"
+
+#include <math.h>
+#include <params.h>
 #include <stddef.h>
 
 // move_cost_min は安全のため固定値
 #define SOLVER_MOVE_COST_MIN 0.05f
 
+// 時間最適プロファイルの 1 区画あたりの最小コスト [s]（パラメータ未設定で 0 にならないように）
+#define SOLVER_TIME_COST_MIN 0.001f
+
+// ターン時間の見積もりに使う角速度上限（F413 は NIGHTFALL_F413_PATH_OMEGA_CAP と揃える、0 で上限なし）
+#ifndef SOLVER_TIME_TURN_OMEGA_CAP
+#define SOLVER_TIME_TURN_OMEGA_CAP 0.0f
+#endif
+
 // =============================================
 // 3つのプロファイル定義
 // =============================================
@@ -46,13 +58,213 @@ static const SolverCaseParams_t kProfileStraightWeak = {
 // =============================================
 
 static uint8_t g_profile = SOLVER_PROFILE_STANDARD;
+static uint8_t g_forced_profile = SOLVER_PROFILE_NONE;
 static SolverCaseParams_t g_params;
+static SolverTimeCosts_t g_time;
+
+void solver_get_shortest_params(uint8_t mode, uint8_t case_index,
+                                const ShortestRunModeParams_t **mode_params,
+                                const ShortestRunCaseParams_t **case_params) {
+    uint8_t idx = (case_index >= 1) ? (case_index - 1) : 0;
+    if (idx > 8) idx = 8;
+
+    switch (mode) {
+        case 2: *mode_params = &shortestRunModeParams2; *case_params = &shortestRunCaseParamsMode2[idx]; break;
+        case 3: *mode_params = &shortestRunModeParams3; *case_params = &shortestRunCaseParamsMode3[idx]; break;
+        case 4: *mode_params = &shortestRunModeParams4; *case_params = &shortestRunCaseParamsMode4[idx]; break;
+        case 5: *mode_params = &shortestRunModeParams5; *case_params = &shortestRunCaseParamsMode5[idx]; break;
+        case 6: *mode_params = &shortestRunModeParams6; *case_params = &shortestRunCaseParamsMode6[idx]; break;
+        case 7: *mode_params = &shortestRunModeParams7; *case_params = &shortestRunCaseParamsMode7[idx]; break;
+        default: *mode_params = &shortestRunModeParams2; *case_params = &shortestRunCaseParamsMode2[0]; break;
+    }
+}
+
+int solver_path_type(const ShortestRunModeParams_t *mode_params, uint8_t case_index) {
+    // case1 は小回り（makepath_type_case3）、それ以外は大回り（makepath_type_case47）
+    int path_type = (case_index == 1) ? mode_params->makepath_type_case3 : mode_params->makepath_type_case47;
+    // case8/9 は斜め走行を有効化
+    if (case_index >= 8) {
+        path_type = 2;
+    }
+    return path_type;
+}
+
+// base_mm + unit_mm * n の直線（斜め）を v_in から v_out まで走る時間 T(n) から、
+// n 区画目の増分 T(n) - T(n-1) を表にする（T(0) = 0、長さ 0 以下の区間は 0 秒）
+static void build_run_time_table(float *table, const path_speed_accel_t *m, float base_mm, float unit_mm,
+                                 float v_in, float v_out) {
+    float prev = 0.0f;
+    for (int n = 0; n < SOLVER_TIME_TABLE_LEN; n++) {
+        float t = path_speed_run_time_s(m, base_mm + unit_mm * (float)(n + 1), v_in, v_out);
+        float dt = t - prev;
+        table[n] = (dt > SOLVER_TIME_COST_MIN) ? dt : SOLVER_TIME_COST_MIN;
+        prev = t;
+    }
+}
+
+static float turn_time_of(uint16_t code, const ShortestRunModeParams_t *mp, float *velocity) {
+    path_speed_turn_t turn;
+    if (!path_speed_turn_from_code(code, mp, &turn)) {
+        *velocity = 0.0f;
+        return SOLVER_TIME_COST_MIN;
+    }
+    *velocity = turn.velocity_mm_s;
+    float t = path_speed_turn_time_s(&turn, SOLVER_TIME_TURN_OMEGA_CAP);
+    return (t > SOLVER_TIME_COST_MIN) ? t : SOLVER_TIME_COST_MIN;
+}
+
+static inline float min2(float a, float b) { return (a < b) ? a : b; }
+
+// ゴールで終わる直進 n 区画（base_mm + unit_mm * n、v_in からゴール区画の進入速度 v_goal まで）の時間から、
+// 増分の表 table の n 区画分の和を引いた補正を表にする（n = 0 はターンでゴールに入って延長の無い場合）
+static void build_goal_time_table(float *goal, const float *table, const path_speed_accel_t *m, float base_mm,
+                                  float unit_mm, float v_in, float v_goal) {
+    float sum = 0.0f;
+    goal[0] = 0.0f;
+    for (int n = 1; n < SOLVER_TIME_TABLE_LEN; n++) {
+        sum += table[n - 1];
+        goal[n] = path_speed_run_time_s(m, base_mm + unit_mm * (float)n, v_in, v_goal) - sum;
+    }
+}
+
+static void fill_table(float *table, float t) {
+    for (int n = 0; n < SOLVER_TIME_TABLE_LEN; n++) {
+        table[n] = t;
+    }
+}
+
+// 時間最適プロファイル: path.c が区画の並びから作るコードごとの時間を、solver.c の
+// 状態遷移（直進 / ターン直後 / 同方向ターン / 斜め / 斜め中の同方向ターン）の移動コストへ割り振る。
+//   小回り（path_type 0）: ターンは全て小回り90°、直進 n 区画は 2n 半区画
+//   大回り（path_type 1）: 直進に挟まれたターンは大回り90°/180°（前後の直進を半区画ずつ使う）、
+//                          ジグザグは小回りの連続（前後の直進は縮まない）
+//   斜め（path_type 2）: ジグザグは 45°/135°入り・斜め直進（ジグザグ 1 回 = 斜め半区画）・V90・45°/135°出
+// ターンの間に残る S1（半区画）とスタート直後の大回りの置き換えは path.c と同じ規則で足す。
+// ゴール後の延長とゴール区画までの減速は goal_start / goal_straight の補正で数える。
+// 直線・斜めの台形は両端をターン速度（スタートからの直進は入口 0）とする近似で、
+// ターン種別ごとの入口速度の違いは数えない。
+static void build_time_params(SolverCaseParams_t *sp, uint8_t mode, uint8_t case_index) {
+    const ShortestRunModeParams_t *mp;
+    const ShortestRunCaseParams_t *cp;
+    path_speed_accel_t straight;
+    path_speed_accel_t diagonal;
+    SolverTimeCosts_t *tc = &g_time;
+    const float half = (float)DIST_HALF_SEC;
+    float v_small, v_large, v_45in, v_45out, v_unused;
+
+    solver_get_shortest_params(mode, case_index, &mp, &cp);
+    path_speed_accel_models(mp, cp, &straight, &diagonal);
+
+    const float t_small = turn_time_of(300, mp, &v_small);
+    const float t_large = turn_time_of(501, mp, &v_large);
+    const float t_180 = turn_time_of(502, mp, &v_unused);
+    const float t_45in = turn_time_of(701, mp, &v_45in);
+    const float t_45out = turn_time_of(703, mp, &v_45out);
+    const float t_v90 = turn_time_of(801, mp, &v_unused);
+    const float t_135in = turn_time_of(901, mp, &v_unused);
+    const float t_135out = turn_time_of(903, mp, &v_unused);
+
+    // ゴール区画の進入速度（path_speed_plan_build() と同じく半区画で停止できる速度）
+    float v_goal = sqrtf(fmaxf(0.0f, 2.0f * cp->acceleration_straight * half));
+    if (v_goal > cp->velocity_straight) {
+        v_goal = cp->velocity_straight;
+    }
+
+    int path_type = solver_path_type(mp, case_index);
+    float v_turn = (path_type == 0) ? v_small : v_large;
+    if (path_type == 0) {
+        // 直進 n 区画 = 2n 半区画（先頭は半区画短い）、ターンは全て小回り
+        build_run_time_table(tc->straight, &straight, 0.0f, 2.0f * half, v_small, v_small);
+        build_run_time_table(tc->start, &straight, (float)DIST_FIRST_SEC - half, 2.0f * half, 0.0f, v_small);
+        fill_table(tc->diagonal, t_small);
+        tc->turn = t_small;
+        tc->single_exit = 0.0f;
+        tc->start_exit = 0.0f;
+        tc->pair = t_small;
+        tc->pair_exit = 0.0f;
+        tc->pair_diag = t_small;
+        tc->diag_in = t_small;
+        tc->diag_exit = 0.0f;
+        tc->diag_pair = t_small;
+        tc->diag_pair_exit = 0.0f;
+        tc->diag_pair_v90 = t_small;
+        tc->s1_half = 0.0f;
+        tc->goal_diag_exit = 0.0f;
+    } else {
+        // 直進 n 区画は前後のターンに半区画ずつ使われて 2n-2 半区画
+        build_run_time_table(tc->straight, &straight, -2.0f * half, 2.0f * half, v_large, v_large);
+        build_run_time_table(tc->start, &straight, (float)DIST_FIRST_SEC - 2.0f * half, 2.0f * half, 0.0f,
+                             v_large);
+        if (path_type == 1) {
+            // ジグザグの小回りは前後の直進を縮めないため、半区画ずつ戻す
+            const float t_half = path_speed_run_time_s(&straight, half, v_small, v_small);
+            const float t_first = min2(min2(t_large, t_180), t_small + t_half);
+            const float t_pair = min2(t_180, 2.0f * t_small + t_half);
+            fill_table(tc->diagonal, t_small);
+            tc->turn = t_first;
+            tc->single_exit = t_large - t_first;
+            tc->pair = t_pair - t_first;
+            tc->pair_exit = t_180 - t_pair;
+            tc->pair_diag = (2.0f * t_small + t_half - t_pair) + t_small;
+            tc->diag_in = (t_small + t_half - t_first) + t_small;
+            tc->diag_exit = t_half;
+            tc->diag_pair = t_small;
+            tc->diag_pair_exit = t_half;
+            tc->diag_pair_v90 = t_small;
+            tc->s1_half = 0.0f;
+            tc->goal_diag_exit = 0.0f;
+        } else {
+            const float t_first = min2(min2(t_large, t_180), min2(t_45in, t_135in));
+            const float t_pair = min2(t_180, t_135in);
+            const float t_diag_pair = min2(t_135out, t_v90);
+            build_run_time_table(tc->diagonal, &diagonal, 0.0f, (float)DIST_D_HALF_SEC, min2(v_45in, v_45out),
+                                 min2(v_45in, v_45out));
+            tc->turn = t_first;
+            tc->single_exit = t_large - t_first;
+            tc->pair = t_pair - t_first;
+            tc->pair_exit = t_180 - t_pair;
+            tc->pair_diag = t_135in - t_pair;
+            tc->diag_in = t_45in - t_first;
+            tc->diag_exit = t_45out;
+            tc->diag_pair = t_diag_pair;
+            tc->diag_pair_exit = t_135out - t_diag_pair;
+            tc->diag_pair_v90 = t_v90 - t_diag_pair;
+            // 斜め入り/出は前後の直進が S1 なら縮めない（大回りに縮められた残りの S1 も含む）
+            tc->s1_half = path_speed_run_time_s(&straight, half, v_large, v_large);
+            tc->goal_diag_exit = path_speed_run_time_s(&straight, half, v_45out, v_goal);
+        }
+    }
+
+    if (path_type != 0) {
+        // 先頭の大回り90°は [半区画, 小回り, 直進 + 半区画] に置き換わる（path.c の out_put()）
+        float t = path_speed_run_time_s(&straight, (float)DIST_FIRST_SEC + half, 0.0f, v_small) - tc->start[0] +
+                  t_small + path_speed_run_time_s(&straight, half, v_small, v_small) - tc->turn;
+        tc->start_exit = (t > 0.0f) ? t : 0.0f;
+    }
+
+    // 最後の直進は入口側のターンにだけ半区画を使われる（スタートからの直進は先頭が半区画短い）
+    build_goal_time_table(tc->goal_start, tc->start, &straight, (float)DIST_FIRST_SEC - half, 2.0f * half, 0.0f,
+                          v_goal);
+    build_goal_time_table(tc->goal_straight, tc->straight, &straight, (path_type == 0) ? 0.0f : -half,
+                          2.0f * half, v_turn, v_goal);
+
+    // 以下の重みは時間表を使わない旧実装（ホストの比較用）向けの近似
+    sp->move_cost_normal = tc->start[0];
+    sp->move_cost_straight = tc->straight[1];
+    sp->move_cost_diagonal = tc->diagonal[0];
+    sp->move_cost_min = SOLVER_TIME_COST_MIN;
+    sp->straight_discount = 0.0f;
+    sp->diagonal_discount = 0.0f;
+    sp->turn_penalty = (tc->turn > sp->move_cost_normal) ? (tc->turn - sp->move_cost_normal) : 0.0f;
+    sp->time = tc;
+}
 
 void solver_set_profile(uint8_t profile) {
     switch (profile) {
         case SOLVER_PROFILE_STANDARD:
         case SOLVER_PROFILE_STRAIGHT_STRONG:
         case SOLVER_PROFILE_STRAIGHT_WEAK:
+        case SOLVER_PROFILE_TIME_OPTIMAL:
             g_profile = profile;
             break;
         default:
@@ -62,15 +274,23 @@ void solver_set_profile(uint8_t profile) {
 }
 
 uint8_t solver_get_profile(void) {
-    return g_profile;
+    return (g_forced_profile != SOLVER_PROFILE_NONE) ? g_forced_profile : g_profile;
+}
+
+void solver_force_profile(uint8_t profile) {
+    g_forced_profile = (profile < SOLVER_PROFILE_NUM) ? profile : SOLVER_PROFILE_NONE;
 }
 
 const SolverCaseParams_t* solver_get_case_params(uint8_t mode, uint8_t case_index) {
-    (void)mode;
-    (void)case_index;
-    
     // 現在のプロファイルに応じてパラメータを返却
-    switch (g_profile) {
+    return solver_get_profile_params(solver_get_profile(), mode, case_index);
+}
+
+const SolverCaseParams_t* solver_get_profile_params(uint8_t profile, uint8_t mode, uint8_t case_index) {
+    switch (profile) {
+        case SOLVER_PROFILE_TIME_OPTIMAL:
+            build_time_params(&g_params, mode, case_index);
+            return &g_params;
         case SOLVER_PROFILE_STRAIGHT_STRONG:
             g_params = kProfileStraightStrong;
             break;
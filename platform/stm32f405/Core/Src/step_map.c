@@ -0,0 +1,404 @@
+/*
+ * step_map.c
+ *
+ * 差分更新型の歩数マップ（search.c の conf_route() から利用）
+ * HAL に依存しないため tools/solver_host でも同じソースをビルドして検証する。
+ */
+
+#include "global.h"
+#include "maze_bitboard.h"
+#include "step_map.h"
+
+#include <string.h>
+
+#define CELL_NUM (MAZE_SIZE * MAZE_SIZE)
+#define NIL 0xffff
+
+// flag[] のビット
+#define FLAG_SEED    0x01 // 起点（歩数0）
+#define FLAG_DIRTY   0x02 // dirty[] に記録済み
+#define FLAG_QUEUED  0x04 // バケットキューに格納中
+#define FLAG_CHANGED 0x08 // 今回の更新で壁ビットまたは起点状態が変わった
+
+// 方向（NESW）ごとの壁ビットと逆向きの壁ビット
+static const uint8_t s_wall_bit[4] = {0x08, 0x04, 0x02, 0x01};
+static const uint8_t s_back_bit[4] = {0x02, 0x01, 0x08, 0x04};
+
+// 歩数別バケットキュー（空の間は bucket[] が全て NIL という不変条件を保つ）
+typedef struct {
+    step_map_t *sm;
+    uint16_t lo;
+    uint16_t hi;
+} BucketQueue;
+
+static inline uint16_t *dist_at(step_map_t *sm, uint16_t idx) {
+    return &sm->dist[idx / MAZE_SIZE][idx % MAZE_SIZE];
+}
+
+// 区画 idx から方向 d の隣接区画を返す（迷路外なら false）
+static inline bool neighbor(uint16_t idx, uint8_t d, uint16_t *out) {
+    uint16_t x = (uint16_t)(idx % MAZE_SIZE);
+    uint16_t y = (uint16_t)(idx / MAZE_SIZE);
+    switch (d) {
+    case 0:
+        if (y == (MAZE_SIZE - 1)) return false;
+        *out = (uint16_t)(idx + MAZE_SIZE);
+        return true;
+    case 1:
+        if (x == (MAZE_SIZE - 1)) return false;
+        *out = (uint16_t)(idx + 1);
+        return true;
+    case 2:
+        if (y == 0) return false;
+        *out = (uint16_t)(idx - MAZE_SIZE);
+        return true;
+    default:
+        if (x == 0) return false;
+        *out = (uint16_t)(idx - 1);
+        return true;
+    }
+}
+
+static inline uint8_t cell_wall(uint16_t walls[MAZE_SIZE][MAZE_SIZE], uint16_t idx,
+                                bool second_run) {
+    uint16_t m = walls[idx / MAZE_SIZE][idx % MAZE_SIZE];
+    if (second_run) {
+        m >>= 4; // 二次走行用は上位4bit
+    }
+    return (uint8_t)(m & 0x0f);
+}
+
+static bool is_seed(bool visited[MAZE_SIZE][MAZE_SIZE], step_map_target_t target,
+                    uint16_t idx) {
+    const uint16_t start_idx = (uint16_t)(START_Y * MAZE_SIZE + START_X);
+    switch (target) {
+    case STEP_MAP_TARGET_START:
+        return idx == start_idx;
+    case STEP_MAP_TARGET_UNVISITED:
+        // make_smap() と同じくスタート区画は常に既知扱い
+        return (idx != start_idx) && !visited[idx / MAZE_SIZE][idx % MAZE_SIZE];
+    case STEP_MAP_TARGET_GOAL:
+    default: {
+        const uint8_t goals[9][2] = {
+            {GOAL1_X, GOAL1_Y}, {GOAL2_X, GOAL2_Y}, {GOAL3_X, GOAL3_Y},
+            {GOAL4_X, GOAL4_Y}, {GOAL5_X, GOAL5_Y}, {GOAL6_X, GOAL6_Y},
+            {GOAL7_X, GOAL7_Y}, {GOAL8_X, GOAL8_Y}, {GOAL9_X, GOAL9_Y},
+        };
+        for (int i = 0; i < 9; i++) {
+            uint8_t gx = goals[i][0];
+            uint8_t gy = goals[i][1];
+            // (0,0) は未使用スロットとして無視
+            if (gx == 0 && gy == 0) continue;
+            if (gx < MAZE_SIZE && gy < MAZE_SIZE &&
+                idx == (uint16_t)(gy * MAZE_SIZE + gx)) {
+                return true;
+            }
+        }
+        return false;
+    }
+    }
+}
+
+//====バケットキュー====
+static void bq_push(BucketQueue *q, uint16_t idx, uint16_t key) {
+    step_map_t *sm = q->sm;
+    uint16_t head = sm->bucket[key];
+    sm->next[idx] = head;
+    sm->prev[idx] = NIL;
+    if (head != NIL) {
+        sm->prev[head] = idx;
+    }
+    sm->bucket[key] = idx;
+    sm->flag[idx] |= FLAG_QUEUED;
+    if (key < q->lo) q->lo = key;
+    if (key > q->hi || q->hi == NIL) q->hi = key;
+}
+
+static void bq_unlink(BucketQueue *q, uint16_t idx, uint16_t key) {
+    step_map_t *sm = q->sm;
+    if (sm->prev[idx] != NIL) {
+        sm->next[sm->prev[idx]] = sm->next[idx];
+    } else {
+        sm->bucket[key] = sm->next[idx];
+    }
+    if (sm->next[idx] != NIL) {
+        sm->prev[sm->next[idx]] = sm->prev[idx];
+    }
+    sm->flag[idx] &= (uint8_t)~FLAG_QUEUED;
+}
+
+static bool bq_pop(BucketQueue *q, uint16_t *idx, uint16_t *key) {
+    step_map_t *sm = q->sm;
+    if (q->hi == NIL) {
+        return false;
+    }
+    while (q->lo <= q->hi && sm->bucket[q->lo] == NIL) {
+        q->lo++;
+    }
+    if (q->lo > q->hi) {
+        return false;
+    }
+    *idx = sm->bucket[q->lo];
+    *key = q->lo;
+    bq_unlink(q, *idx, q->lo);
+    return true;
+}
+
+static inline void bq_init(BucketQueue *q, step_map_t *sm) {
+    q->sm = sm;
+    q->lo = NIL;
+    q->hi = NIL;
+}
+
+//====全面再構築（make_smap と同じ行ビットボードの波面展開を全区画まで実行）====
+// 修復の途中で打ち切った場合も呼ぶため、バケットキューと区画状態フラグもここで初期化する
+static void rebuild(step_map_t *sm, uint16_t walls[MAZE_SIZE][MAZE_SIZE],
+                    bool visited[MAZE_SIZE][MAZE_SIZE], step_map_target_t target,
+                    bool second_run) {
+    static maze_bitboard_t bb; // 作業用（32x32 で 512B。スタックを避ける）
+    maze_row_t seed[MAZE_SIZE] = {0};
+    const uint8_t shift = second_run ? 4 : 0;
+
+    memset(sm->bucket, 0xff, sizeof(sm->bucket)); // NIL
+    memset(sm->flag, 0, sizeof(sm->flag));
+    maze_bitboard_build_cells(&bb, walls, shift, sm->wall);
+    // 起点: ゴール・スタートは該当区画だけを調べる（全区画で is_seed() を呼ばない）
+    if (target == STEP_MAP_TARGET_UNVISITED) {
+        for (uint8_t y = 0; y < MAZE_SIZE; y++) {
+            for (uint8_t x = 0; x < MAZE_SIZE; x++) {
+                if (!visited[y][x]) {
+                    sm->flag[y * MAZE_SIZE + x] = FLAG_SEED;
+                    seed[y] |= (maze_row_t)1u << x;
+                }
+            }
+        }
+        // make_smap() と同じくスタート区画は常に既知扱い
+        sm->flag[START_Y * MAZE_SIZE + START_X] = 0;
+        seed[START_Y] &= ~((maze_row_t)1u << START_X);
+    } else {
+        const uint8_t goals[10][2] = {
+            {START_X, START_Y},
+            {GOAL1_X, GOAL1_Y}, {GOAL2_X, GOAL2_Y}, {GOAL3_X, GOAL3_Y},
+            {GOAL4_X, GOAL4_Y}, {GOAL5_X, GOAL5_Y}, {GOAL6_X, GOAL6_Y},
+            {GOAL7_X, GOAL7_Y}, {GOAL8_X, GOAL8_Y}, {GOAL9_X, GOAL9_Y},
+        };
+        for (int i = 0; i < 10; i++) {
+            uint8_t gx = goals[i][0];
+            uint8_t gy = goals[i][1];
+            if (gx >= MAZE_SIZE || gy >= MAZE_SIZE) continue;
+            uint16_t idx = (uint16_t)(gy * MAZE_SIZE + gx);
+            if (is_seed(visited, target, idx)) {
+                sm->flag[idx] = FLAG_SEED;
+                maze_bitboard_seed_set(seed, gx, gy);
+            }
+        }
+    }
+    (void)maze_bitboard_flood(&bb, seed, sm->dist, MAZE_BITBOARD_NO_TARGET, 0);
+
+    sm->work = CELL_NUM;
+    sm->dirty_len = 0;
+    sm->raised_len = 0;
+    sm->overflow = false;
+    sm->target = (uint8_t)target;
+    sm->second_run = second_run;
+    sm->valid = true;
+}
+
+// c が歩数 d-1 の隣接区画（c へ通過可能なもの）に支えられているか
+static bool has_support(step_map_t *sm, uint16_t c, uint16_t d) {
+    if (sm->flag[c] & FLAG_SEED) {
+        return true;
+    }
+    if (d == 0) {
+        return false; // 起点から外れた
+    }
+    for (uint8_t k = 0; k < 4; k++) {
+        uint16_t u;
+        if (!neighbor(c, k, &u)) continue;
+        if (sm->wall[u] & s_back_bit[k]) continue; // u→c が壁
+        if (*dist_at(sm, u) == (uint16_t)(d - 1)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// 変化区画 c の差分を取り込み、raise 候補をキューへ積む
+static void absorb_change(step_map_t *sm, BucketQueue *q, uint16_t walls[MAZE_SIZE][MAZE_SIZE],
+                          bool visited[MAZE_SIZE][MAZE_SIZE], step_map_target_t target,
+                          bool second_run, uint16_t c) {
+    uint8_t new_wall = cell_wall(walls, c, second_run);
+    bool new_seed = is_seed(visited, target, c);
+    bool old_seed = (sm->flag[c] & FLAG_SEED) != 0;
+    uint8_t closed = (uint8_t)(new_wall & (uint8_t)~sm->wall[c]);
+    uint16_t dc = *dist_at(sm, c);
+
+    sm->flag[c] &= (uint8_t)~FLAG_DIRTY;
+    if (new_wall == sm->wall[c] && new_seed == old_seed) {
+        return;
+    }
+    sm->wall[c] = new_wall;
+    sm->flag[c] |= FLAG_CHANGED;
+    if (new_seed) {
+        sm->flag[c] |= FLAG_SEED;
+    } else {
+        sm->flag[c] &= (uint8_t)~FLAG_SEED;
+    }
+    sm->work++;
+
+    if (dc == STEP_MAP_UNREACHED) {
+        return;
+    }
+    if (old_seed && !new_seed && !(sm->flag[c] & FLAG_QUEUED)) {
+        bq_push(q, c, dc);
+    }
+    for (uint8_t d = 0; d < 4; d++) {
+        uint16_t n;
+        if (!(closed & s_wall_bit[d]) || !neighbor(c, d, &n)) continue;
+        if (*dist_at(sm, n) == (uint16_t)(dc + 1) && !(sm->flag[n] & FLAG_QUEUED)) {
+            bq_push(q, n, (uint16_t)(dc + 1));
+        }
+    }
+}
+
+// lower フェーズ: c の歩数を key に下げてキューへ積む（格納済みなら積み直す）
+static void lower_to(step_map_t *sm, BucketQueue *q, uint16_t c, uint16_t key) {
+    uint16_t *dc = dist_at(sm, c);
+    if (sm->flag[c] & FLAG_QUEUED) {
+        bq_unlink(q, c, *dc);
+    }
+    *dc = key;
+    bq_push(q, c, key);
+}
+
+static void relax_out(step_map_t *sm, BucketQueue *q, uint16_t c) {
+    uint16_t nd = (uint16_t)(*dist_at(sm, c) + 1);
+    for (uint8_t d = 0; d < 4; d++) {
+        uint16_t n;
+        if ((sm->wall[c] & s_wall_bit[d]) || !neighbor(c, d, &n)) continue;
+        if (nd < *dist_at(sm, n)) {
+            lower_to(sm, q, n, nd);
+        }
+    }
+}
+
+void step_map_bind(step_map_t *sm, uint16_t (*dist)[MAZE_SIZE]) {
+    sm->dist = dist;
+    for (uint16_t i = 0; i < CELL_NUM; i++) {
+        sm->bucket[i] = NIL;
+        sm->flag[i] = 0;
+    }
+    sm->dirty_len = 0;
+    sm->raised_len = 0;
+    sm->work = 0;
+    sm->aborts = 0;
+    sm->overflow = false;
+    sm->valid = false;
+}
+
+void step_map_invalidate(step_map_t *sm) { sm->valid = false; }
+
+void step_map_touch(step_map_t *sm, uint8_t x, uint8_t y) {
+    if (!sm->valid || x >= MAZE_SIZE || y >= MAZE_SIZE) {
+        return;
+    }
+    uint16_t idx = (uint16_t)(y * MAZE_SIZE + x);
+    if (sm->flag[idx] & FLAG_DIRTY) {
+        return;
+    }
+    if (sm->dirty_len < STEP_MAP_DIRTY_CAP) {
+        sm->dirty[sm->dirty_len++] = idx;
+        sm->flag[idx] |= FLAG_DIRTY;
+    } else {
+        sm->overflow = true;
+    }
+}
+
+bool step_map_update(step_map_t *sm, uint16_t walls[MAZE_SIZE][MAZE_SIZE],
+                     bool visited[MAZE_SIZE][MAZE_SIZE], step_map_target_t target,
+                     bool second_run) {
+    BucketQueue q;
+    uint16_t c;
+    uint16_t key;
+    uint16_t cand_num;
+
+    if (!sm->valid || sm->target != (uint8_t)target || sm->second_run != second_run) {
+        rebuild(sm, walls, visited, target, second_run);
+        return false;
+    }
+
+    sm->work = 0;
+    sm->raised_len = 0;
+    cand_num = sm->overflow ? (uint16_t)CELL_NUM : sm->dirty_len;
+
+    //====差分の取り込み（raise 候補の収集）====
+    bq_init(&q, sm);
+    for (uint16_t i = 0; i < cand_num; i++) {
+        c = sm->overflow ? i : sm->dirty[i];
+        absorb_change(sm, &q, walls, visited, target, second_run, c);
+    }
+
+    //====raise: 歩数の小さい順に支えを確認し、失った区画を無効化====
+    while (bq_pop(&q, &c, &key)) {
+        if (++sm->work > STEP_MAP_WORK_CAP) {
+            goto abort;
+        }
+        if (has_support(sm, c, key)) {
+            continue;
+        }
+        *dist_at(sm, c) = STEP_MAP_UNREACHED;
+        sm->raised[sm->raised_len++] = c;
+        for (uint8_t d = 0; d < 4; d++) {
+            uint16_t n;
+            if ((sm->wall[c] & s_wall_bit[d]) || !neighbor(c, d, &n)) continue;
+            if (*dist_at(sm, n) == (uint16_t)(key + 1) && !(sm->flag[n] & FLAG_QUEUED)) {
+                bq_push(&q, n, (uint16_t)(key + 1));
+            }
+        }
+    }
+
+    //====lower: 無効化区画と変化区画から歩数を再伝播====
+    bq_init(&q, sm);
+    for (uint16_t i = 0; i < sm->raised_len; i++) {
+        uint16_t best = STEP_MAP_UNREACHED;
+        c = sm->raised[i];
+        for (uint8_t k = 0; k < 4; k++) {
+            uint16_t u;
+            if (!neighbor(c, k, &u) || (sm->wall[u] & s_back_bit[k])) continue;
+            uint16_t du = *dist_at(sm, u);
+            if (du != STEP_MAP_UNREACHED && (uint16_t)(du + 1) < best) {
+                best = (uint16_t)(du + 1);
+            }
+        }
+        if (best < *dist_at(sm, c)) {
+            lower_to(sm, &q, c, best);
+        }
+    }
+    for (uint16_t i = 0; i < cand_num; i++) {
+        c = sm->overflow ? i : sm->dirty[i];
+        if (!(sm->flag[c] & FLAG_CHANGED)) continue;
+        sm->flag[c] &= (uint8_t)~FLAG_CHANGED;
+        if ((sm->flag[c] & FLAG_SEED) && *dist_at(sm, c) != 0) {
+            lower_to(sm, &q, c, 0);
+        }
+        if (*dist_at(sm, c) != STEP_MAP_UNREACHED) {
+            relax_out(sm, &q, c);
+        }
+    }
+    while (bq_pop(&q, &c, &key)) {
+        if (++sm->work > STEP_MAP_WORK_CAP) {
+            goto abort;
+        }
+        relax_out(sm, &q, c);
+    }
+
+    sm->dirty_len = 0;
+    sm->overflow = false;
+    return true;
+
+abort:
+    // 無効化が広がり全面展開より遅くなる更新は、途中の歩数を捨てて全面再構築する
+    sm->aborts++;
+    rebuild(sm, walls, visited, target, second_run);
+    return false;
+}
@@ -22,6 +22,8 @@
 #include "stm32f4xx_it.h"
 /* Private includes ----------------------------------------------------------*/
 /* USER CODE BEGIN Includes */
+#include "trace.h"
+#include "sensor.h"
 /* USER CODE END Includes */
 
 /* Private typedef -----------------------------------------------------------*/
@@ -258,5 +260,20 @@ void DMA2_Stream0_IRQHandler(void)
 }
 
 /* USER CODE BEGIN 1 */
+/**
+  * @brief This function handles DMA2 stream7 global interrupt (USART1 TX trace).
+  */
+void DMA2_Stream7_IRQHandler(void)
+{
+  trace_uart_tx_dma_irq_handler();
+}
+
+/**
+  * @brief This function handles DMA1 stream0 global interrupt (SPI3 RX, IMU burst).
+  */
+void DMA1_Stream0_IRQHandler(void)
+{
+  IMU_BurstDmaIrqHandler();
+}
 
 /* USER CODE END 1 */
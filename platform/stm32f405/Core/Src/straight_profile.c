@@ -0,0 +1,97 @@
+/*
+ * straight_profile.c
+ *
+ * 直線区間のジャーク制限付き S 字速度プロファイル（drive.c の走行コマンドキューから利用）
+ * HAL に依存しないため tools/solver_host でも同じソースをビルドして検証する。
+ */
+
+#include "straight_profile.h"
+
+#include <math.h>
+#include <stddef.h>
+
+bool straight_profile_build(straight_profile_t *p, float v_in, float v_out, float dist_mm,
+                            float jerk_mm_s3) {
+    if (p == NULL) {
+        return false;
+    }
+    p->v_in = v_in;
+    p->v_out = v_out;
+    p->dist_mm = dist_mm;
+    p->jerk = jerk_mm_s3;
+    p->a_peak = 0.0f;
+    p->t_jerk_s = 0.0f;
+    p->t_total_s = 0.0f;
+    p->n_total = 0u;
+
+    const float dv = v_out - v_in;
+    const float dv_abs = fabsf(dv);
+    const float v_sum = v_in + v_out;
+    if (jerk_mm_s3 <= 0.0f || dist_mm <= 0.0f || v_in < 0.0f || v_out < 0.0f ||
+        v_sum <= 0.0f || dv_abs < 1e-3f) {
+        return false;
+    }
+
+    // 等加速度と同じ所要時間で、加速度を台形（立ち上がり t_j、一定 T - 2 t_j）にする
+    //   |dv| = a_peak (T - t_j)、t_j = a_peak / J
+    // から a_peak = 2|dv| / (T + sqrt(T^2 - 4|dv|/J))（差の桁落ちを避けた形）
+    const float t_total = 2.0f * dist_mm / v_sum;
+    const float disc = t_total * t_total - 4.0f * dv_abs / jerk_mm_s3;
+    if (disc < 0.0f) {
+        return false; // この J では区間内に収まらない
+    }
+    const float a_abs = 2.0f * dv_abs / (t_total + sqrtf(disc));
+    float t_jerk = a_abs / jerk_mm_s3;
+    if (t_jerk > 0.5f * t_total) {
+        t_jerk = 0.5f * t_total;
+    }
+
+    p->a_peak = (dv > 0.0f) ? a_abs : -a_abs;
+    p->t_jerk_s = t_jerk;
+    p->t_total_s = t_total;
+    // 中点 (k + 1/2) dt が T 以上になる最初の tick
+    p->n_total = (uint32_t)ceilf(t_total / STRAIGHT_PROFILE_DT_S - 0.5f);
+    return true;
+}
+
+float straight_profile_velocity(const straight_profile_t *p, float t_s) {
+    if (t_s <= 0.0f) {
+        return p->v_in;
+    }
+    if (t_s >= p->t_total_s) {
+        return p->v_out;
+    }
+    const float s = (p->a_peak >= 0.0f) ? 1.0f : -1.0f;
+    const float tj = p->t_jerk_s;
+    if (t_s < tj) {
+        return p->v_in + s * 0.5f * p->jerk * t_s * t_s;
+    }
+    const float td = p->t_total_s - t_s;
+    if (td < tj) {
+        return p->v_out - s * 0.5f * p->jerk * td * td;
+    }
+    return p->v_in + s * 0.5f * p->jerk * tj * tj + p->a_peak * (t_s - tj);
+}
+
+float straight_profile_accel(const straight_profile_t *p, float t_s) {
+    if (t_s <= 0.0f || t_s >= p->t_total_s) {
+        return 0.0f;
+    }
+    const float s = (p->a_peak >= 0.0f) ? 1.0f : -1.0f;
+    const float tj = p->t_jerk_s;
+    if (t_s < tj) {
+        return s * p->jerk * t_s;
+    }
+    const float td = p->t_total_s - t_s;
+    if (td < tj) {
+        return s * p->jerk * td;
+    }
+    return p->a_peak;
+}
+
+float straight_profile_velocity_at(const straight_profile_t *p, uint32_t tick) {
+    if (tick >= p->n_total) {
+        return p->v_out;
+    }
+    return straight_profile_velocity(p, ((float)tick + 0.5f) * STRAIGHT_PROFILE_DT_S);
+}
@@ -0,0 +1,253 @@
+/*
+ * turn_profile.c
+ *
+ * スラローム旋回の角速度プロファイル表（drive.c / F413 の旋回から利用）
+ * HAL に依存しないため tools/solver_host でも同じソースをビルドして検証する。
+ */
+
+#include "turn_profile.h"
+
+#include <math.h>
+#include <stddef.h>
+
+#define TURN_PROFILE_Q 65535.0f
+
+static const float kPi = 3.14159265358979323846f;
+
+static inline float tick_time(uint32_t k) {
+    return (float)k * TURN_PROFILE_DT_S;
+}
+
+// t_s より前にある tick の数（tick_time(k) < t_s を満たす k の個数）
+static uint32_t ticks_before(float t_s) {
+    if (t_s <= 0.0f) {
+        return 0u;
+    }
+    uint32_t k = (uint32_t)ceilf(t_s / TURN_PROFILE_DT_S);
+    while (k > 0u && tick_time(k - 1u) >= t_s) {
+        k--;
+    }
+    while (tick_time(k) < t_s) {
+        k++;
+    }
+    return k;
+}
+
+static inline uint16_t to_q16(float ratio) {
+    if (ratio <= 0.0f) {
+        return 0u;
+    }
+    if (ratio >= 1.0f) {
+        return 0xffffu;
+    }
+    return (uint16_t)(ratio * TURN_PROFILE_Q + 0.5f);
+}
+
+// ωmax, Ta, Tc を求める（作れない条件では false）
+static bool turn_profile_shape(float angle_abs, float alpha_deg_s2, float rounding_scale,
+                               float omega_cap_deg_s, float *omega_peak_out, float *t_acc_out,
+                               float *t_cruise_out) {
+    if (angle_abs <= 0.0f || alpha_deg_s2 <= 0.0f) {
+        return false;
+    }
+
+    // 従来の1/3-1/3-1/3位相から等価なωmax, Ta, Tcを算出する
+    float omega_peak = sqrtf((2.0f * alpha_deg_s2 * angle_abs) / 3.0f);
+    if (omega_cap_deg_s > 0.0f && omega_peak > omega_cap_deg_s) {
+        omega_peak = omega_cap_deg_s;
+    }
+    if (omega_peak <= 0.0f) {
+        return false;
+    }
+    if (rounding_scale < 0.1f) {
+        rounding_scale = 0.1f;
+    }
+
+    // 丸め係数: >1.0 で加減速区間を長く（より滑らか）、<1.0 で短く（より鋭く）
+    const float t_acc = (omega_peak / alpha_deg_s2) * rounding_scale;
+    // 角度保存条件（余弦ブレンド: angle = omega_peak * (t_acc + t_cruise)）
+    float t_cruise = (angle_abs / omega_peak) - t_acc;
+    if (t_cruise < 0.0f) {
+        // 台形が成立しない場合は等速区間なしの三角形へ遷移し、角度が一致するようピークを再計算
+        t_cruise = 0.0f;
+        omega_peak = angle_abs / t_acc;
+        if (omega_cap_deg_s > 0.0f && omega_peak > omega_cap_deg_s) {
+            omega_peak = omega_cap_deg_s;
+            t_cruise = (angle_abs / omega_peak) - t_acc;
+            if (t_cruise < 0.0f) {
+                t_cruise = 0.0f;
+            }
+        }
+    }
+
+    *omega_peak_out = omega_peak;
+    *t_acc_out = t_acc;
+    *t_cruise_out = t_cruise;
+    return true;
+}
+
+float turn_profile_duration_s(float angle_deg, float alpha_deg_s2, float rounding_scale,
+                              float omega_cap_deg_s) {
+    float omega_peak;
+    float t_acc;
+    float t_cruise;
+
+    if (!turn_profile_shape(fabsf(angle_deg), alpha_deg_s2, rounding_scale, omega_cap_deg_s,
+                            &omega_peak, &t_acc, &t_cruise)) {
+        return 0.0f;
+    }
+    return 2.0f * t_acc + t_cruise;
+}
+
+void turn_profile_build(turn_profile_t *p, float angle_deg, float alpha_deg_s2,
+                        float rounding_scale, float omega_cap_deg_s) {
+    const float angle_abs = fabsf(angle_deg);
+    float omega_peak;
+    float t_acc;
+    float t_cruise;
+
+    p->angle_abs_deg = angle_abs;
+    p->alpha_deg_s2 = alpha_deg_s2;
+    p->rounding_scale = rounding_scale;
+    p->omega_cap_deg_s = omega_cap_deg_s;
+    p->omega_peak_deg_s = 0.0f;
+    p->t_acc_s = 0.0f;
+    p->t_cruise_s = 0.0f;
+    p->t_total_s = 0.0f;
+    p->n_acc = 0u;
+    p->n_dec_start = 0u;
+    p->n_total = 0u;
+    p->tabulated = false;
+
+    if (!turn_profile_shape(angle_abs, alpha_deg_s2, rounding_scale, omega_cap_deg_s,
+                            &omega_peak, &t_acc, &t_cruise)) {
+        return;
+    }
+
+    p->omega_peak_deg_s = omega_peak;
+    p->t_acc_s = t_acc;
+    p->t_cruise_s = t_cruise;
+    p->t_total_s = 2.0f * t_acc + t_cruise;
+
+    const uint32_t n_acc = ticks_before(t_acc);
+    const uint32_t n_dec_start = ticks_before(t_acc + t_cruise);
+    const uint32_t n_total = ticks_before(p->t_total_s);
+    if (n_total > 0xffffu) {
+        p->t_total_s = 0.0f; // 65 秒を超える旋回は扱わない
+        return;
+    }
+    p->n_acc = (uint16_t)n_acc;
+    p->n_dec_start = (uint16_t)n_dec_start;
+    p->n_total = (uint16_t)n_total;
+
+    if (n_acc > TURN_PROFILE_RAMP_MAX || (n_total - n_dec_start) > TURN_PROFILE_RAMP_MAX) {
+        return; // 表に収まらない: 連続式で評価する
+    }
+    for (uint32_t k = 0; k < n_acc; k++) {
+        const float x = kPi * (tick_time(k) / t_acc);
+        p->acc[k] = to_q16(0.5f * (1.0f - cosf(x)));
+    }
+    for (uint32_t k = n_dec_start; k < n_total; k++) {
+        const float td = tick_time(k) - (t_acc + t_cruise);
+        const float x = kPi * (td / t_acc);
+        p->dec[k - n_dec_start] = to_q16(0.5f * (1.0f + cosf(x)));
+    }
+    p->tabulated = true;
+}
+
+float turn_profile_sample(const turn_profile_t *p, float t_s) {
+    if (p->t_total_s <= 0.0f || p->omega_peak_deg_s <= 0.0f) {
+        return 0.0f;
+    }
+    if (t_s <= 0.0f) {
+        return 0.0f;
+    }
+
+    if (t_s < p->t_acc_s) {
+        const float x = kPi * (t_s / p->t_acc_s);
+        return 0.5f * p->omega_peak_deg_s * (1.0f - cosf(x));
+    }
+
+    if (t_s < (p->t_acc_s + p->t_cruise_s)) {
+        return p->omega_peak_deg_s;
+    }
+
+    if (t_s < p->t_total_s) {
+        const float td = t_s - (p->t_acc_s + p->t_cruise_s);
+        const float x = kPi * (td / p->t_acc_s);
+        return 0.5f * p->omega_peak_deg_s * (1.0f + cosf(x));
+    }
+
+    return 0.0f;
+}
+
+turn_profile_phase_t turn_profile_phase_at(const turn_profile_t *p, uint32_t tick) {
+    if (tick < p->n_acc) {
+        return TURN_PROFILE_PHASE_ACCEL;
+    }
+    if (tick < p->n_dec_start) {
+        return TURN_PROFILE_PHASE_CRUISE;
+    }
+    if (tick < p->n_total) {
+        return TURN_PROFILE_PHASE_DECEL;
+    }
+    return TURN_PROFILE_PHASE_DONE;
+}
+
+float turn_profile_omega_at(const turn_profile_t *p, uint32_t tick) {
+    if (!p->tabulated) {
+        return turn_profile_sample(p, tick_time(tick));
+    }
+    const float scale = p->omega_peak_deg_s * (1.0f / TURN_PROFILE_Q);
+    switch (turn_profile_phase_at(p, tick)) {
+    case TURN_PROFILE_PHASE_ACCEL:
+        return (float)p->acc[tick] * scale;
+    case TURN_PROFILE_PHASE_CRUISE:
+        return p->omega_peak_deg_s;
+    case TURN_PROFILE_PHASE_DECEL:
+        return (float)p->dec[tick - p->n_dec_start] * scale;
+    default:
+        return 0.0f;
+    }
+}
+
+void turn_profile_cache_init(turn_profile_cache_t *c, turn_profile_t *slots, uint8_t count) {
+    c->slots = slots;
+    c->count = count;
+    c->used = 0u;
+    c->next = 0u;
+    c->last = 0xffu;
+}
+
+const turn_profile_t *turn_profile_cache_get(turn_profile_cache_t *c, float angle_deg,
+                                             float alpha_deg_s2, float rounding_scale,
+                                             float omega_cap_deg_s) {
+    const float angle_abs = fabsf(angle_deg);
+
+    for (uint8_t i = 0; i < c->used; i++) {
+        const turn_profile_t *p = &c->slots[i];
+        if (p->angle_abs_deg == angle_abs && p->alpha_deg_s2 == alpha_deg_s2 &&
+            p->rounding_scale == rounding_scale && p->omega_cap_deg_s == omega_cap_deg_s) {
+            c->last = i;
+            return p;
+        }
+    }
+    if (c->count == 0u) {
+        return NULL;
+    }
+
+    uint8_t slot;
+    if (c->used < c->count) {
+        slot = c->used++;
+    } else {
+        // 満杯: 古い順に上書きする（直前に返した＝実行中かもしれない枠は避ける）
+        slot = c->next;
+        if (slot == c->last && c->count > 1u) {
+            slot = (uint8_t)((slot + 1u) % c->count);
+        }
+        c->next = (uint8_t)((slot + 1u) % c->count);
+    }
+    turn_profile_build(&c->slots[slot], angle_abs, alpha_deg_s2, rounding_scale, omega_cap_deg_s);
+    c->last = slot;
+    return &c->slots[slot];
+}
@@ -12,6 +12,9 @@
 #include <stdbool.h>
 #include <stdint.h>
 
+#include "spi_bus_sched.h"
+#include "turn_profile.h"
+
 #define F413_CTRL_TUNE_AXIS_VELOCITY  (0U)
 #define F413_CTRL_TUNE_AXIS_OMEGA     (1U)
 #define F413_CTRL_TUNE_AXIS_DISTANCE  (2U)
@@ -38,13 +41,57 @@ void f413_ctrl_set_velocity_profile(float start_velocity_mm_s,
                                     float target_velocity_mm_s,
                                     float distance_mm);
 void f413_ctrl_set_omega(float omega_deg_s);
-void f413_ctrl_start_omega_profile(float signed_omega_peak_deg_s,
-                                   float accel_time_s,
-                                   float cruise_time_s);
+/* 旋回表を制御割り込みで再生する（表は呼び出し側が終了まで保持する） */
+void f413_ctrl_start_turn_profile(const turn_profile_t* profile, int8_t sign);
+bool f413_ctrl_turn_profile_active(void);
 void f413_ctrl_stop_omega_profile(void);
 void f413_ctrl_set_angle_target(float angle_deg);
 void f413_ctrl_clear_angle_target(void);
 void f413_ctrl_set_heading_omega_correction(float omega_deg_s);
+
+/* 走行コマンドキュー: メインループが区間を積み、制御 tick が前の区間の終わった tick に次を始める。
+   メインループは積み込みと完了数の確認（f413_ctrl_queue_done_count()）だけを行い、
+   区間の境目で目標の更新が 1 周期以上遅れることがない */
+#define F413_CTRL_QUEUE_LEN (8U) /* 2 のべき乗 */
+
+#define F413_CTRL_CMD_STRAIGHT (0U) /* v_in → v_out の等加速度で distance_mm 進む（角速度 0） */
+#define F413_CTRL_CMD_TURN     (1U) /* 旋回表を v_out の等速で再生する */
+
+#define F413_CTRL_CMD_FLAG_RESET_ANGLE (0x01U) /* 開始時に角度を 0 に戻す（角度積算モードでないとき） */
+
+typedef struct
+{
+    uint8_t type;                  /* F413_CTRL_CMD_* */
+    uint8_t flags;                 /* F413_CTRL_CMD_FLAG_* */
+    int8_t sign;                   /* 旋回方向（-1: 右、+1: 左） */
+    uint16_t tag;                  /* 呼び出し側の識別（状態の確認用） */
+    float distance_mm;             /* 直進の距離 [mm] */
+    float v_in;                    /* 直進の入口速度 [mm/s] */
+    float v_out;                   /* 直進の出口速度・旋回の速度 [mm/s] */
+    const turn_profile_t* profile; /* 旋回表（終了まで呼び出し側が保持する） */
+} f413_ctrl_cmd_t;
+
+typedef struct
+{
+    uint8_t pending;      /* 積まれて未開始のコマンド数 */
+    bool busy;            /* 実行中のコマンドがある */
+    uint8_t type;         /* 実行中（最後に実行した）コマンドの種類 */
+    uint16_t tag;
+    uint32_t started;     /* 開始したコマンド数 */
+    uint32_t done;        /* 終了したコマンド数 */
+    uint32_t underrun_ms; /* 次のコマンドが無く出口速度を保持していた時間 */
+} f413_ctrl_queue_status_t;
+
+/* 積めたら true。満杯・距離 0 の直進・表の無い旋回は false（積まない） */
+bool f413_ctrl_queue_push(const f413_ctrl_cmd_t* cmd);
+/* 積んだコマンドを捨て、実行中の区間も打ち切る（速度・角速度の指令はその時点の値のまま） */
+void f413_ctrl_queue_clear(void);
+bool f413_ctrl_queue_idle(void);
+/* これまでに積んだ数と終えた数。積んだ直後の値まで done が進めばその区間は終わっている */
+uint32_t f413_ctrl_queue_pushed_count(void);
+uint32_t f413_ctrl_queue_done_count(void);
+void f413_ctrl_queue_get_status(f413_ctrl_queue_status_t* st);
+
 void f413_ctrl_tune_start(uint8_t axis, uint8_t set, uint8_t pattern);
 void f413_ctrl_tune_stop(void);
 bool f413_ctrl_tune_is_active(void);
@@ -83,15 +130,62 @@ int16_t f413_ctrl_get_log_encoder_delta_l(void);
 int16_t f413_ctrl_get_log_encoder_delta_r(void);
 bool f413_ctrl_angle_target_enabled(void);
 
+/* 制御ゲイン（既定は params.h の *_FAN_OFF / *_FAN_ON）。制御 tick が毎周期ここから読むので、
+   パラメータストア（f413_param_table.c）で停止中に書き換えれば次の走行から効く */
+typedef struct
+{
+    float kp_d;
+    float ki_d;
+    float kd_d;
+    float ff_d;
+    float kp_v;
+    float ki_v;
+    float kd_v;
+    float ff_ts; /* 並進 FF: 静止摩擦 [PWM] */
+    float ff_tv; /* 並進 FF: 速度比例 [PWM / (mm/s)] */
+    float ff_ta; /* 並進 FF: 加速度比例 [PWM / (mm/s^2)] */
+    float kp_a;
+    float ki_a;
+    float kd_a;
+    float ff_a;
+    float kp_o;
+    float ki_o;
+    float kd_o;
+    float ff_o;
+    float ff_oa;
+} f413_ctrl_gains_t;
+
+#define F413_CTRL_GAIN_SET_FAN_OFF (0U)
+#define F413_CTRL_GAIN_SET_FAN_ON  (1U)
+#define F413_CTRL_GAIN_SET_COUNT   (2U)
+
+extern f413_ctrl_gains_t g_f413_ctrl_gains[F413_CTRL_GAIN_SET_COUNT];
+
 /* 1kHz 割り込みハンドラ（HAL_TIM_PeriodElapsedCallback から呼ぶ） */
 void f413_ctrl_tick(void);
 
 /* 制御が有効かどうか */
 bool f413_ctrl_is_running(void);
 
-/* SPI2 バス排他: 割り込みコンテキストの IMU 読取中は true を返す。
-   メインループ側の FRAM 操作はこれが false の間のみ安全。 */
-bool f413_ctrl_spi2_busy(void);
+/* SPI2 バスの時間割（platform/bus/spi_bus_sched）: 制御周期の先頭は IMU のスロット、
+   FRAM（nvm.c）はその周期の IMU 読取が終わった後、次のスロットまでに終わる転送だけ行う。
+   fram_begin は cost_us [us] の転送が今の窓に収まり SPI2 が空いていればバスを渡して true
+   （終わったら fram_end）。window_us は今から使える残り時間（停止中は UINT32_MAX）。割り込みからも呼べる。 */
+uint32_t f413_ctrl_spi2_fram_window_us(void);
+bool f413_ctrl_spi2_fram_begin(uint32_t cost_us);
+void f413_ctrl_spi2_fram_end(void);
+/* 制御 tick が毎周期 IMU を読んでいるか（FRAM 側は IMU 読取の合間にだけ転送する） */
+bool f413_ctrl_spi2_imu_scheduled(void);
+/* IMU スロットの取りこぼし（skipped / late / errors）と FRAM の許可・見送り・超過の集計 */
+void f413_ctrl_spi2_get_stats(spi_bus_sched_stats_t *out);
+void f413_ctrl_spi2_reset_stats(void);
+/* IMU 読取が終わり SPI2 が空いたときに呼ぶ関数（割り込みから呼ばれる。NULL で解除） */
+typedef void (*f413_ctrl_spi2_idle_hook_t)(void);
+void f413_ctrl_set_spi2_idle_hook(f413_ctrl_spi2_idle_hook_t hook);
+
+/* IMU 6軸バースト読取の DMA 完了割り込み（DMA1 Stream3, stm32f4xx_it.c から呼ぶ）と転送エラー数 */
+void f413_ctrl_imu_dma_irq_handler(void);
+uint32_t f413_ctrl_imu_burst_errors(void);
 
 #ifdef __cplusplus
 }
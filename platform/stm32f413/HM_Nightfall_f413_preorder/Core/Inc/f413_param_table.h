@@ -0,0 +1,19 @@
+#ifndef F413_PARAM_TABLE_H_
+#define F413_PARAM_TABLE_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* 実行時に書き換えられる調整値の表（nvm/nvm_param_store.h）と UART の行入力コマンド。
+ * 対象: 制御ゲイン（ファン停止時/動作時）、壁しきい値、ゴール座標、最短走行のモード・ケースの主な値。
+ * 保存先は FRAM の NVM_AREA_TUNE_PARAMS。起動時に読み込み、無い・壊れていればコンパイル時の値で動く。 */
+
+/* 表を登録して保存値を読み込む（起動時に 1 回。FRAM が使えるようになってから） */
+void f413_param_table_init(void);
+
+/* ':' で行入力に入る。行入力中の文字は f413_param_table_cli_feed() に渡す */
+void f413_param_table_cli_begin(void);
+bool f413_param_table_cli_active(void);
+void f413_param_table_cli_feed(uint8_t c);
+
+#endif
@@ -19,6 +19,7 @@
 #define NIGHTFALL_F413_PATH_TIMEOUT_MS    (5000U)
 #define NIGHTFALL_F413_PATH_VELOCITY_CAP  (0.0f)
 #define NIGHTFALL_F413_PATH_OMEGA_CAP     (2200.0f)
+#define NIGHTFALL_F413_TURN_PROFILE_MARGIN_MS (50U) /* 旋回表の再生待ちの余裕（割り込み停止時の打ち切り） */
 
 #if (NIGHTFALL_F413_REAL_RUN_PATH_ENABLED != 0U)
 void f413_path_run_print_preview(void);
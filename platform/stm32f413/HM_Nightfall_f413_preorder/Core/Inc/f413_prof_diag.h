@@ -0,0 +1,12 @@
+#ifndef F413_PROF_DIAG_H_
+#define F413_PROF_DIAG_H_
+
+#include <stdint.h>
+
+/* DWT サイクルカウンタを有効にして isr_prof（platform/prof）の集計を始める */
+void f413_prof_diag_init(void);
+/* 区間ごとの min/mean/max/予算超過とヒストグラム、SPI2 の時間割の集計を UART へ出す */
+void f413_prof_diag_run_dump_once(void);
+void f413_prof_diag_run_reset_once(void);
+
+#endif
@@ -77,5 +77,7 @@ void f413_search_step_run_map_probe_once(void);
 void f413_search_step_run_status_once(void);
 void f413_search_step_run_map_clear_once(void);
 void f413_search_step_run_map_dump_once(void);
+/* map[][] を探索ステップの外で書き換えた（load_map_from_eeprom()）後に呼び、壁の行ビットボードを作り直す */
+void f413_search_step_map_reloaded(void);
 
 #endif
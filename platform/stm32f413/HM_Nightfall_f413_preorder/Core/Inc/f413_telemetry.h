@@ -0,0 +1,19 @@
+#ifndef F413_TELEMETRY_H_
+#define F413_TELEMETRY_H_
+
+#include <stdbool.h>
+
+#include "nvm_trace_log.h"
+
+/* 自動トレースの記録を UART へ差分符号化パケット（platform/trace/telemetry.h）で流す。
+ * 受信は tools/logging/telemetry_decode.py。 */
+void f413_telemetry_toggle(void);
+bool f413_telemetry_is_enabled(void);
+/* 間引きの組を run -> motion -> wall -> all の順に切り替える */
+void f413_telemetry_next_preset(void);
+/* f413_trace_log_auto_step() から記録の順に渡す（メインループ側。割り込みからは呼ばない） */
+void f413_telemetry_send_record(const nvm_trace_log_record_t* rec);
+/* 組み立て中のパケットを送り出す（自動トレースの停止時） */
+void f413_telemetry_flush(void);
+
+#endif
@@ -29,6 +29,17 @@ typedef struct
   bool saturated;
 } f413_wall_sensor_snapshot_t;
 
+/* 壁ありと判定する差分 ADC のしきい値（既定は params.h の WALL_BASE_*。パラメータストアで書き換える） */
+typedef struct
+{
+  uint16_t fr;
+  uint16_t fl;
+  uint16_t r;
+  uint16_t l;
+} f413_wall_sensor_threshold_t;
+
+extern f413_wall_sensor_threshold_t g_f413_wall_threshold;
+
 bool f413_wall_sensor_start_async(void);
 void f413_wall_sensor_tim6_tick(void);
 void f413_wall_sensor_adc_complete(ADC_HandleTypeDef* hadc);
@@ -4,7 +4,7 @@
  *
  * TIM5 1kHz 割り込みで以下を実行する:
  *   1. TIM3(左)/TIM4(右) エンコーダの差分から並進速度を算出
- *   2. ISM330DHCX (SPI2) から角速度を読み取り（IMUベース）
+ *   2. ISM330DHCX (SPI2) の6軸を1回のバーストで読み取り（SPI DMA, 前 tick のサンプルを使用）
  *   3. P+FF 制御で並進/回転の出力を計算
  *   4. TIM2 CH1(左)/CH3(右) PWM + GPIO 方向ピンでモータを駆動
  *
@@ -14,6 +14,8 @@
 #include "f413_control.h"
 #include "main.h"
 #include "params.h"
+#include "ism330_burst.h"
+#include "isr_prof.h"
 #include <math.h>
 #include <string.h>
 
@@ -77,17 +79,16 @@
 #define F413_IMU_CTRL1_XL         (0x10U)    /* 加速度設定 */
 #define F413_IMU_CTRL2_G          (0x11U)    /* ジャイロ設定 */
 #define F413_IMU_CTRL3_C          (0x12U)    /* 制御レジスタ3 */
-#define F413_IMU_OUTZ_G_L         (0x26U)    /* ジャイロ Z軸 LOW byte */
-#define F413_IMU_OUTZ_G_H         (0x27U)    /* ジャイロ Z軸 HIGH byte */
-#define F413_IMU_OUTX_XL_L        (0x28U)
-#define F413_IMU_OUTY_XL_L        (0x2AU)
-#define F413_IMU_GYRO_SENSITIVITY (0.14f)    /* FS=4000dps → 140mdps/LSB [deg/s/LSB] */
+#define F413_IMU_GYRO_SENSITIVITY (ISM330_GYRO_DPS_PER_LSB)  /* FS=4000dps → 140mdps/LSB [deg/s/LSB] */
 #define F413_IMU_ACCEL_SENS_MG    (0.488f)
 #define F413_IMU_GRAVITY_MM_S2    (9.80665f)
 #define F413_IMU_OFFSET_SAMPLES   (500U)     /* オフセット測定回数 */
 #define F413_IMU_OFFSET_SETTLE_MS (200U)     /* 静定待ち [ms] */
-#define F413_IMU_FORWARD_ACCEL_REG  (F413_IMU_OUTY_XL_L)
+#define F413_IMU_FORWARD_ACCEL_AXIS (1U)      /* 0:X 1:Y 2:Z (旧 OUTY_XL) */
 #define F413_IMU_FORWARD_ACCEL_SIGN (1.0f)
+#ifndef F413_IMU_BURST_USE_DMA
+#define F413_IMU_BURST_USE_DMA    (1)        /* 0: tick 内でブロッキングのバースト読取 */
+#endif
 #define F413_CTRL_VEL_EST_MAX     (1200.0f)
 #define F413_CTRL_VEL_ACCEL_COMP_WINDOW_MAX_MS (64U)
 #define F413_CTRL_TUNE_TOTAL_MS   (800U)
@@ -133,12 +134,9 @@ static volatile float s_target_angle = 0.0f;
 static volatile float s_target_omega = 0.0f;
 static volatile float s_heading_omega_correction = 0.0f;
 static volatile bool s_angle_target_enabled = false;
-static volatile bool s_omega_profile_active = false;
-static volatile float s_omega_profile_peak = 0.0f;
-static volatile float s_omega_profile_t_acc = 0.0f;
-static volatile float s_omega_profile_t_cruise = 0.0f;
-static volatile float s_omega_profile_t_total = 0.0f;
-static volatile float s_omega_profile_elapsed = 0.0f;
+static const turn_profile_t* volatile s_omega_profile = NULL; /* 実行中の旋回表（NULL:停止） */
+static volatile uint32_t s_omega_profile_tick = 0U;
+static volatile int8_t s_omega_profile_sign = 0;
 
 static volatile float s_real_distance = 0.0f;
 static volatile float s_real_velocity = 0.0f;
@@ -197,7 +195,14 @@ static uint16_t s_angle_outer_count = 0U;
 static float s_omega_ref_accel = 0.0f;
 static float s_omega_ref_lead = 0.0f;
 
-static volatile bool s_spi2_busy = false;
+/* SPI2 の時間割: 制御周期（TIM5, 1 カウント = 1us）の先頭を IMU、残りを FRAM に割り当てる */
+#define F413_SPI2_PERIOD_US       (1000U)
+#define F413_SPI2_GUARD_US        (50U)      /* 次の IMU スロットの前に空けておく余裕（割り込み遅れ分） */
+static spi_bus_sched_t s_spi2_sched = {
+    .period_us = F413_SPI2_PERIOD_US,
+    .guard_us = F413_SPI2_GUARD_US,
+};
+static f413_ctrl_spi2_idle_hook_t s_spi2_idle_hook = NULL;
 static volatile bool s_imu_motion_sample_valid = false;
 static volatile bool s_tune_active = false;
 static volatile bool s_tune_done = false;
@@ -207,6 +212,37 @@ static volatile uint8_t s_tune_pattern = F413_CTRL_TUNE_PATTERN_STEP;
 static volatile uint16_t s_tune_tick = 0U;
 static volatile float s_tune_reference = 0.0f;
 
+/* 走行コマンドキュー（積むのはメインループ、取り出すのは制御 tick だけ） */
+#define F413_CTRL_QUEUE_MASK (F413_CTRL_QUEUE_LEN - 1U)
+static f413_ctrl_cmd_t s_q[F413_CTRL_QUEUE_LEN];
+static volatile uint8_t s_q_head = 0U;
+static volatile uint8_t s_q_tail = 0U;
+static f413_ctrl_cmd_t s_q_run;             /* 実行中のコマンド（制御 tick 側のコピー） */
+static volatile bool s_q_busy = false;
+static volatile bool s_q_hold = false;      /* 出口速度 != 0 で終わり、次のコマンドを待っている */
+static float s_q_end_mm = 0.0f;             /* 直進の終了距離（f413_ctrl_get_distance() の値） */
+static uint32_t s_q_pushed = 0U;            /* メインループだけが書く */
+static volatile uint32_t s_q_started = 0U;
+static volatile uint32_t s_q_done = 0U;
+static volatile uint32_t s_q_underrun_ms = 0U;
+
+f413_ctrl_gains_t g_f413_ctrl_gains[F413_CTRL_GAIN_SET_COUNT] = {
+    [F413_CTRL_GAIN_SET_FAN_OFF] = {
+        KP_DISTANCE_FAN_OFF, KI_DISTANCE_FAN_OFF, KD_DISTANCE_FAN_OFF, FF_DISTANCE_FAN_OFF,
+        KP_VELOCITY_FAN_OFF, KI_VELOCITY_FAN_OFF, KD_VELOCITY_FAN_OFF,
+        FF_TRANSLATION_STATIC_PWM_FAN_OFF, FF_TRANSLATION_VELOCITY_PWM_FAN_OFF, FF_TRANSLATION_ACCEL_PWM_FAN_OFF,
+        KP_ANGLE_FAN_OFF, KI_ANGLE_FAN_OFF, KD_ANGLE_FAN_OFF, FF_ANGLE_FAN_OFF,
+        KP_OMEGA_FAN_OFF, KI_OMEGA_FAN_OFF, KD_OMEGA_FAN_OFF, FF_OMEGA_PWM_FAN_OFF, FF_OMEGA_ACCEL_PWM_FAN_OFF,
+    },
+    [F413_CTRL_GAIN_SET_FAN_ON] = {
+        KP_DISTANCE_FAN_ON, KI_DISTANCE_FAN_ON, KD_DISTANCE_FAN_ON, FF_DISTANCE_FAN_ON,
+        KP_VELOCITY_FAN_ON, KI_VELOCITY_FAN_ON, KD_VELOCITY_FAN_ON,
+        FF_TRANSLATION_STATIC_PWM_FAN_ON, FF_TRANSLATION_VELOCITY_PWM_FAN_ON, FF_TRANSLATION_ACCEL_PWM_FAN_ON,
+        KP_ANGLE_FAN_ON, KI_ANGLE_FAN_ON, KD_ANGLE_FAN_ON, FF_ANGLE_FAN_ON,
+        KP_OMEGA_FAN_ON, KI_OMEGA_FAN_ON, KD_OMEGA_FAN_ON, FF_OMEGA_PWM_FAN_ON, FF_OMEGA_ACCEL_PWM_FAN_ON,
+    },
+};
+
 static bool f413_ctrl_use_fan_on_gains(void)
 {
     return false;
@@ -214,69 +250,31 @@ static bool f413_ctrl_use_fan_on_gains(void)
 
 static void f413_ctrl_cancel_omega_profile(void)
 {
-    s_omega_profile_active = false;
-    s_omega_profile_peak = 0.0f;
-    s_omega_profile_t_acc = 0.0f;
-    s_omega_profile_t_cruise = 0.0f;
-    s_omega_profile_t_total = 0.0f;
-    s_omega_profile_elapsed = 0.0f;
-}
-
-static float f413_ctrl_sample_omega_profile(float t_s)
-{
-    const float pi = 3.14159265358979323846f;
-    const float omega_peak_abs = fabsf(s_omega_profile_peak);
-    float omega_abs;
-    float sign;
-
-    if ((s_omega_profile_t_total <= 0.0f) ||
-        (s_omega_profile_t_acc <= 0.0f) ||
-        (omega_peak_abs <= 0.0f) ||
-        (t_s <= 0.0f))
-    {
-        return 0.0f;
-    }
-
-    if (t_s < s_omega_profile_t_acc)
-    {
-        const float x = pi * (t_s / s_omega_profile_t_acc);
-        omega_abs = 0.5f * omega_peak_abs * (1.0f - cosf(x));
-    }
-    else if (t_s < (s_omega_profile_t_acc + s_omega_profile_t_cruise))
-    {
-        omega_abs = omega_peak_abs;
-    }
-    else if (t_s < s_omega_profile_t_total)
-    {
-        const float td = t_s - (s_omega_profile_t_acc + s_omega_profile_t_cruise);
-        const float x = pi * (td / s_omega_profile_t_acc);
-        omega_abs = 0.5f * omega_peak_abs * (1.0f + cosf(x));
-    }
-    else
-    {
-        return 0.0f;
-    }
-
-    sign = (s_omega_profile_peak < 0.0f) ? -1.0f : 1.0f;
-    return sign * omega_abs;
+    s_omega_profile = NULL;
+    s_omega_profile_tick = 0U;
+    s_omega_profile_sign = 0;
 }
 
+/* 旋回表を1tick進める（cosf は使わず、作成済みの表を引くだけ） */
 static void f413_ctrl_update_omega_profile(void)
 {
-    if (!s_omega_profile_active)
+    const turn_profile_t* profile = s_omega_profile;
+    const uint32_t tick = s_omega_profile_tick;
+
+    if (profile == NULL)
     {
         return;
     }
 
-    if (s_omega_profile_elapsed >= s_omega_profile_t_total)
+    if (tick >= profile->n_total)
     {
         s_omega_interrupt = 0.0f;
-        s_omega_profile_active = false;
+        s_omega_profile = NULL;
         return;
     }
 
-    s_omega_interrupt = f413_ctrl_sample_omega_profile(s_omega_profile_elapsed);
-    s_omega_profile_elapsed += F413_CTRL_DT;
+    s_omega_interrupt = (float)s_omega_profile_sign * turn_profile_omega_at(profile, tick);
+    s_omega_profile_tick = tick + 1U;
 }
 
 static float f413_ctrl_lpf_update(float previous, float input, float tau_s)
@@ -459,8 +457,18 @@ static void f413_ctrl_reset_pid_state(void)
     s_angle_outer_count = 0U;
 }
 
+/* 積んだコマンドを捨てる（打ち切った分も終わったものとして数える） */
+static void f413_ctrl_queue_drop(void)
+{
+    s_q_tail = s_q_head;
+    s_q_busy = false;
+    s_q_hold = false;
+    s_q_done = s_q_pushed;
+}
+
 static void f413_ctrl_reset_profile_state(void)
 {
+    f413_ctrl_queue_drop();
     s_acceleration_interrupt = 0.0f;
     s_velocity_interrupt = 0.0f;
     s_velocity_profile_target = 0.0f;
@@ -768,6 +776,69 @@ static void f413_ctrl_tune_finish_now(void)
     s_out_rotate = 0.0f;
 }
 
+/* ========================================================== */
+/* SPI2 バス共有（IMU / FRAM）                                  */
+/* ========================================================== */
+
+/* IMU 読取が終わって SPI2 が空いたことを通知する（FRAM 書き込みキューの次 chunk を起動） */
+static void spi2_notify_idle(void)
+{
+    f413_ctrl_spi2_idle_hook_t hook = s_spi2_idle_hook;
+    if (hook != NULL)
+    {
+        hook();
+    }
+}
+
+/* 周期内の時刻 [us]。周期が終わって制御 tick がまだ走っていなければ窓の外（UINT32_MAX）とする */
+static uint32_t spi2_now_us(void)
+{
+    if ((TIM5->SR & TIM_SR_UIF) != 0U)
+    {
+        return UINT32_MAX;
+    }
+    return TIM5->CNT;
+}
+
+/* 初期化・オフセット取得のブロッキング IMU 読取用（IMU スロットが動いていない間だけ使う）:
+   FRAM の転送が終わるまで待って占有する */
+static void imu_bus_lock(void)
+{
+    for (;;)
+    {
+        bool ok;
+        uint32_t primask = __get_PRIMASK();
+
+        __disable_irq();
+        ok = spi_bus_sched_try_claim(&s_spi2_sched, SPI_BUS_OWNER_IMU);
+        __set_PRIMASK(primask);
+        if (ok)
+        {
+            return;
+        }
+    }
+}
+
+/* 制御 tick が毎周期 IMU を読むかどうかを時間割へ伝える（走行の開始・終了） */
+static void spi2_set_imu_scheduled(bool scheduled)
+{
+    uint32_t primask = __get_PRIMASK();
+
+    __disable_irq();
+    spi_bus_sched_set_imu_scheduled(&s_spi2_sched, scheduled);
+    __set_PRIMASK(primask);
+}
+
+static void imu_bus_unlock(void)
+{
+    uint32_t primask = __get_PRIMASK();
+
+    __disable_irq();
+    spi_bus_sched_release(&s_spi2_sched);
+    __set_PRIMASK(primask);
+    spi2_notify_idle();
+}
+
 /* ========================================================== */
 /* IMU SPI helpers (ISM330DHCX on SPI2, CS = IMU_CS)          */
 /* ========================================================== */
@@ -777,10 +848,12 @@ static uint8_t imu_read_byte(uint8_t reg)
     uint8_t tx[2] = { (uint8_t)(reg | 0x80U), 0x00U };
     uint8_t rx[2] = { 0U, 0U };
 
+    imu_bus_lock();
     HAL_GPIO_WritePin(FRAM_CS_GPIO_Port, FRAM_CS_Pin, GPIO_PIN_SET);
     HAL_GPIO_WritePin(IMU_CS_GPIO_Port, IMU_CS_Pin, GPIO_PIN_RESET);
     (void)HAL_SPI_TransmitReceive(&hspi2, tx, rx, 2U, 10U);
     HAL_GPIO_WritePin(IMU_CS_GPIO_Port, IMU_CS_Pin, GPIO_PIN_SET);
+    imu_bus_unlock();
     return rx[1];
 }
 
@@ -788,38 +861,198 @@ static void imu_write_byte(uint8_t reg, uint8_t val)
 {
     uint8_t tx[2] = { (uint8_t)(reg & 0x7FU), val };
 
+    imu_bus_lock();
     HAL_GPIO_WritePin(FRAM_CS_GPIO_Port, FRAM_CS_Pin, GPIO_PIN_SET);
     HAL_GPIO_WritePin(IMU_CS_GPIO_Port, IMU_CS_Pin, GPIO_PIN_RESET);
     (void)HAL_SPI_Transmit(&hspi2, tx, 2U, 10U);
     HAL_GPIO_WritePin(IMU_CS_GPIO_Port, IMU_CS_Pin, GPIO_PIN_SET);
+    imu_bus_unlock();
+}
+
+/* 6軸出力（0x22..0x2D）を 1 回の CS サイクルで読む。
+   ISM330DHCX は IF_INC=1 (CTRL3_C) なので自動アドレスインクリメントされ、
+   BDU=1 により読取完了まで出力レジスタが更新されない。 */
+static uint8_t s_imu_burst_tx[ISM330_BURST_XFER_LEN];
+static uint8_t s_imu_burst_rx[ISM330_BURST_XFER_LEN];
+
+#if F413_IMU_BURST_USE_DMA
+/* SPI2_RX = DMA1 Stream3 / Channel0, SPI2_TX = DMA1 Stream4 / Channel0
+   tick 先頭（IMU スロット）で次のバーストを起動し、制御は前 tick に完了したサンプルを使う（1ms 遅れ）。
+   転送中は SPI2 を IMU が持ったままにして、FRAM 側 (nvm.c) に待たせる。
+   TX ストリームは FRAM 書き込みの DMA と共用するため、起動のたびに設定し直す。 */
+#define F413_IMU_DMA_RX_STREAM    DMA1_Stream3
+#define F413_IMU_DMA_TX_STREAM    DMA1_Stream4
+#define F413_IMU_DMA_RX_IRQn      DMA1_Stream3_IRQn
+#define F413_IMU_DMA_RX_CLEAR_FLAGS \
+    (DMA_LIFCR_CTCIF3 | DMA_LIFCR_CHTIF3 | DMA_LIFCR_CTEIF3 | DMA_LIFCR_CDMEIF3 | DMA_LIFCR_CFEIF3)
+#define F413_IMU_DMA_TX_CLEAR_FLAGS \
+    (DMA_HIFCR_CTCIF4 | DMA_HIFCR_CHTIF4 | DMA_HIFCR_CTEIF4 | DMA_HIFCR_CDMEIF4 | DMA_HIFCR_CFEIF4)
+#define F413_IMU_DMA_TX_CR        (DMA_SxCR_PL_1 | DMA_SxCR_DIR_0 | DMA_SxCR_MINC) /* メモリ→ペリフェラル, Channel0 */
+#define F413_IMU_DMA_STALL_TICKS  (3U)       /* 完了しないまま経過した tick 数がこれに達したら打ち切る */
+
+static volatile bool s_imu_burst_inflight = false;
+static volatile bool s_imu_burst_ready = false;   /* 未消費の完了サンプルあり */
+static ism330_raw_t s_imu_burst_raw;
+static uint8_t s_imu_burst_stall = 0U;
+
+static void imu_dma_stream_off(DMA_Stream_TypeDef *stream)
+{
+    stream->CR &= ~DMA_SxCR_EN;
+    while ((stream->CR & DMA_SxCR_EN) != 0U)
+    {
+    }
+}
+
+static void imu_dma_init(void)
+{
+    __HAL_RCC_DMA1_CLK_ENABLE();
+    imu_dma_stream_off(F413_IMU_DMA_RX_STREAM);
+    imu_dma_stream_off(F413_IMU_DMA_TX_STREAM);
+    DMA1->LIFCR = F413_IMU_DMA_RX_CLEAR_FLAGS;
+    DMA1->HIFCR = F413_IMU_DMA_TX_CLEAR_FLAGS;
+
+    F413_IMU_DMA_RX_STREAM->PAR = (uint32_t)&SPI2->DR;
+    F413_IMU_DMA_RX_STREAM->M0AR = (uint32_t)s_imu_burst_rx;
+    F413_IMU_DMA_RX_STREAM->FCR = 0U; /* ダイレクトモード */
+    F413_IMU_DMA_RX_STREAM->CR = DMA_SxCR_PL_1 | /* ペリフェラル→メモリ, Channel0 */
+                                 DMA_SxCR_MINC |
+                                 DMA_SxCR_TCIE |
+                                 DMA_SxCR_TEIE;
+
+    F413_IMU_DMA_TX_STREAM->PAR = (uint32_t)&SPI2->DR;
+    F413_IMU_DMA_TX_STREAM->M0AR = (uint32_t)s_imu_burst_tx;
+    F413_IMU_DMA_TX_STREAM->FCR = 0U;
+    F413_IMU_DMA_TX_STREAM->CR = F413_IMU_DMA_TX_CR;
+
+    s_imu_burst_inflight = false;
+    s_imu_burst_ready = false;
+    s_imu_burst_stall = 0U;
+
+    /* TIM5 と同じ優先度にして、1kHz 制御の途中でサンプルが差し替わらないようにする */
+    HAL_NVIC_SetPriority(F413_IMU_DMA_RX_IRQn, 0, 0);
+    HAL_NVIC_EnableIRQ(F413_IMU_DMA_RX_IRQn);
+}
+
+/* 転送を終えて CS を上げ、SPI2 を解放する（完了・エラー・打ち切り共通） */
+static void imu_dma_finish(bool ok)
+{
+    SPI2->CR2 &= ~(SPI_CR2_RXDMAEN | SPI_CR2_TXDMAEN);
+    imu_dma_stream_off(F413_IMU_DMA_RX_STREAM);
+    imu_dma_stream_off(F413_IMU_DMA_TX_STREAM);
+    while ((SPI2->SR & SPI_SR_BSY) != 0U)
+    {
+    }
+    HAL_GPIO_WritePin(IMU_CS_GPIO_Port, IMU_CS_Pin, GPIO_PIN_SET);
+    s_imu_burst_stall = 0U;
+    s_imu_burst_inflight = false;
+    spi_bus_sched_imu_end(&s_spi2_sched, ok);
+    spi2_notify_idle();
 }
 
-static int16_t imu_read16_le(uint8_t reg_l)
+/* 前回のバーストが終わっていない: この tick は起動せず、長引けば打ち切る */
+static void imu_dma_check_stall(void)
 {
-    /* バーストリード: 1回のCS cycleで lo+hi を連続読取。
-       ISM330DHCX は IF_INC=1 (CTRL3_C) なので自動アドレスインクリメントされ、
-       BDU=1 により読取完了まで出力レジスタが更新されない。 */
-    uint8_t tx[3] = { (uint8_t)(reg_l | 0x80U), 0x00U, 0x00U };
-    uint8_t rx[3] = { 0U, 0U, 0U };
+    if (s_imu_burst_inflight && (++s_imu_burst_stall >= F413_IMU_DMA_STALL_TICKS))
+    {
+        imu_dma_finish(false);
+    }
+}
 
+/* IMU スロットで SPI2 を取った状態で呼ぶ */
+static void imu_dma_start(void)
+{
+    DMA1->LIFCR = F413_IMU_DMA_RX_CLEAR_FLAGS;
+    DMA1->HIFCR = F413_IMU_DMA_TX_CLEAR_FLAGS;
+    (void)SPI2->DR; /* 残っている RXNE/OVR を捨てる */
+    (void)SPI2->SR;
+    F413_IMU_DMA_RX_STREAM->NDTR = ISM330_BURST_XFER_LEN;
+    F413_IMU_DMA_TX_STREAM->CR = F413_IMU_DMA_TX_CR;
+    F413_IMU_DMA_TX_STREAM->M0AR = (uint32_t)s_imu_burst_tx;
+    F413_IMU_DMA_TX_STREAM->NDTR = ISM330_BURST_XFER_LEN;
+
+    s_imu_burst_inflight = true;
     HAL_GPIO_WritePin(FRAM_CS_GPIO_Port, FRAM_CS_Pin, GPIO_PIN_SET);
     HAL_GPIO_WritePin(IMU_CS_GPIO_Port, IMU_CS_Pin, GPIO_PIN_RESET);
-    (void)HAL_SPI_TransmitReceive(&hspi2, tx, rx, 3U, 10U);
-    HAL_GPIO_WritePin(IMU_CS_GPIO_Port, IMU_CS_Pin, GPIO_PIN_SET);
+    SPI2->CR1 |= SPI_CR1_SPE;
+    F413_IMU_DMA_RX_STREAM->CR |= DMA_SxCR_EN;
+    F413_IMU_DMA_TX_STREAM->CR |= DMA_SxCR_EN;
+    SPI2->CR2 |= SPI_CR2_RXDMAEN | SPI_CR2_TXDMAEN;
+}
+
+/* 完了済みの未消費サンプルを取り出す（無ければ false） */
+static bool imu_dma_take(ism330_raw_t *raw)
+{
+    bool fresh = false;
+    uint32_t primask = __get_PRIMASK();
+
+    __disable_irq();
+    if (s_imu_burst_ready)
+    {
+        *raw = s_imu_burst_raw;
+        s_imu_burst_ready = false;
+        fresh = true;
+    }
+    __set_PRIMASK(primask);
+    return fresh;
+}
+
+/* DMA1 Stream3（SPI2 RX）割り込み。RX 完了 = 最終バイトまで受信済み。 */
+void f413_ctrl_imu_dma_irq_handler(void)
+{
+    uint32_t lisr = DMA1->LISR;
+
+    DMA1->LIFCR = F413_IMU_DMA_RX_CLEAR_FLAGS;
+    if (!s_imu_burst_inflight || ((lisr & (DMA_LISR_TCIF3 | DMA_LISR_TEIF3)) == 0U))
+    {
+        return;
+    }
+    if ((lisr & DMA_LISR_TEIF3) == 0U)
+    {
+        ism330_burst_decode(s_imu_burst_rx, &s_imu_burst_raw);
+        s_imu_burst_ready = true;
+    }
+    imu_dma_finish((lisr & DMA_LISR_TEIF3) == 0U);
+}
+#else
+void f413_ctrl_imu_dma_irq_handler(void) {}
+#endif
 
-    return (int16_t)((uint16_t)rx[2] << 8U | (uint16_t)rx[1]);
+/* ブロッキングのバースト読取（初期化・オフセット取得用。DMA 版では DMA 転送の終了を待ってから使う） */
+static bool imu_read_burst(ism330_raw_t *raw)
+{
+    HAL_StatusTypeDef st;
+
+#if F413_IMU_BURST_USE_DMA
+    while (s_imu_burst_inflight)
+    {
+    }
+    s_imu_burst_ready = false; /* 古い完了サンプルは捨てる */
+#endif
+    imu_bus_lock();
+    HAL_GPIO_WritePin(FRAM_CS_GPIO_Port, FRAM_CS_Pin, GPIO_PIN_SET);
+    HAL_GPIO_WritePin(IMU_CS_GPIO_Port, IMU_CS_Pin, GPIO_PIN_RESET);
+    st = HAL_SPI_TransmitReceive(&hspi2, s_imu_burst_tx, s_imu_burst_rx,
+                                 ISM330_BURST_XFER_LEN, 10U);
+    HAL_GPIO_WritePin(IMU_CS_GPIO_Port, IMU_CS_Pin, GPIO_PIN_SET);
+    imu_bus_unlock();
+    if (st != HAL_OK)
+    {
+        return false;
+    }
+    ism330_burst_decode(s_imu_burst_rx, raw);
+    return true;
 }
 
-static float imu_read_gyro_z_dps(void)
+static float imu_gyro_z_dps(const ism330_raw_t *raw)
 {
-    return (float)imu_read16_le(F413_IMU_OUTZ_G_L) *
+    return (float)raw->gyro[2] *
            F413_IMU_GYRO_SENSITIVITY *
            F413_IMU_GYRO_Z_SCALE;
 }
 
-static float imu_read_accel_forward_mm_s2(void)
+static float imu_accel_forward_mm_s2(const ism330_raw_t *raw)
 {
-    return (float)imu_read16_le(F413_IMU_FORWARD_ACCEL_REG) *
+    return (float)raw->accel[F413_IMU_FORWARD_ACCEL_AXIS] *
            F413_IMU_ACCEL_SENS_MG *
            F413_IMU_GRAVITY_MM_S2 *
            F413_IMU_FORWARD_ACCEL_SIGN;
@@ -845,6 +1078,11 @@ static bool imu_init_ism330(void)
     imu_write_byte(F413_IMU_CTRL1_XL, 0x7CU);
     HAL_Delay(10U);
 
+    ism330_burst_tx_frame(s_imu_burst_tx);
+#if F413_IMU_BURST_USE_DMA
+    imu_dma_init();
+#endif
+
     return true;
 }
 
@@ -852,22 +1090,32 @@ static void imu_get_motion_offsets(void)
 {
     float gyro_sum = 0.0f;
     float accel_sum = 0.0f;
+    uint32_t n = 0U;
     uint32_t i;
 
     HAL_Delay(F413_IMU_OFFSET_SETTLE_MS);
 
     for (i = 0U; i < F413_IMU_OFFSET_SAMPLES; i++)
     {
-        gyro_sum += imu_read_gyro_z_dps();
-        accel_sum += imu_read_accel_forward_mm_s2();
+        ism330_raw_t raw;
+        if (imu_read_burst(&raw))
+        {
+            gyro_sum += imu_gyro_z_dps(&raw);
+            accel_sum += imu_accel_forward_mm_s2(&raw);
+            n++;
+        }
         HAL_Delay(1U);
     }
+    if (n == 0U)
+    {
+        n = 1U;
+    }
 
-    s_omega_z_offset = gyro_sum / (float)F413_IMU_OFFSET_SAMPLES;
+    s_omega_z_offset = gyro_sum / (float)n;
     s_omega_z_raw = 0.0f;
     s_omega_z_filtered = 0.0f;
     s_omega_z_lpf_inited = false;
-    s_accel_forward_offset = accel_sum / (float)F413_IMU_OFFSET_SAMPLES;
+    s_accel_forward_offset = accel_sum / (float)n;
     s_accel_forward_filtered = 0.0f;
     s_accel_forward_lpf_inited = false;
     f413_ctrl_reset_velocity_accel_comp();
@@ -927,11 +1175,13 @@ void f413_ctrl_start(void)
     HAL_GPIO_WritePin(MOTOR_STBY_GPIO_Port, MOTOR_STBY_Pin, GPIO_PIN_SET);
 
     s_running = true;
+    spi2_set_imu_scheduled(s_imu_ok);
 }
 
 void f413_ctrl_stop(void)
 {
     s_running = false;
+    spi2_set_imu_scheduled(false);
     s_tune_active = false;
     f413_ctrl_reset_profile_state();
     s_target_velocity = 0.0f;
@@ -996,30 +1246,24 @@ void f413_ctrl_set_omega(float omega_deg_s)
     s_target_omega = 0.0f;
 }
 
-void f413_ctrl_start_omega_profile(float signed_omega_peak_deg_s,
-                                   float accel_time_s,
-                                   float cruise_time_s)
+void f413_ctrl_start_turn_profile(const turn_profile_t* profile, int8_t sign)
 {
     f413_ctrl_cancel_omega_profile();
-    if ((signed_omega_peak_deg_s == 0.0f) || (accel_time_s <= 0.0f))
+    s_omega_interrupt = 0.0f;
+    s_target_omega = 0.0f;
+    if ((profile == NULL) || (profile->n_total == 0U) || (sign == 0))
     {
-        s_omega_interrupt = 0.0f;
-        s_target_omega = 0.0f;
         return;
     }
-    if (cruise_time_s < 0.0f)
-    {
-        cruise_time_s = 0.0f;
-    }
 
-    s_omega_profile_peak = signed_omega_peak_deg_s;
-    s_omega_profile_t_acc = accel_time_s;
-    s_omega_profile_t_cruise = cruise_time_s;
-    s_omega_profile_t_total = (2.0f * accel_time_s) + cruise_time_s;
-    s_omega_profile_elapsed = 0.0f;
-    s_omega_interrupt = 0.0f;
-    s_target_omega = 0.0f;
-    s_omega_profile_active = true;
+    s_omega_profile_tick = 0U;
+    s_omega_profile_sign = (sign < 0) ? -1 : 1;
+    s_omega_profile = profile;
+}
+
+bool f413_ctrl_turn_profile_active(void)
+{
+    return s_omega_profile != NULL;
 }
 
 void f413_ctrl_stop_omega_profile(void)
@@ -1043,6 +1287,74 @@ void f413_ctrl_clear_angle_target(void)
     f413_ctrl_reset_angle_outer_state();
 }
 
+bool f413_ctrl_queue_push(const f413_ctrl_cmd_t* cmd)
+{
+    uint8_t next;
+
+    if (cmd == NULL)
+    {
+        return false;
+    }
+    if (cmd->type == F413_CTRL_CMD_TURN)
+    {
+        if ((cmd->profile == NULL) || (cmd->profile->n_total == 0U) || (cmd->sign == 0))
+        {
+            return false;
+        }
+    }
+    else if (cmd->distance_mm <= 0.001f)
+    {
+        return false;
+    }
+
+    next = (uint8_t)((s_q_head + 1U) & F413_CTRL_QUEUE_MASK);
+    if (next == s_q_tail)
+    {
+        return false;
+    }
+    s_q[s_q_head] = *cmd;
+    __DMB(); /* s_q は volatile でないので、スロットを書き終えてから制御 tick へ公開する */
+    s_q_head = next;
+    s_q_pushed++;
+    return true;
+}
+
+void f413_ctrl_queue_clear(void)
+{
+    uint32_t primask = __get_PRIMASK();
+
+    __disable_irq();
+    if (s_q_busy && (s_q_run.type == F413_CTRL_CMD_TURN))
+    {
+        f413_ctrl_stop_omega_profile();
+    }
+    f413_ctrl_queue_drop();
+    __set_PRIMASK(primask);
+}
+
+bool f413_ctrl_queue_idle(void)
+{
+    return !s_q_busy && (s_q_tail == s_q_head);
+}
+
+uint32_t f413_ctrl_queue_pushed_count(void) { return s_q_pushed; }
+uint32_t f413_ctrl_queue_done_count(void)   { return s_q_done; }
+
+void f413_ctrl_queue_get_status(f413_ctrl_queue_status_t* st)
+{
+    if (st == NULL)
+    {
+        return;
+    }
+    st->pending = (uint8_t)((s_q_head - s_q_tail) & F413_CTRL_QUEUE_MASK);
+    st->busy = s_q_busy;
+    st->type = s_q_run.type;
+    st->tag = s_q_run.tag;
+    st->started = s_q_started;
+    st->done = s_q_done;
+    st->underrun_ms = s_q_underrun_ms;
+}
+
 void f413_ctrl_set_heading_omega_correction(float omega_deg_s)
 {
     if (omega_deg_s > WALL_CTRL_MAX)
@@ -1165,17 +1477,157 @@ int16_t f413_ctrl_get_log_encoder_delta_l(void) { return s_encoder_delta_l; }
 int16_t f413_ctrl_get_log_encoder_delta_r(void) { return s_encoder_delta_r; }
 bool f413_ctrl_angle_target_enabled(void) { return s_angle_target_enabled; }
 bool  f413_ctrl_is_running(void)        { return s_running; }
-bool  f413_ctrl_spi2_busy(void)         { return s_spi2_busy; }
+bool  f413_ctrl_spi2_imu_scheduled(void) { return s_spi2_sched.imu_scheduled; }
+uint32_t f413_ctrl_imu_burst_errors(void) { return s_spi2_sched.stats.imu_errors; }
+
+uint32_t f413_ctrl_spi2_fram_window_us(void)
+{
+    uint32_t window;
+    uint32_t primask = __get_PRIMASK();
+
+    __disable_irq();
+    window = spi_bus_sched_fram_window_us(&s_spi2_sched, spi2_now_us());
+    __set_PRIMASK(primask);
+    return window;
+}
+
+bool f413_ctrl_spi2_fram_begin(uint32_t cost_us)
+{
+    bool ok;
+    uint32_t primask = __get_PRIMASK();
+
+    __disable_irq();
+    ok = spi_bus_sched_fram_begin(&s_spi2_sched, spi2_now_us(), cost_us);
+    __set_PRIMASK(primask);
+    return ok;
+}
+
+void f413_ctrl_spi2_fram_end(void)
+{
+    uint32_t now_us;
+    uint32_t primask = __get_PRIMASK();
+
+    __disable_irq();
+    /* 周期が終わって tick が未実行なら、その分の 1 周期を足して占有時間を数える */
+    now_us = TIM5->CNT;
+    if ((TIM5->SR & TIM_SR_UIF) != 0U)
+    {
+        now_us += F413_SPI2_PERIOD_US;
+    }
+    spi_bus_sched_fram_end(&s_spi2_sched, now_us);
+    __set_PRIMASK(primask);
+}
+
+void f413_ctrl_spi2_get_stats(spi_bus_sched_stats_t *out)
+{
+    uint32_t primask = __get_PRIMASK();
+
+    __disable_irq();
+    *out = s_spi2_sched.stats;
+    __set_PRIMASK(primask);
+}
+
+void f413_ctrl_spi2_reset_stats(void)
+{
+    uint32_t primask = __get_PRIMASK();
+
+    __disable_irq();
+    spi_bus_sched_reset_stats(&s_spi2_sched);
+    __set_PRIMASK(primask);
+}
+
+void f413_ctrl_set_spi2_idle_hook(f413_ctrl_spi2_idle_hook_t hook)
+{
+    s_spi2_idle_hook = hook;
+}
 
 /* ========================================================== */
 /* 1kHz 割り込みハンドラ                                       */
 /* ========================================================== */
 
+/* 実行中のコマンドが終わったか（この tick の積算の前に判定する） */
+static bool f413_ctrl_queue_cmd_done(void)
+{
+    if (s_q_run.type == F413_CTRL_CMD_TURN)
+    {
+        const turn_profile_t* profile = s_omega_profile;
+
+        /* 表を最後まで再生した tick で終える（次の区間を同じ tick から始める） */
+        return (profile == NULL) || (s_omega_profile_tick >= profile->n_total);
+    }
+    return fabsf(s_real_distance) >= fabsf(s_q_end_mm);
+}
+
+/* コマンドを始める。走行中の main ループの f413_ctrl_set_* と同じ手順を割り込みの中で行う */
+static void f413_ctrl_queue_start(void)
+{
+    const f413_ctrl_cmd_t* c = &s_q_run;
+
+    if ((c->flags & F413_CTRL_CMD_FLAG_RESET_ANGLE) != 0U)
+    {
+        f413_ctrl_reset_angle();
+    }
+    else
+    {
+        f413_ctrl_clear_angle_target();
+    }
+
+    if (c->type == F413_CTRL_CMD_TURN)
+    {
+        s_heading_omega_correction = 0.0f;
+        f413_ctrl_set_velocity(c->v_out);
+        f413_ctrl_start_turn_profile(c->profile, c->sign);
+    }
+    else
+    {
+        s_q_end_mm = s_real_distance + c->distance_mm;
+        f413_ctrl_set_velocity_profile(c->v_in, c->v_out, c->distance_mm);
+        f413_ctrl_set_omega(0.0f);
+    }
+}
+
+/* 走行コマンドキューを 1 tick 進める。前のコマンドが終わった tick に次を始めるので、
+   区間の境目で指令が途切れない（次が無ければ出口速度のまま待ち、その時間を数える） */
+static void f413_ctrl_queue_tick(void)
+{
+    if (s_q_busy)
+    {
+        if (!f413_ctrl_queue_cmd_done())
+        {
+            if (s_q_run.type == F413_CTRL_CMD_TURN)
+            {
+                s_heading_omega_correction = 0.0f; /* 旋回中は壁制御の補正を入れない */
+            }
+            return;
+        }
+        s_q_busy = false;
+        s_q_done++;
+    }
+    if (s_q_tail == s_q_head)
+    {
+        if (s_q_hold)
+        {
+            s_q_underrun_ms++;
+        }
+        return;
+    }
+
+    s_q_run = s_q[s_q_tail];
+    __DMB(); /* スロットを読み終えてから解放する（解放後はメインループが上書きする） */
+    s_q_tail = (uint8_t)((s_q_tail + 1U) & F413_CTRL_QUEUE_MASK);
+    s_q_busy = true;
+    s_q_hold = (s_q_run.v_out != 0.0f);
+    s_q_started++;
+    f413_ctrl_queue_start();
+}
+
 void f413_ctrl_tick(void)
 {
     float real_velocity_raw;
     float omega_raw = s_real_omega;
     float accel_forward_for_comp = s_accel_forward_filtered;
+    ism330_raw_t imu_raw;
+    bool imu_fresh = false;
     float out_l;
     float out_r;
     uint32_t duty_l;
@@ -1185,33 +1637,71 @@ void f413_ctrl_tick(void)
     GPIO_PinState in2_l = GPIO_PIN_RESET;
     GPIO_PinState in2_r = GPIO_PIN_RESET;
     const bool use_fan_on_gains = f413_ctrl_use_fan_on_gains();
-    const float kp_d = use_fan_on_gains ? KP_DISTANCE_FAN_ON : KP_DISTANCE_FAN_OFF;
-    const float ki_d = use_fan_on_gains ? KI_DISTANCE_FAN_ON : KI_DISTANCE_FAN_OFF;
-    const float kd_d = use_fan_on_gains ? KD_DISTANCE_FAN_ON : KD_DISTANCE_FAN_OFF;
-    const float ff_d = use_fan_on_gains ? FF_DISTANCE_FAN_ON : FF_DISTANCE_FAN_OFF;
-    const float kp_v = use_fan_on_gains ? KP_VELOCITY_FAN_ON : KP_VELOCITY_FAN_OFF;
-    const float ki_v = use_fan_on_gains ? KI_VELOCITY_FAN_ON : KI_VELOCITY_FAN_OFF;
-    const float kd_v = use_fan_on_gains ? KD_VELOCITY_FAN_ON : KD_VELOCITY_FAN_OFF;
-    const float ff_ts = use_fan_on_gains ? FF_TRANSLATION_STATIC_PWM_FAN_ON :
-                                            FF_TRANSLATION_STATIC_PWM_FAN_OFF;
-    const float ff_tv = use_fan_on_gains ? FF_TRANSLATION_VELOCITY_PWM_FAN_ON :
-                                            FF_TRANSLATION_VELOCITY_PWM_FAN_OFF;
-    const float ff_ta = use_fan_on_gains ? FF_TRANSLATION_ACCEL_PWM_FAN_ON :
-                                            FF_TRANSLATION_ACCEL_PWM_FAN_OFF;
-    const float kp_a = use_fan_on_gains ? KP_ANGLE_FAN_ON : KP_ANGLE_FAN_OFF;
-    const float ki_a = use_fan_on_gains ? KI_ANGLE_FAN_ON : KI_ANGLE_FAN_OFF;
-    const float kd_a = use_fan_on_gains ? KD_ANGLE_FAN_ON : KD_ANGLE_FAN_OFF;
-    const float ff_a = use_fan_on_gains ? FF_ANGLE_FAN_ON : FF_ANGLE_FAN_OFF;
-    const float kp_o = use_fan_on_gains ? KP_OMEGA_FAN_ON : KP_OMEGA_FAN_OFF;
-    const float ki_o = use_fan_on_gains ? KI_OMEGA_FAN_ON : KI_OMEGA_FAN_OFF;
-    const float kd_o = use_fan_on_gains ? KD_OMEGA_FAN_ON : KD_OMEGA_FAN_OFF;
-    const float ff_o = use_fan_on_gains ? FF_OMEGA_PWM_FAN_ON : FF_OMEGA_PWM_FAN_OFF;
-    const float ff_oa = use_fan_on_gains ? FF_OMEGA_ACCEL_PWM_FAN_ON : FF_OMEGA_ACCEL_PWM_FAN_OFF;
+    const f413_ctrl_gains_t* gains =
+        &g_f413_ctrl_gains[use_fan_on_gains ? F413_CTRL_GAIN_SET_FAN_ON : F413_CTRL_GAIN_SET_FAN_OFF];
+    const float kp_d = gains->kp_d;
+    const float ki_d = gains->ki_d;
+    const float kd_d = gains->kd_d;
+    const float ff_d = gains->ff_d;
+    const float kp_v = gains->kp_v;
+    const float ki_v = gains->ki_v;
+    const float kd_v = gains->kd_v;
+    const float ff_ts = gains->ff_ts;
+    const float ff_tv = gains->ff_tv;
+    const float ff_ta = gains->ff_ta;
+    const float kp_a = gains->kp_a;
+    const float ki_a = gains->ki_a;
+    const float kd_a = gains->kd_a;
+    const float ff_a = gains->ff_a;
+    const float kp_o = gains->kp_o;
+    const float ki_o = gains->ki_o;
+    const float kd_o = gains->kd_o;
+    const float ff_o = gains->ff_o;
+    const float ff_oa = gains->ff_oa;
+    uint32_t prof_t;
 
     if (!s_running)
     {
         return;
     }
+    prof_t = isr_prof_begin();
+
+    /* ---- IMU: 前 tick に起動したバーストの結果を受け取り、次のバーストを起動 ----
+       周期の先頭は IMU のスロット。FRAM の転送は窓に収まるものしか許可されないので通常は取れる。
+       取れなかった tick（FRAM の超過・前回バーストの遅れ）は前回値を維持し、統計に数える */
+    if (s_imu_ok)
+    {
+#if F413_IMU_BURST_USE_DMA
+        imu_fresh = imu_dma_take(&imu_raw);
+        if (spi_bus_sched_imu_begin(&s_spi2_sched))
+        {
+            imu_dma_start();
+        }
+        else
+        {
+            imu_dma_check_stall();
+        }
+#else
+        if (spi_bus_sched_imu_begin(&s_spi2_sched))
+        {
+            bool ok;
+
+            HAL_GPIO_WritePin(FRAM_CS_GPIO_Port, FRAM_CS_Pin, GPIO_PIN_SET);
+            HAL_GPIO_WritePin(IMU_CS_GPIO_Port, IMU_CS_Pin, GPIO_PIN_RESET);
+            ok = (HAL_SPI_TransmitReceive(&hspi2, s_imu_burst_tx, s_imu_burst_rx,
+                                          ISM330_BURST_XFER_LEN, 10U) == HAL_OK);
+            if (ok)
+            {
+                ism330_burst_decode(s_imu_burst_rx, &imu_raw);
+                imu_fresh = true;
+            }
+            HAL_GPIO_WritePin(IMU_CS_GPIO_Port, IMU_CS_Pin, GPIO_PIN_SET);
+            spi_bus_sched_imu_end(&s_spi2_sched, ok);
+            spi2_notify_idle();
+        }
+#endif
+    }
+    prof_t = isr_prof_end(ISR_PROF_IMU, prof_t);
 
     /* ---- エンコーダ読取 ---- */
     int32_t enc_l = (int32_t)__HAL_TIM_GET_COUNTER(&htim3) - (int32_t)F413_CTRL_ENCODER_CENTER;
@@ -1247,13 +1737,12 @@ void f413_ctrl_tick(void)
     s_real_distance = (s_encoder_distance_l + s_encoder_distance_r) * 0.5f;
 
     /* 角速度 [deg/s] — IMU ジャイロから (F405 read_IMU() と同等)
-       SPI2 が FRAM 操作中（HAL busy）ならこの tick の IMU 読取をスキップし前回値を維持 */
-    if (s_imu_ok && hspi2.State == HAL_SPI_STATE_READY)
+       新しいサンプルが無い tick は前回値を維持 */
+    if (imu_fresh)
     {
-        s_spi2_busy = true;
         /* IMU Z軸: CCW(左旋回)=正, CW(右旋回)=負 → 制御系と一致。符号反転不要。
            （2026-05-01: 旋回逆転の原因はPWMチャネル左右逆だった） */
-        omega_raw = imu_read_gyro_z_dps() - s_omega_z_offset;
+        omega_raw = imu_gyro_z_dps(&imu_raw) - s_omega_z_offset;
         s_omega_z_raw = omega_raw;
         if (!s_omega_z_lpf_inited)
         {
@@ -1266,7 +1755,7 @@ void f413_ctrl_tick(void)
         }
         omega_raw = s_omega_z_filtered;
 
-        float accel_raw = imu_read_accel_forward_mm_s2() - s_accel_forward_offset;
+        float accel_raw = imu_accel_forward_mm_s2(&imu_raw) - s_accel_forward_offset;
         accel_forward_for_comp = accel_raw;
         if (!s_accel_forward_lpf_inited)
         {
@@ -1279,7 +1768,6 @@ void f413_ctrl_tick(void)
                                                             accel_raw,
                                                             F413_IMU_ACCEL_FORWARD_LPF_TAU);
         }
-        s_spi2_busy = false;
         s_imu_motion_sample_valid = true;
     }
 
@@ -1301,6 +1789,7 @@ void f413_ctrl_tick(void)
 
     s_real_omega = omega_raw;
     s_real_angle += s_real_omega * F413_CTRL_DT;
+    prof_t = isr_prof_end(ISR_PROF_ENCODER, prof_t);
 
     if (s_tune_active)
     {
@@ -1501,6 +1990,7 @@ void f413_ctrl_tick(void)
     }
     else
     {
+        f413_ctrl_queue_tick();
         f413_ctrl_update_omega_profile();
 
         s_velocity_interrupt += s_acceleration_interrupt * F413_CTRL_DT;
@@ -1604,7 +2094,7 @@ void f413_ctrl_tick(void)
             s_previous_velocity_error = s_velocity_error;
         }
 
-        if (s_omega_profile_active)
+        if (s_omega_profile != NULL)
         {
             s_target_angle += (s_omega_interrupt + s_heading_omega_correction) * F413_CTRL_DT;
             f413_ctrl_update_angle_outer_loop(kp_a, ki_a, kd_a, ff_a);
@@ -1691,4 +2181,5 @@ void f413_ctrl_tick(void)
         HAL_GPIO_WritePin(MOTOR_R_DIR_GPIO_Port, MOTOR_R_DIR_Pin, GPIO_PIN_RESET);
         __HAL_TIM_SET_COMPARE(&htim2, TIM_CHANNEL_3, compare_r);
     }
+    (void)isr_prof_end(ISR_PROF_PID, prof_t);
 }
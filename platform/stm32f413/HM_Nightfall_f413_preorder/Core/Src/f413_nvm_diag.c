@@ -145,11 +145,12 @@ void f413_nvm_diag_run_nvm_status_once(void)
                (int)trace_st);
   if (trace_st == NVM_STATUS_OK)
   {
-    trace_printf("[NVM-STATUS] trace ver=0x%08lX rec_size=%lu cap=%lu write=%lu total=%lu\r\n",
+    trace_printf("[NVM-STATUS] trace ver=0x%08lX rec_size=%lu block=%lux%lu write=%lu total=%lu\r\n",
                  (unsigned long)header.version,
                  (unsigned long)header.record_size,
-                 (unsigned long)header.record_capacity,
-                 (unsigned long)header.write_index,
+                 (unsigned long)header.block_size,
+                 (unsigned long)header.block_count,
+                 (unsigned long)header.write_block,
                  (unsigned long)header.total_records);
   }
 }
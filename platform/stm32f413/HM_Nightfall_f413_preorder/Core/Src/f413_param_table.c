@@ -0,0 +1,387 @@
+#include "f413_param_table.h"
+
+#include <string.h>
+
+#include "f413_control.h"
+#include "f413_wall_sensor.h"
+#include "nvm_param_store.h"
+#include "params.h"
+#include "shortest_run_params.h"
+#include "solver.h"
+#include "trace.h"
+
+#define F413_PARAM_CLI_LINE_MAX (80U)
+#define F413_PARAM_CASE_COUNT (9U) // shortestRunCaseParamsModeN[] の要素数（case1..9、f413_path_run.c と同じ）
+
+/* id の割り当て（保存ブロブのキー。一度使った id は別の値に使い回さない）
+ *   0x01xx: 制御ゲイン [0]=ファン停止時 [1]=ファン動作時
+ *   0x02xx: 壁しきい値
+ *   0x03xx: ゴール座標 [0..8]=GOAL1..9
+ *   0x1m00 + k: 最短走行 mode m のケース値 [0..8]=case1..9
+ *   0x1m40 + k: 最短走行 mode m のモード値 */
+#define F413_PARAM_GAIN(k, field)                                                                 \
+  {(uint16_t)(0x0100U + (k)), NVM_PARAM_F32, F413_CTRL_GAIN_SET_COUNT, sizeof(f413_ctrl_gains_t), \
+   "pid." #field, 0.0f, 1000.0f, &g_f413_ctrl_gains[0].field}
+#define F413_PARAM_WALL(k, field)                                         \
+  {(uint16_t)(0x0200U + (k)), NVM_PARAM_U16, 1U, 0U, "wall.thr_" #field, \
+   0.0f, 4095.0f, &g_f413_wall_threshold.field}
+#define F413_PARAM_GOAL(k, axis, col)                                                        \
+  {(uint16_t)(0x0300U + (k)), NVM_PARAM_U8, SOLVER_GOAL_SLOTS, sizeof(solver_goals[0]), \
+   "goal." #axis, 0.0f, (float)(MAZE_SIZE - 1), &solver_goals[0][col]}
+#define F413_PARAM_CASE(m, k, type, field, lo, hi)                                                      \
+  {(uint16_t)(0x1000U + ((m) << 8) + (k)), (type), F413_PARAM_CASE_COUNT, sizeof(ShortestRunCaseParams_t), \
+   "sr" #m "." #field, (lo), (hi), &shortestRunCaseParamsMode##m[0].field}
+#define F413_PARAM_MODE(m, k, type, field, lo, hi)                        \
+  {(uint16_t)(0x1040U + ((m) << 8) + (k)), (type), 1U, 0U, "sr" #m "." #field, \
+   (lo), (hi), &shortestRunModeParams##m.field}
+
+#define F413_PARAM_SHORTEST(m)                                                                   \
+  F413_PARAM_CASE(m, 0x00U, NVM_PARAM_F32, acceleration_straight, 0.0f, 100000.0f),              \
+  F413_PARAM_CASE(m, 0x01U, NVM_PARAM_F32, acceleration_straight_dash, 0.0f, 100000.0f),         \
+  F413_PARAM_CASE(m, 0x02U, NVM_PARAM_F32, velocity_straight, 0.0f, 10000.0f),                   \
+  F413_PARAM_CASE(m, 0x03U, NVM_PARAM_F32, jerk_straight, 0.0f, 10000000.0f),                    \
+  F413_PARAM_CASE(m, 0x04U, NVM_PARAM_F32, acceleration_d_straight, 0.0f, 100000.0f),            \
+  F413_PARAM_CASE(m, 0x05U, NVM_PARAM_F32, acceleration_d_straight_dash, 0.0f, 100000.0f),       \
+  F413_PARAM_CASE(m, 0x06U, NVM_PARAM_F32, velocity_d_straight, 0.0f, 10000.0f),                 \
+  F413_PARAM_CASE(m, 0x07U, NVM_PARAM_F32, kp_wall, 0.0f, 10.0f),                                \
+  F413_PARAM_CASE(m, 0x08U, NVM_PARAM_F32, kp_diagonal, 0.0f, 10.0f),                            \
+  F413_PARAM_CASE(m, 0x09U, NVM_PARAM_U8, solver_profile, 0.0f, 2.0f),                           \
+  F413_PARAM_MODE(m, 0x00U, NVM_PARAM_F32, velocity_turn90, 0.0f, 5000.0f),                      \
+  F413_PARAM_MODE(m, 0x01U, NVM_PARAM_F32, alpha_turn90, 0.0f, 200000.0f),                       \
+  F413_PARAM_MODE(m, 0x02U, NVM_PARAM_F32, dist_offset_in, -90.0f, 90.0f),                       \
+  F413_PARAM_MODE(m, 0x03U, NVM_PARAM_F32, dist_offset_out, -90.0f, 180.0f),                     \
+  F413_PARAM_MODE(m, 0x04U, NVM_PARAM_F32, dist_wall_end, 0.0f, 90.0f),                          \
+  F413_PARAM_MODE(m, 0x05U, NVM_PARAM_F32, velocity_l_turn_90, 0.0f, 5000.0f),                   \
+  F413_PARAM_MODE(m, 0x06U, NVM_PARAM_F32, velocity_l_turn_180, 0.0f, 5000.0f),                  \
+  F413_PARAM_MODE(m, 0x07U, NVM_PARAM_U16, fan_power, 0.0f, 1000.0f),                            \
+  F413_PARAM_MODE(m, 0x08U, NVM_PARAM_F32, accel_switch_velocity, 0.0f, 10000.0f)
+
+static const nvm_param_desc_t k_f413_param_table[] = {
+  F413_PARAM_GAIN(0x00U, kp_d),
+  F413_PARAM_GAIN(0x01U, ki_d),
+  F413_PARAM_GAIN(0x02U, kd_d),
+  F413_PARAM_GAIN(0x03U, ff_d),
+  F413_PARAM_GAIN(0x04U, kp_v),
+  F413_PARAM_GAIN(0x05U, ki_v),
+  F413_PARAM_GAIN(0x06U, kd_v),
+  F413_PARAM_GAIN(0x07U, ff_ts),
+  F413_PARAM_GAIN(0x08U, ff_tv),
+  F413_PARAM_GAIN(0x09U, ff_ta),
+  F413_PARAM_GAIN(0x0AU, kp_a),
+  F413_PARAM_GAIN(0x0BU, ki_a),
+  F413_PARAM_GAIN(0x0CU, kd_a),
+  F413_PARAM_GAIN(0x0DU, ff_a),
+  F413_PARAM_GAIN(0x0EU, kp_o),
+  F413_PARAM_GAIN(0x0FU, ki_o),
+  F413_PARAM_GAIN(0x10U, kd_o),
+  F413_PARAM_GAIN(0x11U, ff_o),
+  F413_PARAM_GAIN(0x12U, ff_oa),
+  F413_PARAM_WALL(0x00U, fr),
+  F413_PARAM_WALL(0x01U, fl),
+  F413_PARAM_WALL(0x02U, r),
+  F413_PARAM_WALL(0x03U, l),
+  F413_PARAM_GOAL(0x00U, x, 0),
+  F413_PARAM_GOAL(0x01U, y, 1),
+  F413_PARAM_SHORTEST(2),
+  F413_PARAM_SHORTEST(3),
+  F413_PARAM_SHORTEST(4),
+  F413_PARAM_SHORTEST(5),
+  F413_PARAM_SHORTEST(6),
+  F413_PARAM_SHORTEST(7),
+};
+
+static nvm_param_store_t g_param_store;
+static nvm_status_t g_param_store_status = NVM_STATUS_UNSUPPORTED; // nvm_param_store_init() の結果
+static bool g_param_cli_active = false;
+static char g_param_cli_line[F413_PARAM_CLI_LINE_MAX];
+static uint32_t g_param_cli_len = 0U;
+
+void f413_param_table_init(void)
+{
+  nvm_param_load_result_t res;
+  nvm_status_t st;
+
+  g_param_store_status = nvm_param_store_init(&g_param_store,
+                                              NVM_AREA_TUNE_PARAMS,
+                                              k_f413_param_table,
+                                              (uint32_t)(sizeof(k_f413_param_table) / sizeof(k_f413_param_table[0])));
+  if (g_param_store_status != NVM_STATUS_OK)
+  {
+    trace_printf("[PARAM] FAIL(table) status=%d\r\n", (int)g_param_store_status);
+    return;
+  }
+
+  st = nvm_param_store_load(&g_param_store, &res);
+  if (st == NVM_STATUS_OK)
+  {
+    trace_printf("[PARAM] loaded slot=%lu seq=%lu applied=%lu skipped=%lu (params=%lu values=%lu)\r\n",
+                 (unsigned long)res.slot,
+                 (unsigned long)res.seq,
+                 (unsigned long)res.applied,
+                 (unsigned long)res.skipped,
+                 (unsigned long)g_param_store.count,
+                 (unsigned long)g_param_store.values);
+  }
+  else
+  {
+    trace_printf("[PARAM] defaults status=%d (params=%lu values=%lu)\r\n",
+                 (int)st,
+                 (unsigned long)g_param_store.count,
+                 (unsigned long)g_param_store.values);
+  }
+}
+
+static void f413_param_print_value(const nvm_param_desc_t* d, uint32_t index, bool detail)
+{
+  char text[NVM_PARAM_STORE_NAME_MAX + 24U];
+
+  (void)nvm_param_store_format(d, index, text, sizeof(text));
+  if (detail)
+  {
+    trace_printf("[PARAM] %s default=%.7g range=%.7g..%.7g%s\r\n",
+                 text,
+                 (double)nvm_param_store_default(&g_param_store, d, index),
+                 (double)d->min,
+                 (double)d->max,
+                 nvm_param_store_is_default(&g_param_store, d, index) ? "" : " *");
+  }
+  else
+  {
+    trace_printf("[PARAM] %s%s\r\n", text, nvm_param_store_is_default(&g_param_store, d, index) ? "" : " *");
+  }
+}
+
+// prefix で始まる名前の値を出す（changed_only なら既定値から変えたものだけ）
+static void f413_param_print_list(const char* prefix, bool changed_only)
+{
+  const size_t prefix_len = strlen(prefix);
+  const bool prev_lossless = trace_set_lossless(true);
+  uint32_t shown = 0U;
+  uint32_t i;
+  uint32_t k;
+
+  for (i = 0U; i < g_param_store.count; i++)
+  {
+    const nvm_param_desc_t* d = &g_param_store.table[i];
+
+    if (strncmp(d->name, prefix, prefix_len) != 0)
+    {
+      continue;
+    }
+    for (k = 0U; k < d->count; k++)
+    {
+      if (changed_only && nvm_param_store_is_default(&g_param_store, d, k))
+      {
+        continue;
+      }
+      f413_param_print_value(d, k, changed_only);
+      shown++;
+    }
+  }
+  trace_printf("[PARAM] %lu values (changed=%lu, * = changed)\r\n",
+               (unsigned long)shown,
+               (unsigned long)nvm_param_store_changed_count(&g_param_store));
+  (void)trace_flush(NIGHTFALL_TRACE_FLUSH_TIMEOUT_MS);
+  (void)trace_set_lossless(prev_lossless);
+}
+
+static void f413_param_cli_help(void)
+{
+  trace_printf("[PARAM] list [prefix] | diff | get <name> | set <name> <value> | <name>=<value> | save | load | reset | q\r\n");
+  trace_printf("[PARAM] names: pid.kp_v[0=fan off,1=fan on], wall.thr_fr, goal.x[0..8], sr<mode>.velocity_straight[case-1], sr<mode>.velocity_turn90 ...\r\n");
+}
+
+static void f413_param_cli_set(const char* name, const char* value)
+{
+  const nvm_param_desc_t* d;
+  uint32_t index = 0U;
+  nvm_status_t st;
+
+  st = nvm_param_store_set_text(&g_param_store, name, value);
+  if (st == NVM_STATUS_NOT_FOUND)
+  {
+    trace_printf("[PARAM] unknown name '%s'\r\n", name);
+    return;
+  }
+  d = nvm_param_store_find(&g_param_store, name, &index);
+  if (st != NVM_STATUS_OK)
+  {
+    trace_printf("[PARAM] rejected '%s' (range %.7g..%.7g%s)\r\n",
+                 value,
+                 (double)d->min,
+                 (double)d->max,
+                 (d->type == NVM_PARAM_F32) ? "" : ", integer");
+    return;
+  }
+  f413_param_print_value(d, index, false);
+}
+
+static void f413_param_cli_execute(char* line)
+{
+  char* cmd = line;
+  char* arg;
+  char* eq;
+  nvm_status_t st;
+
+  while (*cmd == ' ')
+  {
+    cmd++;
+  }
+  arg = strchr(cmd, ' ');
+  if (arg != NULL)
+  {
+    *arg++ = '\0';
+    while (*arg == ' ')
+    {
+      arg++;
+    }
+  }
+  else
+  {
+    arg = cmd + strlen(cmd);
+  }
+
+  if ((strcmp(cmd, "q") == 0) || (cmd[0] == '\0'))
+  {
+    g_param_cli_active = false;
+    trace_printf("[PARAM] exit (changed=%lu)\r\n", (unsigned long)nvm_param_store_changed_count(&g_param_store));
+    return;
+  }
+  if (g_param_store_status != NVM_STATUS_OK)
+  {
+    trace_printf("[PARAM] unavailable status=%d\r\n", (int)g_param_store_status);
+    return;
+  }
+
+  if (strcmp(cmd, "list") == 0)
+  {
+    f413_param_print_list(arg, false);
+  }
+  else if (strcmp(cmd, "diff") == 0)
+  {
+    f413_param_print_list(arg, true);
+  }
+  else if (strcmp(cmd, "get") == 0)
+  {
+    uint32_t index = 0U;
+    const nvm_param_desc_t* d = nvm_param_store_find(&g_param_store, arg, &index);
+
+    if (d == NULL)
+    {
+      trace_printf("[PARAM] unknown name '%s'\r\n", arg);
+    }
+    else
+    {
+      f413_param_print_value(d, index, true);
+    }
+  }
+  else if (strcmp(cmd, "set") == 0)
+  {
+    char* value = strchr(arg, ' ');
+
+    if (value == NULL)
+    {
+      trace_printf("[PARAM] usage: set <name> <value>\r\n");
+      return;
+    }
+    *value++ = '\0';
+    f413_param_cli_set(arg, value);
+  }
+  else if (strcmp(cmd, "save") == 0)
+  {
+    st = nvm_param_store_save(&g_param_store);
+    trace_printf("[PARAM] save %s status=%d slot=%lu seq=%lu changed=%lu\r\n",
+                 (st == NVM_STATUS_OK) ? "OK" : "FAIL",
+                 (int)st,
+                 (unsigned long)g_param_store.slot,
+                 (unsigned long)g_param_store.seq,
+                 (unsigned long)nvm_param_store_changed_count(&g_param_store));
+  }
+  else if (strcmp(cmd, "load") == 0)
+  {
+    nvm_param_load_result_t res;
+
+    st = nvm_param_store_load(&g_param_store, &res);
+    if (st == NVM_STATUS_OK)
+    {
+      trace_printf("[PARAM] load OK slot=%lu seq=%lu applied=%lu skipped=%lu\r\n",
+                   (unsigned long)res.slot,
+                   (unsigned long)res.seq,
+                   (unsigned long)res.applied,
+                   (unsigned long)res.skipped);
+    }
+    else
+    {
+      trace_printf("[PARAM] load FAIL status=%d (values unchanged)\r\n", (int)st);
+    }
+  }
+  else if (strcmp(cmd, "reset") == 0)
+  {
+    nvm_param_store_reset_defaults(&g_param_store);
+    trace_printf("[PARAM] reset to compiled defaults (save to persist)\r\n");
+  }
+  else if ((eq = strchr(cmd, '=')) != NULL)
+  {
+    *eq = '\0';
+    f413_param_cli_set(cmd, eq + 1);
+  }
+  else
+  {
+    f413_param_cli_help();
+  }
+}
+
+void f413_param_table_cli_begin(void)
+{
+  g_param_cli_active = true;
+  g_param_cli_len = 0U;
+  f413_param_cli_help();
+  trace_printf("[PARAM] > ");
+}
+
+bool f413_param_table_cli_active(void)
+{
+  return g_param_cli_active;
+}
+
+void f413_param_table_cli_feed(uint8_t c)
+{
+  if ((c == '\r') || (c == '\n'))
+  {
+    if ((c == '\n') && (g_param_cli_len == 0U))
+    {
+      return; // CR LF の LF
+    }
+    trace_printf("\r\n");
+    g_param_cli_line[g_param_cli_len] = '\0';
+    g_param_cli_len = 0U;
+    f413_param_cli_execute(g_param_cli_line);
+    if (g_param_cli_active)
+    {
+      trace_printf("[PARAM] > ");
+    }
+    return;
+  }
+  if (c == 0x1BU)
+  {
+    g_param_cli_active = false;
+    g_param_cli_len = 0U;
+    trace_printf("\r\n[PARAM] exit\r\n");
+    return;
+  }
+  if ((c == 0x08U) || (c == 0x7FU))
+  {
+    if (g_param_cli_len > 0U)
+    {
+      g_param_cli_len--;
+      trace_write("\b \b", 3U);
+    }
+    return;
+  }
+  if ((c < 0x20U) || (g_param_cli_len + 1U >= F413_PARAM_CLI_LINE_MAX))
+  {
+    return;
+  }
+  g_param_cli_line[g_param_cli_len++] = (char)c;
+  trace_write((const char*)&c, 1U);
+}
@@ -14,28 +14,22 @@
 #include "f413_wall_runtime.h"
 #include "main.h"
 #include "params.h"
+#include "path_speed_plan.h"
 #include "shortest_run_params.h"
 #include "trace.h"
 
-typedef struct {
-  float signed_angle_deg;
-  float alpha_deg_s2;
-  float velocity_mm_s;
-  float dist_in_mm;
-  float dist_out_mm;
-  bool front_wall_entry;
-  bool wall_control_offsets;
-} f413_path_run_turn_t;
-
-typedef struct {
-  float omega_peak_deg_s;
-  float t_acc_s;
-  float t_cruise_s;
-  float t_total_s;
-} f413_path_run_smooth_turn_t;
+typedef path_speed_turn_t f413_path_run_turn_t;
+
+#define F413_PATH_RUN_TURN_PROFILE_SLOTS (8U) /* 90/大回り90/180/45入/45出/V90/135入/135出 */
 
 extern uint16_t path[];
 
+/* 旋回表（走行開始時にモードのパラメータから作成し、制御割り込みで再生する） */
+static turn_profile_t s_turn_profile_slots[F413_PATH_RUN_TURN_PROFILE_SLOTS];
+static turn_profile_cache_t s_turn_profile_cache;
+/* 経路全体の速度計画（走行開始時に path[] から作成） */
+static path_speed_plan_t s_speed_plan;
+
 static const ShortestRunModeParams_t* f413_path_run_mode_params(uint8_t mode)
 {
   switch (mode)
@@ -136,219 +130,55 @@ static bool f413_path_run_turn_from_code(uint16_t code,
                                          const ShortestRunModeParams_t* params,
                                          f413_path_run_turn_t* turn)
 {
-  float angle = 0.0f;
-  float accum_angle = 0.0f;
-  float alpha = 0.0f;
-  float velocity = 0.0f;
-  bool right = false;
-
-  if ((params == NULL) || (turn == NULL))
+  if (!path_speed_turn_from_code(code, params, turn))
   {
     return false;
   }
-  turn->front_wall_entry = false;
-  turn->wall_control_offsets = false;
-
-  switch (code)
-  {
-    case 300U:
-      angle = params->angle_turn_90; alpha = params->alpha_turn90;
-      accum_angle = 90.0f;
-      velocity = params->velocity_turn90;
-      turn->dist_in_mm = params->dist_offset_in;
-      turn->dist_out_mm = params->dist_offset_out;
-      turn->front_wall_entry = true;
-      turn->wall_control_offsets = true;
-      right = true; break;
-    case 400U:
-      angle = params->angle_turn_90; alpha = params->alpha_turn90;
-      accum_angle = 90.0f;
-      velocity = params->velocity_turn90;
-      turn->dist_in_mm = params->dist_offset_in;
-      turn->dist_out_mm = params->dist_offset_out;
-      turn->front_wall_entry = true;
-      turn->wall_control_offsets = true;
-      right = false; break;
-    case 501U:
-      angle = params->angle_l_turn_90; alpha = params->alpha_l_turn_90;
-      accum_angle = 90.0f;
-      velocity = params->velocity_l_turn_90;
-      turn->dist_in_mm = params->dist_l_turn_in_90;
-      turn->dist_out_mm = params->dist_l_turn_out_90;
-      turn->front_wall_entry = false;
-      turn->wall_control_offsets = true;
-      right = true; break;
-    case 601U:
-      angle = params->angle_l_turn_90; alpha = params->alpha_l_turn_90;
-      accum_angle = 90.0f;
-      velocity = params->velocity_l_turn_90;
-      turn->dist_in_mm = params->dist_l_turn_in_90;
-      turn->dist_out_mm = params->dist_l_turn_out_90;
-      turn->front_wall_entry = false;
-      turn->wall_control_offsets = true;
-      right = false; break;
-    case 502U:
-      angle = params->angle_l_turn_180; alpha = params->alpha_l_turn_180;
-      accum_angle = 180.0f;
-      velocity = params->velocity_l_turn_180;
-      turn->dist_in_mm = params->dist_l_turn_in_180;
-      turn->dist_out_mm = params->dist_l_turn_out_180;
-      turn->front_wall_entry = false;
-      turn->wall_control_offsets = true;
-      right = true; break;
-    case 602U:
-      angle = params->angle_l_turn_180; alpha = params->alpha_l_turn_180;
-      accum_angle = 180.0f;
-      velocity = params->velocity_l_turn_180;
-      turn->dist_in_mm = params->dist_l_turn_in_180;
-      turn->dist_out_mm = params->dist_l_turn_out_180;
-      turn->front_wall_entry = false;
-      turn->wall_control_offsets = true;
-      right = false; break;
-    case 701U:
-      angle = params->angle_turn45in; alpha = params->alpha_turn45in;
-      accum_angle = 45.0f;
-      velocity = params->velocity_turn45in;
-      turn->dist_in_mm = params->dist_turn45in_in;
-      turn->dist_out_mm = params->dist_turn45in_out;
-      turn->front_wall_entry = false;
-      right = true; break;
-    case 702U:
-      angle = params->angle_turn45in; alpha = params->alpha_turn45in;
-      accum_angle = 45.0f;
-      velocity = params->velocity_turn45in;
-      turn->dist_in_mm = params->dist_turn45in_in;
-      turn->dist_out_mm = params->dist_turn45in_out;
-      turn->front_wall_entry = false;
-      right = false; break;
-    case 703U:
-      angle = params->angle_turn45out; alpha = params->alpha_turn45out;
-      accum_angle = 45.0f;
-      velocity = params->velocity_turn45out;
-      turn->dist_in_mm = params->dist_turn45out_in;
-      turn->dist_out_mm = params->dist_turn45out_out;
-      turn->front_wall_entry = false;
-      right = true; break;
-    case 704U:
-      angle = params->angle_turn45out; alpha = params->alpha_turn45out;
-      accum_angle = 45.0f;
-      velocity = params->velocity_turn45out;
-      turn->dist_in_mm = params->dist_turn45out_in;
-      turn->dist_out_mm = params->dist_turn45out_out;
-      turn->front_wall_entry = false;
-      right = false; break;
-    case 801U:
-      angle = params->angle_turnV90; alpha = params->alpha_turnV90;
-      accum_angle = 90.0f;
-      velocity = params->velocity_turnV90;
-      turn->dist_in_mm = params->dist_turnV90_in;
-      turn->dist_out_mm = params->dist_turnV90_out;
-      turn->front_wall_entry = false;
-      right = true; break;
-    case 802U:
-      angle = params->angle_turnV90; alpha = params->alpha_turnV90;
-      accum_angle = 90.0f;
-      velocity = params->velocity_turnV90;
-      turn->dist_in_mm = params->dist_turnV90_in;
-      turn->dist_out_mm = params->dist_turnV90_out;
-      turn->front_wall_entry = false;
-      right = false; break;
-    case 901U:
-      angle = params->angle_turn135in; alpha = params->alpha_turn135in;
-      accum_angle = 135.0f;
-      velocity = params->velocity_turn135in;
-      turn->dist_in_mm = params->dist_turn135in_in;
-      turn->dist_out_mm = params->dist_turn135in_out;
-      turn->front_wall_entry = false;
-      right = true; break;
-    case 902U:
-      angle = params->angle_turn135in; alpha = params->alpha_turn135in;
-      accum_angle = 135.0f;
-      velocity = params->velocity_turn135in;
-      turn->dist_in_mm = params->dist_turn135in_in;
-      turn->dist_out_mm = params->dist_turn135in_out;
-      turn->front_wall_entry = false;
-      right = false; break;
-    case 903U:
-      angle = params->angle_turn135out; alpha = params->alpha_turn135out;
-      accum_angle = 135.0f;
-      velocity = params->velocity_turn135out;
-      turn->dist_in_mm = params->dist_turn135out_in;
-      turn->dist_out_mm = params->dist_turn135out_out;
-      turn->front_wall_entry = false;
-      right = true; break;
-    case 904U:
-      angle = params->angle_turn135out; alpha = params->alpha_turn135out;
-      accum_angle = 135.0f;
-      velocity = params->velocity_turn135out;
-      turn->dist_in_mm = params->dist_turn135out_in;
-      turn->dist_out_mm = params->dist_turn135out_out;
-      turn->front_wall_entry = false;
-      right = false; break;
-    default: return false;
-  }
-
-  if (angle <= 0.0f)
-  {
-    angle = 90.0f;
-  }
-  if (f413_run_features_angle_accum_mode() && (accum_angle > 0.0f))
-  {
-    angle = accum_angle;
-  }
-  if (alpha <= 0.0f)
+  if (f413_run_features_angle_accum_mode())
   {
-    alpha = 10000.0f;
+    turn->signed_angle_deg = (turn->signed_angle_deg < 0.0f) ? -turn->accum_angle_deg
+                                                             : turn->accum_angle_deg;
   }
-
-  turn->signed_angle_deg = right ? -fabsf(angle) : fabsf(angle);
-  turn->alpha_deg_s2 = alpha;
-  turn->velocity_mm_s = f413_path_run_cap_positive(velocity, NIGHTFALL_F413_PATH_VELOCITY_CAP);
+  turn->velocity_mm_s = f413_path_run_cap_positive(turn->velocity_mm_s,
+                                                   NIGHTFALL_F413_PATH_VELOCITY_CAP);
   return true;
 }
 
-static f413_path_run_smooth_turn_t f413_path_run_build_smooth_turn(float angle_deg,
-                                                                   float alpha_deg_s2,
-                                                                   float omega_cap_deg_s)
+static const turn_profile_t* f413_path_run_turn_profile(const f413_path_run_turn_t* turn)
 {
-  f413_path_run_smooth_turn_t profile = {0.0f, 0.0f, 0.0f, 0.0f};
-  const float angle_abs = fabsf(angle_deg);
-  float rounding_scale = TURN_OMEGA_PROFILE_ROUNDING_SCALE;
-
-  if ((angle_abs <= 0.0f) || (alpha_deg_s2 <= 0.0f))
-  {
-    return profile;
-  }
+  const turn_profile_t* profile = turn_profile_cache_get(&s_turn_profile_cache,
+                                                         turn->signed_angle_deg,
+                                                         turn->alpha_deg_s2,
+                                                         TURN_OMEGA_PROFILE_ROUNDING_SCALE,
+                                                         NIGHTFALL_F413_PATH_OMEGA_CAP);
 
-  profile.omega_peak_deg_s = sqrtf((2.0f * alpha_deg_s2 * angle_abs) / 3.0f);
-  profile.omega_peak_deg_s = f413_path_run_cap_positive(profile.omega_peak_deg_s, omega_cap_deg_s);
-  if (profile.omega_peak_deg_s <= 0.0f)
+  if ((profile == NULL) || (profile->n_total == 0U))
   {
-    return profile;
+    return NULL;
   }
+  return profile;
+}
 
-  if (rounding_scale < 0.1f)
-  {
-    rounding_scale = 0.1f;
-  }
+/* モードのターン種別ごとに旋回表を作っておく（左右は同じ表を符号違いで使う） */
+static void f413_path_run_compile_turn_profiles(const ShortestRunModeParams_t* params)
+{
+  static const uint16_t codes[] = {300U, 501U, 502U, 701U, 703U, 801U, 901U, 903U};
+  f413_path_run_turn_t turn;
+  uint32_t i;
 
-  profile.t_acc_s = (profile.omega_peak_deg_s / alpha_deg_s2) * rounding_scale;
-  profile.t_cruise_s = (angle_abs / profile.omega_peak_deg_s) - profile.t_acc_s;
-  if (profile.t_cruise_s < 0.0f)
+  turn_profile_cache_init(&s_turn_profile_cache,
+                          s_turn_profile_slots,
+                          (uint8_t)F413_PATH_RUN_TURN_PROFILE_SLOTS);
+  for (i = 0U; i < (sizeof(codes) / sizeof(codes[0])); i++)
   {
-    profile.t_cruise_s = 0.0f;
-    profile.omega_peak_deg_s = angle_abs / profile.t_acc_s;
-    profile.omega_peak_deg_s = f413_path_run_cap_positive(profile.omega_peak_deg_s, omega_cap_deg_s);
-    profile.t_cruise_s = (angle_abs / profile.omega_peak_deg_s) - profile.t_acc_s;
-    if (profile.t_cruise_s < 0.0f)
+    if (f413_path_run_turn_from_code(codes[i], params, &turn))
     {
-      profile.t_cruise_s = 0.0f;
+      (void)f413_path_run_turn_profile(&turn);
     }
   }
-  profile.t_total_s = (2.0f * profile.t_acc_s) + profile.t_cruise_s;
-  return profile;
 }
 
+
 static void f413_path_run_trace_on_run_start(void)
 {
   trace_printf("[TRACE-LOG] run-hook: start\r\n");
@@ -636,10 +466,11 @@ static f413_run_session_abort_reason_t f413_path_run_wait_smooth_turn_profile(
     uint16_t trace_flags)
 {
   f413_run_session_abort_reason_t reason = F413_RUN_SESSION_ABORT_NONE;
-  f413_path_run_smooth_turn_t profile;
+  const turn_profile_t* profile;
   uint16_t straight_trace_flags;
   uint16_t turn_trace_flags;
   uint32_t start_ms;
+  uint32_t limit_ms;
   int8_t turn_sign;
 
   if (turn == NULL)
@@ -647,10 +478,8 @@ static f413_run_session_abort_reason_t f413_path_run_wait_smooth_turn_profile(
     return F413_RUN_SESSION_ABORT_IMU_FAULT;
   }
 
-  profile = f413_path_run_build_smooth_turn(turn->signed_angle_deg,
-                                            turn->alpha_deg_s2,
-                                            NIGHTFALL_F413_PATH_OMEGA_CAP);
-  if (profile.t_total_s <= 0.0f)
+  profile = f413_path_run_turn_profile(turn);
+  if (profile == NULL)
   {
     return F413_RUN_SESSION_ABORT_IMU_FAULT;
   }
@@ -659,9 +488,9 @@ static f413_run_session_abort_reason_t f413_path_run_wait_smooth_turn_profile(
   trace_printf("[OP-UI][PATH-TEST] turn profile angle=%.1f alpha=%.0f omega=%.0f v=%.0f t=%.0fms\r\n",
                (double)turn->signed_angle_deg,
                (double)turn->alpha_deg_s2,
-               (double)profile.omega_peak_deg_s,
+               (double)profile->omega_peak_deg_s,
                (double)turn->velocity_mm_s,
-               (double)(profile.t_total_s * 1000.0f));
+               (double)(profile->t_total_s * 1000.0f));
 
   straight_trace_flags = f413_path_run_motor_phase_flags(
       trace_flags,
@@ -701,16 +530,13 @@ static f413_run_session_abort_reason_t f413_path_run_wait_smooth_turn_profile(
 
   f413_path_run_prepare_turn_angle_control();
   f413_ctrl_set_velocity(turn->velocity_mm_s);
-  f413_ctrl_start_omega_profile((float)turn_sign * profile.omega_peak_deg_s,
-                                profile.t_acc_s,
-                                profile.t_cruise_s);
+  f413_ctrl_start_turn_profile(profile, turn_sign);
   start_ms = HAL_GetTick();
+  limit_ms = (uint32_t)profile->n_total + NIGHTFALL_F413_TURN_PROFILE_MARGIN_MS;
 
-  while (1)
+  while (f413_ctrl_turn_profile_active())
   {
-    const float t_s = (float)(HAL_GetTick() - start_ms) * 0.001f;
-
-    if (t_s >= profile.t_total_s)
+    if ((HAL_GetTick() - start_ms) > limit_ms)
     {
       break;
     }
@@ -741,61 +567,63 @@ static f413_run_session_abort_reason_t f413_path_run_wait_smooth_turn_profile(
                                              straight_trace_flags);
 }
 
-static float f413_path_run_goal_entry_speed(const ShortestRunCaseParams_t* case_params)
+/* 速度計画の区間 seg_index を区間先頭から from_mm..to_mm の範囲だけ走る。
+ * 折れ点の間は等加速度なので、折れ点ごとに到達速度を指令する。 */
+static f413_run_session_abort_reason_t f413_path_run_drive_planned(uint16_t seg_index,
+                                                                   float from_mm,
+                                                                   float to_mm,
+                                                                   bool diagonal,
+                                                                   float* speed_now_mm_s,
+                                                                   f413_run_session_guard_t* guard,
+                                                                   uint16_t trace_flags)
 {
-  float speed;
+  float knot_s[PATH_SPEED_PLAN_KNOT_MAX];
+  float knot_v[PATH_SPEED_PLAN_KNOT_MAX];
+  const uint8_t knots = path_speed_plan_knots(&s_speed_plan, seg_index, knot_s, knot_v);
+  f413_run_session_abort_reason_t reason;
+  uint8_t k;
 
-  if (case_params == NULL)
-  {
-    return 0.0f;
-  }
-  speed = sqrtf(fmaxf(0.0f, 2.0f * case_params->acceleration_straight * (float)DIST_HALF_SEC));
-  if (speed > case_params->velocity_straight)
+  for (k = 1U; k < knots; k++)
   {
-    speed = case_params->velocity_straight;
-  }
-  return speed;
-}
+    const float s0 = fmaxf(knot_s[k - 1U], from_mm);
+    const float s1 = fminf(knot_s[k], to_mm);
+    float v1;
 
-static float f413_path_run_next_straight_exit_velocity(uint16_t next_code,
-                                                       const ShortestRunModeParams_t* mode_params,
-                                                       const ShortestRunCaseParams_t* case_params)
-{
-  f413_path_run_turn_t next_turn;
-
-  if (f413_path_run_turn_from_code(next_code, mode_params, &next_turn))
-  {
-    return next_turn.velocity_mm_s;
-  }
-  if (next_code == 0U)
-  {
-    return f413_path_run_goal_entry_speed(case_params);
+    if (s1 <= s0)
+    {
+      continue;
+    }
+    v1 = path_speed_knots_velocity_at(knot_s, knot_v, knots, s1);
+    if (diagonal)
+    {
+      reason = f413_path_run_drive_diagonal_segment(s1 - s0, v1, speed_now_mm_s,
+                                                    guard, trace_flags);
+    }
+    else
+    {
+      reason = f413_path_run_drive_segment(s1 - s0, v1, speed_now_mm_s, guard, trace_flags);
+    }
+    if (reason != F413_RUN_SESSION_ABORT_NONE)
+    {
+      return reason;
+    }
   }
-  return 0.0f;
+  return F413_RUN_SESSION_ABORT_NONE;
 }
 
 static f413_run_session_abort_reason_t f413_path_run_run_straight_code(
-    uint16_t code,
+    uint16_t seg_index,
     uint16_t prev_code,
     uint16_t next_code,
     const ShortestRunModeParams_t* mode_params,
-    const ShortestRunCaseParams_t* case_params,
     float* speed_now_mm_s,
     f413_run_session_guard_t* guard,
     uint16_t trace_flags)
 {
-  const float straight_mm = (float)(code - 200U) * (float)DIST_HALF_SEC;
-  const float v_next =
-      f413_path_run_next_straight_exit_velocity(next_code, mode_params, case_params);
-  const float v_start = 0.0f;
-  const float v_switch = (mode_params != NULL) ? mode_params->accel_switch_velocity : 0.0f;
-  const float v_max = (case_params != NULL) ? case_params->velocity_straight : 0.0f;
-  const float accel_low = (case_params != NULL) ? case_params->acceleration_straight : 0.0f;
-  const float accel_high = (case_params != NULL) ? case_params->acceleration_straight_dash : 0.0f;
-  bool two_stage;
-  float d_acc = 0.0f;
-  float d_constant = 0.0f;
-  float max_reached_speed = v_max;
+  const path_speed_seg_t* seg = &s_speed_plan.seg[seg_index];
+  const uint16_t code = seg->code;
+  const float straight_mm = seg->length_mm;
+  const float v_next = seg->v_exit;
   f413_run_session_abort_reason_t reason;
   bool next_is_small_turn;
   bool next_is_large_turn;
@@ -803,76 +631,11 @@ static f413_run_session_abort_reason_t f413_path_run_run_straight_code(
   bool prev_is_large_turn;
   bool skip_wallend;
 
-  if ((straight_mm <= 0.0f) || (v_max <= 0.0f))
+  if (straight_mm <= 0.0f)
   {
     return F413_RUN_SESSION_ABORT_NONE;
   }
 
-  two_stage = (v_switch > 0.0f) && (v_switch < v_max) &&
-              (accel_low > 0.0f) && (accel_high > 0.0f);
-  if (two_stage)
-  {
-    const float d1 = ((v_switch * v_switch) - (v_start * v_start)) / (2.0f * accel_low);
-    const float d2 = ((v_max * v_max) - (v_switch * v_switch)) / (2.0f * accel_high);
-    const float d_acc_full = d1 + d2;
-    const float d_total_acc_dec = 2.0f * d_acc_full;
-
-    if (d_total_acc_dec <= straight_mm)
-    {
-      d_acc = d_acc_full;
-      d_constant = straight_mm - d_total_acc_dec;
-      max_reached_speed = v_max;
-    }
-    else
-    {
-      const float d_to_switch_and_back = 2.0f * d1;
-      if (d_to_switch_and_back <= straight_mm)
-      {
-        const float remain_half = (straight_mm - d_to_switch_and_back) * 0.5f;
-        const float v_reached_sq = (v_switch * v_switch) + (2.0f * accel_high * remain_half);
-        max_reached_speed = sqrtf(v_reached_sq);
-        d_acc = d1 + remain_half;
-        d_constant = 0.0f;
-      }
-      else
-      {
-        d_acc = straight_mm * 0.5f;
-        d_constant = 0.0f;
-        max_reached_speed = sqrtf((v_start * v_start) + (2.0f * accel_low * d_acc));
-      }
-    }
-  }
-  else
-  {
-    const float accel = (accel_high > 0.0f) ? accel_high : accel_low;
-    if (accel <= 0.0f)
-    {
-      return f413_path_run_drive_segment(straight_mm, v_next, speed_now_mm_s, guard, trace_flags);
-    }
-    {
-      const float t_acc_time = v_max / accel;
-      const float d_acc_full = 0.5f * accel * t_acc_time * t_acc_time;
-      const float d_total_acc_dec = 2.0f * d_acc_full;
-      if (d_total_acc_dec > straight_mm)
-      {
-        d_acc = straight_mm * 0.5f;
-        d_constant = 0.0f;
-        max_reached_speed = sqrtf(2.0f * accel * d_acc);
-      }
-      else
-      {
-        d_acc = d_acc_full;
-        d_constant = straight_mm - d_total_acc_dec;
-        max_reached_speed = v_max;
-      }
-    }
-  }
-
-  if (d_acc > 0.0f)
-  {
-    /* handled below */
-  }
-
   next_is_small_turn = (next_code >= 300U) && (next_code < 500U);
   next_is_large_turn = (next_code >= 500U) && (next_code < 700U);
   prev_is_small_turn = (prev_code >= 300U) && (prev_code < 500U);
@@ -883,9 +646,8 @@ static f413_run_session_abort_reason_t f413_path_run_run_straight_code(
 
   if ((next_is_small_turn || next_is_large_turn) && !skip_wallend)
   {
+    /* 最後の半区画は壁切れ待ち。計画の残り（減速の途中なら残り全部）はその中で出口速度へ寄せる */
     const float wall_end_buffer_mm = (float)DIST_HALF_SEC;
-    const float buffer_max_mm = (float)DIST_HALF_SEC;
-    const float min_main_for_accel = (float)DIST_HALF_SEC * 2.0f;
     float main_mm = straight_mm - wall_end_buffer_mm;
     bool wall_end_found = false;
 
@@ -894,56 +656,14 @@ static f413_run_session_abort_reason_t f413_path_run_run_straight_code(
       main_mm = 0.0f;
     }
 
-    if (main_mm >= min_main_for_accel)
-    {
-      if (d_acc > 0.0f)
-      {
-        const float acc_run = (d_acc < main_mm) ? d_acc : main_mm;
-        reason = f413_path_run_drive_segment(acc_run, max_reached_speed,
-                                             speed_now_mm_s, guard, trace_flags);
-        if (reason != F413_RUN_SESSION_ABORT_NONE)
-        {
-          return reason;
-        }
-      }
-      if ((main_mm - d_acc) > 0.0f && d_constant > 0.0f)
-      {
-        float const_run = main_mm - d_acc;
-        if (const_run > d_constant)
-        {
-          const_run = d_constant;
-        }
-        reason = f413_path_run_drive_segment(const_run, max_reached_speed,
-                                             speed_now_mm_s, guard, trace_flags);
-        if (reason != F413_RUN_SESSION_ABORT_NONE)
-        {
-          return reason;
-        }
-      }
-      {
-        const float dec_in_main = main_mm - d_acc - d_constant;
-        if (dec_in_main > 0.0f)
-        {
-          reason = f413_path_run_drive_segment(dec_in_main, v_next,
-                                               speed_now_mm_s, guard, trace_flags);
-          if (reason != F413_RUN_SESSION_ABORT_NONE)
-          {
-            return reason;
-          }
-        }
-      }
-    }
-    else if (main_mm > 0.0f)
+    reason = f413_path_run_drive_planned(seg_index, 0.0f, main_mm, false,
+                                         speed_now_mm_s, guard, trace_flags);
+    if (reason != F413_RUN_SESSION_ABORT_NONE)
     {
-      reason = f413_path_run_drive_segment(main_mm, v_next,
-                                           speed_now_mm_s, guard, trace_flags);
-      if (reason != F413_RUN_SESSION_ABORT_NONE)
-      {
-        return reason;
-      }
+      return reason;
     }
 
-    reason = f413_path_run_drive_wallend_segment(buffer_max_mm,
+    reason = f413_path_run_drive_wallend_segment(wall_end_buffer_mm,
                                                  v_next,
                                                  speed_now_mm_s,
                                                  guard,
@@ -970,108 +690,24 @@ static f413_run_session_abort_reason_t f413_path_run_run_straight_code(
     return F413_RUN_SESSION_ABORT_NONE;
   }
 
-  if (d_acc > 0.0f)
-  {
-    reason = f413_path_run_drive_segment(d_acc, max_reached_speed, speed_now_mm_s,
-                                         guard, trace_flags);
-    if (reason != F413_RUN_SESSION_ABORT_NONE)
-    {
-      return reason;
-    }
-  }
-  if (d_constant > 0.0f)
-  {
-    reason = f413_path_run_drive_segment(d_constant, max_reached_speed, speed_now_mm_s,
-                                         guard, trace_flags);
-    if (reason != F413_RUN_SESSION_ABORT_NONE)
-    {
-      return reason;
-    }
-  }
-  if (d_acc > 0.0f)
-  {
-    reason = f413_path_run_drive_segment(d_acc, v_next, speed_now_mm_s,
-                                         guard, trace_flags);
-    if (reason != F413_RUN_SESSION_ABORT_NONE)
-    {
-      return reason;
-    }
-  }
-  return F413_RUN_SESSION_ABORT_NONE;
-}
-
-static float f413_path_run_next_diagonal_exit_velocity(uint16_t next_code,
-                                                       const ShortestRunModeParams_t* mode_params)
-{
-  if (mode_params == NULL)
-  {
-    return 0.0f;
-  }
-  if (next_code < 800U)
-  {
-    return mode_params->velocity_turn45out;
-  }
-  if (next_code < 900U)
-  {
-    return mode_params->velocity_turnV90;
-  }
-  if (next_code < 1000U)
-  {
-    return mode_params->velocity_turn135out;
-  }
-  return 0.0f;
+  return f413_path_run_drive_planned(seg_index, 0.0f, straight_mm, false,
+                                     speed_now_mm_s, guard, trace_flags);
 }
 
 static f413_run_session_abort_reason_t f413_path_run_run_diagonal_code(
-    uint16_t code,
-    uint16_t next_code,
-    const ShortestRunModeParams_t* mode_params,
-    const ShortestRunCaseParams_t* case_params,
+    uint16_t seg_index,
     float* speed_now_mm_s,
     f413_run_session_guard_t* guard,
     uint16_t trace_flags)
 {
-  const float straight_mm = (float)(code - 1000U) * (float)DIST_D_HALF_SEC;
-  const float v_max = (case_params != NULL) ? case_params->velocity_d_straight : 0.0f;
-  const float accel = (case_params != NULL) ? case_params->acceleration_d_straight_dash : 0.0f;
-  const float v_next = f413_path_run_next_diagonal_exit_velocity(next_code, mode_params);
-  float d_acc;
-  float d_constant = 0.0f;
-  float max_reached_speed = v_max;
-  f413_run_session_abort_reason_t reason;
+  const path_speed_seg_t* seg = &s_speed_plan.seg[seg_index];
 
-  if ((straight_mm <= 0.0f) || (v_max <= 0.0f) || (accel <= 0.0f))
+  if (seg->length_mm <= 0.0f)
   {
     return F413_RUN_SESSION_ABORT_NONE;
   }
-
-  {
-    const float t_acc = v_max / accel;
-    d_acc = 0.5f * accel * t_acc * t_acc;
-  }
-  if ((2.0f * d_acc) > straight_mm)
-  {
-    d_acc = straight_mm * 0.5f;
-    max_reached_speed = accel * sqrtf((2.0f * d_acc) / accel);
-  }
-  else
-  {
-    d_constant = straight_mm - (2.0f * d_acc);
-  }
-
-  reason = f413_path_run_drive_diagonal_segment(d_acc, max_reached_speed, speed_now_mm_s,
-                                                guard, trace_flags);
-  if (reason != F413_RUN_SESSION_ABORT_NONE)
-  {
-    return reason;
-  }
-  reason = f413_path_run_drive_diagonal_segment(d_constant, max_reached_speed, speed_now_mm_s,
-                                                guard, trace_flags);
-  if (reason != F413_RUN_SESSION_ABORT_NONE)
-  {
-    return reason;
-  }
-  return f413_path_run_drive_diagonal_segment(d_acc, v_next, speed_now_mm_s, guard, trace_flags);
+  return f413_path_run_drive_planned(seg_index, 0.0f, seg->length_mm, true,
+                                     speed_now_mm_s, guard, trace_flags);
 }
 
 void f413_path_run_print_preview(void)
@@ -1184,27 +820,35 @@ void f413_path_run_session_once(uint8_t mode,
                (double)diagonal_velocity,
                (double)NIGHTFALL_F413_PATH_VELOCITY_CAP);
 
+  if (!path_speed_plan_build(&s_speed_plan, path, mode_params, case_params,
+                             NIGHTFALL_F413_PATH_OMEGA_CAP))
+  {
+    trace_printf("[RUN-TEST] path canceled(speed plan failed)\r\n");
+    return;
+  }
+  trace_printf("[RUN-TEST] speed plan segs=%u est=%.3fs infeasible=%u\r\n",
+               (unsigned int)s_speed_plan.count,
+               (double)s_speed_plan.total_time_s,
+               (unsigned int)s_speed_plan.infeasible);
+
   if (!f413_run_session_guard_prepare(&guard))
   {
     trace_printf("[RUN-TEST] path canceled(guard init fail)\r\n");
     return;
   }
 
+  f413_path_run_compile_turn_profiles(mode_params);
   f413_ctrl_start();
   f413_wall_runtime_set_control_gains(case_params->kp_wall, case_params->kp_diagonal);
   f413_path_run_trace_on_run_start();
 
-  {
-    const float first_speed =
-        sqrtf(fmaxf(0.0f, 2.0f * case_params->acceleration_straight * (float)DIST_FIRST_SEC));
-    abort_reason = f413_path_run_drive_segment((float)DIST_FIRST_SEC,
-                                               first_speed,
-                                               &speed_now,
-                                               &guard,
-                                               (uint16_t)(base_trace_flag |
-                                                          NIGHTFALL_F413_TRACE_MODE_SOLVER_PATH_FLAG |
-                                                          NIGHTFALL_F413_TRACE_MODE_MOTOR_FWD_FLAG));
-  }
+  /* 先頭の半端区画（計画の区間0）。以降 path[pi] は区間 pi+1 */
+  abort_reason = f413_path_run_drive_planned(0U, 0.0f, s_speed_plan.seg[0].length_mm, false,
+                                             &speed_now,
+                                             &guard,
+                                             (uint16_t)(base_trace_flag |
+                                                        NIGHTFALL_F413_TRACE_MODE_SOLVER_PATH_FLAG |
+                                                        NIGHTFALL_F413_TRACE_MODE_MOTOR_FWD_FLAG));
 
   for (pi = 0U; pi < NIGHTFALL_F413_PATH_MAX_CODES; pi++)
   {
@@ -1223,11 +867,10 @@ void f413_path_run_session_once(uint8_t mode,
 
     if ((code > 200U) && (code < 300U))
     {
-      abort_reason = f413_path_run_run_straight_code(code,
+      abort_reason = f413_path_run_run_straight_code((uint16_t)(pi + 1U),
                                                      (pi > 0U) ? path[pi - 1U] : 0U,
                                                      next_code,
                                                      mode_params,
-                                                     case_params,
                                                      &speed_now,
                                                      &guard,
           (uint16_t)(base_trace_flag | NIGHTFALL_F413_TRACE_MODE_SOLVER_PATH_FLAG |
@@ -1235,10 +878,7 @@ void f413_path_run_session_once(uint8_t mode,
     }
     else if (code > 1000U)
     {
-      abort_reason = f413_path_run_run_diagonal_code(code,
-                                                     next_code,
-                                                     mode_params,
-                                                     case_params,
+      abort_reason = f413_path_run_run_diagonal_code((uint16_t)(pi + 1U),
                                                      &speed_now,
                                                      &guard,
           (uint16_t)(base_trace_flag | NIGHTFALL_F413_TRACE_MODE_SOLVER_PATH_FLAG |
@@ -0,0 +1,93 @@
+#include "f413_prof_diag.h"
+
+#include "f413_control.h"
+#include "isr_prof.h"
+#include "stm32f4xx_hal.h"
+#include "trace.h"
+
+#define F413_PROF_DIAG_CTRL_BUDGET_US (1000U) // TIM5 1kHz
+#define F413_PROF_DIAG_WALL_BUDGET_US (50U)   // TIM6 20kHz
+
+static uint32_t f413_prof_diag_cycles(void)
+{
+  return DWT->CYCCNT;
+}
+
+void f413_prof_diag_init(void)
+{
+  CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+  DWT->CYCCNT = 0U;
+  DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+  isr_prof_init(f413_prof_diag_cycles, SystemCoreClock / 1000000U);
+  isr_prof_set_budget_us(ISR_PROF_CTRL_TICK, F413_PROF_DIAG_CTRL_BUDGET_US);
+  isr_prof_set_budget_us(ISR_PROF_CTRL_PERIOD, F413_PROF_DIAG_CTRL_BUDGET_US + F413_PROF_DIAG_CTRL_BUDGET_US / 10U);
+  isr_prof_set_budget_us(ISR_PROF_WALL_SCHED, F413_PROF_DIAG_WALL_BUDGET_US);
+  isr_prof_set_budget_us(ISR_PROF_WALL_UPDATE, F413_PROF_DIAG_WALL_BUDGET_US);
+}
+
+/* SPI2 の時間割: IMU スロットの取りこぼし（目標 0）と FRAM 転送の許可・見送り・超過 */
+static void f413_prof_diag_dump_spi2(void)
+{
+  spi_bus_sched_stats_t st;
+
+  f413_ctrl_spi2_get_stats(&st);
+  trace_printf("[PROF] spi2 imu_slots=%lu dropped=%lu (skipped=%lu late=%lu err=%lu) "
+               "fram_grants=%lu deferred=%lu overruns=%lu max_hold=%luus\r\n",
+               (unsigned long)st.imu_slots,
+               (unsigned long)spi_bus_sched_imu_dropped(&st),
+               (unsigned long)st.imu_skipped,
+               (unsigned long)st.imu_late,
+               (unsigned long)st.imu_errors,
+               (unsigned long)st.fram_grants,
+               (unsigned long)st.fram_deferred,
+               (unsigned long)st.fram_overruns,
+               (unsigned long)st.fram_max_hold_us);
+}
+
+void f413_prof_diag_run_dump_once(void)
+{
+  uint32_t s;
+  uint32_t b;
+
+  trace_printf("[PROF] core=%luMHz unit=0.1us hist=log2(us) bins: <1,1,2,4,...,%lu+\r\n",
+               (unsigned long)(SystemCoreClock / 1000000U),
+               (unsigned long)isr_prof_hist_bin_floor_us(ISR_PROF_HIST_BINS - 1U));
+  for (s = 0U; s < (uint32_t)ISR_PROF_SECTION_COUNT; s++)
+  {
+    isr_prof_stat_t st;
+    uint32_t mean;
+
+    if (!isr_prof_snapshot((isr_prof_section_t)s, &st))
+    {
+      trace_printf("[PROF] disabled\r\n");
+      return;
+    }
+    if (st.count == 0U)
+    {
+      trace_printf("[PROF] %-12s n=0\r\n", isr_prof_section_name((isr_prof_section_t)s));
+      continue;
+    }
+    mean = (uint32_t)(st.sum_cycles / st.count);
+    trace_printf("[PROF] %-12s n=%lu min=%u mean=%u max=%u last=%u over=%lu hist=",
+                 isr_prof_section_name((isr_prof_section_t)s),
+                 (unsigned long)st.count,
+                 (unsigned int)isr_prof_cycles_to_us_x10(st.min_cycles),
+                 (unsigned int)isr_prof_cycles_to_us_x10(mean),
+                 (unsigned int)isr_prof_cycles_to_us_x10(st.max_cycles),
+                 (unsigned int)isr_prof_cycles_to_us_x10(st.last_cycles),
+                 (unsigned long)st.over_budget);
+    for (b = 0U; b < ISR_PROF_HIST_BINS; b++)
+    {
+      trace_printf((b + 1U < ISR_PROF_HIST_BINS) ? "%lu," : "%lu\r\n", (unsigned long)st.hist[b]);
+    }
+  }
+  f413_prof_diag_dump_spi2();
+}
+
+void f413_prof_diag_run_reset_once(void)
+{
+  isr_prof_reset();
+  f413_ctrl_spi2_reset_stats();
+  trace_printf("[PROF] reset\r\n");
+}
@@ -9,11 +9,13 @@
 #include "f413_run_session.h"
 #include "f413_trace_flags.h"
 #include "f413_wall_runtime.h"
+#include "maze_bitboard.h"
 #include "nvm_params.h"
 #include "nvm_trace_log.h"
 #include "params.h"
 #include "search.h"
 #include "search_run_params.h"
+#include "solver.h"
 #include "trace.h"
 
 #define F413_SEARCH_STEP_MAZE_WALL_W (0x01U)
@@ -59,15 +61,18 @@
 #define F413_SEARCH_EVENT_FLAG_ACCELED_AFTER (0x04U)
 #define F413_SEARCH_EVENT_FLAG_NEXT_TURN90 (0x08U)
 
-typedef struct {
-  float omega_peak_deg_s;
-  float t_acc_s;
-  float t_cruise_s;
-  float t_total_s;
-} f413_search_step_smooth_turn_t;
+#define F413_SEARCH_TURN_PROFILE_SLOTS (4U) /* 90°スラローム・超信地旋回（±90/180） */
 
 static f413_search_step_config_t g_config;
 static bool g_session_active = false;
+/* 旋回表（セッション内で初回使用時に作成し、以降は同じ表を制御割り込みで再生する） */
+static turn_profile_t g_turn_profile_slots[F413_SEARCH_TURN_PROFILE_SLOTS];
+static turn_profile_cache_t g_turn_profile_cache = {g_turn_profile_slots,
+                                                    (uint8_t)F413_SEARCH_TURN_PROFILE_SLOTS,
+                                                    0U, 0U, 0xffU};
+/* 探索中の壁（map の下位4bit）の行ビットボード。地図の初期化・読込で全面を作り、
+   壁の書き込みでは書いた区画だけ更新する（歩数マップ作成のたびに作り直さない） */
+static maze_bitboard_t g_map_bb;
 static uint8_t g_search_dual_wall_streak = 0U;
 static uint8_t g_search_right_wall_streak = 0U;
 static uint8_t g_search_left_wall_streak = 0U;
@@ -150,8 +155,11 @@ static void f413_search_step_set_action_context(uint8_t op_case,
                                                 uint8_t dir,
                                                 uint8_t next_rel)
 {
+  /* 32x32 迷路の座標 bit4 は test_id の空き bit（x=bit4, y=bit5）へ入れる */
   uint8_t packed_xy = (uint8_t)(((y & 0x0FU) << 4U) | (x & 0x0FU));
   uint8_t packed_action = (uint8_t)(0x80U |
+                                    ((y & 0x10U) << 1U) |
+                                    (x & 0x10U) |
                                     ((next_rel & 0x03U) << 2U) |
                                     (dir & 0x03U));
 
@@ -399,8 +407,8 @@ static bool f413_search_event_start(uint8_t op_case,
                            (int32_t)param_index,
                            (int32_t)F413_SEARCH_STEP_AUTO_MAX_ACTIONS,
                            g_config.trace_search_safe_flag);
-  trace_printf("[SEARCH-EVENT] start cap=%lu max_actions=%lu\r\n",
-               (unsigned long)g_search_event_log_header.record_capacity,
+  trace_printf("[SEARCH-EVENT] start blocks=%lu max_actions=%lu\r\n",
+               (unsigned long)g_search_event_log_header.block_count,
                (unsigned long)F413_SEARCH_STEP_AUTO_MAX_ACTIONS);
   return true;
 }
@@ -412,6 +420,7 @@ static void f413_search_event_finish(uint8_t op_case,
                                      f413_run_session_abort_reason_t abort_reason)
 {
   nvm_status_t st;
+  uint32_t stored = 0U;
 
   if (!g_search_event_log_active)
   {
@@ -444,11 +453,10 @@ static void f413_search_event_finish(uint8_t op_case,
     g_search_event_log_uncommitted = 0U;
   }
 
+  (void)nvm_trace_log_get_stored(&g_search_event_log_header, &stored, NULL);
   trace_printf("[SEARCH-EVENT] stop total=%lu stored=%lu status=%d\r\n",
                (unsigned long)g_search_event_log_header.total_records,
-               (unsigned long)((g_search_event_log_header.total_records > g_search_event_log_header.record_capacity)
-                                   ? g_search_event_log_header.record_capacity
-                                   : g_search_event_log_header.total_records),
+               (unsigned long)stored,
                (int)g_search_event_log_status);
   g_search_event_log_active = false;
 }
@@ -602,17 +610,12 @@ static void f413_search_step_angle_reset_streak_update(void)
 
 static bool f413_search_step_is_goal_cell(uint8_t x, uint8_t y)
 {
-  static const uint8_t goals[9][2] = {
-      {GOAL1_X, GOAL1_Y}, {GOAL2_X, GOAL2_Y}, {GOAL3_X, GOAL3_Y},
-      {GOAL4_X, GOAL4_Y}, {GOAL5_X, GOAL5_Y}, {GOAL6_X, GOAL6_Y},
-      {GOAL7_X, GOAL7_Y}, {GOAL8_X, GOAL8_Y}, {GOAL9_X, GOAL9_Y},
-  };
   uint8_t i;
 
-  for (i = 0U; i < 9U; i++)
+  for (i = 0U; i < (uint8_t)SOLVER_GOAL_SLOTS; i++)
   {
-    uint8_t gx = goals[i][0];
-    uint8_t gy = goals[i][1];
+    uint8_t gx = solver_goals[i][0];
+    uint8_t gy = solver_goals[i][1];
     if (((gx != 0U) || (gy != 0U)) && (gx == x) && (gy == y))
     {
       return true;
@@ -736,6 +739,12 @@ static void f413_search_step_map_init_empty(void)
     map[START_Y][START_X - 1U] |= 0x44U;
   }
   visited[START_Y][START_X] = true;
+  maze_bitboard_build(&g_map_bb, map, 0U);
+}
+
+void f413_search_step_map_reloaded(void)
+{
+  maze_bitboard_build(&g_map_bb, map, 0U);
 }
 
 static uint16_t f413_search_step_wall_info_from_snapshot(const f413_wall_sensor_snapshot_t* wall)
@@ -746,16 +755,16 @@ static uint16_t f413_search_step_wall_info_from_snapshot(const f413_wall_sensor_
   {
     return 0U;
   }
-  if (f413_search_step_wall_delta_present(wall->fr_delta, WALL_BASE_FR) ||
-      f413_search_step_wall_delta_present(wall->fl_delta, WALL_BASE_FL))
+  if (f413_search_step_wall_delta_present(wall->fr_delta, g_f413_wall_threshold.fr) ||
+      f413_search_step_wall_delta_present(wall->fl_delta, g_f413_wall_threshold.fl))
   {
     info |= 0x88U;
   }
-  if (f413_search_step_wall_delta_present(wall->r_delta, WALL_BASE_R))
+  if (f413_search_step_wall_delta_present(wall->r_delta, g_f413_wall_threshold.r))
   {
     info |= 0x44U;
   }
-  if (f413_search_step_wall_delta_present(wall->l_delta, WALL_BASE_L))
+  if (f413_search_step_wall_delta_present(wall->l_delta, g_f413_wall_threshold.l))
   {
     info |= 0x11U;
   }
@@ -829,38 +838,32 @@ static void f413_search_step_write_map_cell(uint8_t x, uint8_t y, uint8_t dir, u
   {
     map[START_Y][START_X + 1U] |= 0x11U;
   }
+
+  /* 書いた区画の行マスクだけ更新する（迷路外の隣接区画は無視される） */
+  maze_bitboard_update_cell(&g_map_bb, map, 0U, x, y);
+  maze_bitboard_update_cell(&g_map_bb, map, 0U, x, (uint8_t)(y + 1U));
+  maze_bitboard_update_cell(&g_map_bb, map, 0U, (uint8_t)(x + 1U), y);
+  maze_bitboard_update_cell(&g_map_bb, map, 0U, x, (uint8_t)(y - 1U));
+  maze_bitboard_update_cell(&g_map_bb, map, 0U, (uint8_t)(x - 1U), y);
+  maze_bitboard_update_cell(&g_map_bb, map, 0U, START_X, START_Y);
+  maze_bitboard_update_cell(&g_map_bb, map, 0U, START_X + 1U, START_Y);
 }
 
 static int f413_search_step_make_smap(uint8_t x, uint8_t y, uint8_t target)
 {
-  static uint16_t q[F413_SEARCH_STEP_CELL_COUNT];
-  uint16_t head = 0U;
-  uint16_t tail = 0U;
+  maze_row_t seed[MAZE_SIZE] = {0};
+  uint16_t step;
   uint8_t ix;
   uint8_t iy;
-  static const uint8_t goals[9][2] = {
-      {GOAL1_X, GOAL1_Y}, {GOAL2_X, GOAL2_Y}, {GOAL3_X, GOAL3_Y},
-      {GOAL4_X, GOAL4_Y}, {GOAL5_X, GOAL5_Y}, {GOAL6_X, GOAL6_Y},
-      {GOAL7_X, GOAL7_Y}, {GOAL8_X, GOAL8_Y}, {GOAL9_X, GOAL9_Y},
-  };
 
   if ((x >= MAZE_SIZE) || (y >= MAZE_SIZE))
   {
     return -1;
   }
 
-  for (iy = 0U; iy < MAZE_SIZE; iy++)
-  {
-    for (ix = 0U; ix < MAZE_SIZE; ix++)
-    {
-      smap[iy][ix] = 0xFFFFU;
-    }
-  }
-
   if (target == F413_SEARCH_STEP_TARGET_START)
   {
-    smap[START_Y][START_X] = 0U;
-    q[tail++] = (uint16_t)(START_Y * MAZE_SIZE + START_X);
+    maze_bitboard_seed_set(seed, START_X, START_Y);
   }
   else if (target == F413_SEARCH_STEP_TARGET_FULL)
   {
@@ -874,62 +877,40 @@ static int f413_search_step_make_smap(uint8_t x, uint8_t y, uint8_t target)
         if (!visited[iy][ix])
         {
           any_unvisited = true;
-          smap[iy][ix] = 0U;
-          q[tail++] = (uint16_t)(iy * MAZE_SIZE + ix);
+          maze_bitboard_seed_set(seed, ix, iy);
         }
       }
     }
     if (!any_unvisited)
     {
+      for (iy = 0U; iy < MAZE_SIZE; iy++)
+      {
+        for (ix = 0U; ix < MAZE_SIZE; ix++)
+        {
+          smap[iy][ix] = 0xFFFFU;
+        }
+      }
       return -2;
     }
   }
   else
   {
-    for (ix = 0U; ix < 9U; ix++)
+    for (ix = 0U; ix < (uint8_t)SOLVER_GOAL_SLOTS; ix++)
     {
-      uint8_t gx = goals[ix][0];
-      uint8_t gy = goals[ix][1];
-      if (((gx == 0U) && (gy == 0U)) || (gx >= MAZE_SIZE) || (gy >= MAZE_SIZE))
+      uint8_t gx = solver_goals[ix][0];
+      uint8_t gy = solver_goals[ix][1];
+      if ((gx == 0U) && (gy == 0U))
       {
         continue;
       }
-      smap[gy][gx] = 0U;
-      q[tail++] = (uint16_t)(gy * MAZE_SIZE + gx);
+      maze_bitboard_seed_set(seed, gx, gy);
     }
   }
 
-  while ((head < tail) && (smap[y][x] == 0xFFFFU))
-  {
-    uint16_t idx = q[head++];
-    uint8_t cy = (uint8_t)(idx / MAZE_SIZE);
-    uint8_t cx = (uint8_t)(idx - (uint16_t)(cy * MAZE_SIZE));
-    uint16_t step = smap[cy][cx];
-    uint8_t cell = (uint8_t)(map[cy][cx] & F413_SEARCH_STEP_MAZE_WALL_KNOWN_MASK);
+  /* 探索中の壁（下位4bit、g_map_bb は壁の書き込みで更新済み）で現在地の歩数まで波面展開する */
+  step = maze_bitboard_flood(&g_map_bb, seed, smap, x, y);
 
-    if (((cell & F413_SEARCH_STEP_MAZE_WALL_N) == 0U) && (cy != (MAZE_SIZE - 1U)) && (smap[cy + 1U][cx] == 0xFFFFU))
-    {
-      smap[cy + 1U][cx] = (uint16_t)(step + 1U);
-      q[tail++] = (uint16_t)((cy + 1U) * MAZE_SIZE + cx);
-    }
-    if (((cell & F413_SEARCH_STEP_MAZE_WALL_E) == 0U) && (cx != (MAZE_SIZE - 1U)) && (smap[cy][cx + 1U] == 0xFFFFU))
-    {
-      smap[cy][cx + 1U] = (uint16_t)(step + 1U);
-      q[tail++] = (uint16_t)(cy * MAZE_SIZE + (cx + 1U));
-    }
-    if (((cell & F413_SEARCH_STEP_MAZE_WALL_S) == 0U) && (cy != 0U) && (smap[cy - 1U][cx] == 0xFFFFU))
-    {
-      smap[cy - 1U][cx] = (uint16_t)(step + 1U);
-      q[tail++] = (uint16_t)((cy - 1U) * MAZE_SIZE + cx);
-    }
-    if (((cell & F413_SEARCH_STEP_MAZE_WALL_W) == 0U) && (cx != 0U) && (smap[cy][cx - 1U] == 0xFFFFU))
-    {
-      smap[cy][cx - 1U] = (uint16_t)(step + 1U);
-      q[tail++] = (uint16_t)(cy * MAZE_SIZE + (cx - 1U));
-    }
-  }
-
-  return (smap[y][x] == 0xFFFFU) ? -1 : (int)smap[y][x];
+  return (step == MAZE_BITBOARD_UNREACHED) ? -1 : (int)step;
 }
 
 static int f413_search_step_make_goal_smap(uint8_t x, uint8_t y)
@@ -1139,52 +1120,47 @@ static float f413_search_step_speed_after_accel(float speed_mm_s,
                          (2.0f * accel_mm_s2 * distance_mm)));
 }
 
-static f413_search_step_smooth_turn_t f413_search_step_build_smooth_turn(float angle_deg,
-                                                                         float alpha_deg_s2)
+static const turn_profile_t* f413_search_step_turn_profile(float angle_deg, float alpha_deg_s2)
 {
-  f413_search_step_smooth_turn_t profile = {0.0f, 0.0f, 0.0f, 0.0f};
-  const float angle_abs = fabsf(angle_deg);
-  float rounding_scale = TURN_OMEGA_PROFILE_ROUNDING_SCALE;
+  const turn_profile_t* profile = turn_profile_cache_get(&g_turn_profile_cache,
+                                                         angle_deg,
+                                                         alpha_deg_s2,
+                                                         TURN_OMEGA_PROFILE_ROUNDING_SCALE,
+                                                         NIGHTFALL_F413_PATH_OMEGA_CAP);
 
-  if ((angle_abs <= 0.0f) || (alpha_deg_s2 <= 0.0f))
+  if ((profile == NULL) || (profile->n_total == 0U))
   {
-    return profile;
-  }
-  if (rounding_scale < 0.1f)
-  {
-    rounding_scale = 0.1f;
+    return NULL;
   }
+  return profile;
+}
 
-  profile.omega_peak_deg_s = sqrtf((2.0f * alpha_deg_s2 * angle_abs) / 3.0f);
-  if ((NIGHTFALL_F413_PATH_OMEGA_CAP > 0.0f) &&
-      (profile.omega_peak_deg_s > NIGHTFALL_F413_PATH_OMEGA_CAP))
-  {
-    profile.omega_peak_deg_s = NIGHTFALL_F413_PATH_OMEGA_CAP;
-  }
-  if (profile.omega_peak_deg_s <= 0.0f)
-  {
-    return profile;
-  }
+/* 旋回表の再生終了を待つ。待ち時間は表の長さ+余裕で打ち切る */
+static f413_run_session_abort_reason_t f413_search_step_wait_turn_profile(
+    const turn_profile_t* profile,
+    float velocity_mm_s,
+    uint16_t turn_trace_flags,
+    f413_run_session_guard_t* guard)
+{
+  f413_run_session_abort_reason_t reason = F413_RUN_SESSION_ABORT_NONE;
+  const uint32_t start_ms = f413_search_step_tick();
+  const uint32_t limit_ms = (uint32_t)profile->n_total + NIGHTFALL_F413_TURN_PROFILE_MARGIN_MS;
 
-  profile.t_acc_s = (profile.omega_peak_deg_s / alpha_deg_s2) * rounding_scale;
-  profile.t_cruise_s = (angle_abs / profile.omega_peak_deg_s) - profile.t_acc_s;
-  if (profile.t_cruise_s < 0.0f)
+  while (f413_ctrl_turn_profile_active())
   {
-    profile.t_cruise_s = 0.0f;
-    profile.omega_peak_deg_s = angle_abs / profile.t_acc_s;
-    if ((NIGHTFALL_F413_PATH_OMEGA_CAP > 0.0f) &&
-        (profile.omega_peak_deg_s > NIGHTFALL_F413_PATH_OMEGA_CAP))
+    if ((f413_search_step_tick() - start_ms) > limit_ms)
     {
-      profile.omega_peak_deg_s = NIGHTFALL_F413_PATH_OMEGA_CAP;
+      break;
     }
-    profile.t_cruise_s = (angle_abs / profile.omega_peak_deg_s) - profile.t_acc_s;
-    if (profile.t_cruise_s < 0.0f)
+    f413_search_step_set_mode_flags(turn_trace_flags);
+    f413_ctrl_set_velocity(velocity_mm_s);
+    reason = f413_run_session_wait_with_auto_step_guarded(1U, guard);
+    if (reason != F413_RUN_SESSION_ABORT_NONE)
     {
-      profile.t_cruise_s = 0.0f;
+      break;
     }
   }
-  profile.t_total_s = (2.0f * profile.t_acc_s) + profile.t_cruise_s;
-  return profile;
+  return reason;
 }
 
 static f413_run_session_abort_reason_t f413_search_step_wait_ctrl_target(float target,
@@ -1236,13 +1212,64 @@ static f413_run_session_abort_reason_t f413_search_step_wait_ctrl_target(float t
   return F413_RUN_SESSION_ABORT_NONE;
 }
 
+/* 走行コマンドの角度の扱い（prepare_*_angle_control() と同じく、積算モードでなければ区間ごとに 0 へ戻す） */
+static uint8_t f413_search_step_queue_angle_flags(void)
+{
+  return f413_run_features_angle_accum_mode() ? 0U : (uint8_t)F413_CTRL_CMD_FLAG_RESET_ANGLE;
+}
+
+/* 積んだ区間が終わるまで待つ（終了数が done_target に達するまで）。区間の切り替えは制御 tick が行い、
+   ここでは実行中の区間の種類に合わせてトレースのモードと壁制御の更新だけを行う */
+static f413_run_session_abort_reason_t f413_search_step_wait_queue(uint32_t done_target,
+                                                                   f413_run_session_guard_t* guard,
+                                                                   uint16_t straight_trace_flags,
+                                                                   uint16_t turn_trace_flags)
+{
+  f413_run_session_abort_reason_t reason;
+  f413_ctrl_queue_status_t st;
+  uint32_t deadline = f413_search_step_tick() + g_config.path_timeout_ms;
+
+  while ((int32_t)(f413_ctrl_queue_done_count() - done_target) < 0)
+  {
+    bool turning;
+    uint16_t trace_flags;
+
+    if (f413_search_step_tick() >= deadline)
+    {
+      f413_ctrl_queue_clear();
+      break;
+    }
+
+    f413_ctrl_queue_get_status(&st);
+    turning = st.busy && (st.type == F413_CTRL_CMD_TURN);
+    trace_flags = turning ? turn_trace_flags : straight_trace_flags;
+    f413_search_step_set_mode_flags(trace_flags);
+    reason = f413_run_session_wait_with_auto_step_guarded(1U, guard);
+    if (turning)
+    {
+      f413_wall_runtime_control_clear();
+    }
+    else if ((g_config.wall_control_apply_straight != NULL) &&
+             ((trace_flags & g_config.trace_motor_fwd_flag) != 0U))
+    {
+      g_config.wall_control_apply_straight();
+    }
+    if (reason != F413_RUN_SESSION_ABORT_NONE)
+    {
+      f413_ctrl_queue_clear();
+      return reason;
+    }
+  }
+  return F413_RUN_SESSION_ABORT_NONE;
+}
+
 static f413_run_session_abort_reason_t f413_search_step_drive_segment(float distance_mm,
                                                                       float target_velocity_mm_s,
                                                                       float* speed_now_mm_s,
                                                                       f413_run_session_guard_t* guard,
                                                                       uint16_t trace_flags)
 {
-  float target_distance;
+  f413_ctrl_cmd_t cmd;
   f413_run_session_abort_reason_t reason;
 
   if (speed_now_mm_s == NULL)
@@ -1255,12 +1282,18 @@ static f413_run_session_abort_reason_t f413_search_step_drive_segment(float dist
     return F413_RUN_SESSION_ABORT_NONE;
   }
 
-  target_distance = f413_ctrl_get_distance() + distance_mm;
-  f413_search_step_prepare_straight_angle_control();
-  f413_ctrl_set_velocity_profile(*speed_now_mm_s, target_velocity_mm_s, distance_mm);
-  f413_ctrl_set_omega(0.0f);
+  memset(&cmd, 0, sizeof(cmd));
+  cmd.type = F413_CTRL_CMD_STRAIGHT;
+  cmd.flags = f413_search_step_queue_angle_flags();
+  cmd.distance_mm = distance_mm;
+  cmd.v_in = *speed_now_mm_s;
+  cmd.v_out = target_velocity_mm_s;
+  if (!f413_ctrl_queue_push(&cmd))
+  {
+    return F413_RUN_SESSION_ABORT_IMU_FAULT;
+  }
 
-  reason = f413_search_step_wait_ctrl_target(target_distance, false, guard, trace_flags);
+  reason = f413_search_step_wait_queue(f413_ctrl_queue_pushed_count(), guard, trace_flags, trace_flags);
   *speed_now_mm_s = target_velocity_mm_s;
   return reason;
 }
@@ -1280,8 +1313,8 @@ static bool f413_search_step_front_wall_strong_present(void)
   {
     return false;
   }
-  return ((float)wall.fr_delta > ((float)WALL_BASE_FR * 1.5f)) &&
-         ((float)wall.fl_delta > ((float)WALL_BASE_FL * 1.5f));
+  return ((float)wall.fr_delta > ((float)g_f413_wall_threshold.fr * 1.5f)) &&
+         ((float)wall.fl_delta > ((float)g_f413_wall_threshold.fl * 1.5f));
 }
 
 static float f413_search_step_clampf(float value, float min_value, float max_value)
@@ -1328,8 +1361,8 @@ static f413_run_session_abort_reason_t f413_search_step_match_front_position(
     {
       return F413_RUN_SESSION_ABORT_WALL_FAULT;
     }
-    if (((float)wall.fr_delta <= ((float)WALL_BASE_FR * 1.5f)) ||
-        ((float)wall.fl_delta <= ((float)WALL_BASE_FL * 1.5f)))
+    if (((float)wall.fr_delta <= ((float)g_f413_wall_threshold.fr * 1.5f)) ||
+        ((float)wall.fl_delta <= ((float)g_f413_wall_threshold.fl * 1.5f)))
     {
       break;
     }
@@ -1647,8 +1680,8 @@ static f413_run_session_abort_reason_t f413_search_step_run_forward_wall_align(
     return F413_RUN_SESSION_ABORT_WALL_FAULT;
   }
 
-  align_right = (wall.r_delta > (int32_t)((float)WALL_BASE_R * 1.3f));
-  align_left = !align_right && (wall.l_delta > (int32_t)((float)WALL_BASE_L * 1.3f));
+  align_right = (wall.r_delta > (int32_t)((float)g_f413_wall_threshold.r * 1.3f));
+  align_left = !align_right && (wall.l_delta > (int32_t)((float)g_f413_wall_threshold.l * 1.3f));
   if (!align_right && !align_left)
   {
     return F413_RUN_SESSION_ABORT_NONE;
@@ -1815,9 +1848,9 @@ static f413_run_session_abort_reason_t f413_search_step_run_smooth_turn(
                                                   g_config.trace_motor_fwd_flag);
   const uint16_t turn_trace_flags = (uint16_t)(g_config.trace_search_safe_flag |
                                               g_config.trace_motor_rev_flag);
-  f413_search_step_smooth_turn_t profile;
+  const turn_profile_t* profile;
+  f413_ctrl_cmd_t cmd;
   f413_run_session_abort_reason_t reason;
-  uint32_t start_ms;
   float signed_angle;
   float angle_90;
   float entry_speed;
@@ -1834,8 +1867,8 @@ static f413_run_session_abort_reason_t f413_search_step_run_smooth_turn(
   {
     signed_angle = (next_rel == 1U) ? -90.0f : 90.0f;
   }
-  profile = f413_search_step_build_smooth_turn(signed_angle, params->alpha_turn90);
-  if (profile.t_total_s <= 0.0f)
+  profile = f413_search_step_turn_profile(signed_angle, params->alpha_turn90);
+  if (profile == NULL)
   {
     return F413_RUN_SESSION_ABORT_IMU_FAULT;
   }
@@ -1852,37 +1885,40 @@ static f413_run_session_abort_reason_t f413_search_step_run_smooth_turn(
     return reason;
   }
 
+  /* 旋回と出口の直進は続けて積み、旋回表の終わった tick から直進を始めさせる */
   turn_sign = (signed_angle < 0.0f) ? -1 : 1;
-  f413_search_step_prepare_turn_angle_control();
-  f413_ctrl_set_velocity(params->velocity_turn90);
-  f413_ctrl_start_omega_profile((float)turn_sign * profile.omega_peak_deg_s,
-                                profile.t_acc_s,
-                                profile.t_cruise_s);
-  start_ms = f413_search_step_tick();
-  while (1)
+  f413_wall_runtime_control_clear();
+  memset(&cmd, 0, sizeof(cmd));
+  cmd.type = F413_CTRL_CMD_TURN;
+  cmd.flags = f413_search_step_queue_angle_flags();
+  cmd.sign = turn_sign;
+  cmd.v_out = params->velocity_turn90;
+  cmd.profile = profile;
+  if (!f413_ctrl_queue_push(&cmd))
   {
-    const float t_s = (float)(f413_search_step_tick() - start_ms) * 0.001f;
-    if (t_s >= profile.t_total_s)
-    {
-      break;
-    }
-    f413_search_step_set_mode_flags(turn_trace_flags);
-    f413_ctrl_set_velocity(params->velocity_turn90);
-    reason = f413_run_session_wait_with_auto_step_guarded(1U, guard);
-    if (reason != F413_RUN_SESSION_ABORT_NONE)
-    {
-      f413_ctrl_stop_omega_profile();
-      return reason;
-    }
+    return F413_RUN_SESSION_ABORT_IMU_FAULT;
+  }
+  if (params->dist_offset_out > 0.0f)
+  {
+    cmd.type = F413_CTRL_CMD_STRAIGHT;
+    cmd.sign = 0;
+    cmd.profile = NULL;
+    cmd.distance_mm = params->dist_offset_out;
+    cmd.v_in = params->velocity_turn90;
+    cmd.v_out = entry_speed;
+    (void)f413_ctrl_queue_push(&cmd);
   }
-  f413_ctrl_stop_omega_profile();
-  *speed_now_mm_s = params->velocity_turn90;
 
-  return f413_search_step_drive_segment(params->dist_offset_out,
-                                        entry_speed,
-                                        speed_now_mm_s,
-                                        guard,
-                                        straight_trace_flags);
+  reason = f413_search_step_wait_queue(f413_ctrl_queue_pushed_count(),
+                                       guard,
+                                       straight_trace_flags,
+                                       turn_trace_flags);
+  if ((reason == F413_RUN_SESSION_ABORT_NONE) && (params->dist_offset_out <= 0.0f))
+  {
+    f413_ctrl_stop_omega_profile();
+  }
+  *speed_now_mm_s = (params->dist_offset_out > 0.0f) ? entry_speed : params->velocity_turn90;
+  return reason;
 }
 
 static f413_run_session_abort_reason_t f413_search_step_run_spot_spin_profile(
@@ -1892,13 +1928,12 @@ static f413_run_session_abort_reason_t f413_search_step_run_spot_spin_profile(
 {
   const uint16_t turn_trace_flags = (uint16_t)(g_config.trace_search_safe_flag |
                                               g_config.trace_motor_rev_flag);
-  f413_search_step_smooth_turn_t profile;
+  const turn_profile_t* profile;
   f413_run_session_abort_reason_t reason;
-  uint32_t start_ms;
   int8_t turn_sign;
 
-  profile = f413_search_step_build_smooth_turn(target_angle_deg, alpha_deg_s2);
-  if (profile.t_total_s <= 0.0f)
+  profile = f413_search_step_turn_profile(target_angle_deg, alpha_deg_s2);
+  if (profile == NULL)
   {
     return F413_RUN_SESSION_ABORT_IMU_FAULT;
   }
@@ -1907,35 +1942,21 @@ static f413_run_session_abort_reason_t f413_search_step_run_spot_spin_profile(
   trace_printf("[SEARCH-TEST] spin target=%.0fdeg alpha=%.0f omega_peak=%.0fdps total=%.2fs\r\n",
                (double)target_angle_deg,
                (double)alpha_deg_s2,
-               (double)((float)turn_sign * profile.omega_peak_deg_s),
-               (double)profile.t_total_s);
+               (double)((float)turn_sign * profile->omega_peak_deg_s),
+               (double)profile->t_total_s);
 
   f413_search_step_prepare_turn_angle_control();
   f413_ctrl_set_velocity(0.0f);
   f413_ctrl_set_omega(0.0f);
-  f413_ctrl_start_omega_profile((float)turn_sign * profile.omega_peak_deg_s,
-                                profile.t_acc_s,
-                                profile.t_cruise_s);
-
-  start_ms = f413_search_step_tick();
-  while (1)
+  f413_ctrl_start_turn_profile(profile, turn_sign);
+  reason = f413_search_step_wait_turn_profile(profile, 0.0f, turn_trace_flags, guard);
+  if (reason != F413_RUN_SESSION_ABORT_NONE)
   {
-    const float t_s = (float)(f413_search_step_tick() - start_ms) * 0.001f;
-    if (t_s >= profile.t_total_s)
-    {
-      break;
-    }
-    f413_search_step_set_mode_flags(turn_trace_flags);
+    f413_ctrl_stop_omega_profile();
+    f413_ctrl_clear_angle_target();
     f413_ctrl_set_velocity(0.0f);
-    reason = f413_run_session_wait_with_auto_step_guarded(1U, guard);
-    if (reason != F413_RUN_SESSION_ABORT_NONE)
-    {
-      f413_ctrl_stop_omega_profile();
-      f413_ctrl_clear_angle_target();
-      f413_ctrl_set_velocity(0.0f);
-      f413_ctrl_set_omega(0.0f);
-      return reason;
-    }
+    f413_ctrl_set_omega(0.0f);
+    return reason;
   }
 
   f413_ctrl_stop_omega_profile();
@@ -2307,6 +2328,9 @@ void f413_search_step_config(const f413_search_step_config_t* config)
 void f413_search_step_session_reset(void)
 {
   g_session_active = false;
+  turn_profile_cache_init(&g_turn_profile_cache,
+                          g_turn_profile_slots,
+                          (uint8_t)F413_SEARCH_TURN_PROFILE_SLOTS);
   g_search_sensor_kx = 1.0f;
   g_search_wall_read_valid = false;
   f413_search_step_angle_reset_streak_clear();
@@ -3135,12 +3159,15 @@ void f413_search_step_run_map_dump_once(void)
   bool loaded_ok = nvm_maze_load_map(loaded, F413_SEARCH_STEP_CELL_COUNT);
   int y;
   uint8_t x;
+  bool prev_lossless;
 
   if (loaded_ok)
   {
     cells = loaded;
   }
 
+  /* solver_host --search-dump で読むため欠落させない */
+  prev_lossless = trace_set_lossless(true);
   trace_printf("[SEARCH-DUMP] source=%s size=%u active=%u mouse=(%u,%u,%u)\r\n",
                loaded_ok ? "FRAM" : "RAM",
                (unsigned int)MAZE_SIZE,
@@ -3157,4 +3184,6 @@ void f413_search_step_run_map_dump_once(void)
     }
     trace_printf("\r\n");
   }
+  (void)trace_flush(NIGHTFALL_TRACE_FLUSH_TIMEOUT_MS);
+  (void)trace_set_lossless(prev_lossless);
 }
@@ -11,15 +11,15 @@
 #define MAIN_C_
 #include "global.h"
 
+#include "f413_search_step.h"
 #include "nvm.h"
 #include "nvm_params.h"
 #include <string.h>
 
 /* maze[][] / path_cell[][] は maze_grid.c で定義されるため、ここでは不要 */
 
-/* search.h 内の bg_plan_ready（ENABLE_BG_REPLAN=0 時はマクロ置換されるが
-   ヘッダでは extern volatile bool bg_plan_ready と宣言されている）。
-   リンクエラー防止用に実体を置く。 */
+/* search.h で extern volatile bool bg_plan_ready と宣言されている。
+   F413 は search.c（背景再計算の実体）をビルドしないため、リンクエラー防止用に実体を置く。 */
 volatile bool bg_plan_ready;
 
 /**
@@ -35,18 +35,19 @@ void load_map_from_eeprom(void)
 
     memset(map, 0, sizeof(map));
 
-    if (!nvm_maze_load_map(cells, (uint16_t)(MAZE_SIZE * MAZE_SIZE)))
+    if (nvm_maze_load_map(cells, (uint16_t)(MAZE_SIZE * MAZE_SIZE)))
     {
-        return;
-    }
-
-    for (int y = 0; y < MAZE_SIZE; y++)
-    {
-        for (int x = 0; x < MAZE_SIZE; x++)
+        for (int y = 0; y < MAZE_SIZE; y++)
         {
-            map[y][x] = cells[(uint32_t)y * MAZE_SIZE + (uint32_t)x];
+            for (int x = 0; x < MAZE_SIZE; x++)
+            {
+                map[y][x] = cells[(uint32_t)y * MAZE_SIZE + (uint32_t)x];
+            }
         }
     }
+
+    /* 探索ステップの壁ビットボードを読み込んだ地図に合わせる */
+    f413_search_step_map_reloaded();
 }
 
 /**
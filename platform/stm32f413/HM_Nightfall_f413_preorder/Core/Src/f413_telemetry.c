@@ -0,0 +1,98 @@
+#include "f413_telemetry.h"
+
+#include "telemetry.h"
+#include "trace.h"
+
+#define F413_TELEMETRY_BATCH (8U) // 1kHz で 8ms ごとに 1 パケット
+
+static telemetry_t g_telemetry;
+static bool g_telemetry_enabled = false;
+static telemetry_preset_t g_telemetry_preset = TELEMETRY_PRESET_RUN;
+static uint32_t g_telemetry_tx_dropped = 0U; // 送信バッファが満杯で捨てたパケット
+
+static void f413_telemetry_write(const uint8_t* packet, uint32_t len)
+{
+  uint32_t dropped = trace_dropped_writes();
+
+  trace_write((const char*)packet, len);
+  if (trace_dropped_writes() != dropped)
+  {
+    g_telemetry_tx_dropped++;
+  }
+}
+
+static void f413_telemetry_print_status(const char* label)
+{
+  trace_printf("[TELEMETRY] %s preset=%s batch=%u packets=%lu records=%lu bytes=%lu gaps=%lu tx_dropped=%lu\r\n",
+               label,
+               telemetry_preset_name(g_telemetry_preset),
+               (unsigned int)F413_TELEMETRY_BATCH,
+               (unsigned long)g_telemetry.stats.packets,
+               (unsigned long)g_telemetry.stats.records,
+               (unsigned long)g_telemetry.stats.bytes,
+               (unsigned long)g_telemetry.stats.gaps,
+               (unsigned long)g_telemetry_tx_dropped);
+}
+
+void f413_telemetry_toggle(void)
+{
+  if (g_telemetry_enabled)
+  {
+    f413_telemetry_flush();
+    g_telemetry_enabled = false;
+    f413_telemetry_print_status("off");
+    return;
+  }
+
+  telemetry_init(&g_telemetry, F413_TELEMETRY_BATCH);
+  telemetry_apply_preset(&g_telemetry, g_telemetry_preset);
+  g_telemetry_tx_dropped = 0U;
+  g_telemetry_enabled = true;
+  trace_printf("[TELEMETRY] on preset=%s batch=%u (streams while auto trace records)\r\n",
+               telemetry_preset_name(g_telemetry_preset),
+               (unsigned int)F413_TELEMETRY_BATCH);
+}
+
+bool f413_telemetry_is_enabled(void)
+{
+  return g_telemetry_enabled;
+}
+
+void f413_telemetry_next_preset(void)
+{
+  g_telemetry_preset = (telemetry_preset_t)(((uint32_t)g_telemetry_preset + 1U) % (uint32_t)TELEMETRY_PRESET_COUNT);
+  // 組み立て中のパケットには前の組のまま、次のパケットから反映される
+  telemetry_apply_preset(&g_telemetry, g_telemetry_preset);
+  f413_telemetry_print_status(g_telemetry_enabled ? "preset" : "preset (off)");
+}
+
+void f413_telemetry_send_record(const nvm_trace_log_record_t* rec)
+{
+  const uint8_t* packet;
+  uint32_t len;
+
+  if (!g_telemetry_enabled)
+  {
+    return;
+  }
+  if (telemetry_push(&g_telemetry, rec, &packet, &len))
+  {
+    f413_telemetry_write(packet, len);
+  }
+}
+
+void f413_telemetry_flush(void)
+{
+  const uint8_t* packet;
+  uint32_t len;
+
+  if (!g_telemetry_enabled)
+  {
+    return;
+  }
+  // 回した記録が残っていれば 2 回目で出る
+  while (telemetry_flush(&g_telemetry, &packet, &len))
+  {
+    f413_telemetry_write(packet, len);
+  }
+}
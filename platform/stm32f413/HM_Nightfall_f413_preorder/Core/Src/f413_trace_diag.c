@@ -11,7 +11,7 @@
 #define F413_TRACE_DIAG_CSV_MAX_RECORDS (256U)
 #define F413_TRACE_DIAG_SELFTEST_RECORDS (16U)
 #define F413_TRACE_BIN_MAGIC (0x4254464EUL)
-#define F413_TRACE_BIN_VERSION (1UL)
+#define F413_TRACE_BIN_VERSION (2UL)
 
 typedef struct __attribute__((packed)) {
   uint32_t magic;
@@ -22,10 +22,20 @@ typedef struct __attribute__((packed)) {
   uint32_t record_count;
   uint32_t available_count;
   uint32_t payload_checksum;
+  uint32_t payload_bytes; // ログヘッダの後ろに続くブロック像の合計長
 } f413_trace_bin_frame_t;
 
 static f413_trace_diag_config_t s_config;
 
+/* CSV/バイナリダンプは欠落させない: 送信リング満杯時は待ち、終了時に送出完了まで待つ */
+static void f413_trace_diag_run_lossless(void (*dump)(uint32_t), uint32_t max_records)
+{
+  bool prev = trace_set_lossless(true);
+  dump(max_records);
+  (void)trace_flush(NIGHTFALL_TRACE_FLUSH_TIMEOUT_MS);
+  (void)trace_set_lossless(prev);
+}
+
 static const char* f413_trace_diag_unknown_name(uint8_t value)
 {
   (void)value;
@@ -90,28 +100,51 @@ static const char* f413_trace_diag_op_sub_name(uint8_t mode, uint8_t sub)
   return (s_config.op_sub_name != NULL) ? s_config.op_sub_name(mode, sub) : f413_trace_diag_unknown_case_name(mode, sub);
 }
 
+static uint32_t f413_trace_diag_stored(const nvm_trace_log_header_t* header, uint32_t* out_bytes)
+{
+  uint32_t stored = 0U;
+
+  if (out_bytes != NULL)
+  {
+    *out_bytes = 0U;
+  }
+  if (nvm_trace_log_get_stored(header, &stored, out_bytes) != NVM_STATUS_OK)
+  {
+    return 0U;
+  }
+  return stored;
+}
+
 void f413_trace_diag_print_header(const nvm_trace_log_header_t* header)
 {
   uint32_t stored;
+  uint32_t bytes;
+  uint32_t ratio_x100 = 0U;
 
   if (header == NULL)
   {
     return;
   }
 
-  stored = header->total_records;
-  if (stored > header->record_capacity)
+  stored = f413_trace_diag_stored(header, &bytes);
+  if (bytes > 0U)
   {
-    stored = header->record_capacity;
+    // 非圧縮で同じバイト数に入るレコード数との比
+    ratio_x100 = (uint32_t)(((uint64_t)stored * header->record_size * 100U) / bytes);
   }
 
-  trace_printf("[TRACE-LOG] header ver=0x%08lX rec_size=%lu cap=%lu write=%lu total=%lu stored=%lu\r\n",
+  trace_printf("[TRACE-LOG] header ver=0x%08lX rec_size=%lu block=%lux%lu write=%lu total=%lu blocks=%lu stored=%lu bytes=%lu ratio=%lu.%02lu\r\n",
                (unsigned long)header->version,
                (unsigned long)header->record_size,
-               (unsigned long)header->record_capacity,
-               (unsigned long)header->write_index,
+               (unsigned long)header->block_size,
+               (unsigned long)header->block_count,
+               (unsigned long)header->write_block,
                (unsigned long)header->total_records,
-               (unsigned long)stored);
+               (unsigned long)header->total_blocks,
+               (unsigned long)stored,
+               (unsigned long)bytes,
+               (unsigned long)(ratio_x100 / 100U),
+               (unsigned long)(ratio_x100 % 100U));
 }
 
 void f413_trace_diag_run_format_once(void)
@@ -196,11 +229,7 @@ void f413_trace_diag_run_dump_latest_once(void)
 
   f413_trace_diag_print_header(&header);
 
-  available = header.total_records;
-  if (available > header.record_capacity)
-  {
-    available = header.record_capacity;
-  }
+  available = f413_trace_diag_stored(&header, NULL);
   if (available == 0U)
   {
     trace_printf("[TRACE-LOG] dump: no records\r\n");
@@ -271,11 +300,7 @@ static void f413_trace_diag_run_dump_csv_impl(uint32_t max_records)
     return;
   }
 
-  available = header.total_records;
-  if (available > header.record_capacity)
-  {
-    available = header.record_capacity;
-  }
+  available = f413_trace_diag_stored(&header, NULL);
   if (available == 0U)
   {
     trace_printf("[TRACE-LOG] csv: no records\r\n");
@@ -306,7 +331,7 @@ static void f413_trace_diag_run_dump_csv_impl(uint32_t max_records)
   trace_printf("[TRACE-LOG] csv latest %lu/%lu (oldest->newest)\r\n",
                (unsigned long)dump_count,
                (unsigned long)available);
-  trace_printf("#log_format=nightfall_trace_csv_v6\r\n");
+  trace_printf("#log_format=nightfall_trace_csv_v7\r\n");
   trace_printf("#fw_target=%s\r\n", FW_TARGET);
   trace_printf("#fw_version=%s\r\n", FW_VERSION);
   trace_printf("#fw_build_type=%s\r\n", FW_BUILD_TYPE);
@@ -338,18 +363,39 @@ static void f413_trace_diag_run_dump_csv_impl(uint32_t max_records)
   trace_printf("target_omega_mdps,real_omega_mdps,gyro_z_raw_mdps,target_angle_mdeg,accel_forward_mm_s2,");
   trace_printf("encoder_l,encoder_r,motor_out_l,motor_out_r,adc_fr,adc_r,adc_fl,adc_l,adc_vbat,");
   trace_printf("wall_read_fr,wall_read_r,wall_read_fl,wall_read_l,");
-  trace_printf("flags,reserved_i32_0,reserved_i32_1,reserved_i32_2,reserved_i32_3,reserved_u16_0,reserved_u16_1\r\n");
+  trace_printf("flags,reserved_i32_0,reserved_i32_1,reserved_i32_2,reserved_i32_3,reserved_u16_0,reserved_u16_1,");
+  trace_printf("isr_tick_max_us_x10,isr_period_max_us_x10\r\n");
+
+  /* ブロック単位のまとめ読みで古い順にたどる。送信リングは DMA で送出されるので、
+   * 次のブロックを FRAM から読む間も前の行の送信は進む。 */
+  st = nvm_trace_log_stream_open(dump_count, &dump_count);
+  if (st != NVM_STATUS_OK)
+  {
+    trace_printf("[TRACE-LOG] csv: FAIL(open stream NVM=%d)\r\n", (int)st);
+    return;
+  }
 
-  for (i = dump_count; i > 0U; i--)
+  i = 0U;
+  for (;;)
   {
     nvm_trace_log_record_t rec;
 
-    st = nvm_trace_log_read_latest(i - 1U, &rec);
+    st = nvm_trace_log_stream_next(&rec);
+    if (st == NVM_STATUS_NOT_FOUND)
+    {
+      break;
+    }
+    if (st == NVM_STATUS_INTEGRITY_ERROR)
+    {
+      trace_printf("[TRACE-LOG] csv: skip corrupt block at row %lu\r\n", (unsigned long)i);
+      continue;
+    }
     if (st != NVM_STATUS_OK)
     {
       trace_printf("[TRACE-LOG] csv: FAIL(read idx=%lu NVM=%d)\r\n",
-                   (unsigned long)(i - 1U),
+                   (unsigned long)i,
                    (int)st);
+      nvm_trace_log_stream_close();
       return;
     }
 
@@ -378,7 +424,7 @@ static void f413_trace_diag_run_dump_csv_impl(uint32_t max_records)
                  (int)rec.motor_out_l,
                  (int)rec.motor_out_r,
                  (unsigned int)rec.adc_fr);
-    trace_printf("%u,%u,%u,%u,%u,%u,%u,%u,%u,%ld,%ld,%ld,%ld,%u,%u\r\n",
+    trace_printf("%u,%u,%u,%u,%u,%u,%u,%u,%u,%ld,%ld,%ld,%ld,%u,%u,%u,%u\r\n",
                  (unsigned int)rec.adc_r,
                  (unsigned int)rec.adc_fl,
                  (unsigned int)rec.adc_l,
@@ -393,20 +439,24 @@ static void f413_trace_diag_run_dump_csv_impl(uint32_t max_records)
                  (long)rec.reserved_i32_2,
                  (long)rec.reserved_i32_3,
                  (unsigned int)rec.reserved_u16_0,
-                 (unsigned int)rec.reserved_u16_1);
+                 (unsigned int)rec.reserved_u16_1,
+                 (unsigned int)rec.isr_tick_max_us_x10,
+                 (unsigned int)rec.isr_period_max_us_x10);
+    i++;
   }
 
+  nvm_trace_log_stream_close();
   trace_printf("[TRACE-LOG] csv: done\r\n");
 }
 
 void f413_trace_diag_run_dump_csv_once(void)
 {
-  f413_trace_diag_run_dump_csv_impl(F413_TRACE_DIAG_CSV_MAX_RECORDS);
+  f413_trace_diag_run_lossless(f413_trace_diag_run_dump_csv_impl, F413_TRACE_DIAG_CSV_MAX_RECORDS);
 }
 
 void f413_trace_diag_run_dump_csv_all_once(void)
 {
-  f413_trace_diag_run_dump_csv_impl(0U);
+  f413_trace_diag_run_lossless(f413_trace_diag_run_dump_csv_impl, 0U);
 }
 
 static uint32_t f413_trace_bin_checksum_update(uint32_t sum, const void* data, uint32_t len)
@@ -426,14 +476,22 @@ static uint32_t f413_trace_bin_checksum_update(uint32_t sum, const void* data, u
   return sum;
 }
 
+/* 圧縮ブロック像をそのまま送る（復号は tools/logging/trace_bin_dump.py）。
+ * 先頭のブロックは max_records より古いレコードを含むことがあり、record_count 件に揃えるのは復号側。 */
 static void f413_trace_diag_run_dump_bin_impl(uint32_t max_records)
 {
   nvm_trace_log_header_t header;
   f413_trace_bin_frame_t frame;
   nvm_status_t st;
+  const uint8_t* image;
   uint32_t available;
   uint32_t dump_count;
+  uint32_t covered;
+  uint32_t blocks;
+  uint32_t bytes;
   uint32_t checksum;
+  uint32_t len;
+  uint32_t recs;
   uint32_t i;
 
   st = nvm_trace_log_get_header(&header);
@@ -443,11 +501,7 @@ static void f413_trace_diag_run_dump_bin_impl(uint32_t max_records)
     return;
   }
 
-  available = header.total_records;
-  if (available > header.record_capacity)
-  {
-    available = header.record_capacity;
-  }
+  available = f413_trace_diag_stored(&header, NULL);
   if (available == 0U)
   {
     trace_printf("[TRACE-LOG] bin: no records\r\n");
@@ -460,19 +514,57 @@ static void f413_trace_diag_run_dump_bin_impl(uint32_t max_records)
     dump_count = max_records;
   }
 
+  /* 1 周目: 送るブロックの数と長さ・チェックサムを求める。壊れたブロックがあれば
+   * それより新しい側だけを送る（2 周目はその位置から開き直す）。 */
+  st = nvm_trace_log_stream_open(dump_count, &dump_count);
+  if (st != NVM_STATUS_OK)
+  {
+    trace_printf("[TRACE-LOG] bin: FAIL(open stream NVM=%d)\r\n", (int)st);
+    return;
+  }
   checksum = f413_trace_bin_checksum_update(0U, &header, (uint32_t)sizeof(header));
-  for (i = dump_count; i > 0U; i--)
+  covered = 0U;
+  blocks = 0U;
+  bytes = 0U;
+  for (;;)
   {
-    nvm_trace_log_record_t rec;
-    st = nvm_trace_log_read_latest(i - 1U, &rec);
+    st = nvm_trace_log_stream_next_block(&image, &len, &recs);
+    if (st == NVM_STATUS_NOT_FOUND)
+    {
+      break;
+    }
+    if (st == NVM_STATUS_INTEGRITY_ERROR)
+    {
+      trace_printf("[TRACE-LOG] bin: corrupt block after %lu records, dump newer only\r\n",
+                   (unsigned long)covered);
+      checksum = f413_trace_bin_checksum_update(0U, &header, (uint32_t)sizeof(header));
+      covered = 0U;
+      blocks = 0U;
+      bytes = 0U;
+      continue;
+    }
     if (st != NVM_STATUS_OK)
     {
-      trace_printf("[TRACE-LOG] bin: FAIL(read idx=%lu NVM=%d)\r\n",
-                   (unsigned long)(i - 1U),
+      trace_printf("[TRACE-LOG] bin: FAIL(read block=%lu NVM=%d)\r\n",
+                   (unsigned long)blocks,
                    (int)st);
+      nvm_trace_log_stream_close();
       return;
     }
-    checksum = f413_trace_bin_checksum_update(checksum, &rec, (uint32_t)sizeof(rec));
+    checksum = f413_trace_bin_checksum_update(checksum, image, len);
+    covered += recs;
+    bytes += len;
+    blocks++;
+  }
+  if (covered < dump_count)
+  {
+    dump_count = covered;
+  }
+  if (dump_count == 0U)
+  {
+    trace_printf("[TRACE-LOG] bin: no readable records\r\n");
+    nvm_trace_log_stream_close();
+    return;
   }
 
   frame.magic = F413_TRACE_BIN_MAGIC;
@@ -483,37 +575,45 @@ static void f413_trace_diag_run_dump_bin_impl(uint32_t max_records)
   frame.record_count = dump_count;
   frame.available_count = available;
   frame.payload_checksum = checksum;
+  frame.payload_bytes = bytes;
 
-  trace_printf("[TRACE-LOG] bin latest %lu/%lu bytes=%lu\r\n",
+  trace_printf("[TRACE-LOG] bin latest %lu/%lu blocks=%lu bytes=%lu\r\n",
                (unsigned long)dump_count,
                (unsigned long)available,
-               (unsigned long)(sizeof(frame) + sizeof(header) + (dump_count * sizeof(nvm_trace_log_record_t))));
+               (unsigned long)blocks,
+               (unsigned long)(sizeof(frame) + sizeof(header) + bytes));
   trace_write((const char*)&frame, sizeof(frame));
   trace_write((const char*)&header, sizeof(header));
-  for (i = dump_count; i > 0U; i--)
+
+  // 2 周目: 同じブロックを古い順に送る（送信リングの DMA 送出と次の FRAM 読み出しが重なる）
+  st = nvm_trace_log_stream_open(dump_count, NULL);
+  for (i = 0U; (st == NVM_STATUS_OK) && (i < blocks); i++)
   {
-    nvm_trace_log_record_t rec;
-    st = nvm_trace_log_read_latest(i - 1U, &rec);
-    if (st != NVM_STATUS_OK)
+    st = nvm_trace_log_stream_next_block(&image, &len, &recs);
+    if (st == NVM_STATUS_OK)
     {
-      trace_printf("[TRACE-LOG] bin: FAIL(read2 idx=%lu NVM=%d)\r\n",
-                   (unsigned long)(i - 1U),
-                   (int)st);
-      return;
+      trace_write((const char*)image, len);
     }
-    trace_write((const char*)&rec, sizeof(rec));
+  }
+  nvm_trace_log_stream_close();
+  if (st != NVM_STATUS_OK)
+  {
+    trace_printf("\r\n[TRACE-LOG] bin: FAIL(read2 block=%lu NVM=%d)\r\n",
+                 (unsigned long)i,
+                 (int)st);
+    return;
   }
   trace_printf("\r\n[TRACE-LOG] bin: done\r\n");
 }
 
 void f413_trace_diag_run_dump_bin_once(void)
 {
-  f413_trace_diag_run_dump_bin_impl(F413_TRACE_DIAG_CSV_MAX_RECORDS);
+  f413_trace_diag_run_lossless(f413_trace_diag_run_dump_bin_impl, F413_TRACE_DIAG_CSV_MAX_RECORDS);
 }
 
 void f413_trace_diag_run_dump_bin_all_once(void)
 {
-  f413_trace_diag_run_dump_bin_impl(0U);
+  f413_trace_diag_run_lossless(f413_trace_diag_run_dump_bin_impl, 0U);
 }
 
 static void f413_trace_diag_fill_selftest_record(nvm_trace_log_record_t* out, uint32_t seq)
@@ -557,6 +657,8 @@ static void f413_trace_diag_fill_selftest_record(nvm_trace_log_record_t* out, ui
   out->test_id = (uint8_t)'T';
   out->reserved_u16_0 = (uint16_t)(0x5500U | (seq & 0x00FFU));
   out->reserved_u16_1 = (uint16_t)(0x6600U | (seq & 0x00FFU));
+  out->isr_tick_max_us_x10 = (uint16_t)(0x7700U | (seq & 0x00FFU));
+  out->isr_period_max_us_x10 = (uint16_t)(0x8800U | (seq & 0x00FFU));
 }
 
 static uint8_t f413_trace_diag_record_equals(const nvm_trace_log_record_t* lhs,
@@ -1,13 +1,23 @@
 #include "f413_trace_log.h"
 
+#include "f413_telemetry.h"
 #include "f413_trace_flags.h"
+#include "params.h"
 #include "stm32f4xx_hal.h"
 #include "trace.h"
 
+/* 32x32 迷路ではソルバ・探索の作業領域が増えるため、FRAM へ送り出す前の溜めを半分にする */
+#if MAZE_SIZE > 16
+#define F413_TRACE_LOG_AUTO_BUFFER_RECORDS (1024U)
+#else
 #define F413_TRACE_LOG_AUTO_BUFFER_RECORDS (2048U)
+#endif
 #define F413_TRACE_LOG_AUTO_FLUSH_RECORDS_PER_STEP (8U)
 #define F413_TRACE_LOG_AUTO_HEADER_COMMIT_RECORDS (8U)
+#define F413_TRACE_LOG_AUTO_INFLIGHT_RECORDS (8U) // FRAM 書き込みキューに同時に積む記録数
+#define F413_TRACE_LOG_AUTO_TELEMETRY_RECORDS_PER_STEP (32U)
 #define F413_TRACE_LOG_AUTO_FLAG (0x8000U)
+#define F413_TRACE_LOG_AUTO_BARRIER_TIMEOUT_MS (1000U)
 
 static volatile uint8_t g_trace_log_auto_enabled = 0U;
 static uint32_t g_trace_log_auto_period_ms = 1U;
@@ -15,14 +25,16 @@ static volatile uint32_t g_trace_log_auto_seq = 0U;
 static volatile uint16_t g_trace_log_auto_mode_flags = 0U;
 static nvm_trace_log_record_t g_trace_log_auto_buffer[F413_TRACE_LOG_AUTO_BUFFER_RECORDS];
 static volatile uint32_t g_trace_log_auto_buffer_head = 0U;
-static volatile uint32_t g_trace_log_auto_buffer_tail = 0U;
+static volatile uint32_t g_trace_log_auto_buffer_tail = 0U;   // FRAM 書き込み完了済み
+static volatile uint32_t g_trace_log_auto_buffer_issued = 0U; // FRAM 書き込みキューへ投入済み
 static volatile uint8_t g_trace_log_auto_buffer_overflow = 0U;
+static uint32_t g_trace_log_auto_telemetry_next = 0U; // テレメトリへ渡した次の記録（FRAM 側の tail とは独立）
 static nvm_trace_log_header_t g_trace_log_auto_nvm_header;
 static uint8_t g_trace_log_auto_nvm_header_valid = 0U;
 static uint32_t g_trace_log_auto_uncommitted_records = 0U;
-static uint32_t g_trace_log_auto_flushed_records = 0U;
-static uint8_t g_trace_log_auto_nvm_error = 0U;
-static nvm_status_t g_trace_log_auto_nvm_status = NVM_STATUS_OK;
+static volatile uint32_t g_trace_log_auto_flushed_records = 0U;
+static volatile uint8_t g_trace_log_auto_nvm_error = 0U;
+static volatile nvm_status_t g_trace_log_auto_nvm_status = NVM_STATUS_OK;
 static f413_trace_log_fill_control_sample_fn g_fill_control_sample = 0;
 static f413_trace_log_void_callback_t g_update_observe_cache = 0;
 static f413_trace_log_void_callback_t g_reset_observe_state = 0;
@@ -36,6 +48,84 @@ static bool f413_trace_log_auto_defer_nvm_flush(void)
   return (g_trace_log_auto_mode_flags & motor_mask) != 0U;
 }
 
+// 記録の FRAM 書き込み完了（DMA 割り込みから呼ばれる）。完了順は投入順と同じ。
+/* 採取済みの記録をテレメトリへ渡す。FRAM への書き出しは待たせない（遅れたら飛ばす）ので、
+ * 写している間に採取割り込みがスロットを上書きした記録は捨てて先へ進む。 */
+static void f413_trace_log_auto_send_telemetry(uint32_t limit)
+{
+  nvm_trace_log_record_t rec;
+  uint32_t next = g_trace_log_auto_telemetry_next;
+  uint32_t n;
+
+  if (!f413_telemetry_is_enabled())
+  {
+    g_trace_log_auto_telemetry_next = g_trace_log_auto_buffer_head;
+    return;
+  }
+
+  for (n = 0U; n < limit; n++)
+  {
+    if (next == g_trace_log_auto_buffer_head)
+    {
+      break;
+    }
+    rec = g_trace_log_auto_buffer[next % F413_TRACE_LOG_AUTO_BUFFER_RECORDS];
+    if ((g_trace_log_auto_buffer_head - next) >= F413_TRACE_LOG_AUTO_BUFFER_RECORDS)
+    {
+      next = g_trace_log_auto_buffer_head - (F413_TRACE_LOG_AUTO_BUFFER_RECORDS / 2U);
+      continue;
+    }
+    f413_telemetry_send_record(&rec);
+    next++;
+  }
+  g_trace_log_auto_telemetry_next = next;
+}
+
+static void f413_trace_log_auto_record_done(nvm_status_t status, void* ctx)
+{
+  (void)ctx;
+
+  if (status != NVM_STATUS_OK)
+  {
+    g_trace_log_auto_nvm_status = status;
+    g_trace_log_auto_nvm_error = 1U;
+  }
+  else
+  {
+    g_trace_log_auto_flushed_records += 1U;
+  }
+  // 書き込みが終わった slot を tick_sample 側へ返す
+  g_trace_log_auto_buffer_tail += 1U;
+}
+
+// 未投入の記録を 1 件 FRAM 書き込みキューへ積む（完了を待たない）
+static nvm_status_t f413_trace_log_auto_issue_one(void)
+{
+  nvm_trace_log_record_t* rec;
+  nvm_status_t st;
+  uint8_t commit_header;
+
+  rec = &g_trace_log_auto_buffer[g_trace_log_auto_buffer_issued % F413_TRACE_LOG_AUTO_BUFFER_RECORDS];
+  commit_header =
+      (g_trace_log_auto_uncommitted_records + 1U >= F413_TRACE_LOG_AUTO_HEADER_COMMIT_RECORDS) ? 1U : 0U;
+  st = nvm_trace_log_append_cached_async(&g_trace_log_auto_nvm_header, rec, commit_header,
+                                         f413_trace_log_auto_record_done, 0);
+  if (st != NVM_STATUS_OK)
+  {
+    g_trace_log_auto_nvm_status = st;
+    g_trace_log_auto_nvm_error = 1U;
+    return st;
+  }
+
+  g_trace_log_auto_buffer_issued += 1U;
+  g_trace_log_auto_uncommitted_records += 1U;
+  if (commit_header != 0U)
+  {
+    g_trace_log_auto_uncommitted_records = 0U;
+  }
+  return NVM_STATUS_OK;
+}
+
 static nvm_status_t f413_trace_log_auto_flush_buffer(void)
 {
   nvm_status_t st;
@@ -45,27 +135,13 @@ static nvm_status_t f413_trace_log_auto_flush_buffer(void)
     return NVM_STATUS_INTEGRITY_ERROR;
   }
 
-  while (g_trace_log_auto_buffer_tail != g_trace_log_auto_buffer_head)
+  while (g_trace_log_auto_buffer_issued != g_trace_log_auto_buffer_head)
   {
-    nvm_trace_log_record_t* rec =
-        &g_trace_log_auto_buffer[g_trace_log_auto_buffer_tail % F413_TRACE_LOG_AUTO_BUFFER_RECORDS];
-    uint8_t commit_header =
-        (g_trace_log_auto_uncommitted_records + 1U >= F413_TRACE_LOG_AUTO_HEADER_COMMIT_RECORDS) ? 1U : 0U;
-
-    st = nvm_trace_log_append_cached(&g_trace_log_auto_nvm_header, rec, commit_header);
+    st = f413_trace_log_auto_issue_one();
     if (st != NVM_STATUS_OK)
     {
-      g_trace_log_auto_nvm_status = st;
-      g_trace_log_auto_nvm_error = 1U;
       return st;
     }
-    g_trace_log_auto_buffer_tail += 1U;
-    g_trace_log_auto_flushed_records += 1U;
-    g_trace_log_auto_uncommitted_records += 1U;
-    if (commit_header != 0U)
-    {
-      g_trace_log_auto_uncommitted_records = 0U;
-    }
   }
 
   if (g_trace_log_auto_uncommitted_records != 0U)
@@ -79,16 +155,25 @@ static nvm_status_t f413_trace_log_auto_flush_buffer(void)
     }
     g_trace_log_auto_uncommitted_records = 0U;
   }
+
+  // 同期のヘッダ書き込みは投入順に処理されるため、ここまでで先の記録も書き終わっている
+  st = nvm_write_barrier(F413_TRACE_LOG_AUTO_BARRIER_TIMEOUT_MS);
+  if (st != NVM_STATUS_OK)
+  {
+    g_trace_log_auto_nvm_status = st;
+    g_trace_log_auto_nvm_error = 1U;
+    return st;
+  }
+  if (g_trace_log_auto_nvm_error != 0U)
+  {
+    return g_trace_log_auto_nvm_status;
+  }
   return NVM_STATUS_OK;
 }
 
 static nvm_status_t f413_trace_log_auto_flush_step(void)
 {
-  nvm_trace_log_record_t* rec;
-  nvm_status_t st;
-  uint8_t commit_header;
-
-  if (g_trace_log_auto_buffer_tail == g_trace_log_auto_buffer_head)
+  if (g_trace_log_auto_buffer_issued == g_trace_log_auto_buffer_head)
   {
     return NVM_STATUS_OK;
   }
@@ -98,26 +183,13 @@ static nvm_status_t f413_trace_log_auto_flush_step(void)
     g_trace_log_auto_nvm_error = 1U;
     return NVM_STATUS_INTEGRITY_ERROR;
   }
-
-  rec = &g_trace_log_auto_buffer[g_trace_log_auto_buffer_tail % F413_TRACE_LOG_AUTO_BUFFER_RECORDS];
-  commit_header =
-      (g_trace_log_auto_uncommitted_records + 1U >= F413_TRACE_LOG_AUTO_HEADER_COMMIT_RECORDS) ? 1U : 0U;
-  st = nvm_trace_log_append_cached(&g_trace_log_auto_nvm_header, rec, commit_header);
-  if (st != NVM_STATUS_OK)
+  if ((g_trace_log_auto_buffer_issued - g_trace_log_auto_buffer_tail) >= F413_TRACE_LOG_AUTO_INFLIGHT_RECORDS)
   {
-    g_trace_log_auto_nvm_status = st;
-    g_trace_log_auto_nvm_error = 1U;
-    return st;
+    // 送出待ちが多いときはキューが空くのを待たずに次の step へ回す
+    return NVM_STATUS_BUSY;
   }
 
-  g_trace_log_auto_buffer_tail += 1U;
-  g_trace_log_auto_flushed_records += 1U;
-  g_trace_log_auto_uncommitted_records += 1U;
-  if (commit_header != 0U)
-  {
-    g_trace_log_auto_uncommitted_records = 0U;
-  }
-  return NVM_STATUS_OK;
+  return f413_trace_log_auto_issue_one();
 }
 
 void f413_trace_log_config(f413_trace_log_fill_control_sample_fn fill_control_sample,
@@ -178,7 +250,9 @@ void f413_trace_log_auto_start(void)
   g_trace_log_auto_mode_flags = 0U;
   g_trace_log_auto_buffer_head = 0U;
   g_trace_log_auto_buffer_tail = 0U;
+  g_trace_log_auto_buffer_issued = 0U;
   g_trace_log_auto_buffer_overflow = 0U;
+  g_trace_log_auto_telemetry_next = 0U;
   g_trace_log_auto_nvm_header_valid = 1U;
   g_trace_log_auto_uncommitted_records = 0U;
   g_trace_log_auto_flushed_records = 0U;
@@ -193,9 +267,10 @@ void f413_trace_log_auto_start(void)
     g_update_observe_cache();
   }
   g_trace_log_auto_enabled = 1U;
-  trace_printf("[TRACE-LOG] auto: START period=%lu ms cap=%lu rec (streaming FRAM)\r\n",
+  trace_printf("[TRACE-LOG] auto: START period=%lu ms blocks=%lux%lu B (streaming FRAM, delta)\r\n",
                (unsigned long)g_trace_log_auto_period_ms,
-               (unsigned long)g_trace_log_auto_nvm_header.record_capacity);
+               (unsigned long)g_trace_log_auto_nvm_header.block_count,
+               (unsigned long)g_trace_log_auto_nvm_header.block_size);
 }
 
 void f413_trace_log_auto_stop(void)
@@ -204,6 +279,7 @@ void f413_trace_log_auto_stop(void)
   nvm_status_t st;
   uint32_t buffered;
   uint32_t flushed;
+  uint32_t stored = 0U;
   uint8_t overflow;
   uint8_t nvm_error;
 
@@ -220,6 +296,9 @@ void f413_trace_log_auto_stop(void)
   nvm_error = g_trace_log_auto_nvm_error;
   g_trace_log_auto_mode_flags = 0U;
 
+  f413_trace_log_auto_send_telemetry(F413_TRACE_LOG_AUTO_BUFFER_RECORDS);
+  f413_telemetry_flush();
+
   st = f413_trace_log_auto_flush_buffer();
   if (st != NVM_STATUS_OK)
   {
@@ -237,9 +316,10 @@ void f413_trace_log_auto_stop(void)
     return;
   }
 
+  (void)nvm_trace_log_get_stored(&header, &stored, NULL);
   trace_printf("[TRACE-LOG] auto: STOP total=%lu stored=%lu pending_start=%lu flushed_start=%lu flushed_total=%lu overflow=%u nvm_error=%u\r\n",
                (unsigned long)header.total_records,
-               (unsigned long)((header.total_records > header.record_capacity) ? header.record_capacity : header.total_records),
+               (unsigned long)stored,
                (unsigned long)buffered,
                (unsigned long)flushed,
                (unsigned long)g_trace_log_auto_flushed_records,
@@ -278,6 +358,9 @@ void f413_trace_log_auto_step(void)
     g_update_observe_cache();
   }
 
+  // テレメトリは走行中も流す（UART DMA なので SPI2 の時間割とは関係しない）
+  f413_trace_log_auto_send_telemetry(F413_TRACE_LOG_AUTO_TELEMETRY_RECORDS_PER_STEP);
+
   if (f413_trace_log_auto_defer_nvm_flush())
   {
     return;
@@ -287,7 +370,7 @@ void f413_trace_log_auto_step(void)
   {
     for (i = 0U; i < F413_TRACE_LOG_AUTO_FLUSH_RECORDS_PER_STEP; i++)
     {
-      if (g_trace_log_auto_buffer_tail == g_trace_log_auto_buffer_head)
+      if (g_trace_log_auto_buffer_issued == g_trace_log_auto_buffer_head)
       {
         break;
       }
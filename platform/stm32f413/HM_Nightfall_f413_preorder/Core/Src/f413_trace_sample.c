@@ -10,6 +10,7 @@
 #include "f413_trace_flags.h"
 #include "f413_trace_log.h"
 #include "f413_wall_runtime.h"
+#include "isr_prof.h"
 #include "params.h"
 #include "trace.h"
 
@@ -231,7 +232,7 @@ void f413_trace_sample_emit_extra_csv_meta(void)
                (double)FF_TRANSLATION_VELOCITY_PWM_FAN_OFF);
   trace_printf("#translation_ff_accel_pwm_fan_off=%.9f\r\n",
                (double)FF_TRANSLATION_ACCEL_PWM_FAN_OFF);
-  trace_printf("#search_step_context=op_mode1_case1_to_8:op_sub=(y<<4)|x,test_id=0x80|(next_rel<<2)|dir\r\n");
+  trace_printf("#search_step_context=op_mode1_case1_to_8:op_sub=((y&15)<<4)|(x&15),test_id=0x80|((y>>4)<<5)|((x>>4)<<4)|(next_rel<<2)|dir\r\n");
   trace_printf("#search_event_wall_read=wall_read_fr,wall_read_r,wall_read_fl,wall_read_l are latest wall-snapshot deltas used for search map update; adc_fr/r/fl/l remain event-time snapshot deltas\r\n");
 #if (NIGHTFALL_F413_DISABLE_WALL_TRACE_OBSERVE == 0U)
   trace_printf("#wall_trace_observe=%u\r\n", (unsigned int)F413_WALL_RUNTIME_TRACE_VERSION);
@@ -349,6 +350,9 @@ void f413_trace_sample_fill_control(nvm_trace_log_record_t* out,
   out->reserved_u16_0 = g_reserved_u16_0;
   out->reserved_u16_1 = g_reserved_u16_1;
   (void)f413_wall_runtime_fill_snapshot_fields(out, mode_flags);
+  /* 制御 tick と同じ TIM5 割り込みから呼ばれるので、区間最大をここで取り出して消去できる */
+  out->isr_tick_max_us_x10 = isr_prof_cycles_to_us_x10(isr_prof_take_window_max(ISR_PROF_CTRL_TICK));
+  out->isr_period_max_us_x10 = isr_prof_cycles_to_us_x10(isr_prof_take_window_max(ISR_PROF_CTRL_PERIOD));
   if ((mode_flags & NIGHTFALL_F413_TRACE_MODE_TUNE_FLAG) != 0U)
   {
     f413_trace_sample_fill_tune_fields(out);
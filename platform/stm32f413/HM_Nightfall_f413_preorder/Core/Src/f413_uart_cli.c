@@ -6,7 +6,10 @@
 #include "f413_imu_diag.h"
 #include "f413_nvm_diag.h"
 #include "f413_op_ui.h"
+#include "f413_param_table.h"
+#include "f413_prof_diag.h"
 #include "f413_search_step.h"
+#include "f413_telemetry.h"
 #include "f413_test_run.h"
 #include "f413_trace_diag.h"
 #include "f413_trace_sample.h"
@@ -31,6 +34,9 @@ void f413_uart_cli_print_help(void)
   trace_printf("[NVM-TEST] commands: h=help, a=save+load all, A=load-only all\r\n");
   trace_printf("[NVM-TEST] d/s/m/t=save+load, D/S/M/T=load-only verify\r\n");
   trace_printf("[TRACE-LOG] q=format, r=append sample, R=dump latest, v/V=dump csv(256/all), </>=dump bin(256/all), k=selftest, u=run-start hook, U=run-stop hook\r\n");
+  trace_printf("[TELEMETRY] ~=live telemetry on/off (binary, during auto trace), +=next preset run/motion/wall/all\r\n");
+  trace_printf("[PARAM]    :=parameter line mode (list/diff/get/set/save/load/reset, q or ESC to leave)\r\n");
+  trace_printf("[PROF]     n=ISR timing (min/mean/max/hist per section) + SPI2 bus stats, '='=reset\r\n");
   trace_printf("[RUN-TEST]  x=idle-run-session(1000ms), y=motor-run-session(short), z=search-entry(solver/fallback), j=shortest-entry(solver/fallback)\r\n");
   trace_printf("[HW-TEST]  w=wall, W=wall-end, O=search-map, G=search-preview, B=search-reset, N=search-step, [/]/@=state/clear/dump, p=switch, i=imu, I=imu-angle, c=imu-accel, b=buzzer, o/0=motor, e=encoder, l=led30s, g=smoke+trace\r\n");
   trace_printf("[TEST]     1=S3straight, 2=S6straight, 3=R90turn, 4=L90turn, 5=S3+R90+S3, F=arm for button; OP mode9/case0/sub0-9=control tune\r\n");
@@ -51,6 +57,12 @@ static void f413_uart_cli_run_tune_sub(uint8_t sub)
 
 void f413_uart_cli_handle_command(uint8_t cmd)
 {
+  if (f413_param_table_cli_active())
+  {
+    f413_param_table_cli_feed(cmd);
+    return;
+  }
+
   switch (cmd)
   {
     case 'h':
@@ -59,6 +71,10 @@ void f413_uart_cli_handle_command(uint8_t cmd)
       f413_uart_cli_print_help();
       break;
 
+    case ':':
+      f413_param_table_cli_begin();
+      break;
+
     case 'a':
       trace_printf("[NVM-TEST] run all\r\n");
       f413_nvm_diag_run_all_tests();
@@ -275,6 +291,22 @@ void f413_uart_cli_handle_command(uint8_t cmd)
       }
       break;
 
+    case '~':
+      f413_telemetry_toggle();
+      break;
+
+    case '+':
+      f413_telemetry_next_preset();
+      break;
+
+    case 'n':
+      f413_prof_diag_run_dump_once();
+      break;
+
+    case '=':
+      f413_prof_diag_run_reset_once();
+      break;
+
     case 'l':
     case 'L':
       f413_hw_diag_run_led_test_once();
@@ -350,10 +350,10 @@ static void f413_wall_runtime_control_update(const f413_wall_sensor_snapshot_t*
   }
 
   right_wall = f413_wall_runtime_control_wall_present(wall->r_delta,
-                                                      WALL_BASE_R,
+                                                      g_f413_wall_threshold.r,
                                                       g_wall_end.deriv_r);
   left_wall = f413_wall_runtime_control_wall_present(wall->l_delta,
-                                                     WALL_BASE_L,
+                                                     g_f413_wall_threshold.l,
                                                      g_wall_end.deriv_l);
 
   if (right_wall && left_wall)
@@ -558,7 +558,7 @@ bool f413_wall_runtime_front_wall_reached(float ad_sum_threshold)
   }
   if (ad_sum_threshold <= 0.0f)
   {
-    threshold = WALL_BASE_FR + WALL_BASE_FL;
+    threshold = (int32_t)g_f413_wall_threshold.fr + (int32_t)g_f413_wall_threshold.fl;
   }
   else
   {
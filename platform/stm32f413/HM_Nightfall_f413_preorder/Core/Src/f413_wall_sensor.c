@@ -37,6 +37,7 @@ static volatile uint16_t g_wall_offset_fr = 0U;
 static volatile uint16_t g_wall_offset_fl = 0U;
 static volatile uint16_t g_wall_base_l = WALL_CTRL_BASE_L;
 static volatile uint16_t g_wall_base_r = WALL_CTRL_BASE_R;
+f413_wall_sensor_threshold_t g_f413_wall_threshold = {WALL_BASE_FR, WALL_BASE_FL, WALL_BASE_R, WALL_BASE_L};
 static volatile uint16_t g_wall_base_f = 0U;
 
 static uint16_t f413_wall_sensor_subtract_u16(uint16_t on, uint16_t off, uint16_t offset)
@@ -215,9 +216,10 @@ bool f413_wall_sensor_read_snapshot(f413_wall_sensor_snapshot_t* out)
   out->r_delta = (int32_t)g_wall_adc_r;
   out->fl_delta = (int32_t)g_wall_adc_fl;
   out->l_delta = (int32_t)g_wall_adc_l;
-  out->front_wall = (out->fr_delta > WALL_BASE_FR) || (out->fl_delta > WALL_BASE_FL);
-  out->right_wall = out->r_delta > WALL_BASE_R;
-  out->left_wall = out->l_delta > WALL_BASE_L;
+  out->front_wall = (out->fr_delta > g_f413_wall_threshold.fr) ||
+                    (out->fl_delta > g_f413_wall_threshold.fl);
+  out->right_wall = out->r_delta > g_f413_wall_threshold.r;
+  out->left_wall = out->l_delta > g_f413_wall_threshold.l;
   out->saturated = (out->fr_on >= F413_WALL_SENSOR_SAT_ADC) ||
                    (out->r_on >= F413_WALL_SENSOR_SAT_ADC) ||
                    (out->fl_on >= F413_WALL_SENSOR_SAT_ADC) ||
@@ -39,7 +39,9 @@
 #include "f413_mode_shortest.h"
 #include "f413_nvm_diag.h"
 #include "f413_op_ui.h"
+#include "f413_param_table.h"
 #include "f413_path_run.h"
+#include "f413_prof_diag.h"
 #include "f413_run_features.h"
 #include "f413_run_session.h"
 #include "f413_search_step.h"
@@ -55,6 +57,7 @@
 #include "solver.h"
 #include "search.h"
 #include "trace.h"
+#include "isr_prof.h"
 
 /* USER CODE END Includes */
 
@@ -378,10 +381,10 @@ static void nightfall_run_wall_sensor_test_once(void)
                (unsigned int)wall.right_wall,
                (unsigned int)wall.left_wall,
                (unsigned int)wall.saturated,
-               (unsigned int)WALL_BASE_FR,
-               (unsigned int)WALL_BASE_FL,
-               (unsigned int)WALL_BASE_R,
-               (unsigned int)WALL_BASE_L);
+               (unsigned int)g_f413_wall_threshold.fr,
+               (unsigned int)g_f413_wall_threshold.fl,
+               (unsigned int)g_f413_wall_threshold.r,
+               (unsigned int)g_f413_wall_threshold.l);
   trace_printf("[HW-TEST][Wall] PASS(measure done)\r\n");
 }
 
@@ -422,10 +425,10 @@ static void nightfall_run_wall_sensor_monitor_once(void)
                (unsigned int)base_f,
                (unsigned int)WALL_CTRL_BASE_L,
                (unsigned int)WALL_CTRL_BASE_R,
-               (unsigned int)WALL_BASE_FR,
-               (unsigned int)WALL_BASE_FL,
-               (unsigned int)WALL_BASE_R,
-               (unsigned int)WALL_BASE_L);
+               (unsigned int)g_f413_wall_threshold.fr,
+               (unsigned int)g_f413_wall_threshold.fl,
+               (unsigned int)g_f413_wall_threshold.r,
+               (unsigned int)g_f413_wall_threshold.l);
 
   while (!nightfall_run_stop_switch_pressed())
   {
@@ -974,6 +977,7 @@ int main(void)
   /* USER CODE BEGIN 2 */
 
   trace_init();
+  f413_prof_diag_init();
   f413_run_features_reset();
   {
     const f413_trace_sample_config_t trace_sample_config = {
@@ -1175,6 +1179,7 @@ int main(void)
     trace_printf("[WALL] FAIL(start async ADC DMA sensor scheduler)\r\n");
   }
 
+  f413_param_table_init();
   f413_ctrl_init();
   trace_printf("[CTRL] 1kHz velocity control initialized\r\n");
   nightfall_op_led_show_mode(f413_op_ui_get_mode());
@@ -1954,20 +1959,31 @@ void Error_Handler(void)
 /* ---------- TIM 割り込みコールバック ---------- */
 void HAL_TIM_PeriodElapsedCallback(TIM_HandleTypeDef *htim)
 {
+  uint32_t prof_t;
+
   if (htim->Instance == TIM5)
   {
+    isr_prof_mark_period(ISR_PROF_CTRL_PERIOD);
+    prof_t = isr_prof_begin();
     f413_ctrl_tick();
+    prof_t = isr_prof_end(ISR_PROF_CTRL_TICK, prof_t);
     nightfall_trace_log_auto_tick_sample();
+    (void)isr_prof_end(ISR_PROF_TRACE_SAMPLE, prof_t);
   }
   else if (htim->Instance == TIM6)
   {
+    prof_t = isr_prof_begin();
     nightfall_wall_sensor_tim6_tick();
+    (void)isr_prof_end(ISR_PROF_WALL_SCHED, prof_t);
   }
 }
 
 void HAL_ADC_ConvCpltCallback(ADC_HandleTypeDef* hadc)
 {
+  uint32_t prof_t = isr_prof_begin();
+
   f413_wall_sensor_adc_complete(hadc);
+  (void)isr_prof_end(ISR_PROF_WALL_UPDATE, prof_t);
 }
 
 #ifdef USE_FULL_ASSERT
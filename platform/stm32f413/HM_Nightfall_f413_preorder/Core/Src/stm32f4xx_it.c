@@ -22,6 +22,9 @@
 #include "stm32f4xx_it.h"
 /* Private includes ----------------------------------------------------------*/
 /* USER CODE BEGIN Includes */
+#include "trace.h"
+#include "f413_control.h"
+#include "nvm.h"
 /* USER CODE END Includes */
 
 /* Private typedef -----------------------------------------------------------*/
@@ -258,5 +261,28 @@ void DMA2_Stream0_IRQHandler(void)
 }
 
 /* USER CODE BEGIN 1 */
+/**
+  * @brief This function handles DMA2 stream7 global interrupt (USART1 TX trace).
+  */
+void DMA2_Stream7_IRQHandler(void)
+{
+  trace_uart_tx_dma_irq_handler();
+}
+
+/**
+  * @brief This function handles DMA1 stream3 global interrupt (SPI2 RX, IMU burst).
+  */
+void DMA1_Stream3_IRQHandler(void)
+{
+  f413_ctrl_imu_dma_irq_handler();
+}
+
+/**
+  * @brief This function handles DMA1 stream4 global interrupt (SPI2 TX, FRAM write queue).
+  */
+void DMA1_Stream4_IRQHandler(void)
+{
+  nvm_fram_dma_irq_handler();
+}
 
 /* USER CODE END 1 */
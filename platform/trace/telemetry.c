@@ -0,0 +1,244 @@
+#include "telemetry.h"
+
+#include <string.h>
+
+static const uint8_t k_telemetry_presets[TELEMETRY_PRESET_COUNT][TELEMETRY_GROUP_COUNT] = {
+    [TELEMETRY_PRESET_RUN] = {1U, 2U, 10U, 0U, 10U},
+    [TELEMETRY_PRESET_MOTION] = {1U, 0U, 0U, 0U, 0U},
+    [TELEMETRY_PRESET_WALL] = {5U, 0U, 1U, 1U, 0U},
+    [TELEMETRY_PRESET_ALL] = {1U, 1U, 1U, 1U, 1U},
+};
+
+static const char* const k_telemetry_preset_names[TELEMETRY_PRESET_COUNT] = {
+    [TELEMETRY_PRESET_RUN] = "run",
+    [TELEMETRY_PRESET_MOTION] = "motion",
+    [TELEMETRY_PRESET_WALL] = "wall",
+    [TELEMETRY_PRESET_ALL] = "all",
+};
+
+// グループの値を src から dst へ写す（seq / timestamp_ms / flags / op_* はどのグループにも属さない）
+static void telemetry_copy_group(nvm_trace_log_record_t* dst,
+                                 const nvm_trace_log_record_t* src,
+                                 uint32_t group) {
+    switch (group) {
+        case TELEMETRY_GROUP_MOTION:
+            dst->target_distance_x1000 = src->target_distance_x1000;
+            dst->distance_mm = src->distance_mm;
+            dst->angle_mdeg = src->angle_mdeg;
+            dst->target_velocity_mm_s = src->target_velocity_mm_s;
+            dst->real_velocity_mm_s = src->real_velocity_mm_s;
+            dst->target_omega_mdps = src->target_omega_mdps;
+            dst->real_omega_mdps = src->real_omega_mdps;
+            dst->target_angle_mdeg = src->target_angle_mdeg;
+            break;
+        case TELEMETRY_GROUP_DRIVE:
+            dst->accel_velocity_mm_s = src->accel_velocity_mm_s;
+            dst->gyro_z_raw_mdps = src->gyro_z_raw_mdps;
+            dst->accel_forward_mm_s2 = src->accel_forward_mm_s2;
+            dst->encoder_l = src->encoder_l;
+            dst->encoder_r = src->encoder_r;
+            dst->motor_out_l = src->motor_out_l;
+            dst->motor_out_r = src->motor_out_r;
+            break;
+        case TELEMETRY_GROUP_WALL:
+            dst->adc_fr = src->adc_fr;
+            dst->adc_r = src->adc_r;
+            dst->adc_fl = src->adc_fl;
+            dst->adc_l = src->adc_l;
+            dst->adc_vbat = src->adc_vbat;
+            dst->wall_read_fr = src->wall_read_fr;
+            dst->wall_read_r = src->wall_read_r;
+            dst->wall_read_fl = src->wall_read_fl;
+            dst->wall_read_l = src->wall_read_l;
+            break;
+        case TELEMETRY_GROUP_OBSERVE:
+            dst->reserved_i32_0 = src->reserved_i32_0;
+            dst->reserved_i32_1 = src->reserved_i32_1;
+            dst->reserved_i32_2 = src->reserved_i32_2;
+            dst->reserved_i32_3 = src->reserved_i32_3;
+            dst->reserved_u16_0 = src->reserved_u16_0;
+            dst->reserved_u16_1 = src->reserved_u16_1;
+            break;
+        case TELEMETRY_GROUP_TIMING:
+            dst->isr_tick_max_us_x10 = src->isr_tick_max_us_x10;
+            dst->isr_period_max_us_x10 = src->isr_period_max_us_x10;
+            break;
+        default:
+            break;
+    }
+}
+
+static void telemetry_put_u16(uint8_t* p, uint16_t v) {
+    p[0] = (uint8_t)(v & 0xFFU);
+    p[1] = (uint8_t)(v >> 8);
+}
+
+static void telemetry_begin(telemetry_t* t) {
+    memcpy(t->active, t->decimation, sizeof(t->active));
+    t->count = 0U;
+    t->used = TELEMETRY_HEADER_BYTES + TELEMETRY_TRACE_PAYLOAD_HEADER_BYTES;
+    nvm_trace_codec_reset(&t->codec);
+}
+
+// 間引きを当てて組み立て中のパケットに追記する（収まらなければ false で何も変えない）
+static bool telemetry_append(telemetry_t* t, const nvm_trace_log_record_t* rec) {
+    static const nvm_trace_log_record_t k_zero;
+    nvm_trace_log_record_t sent = *rec;
+    uint32_t len;
+    uint32_t g;
+
+    for (g = 0U; g < (uint32_t)TELEMETRY_GROUP_COUNT; ++g) {
+        if (t->active[g] == 0U) {
+            telemetry_copy_group(&sent, &k_zero, g);
+            continue;
+        }
+        if ((rec->seq % t->active[g]) == 0U) {
+            telemetry_copy_group(&t->held, rec, g);
+        }
+        telemetry_copy_group(&sent, &t->held, g);
+    }
+
+    len = nvm_trace_codec_encode(&t->codec,
+                                 &sent,
+                                 &t->packet[t->used],
+                                 TELEMETRY_HEADER_BYTES + TELEMETRY_PAYLOAD_MAX - t->used);
+    if (len == 0U) {
+        return false;
+    }
+    t->used += len;
+    t->count++;
+    t->next_record_seq = rec->seq + 1U;
+    return true;
+}
+
+static void telemetry_close(telemetry_t* t, const uint8_t** out_packet, uint32_t* out_len) {
+    uint32_t payload = t->used - TELEMETRY_HEADER_BYTES;
+    uint16_t crc;
+
+    t->packet[0] = TELEMETRY_SYNC0;
+    t->packet[1] = TELEMETRY_SYNC1;
+    t->packet[2] = (uint8_t)TELEMETRY_CH_TRACE;
+    t->packet[3] = 0U;
+    telemetry_put_u16(&t->packet[4], (uint16_t)payload);
+    telemetry_put_u16(&t->packet[6], t->seq);
+    t->packet[TELEMETRY_HEADER_BYTES] = t->count;
+    memcpy(&t->packet[TELEMETRY_HEADER_BYTES + 1U], t->active, sizeof(t->active));
+    crc = telemetry_crc16(&t->packet[2], t->used - 2U);
+    telemetry_put_u16(&t->packet[t->used], crc);
+
+    t->seq++;
+    t->closed = true;
+    t->stats.packets++;
+    t->stats.records += t->count;
+    t->stats.bytes += t->used + TELEMETRY_CRC_BYTES;
+    *out_packet = t->packet;
+    *out_len = t->used + TELEMETRY_CRC_BYTES;
+}
+
+// 送り出したパケットの後始末（回した記録があれば新しいパケットの先頭に入れる）
+static void telemetry_reopen(telemetry_t* t) {
+    if (!t->closed) {
+        return;
+    }
+    t->closed = false;
+    telemetry_begin(t);
+    if (t->has_pending) {
+        t->has_pending = false;
+        (void)telemetry_append(t, &t->pending);
+    }
+}
+
+void telemetry_init(telemetry_t* t, uint8_t batch) {
+    memset(t, 0, sizeof(*t));
+    if (batch == 0U) {
+        batch = 1U;
+    }
+    t->batch = (batch > TELEMETRY_BATCH_MAX) ? (uint8_t)TELEMETRY_BATCH_MAX : batch;
+    telemetry_begin(t);
+}
+
+void telemetry_set_decimation(telemetry_t* t, telemetry_group_t group, uint8_t decimation) {
+    if ((uint32_t)group >= (uint32_t)TELEMETRY_GROUP_COUNT) {
+        return;
+    }
+    t->decimation[group] = decimation;
+    if (t->count == 0U) {
+        t->active[group] = decimation;
+    }
+}
+
+void telemetry_apply_preset(telemetry_t* t, telemetry_preset_t preset) {
+    uint32_t g;
+
+    if ((uint32_t)preset >= (uint32_t)TELEMETRY_PRESET_COUNT) {
+        return;
+    }
+    for (g = 0U; g < (uint32_t)TELEMETRY_GROUP_COUNT; ++g) {
+        telemetry_set_decimation(t, (telemetry_group_t)g, k_telemetry_presets[preset][g]);
+    }
+}
+
+const char* telemetry_preset_name(telemetry_preset_t preset) {
+    if ((uint32_t)preset >= (uint32_t)TELEMETRY_PRESET_COUNT) {
+        return "?";
+    }
+    return k_telemetry_preset_names[preset];
+}
+
+bool telemetry_push(telemetry_t* t,
+                    const nvm_trace_log_record_t* rec,
+                    const uint8_t** out_packet,
+                    uint32_t* out_len) {
+    telemetry_reopen(t);
+
+    if ((t->count != 0U) && (rec->seq != t->next_record_seq)) {
+        t->stats.gaps++;
+        t->pending = *rec;
+        t->has_pending = true;
+        telemetry_close(t, out_packet, out_len);
+        return true;
+    }
+    if (t->count >= t->batch) {
+        // 回した記録だけで埋まった（batch = 1）
+        t->pending = *rec;
+        t->has_pending = true;
+        telemetry_close(t, out_packet, out_len);
+        return true;
+    }
+    if (!telemetry_append(t, rec)) {
+        // 空のパケットには必ず収まる（キーフレームでも NVM_TRACE_CODEC_RECORD_MAX_BYTES 以下）
+        t->stats.full++;
+        t->pending = *rec;
+        t->has_pending = true;
+        telemetry_close(t, out_packet, out_len);
+        return true;
+    }
+    if (t->count >= t->batch) {
+        telemetry_close(t, out_packet, out_len);
+        return true;
+    }
+    return false;
+}
+
+bool telemetry_flush(telemetry_t* t, const uint8_t** out_packet, uint32_t* out_len) {
+    telemetry_reopen(t);
+    if (t->count == 0U) {
+        return false;
+    }
+    telemetry_close(t, out_packet, out_len);
+    return true;
+}
+
+uint16_t telemetry_crc16(const uint8_t* data, uint32_t len) {
+    uint16_t crc = 0xFFFFU;
+    uint32_t i;
+    uint32_t b;
+
+    for (i = 0U; i < len; ++i) {
+        crc ^= (uint16_t)((uint16_t)data[i] << 8);
+        for (b = 0U; b < 8U; ++b) {
+            crc = ((crc & 0x8000U) != 0U) ? (uint16_t)((crc << 1) ^ 0x1021U) : (uint16_t)(crc << 1);
+        }
+    }
+    return crc;
+}
@@ -0,0 +1,112 @@
+#ifndef NIGHTFALL_TELEMETRY_H_
+#define NIGHTFALL_TELEMETRY_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "nvm_trace_codec.h"
+#include "nvm_trace_log.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * 走行中のライブテレメトリ（HAL 非依存。F413 の f413_telemetry.c と tests のホスト試験から利用）
+ *
+ * 制御 tick の記録（nvm_trace_log_record_t）を batch 件ずつまとめ、FRAM のトレースログと同じ
+ * 差分符号化（nvm_trace_codec.c。パケット先頭がキーフレーム）で 1 パケットにして UART へ流す。
+ * パケットは単独で復号できるので、欠落・破損はそのパケットの分だけで済む。
+ *
+ * パケット: sync 0xA5 0x5A | channel u8 | reserved u8 | len u16 | seq u16 | payload[len] | crc16 u16
+ *   - crc16 は CRC-16/CCITT-FALSE（channel から payload の末尾まで）
+ *   - seq はパケットの通し番号（受信側で欠落を数える）
+ * TELEMETRY_CH_TRACE の payload: count u8 | decimation[TELEMETRY_GROUP_COUNT] u8 | 符号化レコード × count
+ *
+ * 記録のフィールドはグループ（運動・駆動・壁センサ・観測・タイミング）ごとに間引き数を持つ。
+ * 間引き中のフィールドは直前に送った値のまま、0 のグループは 0 にしてから符号化するため、
+ * 変化しないフィールドとしてほとんど帯域を使わない。seq / timestamp_ms / flags / op_* は常に送る。
+ * 受信側は tools/logging/telemetry_decode.py（グループの並びはそちらの TELEMETRY_GROUPS と一致させる）。
+ */
+
+#define TELEMETRY_SYNC0 (0xA5U)
+#define TELEMETRY_SYNC1 (0x5AU)
+#define TELEMETRY_HEADER_BYTES (8U)
+#define TELEMETRY_CRC_BYTES (2U)
+#define TELEMETRY_BATCH_MAX (16U)
+#define TELEMETRY_PAYLOAD_MAX (1024U) // 収まらない記録は次のパケットへ回す
+
+typedef enum {
+    TELEMETRY_CH_TRACE = 1, // 制御 tick の記録のまとまり
+} telemetry_channel_t;
+
+typedef enum {
+    TELEMETRY_GROUP_MOTION = 0, // 距離・角度・速度・角速度の目標と実測
+    TELEMETRY_GROUP_DRIVE,      // エンコーダ・モータ出力・加速度・ジャイロ生値
+    TELEMETRY_GROUP_WALL,       // 壁センサ・電池電圧
+    TELEMETRY_GROUP_OBSERVE,    // reserved（壁観測などの付加情報）
+    TELEMETRY_GROUP_TIMING,     // 制御 tick の所要時間・起動間隔
+    TELEMETRY_GROUP_COUNT
+} telemetry_group_t;
+
+// 間引き数の組（f413_telemetry.c の UART コマンドで切り替える）
+typedef enum {
+    TELEMETRY_PRESET_RUN = 0, // 運動 1 / 駆動 2 / 壁センサ 10 / タイミング 10（既定）
+    TELEMETRY_PRESET_MOTION,  // 運動だけ毎 tick
+    TELEMETRY_PRESET_WALL,    // 壁センサ・観測を毎 tick、運動 5
+    TELEMETRY_PRESET_ALL,     // 全フィールド毎 tick
+    TELEMETRY_PRESET_COUNT
+} telemetry_preset_t;
+
+#define TELEMETRY_TRACE_PAYLOAD_HEADER_BYTES (1U + TELEMETRY_GROUP_COUNT)
+#define TELEMETRY_PACKET_MAX (TELEMETRY_HEADER_BYTES + TELEMETRY_PAYLOAD_MAX + TELEMETRY_CRC_BYTES)
+
+typedef struct {
+    uint32_t packets;
+    uint32_t records;
+    uint32_t bytes;
+    uint32_t gaps; // 記録の seq が飛んで途中で閉じたパケット
+    uint32_t full; // payload に収まらず途中で閉じたパケット
+} telemetry_stats_t;
+
+typedef struct {
+    uint8_t decimation[TELEMETRY_GROUP_COUNT]; // 0 = 送らない、n = 記録の seq が n の倍数のときだけ更新
+    uint8_t active[TELEMETRY_GROUP_COUNT];     // 組み立て中のパケットに使っている間引き数
+    uint8_t batch;                             // 1 パケットの記録数
+    uint8_t count;                             // 組み立て中のパケットの記録数
+    bool closed;                               // packet は送り出し済み（次の push で組み立て直す）
+    bool has_pending;                          // pending を次のパケットの先頭に入れる
+    uint16_t seq;
+    uint32_t used;                             // 組み立て中のパケットの使用バイト数
+    uint32_t next_record_seq;
+    nvm_trace_log_record_t held;               // 間引き中のグループの値
+    nvm_trace_log_record_t pending;
+    nvm_trace_codec_state_t codec;
+    telemetry_stats_t stats;
+    uint8_t packet[TELEMETRY_PACKET_MAX];
+} telemetry_t;
+
+// batch は 1..TELEMETRY_BATCH_MAX（範囲外は丸める）。間引きは全グループ 0（送らない）で始まる。
+void telemetry_init(telemetry_t* t, uint8_t batch);
+// 次のパケットから反映する
+void telemetry_set_decimation(telemetry_t* t, telemetry_group_t group, uint8_t decimation);
+void telemetry_apply_preset(telemetry_t* t, telemetry_preset_t preset);
+const char* telemetry_preset_name(telemetry_preset_t preset);
+
+/* 記録を 1 件積む。パケットが閉じたら out_packet / out_len に返して true（次の push まで有効）。
+ * 記録の seq が飛んだとき・payload に収まらないときは組み立て中のパケットを閉じて返し、
+ * 今回の記録は次のパケットの先頭に回す。 */
+bool telemetry_push(telemetry_t* t,
+                    const nvm_trace_log_record_t* rec,
+                    const uint8_t** out_packet,
+                    uint32_t* out_len);
+// 組み立て中のパケットを閉じる（記録がなければ false）
+bool telemetry_flush(telemetry_t* t, const uint8_t** out_packet, uint32_t* out_len);
+
+uint16_t telemetry_crc16(const uint8_t* data, uint32_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -1,10 +1,12 @@
 #include "trace.h"
 
 #include <stdarg.h>
+#include <stdbool.h>
 #include <stdint.h>
 #include <stdio.h>
 
 #include "main.h"
+#include "trace_ring.h"
 
 #if defined(STM32F413xx)
 
@@ -16,18 +18,14 @@ extern UART_HandleTypeDef huart1;
 
 #if NIGHTFALL_TRACE_F413_USE_UART
 
-static void trace_port_putc(char ch) {
-    uint8_t b = (uint8_t)ch;
-    HAL_UART_Transmit(&huart1, &b, 1, 10);
-}
+#define NIGHTFALL_TRACE_UART_DMA 1
 
 int __io_putchar(int ch) {
-    trace_port_putc((char)ch);
+    char c = (char)ch;
+    trace_write(&c, 1U);
     return ch;
 }
 
-void trace_init(void) {}
-
 #else
 
 #define NIGHTFALL_TRACE_SWO_BAUD_HZ 1000000U
@@ -97,12 +95,7 @@ void trace_init(void) {
 
 #elif defined(STM32F405xx)
 
-static void trace_port_putc(char ch) {
-    uint8_t b = (uint8_t)ch;
-    HAL_UART_Transmit(&huart1, &b, 1, 10);
-}
-
-void trace_init(void) {}
+#define NIGHTFALL_TRACE_UART_DMA 1
 
 #else
 
@@ -114,12 +107,246 @@ void trace_init(void) {}
 
 #endif
 
+#ifndef NIGHTFALL_TRACE_UART_DMA
+#define NIGHTFALL_TRACE_UART_DMA 0
+#endif
+
+#if NIGHTFALL_TRACE_UART_DMA
+
+/*
+ * USART1 TX を DMA2 Stream7 / Channel4 でリングバッファから送出する（F405/F413 共通）。
+ * trace_write() はリングへコピーして DMA を起動するだけで戻り、転送完了割り込みで次の
+ * 連続領域を送る。リングが満杯のときは新しい書き込みを捨てて破棄数を数える。
+ * trace_init() 前は従来どおり HAL_UART_Transmit で 1 バイトずつ送る。
+ *
+ * リングへのコピーは割り込みを禁止せずに行う（trace_ring.c）。割り込みを禁止するのは
+ * DMA の起動と完了処理（s_tx_inflight の確認・更新と DMA レジスタ数個の書き込み）だけで、
+ * 書き込み長に依らず数十サイクルで終わる。DMA 完了割り込み（最低優先度）と main の
+ * ポーリングの両方が同じストリームを起動し得るため、この区間だけは排他にしておく。
+ */
+
+#ifndef NIGHTFALL_TRACE_TX_RING_SIZE
+#define NIGHTFALL_TRACE_TX_RING_SIZE 4096U // 2 のべき乗
+#endif
+
+// lossless 時、送出が進まないまま待つ上限[ms]（超えたら残りを破棄）
+#ifndef NIGHTFALL_TRACE_TX_STALL_MS
+#define NIGHTFALL_TRACE_TX_STALL_MS 100U
+#endif
+
+#define TRACE_TX_DMA_STREAM DMA2_Stream7
+#define TRACE_TX_DMA_IRQn DMA2_Stream7_IRQn
+#define TRACE_TX_DMA_CLEAR_FLAGS \
+    (DMA_HIFCR_CTCIF7 | DMA_HIFCR_CHTIF7 | DMA_HIFCR_CTEIF7 | DMA_HIFCR_CDMEIF7 | DMA_HIFCR_CFEIF7)
+
+static uint8_t s_tx_buf[NIGHTFALL_TRACE_TX_RING_SIZE];
+static trace_ring_t s_tx_ring;
+static volatile uint32_t s_tx_inflight; // DMA 転送中のバイト数（0: 停止中）
+static volatile bool s_tx_dma_ready;
+static volatile bool s_tx_lossless;
+
+static void trace_port_putc(char ch) {
+    uint8_t b = (uint8_t)ch;
+    HAL_UART_Transmit(&huart1, &b, 1, 10);
+}
+
+static inline uint32_t trace_irq_save(void) {
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    return primask;
+}
+
+static inline void trace_irq_restore(uint32_t primask) {
+    __set_PRIMASK(primask);
+}
+
+// 割り込み禁止中に呼ぶこと（リングの走査・コピーはしない）
+static void trace_tx_kick_locked(void) {
+    const uint8_t* data;
+    uint32_t len;
+
+    if (s_tx_inflight != 0U) {
+        return;
+    }
+    len = trace_ring_peek(&s_tx_ring, &data);
+    if (len == 0U) {
+        return;
+    }
+    if (len > 0xFFFFU) {
+        len = 0xFFFFU; // NDTR は 16bit
+    }
+
+    s_tx_inflight = len;
+    DMA2->HIFCR = TRACE_TX_DMA_CLEAR_FLAGS;
+    TRACE_TX_DMA_STREAM->M0AR = (uint32_t)data;
+    TRACE_TX_DMA_STREAM->NDTR = len;
+    TRACE_TX_DMA_STREAM->CR |= DMA_SxCR_EN;
+}
+
+// 転送完了（またはエラー）を処理して次の領域を送る。割り込み・ポーリングの両方から呼ぶ。
+static void trace_tx_service(void) {
+    uint32_t primask = trace_irq_save();
+    uint32_t hisr = DMA2->HISR;
+
+    if ((s_tx_inflight != 0U) && ((hisr & (DMA_HISR_TCIF7 | DMA_HISR_TEIF7)) != 0U)) {
+        DMA2->HIFCR = TRACE_TX_DMA_CLEAR_FLAGS;
+        // 転送エラー時も送信済み扱いで先へ進める（trace は欠落を許容する）
+        trace_ring_consume(&s_tx_ring, s_tx_inflight);
+        s_tx_inflight = 0U;
+        trace_tx_kick_locked();
+    }
+    trace_irq_restore(primask);
+}
+
+void trace_uart_tx_dma_irq_handler(void) {
+    trace_tx_service();
+}
+
+void trace_init(void) {
+    (void)trace_ring_init(&s_tx_ring, s_tx_buf, (uint32_t)sizeof(s_tx_buf));
+    s_tx_inflight = 0U;
+    s_tx_lossless = false;
+
+    __HAL_RCC_DMA2_CLK_ENABLE();
+    TRACE_TX_DMA_STREAM->CR &= ~DMA_SxCR_EN;
+    while ((TRACE_TX_DMA_STREAM->CR & DMA_SxCR_EN) != 0U) {
+    }
+    DMA2->HIFCR = TRACE_TX_DMA_CLEAR_FLAGS;
+    TRACE_TX_DMA_STREAM->PAR = (uint32_t)&USART1->DR;
+    TRACE_TX_DMA_STREAM->FCR = 0U; // ダイレクトモード
+    TRACE_TX_DMA_STREAM->CR = (4UL << DMA_SxCR_CHSEL_Pos) | // USART1_TX
+                              DMA_SxCR_DIR_0 |              // メモリ→ペリフェラル
+                              DMA_SxCR_MINC |
+                              DMA_SxCR_TCIE |
+                              DMA_SxCR_TEIE;
+    USART1->CR3 |= USART_CR3_DMAT;
+
+    // 制御周期の割り込みを妨げないよう最低優先度
+    HAL_NVIC_SetPriority(TRACE_TX_DMA_IRQn, 15, 0);
+    HAL_NVIC_EnableIRQ(TRACE_TX_DMA_IRQn);
+
+    s_tx_dma_ready = true;
+}
+
+static void trace_tx_kick(void) {
+    uint32_t primask = trace_irq_save();
+    trace_tx_kick_locked();
+    trace_irq_restore(primask);
+}
+
+static void trace_write_lossless(const uint8_t* data, size_t len) {
+    uint32_t last_progress = HAL_GetTick();
+
+    while (len > 0U) {
+        size_t n = trace_ring_write_some(&s_tx_ring, data, len);
+        trace_tx_kick();
+
+        if (n > 0U) {
+            data += n;
+            len -= n;
+            last_progress = HAL_GetTick();
+            continue;
+        }
+        trace_tx_service();
+        if ((HAL_GetTick() - last_progress) > NIGHTFALL_TRACE_TX_STALL_MS) {
+            atomic_fetch_add_explicit(&s_tx_ring.dropped_bytes, (uint32_t)len, memory_order_relaxed);
+            atomic_fetch_add_explicit(&s_tx_ring.dropped_writes, 1U, memory_order_relaxed);
+            return;
+        }
+    }
+}
+
+void trace_write(const char* data, size_t len) {
+    if (!s_tx_dma_ready) {
+        for (size_t i = 0; i < len; ++i) {
+            trace_port_putc(data[i]);
+        }
+        return;
+    }
+
+    // 割り込みハンドラ内では待てないので lossless 指定でも drop-newest
+    if (s_tx_lossless && (__get_IPSR() == 0U)) {
+        trace_write_lossless((const uint8_t*)data, len);
+        return;
+    }
+
+    (void)trace_ring_write(&s_tx_ring, data, len);
+    trace_tx_kick();
+}
+
+bool trace_flush(uint32_t timeout_ms) {
+    uint32_t start = HAL_GetTick();
+
+    if (s_tx_dma_ready) {
+        while ((trace_ring_used(&s_tx_ring) != 0U) || (s_tx_inflight != 0U)) {
+            trace_tx_service();
+            if ((HAL_GetTick() - start) > timeout_ms) {
+                return false;
+            }
+        }
+    }
+    // 最終バイトがシフトレジスタから出るまで待つ
+    while ((USART1->SR & USART_SR_TC) == 0U) {
+        if ((HAL_GetTick() - start) > timeout_ms) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool trace_set_lossless(bool enable) {
+    bool prev = s_tx_lossless;
+    s_tx_lossless = enable;
+    return prev;
+}
+
+uint32_t trace_dropped_bytes(void) {
+    return s_tx_dma_ready ? atomic_load_explicit(&s_tx_ring.dropped_bytes, memory_order_relaxed) : 0U;
+}
+
+uint32_t trace_dropped_writes(void) {
+    return s_tx_dma_ready ? atomic_load_explicit(&s_tx_ring.dropped_writes, memory_order_relaxed) : 0U;
+}
+
+// printf() の出力（syscalls.c の weak な _write を置き換え、1 回の呼び出しでまとめて積む）
+int _write(int file, char* ptr, int len) {
+    (void)file;
+    if (len > 0) {
+        trace_write(ptr, (size_t)len);
+    }
+    return len;
+}
+
+#else
+
+void trace_uart_tx_dma_irq_handler(void) {}
+
 void trace_write(const char* data, size_t len) {
     for (size_t i = 0; i < len; ++i) {
         trace_port_putc(data[i]);
     }
 }
 
+bool trace_flush(uint32_t timeout_ms) {
+    (void)timeout_ms;
+    return true;
+}
+
+bool trace_set_lossless(bool enable) {
+    (void)enable;
+    return false;
+}
+
+uint32_t trace_dropped_bytes(void) {
+    return 0U;
+}
+
+uint32_t trace_dropped_writes(void) {
+    return 0U;
+}
+
+#endif
+
 int trace_printf(const char* fmt, ...) {
     char buf[512];
     va_list ap;
@@ -1,10 +1,28 @@
 #ifndef NIGHTFALL_TRACE_H_
 #define NIGHTFALL_TRACE_H_
 
+#include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
+
+// ダンプ終了時に trace_flush() で待つ上限[ms]
+#ifndef NIGHTFALL_TRACE_FLUSH_TIMEOUT_MS
+#define NIGHTFALL_TRACE_FLUSH_TIMEOUT_MS 1000U
+#endif
 
 void trace_init(void);
 void trace_write(const char* data, size_t len);
 int trace_printf(const char* fmt, ...);
 
+// 送信バッファが空になり最終バイトが送出されるまで待つ（タイムアウトで false）
+bool trace_flush(uint32_t timeout_ms);
+// true の間は満杯時に破棄せず空きを待つ（CSV/バイナリダンプ用）。直前の設定を返す。
+bool trace_set_lossless(bool enable);
+// 満杯で破棄したバイト数・書き込み回数（起動からの累計）
+uint32_t trace_dropped_bytes(void);
+uint32_t trace_dropped_writes(void);
+
+// DMA2_Stream7_IRQHandler から呼ぶ（USART1 TX DMA 完了）
+void trace_uart_tx_dma_irq_handler(void);
+
 #endif
@@ -0,0 +1,131 @@
+#include "trace_ring.h"
+
+#include <string.h>
+
+/*
+ * 生産者同士は単一コア上で入れ子の割り込みとしてしか重ならない（後から入った側が
+ * 最後まで走ってから元の生産者に戻る）。このため writers が 0 になった時点で予約済みの
+ * 領域は全て埋まっており、head = reserve として公開してよい。
+ */
+
+bool trace_ring_init(trace_ring_t* r, uint8_t* buf, uint32_t size) {
+    if ((r == NULL) || (buf == NULL) || (size == 0U) || ((size & (size - 1U)) != 0U)) {
+        return false;
+    }
+    r->buf = buf;
+    r->size = size;
+    atomic_init(&r->head, 0U);
+    atomic_init(&r->reserve, 0U);
+    atomic_init(&r->writers, 0U);
+    atomic_init(&r->tail, 0U);
+    atomic_init(&r->dropped_bytes, 0U);
+    atomic_init(&r->dropped_writes, 0U);
+    return true;
+}
+
+uint32_t trace_ring_used(const trace_ring_t* r) {
+    return atomic_load_explicit(&r->head, memory_order_acquire) -
+           atomic_load_explicit(&r->tail, memory_order_acquire);
+}
+
+uint32_t trace_ring_free(const trace_ring_t* r) {
+    return r->size - (atomic_load_explicit(&r->reserve, memory_order_relaxed) -
+                      atomic_load_explicit(&r->tail, memory_order_acquire));
+}
+
+bool trace_ring_reserve(trace_ring_t* r, uint32_t min_len, uint32_t max_len, trace_ring_span_t* span) {
+    uint32_t pos;
+    uint32_t len;
+
+    // 予約より先に数える（予約してから数えるまでの間に他の生産者が公開すると、埋まっていない領域が見える）
+    atomic_fetch_add_explicit(&r->writers, 1U, memory_order_acquire);
+    pos = atomic_load_explicit(&r->reserve, memory_order_relaxed);
+    do {
+        uint32_t room = r->size - (pos - atomic_load_explicit(&r->tail, memory_order_acquire));
+        len = (room < max_len) ? room : max_len;
+        if ((len == 0U) || (len < min_len)) {
+            trace_ring_commit(r);
+            return false;
+        }
+    } while (!atomic_compare_exchange_weak_explicit(&r->reserve, &pos, pos + len,
+                                                    memory_order_relaxed, memory_order_relaxed));
+    span->pos = pos;
+    span->len = len;
+    return true;
+}
+
+void trace_ring_fill(trace_ring_t* r, const trace_ring_span_t* span, const void* data) {
+    const uint8_t* src = (const uint8_t*)data;
+    uint32_t pos = span->pos & (r->size - 1U);
+    uint32_t first = r->size - pos;
+
+    if (first > span->len) {
+        first = span->len;
+    }
+    memcpy(&r->buf[pos], src, first);
+    memcpy(&r->buf[0], src + first, span->len - first);
+}
+
+void trace_ring_commit(trace_ring_t* r) {
+    uint32_t end;
+    uint32_t head;
+
+    if (atomic_fetch_sub_explicit(&r->writers, 1U, memory_order_acq_rel) != 1U) {
+        return; // 外側の生産者がまだ書いている（その commit でまとめて公開する）
+    }
+    // 入れ子の生産者が先に公開していれば head を戻さない
+    end = atomic_load_explicit(&r->reserve, memory_order_relaxed);
+    head = atomic_load_explicit(&r->head, memory_order_relaxed);
+    while (((int32_t)(end - head) > 0) &&
+           !atomic_compare_exchange_weak_explicit(&r->head, &head, end,
+                                                  memory_order_release, memory_order_relaxed)) {
+    }
+}
+
+bool trace_ring_write(trace_ring_t* r, const void* data, size_t len) {
+    trace_ring_span_t span;
+
+    if (len == 0U) {
+        return true;
+    }
+    if ((len > (size_t)r->size) || !trace_ring_reserve(r, (uint32_t)len, (uint32_t)len, &span)) {
+        atomic_fetch_add_explicit(&r->dropped_bytes, (uint32_t)len, memory_order_relaxed);
+        atomic_fetch_add_explicit(&r->dropped_writes, 1U, memory_order_relaxed);
+        return false;
+    }
+    trace_ring_fill(r, &span, data);
+    trace_ring_commit(r);
+    return true;
+}
+
+size_t trace_ring_write_some(trace_ring_t* r, const void* data, size_t len) {
+    trace_ring_span_t span;
+    uint32_t max_len = (len > (size_t)r->size) ? r->size : (uint32_t)len;
+
+    if ((max_len == 0U) || !trace_ring_reserve(r, 1U, max_len, &span)) {
+        return 0U;
+    }
+    trace_ring_fill(r, &span, data);
+    trace_ring_commit(r);
+    return span.len;
+}
+
+uint32_t trace_ring_peek(const trace_ring_t* r, const uint8_t** data) {
+    uint32_t tail = atomic_load_explicit(&r->tail, memory_order_relaxed);
+    uint32_t used = atomic_load_explicit(&r->head, memory_order_acquire) - tail;
+    uint32_t pos = tail & (r->size - 1U);
+    uint32_t contig = r->size - pos;
+
+    *data = &r->buf[pos];
+    return (used < contig) ? used : contig;
+}
+
+void trace_ring_consume(trace_ring_t* r, uint32_t len) {
+    uint32_t tail = atomic_load_explicit(&r->tail, memory_order_relaxed);
+    uint32_t used = atomic_load_explicit(&r->head, memory_order_acquire) - tail;
+
+    if (len > used) {
+        len = used;
+    }
+    atomic_store_explicit(&r->tail, tail + len, memory_order_release);
+}
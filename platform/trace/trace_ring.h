@@ -0,0 +1,63 @@
+#ifndef NIGHTFALL_TRACE_RING_H_
+#define NIGHTFALL_TRACE_RING_H_
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * trace 出力用のリングバッファ。割り込みを禁止せずに読み書きできる。
+ * - 消費者（UART DMA）は 1 つで tail のみを更新する。生産者から見た head/tail は SPSC と同じ。
+ * - 生産者は main と割り込み（printf）の複数があり得るため、書き込み位置 reserve を
+ *   compare-exchange で予約してからコピーする。コピー中の生産者数 writers が 0 になった
+ *   ところで head = reserve として公開する（割り込みで入れ子になった書き込みは、
+ *   外側の書き込みが終わるまで消費者から見えない）。
+ * - 添字は 32bit のまま進め、参照時に size-1 でマスクする（size は 2 のべき乗）。
+ * - 空きが足りない書き込みは丸ごと捨て（drop-newest）、破棄数を数える。
+ * HAL に依存しないためホストでもビルドできる（tests/test_trace_ring.c）。
+ */
+typedef struct {
+    uint8_t* buf;
+    uint32_t size;
+    _Atomic uint32_t head;    // 公開済みの末尾（消費者はここまで読める）
+    _Atomic uint32_t reserve; // 予約済みの末尾（head <= reserve）
+    _Atomic uint32_t writers; // 予約してからまだ公開していない生産者の数
+    _Atomic uint32_t tail;
+    _Atomic uint32_t dropped_bytes;
+    _Atomic uint32_t dropped_writes;
+} trace_ring_t;
+
+// 予約した領域（trace_ring_reserve() → trace_ring_fill() → trace_ring_commit()）
+typedef struct {
+    uint32_t pos;
+    uint32_t len;
+} trace_ring_span_t;
+
+bool trace_ring_init(trace_ring_t* r, uint8_t* buf, uint32_t size);
+
+uint32_t trace_ring_used(const trace_ring_t* r);
+uint32_t trace_ring_free(const trace_ring_t* r);
+
+/* 全量を格納できるときだけ書き込む。入らない場合は破棄数を加算して false。 */
+bool trace_ring_write(trace_ring_t* r, const void* data, size_t len);
+
+/* 入るだけ書き込み、書き込んだバイト数を返す（破棄数は加算しない）。 */
+size_t trace_ring_write_some(trace_ring_t* r, const void* data, size_t len);
+
+/*
+ * 書き込みを 3 段に分けたもの（trace_ring_write() はこれを続けて呼ぶ）。
+ * reserve は min_len 以上 max_len 以下の空きを予約し、足りなければ false（破棄数は数えない）。
+ * reserve が true を返したら、必ず fill で埋めて commit すること。
+ */
+bool trace_ring_reserve(trace_ring_t* r, uint32_t min_len, uint32_t max_len, trace_ring_span_t* span);
+void trace_ring_fill(trace_ring_t* r, const trace_ring_span_t* span, const void* data);
+void trace_ring_commit(trace_ring_t* r);
+
+/* 連続して読み出せる先頭領域を返す（DMA 転送用）。戻り値はバイト数。 */
+uint32_t trace_ring_peek(const trace_ring_t* r, const uint8_t** data);
+
+/* peek で取り出した領域のうち len バイトを解放する。 */
+void trace_ring_consume(trace_ring_t* r, uint32_t len);
+
+#endif
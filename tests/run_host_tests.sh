@@ -0,0 +1,53 @@
+#!/usr/bin/env sh
+set -eu
+
+# サブシステムのホスト試験（モジュールごとに 1 つの試験プログラム）
+# usage: tests/run_host_tests.sh [name ...]   （省略時は全て。name は test_<name>.c）
+
+ROOT_DIR=$(CDPATH= cd -- "$(dirname -- "$0")/.." && pwd)
+OUT_DIR="$ROOT_DIR/build/tests"
+CFLAGS="-std=c11 -O2 -Wall -Wextra -Wpedantic ${HOST_TEST_CFLAGS:-}"
+ALL="trace_ring ism330_burst nvm_write_queue nvm_trace_codec nvm_param_store nvm_maze_journal spi_bus_sched isr_prof telemetry"
+
+# 試験ごとの被試験ソースとインクルードパス
+test_sources() {
+  case "$1" in
+    trace_ring)
+      echo "-I$ROOT_DIR/platform/trace $ROOT_DIR/platform/trace/trace_ring.c" ;;
+    ism330_burst)
+      echo "-I$ROOT_DIR/platform/imu $ROOT_DIR/platform/imu/ism330_burst.c" ;;
+    nvm_write_queue)
+      echo "-I$ROOT_DIR/nvm $ROOT_DIR/nvm/nvm_write_queue.c" ;;
+    nvm_trace_codec)
+      echo "-I$ROOT_DIR/nvm $ROOT_DIR/nvm/nvm_trace_codec.c $ROOT_DIR/nvm/nvm_trace_log.c $ROOT_DIR/tests/trace_record_sim.c" ;;
+    nvm_param_store)
+      echo "-I$ROOT_DIR/nvm $ROOT_DIR/nvm/nvm_param_store.c" ;;
+    nvm_maze_journal)
+      echo "-I$ROOT_DIR/nvm $ROOT_DIR/nvm/nvm_maze_journal.c" ;;
+    spi_bus_sched)
+      echo "-I$ROOT_DIR/nvm -I$ROOT_DIR/platform/bus $ROOT_DIR/nvm/nvm_write_queue.c $ROOT_DIR/platform/bus/spi_bus_sched.c" ;;
+    isr_prof)
+      echo "-I$ROOT_DIR/platform/prof $ROOT_DIR/platform/prof/isr_prof.c" ;;
+    telemetry)
+      echo "-I$ROOT_DIR/nvm -I$ROOT_DIR/platform/trace $ROOT_DIR/nvm/nvm_trace_codec.c $ROOT_DIR/platform/trace/telemetry.c $ROOT_DIR/tests/trace_record_sim.c" ;;
+    *)
+      echo "unknown test: $1" >&2
+      return 1 ;;
+  esac
+}
+
+mkdir -p "$OUT_DIR"
+failed=0
+for name in ${*:-$ALL}; do
+  srcs=$(test_sources "$name")
+  # shellcheck disable=SC2086
+  cc $CFLAGS "$ROOT_DIR/tests/test_$name.c" $srcs -lm -o "$OUT_DIR/test_$name"
+  if ! "$OUT_DIR/test_$name"; then
+    failed=$((failed + 1))
+  fi
+done
+if [ "$failed" -ne 0 ]; then
+  echo "[host-tests] failed=$failed"
+  exit 1
+fi
+echo "[host-tests] result=ok"
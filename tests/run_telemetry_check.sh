@@ -0,0 +1,13 @@
+#!/usr/bin/env sh
+set -eu
+
+ROOT_DIR=$(CDPATH= cd -- "$(dirname -- "$0")/.." && pwd)
+OUT_DIR="$ROOT_DIR/build/tests/telemetry"
+PREFIX="$OUT_DIR/fault_stream"
+
+mkdir -p "$OUT_DIR"
+# 送信側（platform/trace/telemetry.c）の確認と、壊れたパケットを混ぜた受信用ストリームの生成
+"$ROOT_DIR/tests/run_host_tests.sh" telemetry >/dev/null
+"$ROOT_DIR/build/tests/test_telemetry" "$PREFIX"
+# 受信側（tools/logging/telemetry_decode.py）で復号して突き合わせる
+python3 "$ROOT_DIR/tools/logging/telemetry_decode.py" "$PREFIX.bin" --verify "$PREFIX.truth"
@@ -0,0 +1,143 @@
+/*
+ * test_ism330_burst.c
+ *
+ * platform/imu/ism330_burst.c のホスト試験:
+ * レジスタダンプをバースト読取したフレームを ism330_burst_decode() / ism330_burst_to_sample() で
+ * 復号し、従来の 1 レジスタずつ読む換算（sensor.c の read16_le + ism330_gyro_dps/accel_g）と
+ * バイト順・符号拡張・軸の対応が一致することを確かめる。
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "ism330_burst.h"
+
+static bool s_ok = true;
+static uint8_t s_regs[0x80]; // ISM330 のレジスタ空間（0x00..0x7F）
+
+static void expect(const char *what, bool cond)
+{
+    if (!cond) {
+        printf("[ism330-burst] NG: %s\n", what);
+        s_ok = false;
+    }
+}
+
+//-------------------------------------------------------------
+// 従来の 1 レジスタずつの読み出し（sensor.c の旧 ISM330_DataUpdate と同じ式）
+//-------------------------------------------------------------
+
+static uint8_t read_byte(uint8_t reg)
+{
+    return s_regs[reg & 0x7FU];
+}
+
+static int16_t read16_le(uint8_t reg_l)
+{
+    uint8_t lo = read_byte(reg_l);
+    uint8_t hi = read_byte(reg_l + 1);
+    return (int16_t)((int16_t)hi << 8 | lo);
+}
+
+static float ism330_gyro_dps(int16_t raw)
+{
+    return (float)raw * 0.14f; // [deg/s]
+}
+
+static float ism330_accel_g(int16_t raw)
+{
+    return (float)raw * 0.000488f; // [g]
+}
+
+static void legacy_read(ism330_sample_t *out)
+{
+    out->gyro_dps[0] = ism330_gyro_dps(read16_le(0x22));
+    out->gyro_dps[1] = ism330_gyro_dps(read16_le(0x24));
+    out->gyro_dps[2] = ism330_gyro_dps(read16_le(0x26));
+    out->accel_g[0] = ism330_accel_g(read16_le(0x28));
+    out->accel_g[1] = ism330_accel_g(read16_le(0x2A));
+    out->accel_g[2] = ism330_accel_g(read16_le(0x2C));
+}
+
+//-------------------------------------------------------------
+// バースト読取: IF_INC=1 でアドレスを自動インクリメントする SPI 転送を模擬する
+//-------------------------------------------------------------
+
+static void burst_xfer(uint8_t rx[ISM330_BURST_XFER_LEN])
+{
+    uint8_t tx[ISM330_BURST_XFER_LEN];
+    uint8_t reg;
+
+    memset(tx, 0xA5, sizeof(tx));
+    ism330_burst_tx_frame(tx);
+    expect("tx[0] is a read of OUTX_L_G", tx[0] == (0x80U | 0x22U));
+    reg = (uint8_t)(tx[0] & 0x7FU);
+    rx[0] = 0xFFU; // アドレス送出中のダミー
+    for (uint32_t i = 1U; i < ISM330_BURST_XFER_LEN; i++) {
+        expect("tx dummy bytes are zero", tx[i] == 0x00U);
+        rx[i] = read_byte(reg++);
+    }
+}
+
+static void set_out(uint8_t reg_l, uint16_t v)
+{
+    s_regs[reg_l] = (uint8_t)(v & 0xFFU);
+    s_regs[reg_l + 1U] = (uint8_t)(v >> 8);
+}
+
+// ダンプ 1 件を両方の経路で読み、生値と物理量を比べる
+static void check_dump(const char *name, const uint16_t g[3], const uint16_t a[3])
+{
+    uint8_t rx[ISM330_BURST_XFER_LEN];
+    ism330_raw_t raw;
+    ism330_sample_t burst;
+    ism330_sample_t legacy;
+    char what[96];
+
+    memset(s_regs, 0x5A, sizeof(s_regs)); // 出力レジスタ以外の値が混ざらないこと
+    for (uint32_t i = 0U; i < 3U; i++) {
+        set_out((uint8_t)(0x22U + 2U * i), g[i]);
+        set_out((uint8_t)(0x28U + 2U * i), a[i]);
+    }
+    burst_xfer(rx);
+    ism330_burst_decode(rx, &raw);
+    ism330_burst_to_sample(&raw, &burst);
+    legacy_read(&legacy);
+
+    for (uint32_t i = 0U; i < 3U; i++) {
+        snprintf(what, sizeof(what), "%s: gyro[%u] raw", name, (unsigned)i);
+        expect(what, raw.gyro[i] == (int16_t)g[i]);
+        snprintf(what, sizeof(what), "%s: accel[%u] raw", name, (unsigned)i);
+        expect(what, raw.accel[i] == (int16_t)a[i]);
+        snprintf(what, sizeof(what), "%s: gyro[%u] matches legacy", name, (unsigned)i);
+        expect(what, memcmp(&burst.gyro_dps[i], &legacy.gyro_dps[i], sizeof(float)) == 0);
+        snprintf(what, sizeof(what), "%s: accel[%u] matches legacy", name, (unsigned)i);
+        expect(what, memcmp(&burst.accel_g[i], &legacy.accel_g[i], sizeof(float)) == 0);
+    }
+}
+
+int main(void)
+{
+    // 静止（Z 上向き +1g = 2049 LSB、ジャイロはわずかなオフセット）
+    static const uint16_t still_g[3] = {0xFFFDU, 0x0002U, 0xFFFFU};
+    static const uint16_t still_a[3] = {0x0011U, 0xFFE8U, 0x0801U};
+    // 軸ごとに上位・下位が異なる値（軸の取り違え・バイト順の取り違えを検出する）
+    static const uint16_t axes_g[3] = {0x0102U, 0x0304U, 0x0506U};
+    static const uint16_t axes_a[3] = {0x0A0BU, 0x0C0DU, 0x0E0FU};
+    // 符号拡張の境界（下位の bit7 が符号として扱われないこと）
+    static const uint16_t edge_g[3] = {0x7FFFU, 0x8000U, 0x0080U};
+    static const uint16_t edge_a[3] = {0xFF7FU, 0x8001U, 0x00FFU};
+    // 旋回中（Z 軸 +720 deg/s ≒ 5143 LSB、X 加速度 -2g）
+    static const uint16_t turn_g[3] = {0x0010U, 0xFFF0U, 0x1417U};
+    static const uint16_t turn_a[3] = {0xF000U, 0x0100U, 0x07F0U};
+
+    check_dump("still", still_g, still_a);
+    check_dump("axes", axes_g, axes_a);
+    check_dump("edge", edge_g, edge_a);
+    check_dump("turn", turn_g, turn_a);
+
+    printf("[ism330-burst] result=%s\n", s_ok ? "ok" : "NG");
+    return s_ok ? 0 : 1;
+}
@@ -0,0 +1,95 @@
+/*
+ * test_isr_prof.c
+ *
+ * platform/prof/isr_prof.c のホスト試験:
+ * DWT の代わりに模擬カウンタで既知の所要サイクルを与え、集計値・ヒストグラム・予算超過・
+ * 32bit カウンタの周回・区間最大の取り出し・リセット要求・起動間隔を確かめる。
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "isr_prof.h"
+
+#define CYCLES_PER_US 100U
+
+static bool s_ok = true;
+static uint32_t s_cycles = 0U;
+
+static void expect(const char *what, bool cond)
+{
+    if (!cond) {
+        printf("[isr-prof] NG: %s\n", what);
+        s_ok = false;
+    }
+}
+
+static uint32_t mock_counter(void)
+{
+    return s_cycles;
+}
+
+// 模擬カウンタを cycles 進めた区間を 1 回記録する
+static void run_section(isr_prof_section_t section, uint32_t cycles)
+{
+    uint32_t t = isr_prof_begin();
+    s_cycles += cycles;
+    (void)isr_prof_end(section, t);
+}
+
+int main(void)
+{
+    isr_prof_stat_t st;
+
+    // 初期化前はカウンタを読まず、何も記録しない
+    isr_prof_init(NULL, CYCLES_PER_US);
+    expect("disabled", isr_prof_begin() == 0U && !isr_prof_snapshot(ISR_PROF_CTRL_TICK, &st));
+
+    // 周回直前から始めて、32bit の周回をまたいでも差分が正しいこと
+    s_cycles = UINT32_MAX - 50U;
+    isr_prof_init(mock_counter, CYCLES_PER_US);
+    isr_prof_set_budget_us(ISR_PROF_CTRL_TICK, 100U);
+    run_section(ISR_PROF_CTRL_TICK, 50U);        // 0.5us -> bin0
+    run_section(ISR_PROF_CTRL_TICK, 150U);       // 1.5us -> bin1
+    run_section(ISR_PROF_CTRL_TICK, 3000U);      // 30us -> bin5 [16,32)
+    run_section(ISR_PROF_CTRL_TICK, 12000U);     // 120us -> bin7 [64,128), 予算超過
+    run_section(ISR_PROF_CTRL_TICK, 100000000U); // 1s -> 最後の bin
+    expect("snapshot", isr_prof_snapshot(ISR_PROF_CTRL_TICK, &st));
+    expect("count", st.count == 5U);
+    expect("min/max/last", st.min_cycles == 50U && st.max_cycles == 100000000U && st.last_cycles == 100000000U);
+    expect("sum", st.sum_cycles == 100015200ULL);
+    expect("over_budget", st.over_budget == 2U);
+    expect("hist", st.hist[0] == 1U && st.hist[1] == 1U && st.hist[5] == 1U && st.hist[7] == 1U &&
+                       st.hist[ISR_PROF_HIST_BINS - 1U] == 1U);
+    expect("bin floor", isr_prof_hist_bin_floor_us(0U) == 0U && isr_prof_hist_bin_floor_us(5U) == 16U);
+    expect("us_x10", isr_prof_cycles_to_us_x10(12345U) == 1234U &&
+                         isr_prof_cycles_to_us_x10(100000000U) == 0xFFFFU);
+    expect("other section untouched", isr_prof_snapshot(ISR_PROF_IMU, &st) && st.count == 0U);
+
+    // 区間最大は取り出すと 0 に戻り、次の記録から取り直す
+    expect("window max", isr_prof_take_window_max(ISR_PROF_CTRL_TICK) == 100000000U &&
+                             isr_prof_take_window_max(ISR_PROF_CTRL_TICK) == 0U);
+    run_section(ISR_PROF_CTRL_TICK, 700U);
+    run_section(ISR_PROF_CTRL_TICK, 300U);
+    expect("window max after take", isr_prof_take_window_max(ISR_PROF_CTRL_TICK) == 700U);
+
+    // リセットは要求だけ立ち、読み出しは消去後の状態を返し、次の記録で実際に消える
+    isr_prof_reset();
+    expect("reset pending", isr_prof_snapshot(ISR_PROF_CTRL_TICK, &st) && st.count == 0U);
+    run_section(ISR_PROF_CTRL_TICK, 250U);
+    expect("reset applied", isr_prof_snapshot(ISR_PROF_CTRL_TICK, &st) && st.count == 1U &&
+                                st.min_cycles == 250U && st.max_cycles == 250U && st.over_budget == 0U);
+
+    // 起動間隔: 初回の mark は記録せず、以降は前回からの差を記録する（ジッタ = max - min）
+    for (uint32_t i = 0U; i < 6U; i++) {
+        isr_prof_mark_period(ISR_PROF_CTRL_PERIOD);
+        s_cycles += 100000U + ((i & 1U) != 0U ? 300U : 0U);
+    }
+    expect("period", isr_prof_snapshot(ISR_PROF_CTRL_PERIOD, &st) && st.count == 5U &&
+                         st.min_cycles == 100000U && st.max_cycles == 100300U);
+
+    printf("[isr-prof] sections=%u bins=%u result=%s\n", (unsigned int)ISR_PROF_SECTION_COUNT,
+           (unsigned int)ISR_PROF_HIST_BINS, s_ok ? "ok" : "NG");
+    return s_ok ? 0 : 1;
+}
@@ -0,0 +1,357 @@
+/*
+ * test_nvm_maze_journal.c
+ *
+ * nvm/nvm_maze_journal.c のホスト試験:
+ * 模擬 Flash の 2 セクタに探索中の保存を繰り返し、往復・差分だけの追記・セクタの切り替え・壊れたセクタからの復帰・
+ * 保存の途中で電源が切れても前回か今回の内容のどちらかが読めること（混ざらないこと）を確かめる。
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "nvm_maze_journal.h"
+
+// 小さいセクタにして切り替えを頻繁に起こす
+#define SECTOR_BYTES (4096U)
+#define CELLS (16U * 16U)
+#define SAVES 90U
+
+static bool s_ok = true;
+
+// 内蔵 Flash と同じく消去で 0xFF、書き込みはビットを 0 にするだけ。
+// 消去 1 回を 1、書き込みを 1 バイト 1 として残りで電源断を模擬する
+static uint8_t s_flash[2][SECTOR_BYTES];
+static uint8_t s_flash_saved[2][SECTOR_BYTES];
+static uint32_t s_bytes = SECTOR_BYTES; // nvm_get_area_info が返す大きさ
+static int32_t s_budget = -1;           // 電源断までに使える単位（負 = 無制限）
+static uint32_t s_erases = 0U;
+
+static nvm_maze_journal_t s_journal;
+static nvm_maze_journal_t s_journal_saved;
+static nvm_maze_journal_t s_reader;
+static uint32_t s_rng = 0x13579BDFU;
+
+static void expect(const char *what, bool cond)
+{
+    if (!cond) {
+        printf("[nvm-maze-journal] NG: %s\n", what);
+        s_ok = false;
+    }
+}
+
+static uint32_t rand32(void)
+{
+    s_rng ^= s_rng << 13;
+    s_rng ^= s_rng >> 17;
+    s_rng ^= s_rng << 5;
+    return s_rng;
+}
+
+//-------------------------------------------------------------
+// 模擬 Flash（nvm.c の代わり）
+//-------------------------------------------------------------
+
+static bool is_journal_area(nvm_area_t area)
+{
+    return area == NVM_AREA_MAZE_JOURNAL || area == NVM_AREA_MAZE_MAP;
+}
+
+nvm_status_t nvm_get_area_info(nvm_area_t area, nvm_area_info_t *out)
+{
+    if (!is_journal_area(area) || out == NULL) {
+        return NVM_STATUS_UNSUPPORTED;
+    }
+    out->area = area;
+    out->base_address = (area == NVM_AREA_MAZE_JOURNAL) ? 0x08060000UL : 0x080E0000UL;
+    out->size_bytes = s_bytes;
+    out->schema_version = NVM_MAZE_JOURNAL_VERSION;
+    return NVM_STATUS_OK;
+}
+
+nvm_status_t nvm_read(nvm_area_t area, uint32_t offset, void *out, size_t len)
+{
+    if (!is_journal_area(area) || (size_t)offset + len > s_bytes) {
+        return NVM_STATUS_INVALID_ARG;
+    }
+    memcpy(out, &s_flash[area == NVM_AREA_MAZE_MAP][offset], len);
+    return NVM_STATUS_OK;
+}
+
+nvm_status_t nvm_write(nvm_area_t area, uint32_t offset, const void *data, size_t len)
+{
+    uint8_t *dst;
+    const uint8_t *src = (const uint8_t *)data;
+
+    if (!is_journal_area(area) || (size_t)offset + len > s_bytes) {
+        return NVM_STATUS_INVALID_ARG;
+    }
+    dst = &s_flash[area == NVM_AREA_MAZE_MAP][offset];
+    // nvm.c の F405 と同じく、消去せずに 0 を 1 に戻す書き込みは受け付けない
+    for (size_t i = 0U; i < len; i++) {
+        if ((uint8_t)(dst[i] & src[i]) != src[i]) {
+            return NVM_STATUS_INVALID_ARG;
+        }
+    }
+    for (size_t i = 0U; i < len; i++) {
+        if (s_budget == 0) {
+            return NVM_STATUS_HW_ERROR;
+        }
+        dst[i] = src[i];
+        if (s_budget > 0) {
+            s_budget--;
+        }
+    }
+    return NVM_STATUS_OK;
+}
+
+nvm_status_t nvm_erase(nvm_area_t area)
+{
+    uint8_t *dst;
+
+    if (!is_journal_area(area)) {
+        return NVM_STATUS_UNSUPPORTED;
+    }
+    dst = s_flash[area == NVM_AREA_MAZE_MAP];
+    // 消去の途中で切れたら前半だけ消えている
+    if (s_budget == 0) {
+        memset(dst, 0xFF, s_bytes / 2U);
+        return NVM_STATUS_HW_ERROR;
+    }
+    memset(dst, 0xFF, s_bytes);
+    s_erases++;
+    if (s_budget > 0) {
+        s_budget--;
+    }
+    return NVM_STATUS_OK;
+}
+
+//-------------------------------------------------------------
+// 試験
+//-------------------------------------------------------------
+
+// 再起動後と同じく、別の構造体で Flash から読み直す
+static nvm_status_t reload(uint16_t *cells, nvm_maze_journal_load_result_t *res)
+{
+    nvm_status_t st = nvm_maze_journal_init(&s_reader, NVM_AREA_MAZE_JOURNAL, NVM_AREA_MAZE_MAP, CELLS);
+
+    if (st != NVM_STATUS_OK) {
+        return st;
+    }
+    return nvm_maze_journal_load(&s_reader, cells, res);
+}
+
+static bool same_cells(const uint16_t *a, const uint16_t *b)
+{
+    return memcmp(a, b, CELLS * sizeof(a[0])) == 0;
+}
+
+// 探索で壁が分かったときのように、いくつかのセルの下位 8bit を変える
+static void mutate(uint16_t *cells, uint32_t count)
+{
+    for (uint32_t i = 0U; i < count; i++) {
+        uint32_t idx = rand32() % CELLS;
+
+        cells[idx] = (uint16_t)((cells[idx] & 0xFF00U) | (rand32() & 0xFFU));
+    }
+}
+
+/* prev を保存済みの状態から next を保存する途中の、すべての位置で電源を切る。
+ * 切れた後の読込は prev か next のどちらか。同じ構造体で保存し直すと next が読める */
+static void check_power_cut(const uint16_t *prev, const uint16_t *next, uint32_t *cuts, uint32_t *newer)
+{
+    static uint16_t got[CELLS];
+    nvm_maze_journal_load_result_t res;
+    nvm_maze_journal_save_result_t sres;
+    nvm_status_t st;
+    int32_t total;
+
+    memcpy(s_flash_saved, s_flash, sizeof(s_flash));
+    s_journal_saved = s_journal;
+
+    // 電源断なしで何単位かかるか
+    s_budget = INT32_MAX;
+    st = nvm_maze_journal_save(&s_journal, next, &sres);
+    total = INT32_MAX - s_budget;
+    s_budget = -1;
+    expect("cut dry run", st == NVM_STATUS_OK);
+
+    for (int32_t cut = 0; cut < total && s_ok; cut++) {
+        memcpy(s_flash, s_flash_saved, sizeof(s_flash));
+        s_journal = s_journal_saved;
+        s_budget = cut;
+        st = nvm_maze_journal_save(&s_journal, next, &sres);
+        s_budget = -1;
+        expect("cut save fails", st == NVM_STATUS_HW_ERROR && !s_journal.scanned);
+
+        st = reload(got, &res);
+        expect("cut load", st == NVM_STATUS_OK && (same_cells(got, prev) || same_cells(got, next)));
+        if (st == NVM_STATUS_OK && same_cells(got, next) && !same_cells(prev, next)) {
+            (*newer)++;
+        }
+
+        // 続けて保存し直す（読み直してから書く）
+        st = nvm_maze_journal_save(&s_journal, next, &sres);
+        expect("cut resave", st == NVM_STATUS_OK);
+        st = reload(got, &res);
+        expect("cut resave load", st == NVM_STATUS_OK && same_cells(got, next));
+        if (!s_ok) {
+            printf("[nvm-maze-journal] cut=%ld/%ld\n", (long)cut, (long)total);
+        }
+        (*cuts)++;
+    }
+
+    // 電源断なしの結果に戻して続ける
+    memcpy(s_flash, s_flash_saved, sizeof(s_flash));
+    s_journal = s_journal_saved;
+    st = nvm_maze_journal_save(&s_journal, next, &sres);
+    expect("cut final save", st == NVM_STATUS_OK);
+}
+
+// 空の Flash への最初の保存（スナップショットの書き込み）のすべての位置で切る
+static void check_first_save_cut(const uint16_t *cells, uint32_t *cuts)
+{
+    static uint16_t got[CELLS];
+    const int32_t total = (int32_t)(1U + sizeof(nvm_maze_journal_header_t) + CELLS * 2U);
+    nvm_maze_journal_load_result_t res;
+    nvm_maze_journal_save_result_t sres;
+    nvm_status_t st;
+    uint32_t before = *cuts;
+
+    memset(s_flash, 0xFF, sizeof(s_flash));
+    expect("reinit", nvm_maze_journal_init(&s_journal, NVM_AREA_MAZE_JOURNAL, NVM_AREA_MAZE_MAP, CELLS) ==
+                         NVM_STATUS_OK);
+    memcpy(s_flash_saved, s_flash, sizeof(s_flash));
+    for (int32_t cut = 0; cut < total; cut++) {
+        memcpy(s_flash, s_flash_saved, sizeof(s_flash));
+        expect("reinit", nvm_maze_journal_init(&s_journal, NVM_AREA_MAZE_JOURNAL, NVM_AREA_MAZE_MAP, CELLS) ==
+                             NVM_STATUS_OK);
+        s_budget = cut;
+        st = nvm_maze_journal_save(&s_journal, cells, &sres);
+        s_budget = -1;
+        expect("first cut save", st == NVM_STATUS_HW_ERROR);
+        st = reload(got, &res);
+        // ヘッダの途中で切れたら INTEGRITY_ERROR（旧形式が残っていれば nvm_params.c はそちらを読む）
+        expect("first cut", st == NVM_STATUS_NOT_FOUND || st == NVM_STATUS_INTEGRITY_ERROR ||
+                                (st == NVM_STATUS_OK && same_cells(got, cells)));
+        (*cuts)++;
+    }
+    expect("first cuts", *cuts - before == (uint32_t)total);
+}
+
+int main(void)
+{
+    static uint16_t cells[CELLS];
+    static uint16_t prev[CELLS];
+    static uint16_t got[CELLS];
+    static uint16_t before_compact[CELLS];
+    nvm_maze_journal_load_result_t res;
+    nvm_maze_journal_save_result_t sres;
+    nvm_status_t st;
+    uint32_t last_sector = 0U;
+    uint32_t last_generation = 0U;
+    uint32_t compactions = 0U;
+    uint32_t appends = 0U;
+    uint32_t append_bytes = 0U;
+    uint32_t erases;
+    uint32_t cuts = 0U;
+    uint32_t newer = 0U;
+
+    memset(s_flash, 0xFF, sizeof(s_flash));
+
+    // 引数の検査（スナップショットが入らない大きさも弾く）
+    expect("init 0", nvm_maze_journal_init(&s_journal, NVM_AREA_MAZE_JOURNAL, NVM_AREA_MAZE_MAP, 0U) ==
+                         NVM_STATUS_INVALID_ARG);
+    expect("init max", nvm_maze_journal_init(&s_journal, NVM_AREA_MAZE_JOURNAL, NVM_AREA_MAZE_MAP,
+                                             NVM_MAZE_JOURNAL_MAX_CELLS + 1U) == NVM_STATUS_INVALID_ARG);
+    expect("init same", nvm_maze_journal_init(&s_journal, NVM_AREA_MAZE_MAP, NVM_AREA_MAZE_MAP, CELLS) ==
+                            NVM_STATUS_INVALID_ARG);
+    expect("init area", nvm_maze_journal_init(&s_journal, NVM_AREA_MAZE_JOURNAL, NVM_AREA_TRACE_LOG, CELLS) !=
+                            NVM_STATUS_OK);
+    s_bytes = 1024U;
+    expect("init small", nvm_maze_journal_init(&s_journal, NVM_AREA_MAZE_JOURNAL, NVM_AREA_MAZE_MAP,
+                                               NVM_MAZE_JOURNAL_MAX_CELLS) == NVM_STATUS_INVALID_ARG);
+    s_bytes = SECTOR_BYTES;
+    expect("init", nvm_maze_journal_init(&s_journal, NVM_AREA_MAZE_JOURNAL, NVM_AREA_MAZE_MAP, CELLS) ==
+                       NVM_STATUS_OK);
+
+    // 空の Flash: NOT_FOUND で cells は変えない
+    for (uint32_t i = 0U; i < CELLS; i++) {
+        cells[i] = (uint16_t)(0xA500U | i);
+    }
+    memcpy(got, cells, sizeof(got));
+    expect("blank", reload(got, &res) == NVM_STATUS_NOT_FOUND && same_cells(got, cells));
+
+    // 最初の保存はセクタ 0 にスナップショット。何も変えずに保存しても書かない
+    memset(cells, 0, sizeof(cells));
+    st = nvm_maze_journal_save(&s_journal, cells, &sres);
+    expect("first save", st == NVM_STATUS_OK && sres.compacted && s_journal.active == 0U &&
+                             s_journal.generation == 1U);
+    st = nvm_maze_journal_save(&s_journal, cells, &sres);
+    expect("no-op save", st == NVM_STATUS_OK && sres.changed == 0U && sres.bytes == 0U && !sres.compacted);
+    st = reload(got, &res);
+    expect("first load", st == NVM_STATUS_OK && same_cells(got, cells) && res.sector == 0U && res.commits == 0U &&
+                             res.torn_words == 0U);
+    last_generation = 1U;
+
+    // 探索の保存を繰り返す: 変えたセル数 + 1 語だけを追記し、埋まったら交互のセクタに切り替える
+    for (uint32_t n = 0U; n < SAVES && s_ok; n++) {
+        memcpy(prev, cells, sizeof(prev));
+        // ときどき全セルを書き換える（大きな追記。残りが足りなければ切り替え）
+        mutate(cells, (n % 29U == 28U) ? CELLS * 4U : 1U + (rand32() % 60U));
+        st = nvm_maze_journal_save(&s_journal, cells, &sres);
+        expect("save", st == NVM_STATUS_OK);
+        if (sres.compacted) {
+            expect("alternate", s_journal.active != last_sector && s_journal.generation == last_generation + 1U);
+            memcpy(before_compact, prev, sizeof(before_compact));
+            last_sector = s_journal.active;
+            last_generation = s_journal.generation;
+            compactions++;
+        } else {
+            expect("append bytes", sres.bytes == (sres.changed + 1U) * 4U);
+            appends++;
+            append_bytes += sres.bytes;
+        }
+        st = reload(got, &res);
+        expect("load", st == NVM_STATUS_OK && same_cells(got, cells) && res.sector == last_sector &&
+                           res.generation == last_generation && res.torn_words == 0U);
+    }
+    erases = s_erases;
+    expect("compacted", compactions >= 3U && erases == compactions + 1U);
+
+    // 新しいセクタのスナップショットが壊れたら、切り替え前の内容（もう一方のセクタ）に戻る
+    s_flash[last_sector][sizeof(nvm_maze_journal_header_t) + 5U] ^= 0x01U;
+    st = reload(got, &res);
+    expect("fallback", st == NVM_STATUS_OK && res.sector != last_sector && res.generation == last_generation - 1U &&
+                           same_cells(got, before_compact));
+    // 壊れたセクタは次の保存で消して使い直す
+    s_journal.scanned = false;
+    st = nvm_maze_journal_save(&s_journal, cells, &sres);
+    st = (st == NVM_STATUS_OK) ? reload(got, &res) : st;
+    expect("fallback save", st == NVM_STATUS_OK && same_cells(got, cells));
+    // 両方とも壊れていれば INTEGRITY_ERROR
+    memcpy(s_flash_saved, s_flash, sizeof(s_flash));
+    s_flash[0][offsetof(nvm_maze_journal_header_t, header_crc)] ^= 0x10U;
+    s_flash[1][offsetof(nvm_maze_journal_header_t, header_crc)] ^= 0x10U;
+    memset(got, 0, sizeof(got));
+    expect("both broken", reload(got, &res) == NVM_STATUS_INTEGRITY_ERROR && got[0] == 0U);
+    memcpy(s_flash, s_flash_saved, sizeof(s_flash));
+    s_journal.scanned = false;
+
+    // 電源断: 続きの保存（追記・全面書き換えでの切り替え・空からの最初の保存）のすべての位置で切る
+    for (uint32_t n = 0U; n < 40U && s_ok; n++) {
+        memcpy(prev, cells, sizeof(prev));
+        mutate(cells, (n % 13U == 12U) ? CELLS * 4U : 1U + (rand32() % 60U));
+        check_power_cut(prev, cells, &cuts, &newer);
+    }
+    check_first_save_cut(cells, &cuts);
+
+    printf("[nvm-maze-journal] cells=%u sector=%uB saves=%u appends=%u (avg %uB) compactions=%u erases=%u "
+           "cuts=%u (new=%u) result=%s\n",
+           (unsigned int)CELLS, (unsigned int)SECTOR_BYTES, (unsigned int)SAVES, (unsigned int)appends,
+           (unsigned int)((appends != 0U) ? (append_bytes / appends) : 0U), (unsigned int)compactions,
+           (unsigned int)erases, (unsigned int)cuts, (unsigned int)newer, s_ok ? "ok" : "NG");
+    return s_ok ? 0 : 1;
+}
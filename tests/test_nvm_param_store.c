@@ -0,0 +1,379 @@
+/*
+ * test_nvm_param_store.c
+ *
+ * nvm/nvm_param_store.c のホスト試験:
+ * 模擬 TUNE_PARAMS 領域（同期書き込みだけ。残りバイト数で電源断を模擬する）に対して、表の検査・
+ * 名前での読み書き・保存と読込・表の変更への耐性・保存の途中で電源が切れても前回の保存が読めることを確かめる。
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "nvm_param_store.h"
+
+#define AREA_BYTES (64U * 1024U)
+#define CURVE_NUM 100U
+
+typedef struct {
+    float accel;
+    uint8_t profile;
+    uint16_t thr;
+} Case;
+
+typedef struct {
+    float gain;
+    int32_t offset;
+    uint16_t thr[3];
+    Case cases[4];
+    float curve[CURVE_NUM];
+} Values;
+
+static bool s_ok = true;
+static uint8_t s_fram[AREA_BYTES];
+static int32_t s_write_budget = -1; // 電源断までに書けるバイト数（負 = 無制限）
+
+static float s_gain = 1.5f;
+static int32_t s_offset = -20;
+static uint16_t s_thr[3] = {100U, 200U, 300U};
+static Case s_cases[4] = {{1000.0f, 0U, 10U}, {2000.0f, 1U, 20U}, {3000.0f, 2U, 30U}, {4000.0f, 0U, 40U}};
+static float s_curve[CURVE_NUM];
+static float s_thr_f = 0.0f;
+
+static const nvm_param_desc_t s_table[] = {
+    {0x0001U, NVM_PARAM_F32, 1U, 0U, "gain", 0.0f, 100.0f, &s_gain},
+    {0x0002U, NVM_PARAM_I32, 1U, 0U, "offset", -500.0f, 500.0f, &s_offset},
+    {0x0003U, NVM_PARAM_U16, 3U, sizeof(uint16_t), "thr", 0.0f, 4095.0f, s_thr},
+    {0x0010U, NVM_PARAM_F32, 4U, sizeof(Case), "case_accel", 0.0f, 20000.0f, &s_cases[0].accel},
+    {0x0011U, NVM_PARAM_U8, 4U, sizeof(Case), "case_profile", 0.0f, 2.0f, &s_cases[0].profile},
+    {0x0012U, NVM_PARAM_U16, 4U, sizeof(Case), "case_thr", 0.0f, 1000.0f, &s_cases[0].thr},
+    {0x0020U, NVM_PARAM_F32, CURVE_NUM, sizeof(float), "curve", -1000.0f, 1000.0f, s_curve},
+};
+
+// 後の版の表: gain の範囲を狭め、offset を外し、case_profile を 1 要素に減らし、thr の型を変えた
+static const nvm_param_desc_t s_table_v2[] = {
+    {0x0001U, NVM_PARAM_F32, 1U, 0U, "gain", 0.0f, 10.0f, &s_gain},
+    {0x0003U, NVM_PARAM_F32, 1U, 0U, "thr", 0.0f, 4095.0f, &s_thr_f},
+    {0x0010U, NVM_PARAM_F32, 4U, sizeof(Case), "case_accel", 0.0f, 20000.0f, &s_cases[0].accel},
+    {0x0011U, NVM_PARAM_U8, 1U, 0U, "case_profile", 0.0f, 2.0f, &s_cases[0].profile},
+    {0x0020U, NVM_PARAM_F32, CURVE_NUM, sizeof(float), "curve", -1000.0f, 1000.0f, s_curve},
+};
+
+#define TABLE_NUM ((uint32_t)(sizeof(s_table) / sizeof(s_table[0])))
+#define TABLE_V2_NUM ((uint32_t)(sizeof(s_table_v2) / sizeof(s_table_v2[0])))
+
+static nvm_param_store_t s_store;
+static nvm_param_store_t s_store_v2;
+static nvm_param_store_t s_store_saved;
+static uint8_t s_fram_saved[NVM_PARAM_STORE_SLOT_BYTES * NVM_PARAM_STORE_SLOT_COUNT];
+
+static void expect(const char *what, bool cond)
+{
+    if (!cond) {
+        printf("[nvm-param-store] NG: %s\n", what);
+        s_ok = false;
+    }
+}
+
+//-------------------------------------------------------------
+// 模擬 FRAM（nvm.c の代わり）
+//-------------------------------------------------------------
+
+nvm_status_t nvm_get_area_info(nvm_area_t area, nvm_area_info_t *out)
+{
+    if (area != NVM_AREA_TUNE_PARAMS || out == NULL) {
+        return NVM_STATUS_UNSUPPORTED;
+    }
+    out->area = area;
+    out->base_address = 0x00030000UL;
+    out->size_bytes = AREA_BYTES;
+    out->schema_version = NVM_PARAM_STORE_SCHEMA_VERSION;
+    return NVM_STATUS_OK;
+}
+
+nvm_status_t nvm_read(nvm_area_t area, uint32_t offset, void *out, size_t len)
+{
+    if (area != NVM_AREA_TUNE_PARAMS || (size_t)offset + len > AREA_BYTES) {
+        return NVM_STATUS_INVALID_ARG;
+    }
+    memcpy(out, &s_fram[offset], len);
+    return NVM_STATUS_OK;
+}
+
+nvm_status_t nvm_write(nvm_area_t area, uint32_t offset, const void *data, size_t len)
+{
+    if (area != NVM_AREA_TUNE_PARAMS || (size_t)offset + len > AREA_BYTES) {
+        return NVM_STATUS_INVALID_ARG;
+    }
+    // 電源断: 書けた分だけ残して止まる（FRAM は先頭から 1 バイトずつ書かれる）
+    if (s_write_budget >= 0 && len > (size_t)s_write_budget) {
+        memcpy(&s_fram[offset], data, (size_t)s_write_budget);
+        s_write_budget = 0;
+        return NVM_STATUS_HW_ERROR;
+    }
+    memcpy(&s_fram[offset], data, len);
+    if (s_write_budget >= 0) {
+        s_write_budget -= (int32_t)len;
+    }
+    return NVM_STATUS_OK;
+}
+
+// FRAM の erase は何もしない（古い内容が残る）
+nvm_status_t nvm_erase(nvm_area_t area)
+{
+    return (area == NVM_AREA_TUNE_PARAMS) ? NVM_STATUS_OK : NVM_STATUS_UNSUPPORTED;
+}
+
+//-------------------------------------------------------------
+// 試験
+//-------------------------------------------------------------
+
+// 構造体の詰め物も含めて丸ごと写す（比較を memcmp で済ませる）
+static void capture_values(Values *v)
+{
+    memset(v, 0, sizeof(*v));
+    v->gain = s_gain;
+    v->offset = s_offset;
+    memcpy(v->thr, s_thr, sizeof(v->thr));
+    memcpy(v->cases, s_cases, sizeof(v->cases));
+    memcpy(v->curve, s_curve, sizeof(v->curve));
+}
+
+static void apply_values(const Values *v)
+{
+    s_gain = v->gain;
+    s_offset = v->offset;
+    memcpy(s_thr, v->thr, sizeof(s_thr));
+    memcpy(s_cases, v->cases, sizeof(s_cases));
+    memcpy(s_curve, v->curve, sizeof(s_curve));
+}
+
+static bool same_values(const Values *v)
+{
+    Values now;
+
+    capture_values(&now);
+    return memcmp(&now, v, sizeof(now)) == 0;
+}
+
+static nvm_status_t reload(nvm_param_store_t *s, nvm_param_load_result_t *res)
+{
+    nvm_param_store_reset_defaults(s);
+    memset(res, 0, sizeof(*res));
+    return nvm_param_store_load(s, res);
+}
+
+// 表の誤りを init が拒むこと
+static void check_table(void)
+{
+    static nvm_param_store_t s;
+    static const char long_name[] = "a_parameter_name_that_is_far_too_long_for_the_cli";
+    nvm_param_desc_t t[2];
+    float f = 1.0f;
+    uint8_t u8 = 3U;
+
+    t[0] = (nvm_param_desc_t){0x01U, NVM_PARAM_F32, 1U, 0U, "a", 0.0f, 10.0f, &f};
+    t[1] = t[0];
+    t[1].name = "b";
+    expect("dup id", nvm_param_store_init(&s, NVM_AREA_TUNE_PARAMS, t, 2U) == NVM_STATUS_INVALID_ARG);
+    t[1].id = 0x02U;
+    t[1].name = "a";
+    expect("dup name", nvm_param_store_init(&s, NVM_AREA_TUNE_PARAMS, t, 2U) == NVM_STATUS_INVALID_ARG);
+    t[1].name = "b";
+    expect("valid", nvm_param_store_init(&s, NVM_AREA_TUNE_PARAMS, t, 2U) == NVM_STATUS_OK && s.values == 2U);
+    t[1] = (nvm_param_desc_t){0x02U, NVM_PARAM_U8, 1U, 0U, "b", 0.0f, 300.0f, &u8};
+    expect("u8 range", nvm_param_store_init(&s, NVM_AREA_TUNE_PARAMS, t, 2U) == NVM_STATUS_INVALID_ARG);
+    t[1].max = 2.0f;
+    expect("default out of range", nvm_param_store_init(&s, NVM_AREA_TUNE_PARAMS, t, 2U) == NVM_STATUS_INVALID_ARG);
+    t[1].max = 5.0f;
+    t[1].count = 0U;
+    expect("count 0", nvm_param_store_init(&s, NVM_AREA_TUNE_PARAMS, t, 2U) == NVM_STATUS_INVALID_ARG);
+    t[1].count = 2U;
+    expect("stride", nvm_param_store_init(&s, NVM_AREA_TUNE_PARAMS, t, 2U) == NVM_STATUS_INVALID_ARG);
+    t[1].count = 1U;
+    t[1].min = 6.0f;
+    expect("min > max", nvm_param_store_init(&s, NVM_AREA_TUNE_PARAMS, t, 2U) == NVM_STATUS_INVALID_ARG);
+    t[1].min = 0.0f;
+    t[1].name = long_name;
+    expect("long name", nvm_param_store_init(&s, NVM_AREA_TUNE_PARAMS, t, 2U) == NVM_STATUS_INVALID_ARG);
+}
+
+// 名前の解釈・文字列での設定・表示
+static void check_names(void)
+{
+    const nvm_param_store_t *s = &s_store;
+    uint32_t index = 99U;
+    char line[NVM_PARAM_STORE_NAME_MAX + 24U];
+
+    expect("find scalar", nvm_param_store_find(s, "gain", &index) == &s_table[0] && index == 0U);
+    expect("find scalar[0]", nvm_param_store_find(s, "gain[0]", &index) == &s_table[0]);
+    expect("find scalar[1]", nvm_param_store_find(s, "gain[1]", &index) == NULL);
+    expect("find array", nvm_param_store_find(s, "thr[2]", &index) == &s_table[2] && index == 2U);
+    expect("array needs index", nvm_param_store_find(s, "thr", &index) == NULL);
+    expect("index range", nvm_param_store_find(s, "thr[3]", &index) == NULL);
+    expect("bad index", nvm_param_store_find(s, "thr[x]", &index) == NULL &&
+                            nvm_param_store_find(s, "thr[1]x", &index) == NULL);
+    expect("prefix", nvm_param_store_find(s, "gai", &index) == NULL && nvm_param_store_find(s, "case", &index) == NULL);
+
+    expect("set f32", nvm_param_store_set_text(s, "gain", "12.5") == NVM_STATUS_OK && s_gain == 12.5f);
+    expect("f32 range", nvm_param_store_set_text(s, "gain", "200") == NVM_STATUS_INVALID_ARG && s_gain == 12.5f);
+    expect("nan", nvm_param_store_set_text(s, "gain", "nan") == NVM_STATUS_INVALID_ARG);
+    expect("set i32", nvm_param_store_set_text(s, "offset", "-300") == NVM_STATUS_OK && s_offset == -300);
+    expect("set u8", nvm_param_store_set_text(s, "case_profile[1]", "2") == NVM_STATUS_OK &&
+                         s_cases[1].profile == 2U);
+    expect("u8 range", nvm_param_store_set_text(s, "case_profile[1]", "3") == NVM_STATUS_INVALID_ARG);
+    expect("u8 fraction", nvm_param_store_set(&s_table[4], 1U, 1.5f) == NVM_STATUS_INVALID_ARG &&
+                              s_cases[1].profile == 2U);
+    expect("not a number", nvm_param_store_set_text(s, "thr[1]", "abc") == NVM_STATUS_INVALID_ARG &&
+                               nvm_param_store_set_text(s, "thr[1]", "12x") == NVM_STATUS_INVALID_ARG &&
+                               s_thr[1] == 200U);
+    expect("unknown", nvm_param_store_set_text(s, "nope", "1") == NVM_STATUS_NOT_FOUND);
+    expect("changed", nvm_param_store_changed_count(s) == 3U && !nvm_param_store_is_default(s, &s_table[0], 0U) &&
+                          nvm_param_store_is_default(s, &s_table[2], 1U) &&
+                          nvm_param_store_default(s, &s_table[0], 0U) == 1.5f);
+
+    (void)nvm_param_store_format(&s_table[0], 0U, line, sizeof(line));
+    expect("format f32", strcmp(line, "gain=12.5") == 0);
+    (void)nvm_param_store_format(&s_table[1], 0U, line, sizeof(line));
+    expect("format i32", strcmp(line, "offset=-300") == 0);
+    (void)nvm_param_store_format(&s_table[4], 1U, line, sizeof(line));
+    expect("format u8", strcmp(line, "case_profile[1]=2") == 0);
+    expect("format truncate", nvm_param_store_format(&s_table[0], 0U, line, 5U) == 4U && strcmp(line, "gain") == 0);
+}
+
+// 保存の途中（先頭から cut バイト）で電源が切れても、読めるのは前回の保存か今回の保存のどちらか。
+// 最後まで書けば今回の保存
+static void check_power_cut(const Values *before, const Values *after, uint32_t *out_cuts, uint32_t *out_newer)
+{
+    uint32_t total = (uint32_t)sizeof(nvm_param_blob_header_t) +
+                     nvm_param_store_changed_count(&s_store) * (uint32_t)sizeof(nvm_param_blob_entry_t);
+    uint32_t bad = 0U;
+    uint32_t newer = 0U;
+    uint32_t seq = s_store.seq;
+
+    memcpy(s_fram_saved, s_fram, sizeof(s_fram_saved));
+    s_store_saved = s_store;
+    for (uint32_t cut = 0U; cut <= total; cut++) {
+        nvm_param_load_result_t res;
+        nvm_status_t st;
+        bool done = (cut == total);
+
+        memcpy(s_fram, s_fram_saved, sizeof(s_fram_saved));
+        s_store = s_store_saved;
+        apply_values(after);
+        s_write_budget = (int32_t)cut;
+        st = nvm_param_store_save(&s_store);
+        s_write_budget = -1;
+        if (st != (done ? NVM_STATUS_OK : NVM_STATUS_HW_ERROR)) {
+            bad++;
+            continue;
+        }
+        // 書き残りが元の内容と同じバイトだけなら今回の保存が有効になってよい（混ざらなければよい）
+        st = reload(&s_store, &res);
+        if (st == NVM_STATUS_OK && res.seq == seq + 1U) {
+            newer++;
+        }
+        if (st != NVM_STATUS_OK || (done && res.seq != seq + 1U) ||
+            !((res.seq == seq && same_values(before)) || (res.seq == seq + 1U && same_values(after)))) {
+            if (bad == 0U) {
+                printf("[nvm-param-store] cut=%u/%u st=%d seq=%u\n", (unsigned int)cut, (unsigned int)total,
+                       (int)st, (unsigned int)res.seq);
+            }
+            bad++;
+        }
+    }
+    *out_cuts = total + 1U;
+    *out_newer = newer;
+    expect("power cut", bad == 0U);
+}
+
+int main(void)
+{
+    static Values a;
+    static Values b;
+    static Values c;
+    const uint32_t body = NVM_PARAM_STORE_SLOT_BYTES + (uint32_t)sizeof(nvm_param_blob_header_t);
+    nvm_param_load_result_t res;
+    nvm_status_t st;
+    uint32_t cuts = 0U;
+    uint32_t newer = 0U;
+
+    for (uint32_t i = 0U; i < CURVE_NUM; i++) {
+        s_curve[i] = 0.5f * (float)i;
+    }
+
+    check_table();
+    expect("init", nvm_param_store_init(&s_store, NVM_AREA_TUNE_PARAMS, s_table, TABLE_NUM) == NVM_STATUS_OK &&
+                       s_store.values == 1U + 1U + 3U + 4U * 3U + CURVE_NUM);
+    check_names();
+
+    // 空の領域: NOT_FOUND で値は変えない
+    capture_values(&a);
+    expect("blank", nvm_param_store_load(&s_store, &res) == NVM_STATUS_NOT_FOUND && same_values(&a));
+
+    // 保存 → 既定値に戻す → 読込で元に戻る（32 要素ずつの読み書きをまたぐ数を変える）
+    for (uint32_t i = 0U; i < 40U; i++) {
+        s_curve[i] = -(float)(i + 1U);
+    }
+    capture_values(&a);
+    expect("save 1", nvm_param_store_save(&s_store) == NVM_STATUS_OK && s_store.slot == 0U && s_store.seq == 1U);
+    st = reload(&s_store, &res);
+    expect("load 1", st == NVM_STATUS_OK && res.applied == 43U && res.skipped == 0U && res.slot == 0U &&
+                         res.seq == 1U && same_values(&a));
+
+    // 次の保存は反対のスロットへ。読込は新しい方
+    s_thr[2] = 4000U;
+    capture_values(&b);
+    expect("save 2", nvm_param_store_save(&s_store) == NVM_STATUS_OK && s_store.slot == 1U && s_store.seq == 2U);
+    st = reload(&s_store, &res);
+    expect("load 2", st == NVM_STATUS_OK && res.applied == 44U && res.slot == 1U && same_values(&b));
+
+    // 新しい方が壊れていれば古い方、両方壊れていれば INTEGRITY_ERROR で値は変えない
+    s_fram[body + 3U] ^= 0x40U;
+    st = reload(&s_store, &res);
+    expect("fallback", st == NVM_STATUS_OK && res.slot == 0U && res.seq == 1U && same_values(&a));
+    s_fram[sizeof(nvm_param_blob_header_t) + 5U] ^= 0x01U;
+    expect("both corrupt", nvm_param_store_load(&s_store, &res) == NVM_STATUS_INTEGRITY_ERROR && same_values(&a));
+    s_fram[body + 3U] ^= 0x40U;
+    s_fram[sizeof(nvm_param_blob_header_t) + 5U] ^= 0x01U;
+
+    // 表が変わった後の版で読む: 無くなった id・型違い・要素外・範囲外は読み飛ばす
+    nvm_param_store_reset_defaults(&s_store);
+    expect("init v2", nvm_param_store_init(&s_store_v2, NVM_AREA_TUNE_PARAMS, s_table_v2, TABLE_V2_NUM) ==
+                          NVM_STATUS_OK);
+    st = nvm_param_store_load(&s_store_v2, &res);
+    expect("load v2", st == NVM_STATUS_OK && res.applied == 40U && res.skipped == 4U && s_gain == 1.5f &&
+                          s_offset == -20 && s_thr_f == 0.0f && memcmp(s_curve, b.curve, sizeof(s_curve)) == 0);
+
+    // 電源断: 保存の全バイト位置で切る
+    st = reload(&s_store, &res);
+    expect("reload", st == NVM_STATUS_OK && res.seq == 2U && same_values(&b));
+    s_gain = 50.0f;
+    for (uint32_t i = 50U; i < 80U; i++) {
+        s_curve[i] = 7.0f;
+    }
+    capture_values(&c);
+    check_power_cut(&b, &c, &cuts, &newer);
+
+    // seq が一周しても新しい方を選ぶ（0 は使わない）
+    memset(s_fram, 0, sizeof(s_fram));
+    apply_values(&a);
+    s_store.seq = 0xFFFFFFFEUL;
+    s_store.slot = 1U;
+    expect("wrap save", nvm_param_store_save(&s_store) == NVM_STATUS_OK && s_store.slot == 0U &&
+                            s_store.seq == 0xFFFFFFFFUL);
+    apply_values(&b);
+    expect("wrap save 2", nvm_param_store_save(&s_store) == NVM_STATUS_OK && s_store.slot == 1U &&
+                              s_store.seq == 1U);
+    st = reload(&s_store, &res);
+    expect("wrap load", st == NVM_STATUS_OK && res.slot == 1U && res.seq == 1U && same_values(&b));
+
+    printf("[nvm-param-store] params=%u values=%u entry=%uB slot=%uB (max %u entries) cuts=%u (new=%u) result=%s\n",
+           (unsigned int)TABLE_NUM, (unsigned int)s_store.values, (unsigned int)sizeof(nvm_param_blob_entry_t),
+           (unsigned int)NVM_PARAM_STORE_SLOT_BYTES,
+           (unsigned int)((NVM_PARAM_STORE_SLOT_BYTES - sizeof(nvm_param_blob_header_t)) /
+                          sizeof(nvm_param_blob_entry_t)),
+           (unsigned int)cuts, (unsigned int)newer, s_ok ? "ok" : "NG");
+    return s_ok ? 0 : 1;
+}
@@ -0,0 +1,542 @@
+/*
+ * test_nvm_trace_codec.c
+ *
+ * nvm/nvm_trace_codec.c + nvm/nvm_trace_log.c のホスト試験:
+ * F413 と同じ大きさの TRACE_LOG 領域を模擬 FRAM 配列で持ち、nvm_read / nvm_write / nvm_write_async を
+ * ここで実装して nvm_trace_log.c をそのまま動かす。非同期書き込みは完了時にデータを写すので、
+ * 完了前に呼び出し側がバッファを書き換えると内容の不一致として出る。
+ * ブロック単位の符号化・復号、領域を何周もさせた追記と読み出し、範囲読み出し、壊れたブロックからの
+ * 復帰を確かめ、同じ領域に非圧縮で入る件数との比（模擬走行で 4 倍以上）を出す。
+ *
+ * usage: test_nvm_trace_codec [BIN_OUT]
+ *   BIN_OUT を渡すと、実機の UART '<' / '>' バイナリダンプと同じフレーム（v2）を書き出す
+ *   （tools/logging/trace_bin_dump.py の復号確認用）。
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "nvm_trace_codec.h"
+#include "nvm_trace_log.h"
+#include "trace_record_sim.h"
+
+#define AREA_BYTES (1024U * 1024U - 0x60000U)
+#define PENDING_MAX 16U
+#define RAW_RECORDS ((AREA_BYTES - (uint32_t)sizeof(nvm_trace_log_header_t)) / (uint32_t)sizeof(nvm_trace_log_record_t))
+
+typedef struct {
+    uint32_t offset;
+    const void *data;
+    size_t len;
+    nvm_write_done_fn done;
+    void *ctx;
+} Pending;
+
+static bool s_ok = true;
+static uint8_t s_fram[AREA_BYTES];
+static Pending s_pending[PENDING_MAX];
+static uint32_t s_pending_head = 0U;
+static uint32_t s_pending_count = 0U;
+static uint32_t s_rng = 0x2468ACE1U;
+static uint32_t s_done_count = 0U;
+static uint32_t s_read_calls = 0U; // nvm_read の回数（SPI 転送の回数に相当）
+static uint32_t s_read_bytes = 0U;
+
+static void expect(const char *what, bool cond)
+{
+    if (!cond) {
+        printf("[nvm-trace-codec] NG: %s\n", what);
+        s_ok = false;
+    }
+}
+
+static uint32_t rand32(void)
+{
+    s_rng ^= s_rng << 13;
+    s_rng ^= s_rng >> 17;
+    s_rng ^= s_rng << 5;
+    return s_rng;
+}
+
+//-------------------------------------------------------------
+// 模擬 FRAM（nvm.c の代わり）
+//-------------------------------------------------------------
+
+static void complete_one(void)
+{
+    Pending *p = &s_pending[s_pending_head];
+
+    memcpy(&s_fram[p->offset], p->data, p->len);
+    s_pending_head = (s_pending_head + 1U) % PENDING_MAX;
+    s_pending_count--;
+    if (p->done != NULL) {
+        p->done(NVM_STATUS_OK, p->ctx);
+    }
+}
+
+static void drain(void)
+{
+    while (s_pending_count != 0U) {
+        complete_one();
+    }
+}
+
+nvm_status_t nvm_get_area_info(nvm_area_t area, nvm_area_info_t *out)
+{
+    if (area != NVM_AREA_TRACE_LOG || out == NULL) {
+        return NVM_STATUS_UNSUPPORTED;
+    }
+    out->area = area;
+    out->base_address = 0x00060000UL;
+    out->size_bytes = AREA_BYTES;
+    out->schema_version = NVM_TRACE_LOG_SCHEMA_VERSION;
+    return NVM_STATUS_OK;
+}
+
+// 同期の読み書きは nvm.c と同じく、先に積んだ非同期書き込みの後に行う
+nvm_status_t nvm_read(nvm_area_t area, uint32_t offset, void *out, size_t len)
+{
+    if (area != NVM_AREA_TRACE_LOG || (size_t)offset + len > AREA_BYTES) {
+        return NVM_STATUS_INVALID_ARG;
+    }
+    drain();
+    memcpy(out, &s_fram[offset], len);
+    s_read_calls++;
+    s_read_bytes += (uint32_t)len;
+    return NVM_STATUS_OK;
+}
+
+nvm_status_t nvm_write(nvm_area_t area, uint32_t offset, const void *data, size_t len)
+{
+    if (area != NVM_AREA_TRACE_LOG || (size_t)offset + len > AREA_BYTES) {
+        return NVM_STATUS_INVALID_ARG;
+    }
+    drain();
+    memcpy(&s_fram[offset], data, len);
+    return NVM_STATUS_OK;
+}
+
+// FRAM の erase は何もしない（古い内容が残る）
+nvm_status_t nvm_erase(nvm_area_t area)
+{
+    return (area == NVM_AREA_TRACE_LOG) ? NVM_STATUS_OK : NVM_STATUS_UNSUPPORTED;
+}
+
+nvm_status_t nvm_write_async(nvm_area_t area, uint32_t offset, const void *data, size_t len,
+                             nvm_write_done_fn done, void *ctx)
+{
+    Pending *p;
+
+    if (area != NVM_AREA_TRACE_LOG || (size_t)offset + len > AREA_BYTES) {
+        return NVM_STATUS_INVALID_ARG;
+    }
+    if (s_pending_count == PENDING_MAX) {
+        complete_one();
+    }
+    p = &s_pending[(s_pending_head + s_pending_count) % PENDING_MAX];
+    p->offset = offset;
+    p->data = data;
+    p->len = len;
+    p->done = done;
+    p->ctx = ctx;
+    s_pending_count++;
+    // 完了は不定期に進める（DMA が IMU 読取の合間に送る様子）
+    for (uint32_t n = rand32() % 3U; n > 0U && s_pending_count > 0U; n--) {
+        complete_one();
+    }
+    return NVM_STATUS_OK;
+}
+
+nvm_status_t nvm_write_barrier(uint32_t timeout_ms)
+{
+    (void)timeout_ms;
+    drain();
+    return NVM_STATUS_OK;
+}
+
+//-------------------------------------------------------------
+// 試験
+//-------------------------------------------------------------
+
+static void record_done(nvm_status_t status, void *ctx)
+{
+    (void)ctx;
+    if (status == NVM_STATUS_OK) {
+        s_done_count++;
+    }
+}
+
+// 全フィールドを任意の値にしたレコード（符号化長の上限・周回・符号拡張の確認用）
+static void fill_random(nvm_trace_log_record_t *rec)
+{
+    uint8_t *p = (uint8_t *)rec;
+
+    for (size_t k = 0; k < sizeof(*rec); k++) {
+        p[k] = (uint8_t)rand32();
+    }
+}
+
+// ブロック単位の符号化・復号を直接確かめる（キーフレーム間隔・収まらない時の拒否・壊れたブロック）
+static void check_blocks(void)
+{
+    static uint8_t image[NVM_TRACE_CODEC_BLOCK_BYTES];
+    static nvm_trace_log_record_t recs[NVM_TRACE_CODEC_KEYFRAME_INTERVAL];
+    nvm_trace_codec_state_t st;
+    nvm_trace_block_cursor_t cur;
+    nvm_trace_log_record_t got;
+    uint32_t off;
+    uint32_t len;
+    uint32_t max_len = 0U;
+    uint32_t count;
+
+    for (uint32_t round = 0U; round < 200U && s_ok; round++) {
+        bool random = (round % 2U) == 0U;
+
+        nvm_trace_block_init(&st, image);
+        count = 0U;
+        while (count < NVM_TRACE_CODEC_KEYFRAME_INTERVAL) {
+            if (random) {
+                fill_random(&recs[count]);
+            } else {
+                trace_record_sim_fill(&recs[count], round * 1000U + count, false);
+            }
+            if (!nvm_trace_block_append(&st, image, sizeof(image), &recs[count], &off, &len)) {
+                break;
+            }
+            if (len > max_len) {
+                max_len = len;
+            }
+            count++;
+        }
+        // 断ったレコードは何度渡しても断り、ブロックの内容も変えない
+        expect("full block rejects", count > 0U && (count == NVM_TRACE_CODEC_KEYFRAME_INTERVAL ||
+                                                    !nvm_trace_block_append(&st, image, sizeof(image), &recs[count],
+                                                                            &off, &len)));
+        expect("cursor init", nvm_trace_block_cursor_init(&cur, image, sizeof(image)));
+        for (uint32_t k = 0U; k < count && s_ok; k++) {
+            expect("block decode", nvm_trace_block_cursor_next(&cur, &got) &&
+                                       memcmp(&got, &recs[k], sizeof(got)) == 0);
+        }
+        expect("block end", !nvm_trace_block_cursor_next(&cur, &got));
+        // ペイロードを 1 バイト壊すとチェックサムで弾く
+        image[sizeof(nvm_trace_block_header_t) + (rand32() % 8U)] ^= 0x10U;
+        expect("corrupt block", !nvm_trace_block_cursor_init(&cur, image, sizeof(image)));
+    }
+    // 変化のないレコードはバイト数では閉じないので、キーフレームの間隔で閉じる
+    nvm_trace_block_init(&st, image);
+    trace_record_sim_fill(&recs[0], 0U, true);
+    for (count = 0U; nvm_trace_block_append(&st, image, sizeof(image), &recs[0], &off, &len); count++) {
+    }
+    expect("keyframe interval", count == NVM_TRACE_CODEC_KEYFRAME_INTERVAL);
+    expect("record max", max_len <= NVM_TRACE_CODEC_RECORD_MAX_BYTES);
+    printf("[nvm-trace-codec] blocks: record_max=%u (limit %u)\n", (unsigned int)max_len,
+           (unsigned int)NVM_TRACE_CODEC_RECORD_MAX_BYTES);
+}
+
+/* nvm_trace_log.c で records 件を追記する（自動収集と同じく非同期・8 件ごとにヘッダ確定。
+ * sync_every 件ごとに同期 append を混ぜる）。 */
+static void fill_log(uint32_t records, bool idle, uint32_t sync_every)
+{
+    nvm_trace_log_header_t header;
+    nvm_trace_log_record_t rec;
+    uint32_t uncommitted = 0U;
+
+    if (nvm_trace_log_format() != NVM_STATUS_OK || nvm_trace_log_get_header(&header) != NVM_STATUS_OK) {
+        expect("format", false);
+        return;
+    }
+    s_done_count = 0U;
+    for (uint32_t i = 0U; i < records; i++) {
+        nvm_status_t st;
+        uint8_t commit = (uncommitted + 1U >= 8U) ? 1U : 0U;
+
+        trace_record_sim_fill(&rec, i, idle);
+        if (sync_every != 0U && (i % sync_every) == sync_every - 1U) {
+            st = nvm_trace_log_append_cached(&header, &rec, commit);
+            s_done_count++;
+        } else {
+            st = nvm_trace_log_append_cached_async(&header, &rec, commit, record_done, NULL);
+        }
+        // 自動収集のリングと同じく、呼び出し後すぐに同じ領域を次のレコードで上書きする
+        memset(&rec, 0xA5, sizeof(rec));
+        if (st != NVM_STATUS_OK) {
+            printf("[nvm-trace-codec] NG: append i=%u NVM=%d\n", (unsigned int)i, (int)st);
+            s_ok = false;
+            return;
+        }
+        uncommitted = commit ? 0U : uncommitted + 1U;
+    }
+    expect("commit", nvm_trace_log_commit_header(&header) == NVM_STATUS_OK &&
+                         nvm_write_barrier(0U) == NVM_STATUS_OK);
+    expect("done callbacks", s_done_count == records);
+}
+
+// 保存済みの全レコードを古い順（CSV ダンプと同じ順）に読み、生成し直した値と比べる
+static void verify_log(bool idle, uint32_t *out_stored, uint32_t *out_bytes)
+{
+    nvm_trace_log_header_t header;
+    nvm_trace_log_record_t got;
+    nvm_trace_log_record_t want;
+    uint32_t stored = 0U;
+    uint32_t bytes = 0U;
+
+    *out_stored = 0U;
+    *out_bytes = 0U;
+    if (nvm_trace_log_get_header(&header) != NVM_STATUS_OK ||
+        nvm_trace_log_get_stored(&header, &stored, &bytes) != NVM_STATUS_OK) {
+        expect("stored", false);
+        return;
+    }
+    expect("stored", stored > 0U && stored <= header.total_records);
+    // 上書きで失うのは最も古いブロックの分だけ
+    expect("ring keeps newest", (header.total_blocks <= header.block_count)
+                                    ? stored == header.total_records
+                                    : bytes > (header.block_count - 1U) * (NVM_TRACE_CODEC_BLOCK_BYTES / 2U));
+    for (uint32_t i = stored; i > 0U && s_ok; i--) {
+        uint32_t seq = header.total_records - i;
+
+        trace_record_sim_fill(&want, seq, idle);
+        expect("read_latest", nvm_trace_log_read_latest(i - 1U, &got) == NVM_STATUS_OK &&
+                                  memcmp(&got, &want, sizeof(got)) == 0);
+        if (!s_ok) {
+            printf("[nvm-trace-codec] mismatch at newest-%u seq=%u got_seq=%u\n", (unsigned int)(i - 1U),
+                   (unsigned int)seq, (unsigned int)got.seq);
+        }
+    }
+    // 読む順を変えても同じ（新しい順・飛び飛び）
+    for (uint32_t n = 0U; n < 2000U && s_ok; n++) {
+        uint32_t i = (n < 1000U) ? n : (rand32() % stored);
+
+        if (i >= stored) {
+            break;
+        }
+        trace_record_sim_fill(&want, header.total_records - 1U - i, idle);
+        expect("random read", nvm_trace_log_read_latest(i, &got) == NVM_STATUS_OK &&
+                                  memcmp(&got, &want, sizeof(got)) == 0);
+    }
+    expect("past end", nvm_trace_log_read_latest(stored, &got) == NVM_STATUS_NOT_FOUND);
+    *out_stored = stored;
+    *out_bytes = bytes;
+}
+
+/* 範囲読み出し（CSV / バイナリダンプ用）が read_latest と同じ内容を古い順に返すこと。
+ * 件数は領域の周回・ブロックの途中・端数の burst（ブロック数が burst の倍数でない）をまたぐ値を選ぶ。 */
+static void check_stream(bool idle)
+{
+    static const uint32_t counts[] = {1U, 43U, 44U, 45U, 64U, 1000U, 4097U, 0U, 0xFFFFFFFFU};
+    nvm_trace_log_header_t header;
+    nvm_trace_log_record_t got;
+    nvm_trace_log_record_t want_rec;
+    const uint8_t *image;
+    uint32_t stored = 0U;
+    uint32_t len;
+    uint32_t recs;
+    uint32_t calls;
+    uint32_t bytes;
+    uint32_t latest_calls;
+    uint32_t latest_bytes;
+
+    expect("stream header", nvm_trace_log_get_header(&header) == NVM_STATUS_OK &&
+                                nvm_trace_log_get_stored(&header, &stored, NULL) == NVM_STATUS_OK);
+    for (uint32_t c = 0U; c < sizeof(counts) / sizeof(counts[0]) && s_ok; c++) {
+        uint32_t want = (counts[c] == 0U || counts[c] > stored) ? stored : counts[c];
+        uint32_t n = 0U;
+        uint32_t covered = 0U;
+
+        expect("stream open", nvm_trace_log_stream_open(counts[c], &n) == NVM_STATUS_OK && n == want);
+        for (uint32_t k = 0U; k < n && s_ok; k++) {
+            trace_record_sim_fill(&want_rec, header.total_records - n + k, idle);
+            expect("stream record", nvm_trace_log_stream_next(&got) == NVM_STATUS_OK &&
+                                        memcmp(&got, &want_rec, sizeof(got)) == 0);
+        }
+        expect("stream end", nvm_trace_log_stream_next(&got) == NVM_STATUS_NOT_FOUND);
+
+        // ブロック単位: 最初のブロックだけ要求より古いレコードを含みうる
+        expect("stream reopen", nvm_trace_log_stream_open(counts[c], NULL) == NVM_STATUS_OK);
+        while (s_ok && nvm_trace_log_stream_next_block(&image, &len, &recs) == NVM_STATUS_OK) {
+            nvm_trace_block_cursor_t cur;
+            expect("stream block", recs > 0U && nvm_trace_block_cursor_init(&cur, image, len));
+            covered += recs;
+        }
+        expect("stream blocks cover", covered >= want && covered < want + 64U);
+        nvm_trace_log_stream_close();
+    }
+
+    // 全件を読むときの FRAM 読み出し回数・バイト数（read_latest を件数分呼ぶ場合と比べる）
+    s_read_calls = 0U;
+    s_read_bytes = 0U;
+    expect("stream all", nvm_trace_log_stream_open(0U, NULL) == NVM_STATUS_OK);
+    while (nvm_trace_log_stream_next(&got) == NVM_STATUS_OK) {
+    }
+    calls = s_read_calls;
+    bytes = s_read_bytes;
+    s_read_calls = 0U;
+    s_read_bytes = 0U;
+    for (uint32_t i = stored; i > 0U; i--) {
+        (void)nvm_trace_log_read_latest(i - 1U, &got);
+    }
+    latest_calls = s_read_calls;
+    latest_bytes = s_read_bytes;
+    printf("[nvm-trace-codec] stream: records=%u nvm_read=%u bytes=%u (read_latest: nvm_read=%u bytes=%u)\n",
+           (unsigned int)stored, (unsigned int)calls, (unsigned int)bytes, (unsigned int)latest_calls,
+           (unsigned int)latest_bytes);
+    expect("stream fewer reads", calls * 10U < latest_calls);
+}
+
+// 閉じたブロックを 1 つ壊しても、そのブロックだけが読めず前後のブロックは読めること
+static void check_resync(void)
+{
+    static uint8_t image[NVM_TRACE_CODEC_BLOCK_BYTES];
+    nvm_trace_log_header_t header;
+    nvm_trace_log_record_t got;
+    uint32_t len;
+    uint32_t recs;
+    uint32_t newer = 0U;
+    uint32_t bad_recs = 0U;
+    uint32_t block;
+    uint32_t want;
+    uint32_t seq;
+    uint32_t errors = 0U;
+    uint32_t returned = 0U;
+    nvm_status_t st;
+
+    expect("resync header", nvm_trace_log_get_header(&header) == NVM_STATUS_OK);
+    for (uint32_t age = 0U; age < 3U && s_ok; age++) {
+        expect("resync block", nvm_trace_log_read_block(&header, age, image, sizeof(image), &len, &recs) ==
+                                   NVM_STATUS_OK);
+        newer += (age < 2U) ? recs : 0U;
+        if (age == 2U) {
+            bad_recs = recs;
+        }
+    }
+    if (!s_ok) {
+        return;
+    }
+    block = (header.write_block + header.block_count - 2U) % header.block_count;
+    s_fram[sizeof(nvm_trace_log_header_t) + block * NVM_TRACE_CODEC_BLOCK_BYTES + sizeof(nvm_trace_block_header_t) +
+           3U] ^= 0x40U;
+    expect("corrupt block rejected", nvm_trace_log_read_block(&header, 2U, image, sizeof(image), &len, &recs) ==
+                                         NVM_STATUS_INTEGRITY_ERROR);
+    expect("newer readable", nvm_trace_log_read_latest(newer - 1U, &got) == NVM_STATUS_OK);
+    expect("corrupt records", nvm_trace_log_read_latest(newer, &got) == NVM_STATUS_INTEGRITY_ERROR &&
+                                  nvm_trace_log_read_latest(newer + bad_recs - 1U, &got) ==
+                                      NVM_STATUS_INTEGRITY_ERROR);
+    expect("older readable", nvm_trace_log_read_latest(newer + bad_recs, &got) == NVM_STATUS_OK &&
+                                 got.seq == header.total_records - 1U - (newer + bad_recs));
+
+    // 範囲読み出しは壊れたブロックで 1 回だけ INTEGRITY_ERROR を返し、その分を飛ばして続ける
+    want = newer + bad_recs + 100U;
+    seq = header.total_records - want;
+    expect("resync stream", nvm_trace_log_stream_open(want, NULL) == NVM_STATUS_OK);
+    while (s_ok && (st = nvm_trace_log_stream_next(&got)) != NVM_STATUS_NOT_FOUND) {
+        if (st == NVM_STATUS_INTEGRITY_ERROR) {
+            errors++;
+            seq += bad_recs;
+            continue;
+        }
+        expect("resync stream record", st == NVM_STATUS_OK && got.seq == seq);
+        seq++;
+        returned++;
+    }
+    expect("resync stream skips block", errors == 1U && returned == want - bad_recs && seq == header.total_records);
+    nvm_trace_log_stream_close();
+}
+
+/* 復号器（tools/logging/trace_bin_dump.py）の確認用に、f413_trace_diag.c の '>' と同じ形式の
+ * バイナリダンプ（フレーム v2 + ログヘッダ + 古い順のブロック像）をファイルへ書く */
+static bool write_bin(const char *path, uint32_t max_records)
+{
+    nvm_trace_log_header_t header;
+    const uint8_t *image;
+    uint32_t frame[9];
+    uint32_t stored;
+    uint32_t blocks = 0U;
+    uint32_t bytes = 0U;
+    uint32_t sum = 0U;
+    uint32_t len;
+    uint32_t recs;
+    FILE *fp;
+
+    if (nvm_trace_log_get_header(&header) != NVM_STATUS_OK ||
+        nvm_trace_log_get_stored(&header, &stored, NULL) != NVM_STATUS_OK ||
+        nvm_trace_log_stream_open(max_records, &max_records) != NVM_STATUS_OK) {
+        return false;
+    }
+    while (nvm_trace_log_stream_next_block(&image, &len, &recs) == NVM_STATUS_OK) {
+        bytes += len;
+        sum += nvm_trace_block_checksum(image, len);
+        blocks++;
+    }
+    sum += nvm_trace_block_checksum((const uint8_t *)&header, sizeof(header));
+    frame[0] = 0x4254464EUL;
+    frame[1] = 2U;
+    frame[2] = NVM_TRACE_LOG_SCHEMA_VERSION;
+    frame[3] = sizeof(header);
+    frame[4] = sizeof(nvm_trace_log_record_t);
+    frame[5] = max_records;
+    frame[6] = stored;
+    frame[7] = sum;
+    frame[8] = bytes;
+    fp = fopen(path, "wb");
+    if (fp == NULL) {
+        return false;
+    }
+    fputs("[TRACE-LOG] bin\r\n", fp);
+    fwrite(frame, sizeof(frame), 1U, fp);
+    fwrite(&header, sizeof(header), 1U, fp);
+    (void)nvm_trace_log_stream_open(max_records, NULL);
+    while (nvm_trace_log_stream_next_block(&image, &len, &recs) == NVM_STATUS_OK) {
+        fwrite(image, len, 1U, fp);
+    }
+    nvm_trace_log_stream_close();
+    fputs("\r\n[TRACE-LOG] bin: done\r\n", fp);
+    fclose(fp);
+    printf("[nvm-trace-codec] bin: %s records=%u blocks=%u bytes=%u\n", path, (unsigned int)max_records,
+           (unsigned int)blocks, (unsigned int)bytes);
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    const char *bin_out = (argc > 1) ? argv[1] : NULL;
+    const uint32_t raw_cap = RAW_RECORDS;
+    uint32_t stored = 0U;
+    uint32_t bytes = 0U;
+    uint32_t idle_stored = 0U;
+    uint32_t idle_bytes = 0U;
+    double run_ratio;
+    double idle_ratio;
+
+    check_blocks();
+
+    // 走行: 領域を 1 周以上させて、保存済みが最新側に連続して残ることを確かめる
+    fill_log(raw_cap * 5U, false, 97U);
+    verify_log(false, &stored, &bytes);
+    // 同じ領域に残る件数の比（ブロック末尾の空きも含めた実効値）
+    run_ratio = (double)stored / (double)raw_cap;
+    printf("[nvm-trace-codec] run: raw_cap=%u stored=%u bytes=%u bytes/rec=%.1f coverage=%.2fs (raw %.2fs) "
+           "ratio=%.2f\n",
+           (unsigned int)raw_cap, (unsigned int)stored, (unsigned int)bytes,
+           stored ? (double)bytes / stored : 0.0, stored / 1000.0, raw_cap / 1000.0, run_ratio);
+    check_stream(false);
+    if (s_ok && bin_out != NULL) {
+        expect("bin out", write_bin(bin_out, 0U));
+    }
+    check_resync();
+
+    // 停止中: ほとんど変わらないレコード
+    fill_log(3000U, true, 0U);
+    verify_log(true, &idle_stored, &idle_bytes);
+    check_stream(true);
+    idle_ratio = (idle_bytes > 0U) ? (double)idle_stored * sizeof(nvm_trace_log_record_t) / (double)idle_bytes : 0.0;
+    printf("[nvm-trace-codec] idle: stored=%u bytes=%u bytes/rec=%.1f ratio=%.2f\n", (unsigned int)idle_stored,
+           (unsigned int)idle_bytes, idle_stored ? (double)idle_bytes / idle_stored : 0.0, idle_ratio);
+
+    expect("run ratio >= 4", run_ratio >= 4.0);
+    printf("[nvm-trace-codec] record=%uB block=%uB keyframe=%u result=%s\n",
+           (unsigned int)sizeof(nvm_trace_log_record_t), (unsigned int)NVM_TRACE_CODEC_BLOCK_BYTES,
+           (unsigned int)NVM_TRACE_CODEC_KEYFRAME_INTERVAL, s_ok ? "ok" : "NG");
+    return s_ok ? 0 : 1;
+}
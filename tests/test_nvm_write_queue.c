@@ -0,0 +1,231 @@
+/*
+ * test_nvm_write_queue.c
+ *
+ * nvm/nvm_write_queue.c のホスト試験:
+ * nvm.c の F413 FRAM backend と同じ使い方（1 tick に最大 1 chunk、IMU 読取で埋まる tick は送らない）で
+ * 模擬 FRAM 配列へ書き、内容・完了順・barrier（通し番号の到達）・chunk 失敗時の扱い・満杯時の拒否を確かめる。
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "nvm_write_queue.h"
+
+#define FRAM_BYTES 8192U
+#define CHUNK_BYTES 128U
+#define REQUESTS 4000U
+#define NO_FAIL UINT32_MAX
+
+typedef struct {
+    uint8_t fram[FRAM_BYTES];
+    uint8_t expect[FRAM_BYTES];
+    uint32_t done_count;
+    uint32_t last_done_seq;
+    uint32_t fail_count;
+    bool order_ok;
+} Sim;
+
+typedef struct {
+    Sim *sim;
+    uint32_t seq;
+    nvm_status_t status;
+    bool done;
+} Req;
+
+// 送出中の chunk（nvm.c の DMA 転送に相当）
+typedef struct {
+    uint32_t addr;
+    const uint8_t *data;
+    uint32_t len;
+    uint32_t chunk_no;
+} Dma;
+
+static bool s_ok = true;
+static uint32_t s_rng = 0x12345678U;
+static Sim s_sim;
+static nvm_write_queue_t s_q;
+static uint8_t s_payload[NVM_WRITE_QUEUE_DEPTH][600];
+static Req s_reqs[NVM_WRITE_QUEUE_DEPTH];
+
+static void expect(const char *what, bool cond)
+{
+    if (!cond) {
+        printf("[nvm-write-queue] NG: %s\n", what);
+        s_ok = false;
+    }
+}
+
+static uint32_t rand32(void)
+{
+    s_rng ^= s_rng << 13;
+    s_rng ^= s_rng >> 17;
+    s_rng ^= s_rng << 5;
+    return s_rng;
+}
+
+static void sim_reset(void)
+{
+    memset(&s_sim, 0, sizeof(s_sim));
+    s_sim.order_ok = true;
+    nvm_write_queue_init(&s_q, CHUNK_BYTES);
+}
+
+static void on_done(nvm_status_t status, void *ctx)
+{
+    Req *r = (Req *)ctx;
+
+    if (r->done || r->seq <= r->sim->last_done_seq) {
+        r->sim->order_ok = false; // 二重完了・投入順と異なる完了
+    }
+    r->sim->last_done_seq = r->seq;
+    r->sim->done_count++;
+    if (status != NVM_STATUS_OK) {
+        r->sim->fail_count++;
+    }
+    r->status = status;
+    r->done = true;
+}
+
+// 1 tick 分: 送出中の chunk を完了させ（fail_at_chunk 番目は失敗させる）、次の chunk を起動する
+static bool tick(Dma *dma, bool imu_busy, uint32_t fail_at_chunk)
+{
+    uint32_t a2;
+    const uint8_t *d2;
+    uint32_t l2;
+
+    if (s_q.chunk_inflight) {
+        if (dma->chunk_no == fail_at_chunk) {
+            nvm_write_queue_chunk_done(&s_q, NVM_STATUS_HW_ERROR);
+        } else {
+            memcpy(&s_sim.fram[dma->addr], dma->data, dma->len);
+            nvm_write_queue_chunk_done(&s_q, NVM_STATUS_OK);
+        }
+        dma->chunk_no++;
+    }
+    if (imu_busy || !nvm_write_queue_next_chunk(&s_q, &dma->addr, &dma->data, &dma->len)) {
+        return true;
+    }
+    if (dma->len == 0U || dma->len > CHUNK_BYTES || dma->addr + dma->len > FRAM_BYTES) {
+        printf("[nvm-write-queue] NG: bad chunk addr=%u len=%u\n", (unsigned int)dma->addr, (unsigned int)dma->len);
+        s_ok = false;
+        return false;
+    }
+    if (nvm_write_queue_next_chunk(&s_q, &a2, &d2, &l2)) {
+        expect("no second chunk while one is in flight", false);
+        return false;
+    }
+    return true;
+}
+
+// 乱数の書き込み列を IMU 読取と交互に流し、最終内容を逐次適用の結果と比べる
+static void check_random(void)
+{
+    Dma dma = {0U, NULL, 0U, 0U};
+    uint32_t ticks = 0U;
+    uint32_t submitted = 0U;
+    uint32_t barriers = 0U;
+
+    sim_reset();
+    while (submitted < REQUESTS || !nvm_write_queue_idle(&s_q)) {
+        if (submitted < REQUESTS && !nvm_write_queue_full(&s_q) && (rand32() % 3U) != 0U) {
+            uint32_t slot = submitted % NVM_WRITE_QUEUE_DEPTH;
+            uint32_t len = rand32() % (uint32_t)sizeof(s_payload[0]); // 長さ 0 も含む
+            uint32_t addr = rand32() % (FRAM_BYTES - len);
+            Req *r = &s_reqs[slot];
+
+            if (r->seq != 0U && !r->done) {
+                expect("slot is not reused before completion", false);
+                return;
+            }
+            for (uint32_t i = 0U; i < len; i++) {
+                s_payload[slot][i] = (uint8_t)rand32();
+            }
+            memcpy(&s_sim.expect[addr], s_payload[slot], len);
+            r->sim = &s_sim;
+            r->done = false;
+            if (!nvm_write_queue_push(&s_q, addr, s_payload[slot], len, on_done, r, &r->seq)) {
+                expect("push succeeds with free slots", false);
+                return;
+            }
+            submitted++;
+            // ときどき barrier: 直前の要求まで完了するまで tick を回す
+            if ((rand32() % 50U) == 0U) {
+                barriers++;
+                while (!nvm_write_queue_reached(&s_q, r->seq)) {
+                    if (!tick(&dma, (ticks++ % 4U) == 0U, NO_FAIL)) {
+                        return;
+                    }
+                }
+                expect("barrier is reached only after completion", r->done && r->status == NVM_STATUS_OK);
+            }
+        }
+        if (!tick(&dma, (ticks++ % 4U) == 0U, NO_FAIL)) {
+            return;
+        }
+    }
+    expect("random: content", memcmp(s_sim.fram, s_sim.expect, FRAM_BYTES) == 0);
+    expect("random: every request completes once in order", s_sim.done_count == submitted && s_sim.order_ok);
+    expect("random: no failures", s_sim.fail_count == 0U && nvm_write_queue_take_error(&s_q) == NVM_STATUS_OK);
+    printf("[nvm-write-queue] random: requests=%u chunks=%u ticks=%u barriers=%u\n", (unsigned int)submitted,
+           (unsigned int)dma.chunk_no, (unsigned int)ticks, (unsigned int)barriers);
+}
+
+// 途中の chunk が失敗した要求は残りを送らずに失敗で完了し、後続の要求は続行する
+static void check_chunk_failure(void)
+{
+    Dma dma = {0U, NULL, 0U, 0U};
+
+    sim_reset();
+    for (uint32_t i = 0U; i < 3U; i++) {
+        memset(s_payload[i], (int)(0xA0U + i), sizeof(s_payload[i]));
+        s_reqs[i].sim = &s_sim;
+        s_reqs[i].done = false;
+        (void)nvm_write_queue_push(&s_q, i * 1024U, s_payload[i], 512U, on_done, &s_reqs[i], &s_reqs[i].seq);
+    }
+    while (!nvm_write_queue_idle(&s_q)) {
+        // 2 番目の要求の 2 chunk 目（512 / 128 = 4 chunk/要求）
+        if (!tick(&dma, false, 5U)) {
+            return;
+        }
+    }
+    expect("failed request completes with the error", s_reqs[0].status == NVM_STATUS_OK &&
+                                                          s_reqs[1].status == NVM_STATUS_HW_ERROR &&
+                                                          s_reqs[2].status == NVM_STATUS_OK);
+    expect("completion order after a failure", s_sim.order_ok && s_sim.done_count == 3U);
+    // 失敗した要求は 1 chunk 目だけ書かれ、2 chunk 目以降は書かれない
+    expect("failed request stops after the failed chunk",
+           s_sim.fram[1024U] == 0xA1U && s_sim.fram[1024U + CHUNK_BYTES] == 0U && s_sim.fram[1024U + 511U] == 0U);
+    expect("later request is written", s_sim.fram[2048U + 511U] == 0xA2U);
+    expect("error is taken once", nvm_write_queue_take_error(&s_q) == NVM_STATUS_HW_ERROR &&
+                                      nvm_write_queue_take_error(&s_q) == NVM_STATUS_OK && s_q.error_count == 1U);
+}
+
+// 満杯のキューは push を拒み、1 要求完了すると再び積める
+static void check_full(void)
+{
+    uint32_t addr;
+    const uint8_t *data;
+    uint32_t len;
+    bool pushed = true;
+
+    nvm_write_queue_init(&s_q, CHUNK_BYTES);
+    for (uint32_t i = 0U; i < NVM_WRITE_QUEUE_DEPTH; i++) {
+        pushed = pushed && nvm_write_queue_push(&s_q, 0U, s_payload[0], 1U, NULL, NULL, NULL);
+    }
+    expect("fills to depth", pushed && nvm_write_queue_full(&s_q));
+    expect("full queue rejects push", !nvm_write_queue_push(&s_q, 0U, s_payload[0], 1U, NULL, NULL, NULL));
+    expect("chunk from a full queue", nvm_write_queue_next_chunk(&s_q, &addr, &data, &len));
+    nvm_write_queue_chunk_done(&s_q, NVM_STATUS_OK);
+    expect("push after one completion", nvm_write_queue_push(&s_q, 0U, s_payload[0], 1U, NULL, NULL, NULL));
+}
+
+int main(void)
+{
+    check_random();
+    check_chunk_failure();
+    check_full();
+    printf("[nvm-write-queue] depth=%u result=%s\n", (unsigned int)NVM_WRITE_QUEUE_DEPTH, s_ok ? "ok" : "NG");
+    return s_ok ? 0 : 1;
+}
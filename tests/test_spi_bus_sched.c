@@ -0,0 +1,385 @@
+/*
+ * test_spi_bus_sched.c
+ *
+ * platform/bus/spi_bus_sched.c のホスト試験:
+ * F413 の制御周期（TIM5, 1ms）を 1us 刻みで模擬し、f413_control.c / nvm.c と同じ手順で
+ * IMU の DMA バースト（周期の先頭）・FRAM 書き込みキューの DMA chunk・メインループの同期読み出し
+ * （窓に収まる長さずつ）を流す。トレース書き出し中に IMU サンプルを 1 つも落とさないこと、
+ * FRAM の書き込み・読み出し内容が正しいことを確かめる。比較として従来の調停（空いていれば FRAM に
+ * 渡し、読み出しは要求ごと一括）での取りこぼし数も出す。
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "nvm_write_queue.h"
+#include "spi_bus_sched.h"
+
+#define PERIOD_US 1000U
+#define GUARD_US 50U
+#define FRAM_BYTES 65536U
+#define WRITE_REGION 49152U
+#define CHUNK_BYTES 128U
+#define WRITE_BYTES 1024U        // トレース書き出しの 1 要求
+#define WRITE_TOTAL (96U * 1024U)
+#define READ_BYTES 512U          // メインループの同期読み出しの 1 要求
+#define READ_TOTAL (48U * 1024U)
+#define IMU_US 72U               // 14 バイトのバースト
+// nvm.c と同じ占有時間の見積り（1 バイト 5.12us、ポーリングの引き延ばし 1/8、固定分）と切り方
+#define SETUP_US 10U
+#define XFER_US(bytes) (((((uint32_t)(bytes) * 512U + 99U) / 100U) * 9U) / 8U + SETUP_US)
+#define SYNC_MIN_BYTES 16U
+#define SYNC_MAX_BYTES 0x8000U
+
+typedef struct {
+    bool legacy;                 // 従来の調停（窓を見ない・読み出しは一括）
+    bool running;                // 制御 tick が IMU を読む（走行中）
+    spi_bus_sched_t sched;
+    nvm_write_queue_t q;
+    uint8_t fram[FRAM_BYTES];
+    uint8_t expect[FRAM_BYTES];
+    uint8_t wbuf[NVM_WRITE_QUEUE_DEPTH][WRITE_BYTES];
+    uint8_t rbuf[READ_BYTES];
+    uint64_t t;
+    uint32_t isr_lat;            // この周期の TIM5 割り込みの遅れ
+    bool isr_done;               // この周期の制御 tick が走った
+    bool imu_busy;
+    uint64_t imu_end_t;
+    bool imu_ready;              // 未消費の完了サンプル
+    uint32_t ticks;
+    uint32_t stale_ticks;        // 新しいサンプルを得られなかった制御 tick
+    uint32_t missed_ticks;       // 走らなかった制御 tick（従来の同期読み出しが TIM5 を止めた間）
+    bool dma_busy;
+    uint64_t dma_end_t;
+    uint32_t dma_addr;
+    const uint8_t *dma_data;
+    uint32_t dma_len;
+    bool read_busy;
+    uint64_t read_end_t;
+    uint32_t read_off;           // 要求内の読み出し済み位置
+    uint32_t read_len;
+    uint32_t read_total;
+    uint32_t read_addr;
+    uint32_t read_pieces;
+    uint32_t write_total;
+    uint32_t writes_done;
+    uint32_t max_hold_over_us;   // 窓の見積りを越えて占有した最大量（同期読み出し）
+    uint64_t main_next_t;
+    bool ok;
+} Sim;
+
+static bool s_ok = true;
+static uint32_t s_rng = 0x2468ACE1U;
+static Sim s_sim;
+
+static void expect(const char *what, bool cond)
+{
+    if (!cond) {
+        printf("[spi-bus-sched] NG: %s\n", what);
+        s_ok = false;
+    }
+}
+
+static uint32_t rand32(void)
+{
+    s_rng ^= s_rng << 13;
+    s_rng ^= s_rng >> 17;
+    s_rng ^= s_rng << 5;
+    return s_rng;
+}
+
+// f413_control.c の spi2_now_us() と同じ: 周期が変わって制御 tick が未実行なら窓の外
+static uint32_t now_us(const Sim *sim)
+{
+    if (sim->running && !sim->isr_done) {
+        return UINT32_MAX;
+    }
+    return (uint32_t)(sim->t % PERIOD_US);
+}
+
+// f413_ctrl_spi2_fram_end() と同じ: 未実行の tick があれば 1 周期を足す
+static uint32_t end_us(const Sim *sim)
+{
+    uint32_t in = (uint32_t)(sim->t % PERIOD_US);
+    return (sim->running && !sim->isr_done) ? in + PERIOD_US : in;
+}
+
+static bool fram_begin(Sim *sim, uint32_t cost_us)
+{
+    if (sim->legacy) {
+        return spi_bus_sched_try_claim(&sim->sched, SPI_BUS_OWNER_FRAM);
+    }
+    return spi_bus_sched_fram_begin(&sim->sched, now_us(sim), cost_us);
+}
+
+static void fram_end(Sim *sim)
+{
+    if (sim->legacy) {
+        spi_bus_sched_release(&sim->sched);
+        return;
+    }
+    spi_bus_sched_fram_end(&sim->sched, end_us(sim));
+}
+
+static void write_done(nvm_status_t status, void *ctx)
+{
+    Sim *sim = (Sim *)ctx;
+
+    if (status != NVM_STATUS_OK) {
+        sim->ok = false;
+    }
+    sim->writes_done++;
+}
+
+// nvm_stm32f413_fram_kick() と同じ: 空いていて窓に収まれば 1 chunk を DMA で起動する
+static void kick(Sim *sim)
+{
+    if (sim->dma_busy || nvm_write_queue_idle(&sim->q) || !fram_begin(sim, XFER_US(CHUNK_BYTES + 5U))) {
+        return;
+    }
+    if (!nvm_write_queue_next_chunk(&sim->q, &sim->dma_addr, &sim->dma_data, &sim->dma_len)) {
+        fram_end(sim);
+        return;
+    }
+    sim->dma_busy = true;
+    // WREN + WRITE ヘッダはポーリング、データは DMA（割り込みで引き延ばされない）
+    sim->dma_end_t = sim->t + ((sim->dma_len + 5U) * 512U) / 100U + 4U + rand32() % 4U;
+}
+
+// nvm_stm32f413_fram_fit_bytes() と同じ
+static uint32_t fit_bytes(uint32_t window_us, uint32_t overhead)
+{
+    uint32_t bytes;
+
+    if (window_us == UINT32_MAX) {
+        return SYNC_MAX_BYTES;
+    }
+    if (window_us <= SETUP_US) {
+        return 0U;
+    }
+    bytes = ((((window_us - SETUP_US) * 8U) / 9U) * 100U) / 512U;
+    return (bytes > overhead) ? (bytes - overhead) : 0U;
+}
+
+// メインループ: 書き込み要求を積み、キューを蹴り、同期読み出しの次の一片を窓に合わせて始める
+static void main_loop(Sim *sim)
+{
+    uint32_t want;
+    uint32_t n;
+    uint32_t stretch;
+    uint32_t actual;
+
+    while (sim->write_total < WRITE_TOTAL && !nvm_write_queue_full(&sim->q)) {
+        uint32_t slot = (sim->write_total / WRITE_BYTES) % NVM_WRITE_QUEUE_DEPTH;
+        uint32_t addr = sim->write_total % WRITE_REGION;
+
+        for (uint32_t i = 0U; i < WRITE_BYTES; i++) {
+            sim->wbuf[slot][i] = (uint8_t)rand32();
+        }
+        memcpy(&sim->expect[addr], sim->wbuf[slot], WRITE_BYTES);
+        (void)nvm_write_queue_push(&sim->q, addr, sim->wbuf[slot], WRITE_BYTES, write_done, sim, NULL);
+        sim->write_total += WRITE_BYTES;
+    }
+    kick(sim);
+
+    if (sim->read_total >= READ_TOTAL) {
+        return;
+    }
+    want = sim->read_len - sim->read_off;
+    n = want;
+    stretch = 100U + rand32() % 12U; // 割り込みによる引き延ばし（見積りは 1/8）
+    if (!sim->legacy) {
+        uint32_t min_len = (want < SYNC_MIN_BYTES) ? want : SYNC_MIN_BYTES;
+        n = fit_bytes(spi_bus_sched_fram_window_us(&sim->sched, now_us(sim)), 4U);
+        if (n > want) {
+            n = want;
+        }
+        if (n < min_len || !fram_begin(sim, XFER_US(n + 4U))) {
+            return;
+        }
+    } else if (!fram_begin(sim, 0U)) {
+        return;
+    }
+    actual = ((((n + 4U) * 512U) / 100U) * stretch) / 100U + 4U + rand32() % 4U;
+    if (!sim->legacy && actual > XFER_US(n + 4U)) {
+        uint32_t over = actual - XFER_US(n + 4U);
+        if (over > sim->max_hold_over_us) {
+            sim->max_hold_over_us = over;
+        }
+    }
+    sim->read_busy = true;
+    sim->read_end_t = sim->t + actual;
+    sim->read_pieces++;
+    memcpy(sim->rbuf + sim->read_off, &sim->fram[sim->read_addr + sim->read_off], n);
+    sim->read_off += n;
+}
+
+// 1 回の模擬: running なら制御 tick が毎周期 IMU を読む
+static void run_sim(Sim *sim, bool legacy, bool running)
+{
+    const uint32_t read_base = WRITE_REGION;
+
+    memset(sim, 0, sizeof(*sim));
+    sim->legacy = legacy;
+    sim->running = running;
+    sim->ok = true;
+    spi_bus_sched_init(&sim->sched, PERIOD_US, GUARD_US);
+    spi_bus_sched_set_imu_scheduled(&sim->sched, running);
+    nvm_write_queue_init(&sim->q, CHUNK_BYTES);
+    for (uint32_t i = read_base; i < FRAM_BYTES; i++) {
+        sim->fram[i] = (uint8_t)(i * 7U + 3U);
+    }
+    memcpy(sim->expect + read_base, sim->fram + read_base, FRAM_BYTES - read_base);
+    sim->read_addr = read_base;
+    sim->read_len = READ_BYTES;
+
+    for (;; sim->t++) {
+        uint32_t in = (uint32_t)(sim->t % PERIOD_US);
+
+        if (in == 0U) {
+            if (sim->running && sim->t > 0U && !sim->isr_done) {
+                sim->missed_ticks++;
+            }
+            sim->isr_lat = rand32() % 6U;
+            sim->isr_done = false;
+        }
+        // 完了割り込み（IMU DMA → FRAM DMA の順。どちらも TIM5 と同じ優先度）
+        if (sim->imu_busy && sim->t >= sim->imu_end_t) {
+            sim->imu_busy = false;
+            sim->imu_ready = true;
+            spi_bus_sched_imu_end(&sim->sched, true);
+            kick(sim); // IMU 読取後の空き通知
+        }
+        if (sim->dma_busy && sim->t >= sim->dma_end_t) {
+            memcpy(&sim->fram[sim->dma_addr], sim->dma_data, sim->dma_len);
+            sim->dma_busy = false;
+            nvm_write_queue_chunk_done(&sim->q, NVM_STATUS_OK);
+            fram_end(sim);
+            if (!sim->sched.imu_scheduled) {
+                kick(sim);
+            }
+        }
+        if (sim->read_busy && sim->t >= sim->read_end_t) {
+            sim->read_busy = false;
+            fram_end(sim);
+            if (sim->read_off >= sim->read_len) {
+                if (memcmp(sim->rbuf, &sim->expect[sim->read_addr], sim->read_len) != 0) {
+                    printf("[spi-bus-sched] NG: read mismatch at 0x%05X\n", (unsigned int)sim->read_addr);
+                    sim->ok = false;
+                }
+                sim->read_total += sim->read_len;
+                sim->read_off = 0U;
+                sim->read_addr += READ_BYTES;
+                if (sim->read_addr + READ_BYTES > FRAM_BYTES) {
+                    sim->read_addr = read_base;
+                }
+            }
+        }
+        // 制御 tick（TIM5）。従来の調停では同期読み出しが TIM5 を止めている間は待たされる
+        if (sim->running && !sim->isr_done && in >= sim->isr_lat && !(sim->legacy && sim->read_busy)) {
+            sim->isr_done = true;
+            if (sim->ticks > 0U && !sim->imu_ready) {
+                sim->stale_ticks++;
+            }
+            sim->imu_ready = false;
+            sim->ticks++;
+            if (spi_bus_sched_imu_begin(&sim->sched)) {
+                sim->imu_busy = true;
+                sim->imu_end_t = sim->t + IMU_US + rand32() % 5U;
+            }
+        }
+        if (!sim->read_busy && sim->t >= sim->main_next_t) {
+            sim->main_next_t = sim->t + 5U + rand32() % 40U;
+            main_loop(sim);
+        }
+        if (sim->write_total >= WRITE_TOTAL && nvm_write_queue_idle(&sim->q) && !sim->dma_busy &&
+            sim->read_total >= READ_TOTAL && !sim->read_busy) {
+            break;
+        }
+        if (sim->t > 60ULL * 1000000ULL) {
+            printf("[spi-bus-sched] NG: simulation did not finish\n");
+            sim->ok = false;
+            break;
+        }
+    }
+    if (memcmp(sim->fram, sim->expect, FRAM_BYTES) != 0 || sim->writes_done != WRITE_TOTAL / WRITE_BYTES) {
+        printf("[spi-bus-sched] NG: write content mismatch done=%u\n", (unsigned int)sim->writes_done);
+        sim->ok = false;
+    }
+}
+
+// 時間割の規則: スロット前・窓の外の FRAM は断り、IMU は FRAM・前回転送の残りを数える
+static void check_rules(void)
+{
+    static spi_bus_sched_t s;
+
+    spi_bus_sched_init(&s, PERIOD_US, GUARD_US);
+    expect("unlimited window while stopped", spi_bus_sched_fram_window_us(&s, 500U) == UINT32_MAX);
+    spi_bus_sched_set_imu_scheduled(&s, true);
+    expect("fram refused before the first slot", !spi_bus_sched_fram_begin(&s, 100U, 10U));
+    expect("imu begin", spi_bus_sched_imu_begin(&s));
+    expect("fram refused during imu", !spi_bus_sched_fram_begin(&s, 30U, 10U));
+    spi_bus_sched_imu_end(&s, true);
+    expect("window after imu", spi_bus_sched_fram_window_us(&s, 100U) == 850U);
+    expect("fram refused past the window", !spi_bus_sched_fram_begin(&s, 100U, 851U));
+    expect("fram within the window", spi_bus_sched_fram_begin(&s, 100U, 850U));
+    expect("imu skipped while fram overruns", !spi_bus_sched_imu_begin(&s));
+    spi_bus_sched_fram_end(&s, 20U);
+    expect("overrun stats", s.stats.imu_skipped == 1U && s.stats.fram_overruns == 1U &&
+                                s.stats.fram_max_hold_us == 920U && s.stats.fram_deferred == 2U);
+    expect("no window before this period's imu", spi_bus_sched_fram_window_us(&s, 100U) == 0U);
+    expect("imu begin after overrun", spi_bus_sched_imu_begin(&s));
+    expect("imu late while the previous transfer remains", !spi_bus_sched_imu_begin(&s));
+    spi_bus_sched_imu_end(&s, false);
+    expect("late stats", s.stats.imu_late == 1U && s.stats.imu_errors == 1U && s.stats.imu_slots == 4U &&
+                             spi_bus_sched_imu_dropped(&s.stats) == 3U);
+}
+
+// 走行中のトレース書き出し + 同期読み出し: IMU の取りこぼし 0、FRAM の超過 0
+static void check_scheduled_flush(void)
+{
+    run_sim(&s_sim, false, true);
+    printf("[spi-bus-sched] scheduled flush: ticks=%u dropped=%u stale=%u fram_grants=%u deferred=%u overruns=%u "
+           "max_hold=%uus read_pieces=%u\n",
+           (unsigned int)s_sim.ticks, (unsigned int)spi_bus_sched_imu_dropped(&s_sim.sched.stats),
+           (unsigned int)s_sim.stale_ticks, (unsigned int)s_sim.sched.stats.fram_grants,
+           (unsigned int)s_sim.sched.stats.fram_deferred, (unsigned int)s_sim.sched.stats.fram_overruns,
+           (unsigned int)s_sim.sched.stats.fram_max_hold_us, (unsigned int)s_sim.read_pieces);
+    expect("scheduled flush: content", s_sim.ok);
+    expect("scheduled flush: no stale or missed tick", s_sim.stale_ticks == 0U && s_sim.missed_ticks == 0U);
+    expect("scheduled flush: no dropped imu sample", spi_bus_sched_imu_dropped(&s_sim.sched.stats) == 0U);
+    expect("scheduled flush: no fram overrun", s_sim.sched.stats.fram_overruns == 0U);
+}
+
+// 比較: 従来の調停（空いていれば FRAM に渡す・読み出しは要求ごと一括）での取りこぼし
+static void check_legacy_flush(void)
+{
+    run_sim(&s_sim, true, true);
+    printf("[spi-bus-sched] legacy flush:    ticks=%u dropped=%u stale=%u missed=%u (reference)\n",
+           (unsigned int)s_sim.ticks, (unsigned int)spi_bus_sched_imu_dropped(&s_sim.sched.stats),
+           (unsigned int)s_sim.stale_ticks, (unsigned int)s_sim.missed_ticks);
+    expect("legacy flush: content", s_sim.ok);
+}
+
+// 停止中: 窓の制限なしに続けて送る（見送り 0）
+static void check_stopped_flush(void)
+{
+    run_sim(&s_sim, false, false);
+    printf("[spi-bus-sched] stopped flush: time=%lums fram_grants=%u deferred=%u\n",
+           (unsigned long)(s_sim.t / 1000ULL), (unsigned int)s_sim.sched.stats.fram_grants,
+           (unsigned int)s_sim.sched.stats.fram_deferred);
+    expect("stopped flush: content", s_sim.ok);
+    expect("stopped flush: nothing deferred", s_sim.sched.stats.fram_deferred == 0U && s_sim.ticks == 0U);
+}
+
+int main(void)
+{
+    check_rules();
+    check_scheduled_flush();
+    check_legacy_flush();
+    check_stopped_flush();
+    printf("[spi-bus-sched] result=%s\n", s_ok ? "ok" : "NG");
+    return s_ok ? 0 : 1;
+}
@@ -0,0 +1,373 @@
+/*
+ * test_telemetry.c
+ *
+ * platform/trace/telemetry.c のホスト試験:
+ * 模擬走行のトレースレコードをプリセットごとに流し、閉じたパケットを受信側（telemetry_decode.py）と同じ検査で
+ * 復号して、記録の並び・グループの間引き・seq の飛びでの区切り・CSV ダンプに対する帯域の利得を確かめる。
+ *
+ * 使い方: test_telemetry [OUT_PREFIX]
+ *   OUT_PREFIX を渡すと、欠落・ビット反転・途中切れを混ぜた受信用ストリーム OUT_PREFIX.bin と
+ *   その正解 OUT_PREFIX.truth を書く（tests/run_telemetry_check.sh が telemetry_decode.py で突き合わせる）。
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "nvm_trace_codec.h"
+#include "telemetry.h"
+#include "trace_record_sim.h"
+
+#define UART_BAUD 921600U
+#define CHECK_RECORDS 9000U // 走行模擬 10 周分（1kHz で 9 秒）
+#define FAULT_RECORDS 3000U
+
+typedef struct {
+    uint32_t packets;
+    uint32_t records;
+    uint32_t bytes;
+    uint32_t text_bytes; // 同じ記録を CSV ダンプの行にしたときのバイト数
+} Totals;
+
+static bool s_ok = true;
+static uint32_t s_rng = 0x13579BDFU;
+static nvm_trace_log_record_t s_src[CHECK_RECORDS];
+
+static void expect(const char *what, bool cond)
+{
+    if (!cond) {
+        printf("[telemetry] NG: %s\n", what);
+        s_ok = false;
+    }
+}
+
+static uint32_t rand32(void)
+{
+    s_rng ^= s_rng << 13;
+    s_rng ^= s_rng >> 17;
+    s_rng ^= s_rng << 5;
+    return s_rng;
+}
+
+static uint32_t fnv1a(const void *data, size_t len)
+{
+    const uint8_t *p = (const uint8_t *)data;
+    uint32_t h = 0x811C9DC5U;
+
+    for (size_t i = 0U; i < len; i++) {
+        h ^= p[i];
+        h *= 0x01000193U;
+    }
+    return h;
+}
+
+// f413_trace_diag.c の CSV ダンプと同じ書式の 1 行の長さ
+static uint32_t csv_row_bytes(const nvm_trace_log_record_t *rec)
+{
+    char line[512];
+    int n = snprintf(line, sizeof(line),
+                     "%lu,%lu,%u,%u,%u,%u,%.3f,%ld,%ld,%ld,%ld,%ld,%ld,%ld,%ld,%ld,%ld,%d,%d,%d,%d,%u,"
+                     "%u,%u,%u,%u,%u,%u,%u,%u,%u,%ld,%ld,%ld,%ld,%u,%u,%u,%u\r\n",
+                     (unsigned long)rec->timestamp_ms, (unsigned long)rec->seq, (unsigned int)rec->op_mode,
+                     (unsigned int)rec->op_case, (unsigned int)rec->op_sub, (unsigned int)rec->test_id,
+                     (double)rec->target_distance_x1000 / 1000.0, (long)rec->distance_mm, (long)rec->angle_mdeg,
+                     (long)rec->target_velocity_mm_s, (long)rec->real_velocity_mm_s,
+                     (long)rec->accel_velocity_mm_s, (long)rec->target_omega_mdps, (long)rec->real_omega_mdps,
+                     (long)rec->gyro_z_raw_mdps, (long)rec->target_angle_mdeg, (long)rec->accel_forward_mm_s2,
+                     (int)rec->encoder_l, (int)rec->encoder_r, (int)rec->motor_out_l, (int)rec->motor_out_r,
+                     (unsigned int)rec->adc_fr, (unsigned int)rec->adc_r, (unsigned int)rec->adc_fl,
+                     (unsigned int)rec->adc_l, (unsigned int)rec->adc_vbat, (unsigned int)rec->wall_read_fr,
+                     (unsigned int)rec->wall_read_r, (unsigned int)rec->wall_read_fl,
+                     (unsigned int)rec->wall_read_l, (unsigned int)rec->flags, (long)rec->reserved_i32_0,
+                     (long)rec->reserved_i32_1, (long)rec->reserved_i32_2, (long)rec->reserved_i32_3,
+                     (unsigned int)rec->reserved_u16_0, (unsigned int)rec->reserved_u16_1,
+                     (unsigned int)rec->isr_tick_max_us_x10, (unsigned int)rec->isr_period_max_us_x10);
+    return (n > 0) ? (uint32_t)n : 0U;
+}
+
+static uint16_t get_u16(const uint8_t *p)
+{
+    return (uint16_t)(p[0] | ((uint16_t)p[1] << 8));
+}
+
+// パケット 1 つを復号する（受信側 telemetry_decode.py と同じ検査）
+static bool decode_packet(const uint8_t *pkt, uint32_t len, nvm_trace_log_record_t *out, uint32_t *out_count,
+                          uint8_t *decimation, uint16_t *out_seq)
+{
+    nvm_trace_codec_state_t codec;
+    uint32_t payload;
+    uint32_t pos;
+    uint32_t end;
+    uint32_t count;
+
+    if (len < TELEMETRY_HEADER_BYTES + TELEMETRY_TRACE_PAYLOAD_HEADER_BYTES + TELEMETRY_CRC_BYTES ||
+        pkt[0] != TELEMETRY_SYNC0 || pkt[1] != TELEMETRY_SYNC1 || pkt[2] != (uint8_t)TELEMETRY_CH_TRACE) {
+        return false;
+    }
+    payload = get_u16(&pkt[4]);
+    end = TELEMETRY_HEADER_BYTES + payload;
+    if (end + TELEMETRY_CRC_BYTES != len || telemetry_crc16(&pkt[2], end - 2U) != get_u16(&pkt[end])) {
+        return false;
+    }
+    count = pkt[TELEMETRY_HEADER_BYTES];
+    if (count == 0U || count > TELEMETRY_BATCH_MAX) {
+        return false;
+    }
+    memcpy(decimation, &pkt[TELEMETRY_HEADER_BYTES + 1U], TELEMETRY_GROUP_COUNT);
+    pos = TELEMETRY_HEADER_BYTES + TELEMETRY_TRACE_PAYLOAD_HEADER_BYTES;
+    nvm_trace_codec_reset(&codec);
+    for (uint32_t k = 0U; k < count; k++) {
+        uint32_t used = nvm_trace_codec_decode(&codec, &pkt[pos], end - pos, &out[k]);
+        if (used == 0U) {
+            return false;
+        }
+        pos += used;
+    }
+    *out_count = count;
+    *out_seq = get_u16(&pkt[6]);
+    return pos == end;
+}
+
+// グループの代表フィールドが間引き数どおりか（0 = 0 のまま、n = seq が n の倍数の記録の値を保持）
+static bool check_record(const nvm_trace_log_record_t *got, const uint8_t *decimation)
+{
+    const nvm_trace_log_record_t *src = s_src;
+    nvm_trace_log_record_t ref;
+    uint32_t at[TELEMETRY_GROUP_COUNT];
+    bool ok = true;
+
+    for (uint32_t g = 0U; g < TELEMETRY_GROUP_COUNT; g++) {
+        at[g] = (decimation[g] != 0U) ? (got->seq - got->seq % decimation[g]) : 0U;
+    }
+    ok = ok && got->seq == src[got->seq].seq && got->timestamp_ms == src[got->seq].timestamp_ms &&
+         got->flags == src[got->seq].flags && got->op_sub == src[got->seq].op_sub;
+    ref = src[at[TELEMETRY_GROUP_MOTION]];
+    ok = ok && got->distance_mm == ((decimation[TELEMETRY_GROUP_MOTION] != 0U) ? ref.distance_mm : 0);
+    ok = ok && got->target_angle_mdeg == ((decimation[TELEMETRY_GROUP_MOTION] != 0U) ? ref.target_angle_mdeg : 0);
+    ref = src[at[TELEMETRY_GROUP_DRIVE]];
+    ok = ok && got->encoder_l == ((decimation[TELEMETRY_GROUP_DRIVE] != 0U) ? ref.encoder_l : 0);
+    ref = src[at[TELEMETRY_GROUP_WALL]];
+    ok = ok && got->adc_fr == ((decimation[TELEMETRY_GROUP_WALL] != 0U) ? ref.adc_fr : 0U);
+    ref = src[at[TELEMETRY_GROUP_OBSERVE]];
+    ok = ok && got->reserved_i32_0 == ((decimation[TELEMETRY_GROUP_OBSERVE] != 0U) ? ref.reserved_i32_0 : 0);
+    ref = src[at[TELEMETRY_GROUP_TIMING]];
+    ok = ok &&
+         got->isr_tick_max_us_x10 == ((decimation[TELEMETRY_GROUP_TIMING] != 0U) ? ref.isr_tick_max_us_x10 : 0U);
+    return ok;
+}
+
+// プリセット 1 つで全記録を流し、届いた記録と帯域を集計する
+static bool check_preset(telemetry_preset_t preset, uint32_t n, Totals *tot)
+{
+    static telemetry_t t;
+    static nvm_trace_log_record_t got[TELEMETRY_BATCH_MAX];
+    uint8_t decimation[TELEMETRY_GROUP_COUNT];
+    uint32_t next = 0U;
+    uint16_t expect_seq = 0U;
+    bool ok = true;
+
+    memset(tot, 0, sizeof(*tot));
+    telemetry_init(&t, 8U);
+    telemetry_apply_preset(&t, preset);
+    for (uint32_t i = 0U; i <= n; i++) {
+        const uint8_t *pkt;
+        uint32_t len;
+        uint32_t count = 0U;
+        uint16_t seq = 0U;
+        bool closed = (i < n) ? telemetry_push(&t, &s_src[i], &pkt, &len) : telemetry_flush(&t, &pkt, &len);
+
+        if (i < n) {
+            tot->text_bytes += csv_row_bytes(&s_src[i]);
+        }
+        if (!closed) {
+            continue;
+        }
+        if (!decode_packet(pkt, len, got, &count, decimation, &seq) || seq != expect_seq) {
+            printf("[telemetry] %s: packet %u NG\n", telemetry_preset_name(preset), (unsigned int)expect_seq);
+            return false;
+        }
+        expect_seq++;
+        tot->packets++;
+        tot->bytes += len;
+        for (uint32_t k = 0U; k < count; k++) {
+            ok = ok && got[k].seq == next && check_record(&got[k], decimation);
+            if (preset == TELEMETRY_PRESET_ALL) {
+                ok = ok && memcmp(&got[k], &s_src[next], sizeof(got[k])) == 0;
+            }
+            next++;
+        }
+        tot->records += count;
+    }
+    return ok && next == n && t.stats.records == n && t.stats.bytes == tot->bytes;
+}
+
+// 記録の seq が飛んだらパケットを途中で閉じ、飛んだ先を次のパケットの先頭にする
+static void check_gaps(void)
+{
+    static telemetry_t t;
+    static nvm_trace_log_record_t got[TELEMETRY_BATCH_MAX];
+    static const uint32_t order[] = {0U, 1U, 2U, 3U, 7U, 8U, 9U, 20U, 21U, 22U, 23U, 24U, 25U, 26U, 27U, 28U, 29U};
+    const uint32_t order_num = (uint32_t)(sizeof(order) / sizeof(order[0]));
+    uint8_t decimation[TELEMETRY_GROUP_COUNT];
+    bool ok = true;
+
+    for (uint8_t batch = 1U; batch <= 8U; batch = (uint8_t)(batch + 7U)) {
+        uint32_t next = 0U;
+        uint32_t packets = 0U;
+
+        telemetry_init(&t, batch);
+        telemetry_apply_preset(&t, TELEMETRY_PRESET_ALL);
+        for (uint32_t i = 0U; i <= order_num; i++) {
+            const uint8_t *pkt;
+            uint32_t len;
+            uint32_t count = 0U;
+            uint16_t seq = 0U;
+            bool closed = (i < order_num) ? telemetry_push(&t, &s_src[order[i]], &pkt, &len)
+                                          : telemetry_flush(&t, &pkt, &len);
+
+            if (!closed) {
+                continue;
+            }
+            ok = ok && decode_packet(pkt, len, got, &count, decimation, &seq);
+            packets++;
+            for (uint32_t k = 0U; k < count; k++) {
+                ok = ok && got[k].seq == order[next] && memcmp(&got[k], &s_src[order[next]], sizeof(got[k])) == 0;
+                ok = ok && ((k == 0U) || got[k].seq == got[k - 1U].seq + 1U);
+                next++;
+            }
+        }
+        ok = ok && next == order_num;
+        ok = ok && ((batch == 1U) ? packets == next : (t.stats.gaps == 2U && packets == 4U));
+    }
+    printf("[telemetry] gaps: result=%s\n", ok ? "ok" : "NG");
+    expect("gaps", ok);
+}
+
+/* 受信側の検証用ストリームを書く。パケットごとに欠落・ビット反転・途中切れを混ぜ、間に文字のログ行や
+ * 偽の同期語を挟む。truth には各パケットの行方と、届くはずの記録の FNV-1a を書く。 */
+static bool write_fault_stream(const char *prefix, uint32_t n)
+{
+    static telemetry_t t;
+    static nvm_trace_log_record_t got[TELEMETRY_BATCH_MAX];
+    static const char text[] = "[TRACE] run: seg=12 v=1480 omega=0\r\n";
+    static const uint8_t fake[] = {TELEMETRY_SYNC0, TELEMETRY_SYNC1, 0x01U, 0x00U, 0x10U, 0x00U, 0x33U};
+    uint8_t decimation[TELEMETRY_GROUP_COUNT];
+    uint32_t fate_count[4] = {0U, 0U, 0U, 0U};
+    char path[1024];
+    FILE *bin;
+    FILE *truth;
+
+    snprintf(path, sizeof(path), "%s.bin", prefix);
+    bin = fopen(path, "wb");
+    snprintf(path, sizeof(path), "%s.truth", prefix);
+    truth = fopen(path, "w");
+    if (bin == NULL || truth == NULL) {
+        if (bin != NULL) {
+            fclose(bin);
+        }
+        if (truth != NULL) {
+            fclose(truth);
+        }
+        return false;
+    }
+    fprintf(truth, "# telemetry truth: packet <seq> ok|drop|crc|trunc / record <seq> <fnv1a>\n");
+    fputs("[TELEMETRY] on preset=run\r\n", bin);
+    telemetry_init(&t, 8U);
+    telemetry_apply_preset(&t, TELEMETRY_PRESET_RUN);
+    for (uint32_t i = 0U; i <= n; i++) {
+        const uint8_t *pkt;
+        uint32_t len;
+        uint32_t count = 0U;
+        uint16_t seq = 0U;
+        uint32_t r;
+        uint8_t copy[TELEMETRY_PACKET_MAX];
+        bool closed = (i < n) ? telemetry_push(&t, &s_src[i], &pkt, &len) : telemetry_flush(&t, &pkt, &len);
+
+        if (!closed) {
+            continue;
+        }
+        if (!decode_packet(pkt, len, got, &count, decimation, &seq)) {
+            fclose(bin);
+            fclose(truth);
+            return false;
+        }
+        r = rand32() % 24U;
+        if (r == 3U) {
+            fwrite(text, sizeof(text) - 1U, 1U, bin);
+        } else if (r == 4U) {
+            fwrite(fake, sizeof(fake), 1U, bin);
+        }
+        memcpy(copy, pkt, len);
+        if (r == 0U) {
+            fprintf(truth, "packet %u drop\n", (unsigned int)seq);
+            fate_count[1]++;
+            continue;
+        }
+        if (r == 1U) {
+            // ヘッダの同期語以外のどこか 1 ビット
+            uint32_t bit = 16U + rand32() % ((len - 2U) * 8U);
+            copy[bit / 8U] ^= (uint8_t)(1U << (bit % 8U));
+            fwrite(copy, len, 1U, bin);
+            fprintf(truth, "packet %u crc\n", (unsigned int)seq);
+            fate_count[2]++;
+            continue;
+        }
+        if (r == 2U) {
+            fwrite(copy, len / 2U, 1U, bin);
+            fprintf(truth, "packet %u trunc\n", (unsigned int)seq);
+            fate_count[3]++;
+            continue;
+        }
+        fwrite(copy, len, 1U, bin);
+        fprintf(truth, "packet %u ok\n", (unsigned int)seq);
+        fate_count[0]++;
+        for (uint32_t k = 0U; k < count; k++) {
+            fprintf(truth, "record %u %08x\n", (unsigned int)got[k].seq, (unsigned int)fnv1a(&got[k], sizeof(got[k])));
+        }
+    }
+    fputs("[TELEMETRY] off\r\n", bin);
+    fclose(bin);
+    fclose(truth);
+    printf("[telemetry] fault stream: %s.bin ok=%u drop=%u crc=%u trunc=%u\n", prefix, (unsigned int)fate_count[0],
+           (unsigned int)fate_count[1], (unsigned int)fate_count[2], (unsigned int)fate_count[3]);
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    const double byte_rate = (double)UART_BAUD / 10.0; // 8N1
+    double run_gain = 0.0;
+
+    for (uint32_t i = 0U; i < CHECK_RECORDS; i++) {
+        trace_record_sim_fill(&s_src[i], i, false);
+    }
+    for (uint32_t p = 0U; p < (uint32_t)TELEMETRY_PRESET_COUNT; p++) {
+        Totals tot;
+        bool pok = check_preset((telemetry_preset_t)p, CHECK_RECORDS, &tot);
+        double bytes_per = (double)tot.bytes / tot.records;
+        double text_per = (double)tot.text_bytes / tot.records;
+        double rate = byte_rate / bytes_per;
+        double text_rate = byte_rate / text_per;
+
+        printf("[telemetry] %-6s packets=%u bytes/sample=%.1f (csv %.1f) samples/s=%.0f (csv %.0f) gain=%.1fx "
+               "result=%s\n",
+               telemetry_preset_name((telemetry_preset_t)p), (unsigned int)tot.packets, bytes_per, text_per, rate,
+               text_rate, rate / text_rate, pok ? "ok" : "NG");
+        if (p == (uint32_t)TELEMETRY_PRESET_RUN) {
+            run_gain = rate / text_rate;
+            // 1kHz の制御 tick を間引かずに流せること
+            expect("run preset carries 1kHz", rate >= 1000.0);
+        }
+        expect(telemetry_preset_name((telemetry_preset_t)p), pok);
+    }
+    check_gaps();
+    expect("run gain >= 3", run_gain >= 3.0);
+    if (s_ok && argc > 1) {
+        expect("fault stream", write_fault_stream(argv[1], FAULT_RECORDS));
+    }
+    printf("[telemetry] baud=%u batch=8 packet_max=%u result=%s\n", (unsigned int)UART_BAUD,
+           (unsigned int)TELEMETRY_PACKET_MAX, s_ok ? "ok" : "NG");
+    return s_ok ? 0 : 1;
+}
@@ -0,0 +1,207 @@
+/*
+ * test_trace_ring.c
+ *
+ * platform/trace/trace_ring.c のホスト試験:
+ * 折り返し、drop-newest（満杯時は新しい書き込みを丸ごと捨てる）と破棄数、入るだけ書く
+ * write_some、割り込みで入れ子になった書き込みの公開順、32bit 添字の一周。
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "trace_ring.h"
+
+#define RING_SIZE 16U
+
+static bool s_ok = true;
+
+static void expect(const char *what, bool cond)
+{
+    if (!cond) {
+        printf("[trace-ring] NG: %s\n", what);
+        s_ok = false;
+    }
+}
+
+// 消費者（DMA）と同じく peek/consume で全て読み出す
+static uint32_t drain(trace_ring_t *r, uint8_t *out, uint32_t cap)
+{
+    uint32_t n = 0U;
+
+    while (1) {
+        const uint8_t *data;
+        uint32_t len = trace_ring_peek(r, &data);
+        if (len == 0U) {
+            break;
+        }
+        if (n + len <= cap) {
+            memcpy(&out[n], data, len);
+        }
+        n += len;
+        trace_ring_consume(r, len);
+    }
+    return n;
+}
+
+static void fill_pattern(uint8_t *buf, uint32_t len, uint8_t seed)
+{
+    for (uint32_t i = 0U; i < len; i++) {
+        buf[i] = (uint8_t)(seed + i * 7U);
+    }
+}
+
+static void check_init(void)
+{
+    static uint8_t buf[RING_SIZE];
+    trace_ring_t r;
+
+    expect("init rejects size 0", !trace_ring_init(&r, buf, 0U));
+    expect("init rejects non power of two", !trace_ring_init(&r, buf, 12U));
+    expect("init rejects NULL buffer", !trace_ring_init(&r, NULL, RING_SIZE));
+    expect("init accepts power of two", trace_ring_init(&r, buf, RING_SIZE));
+    expect("empty after init", trace_ring_used(&r) == 0U && trace_ring_free(&r) == RING_SIZE);
+}
+
+// 末尾をまたぐ書き込みは 2 回の peek（末尾まで / 先頭から）に分かれて同じ順で出てくる
+static void check_wrap(void)
+{
+    static uint8_t buf[RING_SIZE];
+    trace_ring_t r;
+    uint8_t in[RING_SIZE];
+    uint8_t out[RING_SIZE];
+    const uint8_t *data;
+
+    trace_ring_init(&r, buf, RING_SIZE);
+    fill_pattern(in, 10U, 1U);
+    expect("first write", trace_ring_write(&r, in, 10U));
+    expect("first drain", drain(&r, out, sizeof(out)) == 10U && memcmp(in, out, 10U) == 0);
+
+    fill_pattern(in, 12U, 50U);
+    expect("wrapping write", trace_ring_write(&r, in, 12U));
+    expect("used after wrapping write", trace_ring_used(&r) == 12U);
+    expect("peek stops at the end of the buffer", trace_ring_peek(&r, &data) == RING_SIZE - 10U);
+    expect("peek points at the tail", data == &buf[10]);
+    expect("wrapped drain", drain(&r, out, sizeof(out)) == 12U && memcmp(in, out, 12U) == 0);
+
+    // 満杯ちょうどまで書ける
+    fill_pattern(in, RING_SIZE, 100U);
+    expect("full-size write", trace_ring_write(&r, in, RING_SIZE));
+    expect("no room when full", trace_ring_free(&r) == 0U);
+    expect("full drain", drain(&r, out, sizeof(out)) == RING_SIZE && memcmp(in, out, RING_SIZE) == 0);
+}
+
+// 入らない書き込みは丸ごと捨て、既に積んだ内容は変えない
+static void check_drop_newest(void)
+{
+    static uint8_t buf[RING_SIZE];
+    trace_ring_t r;
+    uint8_t in[RING_SIZE + 4U];
+    uint8_t out[RING_SIZE];
+
+    trace_ring_init(&r, buf, RING_SIZE);
+    fill_pattern(in, 14U, 3U);
+    expect("fill 14", trace_ring_write(&r, in, 14U));
+    expect("4 bytes do not fit", !trace_ring_write(&r, "abcd", 4U));
+    expect("dropped counters after one drop",
+           atomic_load(&r.dropped_bytes) == 4U && atomic_load(&r.dropped_writes) == 1U);
+    expect("drop leaves used unchanged", trace_ring_used(&r) == 14U);
+    expect("2 bytes still fit", trace_ring_write(&r, "xy", 2U));
+    expect("full", trace_ring_free(&r) == 0U);
+    expect("1 byte does not fit", !trace_ring_write(&r, "z", 1U));
+    expect("zero-length write is not a drop", trace_ring_write(&r, "z", 0U));
+    expect("dropped counters after two drops",
+           atomic_load(&r.dropped_bytes) == 5U && atomic_load(&r.dropped_writes) == 2U);
+    expect("contents keep the older bytes", drain(&r, out, sizeof(out)) == RING_SIZE &&
+                                                 memcmp(out, in, 14U) == 0 && memcmp(&out[14], "xy", 2U) == 0);
+
+    // バッファより長い書き込みは空でも入らない
+    fill_pattern(in, sizeof(in), 9U);
+    expect("oversize write is dropped", !trace_ring_write(&r, in, sizeof(in)));
+    expect("oversize drop counted",
+           atomic_load(&r.dropped_bytes) == 5U + sizeof(in) && atomic_load(&r.dropped_writes) == 3U);
+    expect("empty after oversize drop", trace_ring_used(&r) == 0U);
+}
+
+// write_some は入るだけ書き、破棄数は数えない（lossless 送信の残りは呼び出し側が再送する）
+static void check_write_some(void)
+{
+    static uint8_t buf[RING_SIZE];
+    trace_ring_t r;
+    uint8_t in[RING_SIZE];
+    uint8_t out[RING_SIZE];
+
+    trace_ring_init(&r, buf, RING_SIZE);
+    fill_pattern(in, 13U, 21U);
+    expect("fill 13", trace_ring_write(&r, in, 13U));
+    expect("write_some stores 3 of 5", trace_ring_write_some(&r, "ABCDE", 5U) == 3U);
+    expect("write_some on full ring stores nothing", trace_ring_write_some(&r, "F", 1U) == 0U);
+    expect("write_some does not count drops",
+           atomic_load(&r.dropped_bytes) == 0U && atomic_load(&r.dropped_writes) == 0U);
+    expect("write_some contents", drain(&r, out, sizeof(out)) == RING_SIZE && memcmp(&out[13], "ABC", 3U) == 0);
+}
+
+// 予約中に割り込みが書き込んだ分は、外側の書き込みが公開されるまで消費者に見えない
+static void check_nested_producer(void)
+{
+    static uint8_t buf[RING_SIZE];
+    trace_ring_t r;
+    trace_ring_span_t outer;
+    uint8_t out[RING_SIZE];
+
+    trace_ring_init(&r, buf, RING_SIZE);
+    expect("outer reserve", trace_ring_reserve(&r, 4U, 4U, &outer));
+    expect("outer span", outer.pos == 0U && outer.len == 4U);
+    // ここで割り込みが入り、最後まで書き込んだとする
+    expect("inner write", trace_ring_write(&r, "inn", 3U));
+    expect("inner write is not visible yet", trace_ring_used(&r) == 0U);
+    expect("inner write takes room", trace_ring_free(&r) == RING_SIZE - 7U);
+    trace_ring_fill(&r, &outer, "OUT!");
+    trace_ring_commit(&r);
+    expect("both visible after the outer commit", trace_ring_used(&r) == 7U);
+    expect("outer bytes come first", drain(&r, out, sizeof(out)) == 7U && memcmp(out, "OUT!inn", 7U) == 0);
+
+    // 予約に失敗した生産者は公開を止めない
+    expect("outer reserve 2", trace_ring_reserve(&r, 2U, 2U, &outer));
+    expect("inner write that does not fit is dropped", !trace_ring_write(&r, "0123456789abcde", 15U));
+    trace_ring_fill(&r, &outer, "ok");
+    trace_ring_commit(&r);
+    expect("outer visible after a failed inner reserve", drain(&r, out, sizeof(out)) == 2U &&
+                                                              memcmp(out, "ok", 2U) == 0);
+    expect("writers back to zero", atomic_load(&r.writers) == 0U);
+}
+
+// 添字は 32bit で進め続ける（一周しても used/free がずれない）
+static void check_index_overflow(void)
+{
+    static uint8_t buf[RING_SIZE];
+    trace_ring_t r;
+    uint8_t in[12];
+    uint8_t out[RING_SIZE];
+    const uint32_t base = 0xFFFFFFF8u;
+
+    trace_ring_init(&r, buf, RING_SIZE);
+    atomic_store(&r.head, base);
+    atomic_store(&r.reserve, base);
+    atomic_store(&r.tail, base);
+    fill_pattern(in, sizeof(in), 77U);
+    expect("write across the 32-bit wrap", trace_ring_write(&r, in, sizeof(in)));
+    expect("used across the 32-bit wrap", trace_ring_used(&r) == sizeof(in));
+    expect("free across the 32-bit wrap", trace_ring_free(&r) == RING_SIZE - sizeof(in));
+    expect("head wrapped", atomic_load(&r.head) == (uint32_t)(base + sizeof(in)));
+    expect("drain across the 32-bit wrap", drain(&r, out, sizeof(out)) == sizeof(in) &&
+                                               memcmp(in, out, sizeof(in)) == 0);
+}
+
+int main(void)
+{
+    check_init();
+    check_wrap();
+    check_drop_newest();
+    check_write_some();
+    check_nested_producer();
+    check_index_overflow();
+    printf("[trace-ring] result=%s\n", s_ok ? "ok" : "NG");
+    return s_ok ? 0 : 1;
+}
@@ -0,0 +1,104 @@
+/*
+ * trace_record_sim.c
+ *
+ * ホスト試験用の模擬トレースレコード（trace_record_sim.h）。
+ */
+
+#include "trace_record_sim.h"
+
+#include <math.h>
+#include <string.h>
+
+// (i, k) から決まる -amp..amp の一様な値（レコードを番号だけから作り直せるように乱数列は使わない）
+static int32_t noise(uint32_t i, uint32_t k, int32_t amp)
+{
+    uint32_t h = i * 0x9E3779B1U ^ (k + 1U) * 0x85EBCA77U;
+
+    h ^= h >> 15;
+    h *= 0x2C1B3C6DU;
+    h ^= h >> 12;
+    h *= 0x297A2D39U;
+    h ^= h >> 15;
+    return (int32_t)(h % (uint32_t)(2 * amp + 1)) - amp;
+}
+
+void trace_record_sim_fill(nvm_trace_log_record_t *rec, uint32_t i, bool idle)
+{
+    const uint32_t cycle = 900U;
+    uint32_t t = idle ? 850U : (i % cycle);
+    uint32_t n = i / cycle;
+    uint32_t obs = i / 4U; // 観測キャッシュの更新
+    float v = 0.0f;
+    float a = 0.0f;
+    float omega = 0.0f;
+    float dist = 0.0f;
+    float angle = 90000.0f * (float)n;
+    uint16_t mode_flags = 0x0004U;
+
+    if (t < 600U) {
+        // 0.2s で 1500mm/s、0.2s 巡航、0.2s で停止
+        float ts = (float)t * 0.001f;
+        if (t < 200U) {
+            a = 7500.0f;
+            v = a * ts;
+            dist = 0.5f * a * ts * ts;
+        } else if (t < 400U) {
+            v = 1500.0f;
+            dist = 150.0f + 1500.0f * (ts - 0.2f);
+        } else {
+            float td = ts - 0.4f;
+            a = -7500.0f;
+            v = 1500.0f - 7500.0f * td;
+            dist = 450.0f + 1500.0f * td - 0.5f * 7500.0f * td * td;
+        }
+    } else if (t < 800U) {
+        float tt = (float)(t - 600U) * 0.001f;
+        mode_flags = 0x0010U;
+        omega = 450000.0f; // mdps
+        angle += omega * tt;
+        dist = 600.0f;
+    } else {
+        mode_flags = 0x0008U;
+        dist = 600.0f;
+        angle += 90000.0f;
+    }
+    if (t >= 800U && !idle) {
+        angle = 90000.0f * (float)(n + 1U);
+    }
+
+    memset(rec, 0, sizeof(*rec));
+    rec->seq = i;
+    rec->timestamp_ms = 1000U + i;
+    rec->target_distance_x1000 = (int32_t)lrintf(dist * 1000.0f);
+    rec->distance_mm = (int32_t)lrintf(dist) + noise(i, 0U, 1);
+    rec->angle_mdeg = (int32_t)lrintf(angle) + noise(i, 1U, 40);
+    rec->target_velocity_mm_s = (int32_t)lrintf(v);
+    rec->real_velocity_mm_s = (int32_t)lrintf(v) + noise(i, 2U, 12);
+    rec->accel_velocity_mm_s = (int32_t)lrintf(v) + noise(i, 3U, 6);
+    rec->target_omega_mdps = (int32_t)lrintf(omega);
+    rec->real_omega_mdps = (int32_t)lrintf(omega) + noise(i, 4U, 300);
+    rec->gyro_z_raw_mdps = rec->real_omega_mdps + noise(i, 5U, 60);
+    rec->target_angle_mdeg = (int32_t)lrintf(angle);
+    rec->accel_forward_mm_s2 = (int32_t)lrintf(a) + noise(i, 6U, 150);
+    rec->encoder_l = (int16_t)(lrintf(v * 0.05f - omega * 0.00002f) + noise(i, 7U, 1));
+    rec->encoder_r = (int16_t)(lrintf(v * 0.05f + omega * 0.00002f) + noise(i, 8U, 1));
+    rec->motor_out_l = (int16_t)(lrintf(v * 0.3f + a * 0.02f) + noise(i, 9U, 15));
+    rec->motor_out_r = (int16_t)(lrintf(v * 0.3f + a * 0.02f) + noise(i, 10U, 15));
+    rec->adc_fr = (uint16_t)(600 + (int32_t)(t / 8U) + noise(obs, 11U, 5));
+    rec->adc_r = (uint16_t)(900 + noise(obs, 12U, 5));
+    rec->adc_fl = (uint16_t)(620 + (int32_t)(t / 8U) + noise(obs, 13U, 5));
+    rec->adc_l = (uint16_t)(880 + noise(obs, 14U, 5));
+    rec->adc_vbat = (uint16_t)(3100 - (int32_t)(i / 20000U) + noise(obs / 8U, 15U, 1));
+    rec->flags = (uint16_t)(0xA000U | mode_flags);
+    rec->op_mode = 2U;
+    rec->op_case = 0U;
+    rec->op_sub = 8U;
+    rec->test_id = 0U;
+    rec->reserved_i32_0 = (int32_t)rec->adc_fr - 40;
+    rec->reserved_i32_1 = (int32_t)rec->adc_r - 40;
+    rec->reserved_i32_2 = (int32_t)rec->adc_fl - 40;
+    rec->reserved_i32_3 = (int32_t)rec->adc_l - 40;
+    rec->reserved_u16_0 = (uint16_t)(0x8200U | ((t < 600U) ? 0x0006U : 0x0001U));
+    rec->isr_tick_max_us_x10 = (uint16_t)(160 + noise(i, 16U, 12));
+    rec->isr_period_max_us_x10 = (uint16_t)(10000 + noise(i, 17U, 4));
+}
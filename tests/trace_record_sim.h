@@ -0,0 +1,18 @@
+#ifndef NIGHTFALL_TESTS_TRACE_RECORD_SIM_H_
+#define NIGHTFALL_TESTS_TRACE_RECORD_SIM_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "nvm_trace_log.h"
+
+/*
+ * ホスト試験用の模擬トレースレコード（test_nvm_trace_codec.c / test_telemetry.c で共用）。
+ * 1kHz 自動収集の模擬: 直進（台形速度）600ms / 90 度旋回 200ms / 停止 100ms を繰り返す。
+ * 壁センサ・電池電圧・壁観測の予備欄は f413_trace_log_auto_step() の観測キャッシュ更新と同じく
+ * 数 tick ごとにしか変わらない。idle では停止中の値だけを出す。
+ * レコードは番号 i だけから決まる（乱数列を使わないので、読み出した側で作り直して比べられる）。
+ */
+void trace_record_sim_fill(nvm_trace_log_record_t *rec, uint32_t i, bool idle);
+
+#endif
@@ -0,0 +1,290 @@
+#!/usr/bin/env python3
+"""F413 のライブテレメトリ（UART `~`）を受信・復号して CSV にする。
+
+パケットの形式は platform/trace/telemetry.h を参照。文字のログ行や壊れたパケットが混ざっていても
+同期語から読み直し、CRC の合わないものは 1 バイトずらして次の同期語を探す。
+"""
+import argparse
+import csv
+import os
+import select
+import struct
+import sys
+import time
+from pathlib import Path
+from typing import Optional
+
+from trace_bin_dump import (
+    DEFAULT_BAUD,
+    RECORD_STRUCT_V7,
+    SEARCH_EVENT_COLUMNS,
+    _configure_serial,
+    _detect_port,
+    _rows_from_records,
+    decode_records,
+    record_columns_for_size,
+)
+
+SYNC = b"\xA5\x5A"
+HEADER_STRUCT = struct.Struct("<BBHH")  # channel, reserved, len, seq（同期語の後）
+HEADER_BYTES = 2 + HEADER_STRUCT.size
+CRC_BYTES = 2
+CHANNEL_TRACE = 1
+PAYLOAD_MAX = 1024
+BATCH_MAX = 16
+# platform/trace/telemetry.h の telemetry_group_t と同じ並び
+TELEMETRY_GROUPS = ["motion", "drive", "wall", "observe", "timing"]
+PAYLOAD_HEADER_BYTES = 1 + len(TELEMETRY_GROUPS)
+
+
+def crc16(data: bytes) -> int:
+    """CRC-16/CCITT-FALSE（telemetry_crc16() と同じ）"""
+    crc = 0xFFFF
+    for b in data:
+        crc ^= b << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else (crc << 1)
+            crc &= 0xFFFF
+    return crc
+
+
+def fnv1a(data: bytes) -> int:
+    h = 0x811C9DC5
+    for b in data:
+        h = ((h ^ b) * 0x01000193) & 0xFFFFFFFF
+    return h
+
+
+class TelemetryDecoder:
+    """受信バイト列を順に与えてパケットを取り出す"""
+
+    def __init__(self) -> None:
+        self.buf = bytearray()
+        self.packets = 0
+        self.records = 0
+        self.crc_errors = 0
+        self.decode_errors = 0
+        self.skipped_bytes = 0
+        self.lost_packets = 0
+        self.last_seq: Optional[int] = None
+        self.decimation: list[int] = [0] * len(TELEMETRY_GROUPS)
+
+    def _skip(self, n: int) -> None:
+        del self.buf[:n]
+        self.skipped_bytes += n
+
+    def feed(self, data: bytes) -> list[tuple[int, list[bytes]]]:
+        """取り出せたパケットの (seq, 記録の列) を返す。足りない分は次の feed まで持ち越す。"""
+        self.buf.extend(data)
+        out: list[tuple[int, list[bytes]]] = []
+        while True:
+            idx = self.buf.find(SYNC)
+            if idx < 0:
+                # 末尾の 0xA5 は次の同期語の前半かもしれない
+                keep = 1 if self.buf[-1:] == SYNC[:1] else 0
+                self._skip(len(self.buf) - keep)
+                return out
+            if idx > 0:
+                self._skip(idx)
+            if len(self.buf) < HEADER_BYTES:
+                return out
+            channel, _reserved, length, seq = HEADER_STRUCT.unpack_from(self.buf, 2)
+            if channel != CHANNEL_TRACE or length < PAYLOAD_HEADER_BYTES or length > PAYLOAD_MAX:
+                self._skip(1)
+                continue
+            total = HEADER_BYTES + length + CRC_BYTES
+            if len(self.buf) < total:
+                return out
+            end = HEADER_BYTES + length
+            if crc16(bytes(self.buf[2:end])) != int.from_bytes(self.buf[end:total], "little"):
+                self.crc_errors += 1
+                self._skip(1)
+                continue
+            packet = bytes(self.buf[:total])
+            count = packet[HEADER_BYTES]
+            try:
+                if count == 0 or count > BATCH_MAX:
+                    raise ValueError("bad record count")
+                records, pos = decode_records(packet, HEADER_BYTES + PAYLOAD_HEADER_BYTES, count, end)
+                if pos != end:
+                    raise ValueError("payload length mismatch")
+            except ValueError:
+                self.decode_errors += 1
+                self._skip(1)
+                continue
+            del self.buf[:total]
+            if self.last_seq is not None:
+                self.lost_packets += (seq - self.last_seq - 1) & 0xFFFF
+            self.last_seq = seq
+            self.decimation = list(packet[HEADER_BYTES + 1 : HEADER_BYTES + PAYLOAD_HEADER_BYTES])
+            self.packets += 1
+            self.records += len(records)
+            out.append((seq, records))
+
+    def summary(self) -> str:
+        return (
+            f"packets={self.packets} records={self.records} lost_packets={self.lost_packets} "
+            f"crc_errors={self.crc_errors} decode_errors={self.decode_errors} skipped_bytes={self.skipped_bytes}"
+        )
+
+    def decimation_text(self) -> str:
+        return ",".join(f"{name}:{d}" for name, d in zip(TELEMETRY_GROUPS, self.decimation))
+
+
+def capture_live(port: str, baud: int, command: str, duration_s: float, raw_path: Path) -> bytes:
+    """duration_s 秒（0 なら Ctrl-C まで）受信し、受信中も 1 秒ごとに統計を出す"""
+    fd = os.open(port, os.O_RDWR | os.O_NOCTTY | os.O_NONBLOCK)
+    dec = TelemetryDecoder()
+    chunks: list[bytes] = []
+    try:
+        _configure_serial(fd, baud)
+        time.sleep(0.1)
+        if command:
+            os.write(fd, command.encode("ascii"))
+        start = time.monotonic()
+        next_report = start + 1.0
+        try:
+            while duration_s <= 0.0 or time.monotonic() - start < duration_s:
+                r, _w, _x = select.select([fd], [], [], 0.1)
+                if r:
+                    try:
+                        chunk = os.read(fd, 4096)
+                    except BlockingIOError:
+                        chunk = b""
+                    if chunk:
+                        chunks.append(chunk)
+                        dec.feed(chunk)
+                now = time.monotonic()
+                if now >= next_report:
+                    print(f"[telemetry] {now - start:5.1f}s {dec.summary()}", flush=True)
+                    next_report = now + 1.0
+        except KeyboardInterrupt:
+            pass
+        if command:
+            # 受信を止めたら送信も止める（同じコマンドで切り替え）
+            os.write(fd, command.encode("ascii"))
+    finally:
+        os.close(fd)
+    raw = b"".join(chunks)
+    raw_path.parent.mkdir(parents=True, exist_ok=True)
+    raw_path.write_bytes(raw)
+    print(f"raw: {raw_path} ({len(raw)} bytes)")
+    return raw
+
+
+def write_csv(path: Path, dec: TelemetryDecoder, records: list[bytes]) -> None:
+    record_size = RECORD_STRUCT_V7.size
+    rows = _rows_from_records(records, record_size)
+    with path.open("w", encoding="ascii", newline="") as f:
+        f.write("#log_format=nightfall_telemetry_v1_decoded\n")
+        f.write(f"#telemetry_channels={dec.decimation_text()}\n")
+        f.write(f"#telemetry_packets={dec.packets}\n")
+        f.write(f"#telemetry_lost_packets={dec.lost_packets}\n")
+        f.write(f"#telemetry_crc_errors={dec.crc_errors}\n")
+        f.write("#mm_columns=" + ",".join(record_columns_for_size(record_size) + SEARCH_EVENT_COLUMNS) + "\n")
+        writer = csv.writer(f)
+        for row in rows:
+            writer.writerow(row)
+
+
+def write_plotjuggler(csv_path: Path, out_path: Path) -> int:
+    from export_plotjuggler_csv import _build_output, _load_nightfall_csv
+
+    columns, rows, meta = _load_nightfall_csv(csv_path)
+    out_columns, out_rows = _build_output(columns, rows, meta, True)
+    out_path.parent.mkdir(parents=True, exist_ok=True)
+    with out_path.open("w", encoding="ascii", newline="") as f:
+        writer = csv.writer(f)
+        writer.writerow(out_columns)
+        writer.writerows(out_rows)
+    return len(out_rows)
+
+
+def verify(truth_path: Path, dec: TelemetryDecoder, packets: list[tuple[int, list[bytes]]]) -> bool:
+    """tests/test_telemetry が書いた truth と突き合わせる"""
+    fates: dict[int, str] = {}
+    expect_records: dict[int, int] = {}
+    for line in truth_path.read_text(encoding="ascii").splitlines():
+        parts = line.split()
+        if not parts or parts[0].startswith("#"):
+            continue
+        if parts[0] == "packet":
+            fates[int(parts[1])] = parts[2]
+        elif parts[0] == "record":
+            expect_records[int(parts[1])] = int(parts[2], 16)
+
+    ok = True
+    ok_seqs = sorted(seq for seq, fate in fates.items() if fate == "ok")
+    got_seqs = [seq for seq, _records in packets]
+    if got_seqs != ok_seqs:
+        missing = sorted(set(ok_seqs) - set(got_seqs))
+        extra = sorted(set(got_seqs) - set(ok_seqs))
+        print(f"[verify] packets NG missing={missing[:8]} extra={extra[:8]}")
+        ok = False
+    got_records = 0
+    for _seq, records in packets:
+        for rec in records:
+            rec_seq = struct.unpack_from("<I", rec, 0)[0]
+            if expect_records.get(rec_seq) != fnv1a(rec):
+                print(f"[verify] record seq={rec_seq} NG")
+                ok = False
+            got_records += 1
+    if got_records != len(expect_records):
+        print(f"[verify] records NG got={got_records} expect={len(expect_records)}")
+        ok = False
+    # 最初と最後に届いたパケットの間で失ったもの（seq の飛びとして数えられる分）
+    if ok_seqs:
+        lost = sum(1 for seq, fate in fates.items() if fate != "ok" and ok_seqs[0] < seq < ok_seqs[-1])
+        if dec.lost_packets != lost:
+            print(f"[verify] lost_packets NG got={dec.lost_packets} expect={lost}")
+            ok = False
+    counts = {fate: sum(1 for f in fates.values() if f == fate) for fate in ("ok", "drop", "crc", "trunc")}
+    print(
+        f"[verify] truth ok={counts['ok']} drop={counts['drop']} crc={counts['crc']} trunc={counts['trunc']} "
+        f"records={len(expect_records)} result={'ok' if ok else 'NG'}"
+    )
+    return ok
+
+
+def main() -> int:
+    ap = argparse.ArgumentParser(description="Capture or decode Nightfall live telemetry")
+    ap.add_argument("input", nargs="?", help="raw UART capture to decode; omit to capture from serial")
+    ap.add_argument("--port", default="auto")
+    ap.add_argument("--baud", type=int, default=DEFAULT_BAUD)
+    ap.add_argument("--send", default="~", help="UART command that toggles telemetry when capturing")
+    ap.add_argument("--duration", type=float, default=0.0, help="capture seconds (0 = until Ctrl-C)")
+    ap.add_argument("--raw-out", default=None)
+    ap.add_argument("--csv-out", default=None)
+    ap.add_argument("--plotjuggler", default=None, metavar="OUT", help="also write a PlotJuggler CSV")
+    ap.add_argument("--verify", default=None, metavar="TRUTH", help="compare against a truth file written by tests/test_telemetry")
+    args = ap.parse_args()
+
+    if args.input:
+        raw_path = Path(args.input).expanduser()
+        raw = raw_path.read_bytes()
+    else:
+        port = _detect_port() if args.port in ("", "auto") else args.port
+        if not port:
+            print("UART port not found", file=sys.stderr)
+            return 1
+        raw_path = Path(args.raw_out) if args.raw_out else Path("tools/logging/logs") / f"telemetry_{time.strftime('%Y%m%d_%H%M%S')}.raw"
+        raw = capture_live(port, args.baud, args.send, args.duration, raw_path)
+
+    dec = TelemetryDecoder()
+    packets = dec.feed(raw)
+    print(f"[telemetry] {dec.summary()} channels={dec.decimation_text()}")
+    if args.verify:
+        return 0 if verify(Path(args.verify).expanduser(), dec, packets) else 1
+
+    records = [rec for _seq, recs in packets for rec in recs]
+    csv_path = Path(args.csv_out) if args.csv_out else raw_path.with_suffix(".csv")
+    write_csv(csv_path, dec, records)
+    print(f"csv={csv_path} rows={len(records)}")
+    if args.plotjuggler:
+        rows = write_plotjuggler(csv_path, Path(args.plotjuggler).expanduser())
+        print(f"plotjuggler={args.plotjuggler} rows={rows}")
+    return 0
+
+
+if __name__ == "__main__":
+    raise SystemExit(main())
@@ -17,6 +17,10 @@ DEFAULT_BAUD = int(os.environ.get("NIGHTFALL_UART_BAUD", "921600"))
 IOSSIOSPEED = 0x80045402
 FRAME_STRUCT = struct.Struct("<IIIIIIII")
 HEADER_STRUCT = struct.Struct("<IIIIIIII")
+# フレーム v2（schema 0x00080000 以降）: v1 の 8 語 + payload_bytes。ログヘッダの後ろは圧縮ブロック像（古い順）
+FRAME_STRUCT_V2 = struct.Struct("<IIIIIIIII")
+HEADER_STRUCT_V8 = struct.Struct("<IIIIIIIIIIHHI")
+BLOCK_HEADER_STRUCT = struct.Struct("<HHI")
 RECORD_COLUMNS_V3 = [
     "timestamp_ms",
     "seq",
@@ -164,12 +168,54 @@ RECORD_COLUMNS_V6 = [
     "reserved_u16_0",
     "reserved_u16_1",
 ]
+RECORD_COLUMNS_V7 = [
+    "timestamp_ms",
+    "seq",
+    "op_mode",
+    "op_case",
+    "op_sub",
+    "test_id",
+    "target_distance_mm",
+    "distance_mm",
+    "angle_mdeg",
+    "target_velocity_mm_s",
+    "real_velocity_mm_s",
+    "accel_velocity_mm_s",
+    "target_omega_mdps",
+    "real_omega_mdps",
+    "gyro_z_raw_mdps",
+    "target_angle_mdeg",
+    "accel_forward_mm_s2",
+    "encoder_l",
+    "encoder_r",
+    "motor_out_l",
+    "motor_out_r",
+    "adc_fr",
+    "adc_r",
+    "adc_fl",
+    "adc_l",
+    "adc_vbat",
+    "wall_read_fr",
+    "wall_read_r",
+    "wall_read_fl",
+    "wall_read_l",
+    "flags",
+    "reserved_i32_0",
+    "reserved_i32_1",
+    "reserved_i32_2",
+    "reserved_i32_3",
+    "reserved_u16_0",
+    "reserved_u16_1",
+    "isr_tick_max_us_x10",
+    "isr_period_max_us_x10",
+]
 RECORD_STRUCT_V3 = struct.Struct("<II14i4h6H4B2H")
 RECORD_STRUCT_V4 = struct.Struct("<II19i4h6H4B2H")
 RECORD_STRUCT_V5 = struct.Struct("<II15i4h6H4B2H")
 RECORD_STRUCT_V6 = struct.Struct("<II15i4h10H4B2H")
-RECORD_STRUCT = RECORD_STRUCT_V6
-RECORD_COLUMNS = RECORD_COLUMNS_V6
+RECORD_STRUCT_V7 = struct.Struct("<II15i4h10H4B4H")
+RECORD_STRUCT = RECORD_STRUCT_V7
+RECORD_COLUMNS = RECORD_COLUMNS_V7
 SEARCH_EVENT_MARKER = 0x5345
 SEARCH_EVENT_SESSION_START = 0xE0
 SEARCH_EVENT_PHASE = 0xE1
@@ -207,9 +253,148 @@ RECORD_LAYOUTS = {
     RECORD_STRUCT_V4.size: (RECORD_STRUCT_V4, RECORD_COLUMNS_V4),
     RECORD_STRUCT_V5.size: (RECORD_STRUCT_V5, RECORD_COLUMNS_V5),
     RECORD_STRUCT_V6.size: (RECORD_STRUCT_V6, RECORD_COLUMNS_V6),
+    RECORD_STRUCT_V7.size: (RECORD_STRUCT_V7, RECORD_COLUMNS_V7),
 }
 
 
+# nvm_trace_log_record_t（v7 以降）のフィールドと struct 書式。オフセットはこの並びから求める
+RECORD_FIELDS_V7 = [
+    ("seq", "I"),
+    ("timestamp_ms", "I"),
+    ("target_distance_x1000", "i"),
+    ("distance_mm", "i"),
+    ("angle_mdeg", "i"),
+    ("target_velocity_mm_s", "i"),
+    ("real_velocity_mm_s", "i"),
+    ("accel_velocity_mm_s", "i"),
+    ("target_omega_mdps", "i"),
+    ("real_omega_mdps", "i"),
+    ("gyro_z_raw_mdps", "i"),
+    ("target_angle_mdeg", "i"),
+    ("accel_forward_mm_s2", "i"),
+    ("reserved_i32_0", "i"),
+    ("reserved_i32_1", "i"),
+    ("reserved_i32_2", "i"),
+    ("reserved_i32_3", "i"),
+    ("encoder_l", "h"),
+    ("encoder_r", "h"),
+    ("motor_out_l", "h"),
+    ("motor_out_r", "h"),
+    ("adc_fr", "H"),
+    ("adc_r", "H"),
+    ("adc_fl", "H"),
+    ("adc_l", "H"),
+    ("adc_vbat", "H"),
+    ("wall_read_fr", "H"),
+    ("wall_read_r", "H"),
+    ("wall_read_fl", "H"),
+    ("wall_read_l", "H"),
+    ("flags", "H"),
+    ("op_mode", "B"),
+    ("op_case", "B"),
+    ("op_sub", "B"),
+    ("test_id", "B"),
+    ("reserved_u16_0", "H"),
+    ("reserved_u16_1", "H"),
+    ("isr_tick_max_us_x10", "H"),
+    ("isr_period_max_us_x10", "H"),
+]
+# nvm/nvm_trace_codec.c の k_nvm_trace_codec_fields と同じ並び（L = 直前 2 件からの直線予測、D = 直前の値）
+CODEC_FIELDS = [
+    ("target_distance_x1000", "L"), ("distance_mm", "L"), ("angle_mdeg", "L"), ("target_velocity_mm_s", "L"),
+    ("real_velocity_mm_s", "D"), ("accel_velocity_mm_s", "D"), ("real_omega_mdps", "D"), ("gyro_z_raw_mdps", "D"),
+    ("motor_out_l", "D"), ("motor_out_r", "D"), ("encoder_l", "D"), ("encoder_r", "D"),
+    ("accel_forward_mm_s2", "D"), ("target_omega_mdps", "L"), ("target_angle_mdeg", "L"), ("isr_tick_max_us_x10", "D"),
+    ("isr_period_max_us_x10", "D"), ("adc_fr", "D"), ("adc_r", "D"), ("adc_fl", "D"),
+    ("adc_l", "D"), ("adc_vbat", "D"), ("seq", "L"), ("timestamp_ms", "L"),
+    ("reserved_i32_0", "D"), ("reserved_i32_1", "D"), ("reserved_i32_2", "D"), ("reserved_i32_3", "D"),
+    ("reserved_u16_0", "D"), ("reserved_u16_1", "D"), ("flags", "D"), ("wall_read_fr", "D"),
+    ("wall_read_r", "D"), ("wall_read_fl", "D"), ("wall_read_l", "D"), ("op_mode", "D"),
+    ("op_case", "D"), ("op_sub", "D"), ("test_id", "D"),
+]
+CODEC_GROUP_COUNT = (len(CODEC_FIELDS) + 7) // 8
+
+
+def _codec_field_layout() -> list[tuple[int, int, bool, bool]]:
+    offsets: dict[str, tuple[int, str]] = {}
+    off = 0
+    for name, fmt in RECORD_FIELDS_V7:
+        offsets[name] = (off, fmt)
+        off += struct.calcsize("<" + fmt)
+    layout = []
+    for name, pred in CODEC_FIELDS:
+        field_off, fmt = offsets[name]
+        layout.append((field_off, struct.calcsize("<" + fmt), fmt.islower(), pred == "L"))
+    return layout
+
+
+CODEC_LAYOUT = _codec_field_layout()
+
+
+def _narrow(value: int, size: int, signed: bool) -> int:
+    bits = size * 8
+    value &= (1 << bits) - 1
+    if signed and value >= (1 << (bits - 1)):
+        value -= 1 << bits
+    return value & 0xFFFFFFFF
+
+
+def decode_records(data: bytes, pos: int, count: int, end: int) -> tuple[list[bytes], int]:
+    """data[pos:end] の符号化レコード count 件（先頭はキーフレーム）を復号し、(レコード列, 次の位置) を返す"""
+    prev = [0] * len(CODEC_LAYOUT)
+    prev2 = [0] * len(CODEC_LAYOUT)
+    out: list[bytes] = []
+    try:
+        for n in range(count):
+            group_mask = data[pos]
+            pos += 1
+            values = []
+            field_mask = 0
+            for i, (field_off, size, signed, linear) in enumerate(CODEC_LAYOUT):
+                if i % 8 == 0:
+                    field_mask = 0
+                    if group_mask & (1 << (i // 8)):
+                        field_mask = data[pos]
+                        pos += 1
+                z = 0
+                if field_mask & (1 << (i % 8)):
+                    shift = 0
+                    while True:
+                        b = data[pos]
+                        pos += 1
+                        z |= (b & 0x7F) << shift
+                        shift += 7
+                        if not b & 0x80:
+                            break
+                residual = (z >> 1) ^ (-(z & 1) & 0xFFFFFFFF)
+                pred = (2 * prev[i] - prev2[i]) if (linear and n >= 2) else prev[i]
+                values.append(_narrow(pred + residual, size, signed))
+            if pos > end:
+                raise ValueError("record runs past end")
+            rec = bytearray(RECORD_STRUCT_V7.size)
+            for (field_off, size, _signed, _linear), value in zip(CODEC_LAYOUT, values):
+                rec[field_off : field_off + size] = (value & ((1 << (size * 8)) - 1)).to_bytes(size, "little")
+            out.append(bytes(rec))
+            prev2 = prev
+            prev = values
+    except IndexError:
+        raise ValueError("record runs past end") from None
+    return out, pos
+
+
+def decode_block(image: bytes) -> list[bytes]:
+    """圧縮ブロック像 1 つを nvm_trace_log_record_t のバイト列の並びへ戻す（壊れていれば ValueError）"""
+    if len(image) < BLOCK_HEADER_STRUCT.size:
+        raise ValueError("short block")
+    records, used, block_sum = BLOCK_HEADER_STRUCT.unpack_from(image, 0)
+    if records == 0 or used > len(image) or used <= BLOCK_HEADER_STRUCT.size:
+        raise ValueError("bad block header")
+    if checksum(image[BLOCK_HEADER_STRUCT.size : used]) != block_sum:
+        raise ValueError("block checksum mismatch")
+    out, _pos = decode_records(image, BLOCK_HEADER_STRUCT.size, records, used)
+    return out
+
+
 def record_struct_for_size(record_size: int) -> Optional[struct.Struct]:
     layout = RECORD_LAYOUTS.get(record_size)
     return layout[0] if layout else None
@@ -480,6 +665,11 @@ def _record_to_row_v6(values: tuple[int, ...]) -> list[str]:
     ]
 
 
+def _record_to_row_v7(values: tuple[int, ...]) -> list[str]:
+    isr_tick_max, isr_period_max = values[37:39]
+    return _record_to_row_v6(values[:37]) + [str(isr_tick_max), str(isr_period_max)]
+
+
 def _record_to_row(values: tuple[int, ...], record_size: int) -> list[str]:
     if record_size == RECORD_STRUCT_V3.size:
         return _record_to_row_v3(values)
@@ -489,6 +679,8 @@ def _record_to_row(values: tuple[int, ...], record_size: int) -> list[str]:
         return _record_to_row_v5(values)
     if record_size == RECORD_STRUCT_V6.size:
         return _record_to_row_v6(values)
+    if record_size == RECORD_STRUCT_V7.size:
+        return _record_to_row_v7(values)
     raise ValueError(f"unsupported record size: {record_size}")
 
 
@@ -588,6 +780,65 @@ def _decode_search_event(row: list[str], columns: list[str]) -> list[str]:
     ]
 
 
+def _rows_from_records(records: list[bytes], record_size: int) -> list[list[str]]:
+    rec_struct = record_struct_for_size(record_size)
+    columns = record_columns_for_size(record_size)
+    rows: list[list[str]] = []
+    for rec_bytes in records:
+        row = _record_to_row(rec_struct.unpack_from(rec_bytes, 0), record_size)
+        row.extend(_decode_search_event(row, columns))
+        rows.append(row)
+    return rows
+
+
+def _extract_frame_v2(raw: bytes, idx: int) -> Optional[tuple[dict[str, int], dict[str, int], list[list[str]]]]:
+    if idx + FRAME_STRUCT_V2.size > len(raw):
+        return None
+    fields = FRAME_STRUCT_V2.unpack_from(raw, idx)
+    frame = {
+        "magic": fields[0],
+        "version": fields[1],
+        "schema": fields[2],
+        "header_size": fields[3],
+        "record_size": fields[4],
+        "record_count": fields[5],
+        "available_count": fields[6],
+        "payload_checksum": fields[7],
+        "payload_bytes": fields[8],
+    }
+    if frame["header_size"] != HEADER_STRUCT_V8.size or frame["record_size"] != RECORD_STRUCT_V7.size:
+        return None
+    total_len = FRAME_STRUCT_V2.size + frame["header_size"] + frame["payload_bytes"]
+    if idx + total_len > len(raw):
+        return None
+    payload = raw[idx + FRAME_STRUCT_V2.size : idx + total_len]
+    if checksum(payload) != frame["payload_checksum"]:
+        return None
+    hv = HEADER_STRUCT_V8.unpack_from(payload, 0)
+    header = {
+        "magic": hv[0],
+        "version": hv[1],
+        "length": hv[2],
+        "crc": hv[3],
+        "record_size": hv[4],
+        "block_size": hv[5],
+        "block_count": hv[6],
+        "write_block": hv[7],
+        "total_records": hv[8],
+        "total_blocks": hv[9],
+    }
+    records: list[bytes] = []
+    off = frame["header_size"]
+    while off < len(payload):
+        _count, used, _sum = BLOCK_HEADER_STRUCT.unpack_from(payload, off)
+        records.extend(decode_block(payload[off : off + used]))
+        off += used
+    # 先頭のブロックは要求より古いレコードを含むことがある
+    records = records[-frame["record_count"] :] if frame["record_count"] else []
+    frame["record_count"] = len(records)
+    return frame, header, _rows_from_records(records, frame["record_size"])
+
+
 def extract_frame(raw: bytes) -> tuple[dict[str, int], dict[str, int], list[list[str]], int]:
     pos = 0
     while True:
@@ -597,6 +848,15 @@ def extract_frame(raw: bytes) -> tuple[dict[str, int], dict[str, int], list[list
         if idx + FRAME_STRUCT.size > len(raw):
             raise ValueError("incomplete frame header")
         fields = FRAME_STRUCT.unpack_from(raw, idx)
+        if fields[1] == 2:
+            try:
+                decoded = _extract_frame_v2(raw, idx)
+            except (ValueError, IndexError, struct.error):
+                decoded = None
+            if decoded is not None:
+                return decoded[0], decoded[1], decoded[2], idx
+            pos = idx + 1
+            continue
         frame = {
             "magic": fields[0],
             "version": fields[1],
@@ -638,7 +898,7 @@ def extract_frame(raw: bytes) -> tuple[dict[str, int], dict[str, int], list[list
 
 def write_csv(path: Path, frame: dict[str, int], header: dict[str, int], rows: list[list[str]]) -> None:
     with path.open("w", encoding="ascii", newline="") as f:
-        f.write("#log_format=nightfall_trace_bin_v1_decoded\n")
+        f.write(f"#log_format=nightfall_trace_bin_v{frame['version']}_decoded\n")
         f.write(f"#fw_log_schema=0x{frame['schema']:08X}\n")
         f.write(f"#bin_record_count={frame['record_count']}\n")
         f.write(f"#bin_available_count={frame['available_count']}\n")
@@ -265,6 +265,7 @@ def _build_nightfall_plot(df):
         ("Flags", "raw / 0-1", ["flags", "flag_idle", "flag_motor_forward", "flag_motor_coast", "flag_motor_reverse", "flag_abort_switch", "flag_abort_wall_fault", "flag_abort_encoder_fault", "flag_abort_imu_fault", "flag_angle_target", "flag_auto"]),
         ("Reserved i32", "raw", ["reserved_i32_0", "reserved_i32_1", "reserved_i32_2", "reserved_i32_3"]),
         ("Reserved u16", "raw", ["reserved_u16_0", "reserved_u16_1"]),
+        ("ISR Timing", "0.1us", ["isr_tick_max_us_x10", "isr_period_max_us_x10"]),
         ("Tune", "raw", ["tune_ref", "tune_error"]),
     ]
 
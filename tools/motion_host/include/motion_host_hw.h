@@ -0,0 +1,20 @@
+#ifndef NIGHTFALL_MOTION_HOST_HW_H_
+#define NIGHTFALL_MOTION_HOST_HW_H_
+
+// motion_host のビルドで全ソースの先頭に -include する。
+// 実機のレジスタ番地を直接読むエンコーダのカウンタ（TIM8/TIM4->CNT）を
+// シミュレータ側の構造体へ差し替える（main.h はインクルードガードで以後は再展開されない）。
+#include "main.h"
+
+extern TIM_TypeDef g_motion_host_tim4;
+extern TIM_TypeDef g_motion_host_tim8;
+
+#undef TIM4
+#define TIM4 (&g_motion_host_tim4)
+#undef TIM8
+#define TIM8 (&g_motion_host_tim8)
+
+// CMSIS の __DMB() は Cortex-M の命令なので、ホストでは同じ順序保証のフェンスにする
+#define __DMB() __atomic_thread_fence(__ATOMIC_SEQ_CST)
+
+#endif
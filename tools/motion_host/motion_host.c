@@ -0,0 +1,1368 @@
+/*
+ * motion_host.c
+ *
+ * F405 の走行プリミティブ（drive.c）と最短走行（run.c の run_shortest() / run()）を
+ * PC 上で閉ループ実行するシミュレータ。
+ * - 制御割り込み（interrupt.c の TIM5 節 → control.c の PID 縦続 → drive_motor()）は実物をリンクする
+ * - drive_motor() が書く TIM2 の CCR と DIR/STBY ピンから差動二輪のモデルを動かし、
+ *   エンコーダ（TIM8/TIM4->CNT）とジャイロ（omega_z_true / accel_y_true）を返す
+ * - 待ちループの background_replan_tick() と HAL_Delay() で 1ms ずつ時間を進める
+ * 壁センサは常に 0（壁なし）なので、横壁制御・壁切れ補正・前壁補正は働かない。
+ */
+
+#define _POSIX_C_SOURCE 200809L
+#define MAIN_C_
+#include "global.h"
+
+#include "logging.h"
+#include "maze_grid.h"
+#include "solver.h"
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <math.h>
+#include <setjmp.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#if !ENABLE_BG_REPLAN
+#error "motion_host は drive.c の待ちループが呼ぶ background_replan_tick() で時間を進める（ENABLE_BG_REPLAN=1 でビルドする）"
+#endif
+
+#define MOTION_TICK_S 0.001f
+#define MOTION_SUBSTEPS 4
+#define MOTION_SEG_MAX 1024
+#define MOTION_GRAVITY_MMPS2 9806.65f
+#define MOTION_PI 3.14159265358979f
+// read_encoder() と同じ換算（400PPR × 4逓倍、円周率も同じ値を使い距離の偏りを出さない）
+#define MOTION_ENC_CPR 1600.0f
+#define MOTION_ENC_PI 3.1415f
+
+// trace CSV の flags（tools/logging/analyze_trace_csv.py と同じビット）
+#define MOTION_FLAG_IDLE 0x0002u
+#define MOTION_FLAG_MOTOR_FWD 0x0004u
+#define MOTION_FLAG_MOTOR_COAST 0x0008u
+#define MOTION_FLAG_MOTOR_REV 0x0010u
+#define MOTION_FLAG_ANGLE_TARGET 0x2000u
+#define MOTION_FLAG_AUTO 0x8000u
+
+enum {
+    MOTION_ABORT_NONE = 0,
+    MOTION_ABORT_TIMEOUT,
+    MOTION_ABORT_NO_PATH,
+};
+
+/*============================================================
+    機体モデル
+============================================================*/
+// 各輪の駆動力はデューティと逆起電力に比例する DC モータの近似。
+// 車輪ごとの並進加速度 a_w = 0.5 * a_stall * (u * vbat - v_w / v_free) - 0.5 * a_fric * sgn(v_w)
+// 並進 a = a_l + a_r、回転 alpha = (a_r - a_l) * (tread / 2) / gyration^2（滑り無し）
+typedef struct {
+    float v_free;    // デューティ100%の無負荷速度 [mm/s]
+    float a_stall;   // 両輪デューティ100%・停止時の並進加速度 [mm/s^2]
+    float a_fric;    // 転がり摩擦の減速度 [mm/s^2]
+    float tread;     // トレッド [mm]
+    float gyration;  // 重心まわりの慣性半径 [mm]
+    float vbat;      // 電池電圧の公称比（1.0 = 公称）
+    float gyro_bias; // ジャイロのゼロ点ずれ [deg/s]
+} MotionPlant;
+
+static MotionPlant s_plant = {
+    .v_free = 6000.0f,
+    .a_stall = 40000.0f,
+    .a_fric = 300.0f,
+    .tread = 32.0f,
+    .gyration = 14.0f,
+    .vbat = 1.0f,
+    .gyro_bias = 0.0f,
+};
+
+typedef struct {
+    float v;        // 並進速度 [mm/s]
+    float omega;    // 角速度 [rad/s]（CCW 正）
+    float accel;    // 並進加速度 [mm/s^2]
+    float x;        // 位置 [mm]（スタート時の前方 +y）
+    float y;
+    float theta;    // 向き [rad]（スタート時 0、CCW 正）
+    double enc_l;   // 車輪の回転量 [count]
+    double enc_r;
+    int32_t cnt_l;  // 整数化したカウント（エンコーダの量子化）
+    int32_t cnt_r;
+    float duty_l;   // 符号付きデューティ（-1..1、惰行時 0）
+    float duty_r;
+    bool coast_l;
+    bool coast_r;
+    float travel;   // 走行距離の積算 [mm]
+} MotionState;
+
+static MotionState s_state;
+
+/*============================================================
+    実機ペリフェラルの代替
+============================================================*/
+ADC_HandleTypeDef hadc1;
+SPI_HandleTypeDef hspi3;
+TIM_HandleTypeDef htim1;
+TIM_HandleTypeDef htim2;
+TIM_HandleTypeDef htim3;
+TIM_HandleTypeDef htim4;
+TIM_HandleTypeDef htim5;
+TIM_HandleTypeDef htim6;
+TIM_HandleTypeDef htim8;
+UART_HandleTypeDef huart1;
+DMA_HandleTypeDef hdma_adc1;
+
+TIM_TypeDef g_motion_host_tim4;
+TIM_TypeDef g_motion_host_tim8;
+static TIM_TypeDef s_tim1;
+static TIM_TypeDef s_tim2;
+static TIM_TypeDef s_tim3;
+static TIM_TypeDef s_tim5;
+static TIM_TypeDef s_tim6;
+
+static bool s_pwm_on_l; // TIM2 CH1（左）
+static bool s_pwm_on_r; // TIM2 CH4（右）
+
+typedef struct {
+    GPIO_TypeDef *port;
+    uint16_t pin;
+    GPIO_PinState state;
+} MotionPin;
+
+static MotionPin s_pins[16];
+static unsigned int s_pin_count;
+
+static MotionPin *pin_slot(GPIO_TypeDef *port, uint16_t pin, bool create)
+{
+    for (unsigned int i = 0U; i < s_pin_count; i++) {
+        if (s_pins[i].port == port && s_pins[i].pin == pin) {
+            return &s_pins[i];
+        }
+    }
+    if (!create || s_pin_count >= (sizeof(s_pins) / sizeof(s_pins[0]))) {
+        return NULL;
+    }
+    s_pins[s_pin_count].port = port;
+    s_pins[s_pin_count].pin = pin;
+    s_pins[s_pin_count].state = GPIO_PIN_RESET;
+    return &s_pins[s_pin_count++];
+}
+
+void HAL_GPIO_WritePin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin, GPIO_PinState PinState)
+{
+    MotionPin *p = pin_slot(GPIOx, GPIO_Pin, true);
+    if (p != NULL) {
+        p->state = PinState;
+    }
+}
+
+GPIO_PinState HAL_GPIO_ReadPin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin)
+{
+    const MotionPin *p = pin_slot(GPIOx, GPIO_Pin, false);
+    return (p != NULL) ? p->state : GPIO_PIN_RESET;
+}
+
+HAL_StatusTypeDef HAL_TIM_PWM_Start(TIM_HandleTypeDef *htim, uint32_t Channel)
+{
+    if (htim == &htim2) {
+        if (Channel == TIM_CHANNEL_1) {
+            s_pwm_on_l = true;
+        } else if (Channel == TIM_CHANNEL_4) {
+            s_pwm_on_r = true;
+        }
+    }
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_TIM_PWM_Stop(TIM_HandleTypeDef *htim, uint32_t Channel)
+{
+    if (htim == &htim2) {
+        if (Channel == TIM_CHANNEL_1) {
+            s_pwm_on_l = false;
+        } else if (Channel == TIM_CHANNEL_4) {
+            s_pwm_on_r = false;
+        }
+    }
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_TIM_Encoder_Start(TIM_HandleTypeDef *htim, uint32_t Channel)
+{
+    (void)htim;
+    (void)Channel;
+    return HAL_OK;
+}
+
+// drive_enable_motor() の数十us待ちは 1ms 未満なので時間を進めない
+void tim1_wait_us(uint32_t us)
+{
+    (void)us;
+}
+
+// IMU: モデルの角速度・加速度を返す（オフセット除去後の値として渡す）
+void IMU_DataUpdate(void)
+{
+    omega_z_true = (s_state.omega * (180.0f / MOTION_PI) + s_plant.gyro_bias) / KP_IMU;
+    accel_y_true = s_state.accel / MOTION_GRAVITY_MMPS2;
+}
+
+void IMU_GetOffset(void) {}
+
+// 壁センサ・LED・ブザー・ログは動かさない（ad_* は 0 のまま = 壁なし）
+uint8_t get_base(void) { return 1U; }
+void get_wall_info(void) {}
+void detect_wall_end(void) {}
+void wall_end_set_detect_mode(uint8_t mode) { wall_end_detect_mode = mode; }
+void wall_end_update_deriv(void) {}
+void wall_end_reset(void)
+{
+    wall_end_detected_r = false;
+    wall_end_detected_l = false;
+}
+HAL_StatusTypeDef sensor_adc_dma_start(volatile uint16_t *dst)
+{
+    (void)dst;
+    return HAL_OK;
+}
+void sensor_log_start(void) {}
+void sensor_log_stop(void) {}
+void sensor_log_capture(void) {}
+void led_write(bool a, bool b, bool c)
+{
+    (void)a;
+    (void)b;
+    (void)c;
+}
+void led_flash(uint8_t n) { (void)n; }
+void led_wait(void) {}
+void buzzer_beep(uint16_t ms) { (void)ms; }
+int select_mode(int mode) { return mode; }
+void log_init(void) {}
+void log_set_profile(LogProfile profile) { (void)profile; }
+void log_start(uint32_t start_time) { (void)start_time; }
+void log_stop(void) {}
+void log_print_all(void) {}
+void log_capture_tick(void) {}
+void turn_dir(uint8_t t_pat) { (void)t_pat; }
+
+/*============================================================
+    迷路の読み込み（tools/solver_host と同じ .maze テキスト形式）
+============================================================*/
+static uint8_t s_walls_bl[MAZE_SIZE][MAZE_SIZE];
+static unsigned int s_maze_size = 16U;
+
+static void set_wall_pair(unsigned int x, unsigned int y, uint8_t wall)
+{
+    if (x >= s_maze_size || y >= s_maze_size) {
+        return;
+    }
+    s_walls_bl[y][x] |= wall;
+    if ((wall == NORTH_WALL) && ((y + 1U) < s_maze_size)) {
+        s_walls_bl[y + 1U][x] |= SOUTH_WALL;
+    } else if ((wall == EAST_WALL) && ((x + 1U) < s_maze_size)) {
+        s_walls_bl[y][x + 1U] |= WEST_WALL;
+    } else if ((wall == SOUTH_WALL) && (y > 0U)) {
+        s_walls_bl[y - 1U][x] |= NORTH_WALL;
+    } else if ((wall == WEST_WALL) && (x > 0U)) {
+        s_walls_bl[y][x - 1U] |= EAST_WALL;
+    }
+}
+
+static bool line_has_horizontal_wall(const char *line, unsigned int x)
+{
+    const size_t pos = (size_t)x * 4U + 1U;
+    if (strlen(line) < pos + 3U) {
+        return false;
+    }
+    return (line[pos] == '-') || (line[pos + 1U] == '-') || (line[pos + 2U] == '-') ||
+           (line[pos] == '.') || (line[pos + 1U] == '.') || (line[pos + 2U] == '.');
+}
+
+static bool line_has_vertical_wall(const char *line, unsigned int x)
+{
+    const size_t pos = (size_t)x * 4U;
+    if (strlen(line) <= pos) {
+        return false;
+    }
+    return (line[pos] == '|') || (line[pos] == '.');
+}
+
+static bool load_maze_text_file(const char *path_name)
+{
+    static char buf[64U * 1024U];
+    char *lines[2U * MAZE_SIZE + 1U];
+    size_t line_count = 0U;
+    FILE *fp = fopen(path_name, "r");
+
+    if (fp == NULL) {
+        fprintf(stderr, "cannot open %s\n", path_name);
+        return false;
+    }
+    const size_t n = fread(buf, 1U, sizeof(buf) - 1U, fp);
+    fclose(fp);
+    buf[n] = '\0';
+
+    for (char *line = strtok(buf, "\r\n"); line != NULL && line_count < (sizeof(lines) / sizeof(lines[0]));
+         line = strtok(NULL, "\r\n")) {
+        lines[line_count++] = line;
+    }
+    if ((line_count < 3U) || ((line_count % 2U) == 0U) || (((line_count - 1U) / 2U) > MAZE_SIZE)) {
+        fprintf(stderr, "invalid maze text: %s\n", path_name);
+        return false;
+    }
+
+    s_maze_size = (unsigned int)((line_count - 1U) / 2U);
+    for (unsigned int y = 0U; y < MAZE_SIZE; y++) {
+        for (unsigned int x = 0U; x < MAZE_SIZE; x++) {
+            s_walls_bl[y][x] = (x < s_maze_size && y < s_maze_size) ? 0U : 0x0FU;
+        }
+    }
+    for (unsigned int y = 0U; y < s_maze_size; y++) {
+        const unsigned int row = s_maze_size - 1U - y;
+        for (unsigned int x = 0U; x < s_maze_size; x++) {
+            if (line_has_horizontal_wall(lines[row * 2U], x)) {
+                set_wall_pair(x, y, NORTH_WALL);
+            }
+            if (line_has_horizontal_wall(lines[row * 2U + 2U], x)) {
+                set_wall_pair(x, y, SOUTH_WALL);
+            }
+            if (line_has_vertical_wall(lines[row * 2U + 1U], x)) {
+                set_wall_pair(x, y, WEST_WALL);
+            }
+            if (line_has_vertical_wall(lines[row * 2U + 1U], x + 1U)) {
+                set_wall_pair(x, y, EAST_WALL);
+            }
+        }
+    }
+    for (unsigned int i = 0U; i < s_maze_size; i++) {
+        set_wall_pair(i, 0U, SOUTH_WALL);
+        set_wall_pair(i, s_maze_size - 1U, NORTH_WALL);
+        set_wall_pair(0U, i, WEST_WALL);
+        set_wall_pair(s_maze_size - 1U, i, EAST_WALL);
+    }
+    set_wall_pair(START_X, START_Y, EAST_WALL);
+    return true;
+}
+
+// solver_build_path() が読む探索済み map（全区画既知として上位4bitに壁を置く）
+void load_map_from_eeprom(void)
+{
+    for (unsigned int y = 0U; y < MAZE_SIZE; y++) {
+        for (unsigned int x = 0U; x < MAZE_SIZE; x++) {
+            map[y][x] = (uint16_t)((uint16_t)(s_walls_bl[y][x] & 0x0FU) << 4U);
+        }
+    }
+}
+
+/*============================================================
+    時間の進行と集計
+============================================================*/
+typedef struct {
+    const char *name;
+    char label[24];    // 走行コマンドキューの区間名（name が指す）
+    uint32_t start_ms;
+    uint32_t end_ms;
+    float v_in;
+    float v_out;
+    float dist_err_max;
+    float angle_err_max;
+} MotionSegment;
+
+typedef struct {
+    int abort_reason;
+    bool failed;
+    uint32_t fail_ms;      // 走行中に MF.FLAG.FAILED が最初に立った時刻（0 = 立たなかった）
+    uint16_t path_len;
+    uint16_t turn_skip;    // 1ms も掛からずに戻った旋回（パラメータ未設定で旋回表が作れない等）
+    uint32_t run_ms;       // MF.FLAG.RUNNING が立っていた時間
+    float dist_err_max;    // |target_distance - real_distance| の最大 [mm]
+    double dist_err_sq;
+    float vel_err_max;     // |target_velocity - real_velocity| の最大 [mm/s]
+    float v_peak;          // 実速度の最大 [mm/s]
+    float v_cmd_peak;      // 指令速度（velocity_interrupt）の最大 [mm/s]
+    float angle_err_max;   // |target_angle - real_angle| の最大 [deg]
+    float heading_err;     // 終了時のモデルの向きと最寄りの 45deg 倍角との差 [deg]
+    float travel;          // モデルの走行距離 [mm]
+    float end_x;
+    float end_y;
+    float end_theta;
+} MotionResult;
+
+static uint32_t s_tick_ms;
+static uint32_t s_max_ms = 120000U;
+static uint32_t s_abort_at_ms;
+static jmp_buf s_abort_jmp;
+static bool s_abort_armed;
+static MotionResult s_result;
+static FILE *s_trace_fp;
+static uint32_t s_trace_seq;
+
+static MotionSegment s_segs[MOTION_SEG_MAX];
+static unsigned int s_seg_count;
+static int s_seg_open = -1;
+
+static uint16_t s_path_literal[ROUTE_MAX_LEN];
+static uint16_t s_path_literal_len;
+
+static void motion_abort(int reason)
+{
+    if (s_abort_armed) {
+        s_abort_armed = false;
+        longjmp(s_abort_jmp, reason);
+    }
+}
+
+// IN/IN 駆動: IN1 = DIR ピン、IN2 = PWM。IN1 != IN2 の割合が駆動デューティ（IN1 == IN2 は短絡ブレーキ）
+static float wheel_duty(uint32_t ccr, GPIO_TypeDef *dir_port, uint16_t dir_pin, GPIO_PinState fwd_level)
+{
+    const float arr = (float)s_tim2.ARR;
+    const GPIO_PinState dir = HAL_GPIO_ReadPin(dir_port, dir_pin);
+    float frac;
+
+    if (arr <= 0.0f) {
+        return 0.0f;
+    }
+    frac = (float)ccr / arr;
+    if (frac > 1.0f) {
+        frac = 1.0f;
+    }
+    if (dir == GPIO_PIN_SET) {
+        frac = 1.0f - frac;
+    }
+    return (dir == fwd_level) ? frac : -frac;
+}
+
+static float wheel_accel(float duty, bool coast, float v_wheel)
+{
+    float a = 0.0f;
+    if (!coast) {
+        a = 0.5f * s_plant.a_stall * (duty * s_plant.vbat - v_wheel / s_plant.v_free);
+    }
+    // 摩擦は速度 0 付近で連続になるよう tanh で符号を丸める
+    return a - 0.5f * s_plant.a_fric * tanhf(v_wheel / 5.0f);
+}
+
+static void plant_step(void)
+{
+    const bool stby = (HAL_GPIO_ReadPin(MOTOR_STBY_GPIO_Port, MOTOR_STBY_Pin) == GPIO_PIN_SET);
+    const float dt = MOTION_TICK_S / (float)MOTION_SUBSTEPS;
+    const float half_tread = 0.5f * s_plant.tread;
+    const float yaw_gain = half_tread / (s_plant.gyration * s_plant.gyration);
+    const float counts_per_mm = MOTION_ENC_CPR / (D_TIRE * MOTION_ENC_PI);
+
+    s_state.coast_l = !(stby && s_pwm_on_l);
+    s_state.coast_r = !(stby && s_pwm_on_r);
+    s_state.duty_l = s_state.coast_l ? 0.0f : wheel_duty(s_tim2.CCR1, MOTOR_L_DIR_GPIO_Port, MOTOR_L_DIR_Pin, DIR_FWD_L);
+    s_state.duty_r = s_state.coast_r ? 0.0f : wheel_duty(s_tim2.CCR4, MOTOR_R_DIR_GPIO_Port, MOTOR_R_DIR_Pin, DIR_FWD_R);
+
+    for (int i = 0; i < MOTION_SUBSTEPS; i++) {
+        const float v_l = s_state.v - s_state.omega * half_tread;
+        const float v_r = s_state.v + s_state.omega * half_tread;
+        const float a_l = wheel_accel(s_state.duty_l, s_state.coast_l, v_l);
+        const float a_r = wheel_accel(s_state.duty_r, s_state.coast_r, v_r);
+        const float theta_mid = s_state.theta + 0.5f * s_state.omega * dt;
+
+        s_state.accel = a_l + a_r;
+        s_state.x += -s_state.v * sinf(theta_mid) * dt;
+        s_state.y += s_state.v * cosf(theta_mid) * dt;
+        s_state.theta += s_state.omega * dt;
+        s_state.travel += fabsf(s_state.v) * dt;
+        s_state.enc_l += (double)(v_l * dt * counts_per_mm);
+        s_state.enc_r += (double)(v_r * dt * counts_per_mm);
+        s_state.v += s_state.accel * dt;
+        s_state.omega += (a_r - a_l) * yaw_gain * dt;
+    }
+
+    // read_encoder() の符号規約に合わせて前進量をカウンタへ足す（CNT は ISR で 30000 に戻される）
+    const int32_t cnt_l = (int32_t)floor(s_state.enc_l);
+    const int32_t cnt_r = (int32_t)floor(s_state.enc_r);
+    g_motion_host_tim4.CNT = (uint32_t)((int32_t)g_motion_host_tim4.CNT + DIR_ENC_L * (cnt_l - s_state.cnt_l));
+    g_motion_host_tim8.CNT = (uint32_t)((int32_t)g_motion_host_tim8.CNT - DIR_ENC_R * (cnt_r - s_state.cnt_r));
+    s_state.cnt_l = cnt_l;
+    s_state.cnt_r = cnt_r;
+}
+
+static void stats_tick(void)
+{
+    if (!MF.FLAG.RUNNING) {
+        return;
+    }
+    // run() は FAILED を見ずに次のプリミティブへ進むので、立った時点で記録する
+    if (MF.FLAG.FAILED && !s_result.failed) {
+        s_result.failed = true;
+        s_result.fail_ms = s_tick_ms;
+    }
+    const float e_dist = fabsf(target_distance - real_distance);
+    const float e_vel = fabsf(target_velocity - real_velocity);
+    const float e_ang = fabsf(target_angle - real_angle);
+
+    s_result.run_ms++;
+    s_result.dist_err_sq += (double)e_dist * (double)e_dist;
+    s_result.dist_err_max = fmaxf(s_result.dist_err_max, e_dist);
+    s_result.vel_err_max = fmaxf(s_result.vel_err_max, e_vel);
+    s_result.angle_err_max = fmaxf(s_result.angle_err_max, e_ang);
+    s_result.v_peak = fmaxf(s_result.v_peak, real_velocity);
+    s_result.v_cmd_peak = fmaxf(s_result.v_cmd_peak, velocity_interrupt);
+
+    if (s_seg_open >= 0) {
+        MotionSegment *seg = &s_segs[s_seg_open];
+        seg->dist_err_max = fmaxf(seg->dist_err_max, e_dist);
+        seg->angle_err_max = fmaxf(seg->angle_err_max, e_ang);
+    }
+}
+
+static void trace_tick(void)
+{
+    uint16_t flags;
+
+    if (s_trace_fp == NULL) {
+        return;
+    }
+    if (!MF.FLAG.RUNNING) {
+        flags = MOTION_FLAG_IDLE;
+    } else if (s_state.duty_l == 0.0f && s_state.duty_r == 0.0f) {
+        flags = MOTION_FLAG_MOTOR_COAST;
+    } else if (s_state.duty_l < 0.0f || s_state.duty_r < 0.0f) {
+        flags = MOTION_FLAG_MOTOR_REV;
+    } else {
+        flags = MOTION_FLAG_MOTOR_FWD;
+    }
+    if (MF.FLAG.RUNNING) {
+        flags |= MOTION_FLAG_AUTO;
+    }
+    if (MF.FLAG.SLALOM_R || MF.FLAG.SLALOM_L || alpha_interrupt != 0.0f || omega_interrupt != 0.0f) {
+        flags |= MOTION_FLAG_ANGLE_TARGET;
+    }
+
+    fprintf(s_trace_fp, "%u,%u,%u,%u,%d,%d,%d,%u,%d,%d,%ld,%ld,%ld,%ld,%ld,%ld,%ld\n",
+            (unsigned)s_tick_ms, (unsigned)s_trace_seq++,
+            (unsigned)((uint32_t)s_state.cnt_l & 0xFFFFu), (unsigned)((uint32_t)s_state.cnt_r & 0xFFFFu),
+            (int)lrintf(s_state.duty_l * 1000.0f), (int)lrintf(s_state.duty_r * 1000.0f),
+            (int)lrintf(real_omega * 1000.0f), (unsigned)flags,
+            (int)lrintf(target_velocity), (int)lrintf(real_velocity),
+            lrintf(target_distance * 1000.0f), lrintf(real_distance * 1000.0f),
+            lrintf(target_angle * 1000.0f), lrintf(real_angle * 1000.0f),
+            lrintf(s_state.x * 1000.0f), lrintf(s_state.y * 1000.0f),
+            lrintf(s_state.theta * (180000.0f / MOTION_PI)));
+}
+
+static void seg_begin(const char *name);
+static void seg_end(void);
+
+// run() が走行コマンドキューに積んだ区間は、割り込みが次のコマンドを始めた tick で区切る
+// （同じ tick に終わった距離 0 の区間は記録しない）
+static uint32_t s_queue_started;
+static bool s_queue_seg_open;
+
+static void queue_seg_tick(void)
+{
+    static const char *const type_name[] = {"q_straight", "q_fwall", "q_wallend", "q_turn"};
+    drive_queue_status_t st;
+
+    drive_queue_get_status(&st);
+    if (st.started != s_queue_started) {
+        s_queue_started = st.started;
+        seg_end();
+        seg_begin("");
+        if (s_seg_open >= 0) {
+            MotionSegment *seg = &s_segs[s_seg_open];
+            snprintf(seg->label, sizeof(seg->label), "%s %u",
+                     (st.type < 4U) ? type_name[st.type] : "q_?", (unsigned)st.tag);
+            seg->name = seg->label;
+        }
+        s_queue_seg_open = true;
+    } else if (s_queue_seg_open && !st.busy && st.pending == 0U) {
+        seg_end();
+        s_queue_seg_open = false;
+    }
+}
+
+// 1ms 進める: モデルを積分してから TIM5 の制御割り込みを実行する
+static void motion_tick(void)
+{
+    plant_step();
+    s_tick_ms++;
+    HAL_TIM_PeriodElapsedCallback(&htim5);
+    queue_seg_tick();
+    stats_tick();
+    trace_tick();
+    if (s_tick_ms >= s_abort_at_ms) {
+        motion_abort(MOTION_ABORT_TIMEOUT);
+    }
+}
+
+// drive.c の待ちループから毎回呼ばれる（実機では探索の背景再計算、ここでは 1ms の経過）
+void background_replan_tick(void)
+{
+    motion_tick();
+}
+
+uint32_t HAL_GetTick(void)
+{
+    return s_tick_ms;
+}
+
+void HAL_Delay(uint32_t Delay)
+{
+    // HAL と同じく最低 1 tick を上乗せする
+    uint32_t wait = Delay;
+    if (wait < HAL_MAX_DELAY) {
+        wait += 1U;
+    }
+    for (uint32_t i = 0U; i < wait; i++) {
+        motion_tick();
+    }
+}
+
+// run_shortest() の経路作成: --path 指定時はその列を使う。経路が無ければ停止ループに入らず中断する
+bool __real_solver_build_path(uint8_t mode, uint8_t case_index);
+bool __wrap_solver_build_path(uint8_t mode, uint8_t case_index)
+{
+    bool ok;
+
+    if (s_path_literal_len > 0U) {
+        memcpy(path, s_path_literal, sizeof(uint16_t) * s_path_literal_len);
+        path[s_path_literal_len] = 0;
+        ok = true;
+    } else {
+        ok = __real_solver_build_path(mode, case_index);
+    }
+    if (!ok || path[0] == 0) {
+        motion_abort(MOTION_ABORT_NO_PATH);
+    }
+    for (s_result.path_len = 0U; path[s_result.path_len] != 0; s_result.path_len++) {
+    }
+    return ok;
+}
+
+/*============================================================
+    run() が呼ぶプリミティブ単位の区間記録（リンカの --wrap で差し込む）
+============================================================*/
+static void seg_begin(const char *name)
+{
+    if (s_seg_count >= MOTION_SEG_MAX) {
+        s_seg_open = -1;
+        return;
+    }
+    MotionSegment *seg = &s_segs[s_seg_count];
+    memset(seg, 0, sizeof(*seg));
+    seg->name = name;
+    seg->start_ms = s_tick_ms;
+    seg->v_in = real_velocity;
+    s_seg_open = (int)s_seg_count++;
+}
+
+static void seg_end(void)
+{
+    if (s_seg_open >= 0) {
+        MotionSegment *seg = &s_segs[s_seg_open];
+        seg->end_ms = s_tick_ms;
+        seg->v_out = real_velocity;
+        if (seg->end_ms == seg->start_ms && strstr(seg->name, "turn_") != NULL) {
+            s_result.turn_skip++;
+        }
+    }
+    s_seg_open = -1;
+}
+
+#define MOTION_WRAP0(fn)                                                                           \
+    void __real_##fn(void);                                                                        \
+    void __wrap_##fn(void)                                                                         \
+    {                                                                                              \
+        seg_begin(#fn);                                                                            \
+        __real_##fn();                                                                             \
+        seg_end();                                                                                 \
+    }
+#define MOTION_WRAP1(fn, t1)                                                                       \
+    void __real_##fn(t1);                                                                          \
+    void __wrap_##fn(t1 a)                                                                         \
+    {                                                                                              \
+        seg_begin(#fn);                                                                            \
+        __real_##fn(a);                                                                            \
+        seg_end();                                                                                 \
+    }
+#define MOTION_WRAP2(fn, t1, t2)                                                                   \
+    void __real_##fn(t1, t2);                                                                      \
+    void __wrap_##fn(t1 a, t2 b)                                                                   \
+    {                                                                                              \
+        seg_begin(#fn);                                                                            \
+        __real_##fn(a, b);                                                                         \
+        seg_end();                                                                                 \
+    }
+
+MOTION_WRAP0(first_sectionA)
+MOTION_WRAP1(half_sectionD, uint16_t)
+MOTION_WRAP1(turn_R90, uint8_t)
+MOTION_WRAP1(turn_L90, uint8_t)
+MOTION_WRAP1(l_turn_R90, bool)
+MOTION_WRAP1(l_turn_L90, bool)
+MOTION_WRAP1(l_turn_R180, bool)
+MOTION_WRAP1(l_turn_L180, bool)
+MOTION_WRAP0(turn_R45_In)
+MOTION_WRAP0(turn_L45_In)
+MOTION_WRAP0(turn_R45_Out)
+MOTION_WRAP0(turn_L45_Out)
+MOTION_WRAP0(turn_RV90)
+MOTION_WRAP0(turn_LV90)
+MOTION_WRAP0(turn_R135_In)
+MOTION_WRAP0(turn_L135_In)
+MOTION_WRAP0(turn_R135_Out)
+MOTION_WRAP0(turn_L135_Out)
+MOTION_WRAP2(run_diagonal, float, float)
+
+void __real_run_straight(float section, float spd_out, float dist_wallend);
+void __wrap_run_straight(float section, float spd_out, float dist_wallend)
+{
+    seg_begin("run_straight");
+    __real_run_straight(section, spd_out, dist_wallend);
+    seg_end();
+}
+
+bool __real_driveC_wallend(float dist_max, float spd);
+bool __wrap_driveC_wallend(float dist_max, float spd)
+{
+    seg_begin("driveC_wallend");
+    const bool found = __real_driveC_wallend(dist_max, spd);
+    seg_end();
+    return found;
+}
+
+/*============================================================
+    1 回の走行
+============================================================*/
+static void motion_reset(void)
+{
+    memset(&s_state, 0, sizeof(s_state));
+    memset(&s_result, 0, sizeof(s_result));
+    s_seg_count = 0U;
+    s_seg_open = -1;
+    s_queue_started = 0U;
+    s_queue_seg_open = false;
+    s_tick_ms = 0U;
+    s_trace_seq = 0U;
+    s_pin_count = 0U;
+    s_pwm_on_l = false;
+    s_pwm_on_r = false;
+
+    htim1.Instance = &s_tim1;
+    htim2.Instance = &s_tim2;
+    htim3.Instance = &s_tim3;
+    htim4.Instance = &g_motion_host_tim4;
+    htim5.Instance = &s_tim5;
+    htim6.Instance = &s_tim6;
+    htim8.Instance = &g_motion_host_tim8;
+    s_tim2.ARR = 1000U; // MX_TIM2_Init() の Period
+    s_tim3.ARR = 1000U;
+    g_motion_host_tim4.CNT = 30000U;
+    g_motion_host_tim8.CNT = 30000U;
+
+    g_ctrl_dt = MOTION_TICK_S;
+    drive_init();
+}
+
+static void motion_finish(void)
+{
+    const float deg = s_state.theta * (180.0f / MOTION_PI);
+    drive_queue_status_t st;
+
+    // キューで実行した旋回のうち、旋回表が作れず飛ばしたもの
+    drive_queue_get_status(&st);
+    s_result.turn_skip += st.turn_skip;
+    s_result.failed = s_result.failed || MF.FLAG.FAILED;
+    s_result.heading_err = deg - 45.0f * roundf(deg / 45.0f);
+    s_result.travel = s_state.travel;
+    s_result.end_x = s_state.x;
+    s_result.end_y = s_state.y;
+    s_result.end_theta = deg;
+    seg_end();
+}
+
+// longjmp で戻る枠にはローカル変数を置かない（-Wclobbered。出力の付け替えは呼び出し側で行う）
+static __attribute__((noinline)) int run_guarded(uint8_t mode, uint8_t case_index)
+{
+    int reason;
+
+    s_abort_at_ms = s_max_ms;
+    s_abort_armed = true;
+    reason = setjmp(s_abort_jmp);
+    if (reason == 0) {
+        run_shortest(mode, case_index);
+    }
+    s_abort_armed = false;
+    return reason;
+}
+
+static bool run_quiet(bool quiet, uint8_t mode, uint8_t case_index)
+{
+    int saved_stdout = -1;
+    int null_fd = -1;
+    int reason;
+
+    if (quiet) {
+        saved_stdout = dup(STDOUT_FILENO);
+        null_fd = open("/dev/null", O_WRONLY);
+        if (saved_stdout >= 0 && null_fd >= 0) {
+            fflush(stdout);
+            dup2(null_fd, STDOUT_FILENO);
+        }
+    }
+
+    reason = run_guarded(mode, case_index);
+    s_result.abort_reason = reason;
+    motion_finish();
+
+    if (saved_stdout >= 0 && null_fd >= 0) {
+        fflush(stdout);
+        dup2(saved_stdout, STDOUT_FILENO);
+    }
+    if (saved_stdout >= 0) {
+        close(saved_stdout);
+    }
+    if (null_fd >= 0) {
+        close(null_fd);
+    }
+    return (reason == MOTION_ABORT_NONE) && !s_result.failed;
+}
+
+static const char *result_name(const MotionResult *r)
+{
+    if (r->abort_reason == MOTION_ABORT_TIMEOUT) {
+        return "timeout";
+    }
+    if (r->abort_reason == MOTION_ABORT_NO_PATH) {
+        return "no-path";
+    }
+    return r->failed ? "failsafe" : "ok";
+}
+
+static double result_dist_rms(const MotionResult *r)
+{
+    return (r->run_ms > 0U) ? sqrt(r->dist_err_sq / (double)r->run_ms) : 0.0;
+}
+
+static void print_result_fields(FILE *fp, const MotionResult *r)
+{
+    fprintf(fp,
+            "result=%s path_len=%u turn_skip=%u run_ms=%u dist_err_max=%.2f dist_err_rms=%.2f vel_err_max=%.1f "
+            "v_peak=%.1f v_over=%.1f angle_err_max=%.2f heading_err=%.2f",
+            result_name(r), (unsigned)r->path_len, (unsigned)r->turn_skip, (unsigned)r->run_ms, r->dist_err_max,
+            result_dist_rms(r), r->vel_err_max, r->v_peak, r->v_peak - r->v_cmd_peak,
+            r->angle_err_max, r->heading_err);
+}
+
+static void print_segments(void)
+{
+    printf("[motion] segments=%u\n", s_seg_count);
+    for (unsigned int i = 0U; i < s_seg_count; i++) {
+        const MotionSegment *seg = &s_segs[i];
+        printf("  #%03u %-16s t=%6u..%6u ms dur=%5u v_in=%7.1f v_out=%7.1f dist_err=%5.2f angle_err=%5.2f\n",
+               i, seg->name, (unsigned)seg->start_ms, (unsigned)seg->end_ms,
+               (unsigned)(seg->end_ms - seg->start_ms), seg->v_in, seg->v_out, seg->dist_err_max,
+               seg->angle_err_max);
+    }
+}
+
+static void trace_open(const char *trace_path, uint8_t mode, uint8_t case_index)
+{
+    s_trace_fp = fopen(trace_path, "w");
+    if (s_trace_fp == NULL) {
+        fprintf(stderr, "cannot open %s\n", trace_path);
+        return;
+    }
+    fprintf(s_trace_fp, "#fw_target=motion_host\n");
+    fprintf(s_trace_fp, "#fw_machine_unit=%s\n", MOTION_HOST_VARIANT);
+    fprintf(s_trace_fp, "#motion_mode=%u\n#motion_case=%u\n", (unsigned)mode, (unsigned)case_index);
+    fprintf(s_trace_fp,
+            "#motion_plant=v_free=%g,a_stall=%g,a_fric=%g,tread=%g,gyration=%g,vbat=%g,gyro_bias=%g\n",
+            s_plant.v_free, s_plant.a_stall, s_plant.a_fric, s_plant.tread, s_plant.gyration,
+            s_plant.vbat, s_plant.gyro_bias);
+    fprintf(s_trace_fp,
+            "#mm_columns=timestamp_ms,seq,encoder_l,encoder_r,motor_out_l,motor_out_r,omega_z_mdps,flags,"
+            "target_velocity_mmps,real_velocity_mmps,target_distance_um,real_distance_um,"
+            "target_angle_mdeg,real_angle_mdeg,pose_x_um,pose_y_um,pose_theta_mdeg\n");
+}
+
+/*============================================================
+    一括実行とゴールデン比較
+============================================================*/
+typedef struct {
+    char key[96];
+    MotionResult r;
+} BatchEntry;
+
+typedef struct {
+    BatchEntry *items;
+    size_t count;
+    size_t cap;
+} BatchSet;
+
+static BatchEntry *batch_push(BatchSet *set)
+{
+    if (set->count == set->cap) {
+        const size_t cap = (set->cap == 0U) ? 64U : set->cap * 2U;
+        BatchEntry *items = realloc(set->items, cap * sizeof(*items));
+        if (items == NULL) {
+            return NULL;
+        }
+        set->items = items;
+        set->cap = cap;
+    }
+    memset(&set->items[set->count], 0, sizeof(set->items[0]));
+    return &set->items[set->count++];
+}
+
+// 迷路ごとに子プロセスで走らせ、前の走行の内部状態（static 変数など）を持ち越さない
+static bool run_isolated(const char *maze_file, uint8_t mode, uint8_t case_index, MotionResult *out)
+{
+    int fds[2];
+    pid_t pid;
+    ssize_t got;
+    int status = 0;
+
+    fflush(stdout);
+    if (pipe(fds) != 0) {
+        return false;
+    }
+    pid = fork();
+    if (pid < 0) {
+        close(fds[0]);
+        close(fds[1]);
+        return false;
+    }
+    if (pid == 0) {
+        close(fds[0]);
+        motion_reset();
+        if (!load_maze_text_file(maze_file)) {
+            _exit(2);
+        }
+        run_quiet(true, mode, case_index);
+        if (write(fds[1], &s_result, sizeof(s_result)) != (ssize_t)sizeof(s_result)) {
+            _exit(3);
+        }
+        _exit(0);
+    }
+    close(fds[1]);
+    got = read(fds[0], out, sizeof(*out));
+    close(fds[0]);
+    waitpid(pid, &status, 0);
+    return (got == (ssize_t)sizeof(*out)) && WIFEXITED(status) && (WEXITSTATUS(status) == 0);
+}
+
+static int cmp_name(const void *a, const void *b)
+{
+    return strcmp(*(const char *const *)a, *(const char *const *)b);
+}
+
+static bool golden_parse_line(const char *line, BatchEntry *e)
+{
+    char maze[64];
+    unsigned int mode = 0U;
+    unsigned int case_index = 0U;
+    char result[16];
+    unsigned int path_len = 0U;
+    unsigned int turn_skip = 0U;
+    unsigned int run_ms = 0U;
+    float dist_max = 0.0f;
+    float dist_rms = 0.0f;
+    float vel_max = 0.0f;
+    float v_peak = 0.0f;
+    float v_over = 0.0f;
+    float angle_max = 0.0f;
+    float heading = 0.0f;
+
+    if (sscanf(line,
+               "%63s mode=%u case=%u result=%15s path_len=%u turn_skip=%u run_ms=%u dist_err_max=%f dist_err_rms=%f "
+               "vel_err_max=%f v_peak=%f v_over=%f angle_err_max=%f heading_err=%f",
+               maze, &mode, &case_index, result, &path_len, &turn_skip, &run_ms, &dist_max, &dist_rms, &vel_max,
+               &v_peak, &v_over, &angle_max, &heading) != 14) {
+        return false;
+    }
+    snprintf(e->key, sizeof(e->key), "%s mode=%u case=%u", maze, mode, case_index);
+    e->r.abort_reason = (strcmp(result, "timeout") == 0)   ? MOTION_ABORT_TIMEOUT
+                        : (strcmp(result, "no-path") == 0) ? MOTION_ABORT_NO_PATH
+                                                           : MOTION_ABORT_NONE;
+    e->r.failed = (strcmp(result, "failsafe") == 0);
+    e->r.path_len = (uint16_t)path_len;
+    e->r.turn_skip = (uint16_t)turn_skip;
+    e->r.run_ms = run_ms;
+    e->r.dist_err_max = dist_max;
+    e->r.vel_err_max = vel_max;
+    e->r.angle_err_max = angle_max;
+    e->r.heading_err = heading;
+    return true;
+}
+
+static bool golden_load(const char *golden_path, BatchSet *set)
+{
+    char line[512];
+    FILE *fp = fopen(golden_path, "r");
+
+    if (fp == NULL) {
+        fprintf(stderr, "cannot open golden %s\n", golden_path);
+        return false;
+    }
+    while (fgets(line, sizeof(line), fp) != NULL) {
+        BatchEntry tmp;
+        if (line[0] == '#' || !golden_parse_line(line, &tmp)) {
+            continue;
+        }
+        BatchEntry *e = batch_push(set);
+        if (e == NULL) {
+            fclose(fp);
+            return false;
+        }
+        *e = tmp;
+    }
+    fclose(fp);
+    return true;
+}
+
+static const BatchEntry *batch_find(const BatchSet *set, const char *key)
+{
+    for (size_t i = 0U; i < set->count; i++) {
+        if (strcmp(set->items[i].key, key) == 0) {
+            return &set->items[i];
+        }
+    }
+    return NULL;
+}
+
+typedef struct {
+    uint32_t time_tol_ms;   // 走行時間の許容増加 [ms]
+    float dist_tol_mm;      // 位置追従誤差の許容増加 [mm]
+    float angle_tol_deg;    // 角度追従誤差・終了時の向きの許容増加 [deg]
+} GoldenTolerance;
+
+// 結果が変わった・走行時間が延びた・追従誤差が増えた組は回帰（終了コード1）
+static unsigned int golden_compare(const BatchSet *run, const BatchSet *golden, const GoldenTolerance *tol)
+{
+    unsigned int regress = 0U;
+    unsigned int improved = 0U;
+    unsigned int missing = 0U;
+    unsigned int added = 0U;
+    long long sum_now = 0;
+    long long sum_golden = 0;
+
+    for (size_t i = 0U; i < run->count; i++) {
+        const BatchEntry *e = &run->items[i];
+        const BatchEntry *g = batch_find(golden, e->key);
+        if (g == NULL) {
+            printf("new      %s\n", e->key);
+            added++;
+            continue;
+        }
+        sum_now += e->r.run_ms;
+        sum_golden += g->r.run_ms;
+        const char *what = NULL;
+        if (strcmp(result_name(&e->r), result_name(&g->r)) != 0 || e->r.path_len != g->r.path_len ||
+            e->r.turn_skip > g->r.turn_skip) {
+            what = "RESULT";
+        } else if (e->r.run_ms > g->r.run_ms + tol->time_tol_ms) {
+            what = "TIME";
+        } else if (e->r.dist_err_max > g->r.dist_err_max + tol->dist_tol_mm ||
+                   e->r.angle_err_max > g->r.angle_err_max + tol->angle_tol_deg ||
+                   fabsf(e->r.heading_err) > fabsf(g->r.heading_err) + tol->angle_tol_deg) {
+            what = "TRACK";
+        }
+        if (what != NULL) {
+            printf("%-8s %s %s->%s run_ms=%u->%u dist_err_max=%.2f->%.2f angle_err_max=%.2f->%.2f "
+                   "heading_err=%.2f->%.2f\n",
+                   what, e->key, result_name(&g->r), result_name(&e->r), (unsigned)g->r.run_ms,
+                   (unsigned)e->r.run_ms, g->r.dist_err_max, e->r.dist_err_max, g->r.angle_err_max,
+                   e->r.angle_err_max, g->r.heading_err, e->r.heading_err);
+            regress++;
+        } else if (e->r.run_ms + tol->time_tol_ms < g->r.run_ms) {
+            improved++;
+        }
+    }
+    for (size_t i = 0U; i < golden->count; i++) {
+        if (batch_find(run, golden->items[i].key) == NULL) {
+            printf("missing  %s\n", golden->items[i].key);
+            missing++;
+        }
+    }
+    printf("[motion-golden] compared=%zu regress=%u faster=%u new=%u missing=%u run_ms_sum=%lld->%lld\n",
+           run->count - added, regress, improved, added, missing, sum_golden, sum_now);
+    return regress;
+}
+
+static int run_batch(const char *dir, const uint8_t *modes, unsigned int mode_count, const uint8_t *cases,
+                     unsigned int case_count, const char *golden_path, bool update_golden,
+                     const GoldenTolerance *tol)
+{
+    char *names[256];
+    unsigned int name_count = 0U;
+    BatchSet run = {0};
+    BatchSet golden = {0};
+    unsigned int not_ok = 0U;
+    DIR *dp = opendir(dir);
+    int rc = 0;
+
+    if (dp == NULL) {
+        fprintf(stderr, "cannot open %s\n", dir);
+        return 2;
+    }
+    for (struct dirent *de = readdir(dp); de != NULL && name_count < 256U; de = readdir(dp)) {
+        const size_t len = strlen(de->d_name);
+        if (len > 5U && strcmp(de->d_name + len - 5U, ".maze") == 0) {
+            names[name_count++] = strdup(de->d_name);
+        }
+    }
+    closedir(dp);
+    qsort(names, name_count, sizeof(names[0]), cmp_name);
+
+    for (unsigned int i = 0U; i < name_count; i++) {
+        char maze_path[1024];
+        snprintf(maze_path, sizeof(maze_path), "%s/%s", dir, names[i]);
+        for (unsigned int m = 0U; m < mode_count; m++) {
+            for (unsigned int c = 0U; c < case_count; c++) {
+                BatchEntry *e = batch_push(&run);
+                if (e == NULL) {
+                    return 2;
+                }
+                snprintf(e->key, sizeof(e->key), "%s mode=%u case=%u", names[i], (unsigned)modes[m],
+                         (unsigned)cases[c]);
+                if (!run_isolated(maze_path, modes[m], cases[c], &e->r)) {
+                    fprintf(stderr, "simulation crashed: %s\n", e->key);
+                    return 2;
+                }
+                printf("%s ", e->key);
+                print_result_fields(stdout, &e->r);
+                printf("\n");
+                if (e->r.abort_reason != MOTION_ABORT_NONE || e->r.failed) {
+                    not_ok++;
+                }
+            }
+        }
+        free(names[i]);
+    }
+    printf("[motion-batch] runs=%zu not_ok=%u\n", run.count, not_ok);
+
+    if (golden_path != NULL && update_golden) {
+        FILE *fp = fopen(golden_path, "w");
+        if (fp == NULL) {
+            fprintf(stderr, "cannot write golden %s\n", golden_path);
+            return 2;
+        }
+        fprintf(fp, "# motion_host --batch golden (tools/motion_host/run_motion_corpus.sh --update)\n");
+        fprintf(fp, "# variant=%s maze_size=%u goal1=%u,%u plant=v_free=%g,a_stall=%g,a_fric=%g,tread=%g,gyration=%g\n",
+                MOTION_HOST_VARIANT, (unsigned)MAZE_SIZE, (unsigned)GOAL1_X, (unsigned)GOAL1_Y,
+                s_plant.v_free, s_plant.a_stall, s_plant.a_fric, s_plant.tread, s_plant.gyration);
+        for (size_t i = 0U; i < run.count; i++) {
+            fprintf(fp, "%s ", run.items[i].key);
+            print_result_fields(fp, &run.items[i].r);
+            fprintf(fp, "\n");
+        }
+        fclose(fp);
+        printf("[motion-golden] updated %s (%zu runs)\n", golden_path, run.count);
+    } else if (golden_path != NULL) {
+        if (!golden_load(golden_path, &golden)) {
+            rc = 2;
+        } else if (golden_compare(&run, &golden, tol) > 0U) {
+            rc = 1;
+        }
+    }
+    free(run.items);
+    free(golden.items);
+    return rc;
+}
+
+/*============================================================
+    コマンドライン
+============================================================*/
+static bool parse_plant(char *spec)
+{
+    for (char *tok = strtok(spec, ","); tok != NULL; tok = strtok(NULL, ",")) {
+        char *eq = strchr(tok, '=');
+        if (eq == NULL) {
+            return false;
+        }
+        *eq = '\0';
+        const float v = strtof(eq + 1, NULL);
+        if (strcmp(tok, "v_free") == 0) {
+            s_plant.v_free = v;
+        } else if (strcmp(tok, "a_stall") == 0) {
+            s_plant.a_stall = v;
+        } else if (strcmp(tok, "a_fric") == 0) {
+            s_plant.a_fric = v;
+        } else if (strcmp(tok, "tread") == 0) {
+            s_plant.tread = v;
+        } else if (strcmp(tok, "gyration") == 0) {
+            s_plant.gyration = v;
+        } else if (strcmp(tok, "vbat") == 0) {
+            s_plant.vbat = v;
+        } else if (strcmp(tok, "gyro_bias") == 0) {
+            s_plant.gyro_bias = v;
+        } else {
+            return false;
+        }
+    }
+    return (s_plant.v_free > 0.0f) && (s_plant.a_stall > 0.0f) && (s_plant.gyration > 0.0f);
+}
+
+static bool parse_path_literal(char *spec)
+{
+    s_path_literal_len = 0U;
+    for (char *tok = strtok(spec, ","); tok != NULL; tok = strtok(NULL, ",")) {
+        const long v = strtol(tok, NULL, 10);
+        if (v <= 0 || v > 0xFFFF || s_path_literal_len + 1U >= ROUTE_MAX_LEN) {
+            return false;
+        }
+        s_path_literal[s_path_literal_len++] = (uint16_t)v;
+    }
+    return s_path_literal_len > 0U;
+}
+
+static unsigned int parse_list(const char *spec, uint8_t *out, unsigned int cap, unsigned int lo,
+                               unsigned int hi)
+{
+    unsigned int n = 0U;
+    const char *p = spec;
+
+    while (*p != '\0' && n < cap) {
+        char *end;
+        unsigned long a = strtoul(p, &end, 10);
+        unsigned long b = a;
+        if (end == p) {
+            return 0U;
+        }
+        if (*end == '-') {
+            p = end + 1;
+            b = strtoul(p, &end, 10);
+        }
+        for (unsigned long v = a; v <= b && n < cap; v++) {
+            if (v < lo || v > hi) {
+                return 0U;
+            }
+            out[n++] = (uint8_t)v;
+        }
+        p = (*end == ',') ? end + 1 : end;
+        if (*end != ',' && *end != '\0') {
+            return 0U;
+        }
+    }
+    return n;
+}
+
+static void print_usage(const char *argv0)
+{
+    fprintf(stderr,
+            "usage: %s [--maze FILE | --path CODES] [--mode M] [--case C] [--trace CSV] [--segments]\n"
+            "          [--plant key=val,...] [--max-ms MS] [--verbose-fw]\n"
+            "       %s --batch DIR [--modes 2-7] [--cases 1-9] [--golden FILE [--update-golden]]\n"
+            "          [--time-tolerance-ms MS] [--dist-tolerance-mm MM] [--angle-tolerance-deg DEG]\n",
+            argv0, argv0);
+}
+
+int main(int argc, char **argv)
+{
+    const char *maze_file = NULL;
+    const char *trace_path = NULL;
+    const char *batch_dir = NULL;
+    const char *golden_path = NULL;
+    bool update_golden = false;
+    bool show_segments = false;
+    bool verbose_fw = false;
+    uint8_t mode = 2U;
+    uint8_t case_index = 1U;
+    uint8_t modes[8] = {2U, 3U, 4U, 5U, 6U, 7U};
+    unsigned int mode_count = 6U;
+    uint8_t cases[9] = {1U, 2U, 3U, 4U, 5U, 6U, 7U, 8U, 9U};
+    unsigned int case_count = 9U;
+    GoldenTolerance tol = {.time_tol_ms = 5U, .dist_tol_mm = 0.5f, .angle_tol_deg = 0.5f};
+
+    for (int i = 1; i < argc; i++) {
+        const bool has_arg = (i + 1) < argc;
+        if (strcmp(argv[i], "--maze") == 0 && has_arg) {
+            maze_file = argv[++i];
+        } else if (strcmp(argv[i], "--path") == 0 && has_arg) {
+            if (!parse_path_literal(argv[++i])) {
+                fprintf(stderr, "invalid --path\n");
+                return 2;
+            }
+        } else if (strcmp(argv[i], "--mode") == 0 && has_arg) {
+            mode = (uint8_t)atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--case") == 0 && has_arg) {
+            case_index = (uint8_t)atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--trace") == 0 && has_arg) {
+            trace_path = argv[++i];
+        } else if (strcmp(argv[i], "--segments") == 0) {
+            show_segments = true;
+        } else if (strcmp(argv[i], "--plant") == 0 && has_arg) {
+            if (!parse_plant(argv[++i])) {
+                fprintf(stderr, "invalid --plant\n");
+                return 2;
+            }
+        } else if (strcmp(argv[i], "--max-ms") == 0 && has_arg) {
+            s_max_ms = (uint32_t)strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--verbose-fw") == 0) {
+            verbose_fw = true;
+        } else if (strcmp(argv[i], "--batch") == 0 && has_arg) {
+            batch_dir = argv[++i];
+        } else if (strcmp(argv[i], "--modes") == 0 && has_arg) {
+            mode_count = parse_list(argv[++i], modes, 8U, 2U, 7U);
+        } else if (strcmp(argv[i], "--cases") == 0 && has_arg) {
+            case_count = parse_list(argv[++i], cases, 9U, 1U, 9U);
+        } else if (strcmp(argv[i], "--golden") == 0 && has_arg) {
+            golden_path = argv[++i];
+        } else if (strcmp(argv[i], "--update-golden") == 0) {
+            update_golden = true;
+        } else if (strcmp(argv[i], "--time-tolerance-ms") == 0 && has_arg) {
+            tol.time_tol_ms = (uint32_t)strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "--dist-tolerance-mm") == 0 && has_arg) {
+            tol.dist_tol_mm = strtof(argv[++i], NULL);
+        } else if (strcmp(argv[i], "--angle-tolerance-deg") == 0 && has_arg) {
+            tol.angle_tol_deg = strtof(argv[++i], NULL);
+        } else {
+            print_usage(argv[0]);
+            return 2;
+        }
+    }
+    if (mode_count == 0U || case_count == 0U) {
+        fprintf(stderr, "invalid --modes/--cases\n");
+        return 2;
+    }
+
+    if (batch_dir != NULL) {
+        return run_batch(batch_dir, modes, mode_count, cases, case_count, golden_path, update_golden, &tol);
+    }
+
+    motion_reset();
+    if (maze_file != NULL) {
+        if (!load_maze_text_file(maze_file)) {
+            return 2;
+        }
+    } else if (s_path_literal_len == 0U) {
+        fprintf(stderr, "--maze or --path is required\n");
+        print_usage(argv[0]);
+        return 2;
+    }
+    if (trace_path != NULL) {
+        trace_open(trace_path, mode, case_index);
+    }
+
+    const bool ok = run_quiet(!verbose_fw, mode, case_index);
+
+    if (s_trace_fp != NULL) {
+        fclose(s_trace_fp);
+        s_trace_fp = NULL;
+    }
+    printf("[motion] variant=%s mode=%u case=%u path=", MOTION_HOST_VARIANT, (unsigned)mode,
+           (unsigned)case_index);
+    for (uint16_t i = 0U; i < s_result.path_len; i++) {
+        printf("%s%u", (i == 0U) ? "" : ",", (unsigned)path[i]);
+    }
+    printf("\n[motion] ");
+    print_result_fields(stdout, &s_result);
+    if (s_result.failed) {
+        printf("\n[motion] failsafe_at_ms=%u", (unsigned)s_result.fail_ms);
+    }
+    printf("\n[motion] end_pose x=%.1f y=%.1f theta=%.2f travel=%.1f sim_ms=%u\n", s_result.end_x,
+           s_result.end_y, s_result.end_theta, s_result.travel, (unsigned)s_tick_ms);
+    if (show_segments) {
+        print_segments();
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,23 @@
+#!/usr/bin/env sh
+set -eu
+
+ROOT_DIR=$(CDPATH= cd -- "$(dirname -- "$0")/../.." && pwd)
+
+# --32: 32x32 コーパス（tools/solver_host/corpus32/、中央 2x2 ゴール）
+if [ "${1:-}" = "--32" ]; then
+  shift
+  CORPUS_DIR="${CORPUS_DIR:-$ROOT_DIR/tools/solver_host/corpus32}"
+  GOLDEN="${GOLDEN:-$ROOT_DIR/tools/motion_host/golden32.txt}"
+  MOTION_HOST_CFLAGS="${MOTION_HOST_CFLAGS:--DGOAL1_X=15 -DGOAL1_Y=15 -DGOAL2_X=16 -DGOAL2_Y=15 -DGOAL3_X=15 -DGOAL3_Y=16 -DGOAL4_X=16 -DGOAL4_Y=16 -DGOAL5_X=0 -DGOAL5_Y=0 -DGOAL6_X=0 -DGOAL6_Y=0 -DGOAL7_X=0 -DGOAL7_Y=0 -DGOAL8_X=0 -DGOAL8_Y=0 -DGOAL9_X=0 -DGOAL9_Y=0}"
+fi
+# solver_host と同じ迷路コーパスを使う（中央 2x2 ゴール、機体パラメータの追加ゴールは無効化）
+CORPUS_DIR="${CORPUS_DIR:-$ROOT_DIR/tools/solver_host/corpus}"
+GOLDEN="${GOLDEN:-$ROOT_DIR/tools/motion_host/golden.txt}"
+MOTION_HOST_CFLAGS="${MOTION_HOST_CFLAGS:--DGOAL1_X=7 -DGOAL1_Y=7 -DGOAL2_X=8 -DGOAL2_Y=7 -DGOAL3_X=7 -DGOAL3_Y=8 -DGOAL4_X=8 -DGOAL4_Y=8 -DGOAL5_X=0 -DGOAL5_Y=0 -DGOAL6_X=0 -DGOAL6_Y=0 -DGOAL7_X=0 -DGOAL7_Y=0 -DGOAL8_X=0 -DGOAL8_Y=0 -DGOAL9_X=0 -DGOAL9_Y=0}"
+export MOTION_HOST_CFLAGS
+
+if [ "${1:-}" = "--update" ]; then
+  shift
+  exec "$ROOT_DIR/tools/motion_host/run_motion_host.sh" --batch "$CORPUS_DIR" --golden "$GOLDEN" --update-golden "$@"
+fi
+exec "$ROOT_DIR/tools/motion_host/run_motion_host.sh" --batch "$CORPUS_DIR" --golden "$GOLDEN" "$@"
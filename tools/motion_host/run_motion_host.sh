@@ -0,0 +1,69 @@
+#!/usr/bin/env sh
+set -eu
+
+ROOT_DIR=$(CDPATH= cd -- "$(dirname -- "$0")/../.." && pwd)
+OUT_DIR="$ROOT_DIR/build/motion_host"
+OUT_BIN="$OUT_DIR/motion_host"
+
+# 機体バリアント（params/<variant>）。ROBOT_* は CMakeLists.txt の nightfall_add_firmware() と同じ
+MOTION_HOST_VARIANT="${MOTION_HOST_VARIANT:-mini_r1_0}"
+case "$MOTION_HOST_VARIANT" in
+  mini_r1_0) VARIANT_DEFINE=ROBOT_MINI_R1_0 ;;
+  classic_r1_0) VARIANT_DEFINE=ROBOT_CLASSIC_R1_0 ;;
+  *) echo "unknown MOTION_HOST_VARIANT: $MOTION_HOST_VARIANT" >&2; exit 2 ;;
+esac
+
+F405="$ROOT_DIR/platform/stm32f405"
+CFLAGS="-std=gnu11 -O2 -Wall
+  -DUSE_HAL_DRIVER -DSTM32F405xx -D$VARIANT_DEFINE -DMOTION_HOST_VARIANT=\"$MOTION_HOST_VARIANT\"
+  ${MOTION_HOST_CFLAGS:-}
+  -include $ROOT_DIR/tools/motion_host/include/motion_host_hw.h
+  -I$ROOT_DIR/tools/motion_host/include
+  -I$F405/Core/Inc
+  -isystem $F405/Drivers/STM32F4xx_HAL_Driver/Inc
+  -isystem $F405/Drivers/CMSIS/Device/ST/STM32F4xx/Include
+  -isystem $F405/Drivers/CMSIS/Include
+  -I$ROOT_DIR/params/$MOTION_HOST_VARIANT
+  -I$ROOT_DIR/nvm
+  -I$ROOT_DIR/platform/trace
+  -I$ROOT_DIR/platform/imu
+  -I$ROOT_DIR/platform/prof"
+# ファームのソースは未使用の引数・変数が多いため、その警告だけ止める（motion_host.c は -Wextra まで見る）
+FW_CFLAGS="$CFLAGS -Wno-unused-parameter -Wno-unused-variable -Wno-unused-but-set-variable"
+HOST_CFLAGS="$CFLAGS -Wextra"
+
+# run() が呼ぶ走行プリミティブを区間記録でラップする
+WRAPS="solver_build_path first_sectionA half_sectionD run_straight driveC_wallend
+  turn_R90 turn_L90 l_turn_R90 l_turn_L90 l_turn_R180 l_turn_L180
+  turn_R45_In turn_L45_In turn_R45_Out turn_L45_Out turn_RV90 turn_LV90
+  turn_R135_In turn_L135_In turn_R135_Out turn_L135_Out run_diagonal"
+LDFLAGS=""
+for fn in $WRAPS; do
+  LDFLAGS="$LDFLAGS -Wl,--wrap=$fn"
+done
+
+mkdir -p "$OUT_DIR"
+# tim1_wait_us() は TIM1 のカウンタを空回しで待つため、シミュレータ側の実装に差し替える
+# shellcheck disable=SC2086
+cc $FW_CFLAGS -Dtim1_wait_us=interrupt_tim1_wait_us_unused -c "$F405/Core/Src/interrupt.c" -o "$OUT_DIR/interrupt.o"
+# shellcheck disable=SC2086
+cc $HOST_CFLAGS -c "$ROOT_DIR/tools/motion_host/motion_host.c" -o "$OUT_DIR/motion_host.o"
+# shellcheck disable=SC2086
+cc $FW_CFLAGS \
+  "$OUT_DIR/motion_host.o" \
+  "$OUT_DIR/interrupt.o" \
+  "$F405/Core/Src/drive.c" \
+  "$F405/Core/Src/control.c" \
+  "$F405/Core/Src/run.c" \
+  "$F405/Core/Src/turn_profile.c" \
+  "$F405/Core/Src/straight_profile.c" \
+  "$F405/Core/Src/solver.c" \
+  "$F405/Core/Src/path.c" \
+  "$F405/Core/Src/path_speed_plan.c" \
+  "$F405/Core/Src/maze_bitboard.c" \
+  "$F405/Core/Src/maze_grid.c" \
+  "$F405/Core/Src/step_map.c" \
+  "$F405/Core/Src/solver_params.c" \
+  "$ROOT_DIR/params/$MOTION_HOST_VARIANT/shortest_run_params_split.c" \
+  $LDFLAGS -lm -o "$OUT_BIN"
+"$OUT_BIN" "$@"
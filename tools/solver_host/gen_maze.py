@@ -0,0 +1,116 @@
+#!/usr/bin/env python3
+"""solver_host 用のランダム迷路（.maze テキスト形式）を生成する。
+
+穴掘り法（深さ優先）で全区画をつないだあと、内部の壁を一定割合だけ抜いてループを作る。
+中央 2x2 のゴール区画は内部の壁を抜き、スタート区画 (0,0) は東壁ありにする。
+同じ --seed からは同じ迷路を出力する（コーパスの再生成用）。
+"""
+import argparse
+import random
+import sys
+
+NORTH = 0x08
+EAST = 0x04
+SOUTH = 0x02
+WEST = 0x01
+DELTA = {NORTH: (0, 1), EAST: (1, 0), SOUTH: (0, -1), WEST: (-1, 0)}
+OPPOSITE = {NORTH: SOUTH, EAST: WEST, SOUTH: NORTH, WEST: EAST}
+
+
+def open_wall(walls, x, y, d):
+    dx, dy = DELTA[d]
+    walls[y][x] &= ~d
+    walls[y + dy][x + dx] &= ~OPPOSITE[d]
+
+
+def close_wall(walls, size, x, y, d):
+    dx, dy = DELTA[d]
+    walls[y][x] |= d
+    nx, ny = x + dx, y + dy
+    if 0 <= nx < size and 0 <= ny < size:
+        walls[ny][nx] |= OPPOSITE[d]
+
+
+def generate(size, seed, loops, empty):
+    rng = random.Random(seed)
+    full = NORTH | EAST | SOUTH | WEST
+    walls = [[0 if empty else full for _ in range(size)] for _ in range(size)]
+    for i in range(size):
+        walls[0][i] |= SOUTH
+        walls[size - 1][i] |= NORTH
+        walls[i][0] |= WEST
+        walls[i][size - 1] |= EAST
+
+    if not empty:
+        # スタート区画は東壁ありなので北へだけ掘り、(0,1) から掘り進める
+        seen = [[False] * size for _ in range(size)]
+        seen[0][0] = True
+        seen[1][0] = True
+        open_wall(walls, 0, 0, NORTH)
+        stack = [(0, 1)]
+        while stack:
+            x, y = stack[-1]
+            nexts = []
+            for d, (dx, dy) in DELTA.items():
+                nx, ny = x + dx, y + dy
+                if 0 <= nx < size and 0 <= ny < size and not seen[ny][nx]:
+                    nexts.append(d)
+            if not nexts:
+                stack.pop()
+                continue
+            d = rng.choice(nexts)
+            dx, dy = DELTA[d]
+            open_wall(walls, x, y, d)
+            seen[y + dy][x + dx] = True
+            stack.append((x + dx, y + dy))
+
+        inner = []
+        for y in range(size):
+            for x in range(size):
+                if x + 1 < size and walls[y][x] & EAST:
+                    inner.append((x, y, EAST))
+                if y + 1 < size and walls[y][x] & NORTH:
+                    inner.append((x, y, NORTH))
+        for x, y, d in rng.sample(inner, int(len(inner) * loops)):
+            open_wall(walls, x, y, d)
+
+    c = size // 2 - 1
+    open_wall(walls, c, c, EAST)
+    open_wall(walls, c, c + 1, EAST)
+    open_wall(walls, c, c, NORTH)
+    open_wall(walls, c + 1, c, NORTH)
+    close_wall(walls, size, 0, 0, EAST)
+    return walls
+
+
+def render(walls, size):
+    lines = []
+    for y in range(size - 1, -1, -1):
+        top = "+"
+        mid = ""
+        for x in range(size):
+            top += ("---" if walls[y][x] & NORTH else "   ") + "+"
+            mid += ("|" if walls[y][x] & WEST else " ") + "   "
+        mid += "|" if walls[y][size - 1] & EAST else " "
+        lines.append(top)
+        lines.append(mid)
+    lines.append("+" + "---+" * size)
+    return "\n".join(lines) + "\n"
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    ap.add_argument("--size", type=int, default=16)
+    ap.add_argument("--seed", type=int, default=0)
+    ap.add_argument("--loops", type=float, default=0.08, help="抜く内部壁の割合（0..1）")
+    ap.add_argument("--empty", action="store_true", help="外周とスタート東壁だけの迷路（ソルバの最悪ケース）")
+    args = ap.parse_args()
+    if args.size < 4 or args.size % 2 != 0:
+        print("size must be an even number >= 4", file=sys.stderr)
+        return 2
+    sys.stdout.write(render(generate(args.size, args.seed, args.loops, args.empty), args.size))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
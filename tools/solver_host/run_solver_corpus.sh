@@ -0,0 +1,43 @@
+#!/usr/bin/env sh
+set -eu
+
+ROOT_DIR=$(CDPATH= cd -- "$(dirname -- "$0")/../.." && pwd)
+
+# --32: 32x32 コーパス（corpus32/、MAZE_SIZE=32 でビルド）
+if [ "${1:-}" = "--32" ]; then
+  shift
+  CORPUS_DIR="${CORPUS_DIR:-$ROOT_DIR/tools/solver_host/corpus32}"
+  SOLVER_HOST_CFLAGS="${SOLVER_HOST_CFLAGS:--DMAZE_SIZE=32 -DGOAL1_X=15 -DGOAL1_Y=15 -DGOAL2_X=16 -DGOAL2_Y=15 -DGOAL3_X=15 -DGOAL3_Y=16 -DGOAL4_X=16 -DGOAL4_Y=16}"
+fi
+CORPUS_DIR="${CORPUS_DIR:-$ROOT_DIR/tools/solver_host/corpus}"
+GOLDEN="${GOLDEN:-$CORPUS_DIR/golden.txt}"
+
+# コーパスの迷路は中央 2x2 ゴール（ゴールデンはこのゴール設定で作成する）
+SOLVER_HOST_CFLAGS="${SOLVER_HOST_CFLAGS:--DGOAL1_X=7 -DGOAL1_Y=7 -DGOAL2_X=8 -DGOAL2_Y=7 -DGOAL3_X=7 -DGOAL3_Y=8 -DGOAL4_X=8 -DGOAL4_Y=8}"
+export SOLVER_HOST_CFLAGS
+
+if [ "${1:-}" = "--update" ]; then
+  shift
+  exec "$ROOT_DIR/tools/solver_host/run_solver_host.sh" --batch "$CORPUS_DIR" --golden "$GOLDEN" --update-golden "$@"
+fi
+if [ "${1:-}" = "--profile-compare" ]; then
+  shift
+  exec "$ROOT_DIR/tools/solver_host/run_solver_host.sh" --profile-compare "$CORPUS_DIR" "$@"
+fi
+if [ "${1:-}" = "--bg-replan-check" ]; then
+  shift
+  exec "$ROOT_DIR/tools/solver_host/run_solver_host.sh" --bg-replan-check "$CORPUS_DIR" "$@"
+fi
+if [ "${1:-}" = "--explore-full" ]; then
+  shift
+  exec "$ROOT_DIR/tools/solver_host/run_solver_host.sh" --explore-full "$CORPUS_DIR" "$@"
+fi
+if [ "${1:-}" = "--path-compile-check" ]; then
+  shift
+  exec "$ROOT_DIR/tools/solver_host/run_solver_host.sh" --path-compile-check "$CORPUS_DIR" "$@"
+fi
+if [ "${1:-}" = "--step-report" ]; then
+  shift
+  exec "$ROOT_DIR/tools/solver_host/run_solver_host.sh" --step-report "$CORPUS_DIR" "$@"
+fi
+exec "$ROOT_DIR/tools/solver_host/run_solver_host.sh" --batch "$CORPUS_DIR" --golden "$GOLDEN" "$@"
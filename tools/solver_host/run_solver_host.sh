@@ -6,14 +6,23 @@ OUT_DIR="$ROOT_DIR/build/solver_host"
 OUT_BIN="$OUT_DIR/solver_host"
 
 mkdir -p "$OUT_DIR"
-cc -std=c11 -Wall -Wextra -Wpedantic -Wno-strict-prototypes \
+cc -std=c11 -O2 -Wall -Wextra -Wpedantic -Wno-strict-prototypes \
+  -DSOLVER_ENABLE_LEGACY_SCAN=1 -DPATH_ENABLE_LEGACY_PASSES=1 -DSOLVER_TIME_TURN_OMEGA_CAP=2200.0f ${SOLVER_HOST_CFLAGS:-} \
   -I"$ROOT_DIR/tools/solver_host/include" \
   -I"$ROOT_DIR/platform/stm32f405/Core/Inc" \
   -I"$ROOT_DIR/params/f413_preorder" \
   "$ROOT_DIR/tools/solver_host/solver_host.c" \
   "$ROOT_DIR/platform/stm32f405/Core/Src/solver.c" \
   "$ROOT_DIR/platform/stm32f405/Core/Src/path.c" \
+  "$ROOT_DIR/platform/stm32f405/Core/Src/path_speed_plan.c" \
+  "$ROOT_DIR/platform/stm32f405/Core/Src/maze_bitboard.c" \
   "$ROOT_DIR/platform/stm32f405/Core/Src/maze_grid.c" \
+  "$ROOT_DIR/platform/stm32f405/Core/Src/step_map.c" \
+  "$ROOT_DIR/platform/stm32f405/Core/Src/search_route.c" \
+  "$ROOT_DIR/platform/stm32f405/Core/Src/search_target.c" \
+  "$ROOT_DIR/params/f413_preorder/search_run_params_split.c" \
+  "$ROOT_DIR/platform/stm32f405/Core/Src/turn_profile.c" \
+  "$ROOT_DIR/platform/stm32f405/Core/Src/straight_profile.c" \
   "$ROOT_DIR/platform/stm32f405/Core/Src/solver_params.c" \
   "$ROOT_DIR/params/f413_preorder/shortest_run_params_split.c" \
   -lm -o "$OUT_BIN"
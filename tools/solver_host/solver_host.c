@@ -1,14 +1,27 @@
+#define _POSIX_C_SOURCE 200809L
 #define MAIN_C_
 #include "global.h"
 
+#include "maze_bitboard.h"
 #include "maze_grid.h"
+#include "path_speed_plan.h"
 #include "solver.h"
+#include "search_route.h"
+#include "search_run_params.h"
+#include "search_target.h"
+#include "solver_params.h"
+#include "shortest_run_params.h"
+#include "step_map.h"
+#include "straight_profile.h"
+#include "turn_profile.h"
 
 #include <ctype.h>
+#include <dirent.h>
 #include <errno.h>
 #include <fcntl.h>
 #include <math.h>
 #include <string.h>
+#include <time.h>
 #include <unistd.h>
 
 static uint8_t s_walls_bl[MAZE_SIZE][MAZE_SIZE];
@@ -21,6 +34,18 @@ typedef struct {
     uint8_t dir;
 } SimMouse;
 
+static double host_now_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e6 + (double)ts.tv_nsec / 1e3;
+}
+
+static uint32_t host_clock_us(void)
+{
+    return (uint32_t)(uint64_t)host_now_us();
+}
+
 static void clear_sample_area(unsigned int width, unsigned int height)
 {
     for (unsigned int y = 0U; y < MAZE_SIZE; y++) {
@@ -384,8 +409,15 @@ static bool load_maze_text_file(const char *path_name)
     return true;
 }
 
+// true の間は load_map_from_eeprom() が map[][] を書き換えない
+// （--explore-full で探索後の地図を解く。実機で探索後に保存した地図を読み戻すのと同じ）
+static bool s_keep_search_map = false;
+
 void load_map_from_eeprom(void)
 {
+    if (s_keep_search_map) {
+        return;
+    }
     memset(map, 0, sizeof(map));
     for (unsigned int y = 0U; y < MAZE_SIZE; y++) {
         for (unsigned int x = 0U; x < MAZE_SIZE; x++) {
@@ -419,6 +451,10 @@ static bool sim_is_goal(uint8_t x, uint8_t y)
     return false;
 }
 
+// map[][] の下位4bit の行ビットボード。F413 の探索ステップと同じく初期化で全面を作り、
+// 壁を書いた区画だけ maze_bitboard_update_cell() で更新する（--explore-smap-check で全面作成と比較）
+static maze_bitboard_t s_sim_map_bb;
+
 static void sim_init_search_map(void)
 {
     for (uint8_t y = 0U; y < MAZE_SIZE; y++) {
@@ -440,6 +476,7 @@ static void sim_init_search_map(void)
         map[START_Y][START_X - 1U] |= 0x44U;
     }
     visited[START_Y][START_X] = true;
+    maze_bitboard_build(&s_sim_map_bb, map, 0U);
 }
 
 static uint16_t sim_relative_wall_info(uint8_t x, uint8_t y, uint8_t dir)
@@ -506,6 +543,14 @@ static void sim_write_map_cell(uint8_t x, uint8_t y, uint8_t dir, uint16_t relat
     if ((START_X + 1U) < MAZE_SIZE) {
         map[START_Y][START_X + 1U] |= 0x11U;
     }
+
+    maze_bitboard_update_cell(&s_sim_map_bb, map, 0U, x, y);
+    maze_bitboard_update_cell(&s_sim_map_bb, map, 0U, x, (uint8_t)(y + 1U));
+    maze_bitboard_update_cell(&s_sim_map_bb, map, 0U, (uint8_t)(x + 1U), y);
+    maze_bitboard_update_cell(&s_sim_map_bb, map, 0U, x, (uint8_t)(y - 1U));
+    maze_bitboard_update_cell(&s_sim_map_bb, map, 0U, (uint8_t)(x - 1U), y);
+    maze_bitboard_update_cell(&s_sim_map_bb, map, 0U, START_X, START_Y);
+    maze_bitboard_update_cell(&s_sim_map_bb, map, 0U, START_X + 1U, START_Y);
 }
 
 static int sim_make_goal_smap(const SimMouse *m)
@@ -563,6 +608,256 @@ static int sim_make_goal_smap(const SimMouse *m)
     return (smap[m->y][m->x] == 0xFFFFU) ? -1 : (int)smap[m->y][m->x];
 }
 
+// ---- 差分更新歩数マップ（step_map.c）の検証 ----
+// 往路(GOAL)・復路(START)・全面探索(UNVISITED)の3種の起点それぞれについて、
+// 毎ステップ step_map_update() の結果を全区画 BFS と比較する。
+#define SMAP_CHECK_TARGET_NUM 3
+// 1ステップの所要時間は同じ状態から繰り返した最小値（割り込み・キャッシュの外れ値を除く）
+#define SMAP_CHECK_REPEAT 5
+
+typedef struct {
+    double inc_us_sum;
+    double inc_us_max;
+    double bfs_us_sum;
+    double bfs_us_max;
+    double bb_us_sum;   // maze_bitboard の全区画展開
+    double bb_us_max;
+    double rebuild_us_max; // step_map の全面再構築（同じ状態から無効化して更新）
+    double repair_us_max;  // 差分修復そのもの（打ち切ったステップは全面再構築の分を除く）
+    unsigned int bb_mismatches;
+    unsigned long work_sum;
+    unsigned int work_max;
+    unsigned int rebuilds;
+    unsigned int aborts;
+    unsigned int mismatches;
+} SmapCheckStat;
+
+static const char *const s_smap_target_name[SMAP_CHECK_TARGET_NUM] = {"goal", "start", "full"};
+static step_map_t s_smap_inc[SMAP_CHECK_TARGET_NUM];
+static uint16_t s_smap_inc_dist[SMAP_CHECK_TARGET_NUM][MAZE_SIZE][MAZE_SIZE];
+static uint16_t s_smap_ref_dist[MAZE_SIZE][MAZE_SIZE];
+static uint16_t s_smap_bb_dist[MAZE_SIZE][MAZE_SIZE];
+static maze_bitboard_t s_smap_bb;
+static step_map_t s_smap_saved;
+static uint16_t s_smap_saved_dist[MAZE_SIZE][MAZE_SIZE];
+static SmapCheckStat s_smap_stat[SMAP_CHECK_TARGET_NUM];
+
+static bool sim_smap_is_seed(step_map_target_t target, uint8_t x, uint8_t y)
+{
+    switch (target) {
+    case STEP_MAP_TARGET_START:
+        return x == START_X && y == START_Y;
+    case STEP_MAP_TARGET_UNVISITED:
+        return !visited[y][x] && !(x == START_X && y == START_Y);
+    default:
+        return sim_is_goal(x, y);
+    }
+}
+
+static void sim_smap_seed_mask(step_map_target_t target, maze_row_t seed[MAZE_SIZE])
+{
+    for (uint8_t y = 0U; y < MAZE_SIZE; y++) {
+        seed[y] = 0U;
+        for (uint8_t x = 0U; x < MAZE_SIZE; x++) {
+            if (sim_smap_is_seed(target, x, y)) {
+                maze_bitboard_seed_set(seed, x, y);
+            }
+        }
+    }
+}
+
+// 参照: 起点から全区画まで BFS（make_smap の早期終了なし版）
+static void sim_full_bfs(step_map_target_t target, uint16_t out[MAZE_SIZE][MAZE_SIZE])
+{
+    static const int8_t dx[4] = {0, 1, 0, -1};
+    static const int8_t dy[4] = {1, 0, -1, 0};
+    static const uint8_t wall_bit[4] = {NORTH_WALL, EAST_WALL, SOUTH_WALL, WEST_WALL};
+    uint16_t q[MAZE_SIZE * MAZE_SIZE];
+    uint16_t head = 0U;
+    uint16_t tail = 0U;
+
+    for (uint8_t y = 0U; y < MAZE_SIZE; y++) {
+        for (uint8_t x = 0U; x < MAZE_SIZE; x++) {
+            out[y][x] = 0xFFFFU;
+            if (sim_smap_is_seed(target, x, y)) {
+                out[y][x] = 0U;
+                q[tail++] = (uint16_t)(y * MAZE_SIZE + x);
+            }
+        }
+    }
+    while (head < tail) {
+        uint16_t idx = q[head++];
+        uint8_t cy = (uint8_t)(idx / MAZE_SIZE);
+        uint8_t cx = (uint8_t)(idx % MAZE_SIZE);
+        uint8_t cell = (uint8_t)(map[cy][cx] & 0x0FU);
+
+        for (unsigned int d = 0U; d < 4U; d++) {
+            int nx = (int)cx + dx[d];
+            int ny = (int)cy + dy[d];
+            if ((cell & wall_bit[d]) != 0U) {
+                continue;
+            }
+            if (nx < 0 || ny < 0 || nx >= (int)MAZE_SIZE || ny >= (int)MAZE_SIZE) {
+                continue;
+            }
+            if (out[ny][nx] == 0xFFFFU) {
+                out[ny][nx] = (uint16_t)(out[cy][cx] + 1U);
+                q[tail++] = (uint16_t)(ny * MAZE_SIZE + nx);
+            }
+        }
+    }
+}
+
+static void sim_smap_check_init(void)
+{
+    for (unsigned int t = 0U; t < SMAP_CHECK_TARGET_NUM; t++) {
+        step_map_bind(&s_smap_inc[t], s_smap_inc_dist[t]);
+        memset(&s_smap_stat[t], 0, sizeof(s_smap_stat[t]));
+    }
+}
+
+// write_map()/markVisited() が search.c で通知するのと同じ区画を通知する
+static void sim_smap_check_touch(uint8_t x, uint8_t y)
+{
+    for (unsigned int t = 0U; t < SMAP_CHECK_TARGET_NUM; t++) {
+        step_map_t *sm = &s_smap_inc[t];
+        step_map_touch(sm, x, y);
+        step_map_touch(sm, x, (uint8_t)(y + 1U));
+        step_map_touch(sm, (uint8_t)(x + 1U), y);
+        step_map_touch(sm, x, (uint8_t)(y - 1U));
+        step_map_touch(sm, (uint8_t)(x - 1U), y);
+        step_map_touch(sm, START_X, START_Y);
+        step_map_touch(sm, START_X + 1U, START_Y);
+    }
+}
+
+static bool sim_smap_check_step(unsigned int step, const SimMouse *m, bool verbose)
+{
+    bool ok = true;
+
+    for (unsigned int t = 0U; t < SMAP_CHECK_TARGET_NUM; t++) {
+        step_map_target_t target = (step_map_target_t)t;
+        SmapCheckStat *st = &s_smap_stat[t];
+        step_map_t *sm = &s_smap_inc[t];
+        const uint16_t aborts = sm->aborts;
+        double inc_us = 0.0;
+        double rebuild_us = 0.0;
+        double bb_us = 0.0;
+        bool incremental = false;
+
+        // 差分更新は状態を持つので、更新前の状態へ戻しながら繰り返す
+        s_smap_saved = *sm;
+        memcpy(s_smap_saved_dist, s_smap_inc_dist[t], sizeof(s_smap_saved_dist));
+        for (unsigned int k = 0U; k < SMAP_CHECK_REPEAT; k++) {
+            if (k > 0U) {
+                *sm = s_smap_saved;
+                memcpy(s_smap_inc_dist[t], s_smap_saved_dist, sizeof(s_smap_saved_dist));
+            }
+            double t0 = host_now_us();
+            incremental = step_map_update(sm, map, visited, target, false);
+            double t1 = host_now_us();
+            if (k == 0U || (t1 - t0) < inc_us) inc_us = t1 - t0;
+        }
+        // 同じ状態からの全面再構築（打ち切り時の行き先）の所要時間
+        for (unsigned int k = 0U; k < SMAP_CHECK_REPEAT; k++) {
+            step_map_t *tmp = &s_smap_saved;
+            double t0;
+            double t1;
+            tmp->dist = s_smap_saved_dist;
+            step_map_invalidate(tmp);
+            t0 = host_now_us();
+            (void)step_map_update(tmp, map, visited, target, false);
+            t1 = host_now_us();
+            if (k == 0U || (t1 - t0) < rebuild_us) rebuild_us = t1 - t0;
+        }
+        double t1 = host_now_us();
+        sim_full_bfs(target, s_smap_ref_dist);
+        double t2 = host_now_us();
+        for (unsigned int k = 0U; k < SMAP_CHECK_REPEAT; k++) {
+            double t3 = host_now_us();
+            maze_row_t seed[MAZE_SIZE];
+            sim_smap_seed_mask(target, seed);
+            maze_bitboard_build(&s_smap_bb, map, 0U);
+            (void)maze_bitboard_flood(&s_smap_bb, seed, s_smap_bb_dist, MAZE_BITBOARD_NO_TARGET, 0U);
+            double t4 = host_now_us();
+            if (k == 0U || (t4 - t3) < bb_us) bb_us = t4 - t3;
+        }
+        unsigned int work = sm->work;
+
+        if (sm->aborts != aborts) st->aborts++;
+        if (rebuild_us > st->rebuild_us_max) st->rebuild_us_max = rebuild_us;
+        if (incremental || sm->aborts != aborts) {
+            // 打ち切ったステップは同じ状態からの全面再構築を引いた残りが修復に使った時間
+            double repair_us = incremental ? inc_us : (inc_us - rebuild_us);
+            if (repair_us > st->repair_us_max) st->repair_us_max = repair_us;
+        }
+        st->bb_us_sum += bb_us;
+        if (bb_us > st->bb_us_max) st->bb_us_max = bb_us;
+        if (memcmp(s_smap_bb_dist, s_smap_ref_dist, sizeof(s_smap_ref_dist)) != 0) {
+            st->bb_mismatches++;
+            ok = false;
+            printf("[explore-smap] bitboard mismatch step=%u target=%s\n", step,
+                   s_smap_target_name[t]);
+        }
+
+        st->inc_us_sum += inc_us;
+        st->bfs_us_sum += t2 - t1;
+        if (inc_us > st->inc_us_max) st->inc_us_max = inc_us;
+        if ((t2 - t1) > st->bfs_us_max) st->bfs_us_max = t2 - t1;
+        st->work_sum += work;
+        if (work > st->work_max) st->work_max = work;
+        if (!incremental) st->rebuilds++;
+
+        if (memcmp(s_smap_inc_dist[t], s_smap_ref_dist, sizeof(s_smap_ref_dist)) != 0) {
+            st->mismatches++;
+            ok = false;
+            for (uint8_t y = 0U; y < MAZE_SIZE; y++) {
+                for (uint8_t x = 0U; x < MAZE_SIZE; x++) {
+                    if (s_smap_inc_dist[t][y][x] != s_smap_ref_dist[y][x]) {
+                        printf("[explore-smap] mismatch step=%u target=%s cell=(%u,%u) inc=%u bfs=%u\n",
+                               step, s_smap_target_name[t], (unsigned int)x, (unsigned int)y,
+                               (unsigned int)s_smap_inc_dist[t][y][x],
+                               (unsigned int)s_smap_ref_dist[y][x]);
+                        break;
+                    }
+                }
+            }
+        }
+        if (verbose) {
+            printf("[explore-smap] step=%u pos=(%u,%u) target=%s mode=%s work=%u inc_us=%.3f bfs_us=%.3f bb_us=%.3f\n",
+                   step, (unsigned int)m->x, (unsigned int)m->y, s_smap_target_name[t],
+                   incremental ? "repair" : "rebuild", work, inc_us, t2 - t1, bb_us);
+        }
+    }
+    return ok;
+}
+
+// 差分修復の最大所要時間が全面展開（make_smap() と同じ行ビットボードの波面展開）の最大を超えないこと。
+// 修復は STEP_MAP_WORK_CAP で打ち切って全面再構築するため、1ステップの最悪は全面再構築 + 打ち切りまでの修復。
+// 超えたら false
+static bool sim_smap_check_report(unsigned int steps)
+{
+    bool ok = true;
+
+    if (steps == 0U) {
+        return true;
+    }
+    for (unsigned int t = 0U; t < SMAP_CHECK_TARGET_NUM; t++) {
+        const SmapCheckStat *st = &s_smap_stat[t];
+        const bool cost_ok = st->repair_us_max <= st->bb_us_max;
+        printf("[explore-smap] target=%s steps=%u rebuilds=%u aborts=%u mismatches=%u bb_mismatches=%u "
+               "avg_work=%.1f max_work=%u cells=%u avg_inc_us=%.3f max_inc_us=%.3f "
+               "avg_bfs_us=%.3f max_bfs_us=%.3f avg_bb_us=%.3f max_bb_us=%.3f max_repair_us=%.3f max_rebuild_us=%.3f cost=%s\n",
+               s_smap_target_name[t], steps, st->rebuilds, st->aborts, st->mismatches, st->bb_mismatches,
+               (double)st->work_sum / (double)steps, st->work_max,
+               (unsigned int)(MAZE_SIZE * MAZE_SIZE), st->inc_us_sum / (double)steps,
+               st->inc_us_max, st->bfs_us_sum / (double)steps, st->bfs_us_max,
+               st->bb_us_sum / (double)steps, st->bb_us_max, st->repair_us_max, st->rebuild_us_max, cost_ok ? "ok" : "over");
+        ok = ok && cost_ok;
+    }
+    return ok;
+}
+
 static bool sim_next_move(const SimMouse *m, uint8_t *out_rel)
 {
     static const uint8_t rel_priority[4] = {0U, 1U, 3U, 2U};
@@ -591,6 +886,52 @@ static bool sim_next_move(const SimMouse *m, uint8_t *out_rel)
     return false;
 }
 
+// 早期終了つきの波面展開（F413 の探索ステップと同じ呼び方）を、現在の smap[][]
+// （sim_make_goal_smap() のキュー BFS）と比較する。キュー BFS は現在地を書いた時点で止まるため、
+// 現在地と同じ歩数の区画はキュー BFS 側で未記入のことがある。それ以外の区画・歩数・次の進行方向は一致すること。
+// 展開には壁の書き込みで更新してきた s_sim_map_bb を使い、map[][] から作り直したものと一致することも確かめる。
+static bool sim_smap_check_early_exit(unsigned int step, const SimMouse *m, int bfs_step,
+                                      uint8_t bfs_rel)
+{
+    static uint16_t bfs_dist[MAZE_SIZE][MAZE_SIZE];
+    maze_row_t seed[MAZE_SIZE];
+    uint16_t bb_step;
+    uint8_t bb_rel = 0xFFU;
+    bool ok = true;
+
+    memcpy(bfs_dist, smap, sizeof(bfs_dist));
+    sim_smap_seed_mask(STEP_MAP_TARGET_GOAL, seed);
+    maze_bitboard_build(&s_smap_bb, map, 0U);
+    if (memcmp(&s_smap_bb, &s_sim_map_bb, sizeof(s_smap_bb)) != 0) {
+        printf("[explore-smap] bitboard incremental update mismatch step=%u\n", step);
+        ok = false;
+    }
+    bb_step = maze_bitboard_flood(&s_sim_map_bb, seed, smap, m->x, m->y);
+    if ((int)bb_step != bfs_step) {
+        ok = false;
+    }
+    for (uint8_t y = 0U; y < MAZE_SIZE && ok; y++) {
+        for (uint8_t x = 0U; x < MAZE_SIZE; x++) {
+            uint16_t b = bfs_dist[y][x];
+            uint16_t w = smap[y][x];
+            bool same_level_fill = (b == 0xFFFFU) && (w == bb_step);
+            if (b != w && !same_level_fill) {
+                ok = false;
+                break;
+            }
+        }
+    }
+    if (ok && (!sim_next_move(m, &bb_rel) || bb_rel != bfs_rel)) {
+        ok = false;
+    }
+    if (!ok) {
+        printf("[explore-smap] bitboard early-exit mismatch step=%u bfs_step=%d bb_step=%u bfs_rel=%u bb_rel=%u\n",
+               step, bfs_step, (unsigned int)bb_step, (unsigned int)bfs_rel, (unsigned int)bb_rel);
+    }
+    memcpy(smap, bfs_dist, sizeof(bfs_dist));
+    return ok;
+}
+
 static bool sim_apply_move(SimMouse *m, uint8_t rel)
 {
     static const int8_t dx[4] = {0, 1, 0, -1};
@@ -615,12 +956,167 @@ static bool sim_apply_move(SimMouse *m, uint8_t rel)
     return true;
 }
 
-static bool run_explore_sim(unsigned int max_steps, bool verbose)
+// ---- 背景再計算（search.c の arm_background_replan()/conf_route()）の検証 ----
+// 移動を始める前に、次区画の壁を書く前の map[][] で次区画起点の歩数マップと経路を作っておき、
+// 到着して壁を書いたあとの同期計算（全区画 BFS + search_route_build）と比べる。
+// search_route_can_commit() が true の区画では経路全体が一致すること。起点は往路と全面探索。
+#define BG_CHECK_TARGET_NUM 2
+
+typedef struct {
+    unsigned int hits;       // 先行経路を採用した区画
+    unsigned int reroutes;   // 1手目が塞がれ、先行した歩数マップで経路だけ作り直した区画
+    unsigned int fallbacks;  // 同期計算に戻した区画
+    unsigned int unarmed;    // Uターン・到達不能などで先行計算しなかった区画
+    unsigned int mismatches; // 採用したのに同期計算と経路・歩数が違った区画
+} BgCheckStat;
+
+static const step_map_target_t s_bg_check_target[BG_CHECK_TARGET_NUM] = {
+    STEP_MAP_TARGET_GOAL, STEP_MAP_TARGET_UNVISITED};
+static const char *const s_bg_check_name[BG_CHECK_TARGET_NUM] = {"goal", "full"};
+static BgCheckStat s_bg_stat[BG_CHECK_TARGET_NUM];
+static bool s_bg_ready[BG_CHECK_TARGET_NUM];
+static uint16_t s_bg_route[BG_CHECK_TARGET_NUM][ROUTE_MAX_LEN];
+static search_route_walls_t s_bg_walls[BG_CHECK_TARGET_NUM];
+static uint16_t s_bg_sync_route[ROUTE_MAX_LEN];
+static uint16_t s_bg_reroute[ROUTE_MAX_LEN];
+static uint16_t s_bg_dist[BG_CHECK_TARGET_NUM][MAZE_SIZE][MAZE_SIZE];
+static SimMouse s_bg_pose;
+
+// 区画 m から相対方向 rel へ動き始めたときの先行計算（arm_background_replan + background_replan_tick）
+static void sim_bg_check_arm(const SimMouse *m, uint8_t rel)
+{
+    static const int8_t dx[4] = {0, 1, 0, -1};
+    static const int8_t dy[4] = {1, 0, -1, 0};
+    const uint8_t abs_dir = (uint8_t)((m->dir + rel) & 0x03U);
+
+    s_bg_pose.dir = abs_dir;
+    s_bg_pose.x = (uint8_t)((int)m->x + dx[abs_dir]);
+    s_bg_pose.y = (uint8_t)((int)m->y + dy[abs_dir]);
+
+    for (unsigned int t = 0U; t < BG_CHECK_TARGET_NUM; t++) {
+        const SimMouse *p = &s_bg_pose;
+        bool saved_visited;
+        uint16_t step;
+
+        s_bg_ready[t] = false;
+        if (rel == 2U || p->x >= MAZE_SIZE || p->y >= MAZE_SIZE) {
+            continue; // Uターンは先行計算しない
+        }
+        // 全面探索では次区画を先に探索済にしてから歩数マップを作る
+        saved_visited = visited[p->y][p->x];
+        if (s_bg_check_target[t] == STEP_MAP_TARGET_UNVISITED) {
+            visited[p->y][p->x] = true;
+        }
+        sim_full_bfs(s_bg_check_target[t], s_bg_dist[t]);
+        visited[p->y][p->x] = saved_visited;
+
+        step = s_bg_dist[t][p->y][p->x];
+        if (step == 0U || step == 0xFFFFU) {
+            continue;
+        }
+        (void)search_route_build(s_bg_route[t], ROUTE_MAX_LEN, s_bg_dist[t], map, 0U, p->x, p->y,
+                                 p->dir);
+        search_route_walls_save(&s_bg_walls[t], map, 0U, p->x, p->y);
+        s_bg_ready[t] = true;
+    }
+}
+
+// 区画 m に到着して壁を書いたあと（conf_route）。rel は探索シミュレーションが選んだ次の相対方向
+static bool sim_bg_check_step(unsigned int step, const SimMouse *m, uint8_t rel)
+{
+    static const uint16_t rel_opcode[4] = {0x88U, 0x44U, 0x22U, 0x11U};
+    bool ok = true;
+
+    for (unsigned int t = 0U; t < BG_CHECK_TARGET_NUM; t++) {
+        BgCheckStat *st = &s_bg_stat[t];
+        const bool ready = s_bg_ready[t];
+        const uint16_t *route;
+
+        s_bg_ready[t] = false;
+        sim_full_bfs(s_bg_check_target[t], s_smap_ref_dist);
+        if (s_smap_ref_dist[m->y][m->x] == 0U || s_smap_ref_dist[m->y][m->x] == 0xFFFFU) {
+            continue; // 起点に到着した（探索終了）
+        }
+        (void)search_route_build(s_bg_sync_route, ROUTE_MAX_LEN, s_smap_ref_dist, map, 0U, m->x,
+                                 m->y, m->dir);
+        if (s_bg_check_target[t] == STEP_MAP_TARGET_GOAL && s_bg_sync_route[0] != rel_opcode[rel]) {
+            printf("[bg-replan] route_build_mismatch step=%u pos=(%u,%u,%u) sim_rel=%u route0=0x%02X\n",
+                   step, (unsigned int)m->x, (unsigned int)m->y, (unsigned int)m->dir,
+                   (unsigned int)rel, (unsigned int)s_bg_sync_route[0]);
+            ok = false;
+        }
+
+        if (!ready) {
+            st->unarmed++;
+            continue;
+        }
+        if (m->x != s_bg_pose.x || m->y != s_bg_pose.y || m->dir != s_bg_pose.dir) {
+            printf("[bg-replan] mispredict step=%u\n", step);
+            ok = false;
+            continue;
+        }
+        if (!search_route_walls_only_added(&s_bg_walls[t], map, 0U, m->x, m->y)) {
+            st->fallbacks++;
+            continue;
+        }
+        if (search_route_first_move_open(s_bg_route[t], map, 0U, m->x, m->y, m->dir)) {
+            st->hits++;
+            route = s_bg_route[t];
+        } else {
+            // conf_route() と同じく、先行した歩数マップのまま経路だけ作り直す
+            (void)search_route_build(s_bg_reroute, ROUTE_MAX_LEN, s_bg_dist[t], map, 0U, m->x,
+                                     m->y, m->dir);
+            if (s_bg_reroute[0] == 0x00U) {
+                st->fallbacks++;
+                continue;
+            }
+            st->reroutes++;
+            route = s_bg_reroute;
+        }
+        if (memcmp(route, s_bg_sync_route, sizeof(s_bg_sync_route)) != 0 ||
+            s_bg_dist[t][m->y][m->x] != s_smap_ref_dist[m->y][m->x]) {
+            st->mismatches++;
+            printf("[bg-replan] mismatch step=%u target=%s pos=(%u,%u,%u) bg0=0x%02X sync0=0x%02X bg_step=%u sync_step=%u\n",
+                   step, s_bg_check_name[t], (unsigned int)m->x, (unsigned int)m->y,
+                   (unsigned int)m->dir, (unsigned int)route[0], (unsigned int)s_bg_sync_route[0],
+                   (unsigned int)s_bg_dist[t][m->y][m->x],
+                   (unsigned int)s_smap_ref_dist[m->y][m->x]);
+            ok = false;
+        }
+    }
+    return ok;
+}
+
+static void sim_bg_check_report(void)
+{
+    for (unsigned int t = 0U; t < BG_CHECK_TARGET_NUM; t++) {
+        const BgCheckStat *st = &s_bg_stat[t];
+        const unsigned int total = st->hits + st->reroutes + st->fallbacks + st->unarmed;
+        printf("[bg-replan] target=%s cells=%u hits=%u reroutes=%u fallbacks=%u unarmed=%u mismatches=%u hit_rate=%.1f%%\n",
+               s_bg_check_name[t], total, st->hits, st->reroutes, st->fallbacks, st->unarmed,
+               st->mismatches,
+               (total > 0U) ? (100.0 * (double)(st->hits + st->reroutes) / (double)total) : 0.0);
+    }
+}
+
+static unsigned int s_explore_steps; // 直近の run_explore_sim() でゴールまでに要したステップ数
+
+static bool run_explore_sim(unsigned int max_steps, bool verbose, bool smap_check, bool bg_check)
 {
     SimMouse m = {START_X, START_Y, 0U};
     unsigned int newly_visited = 0U;
+    unsigned int checked_steps = 0U;
+    bool smap_ok = true;
+    bool bg_ok = true;
 
     sim_init_search_map();
+    if (smap_check) {
+        sim_smap_check_init();
+    }
+    if (bg_check) {
+        memset(s_bg_stat, 0, sizeof(s_bg_stat));
+        memset(s_bg_ready, 0, sizeof(s_bg_ready));
+    }
 
     for (unsigned int step = 0U; step <= max_steps; step++) {
         uint16_t rel_walls;
@@ -638,6 +1134,9 @@ static bool run_explore_sim(unsigned int max_steps, bool verbose)
             newly_visited++;
         }
         visited[m.y][m.x] = true;
+        if (smap_check) {
+            sim_smap_check_touch(m.x, m.y);
+        }
 
         if (verbose) {
             printf("[explore] step=%u pos=(%u,%u,%u) rel_wall=0x%02X map=0x%04X\n",
@@ -646,11 +1145,26 @@ static bool run_explore_sim(unsigned int max_steps, bool verbose)
                    (unsigned int)map[m.y][m.x]);
         }
 
+        if (smap_check) {
+            smap_ok = sim_smap_check_step(step, &m, verbose) && smap_ok;
+            checked_steps++;
+        }
+
         if (sim_is_goal(m.x, m.y)) {
+            s_explore_steps = step;
             printf("[explore] result=ok steps=%u pos=(%u,%u,%u) newly_visited=%u\n",
                    step, (unsigned int)m.x, (unsigned int)m.y,
                    (unsigned int)m.dir, newly_visited);
-            return true;
+            if (smap_check) {
+                const bool cost_ok = sim_smap_check_report(checked_steps);
+                printf("[explore-smap] result=%s\n", !smap_ok ? "mismatch" : (cost_ok ? "match" : "slow"));
+                smap_ok = smap_ok && cost_ok;
+            }
+            if (bg_check) {
+                sim_bg_check_report();
+                printf("[bg-replan] result=%s\n", bg_ok ? "match" : "mismatch");
+            }
+            return smap_ok && bg_ok;
         }
 
         smap_step = sim_make_goal_smap(&m);
@@ -659,6 +1173,23 @@ static bool run_explore_sim(unsigned int max_steps, bool verbose)
                    (unsigned int)m.x, (unsigned int)m.y, (unsigned int)m.dir);
             return false;
         }
+        if (smap_check && !sim_smap_check_early_exit(step, &m, smap_step, rel)) {
+            smap_ok = false;
+        }
+        if (smap_check) {
+            // 早期終了 BFS と差分更新の歩数マップで、次の進行方向が一致することを確認
+            uint8_t inc_rel = 0xFFU;
+            memcpy(smap, s_smap_inc_dist[STEP_MAP_TARGET_GOAL], sizeof(smap));
+            if (!sim_next_move(&m, &inc_rel) || inc_rel != rel) {
+                printf("[explore-smap] next_move_mismatch step=%u bfs_rel=%u inc_rel=%u\n",
+                       step, (unsigned int)rel, (unsigned int)inc_rel);
+                smap_ok = false;
+            }
+        }
+        if (bg_check) {
+            bg_ok = sim_bg_check_step(step, &m, rel) && bg_ok;
+            sim_bg_check_arm(&m, rel);
+        }
         if (!sim_apply_move(&m, rel)) {
             printf("[explore] result=failed reason=hit_virtual_wall step=%u rel=%u pos=(%u,%u,%u)\n",
                    step, (unsigned int)rel, (unsigned int)m.x,
@@ -719,9 +1250,336 @@ static void print_path_summary(void)
     printf("[host] path_count=%u diagonal_or_special=%s\n", count, has_diagonal ? "yes" : "no");
 }
 
+// ---- 旋回プロファイル表（turn_profile.c）の検証 ----
+// 各モードのターン種別について、1ms 刻みの表引きの値を従来の連続式（cosf）と tick ごとに比較する。
+// 許容誤差は 16bit 固定小数の丸め（ωmax/65535）に余裕を持たせた値。
+#define TURN_CHECK_REL_TOL 1.0e-4f
+#define HOST_F413_PATH_OMEGA_CAP 2200.0f // f413_path_run.h の NIGHTFALL_F413_PATH_OMEGA_CAP
+#define TURN_CHECK_ABS_TOL 1.0e-3f
+
+static bool turn_check_one(const char *label, float angle, float alpha, float cap,
+                           float *worst_rel, unsigned int *tabulated)
+{
+    static turn_profile_t p;
+    float max_err = 0.0f;
+    double sum_deg = 0.0;
+
+    if (angle <= 0.0f || alpha <= 0.0f) {
+        return true; // 未設定のターン（実機は既定値で置き換える）
+    }
+    turn_profile_build(&p, angle, alpha, TURN_OMEGA_PROFILE_ROUNDING_SCALE, cap);
+    if (p.n_total == 0U) {
+        printf("[turn] %s angle=%.1f alpha=%.0f: empty profile\n", label, (double)angle,
+               (double)alpha);
+        return false;
+    }
+    // 表の終端の先（DONE）が 0 になることも確認する
+    for (uint32_t k = 0U; k <= (uint32_t)p.n_total + 1U; k++) {
+        const float ref = turn_profile_sample(&p, (float)k * TURN_PROFILE_DT_S);
+        const float got = turn_profile_omega_at(&p, k);
+        const float err = fabsf(got - ref);
+        if (err > max_err) {
+            max_err = err;
+        }
+        sum_deg += (double)got * (double)TURN_PROFILE_DT_S;
+    }
+    const float tol = TURN_CHECK_REL_TOL * p.omega_peak_deg_s + TURN_CHECK_ABS_TOL;
+    const float rel = max_err / p.omega_peak_deg_s;
+    const bool ok = max_err <= tol;
+    if (rel > *worst_rel) {
+        *worst_rel = rel;
+    }
+    if (p.tabulated) {
+        (*tabulated)++;
+    }
+    printf("[turn] %s angle=%.1f alpha=%.0f cap=%.0f peak=%.1f ticks=%u/%u/%u table=%s "
+           "max_err=%.5f (%.2e peak) angle_sum=%.3f %s\n",
+           label, (double)angle, (double)alpha, (double)cap, (double)p.omega_peak_deg_s,
+           (unsigned int)p.n_acc, (unsigned int)p.n_dec_start, (unsigned int)p.n_total,
+           p.tabulated ? "yes" : "no", (double)max_err, (double)rel, sum_deg,
+           ok ? "ok" : "NG");
+    return ok;
+}
+
+static bool run_turn_profile_check(void)
+{
+    static const ShortestRunModeParams_t *const modes[] = {
+        &shortestRunModeParams2, &shortestRunModeParams3, &shortestRunModeParams4,
+        &shortestRunModeParams5, &shortestRunModeParams6, &shortestRunModeParams7,
+    };
+    // F405 は上限なし、F413 は NIGHTFALL_F413_PATH_OMEGA_CAP (2200deg/s) で作る
+    static const float caps[] = {0.0f, HOST_F413_PATH_OMEGA_CAP};
+    bool ok = true;
+    float worst_rel = 0.0f;
+    unsigned int count = 0U;
+    unsigned int tabulated = 0U;
+
+    for (unsigned int m = 0U; m < sizeof(modes) / sizeof(modes[0]); m++) {
+        const ShortestRunModeParams_t *mp = modes[m];
+        const struct {
+            const char *name;
+            float angle;
+            float alpha;
+        } turns[] = {
+            {"turn90", mp->angle_turn_90, mp->alpha_turn90},
+            {"l_turn90", mp->angle_l_turn_90, mp->alpha_l_turn_90},
+            {"l_turn180", mp->angle_l_turn_180, mp->alpha_l_turn_180},
+            {"turn45in", mp->angle_turn45in, mp->alpha_turn45in},
+            {"turn45out", mp->angle_turn45out, mp->alpha_turn45out},
+            {"turnV90", mp->angle_turnV90, mp->alpha_turnV90},
+            {"turn135in", mp->angle_turn135in, mp->alpha_turn135in},
+            {"turn135out", mp->angle_turn135out, mp->alpha_turn135out},
+        };
+        for (unsigned int t = 0U; t < sizeof(turns) / sizeof(turns[0]); t++) {
+            for (unsigned int c = 0U; c < sizeof(caps) / sizeof(caps[0]); c++) {
+                char label[32];
+                snprintf(label, sizeof(label), "mode%u/%s", m + 2U, turns[t].name);
+                if (turns[t].angle <= 0.0f || turns[t].alpha <= 0.0f) {
+                    continue;
+                }
+                if (!turn_check_one(label, turns[t].angle, turns[t].alpha, caps[c], &worst_rel,
+                                    &tabulated)) {
+                    ok = false;
+                }
+                count++;
+            }
+        }
+    }
+    // 表に収まらない緩い旋回（連続式へのフォールバック）も同じ判定で確認する
+    if (!turn_check_one("fallback/spin180", 180.0f, 500.0f, 0.0f, &worst_rel, &tabulated)) {
+        ok = false;
+    }
+    count++;
+
+    printf("[turn] profiles=%u tabulated=%u worst_err=%.2e peak tol=%.1e peak result=%s\n",
+           count, tabulated, (double)worst_rel, (double)TURN_CHECK_REL_TOL, ok ? "ok" : "NG");
+    return ok;
+}
+
+// ---- 直線の S 字速度プロファイル（straight_profile.c）の検証 ----
+// drive.c の走行コマンドキューと同じく、tick ごとに straight_profile_velocity_at() の速度になる加速度を与えて
+// calculate_translation() と同じ式（float）で積算し、区間長・出口速度・加速度の連続性を確かめる。
+// ジャーク未設定のケース（既定）は、加速度の立ち上がり 10/20/50ms 相当の J で確かめる。
+// 区間長に達した tick の速度は、終端の 2 tick 分（2 J dt^2）か、残り距離が SCURVE_CHECK_TAIL_MM になる
+// 位置の速度まで出口速度からずれてよい（停止区間の終端は速度がほぼ 0 で、float の target_distance の
+// 丸めで区間長に達する tick が前後する）。
+// 加速度の変化はプロファイルの速度（float 積算の丸めを含まない）で測る。
+#define SCURVE_CHECK_DIST_TOL_MM 0.05f  // プロファイル終了時の距離誤差
+#define SCURVE_CHECK_VEL_TOL 0.01f      // 出口速度との差の余裕 [mm/s]
+#define SCURVE_CHECK_TAIL_MM 0.002f     // target_distance（float）の積算誤差の目安（+ 区間長の 1e-6）
+#define SCURVE_CHECK_JERK_MARGIN 1.001f // tick 間の加速度変化 <= J dt の余裕（float の速度の丸め 2ulp を別に許す）
+
+typedef struct {
+    unsigned int built;
+    unsigned int fallback;
+    float worst_dist_err;
+    float worst_vel_err;
+    float worst_jerk_ratio;
+    float worst_peak_ratio; // a_peak / 等加速度
+} ScurveCheckStats;
+
+static bool scurve_check_one(const char *label, float v_in, float v_out, float dist, float jerk,
+                             ScurveCheckStats *st)
+{
+    static straight_profile_t p;
+    const float dt = STRAIGHT_PROFILE_DT_S;
+
+    if (!straight_profile_build(&p, v_in, v_out, dist, jerk)) {
+        st->fallback++; // 従来の等加速度で走る
+        return true;
+    }
+    st->built++;
+
+    float v = v_in;
+    double v_prof_prev = v_in;
+    double a_prev = 0.0;
+    float target = 0.0f;
+    float jerk_ratio = 0.0f;
+    float vel_err = -1.0f;
+    float dist_err = 0.0f;
+    bool monotonic = true;
+    const uint32_t n_limit = p.n_total + (uint32_t)(dist / (dt * (v_out > 1.0f ? v_out : 1.0f))) + 2U;
+
+    for (uint32_t k = 0U; k <= n_limit; k++) {
+        if (k == p.n_total) {
+            // 終了後は v_out で延長した連続形の距離と比べる
+            dist_err = fabsf(target - (dist + v_out * ((float)k * dt - p.t_total_s)));
+        }
+        if (target >= dist && vel_err < 0.0f) {
+            vel_err = fabsf(v - v_out);
+            if (k >= p.n_total) {
+                break;
+            }
+        }
+        const float vk = straight_profile_velocity_at(&p, k);
+        const double a_prof = ((double)vk - v_prof_prev) / (double)dt;
+        const double v_abs = (fabsf(v_in) > fabsf(v_out)) ? fabsf(v_in) : fabsf(v_out);
+        const double ulp = (double)nextafterf((float)v_abs, INFINITY) - v_abs;
+        const float ratio = (float)((fabs(a_prof - a_prev) - 4.0 * ulp / (double)dt) /
+                                    ((double)p.jerk * (double)dt));
+        if (ratio > jerk_ratio) {
+            jerk_ratio = ratio;
+        }
+        if ((v_out > v_in) ? ((double)vk < v_prof_prev) : ((double)vk > v_prof_prev)) {
+            monotonic = false;
+        }
+        v_prof_prev = vk;
+        a_prev = a_prof;
+        // drive_queue_scurve_step() と calculate_translation() の積算
+        const float a = (vk - v) / dt;
+        v += a * dt;
+        target += v * dt;
+    }
+    if (vel_err < 0.0f) {
+        vel_err = fabsf(v - v_out);
+    }
+
+    const float a_mean = fabsf(v_out - v_in) / p.t_total_s;
+    const float peak_ratio = fabsf(p.a_peak) / a_mean;
+    const float t_tail = cbrtf(6.0f * (SCURVE_CHECK_TAIL_MM + 1e-6f * dist) / p.jerk); // 残り距離 J t^3 / 6
+    const float vel_tol = fmaxf(2.0f * p.jerk * dt * dt, 0.5f * p.jerk * t_tail * t_tail) +
+                          SCURVE_CHECK_VEL_TOL;
+    const bool ok = monotonic && dist_err <= SCURVE_CHECK_DIST_TOL_MM &&
+                    vel_err <= vel_tol && jerk_ratio <= SCURVE_CHECK_JERK_MARGIN;
+    if (dist_err > st->worst_dist_err) {
+        st->worst_dist_err = dist_err;
+    }
+    if (vel_err > st->worst_vel_err) {
+        st->worst_vel_err = vel_err;
+    }
+    if (jerk_ratio > st->worst_jerk_ratio) {
+        st->worst_jerk_ratio = jerk_ratio;
+    }
+    if (peak_ratio > st->worst_peak_ratio) {
+        st->worst_peak_ratio = peak_ratio;
+    }
+    if (!ok) {
+        printf("[scurve] %s v=%.0f->%.0f dist=%.1f jerk=%.0f ticks=%u a_peak=%.0f dist_err=%.4f "
+               "vel_err=%.4f jerk_ratio=%.4f monotonic=%s NG\n",
+               label, (double)v_in, (double)v_out, (double)dist, (double)jerk,
+               (unsigned int)p.n_total, (double)p.a_peak, (double)dist_err, (double)vel_err,
+               (double)jerk_ratio, monotonic ? "yes" : "no");
+    }
+    return ok;
+}
+
+static bool run_straight_profile_check(void)
+{
+    static const ShortestRunCaseParams_t *const modes[] = {
+        shortestRunCaseParamsMode2, shortestRunCaseParamsMode3, shortestRunCaseParamsMode4,
+        shortestRunCaseParamsMode5, shortestRunCaseParamsMode6, shortestRunCaseParamsMode7,
+    };
+    static const float ramp_s[] = {0.01f, 0.02f, 0.05f};
+    ScurveCheckStats st = {0};
+    bool ok = true;
+
+    for (unsigned int m = 0U; m < sizeof(modes) / sizeof(modes[0]); m++) {
+        for (unsigned int c = 0U; c < 9U; c++) {
+            const ShortestRunCaseParams_t *cp = &modes[m][c];
+            const float accel = cp->acceleration_straight;
+            const float v_max = cp->velocity_straight;
+            if (accel <= 0.0f || v_max <= 0.0f) {
+                continue;
+            }
+            // run() の直進の典型: 停止/低速/最高速の間の加減速を、等加速度で丁度の区間長で行う
+            const float speeds[] = {0.0f, 300.0f, 0.5f * v_max, v_max};
+            float jerks[4];
+            unsigned int n_jerk = 0U;
+            if (cp->jerk_straight > 0.0f) {
+                jerks[n_jerk++] = cp->jerk_straight;
+            }
+            for (unsigned int r = 0U; r < sizeof(ramp_s) / sizeof(ramp_s[0]); r++) {
+                jerks[n_jerk++] = accel / ramp_s[r];
+            }
+            char label[32];
+            snprintf(label, sizeof(label), "mode%u/case%u", m + 2U, c + 1U);
+            for (unsigned int i = 0U; i < 4U; i++) {
+                for (unsigned int o = 0U; o < 4U; o++) {
+                    const float v_in = speeds[i];
+                    const float v_out = speeds[o];
+                    if (v_in == v_out) {
+                        continue;
+                    }
+                    const float dist = fabsf(v_out * v_out - v_in * v_in) / (2.0f * accel);
+                    for (unsigned int j = 0U; j < n_jerk; j++) {
+                        if (!scurve_check_one(label, v_in, v_out, dist, jerks[j], &st)) {
+                            ok = false;
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    printf("[scurve] profiles=%u fallback=%u worst_dist_err=%.4fmm worst_vel_err=%.4fmm/s "
+           "worst_jerk_ratio=%.4f worst_peak_ratio=%.3f result=%s\n",
+           st.built, st.fallback, (double)st.worst_dist_err, (double)st.worst_vel_err,
+           (double)st.worst_jerk_ratio, (double)st.worst_peak_ratio, ok ? "ok" : "NG");
+    return ok;
+}
+
+// ---- 経路全体の速度計画（path_speed_plan.c）の表示 ----
+// solver_build_path() と同じモード/ケースのパラメータで path[] の速度計画を作り、
+// 区間ごとの入口・最高・出口速度と所要時間の見積もりを表示する。
+static bool host_shortest_params(uint8_t mode, uint8_t case_index,
+                                 const ShortestRunModeParams_t **mp,
+                                 const ShortestRunCaseParams_t **cp)
+{
+    uint8_t idx = (case_index >= 1U) ? (uint8_t)(case_index - 1U) : 0U;
+
+    if (idx > 8U) {
+        idx = 8U;
+    }
+    switch (mode) {
+    case 2: *mp = &shortestRunModeParams2; *cp = &shortestRunCaseParamsMode2[idx]; break;
+    case 3: *mp = &shortestRunModeParams3; *cp = &shortestRunCaseParamsMode3[idx]; break;
+    case 4: *mp = &shortestRunModeParams4; *cp = &shortestRunCaseParamsMode4[idx]; break;
+    case 5: *mp = &shortestRunModeParams5; *cp = &shortestRunCaseParamsMode5[idx]; break;
+    case 6: *mp = &shortestRunModeParams6; *cp = &shortestRunCaseParamsMode6[idx]; break;
+    case 7: *mp = &shortestRunModeParams7; *cp = &shortestRunCaseParamsMode7[idx]; break;
+    default: return false;
+    }
+    return true;
+}
+
+static bool print_speed_plan(uint8_t mode, uint8_t case_index)
+{
+    static path_speed_plan_t plan;
+    static const char *const kind_name[] = {"straight", "diagonal", "turn"};
+    const ShortestRunModeParams_t *mp = NULL;
+    const ShortestRunCaseParams_t *cp = NULL;
+
+    if (!host_shortest_params(mode, case_index, &mp, &cp)) {
+        printf("[plan] unsupported mode=%u\n", (unsigned int)mode);
+        return false;
+    }
+    if (!path_speed_plan_build(&plan, path, mp, cp, HOST_F413_PATH_OMEGA_CAP)) {
+        printf("[plan] build failed (unsupported code or too many codes)\n");
+        return false;
+    }
+    printf("[plan] straight v_max=%.0f a=%.0f/%.0f switch=%.0f diagonal v_max=%.0f a=%.0f\n",
+           (double)plan.straight.v_max, (double)plan.straight.accel_low,
+           (double)plan.straight.accel_high, (double)plan.straight.v_switch,
+           (double)plan.diagonal.v_max, (double)plan.diagonal.accel_high);
+    for (uint16_t i = 0U; i < plan.count; i++) {
+        const path_speed_seg_t *seg = &plan.seg[i];
+        char name[16];
+        printf("[plan] %3u %-8s %-9s len=%7.1f v_in=%6.0f v_peak=%6.0f v_out=%6.0f t=%6.1fms%s\n",
+               (unsigned int)i,
+               (seg->code == 0U) ? "first" : path_code_name(seg->code, name, sizeof(name)),
+               kind_name[seg->kind], (double)seg->length_mm, (double)seg->v_entry,
+               (double)seg->v_peak, (double)seg->v_exit, (double)(seg->time_s * 1000.0f),
+               seg->feasible ? "" : " infeasible");
+    }
+    printf("[plan] segments=%u length=%.0fmm est_time=%.3fs infeasible=%u\n",
+           (unsigned int)plan.count, (double)plan.total_length_mm, (double)plan.total_time_s,
+           (unsigned int)plan.infeasible);
+    return true;
+}
+
 static void print_usage(const char *argv0)
 {
-    printf("usage: %s [--maze FILE.maze] [--maze-c-array FILE] [--search-dump FILE] [--origin top-left|bottom-left] [--mode N] [--case N] [--verbose-solver] [--explore-sim] [--explore-verbose] [--max-steps N]\n", argv0);
+    printf("usage: %s [--maze FILE.maze] [--maze-c-array FILE] [--search-dump FILE] [--origin top-left|bottom-left] [--mode N] [--case N] [--verbose-solver] [--explore-sim] [--explore-verbose] [--explore-smap-check] [--explore-bg-check] [--max-steps N] [--bench N] [--speed-plan] [--turn-profile-check] [--straight-profile-check] [--solver-profile N] [--profile-compare DIR [--verbose-solver]] [--step-report DIR [--batch-iterations N] [--max-steps N]] [--bg-replan-check DIR [--max-steps N]] [--explore-full DIR [--mode N] [--case N] [--max-steps N]] [--path-compile-check DIR] [--batch DIR [--golden FILE] [--update-golden] [--batch-iterations N] [--time-tolerance PCT]]\n", argv0);
 }
 
 static bool run_solver_quiet(uint8_t mode, uint8_t case_index)
@@ -750,48 +1608,1425 @@ static bool run_solver_quiet(uint8_t mode, uint8_t case_index)
     return ok;
 }
 
-int main(int argc, char **argv)
+// solver_build_path() 1 回あたりの時間と、そのうち迷路構築 + 探索（solver_stats_t.search_us）の平均
+static double bench_solver_once(uint8_t mode, uint8_t case_index, unsigned int iterations, bool *ok,
+                                double *search_us)
 {
-    const char *maze_file = NULL;
-    const char *maze_text_file = NULL;
-    const char *search_dump_file = NULL;
-    bool top_left_origin = true;
-    bool verbose_solver = false;
-    bool explore_sim = false;
-    bool explore_verbose = false;
-    unsigned int max_steps = 2048U;
-    uint8_t mode = 2U;
-    uint8_t case_index = 1U;
+    uint64_t search_sum = 0U;
+    double t0 = host_now_us();
+    *ok = true;
+    solver_set_clock(host_clock_us);
+    for (unsigned int i = 0U; i < iterations; i++) {
+        solver_stats_t st;
+        if (!solver_build_path(mode, case_index)) {
+            *ok = false;
+        }
+        solver_get_stats(&st);
+        search_sum += st.search_us;
+    }
+    solver_set_clock(NULL);
+    *search_us = (double)search_sum / (double)iterations;
+    return (host_now_us() - t0) / (double)iterations;
+}
 
-    for (int i = 1; i < argc; i++) {
-        if (strcmp(argv[i], "--maze-c-array") == 0 && (i + 1) < argc) {
-            maze_file = argv[++i];
-        } else if (strcmp(argv[i], "--maze") == 0 && (i + 1) < argc) {
-            maze_text_file = argv[++i];
-        } else if (strcmp(argv[i], "--search-dump") == 0 && (i + 1) < argc) {
-            search_dump_file = argv[++i];
-        } else if (strcmp(argv[i], "--origin") == 0 && (i + 1) < argc) {
-            const char *origin = argv[++i];
-            if (strcmp(origin, "top-left") == 0) {
-                top_left_origin = true;
-            } else if (strcmp(origin, "bottom-left") == 0) {
-                top_left_origin = false;
-            } else {
-                print_usage(argv[0]);
-                return 2;
-            }
-        } else if (strcmp(argv[i], "--mode") == 0 && (i + 1) < argc) {
-            mode = (uint8_t)strtoul(argv[++i], NULL, 0);
-        } else if (strcmp(argv[i], "--case") == 0 && (i + 1) < argc) {
-            case_index = (uint8_t)strtoul(argv[++i], NULL, 0);
-        } else if (strcmp(argv[i], "--verbose-solver") == 0) {
-            verbose_solver = true;
+static bool run_solver_bench(uint8_t mode, uint8_t case_index, unsigned int iterations)
+{
+    static const struct {
+        uint8_t impl;
+        const char *name;
+    } impls[] = {
+        {SOLVER_IMPL_LEGACY_SCAN, "legacy-scan"},
+        {SOLVER_IMPL_PER_GOAL, "per-goal-heap"},
+        {SOLVER_IMPL_MULTI_GOAL, "multi-goal-heap"},
+    };
+    enum { IMPL_NUM = sizeof(impls) / sizeof(impls[0]) };
+    static uint16_t paths[IMPL_NUM][ROUTE_MAX_LEN];
+    uint8_t goal_x[IMPL_NUM];
+    uint8_t goal_y[IMPL_NUM];
+    bool goal_ok[IMPL_NUM];
+    bool ok[IMPL_NUM];
+    double us[IMPL_NUM];
+    double search_us[IMPL_NUM];
+    int saved_stdout = dup(STDOUT_FILENO);
+    int null_fd = open("/dev/null", O_WRONLY);
+
+    if (saved_stdout < 0 || null_fd < 0) {
+        if (saved_stdout >= 0) {
+            close(saved_stdout);
+        }
+        if (null_fd >= 0) {
+            close(null_fd);
+        }
+        return false;
+    }
+
+    // solver.c 内部の迷路表示は /dev/null へ捨て、各実装で同じ条件にする
+    fflush(stdout);
+    dup2(null_fd, STDOUT_FILENO);
+    for (unsigned int i = 0U; i < IMPL_NUM; i++) {
+        solver_set_impl(impls[i].impl);
+        us[i] = bench_solver_once(mode, case_index, iterations, &ok[i], &search_us[i]);
+        memcpy(paths[i], path, sizeof(paths[i]));
+        goal_ok[i] = solver_get_last_goal(&goal_x[i], &goal_y[i]);
+    }
+    solver_set_impl(SOLVER_IMPL_MULTI_GOAL);
+    fflush(stdout);
+    dup2(saved_stdout, STDOUT_FILENO);
+    close(null_fd);
+    close(saved_stdout);
+
+    for (unsigned int i = 0U; i < IMPL_NUM; i++) {
+        printf("[bench] impl=%s iterations=%u avg_us=%.1f search_us=%.1f result=%s",
+               impls[i].name, iterations, us[i], search_us[i], ok[i] ? "ok" : "failed");
+        if (goal_ok[i]) {
+            printf(" goal=(%u,%u)\n", (unsigned int)goal_x[i], (unsigned int)goal_y[i]);
+        } else {
+            printf(" goal=none\n");
+        }
+    }
+
+    // 現行（multi-goal）は per-goal ループと同じゴール・経路を選ぶこと
+    const unsigned int cur = IMPL_NUM - 1U;
+    bool match_per_goal = (memcmp(paths[1], paths[cur], sizeof(paths[cur])) == 0) &&
+                          (goal_ok[1] == goal_ok[cur]) &&
+                          (goal_x[1] == goal_x[cur]) && (goal_y[1] == goal_y[cur]);
+    bool match_legacy = (memcmp(paths[0], paths[cur], sizeof(paths[cur])) == 0);
+    printf("[bench] speedup_vs_legacy=%.2fx speedup_vs_per_goal=%.2fx search_speedup_vs_legacy=%.2fx "
+           "search_speedup_vs_per_goal=%.2fx match_per_goal=%s path_match_legacy=%s\n",
+           (us[cur] > 0.0) ? (us[0] / us[cur]) : 0.0,
+           (us[cur] > 0.0) ? (us[1] / us[cur]) : 0.0,
+           (search_us[cur] > 0.0) ? (search_us[0] / search_us[cur]) : 0.0,
+           (search_us[cur] > 0.0) ? (search_us[1] / search_us[cur]) : 0.0,
+           match_per_goal ? "yes" : "no", match_legacy ? "yes" : "no");
+    if (!match_per_goal || !match_legacy) {
+        for (unsigned int i = 0U; i < IMPL_NUM; i++) {
+            memcpy(path, paths[i], sizeof(paths[i]));
+            printf("[bench] %s:\n", impls[i].name);
+            print_path_summary();
+        }
+    }
+    return ok[1] == ok[cur] && match_per_goal;
+}
+
+// ---- 迷路コーパスの一括実行とゴールデン比較 ----
+// ディレクトリ内の *.maze を名前順に読み、モード 2..7 × ケース 1..9 の全組で solver_build_path() を
+// 実行して path[]・速度計画の見積もり走行時間・求解時間（iterations 回の最短）を記録する。
+// ゴールデンファイルと比較し、経路（result/goal/path）の不一致は終了コード1、求解時間の悪化
+// （time_tol_pct [%] かつ BATCH_TIME_FLOOR_US 以上の増加）と見積もり時間の変化は報告のみ。
+#define BATCH_MODE_FIRST 2U
+#define BATCH_MODE_LAST 7U
+#define BATCH_CASE_NUM 9U
+#define BATCH_TIME_FLOOR_US 5.0  // これ未満の求解時間の増加は計測ばらつきとして無視
+#define BATCH_EST_TOL_MS 0.5     // 見積もり走行時間の変化として報告する差
+
+typedef struct {
+    char maze[64];
+    uint8_t mode;
+    uint8_t case_index;
+    bool ok;
+    char goal[16];
+    double est_ms;   // 速度計画の見積もり走行時間（作れない場合は負）
+    double solve_us;
+    char *path;      // "201,300,..."（経路なしは "-"）
+    bool matched;    // ゴールデン比較で対応する記録が見つかった
+} BatchEntry;
+
+typedef struct {
+    BatchEntry *items;
+    size_t count;
+    size_t cap;
+    char goals[128]; // ゴールデンのヘッダ（作成時のゴール座標）
+} BatchSet;
+
+static void batch_goals_string(char *buf, size_t len)
+{
+    const uint8_t goals[9][2] = {
+        {GOAL1_X, GOAL1_Y}, {GOAL2_X, GOAL2_Y}, {GOAL3_X, GOAL3_Y},
+        {GOAL4_X, GOAL4_Y}, {GOAL5_X, GOAL5_Y}, {GOAL6_X, GOAL6_Y},
+        {GOAL7_X, GOAL7_Y}, {GOAL8_X, GOAL8_Y}, {GOAL9_X, GOAL9_Y},
+    };
+    size_t pos = 0U;
+
+    buf[0] = '\0';
+    for (unsigned int i = 0U; i < 9U && pos < len; i++) {
+        if (goals[i][0] == 0U && goals[i][1] == 0U) {
+            continue;
+        }
+        int n = snprintf(buf + pos, len - pos, "%s%u,%u", (pos != 0U) ? ";" : "",
+                         (unsigned int)goals[i][0], (unsigned int)goals[i][1]);
+        if (n < 0) {
+            break;
+        }
+        pos += (size_t)n;
+    }
+}
+
+static BatchEntry *batch_push(BatchSet *set)
+{
+    if (set->count == set->cap) {
+        size_t cap = (set->cap == 0U) ? 256U : set->cap * 2U;
+        BatchEntry *items = (BatchEntry *)realloc(set->items, cap * sizeof(BatchEntry));
+        if (items == NULL) {
+            return NULL;
+        }
+        set->items = items;
+        set->cap = cap;
+    }
+    BatchEntry *e = &set->items[set->count++];
+    memset(e, 0, sizeof(*e));
+    return e;
+}
+
+static void batch_free(BatchSet *set)
+{
+    for (size_t i = 0U; i < set->count; i++) {
+        free(set->items[i].path);
+    }
+    free(set->items);
+    memset(set, 0, sizeof(*set));
+}
+
+static char *batch_path_string(void)
+{
+    size_t len = 2U;
+    size_t pos = 0U;
+    char *buf;
+
+    for (unsigned int i = 0U; i < ROUTE_MAX_LEN && path[i] != 0U; i++) {
+        len += 6U;
+    }
+    buf = (char *)malloc(len);
+    if (buf == NULL) {
+        return NULL;
+    }
+    if (path[0] == 0U) {
+        strcpy(buf, "-");
+        return buf;
+    }
+    for (unsigned int i = 0U; i < ROUTE_MAX_LEN && path[i] != 0U; i++) {
+        pos += (size_t)snprintf(buf + pos, len - pos, "%s%u", (i != 0U) ? "," : "",
+                                (unsigned int)path[i]);
+    }
+    return buf;
+}
+
+static void batch_format(const BatchEntry *e, FILE *fp)
+{
+    fprintf(fp, "%s mode=%u case=%u result=%s goal=%s est_ms=%.1f solve_us=%.1f path=%s\n",
+            e->maze, (unsigned int)e->mode, (unsigned int)e->case_index,
+            e->ok ? "ok" : "failed", e->goal, e->est_ms, e->solve_us, e->path);
+}
+
+// 1 迷路について全モード・ケースを実行して set に追加する（solver.c の表示は捨てる）
+static bool batch_run_maze(BatchSet *set, const char *maze_name, unsigned int iterations)
+{
+    static path_speed_plan_t plan;
+    int saved_stdout = dup(STDOUT_FILENO);
+    int null_fd = open("/dev/null", O_WRONLY);
+    bool alloc_ok = true;
+
+    if (saved_stdout < 0 || null_fd < 0) {
+        if (saved_stdout >= 0) {
+            close(saved_stdout);
+        }
+        if (null_fd >= 0) {
+            close(null_fd);
+        }
+        return false;
+    }
+
+    fflush(stdout);
+    dup2(null_fd, STDOUT_FILENO);
+    for (uint8_t mode = BATCH_MODE_FIRST; mode <= BATCH_MODE_LAST && alloc_ok; mode++) {
+        for (uint8_t ci = 1U; ci <= BATCH_CASE_NUM; ci++) {
+            const ShortestRunModeParams_t *mp = NULL;
+            const ShortestRunCaseParams_t *cp = NULL;
+            BatchEntry *e = batch_push(set);
+            uint8_t gx;
+            uint8_t gy;
+            bool ok;
+
+            if (e == NULL) {
+                alloc_ok = false;
+                break;
+            }
+            snprintf(e->maze, sizeof(e->maze), "%.63s", maze_name);
+            e->mode = mode;
+            e->case_index = ci;
+            // 求解時間は iterations 回のうち最短の 1 回（割り込み等による外れ値を除く）
+            e->solve_us = -1.0;
+            ok = true;
+            for (unsigned int k = 0U; k < iterations; k++) {
+                double search_us;
+                double us = bench_solver_once(mode, ci, 1U, &ok, &search_us);
+                if (e->solve_us < 0.0 || us < e->solve_us) {
+                    e->solve_us = us;
+                }
+            }
+            e->ok = ok;
+            if (ok && solver_get_last_goal(&gx, &gy)) {
+                snprintf(e->goal, sizeof(e->goal), "%u,%u", (unsigned int)gx, (unsigned int)gy);
+            } else {
+                snprintf(e->goal, sizeof(e->goal), "-");
+            }
+            e->est_ms = -1.0;
+            if (ok && host_shortest_params(mode, ci, &mp, &cp) &&
+                path_speed_plan_build(&plan, path, mp, cp, HOST_F413_PATH_OMEGA_CAP)) {
+                e->est_ms = (double)plan.total_time_s * 1000.0;
+            }
+            e->path = batch_path_string();
+            if (e->path == NULL) {
+                alloc_ok = false;
+                break;
+            }
+        }
+    }
+    fflush(stdout);
+    dup2(saved_stdout, STDOUT_FILENO);
+    close(null_fd);
+    close(saved_stdout);
+    return alloc_ok;
+}
+
+static int batch_maze_filter(const struct dirent *d)
+{
+    size_t len = strlen(d->d_name);
+    return (len > 5U) && (strcmp(d->d_name + len - 5U, ".maze") == 0);
+}
+
+static bool batch_run_dir(BatchSet *set, const char *dir_name, unsigned int iterations)
+{
+    struct dirent **names = NULL;
+    int n = scandir(dir_name, &names, batch_maze_filter, alphasort);
+    bool ok = true;
+
+    if (n < 0) {
+        fprintf(stderr, "failed to scan %s: %s\n", dir_name, strerror(errno));
+        return false;
+    }
+    if (n == 0) {
+        fprintf(stderr, "no .maze files in %s\n", dir_name);
+        ok = false;
+    }
+    for (int i = 0; i < n; i++) {
+        char file[1024];
+
+        if (ok) {
+            snprintf(file, sizeof(file), "%s/%s", dir_name, names[i]->d_name);
+            if (!load_maze_text_file(file) || !batch_run_maze(set, names[i]->d_name, iterations)) {
+                fprintf(stderr, "[batch] failed on %s\n", file);
+                ok = false;
+            }
+        }
+        free(names[i]);
+    }
+    free(names);
+    return ok;
+}
+
+static bool batch_write_golden(const BatchSet *set, const char *golden_file,
+                               unsigned int iterations)
+{
+    char goals[128];
+    FILE *fp = fopen(golden_file, "w");
+
+    if (fp == NULL) {
+        fprintf(stderr, "failed to open %s\n", golden_file);
+        return false;
+    }
+    batch_goals_string(goals, sizeof(goals));
+    fprintf(fp, "# solver_host --batch golden (tools/solver_host/run_solver_corpus.sh --update)\n");
+    fprintf(fp, "# goals=%s maze_size=%u iterations=%u\n", goals, (unsigned int)MAZE_SIZE,
+            iterations);
+    for (size_t i = 0U; i < set->count; i++) {
+        batch_format(&set->items[i], fp);
+    }
+    fclose(fp);
+    printf("[batch] wrote golden=%s entries=%zu\n", golden_file, set->count);
+    return true;
+}
+
+static bool batch_parse_line(char *line, BatchEntry *e)
+{
+    char result[16];
+    unsigned int mode;
+    unsigned int ci;
+    int path_pos = -1;
+
+    if (sscanf(line, "%63s mode=%u case=%u result=%15s goal=%15s est_ms=%lf solve_us=%lf path=%n",
+               e->maze, &mode, &ci, result, e->goal, &e->est_ms, &e->solve_us, &path_pos) != 7 ||
+        path_pos < 0) {
+        return false;
+    }
+    e->mode = (uint8_t)mode;
+    e->case_index = (uint8_t)ci;
+    e->ok = (strcmp(result, "ok") == 0);
+    e->path = strdup(line + path_pos);
+    return e->path != NULL;
+}
+
+static bool batch_load_golden(BatchSet *set, const char *golden_file)
+{
+    char *buf = NULL;
+    char *save = NULL;
+
+    if (!read_file_bytes(golden_file, &buf)) {
+        return false;
+    }
+    for (char *line = strtok_r(buf, "\r\n", &save); line != NULL;
+         line = strtok_r(NULL, "\r\n", &save)) {
+        if (line[0] == '#') {
+            const char *g = strstr(line, "goals=");
+            if (g != NULL) {
+                sscanf(g, "goals=%127s", set->goals);
+            }
+            continue;
+        }
+        BatchEntry *e = batch_push(set);
+        if (e == NULL || !batch_parse_line(line, e)) {
+            fprintf(stderr, "invalid golden line: %s\n", line);
+            free(buf);
+            return false;
+        }
+    }
+    free(buf);
+    return true;
+}
+
+static BatchEntry *batch_find(BatchSet *set, const BatchEntry *key)
+{
+    for (size_t i = 0U; i < set->count; i++) {
+        BatchEntry *e = &set->items[i];
+        if (e->mode == key->mode && e->case_index == key->case_index &&
+            strcmp(e->maze, key->maze) == 0) {
+            return e;
+        }
+    }
+    return NULL;
+}
+
+static bool batch_compare(BatchSet *cur, BatchSet *golden, double time_tol_pct)
+{
+    char goals[128];
+    unsigned int path_regress = 0U;
+    unsigned int time_regress = 0U;
+    unsigned int est_changed = 0U;
+    unsigned int added = 0U;
+    unsigned int missing = 0U;
+    double cur_us = 0.0;
+    double golden_us = 0.0;
+
+    batch_goals_string(goals, sizeof(goals));
+    if (strcmp(goals, golden->goals) != 0) {
+        printf("[batch] goal mismatch: build=%s golden=%s (check SOLVER_HOST_CFLAGS)\n", goals,
+               golden->goals);
+        return false;
+    }
+
+    for (size_t i = 0U; i < cur->count; i++) {
+        BatchEntry *c = &cur->items[i];
+        BatchEntry *g = batch_find(golden, c);
+
+        if (g == NULL) {
+            printf("[batch] new   ");
+            batch_format(c, stdout);
+            added++;
+            continue;
+        }
+        g->matched = true;
+        cur_us += c->solve_us;
+        golden_us += g->solve_us;
+        if (c->ok != g->ok || strcmp(c->goal, g->goal) != 0 || strcmp(c->path, g->path) != 0) {
+            printf("[batch] PATH  %s mode=%u case=%u\n", c->maze, (unsigned int)c->mode,
+                   (unsigned int)c->case_index);
+            printf("[batch]   golden: ");
+            batch_format(g, stdout);
+            printf("[batch]   now:    ");
+            batch_format(c, stdout);
+            path_regress++;
+            continue;
+        }
+        if ((c->solve_us - g->solve_us) >= BATCH_TIME_FLOOR_US &&
+            c->solve_us > g->solve_us * (1.0 + time_tol_pct / 100.0)) {
+            printf("[batch] TIME  %s mode=%u case=%u solve_us=%.1f golden=%.1f (+%.0f%%)\n",
+                   c->maze, (unsigned int)c->mode, (unsigned int)c->case_index, c->solve_us,
+                   g->solve_us, (c->solve_us / g->solve_us - 1.0) * 100.0);
+            time_regress++;
+        }
+        if (fabs(c->est_ms - g->est_ms) >= BATCH_EST_TOL_MS) {
+            printf("[batch] EST   %s mode=%u case=%u est_ms=%.1f golden=%.1f\n", c->maze,
+                   (unsigned int)c->mode, (unsigned int)c->case_index, c->est_ms, g->est_ms);
+            est_changed++;
+        }
+    }
+    for (size_t i = 0U; i < golden->count; i++) {
+        if (!golden->items[i].matched) {
+            printf("[batch] missing ");
+            batch_format(&golden->items[i], stdout);
+            missing++;
+        }
+    }
+
+    printf("[batch] entries=%zu path_regress=%u time_regress=%u est_changed=%u new=%u missing=%u "
+           "solve_us_total=%.0f golden=%.0f (%.2fx)\n",
+           cur->count, path_regress, time_regress, est_changed, added, missing, cur_us,
+           golden_us, (golden_us > 0.0) ? (cur_us / golden_us) : 0.0);
+    // 個々の求解時間は計測ばらつきが大きいため、全体の合計でも悪化を判定して報告する
+    printf("[batch] result=%s solve_time=%s\n", (path_regress == 0U) ? "ok" : "path_regression",
+           (cur_us > golden_us * (1.0 + time_tol_pct / 100.0)) ? "regressed" : "ok");
+    return path_regress == 0U;
+}
+
+static bool run_batch(const char *dir_name, const char *golden_file, bool update_golden,
+                      unsigned int iterations, double time_tol_pct)
+{
+    BatchSet cur;
+    BatchSet golden;
+    double t0 = host_now_us();
+    bool ok;
+
+    memset(&cur, 0, sizeof(cur));
+    memset(&golden, 0, sizeof(golden));
+    if (!batch_run_dir(&cur, dir_name, iterations)) {
+        batch_free(&cur);
+        return false;
+    }
+    printf("[batch] dir=%s entries=%zu iterations=%u elapsed=%.2fs\n", dir_name, cur.count,
+           iterations, (host_now_us() - t0) / 1e6);
+
+    if (golden_file == NULL) {
+        for (size_t i = 0U; i < cur.count; i++) {
+            batch_format(&cur.items[i], stdout);
+        }
+        ok = true;
+    } else if (update_golden) {
+        ok = batch_write_golden(&cur, golden_file, iterations);
+    } else {
+        ok = batch_load_golden(&golden, golden_file) && batch_compare(&cur, &golden, time_tol_pct);
+    }
+    batch_free(&cur);
+    batch_free(&golden);
+    return ok;
+}
+
+// ---- ソルバのコストプロファイル比較（--profile-compare） ----
+// 迷路ディレクトリの全迷路・全モード/ケースについて、各プロファイルを強制して経路を作り、
+// path_speed_plan.c の見積もり走行時間を比べる。時間最適プロファイルが手調整プロファイルの
+// 最良値より遅い組と、その差の最大を報告する。最良値より PROFILE_CMP_TOL_PCT を超えて遅い組が
+// あれば NG（時間最適のコストモデルは同着や斜めの連続回数の扱いを近似しているため、わずかな差は許す）。
+#define PROFILE_CMP_TIE_MS  0.5 // 同じ時間とみなす差
+#define PROFILE_CMP_TOL_PCT 1.5 // 手調整の最良値に対して許す遅れ [%]
+
+static const char *const k_profile_name[SOLVER_PROFILE_NUM] = {
+    "standard", "straight-strong", "straight-weak", "time-optimal",
+};
+
+typedef struct {
+    double total_ms;
+    unsigned int solved;
+    unsigned int best;   // 全プロファイル中で最速（同着を含む）
+} ProfileCmpStat;
+
+static bool profile_cmp_est(uint8_t mode, uint8_t case_index, uint8_t profile, double *est_ms)
+{
+    static path_speed_plan_t plan;
+    const ShortestRunModeParams_t *mp = NULL;
+    const ShortestRunCaseParams_t *cp = NULL;
+
+    solver_force_profile(profile);
+    if (!solver_build_path(mode, case_index) || !host_shortest_params(mode, case_index, &mp, &cp) ||
+        !path_speed_plan_build(&plan, path, mp, cp, HOST_F413_PATH_OMEGA_CAP)) {
+        return false;
+    }
+    *est_ms = (double)plan.total_time_s * 1000.0;
+    return true;
+}
+
+static bool run_profile_compare(const char *dir_name, bool verbose)
+{
+    ProfileCmpStat stat[SOLVER_PROFILE_NUM];
+    struct dirent **names = NULL;
+    unsigned int entries = 0U;
+    unsigned int slower = 0U;
+    unsigned int over = 0U;
+    unsigned int lost = 0U;
+    double worst_ms = 0.0;
+    double worst_pct = 0.0;
+    char worst[128] = "-";
+    int saved_stdout;
+    int null_fd;
+    int n = scandir(dir_name, &names, batch_maze_filter, alphasort);
+
+    if (n <= 0) {
+        fprintf(stderr, "no .maze files in %s\n", dir_name);
+        free(names);
+        return false;
+    }
+    memset(stat, 0, sizeof(stat));
+    for (int i = 0; i < n; i++) {
+        char file[1024];
+
+        snprintf(file, sizeof(file), "%s/%s", dir_name, names[i]->d_name);
+        if (!load_maze_text_file(file)) {
+            fprintf(stderr, "[cmp] failed on %s\n", file);
+            continue;
+        }
+        for (uint8_t mode = BATCH_MODE_FIRST; mode <= BATCH_MODE_LAST; mode++) {
+            for (uint8_t ci = 1U; ci <= BATCH_CASE_NUM; ci++) {
+                double est[SOLVER_PROFILE_NUM];
+                bool ok[SOLVER_PROFILE_NUM];
+                double best_hand = -1.0;
+                double best_all = -1.0;
+
+                // solver.c の表示は捨てる
+                fflush(stdout);
+                saved_stdout = dup(STDOUT_FILENO);
+                null_fd = open("/dev/null", O_WRONLY);
+                if (saved_stdout >= 0 && null_fd >= 0) {
+                    dup2(null_fd, STDOUT_FILENO);
+                }
+                for (uint8_t p = 0U; p < SOLVER_PROFILE_NUM; p++) {
+                    ok[p] = profile_cmp_est(mode, ci, p, &est[p]);
+                }
+                fflush(stdout);
+                if (saved_stdout >= 0) {
+                    dup2(saved_stdout, STDOUT_FILENO);
+                    close(saved_stdout);
+                }
+                if (null_fd >= 0) {
+                    close(null_fd);
+                }
+
+                entries++;
+                for (uint8_t p = 0U; p < SOLVER_PROFILE_NUM; p++) {
+                    if (!ok[p]) {
+                        continue;
+                    }
+                    stat[p].solved++;
+                    stat[p].total_ms += est[p];
+                    if (best_all < 0.0 || est[p] < best_all) {
+                        best_all = est[p];
+                    }
+                    if (p != SOLVER_PROFILE_TIME_OPTIMAL && (best_hand < 0.0 || est[p] < best_hand)) {
+                        best_hand = est[p];
+                    }
+                }
+                for (uint8_t p = 0U; p < SOLVER_PROFILE_NUM; p++) {
+                    if (ok[p] && est[p] < best_all + PROFILE_CMP_TIE_MS) {
+                        stat[p].best++;
+                    }
+                }
+                if (best_hand < 0.0) {
+                    continue;
+                }
+                if (!ok[SOLVER_PROFILE_TIME_OPTIMAL]) {
+                    printf("[cmp] LOST  %s mode=%u case=%u\n", names[i]->d_name,
+                           (unsigned int)mode, (unsigned int)ci);
+                    lost++;
+                    continue;
+                }
+                double diff = est[SOLVER_PROFILE_TIME_OPTIMAL] - best_hand;
+                double pct = diff * 100.0 / best_hand;
+                if (pct > PROFILE_CMP_TOL_PCT) {
+                    printf("[cmp] OVER  %s mode=%u case=%u time-optimal=%.1fms best=%.1fms (+%.2f%%)\n",
+                           names[i]->d_name, (unsigned int)mode, (unsigned int)ci,
+                           est[SOLVER_PROFILE_TIME_OPTIMAL], best_hand, pct);
+                    over++;
+                } else if (diff >= PROFILE_CMP_TIE_MS) {
+                    slower++;
+                    if (verbose) {
+                        printf("[cmp] SLOW  %s mode=%u case=%u time-optimal=%.1fms best=%.1fms\n",
+                               names[i]->d_name, (unsigned int)mode, (unsigned int)ci,
+                               est[SOLVER_PROFILE_TIME_OPTIMAL], best_hand);
+                    }
+                }
+                if (pct > worst_pct) {
+                    worst_pct = pct;
+                }
+                if (diff > worst_ms) {
+                    worst_ms = diff;
+                    snprintf(worst, sizeof(worst), "%.63s mode=%u case=%u", names[i]->d_name,
+                             (unsigned int)mode, (unsigned int)ci);
+                }
+            }
+        }
+    }
+    for (int i = 0; i < n; i++) {
+        free(names[i]);
+    }
+    free(names);
+    solver_force_profile(SOLVER_PROFILE_NONE);
+
+    for (uint8_t p = 0U; p < SOLVER_PROFILE_NUM; p++) {
+        printf("[cmp] profile=%-15s solved=%u/%u est_total=%.1fs best=%u\n", k_profile_name[p],
+               stat[p].solved, entries, stat[p].total_ms / 1000.0, stat[p].best);
+    }
+    printf("[cmp] time-optimal slower_than_best_hand=%u worst=+%.1fms (%s) worst_pct=+%.2f%% "
+           "over_tolerance=%u (>%.1f%%) lost=%u\n",
+           slower + over, worst_ms, worst, worst_pct, over, PROFILE_CMP_TOL_PCT, lost);
+    printf("[cmp] result=%s\n", (lost == 0U && over == 0U) ? "ok" : "NG");
+    return lost == 0U && over == 0U;
+}
+
+// ---- 段階ごとの時間・容量レポート ----
+// 探索（差分更新歩数マップ / ビットボード全面展開）・ソルバ（迷路構築+探索 / 走行パス変換）・
+// NVM 保存の各段階について、迷路ごとの所要時間と、MAZE_SIZE で決まる静的作業領域を出す。
+typedef struct {
+    double search_us;
+    double path_us;
+    unsigned int heap_peak;
+    unsigned long closed;
+    unsigned int overflow;
+    unsigned int failed;
+} StepReportSolve;
+
+static void step_report_solve(unsigned int iterations, StepReportSolve *out)
+{
+    memset(out, 0, sizeof(*out));
+    solver_set_clock(host_clock_us);
+    for (uint8_t mode = BATCH_MODE_FIRST; mode <= BATCH_MODE_LAST; mode++) {
+        for (uint8_t ci = 1U; ci <= BATCH_CASE_NUM; ci++) {
+            uint64_t search_sum = 0U;
+            uint64_t path_sum = 0U;
+            solver_stats_t st;
+            bool ok = true;
+
+            // 1us 刻みの時計なので iterations 回の平均を使う
+            for (unsigned int k = 0U; k < iterations; k++) {
+                ok = solver_build_path(mode, ci) && ok;
+                solver_get_stats(&st);
+                search_sum += st.search_us;
+                path_sum += st.path_us;
+            }
+            if (!ok) {
+                out->failed++;
+            }
+            if ((double)search_sum / iterations > out->search_us) {
+                out->search_us = (double)search_sum / iterations;
+            }
+            if ((double)path_sum / iterations > out->path_us) {
+                out->path_us = (double)path_sum / iterations;
+            }
+            if (st.heap_peak > out->heap_peak) {
+                out->heap_peak = st.heap_peak;
+            }
+            if (st.closed > out->closed) {
+                out->closed = st.closed;
+            }
+            out->overflow += st.overflow;
+        }
+    }
+    solver_set_clock(NULL);
+}
+
+static void step_report_memory(void)
+{
+    solver_stats_t st;
+    const size_t cells = (size_t)MAZE_SIZE * MAZE_SIZE;
+
+    solver_get_stats(&st);
+    // search.c: map / smap / visited / 差分更新歩数マップ / make_smap() のビットボード
+    printf("[step-mem] maze_size=%u search=%zu (map=%zu smap=%zu visited=%zu step_map=%zu bitboard=%zu)\n",
+           (unsigned int)MAZE_SIZE,
+           sizeof(map) + sizeof(smap) + sizeof(visited) + sizeof(step_map_t) + sizeof(maze_bitboard_t),
+           sizeof(map), sizeof(smap), sizeof(visited), sizeof(step_map_t), sizeof(maze_bitboard_t));
+    printf("[step-mem] solver=%zu (work=%u heap_cap=%u maze=%zu path_cell=%zu)\n",
+           (size_t)st.work_bytes + sizeof(maze) + sizeof(path_cell), (unsigned int)st.work_bytes,
+           (unsigned int)st.heap_cap, sizeof(maze), sizeof(path_cell));
+    // path.c の後段処理は path[] と同じ長さの作業配列を 3 本持つ
+    printf("[step-mem] path=%zu (path=%zu route=%zu work=%zu) speed_plan=%zu\n",
+           sizeof(path) + sizeof(route) + 3U * sizeof(path), sizeof(path), sizeof(route),
+           3U * sizeof(path), sizeof(path_speed_plan_t));
+    // nvm_maze_save_map(): 16B ヘッダ + 1 区画 2B。map[] から直接書くので作業配列は無い
+    printf("[step-mem] nvm_blob=%zu (header=16 cells=%zu x 2B) staging=0\n", 16U + cells * 2U, cells);
+}
+
+static bool run_step_report(const char *dir_name, unsigned int iterations, unsigned int max_steps)
+{
+    struct dirent **names = NULL;
+    unsigned int failed = 0U;
+    double search_max = 0.0;
+    double solve_max = 0.0;
+    unsigned int heap_peak_max = 0U;
+    int n = scandir(dir_name, &names, batch_maze_filter, alphasort);
+
+    if (n <= 0) {
+        fprintf(stderr, "no .maze files in %s\n", dir_name);
+        free(names);
+        return false;
+    }
+    for (int i = 0; i < n; i++) {
+        char file[1024];
+        StepReportSolve sv;
+        const SmapCheckStat *inc = &s_smap_stat[STEP_MAP_TARGET_GOAL];
+        int saved_stdout;
+        int null_fd;
+        bool explore_ok;
+
+        snprintf(file, sizeof(file), "%s/%s", dir_name, names[i]->d_name);
+        if (!load_maze_text_file(file)) {
+            fprintf(stderr, "[step] failed on %s\n", file);
+            failed++;
+            free(names[i]);
+            continue;
+        }
+
+        // 探索シミュレーションと solver.c の表示は捨てる
+        fflush(stdout);
+        saved_stdout = dup(STDOUT_FILENO);
+        null_fd = open("/dev/null", O_WRONLY);
+        if (saved_stdout >= 0 && null_fd >= 0) {
+            dup2(null_fd, STDOUT_FILENO);
+        }
+        memset(s_smap_stat, 0, sizeof(s_smap_stat));
+        s_explore_steps = 0U;
+        explore_ok = run_explore_sim(max_steps, false, true, false);
+        step_report_solve(iterations, &sv);
+        fflush(stdout);
+        if (saved_stdout >= 0) {
+            dup2(saved_stdout, STDOUT_FILENO);
+            close(saved_stdout);
+        }
+        if (null_fd >= 0) {
+            close(null_fd);
+        }
+
+        const double steps = (s_explore_steps > 0U) ? (double)s_explore_steps : 1.0;
+        printf("[step] %s explore=%s steps=%u search_inc_us=%.2f/%.2f search_bb_us=%.2f/%.2f "
+               "solve_search_us=%.1f solve_path_us=%.1f heap_peak=%u closed=%lu overflow=%u failed=%u\n",
+               names[i]->d_name, explore_ok ? "ok" : "NG", s_explore_steps,
+               inc->inc_us_sum / steps, inc->inc_us_max, inc->bb_us_sum / steps, inc->bb_us_max,
+               sv.search_us, sv.path_us, sv.heap_peak, sv.closed, sv.overflow, sv.failed);
+        if (!explore_ok || sv.failed != 0U || sv.overflow != 0U) {
+            failed++;
+        }
+        if (inc->inc_us_max > search_max) {
+            search_max = inc->inc_us_max;
+        }
+        if (sv.search_us + sv.path_us > solve_max) {
+            solve_max = sv.search_us + sv.path_us;
+        }
+        if (sv.heap_peak > heap_peak_max) {
+            heap_peak_max = sv.heap_peak;
+        }
+        free(names[i]);
+    }
+    free(names);
+
+    step_report_memory();
+    printf("[step] mazes=%d search_inc_max_us=%.2f solve_max_us=%.1f heap_peak_max=%u failed=%u\n",
+           n, search_max, solve_max, heap_peak_max, failed);
+    printf("[step] result=%s\n", (failed == 0U) ? "ok" : "NG");
+    return failed == 0U;
+}
+
+// コーパスの各迷路で探索シミュレーションを行い、背景再計算の採用率と同期計算との一致を表示する
+static bool run_bg_replan_check(const char *dir_name, unsigned int max_steps)
+{
+    struct dirent **names = NULL;
+    BgCheckStat sum[BG_CHECK_TARGET_NUM];
+    unsigned int failed = 0U;
+    int n = scandir(dir_name, &names, batch_maze_filter, alphasort);
+
+    if (n <= 0) {
+        fprintf(stderr, "no .maze files in %s\n", dir_name);
+        free(names);
+        return false;
+    }
+    memset(sum, 0, sizeof(sum));
+    for (int i = 0; i < n; i++) {
+        char file[1024];
+        int saved_stdout;
+        int null_fd;
+        bool explore_ok;
+
+        snprintf(file, sizeof(file), "%s/%s", dir_name, names[i]->d_name);
+        if (!load_maze_text_file(file)) {
+            fprintf(stderr, "[bg-replan] failed on %s\n", file);
+            failed++;
+            free(names[i]);
+            continue;
+        }
+
+        // 探索シミュレーションの表示は捨てる（不一致の詳細は --explore-bg-check で確認する）
+        fflush(stdout);
+        saved_stdout = dup(STDOUT_FILENO);
+        null_fd = open("/dev/null", O_WRONLY);
+        if (saved_stdout >= 0 && null_fd >= 0) {
+            dup2(null_fd, STDOUT_FILENO);
+        }
+        explore_ok = run_explore_sim(max_steps, false, false, true);
+        fflush(stdout);
+        if (saved_stdout >= 0) {
+            dup2(saved_stdout, STDOUT_FILENO);
+            close(saved_stdout);
+        }
+        if (null_fd >= 0) {
+            close(null_fd);
+        }
+
+        printf("[bg-replan] %s explore=%s", names[i]->d_name, explore_ok ? "ok" : "NG");
+        for (unsigned int t = 0U; t < BG_CHECK_TARGET_NUM; t++) {
+            const BgCheckStat *st = &s_bg_stat[t];
+            printf(" %s=%u/%u/%u/%u/%u", s_bg_check_name[t], st->hits, st->reroutes, st->fallbacks,
+                   st->unarmed, st->mismatches);
+            sum[t].hits += st->hits;
+            sum[t].reroutes += st->reroutes;
+            sum[t].fallbacks += st->fallbacks;
+            sum[t].unarmed += st->unarmed;
+            sum[t].mismatches += st->mismatches;
+        }
+        printf("\n");
+        if (!explore_ok) {
+            failed++;
+        }
+        free(names[i]);
+    }
+    free(names);
+
+    // 1区画あたり hits/reroutes/fallbacks/unarmed/mismatches の合計
+    for (unsigned int t = 0U; t < BG_CHECK_TARGET_NUM; t++) {
+        const unsigned int total = sum[t].hits + sum[t].reroutes + sum[t].fallbacks + sum[t].unarmed;
+        printf("[bg-replan] total target=%s cells=%u hits=%u reroutes=%u fallbacks=%u unarmed=%u mismatches=%u hit_rate=%.1f%%\n",
+               s_bg_check_name[t], total, sum[t].hits, sum[t].reroutes, sum[t].fallbacks,
+               sum[t].unarmed, sum[t].mismatches,
+               (total > 0U) ? (100.0 * (double)(sum[t].hits + sum[t].reroutes) / (double)total) : 0.0);
+    }
+    printf("[bg-replan] mazes=%d failed=%u\n", n, failed);
+    printf("[bg-replan] result=%s\n", (failed == 0U) ? "ok" : "NG");
+    return failed == 0U;
+}
+
+// ---- 全面探索の探索対象の比較（search.c の SEARCH_FULL_TARGETED） ----
+// 全ての未探索区画を起点にする方式（all）と、search_target.c の候補区画だけを起点にして上下界の一致で
+// 終える方式（target）で全面探索を最後まで走らせ、移動区画数・探索済区画数・探索時間の見積もりを比べる。
+// スタートから全面探索する場合（mode1-2）と、ゴール探索のあとにゴールから全面探索する場合（mode1-1）の 2 通り。
+// 探索時間の見積もりは searchRunParams[0]: 1 区画（90°ターンを含む）を velocity_turn90 で走り、
+// U ターンは半区画ずつの減速・加速（acceleration_straight）と EXPLORE_FULL_ROTATE_MS の超信地旋回を足す。
+// 探索後の地図（未知壁は壁）で --mode/--case の最短走行を作り、全て既知の場合との差も出す。
+// 最短走行はゴール後に壁まで直進で延長するため、ゴールの先を探索しない target では延長が短くなり、
+// run_ms が known_run_ms と食い違うことがある。食い違った件数を short/long として数える
+// （ゴール区画は候補に含めるので、未探索のゴール区画が残ったら失敗）。
+#define EXPLORE_FULL_ROTATE_MS 400.0
+#define EXPLORE_FULL_POLICY_NUM 2U
+#define EXPLORE_FULL_FROM_NUM 2U
+
+typedef struct {
+    unsigned int steps;   // 移動した区画数
+    unsigned int uturns;  // U ターンの回数
+    unsigned int visited; // 終了時の探索済区画数
+    double search_s;      // 探索時間の見積もり
+    double plan_us;       // 1 区画あたりの起点選択 + 歩数マップ作成の時間（ホスト）
+    double run_ms;        // 探索後の地図での最短走行の見積もり（作れなければ負）
+    bool optimal;         // 探索後の上界が真の最短歩数と一致した
+    bool ok;
+    unsigned int goal_left; // 終了時に未探索のまま残ったゴール区画の数
+    unsigned int run_short; // run_ms が known_run_ms より短かった迷路数（集計用）
+    unsigned int run_long;  // 同 長かった迷路数
+} ExploreFullStat;
+
+// run_ms と known_run_ms を同じとみなす幅 [ms]
+#define EXPLORE_FULL_RUN_EPS_MS 0.5
+
+static const char *const s_explore_full_policy[EXPLORE_FULL_POLICY_NUM] = {"all", "target"};
+static const char *const s_explore_full_from[EXPLORE_FULL_FROM_NUM] = {"start", "goal"};
+
+static double explore_full_move_s(uint8_t rel)
+{
+    const double v = (double)searchRunParams[0].velocity_turn90;
+    const double a = (double)searchRunParams[0].acceleration_straight;
+    double t = 2.0 * DIST_HALF_SEC / v;
+
+    if (rel == 2U) {
+        t += 2.0 * (v / a - DIST_HALF_SEC / v) + EXPLORE_FULL_ROTATE_MS / 1000.0;
+    }
+    return t;
+}
+
+// 壁を全て知っている場合のスタート→ゴール歩数
+static uint16_t explore_full_true_steps(void)
+{
+    static uint16_t truth[MAZE_SIZE][MAZE_SIZE];
+    maze_row_t seed[MAZE_SIZE];
+
+    for (uint8_t y = 0U; y < MAZE_SIZE; y++) {
+        for (uint8_t x = 0U; x < MAZE_SIZE; x++) {
+            truth[y][x] = s_walls_bl[y][x];
+        }
+    }
+    sim_smap_seed_mask(STEP_MAP_TARGET_GOAL, seed);
+    maze_bitboard_build(&s_smap_bb, truth, 0U);
+    return maze_bitboard_flood(&s_smap_bb, seed, s_smap_bb_dist, START_X, START_Y);
+}
+
+// 現在の map[][]（上位4bit）で最短走行を作り、速度計画の所要時間を返す（作れなければ負）
+static double explore_full_run_ms(uint8_t mode, uint8_t case_index)
+{
+    static path_speed_plan_t plan;
+    const ShortestRunModeParams_t *mp = NULL;
+    const ShortestRunCaseParams_t *cp = NULL;
+
+    if (!run_solver_quiet(mode, case_index) || !host_shortest_params(mode, case_index, &mp, &cp) ||
+        !path_speed_plan_build(&plan, path, mp, cp, HOST_F413_PATH_OMEGA_CAP)) {
+        return -1.0;
+    }
+    return (double)plan.total_time_s * 1000.0;
+}
+
+// ゴール探索（run_explore_sim() と同じ進み方）でゴールまで進める
+static bool explore_full_goal_phase(SimMouse *m, unsigned int max_steps)
+{
+    for (unsigned int step = 0U; step <= max_steps; step++) {
+        uint8_t rel;
+
+        sim_write_map_cell(m->x, m->y, m->dir, sim_relative_wall_info(m->x, m->y, m->dir));
+        visited[m->y][m->x] = true;
+        if (sim_is_goal(m->x, m->y)) {
+            return true;
+        }
+        if (sim_make_goal_smap(m) < 0 || !sim_next_move(m, &rel) || !sim_apply_move(m, rel)) {
+            return false;
+        }
+    }
+    return false;
+}
+
+// 区画 m から全面探索を終わりまで進める（conf_route() の全面探索と同じ順に判定する）
+static void explore_full_search(SimMouse *m, bool targeted, unsigned int max_steps,
+                                ExploreFullStat *st)
+{
+    static search_target_t target;
+    static maze_bitboard_t bb;
+    maze_row_t goal_seed[MAZE_SIZE];
+    double plan_us = 0.0;
+    unsigned int plans = 0U;
+
+    sim_smap_seed_mask(STEP_MAP_TARGET_GOAL, goal_seed);
+    st->ok = false;
+    for (unsigned int step = 0U; step <= max_steps; step++) {
+        maze_row_t seed[MAZE_SIZE];
+        uint16_t d;
+        uint8_t rel;
+        double t0;
+
+        sim_write_map_cell(m->x, m->y, m->dir, sim_relative_wall_info(m->x, m->y, m->dir));
+        visited[m->y][m->x] = true;
+        visited[START_Y][START_X] = true;
+
+        t0 = host_now_us();
+        if (targeted) {
+            search_target_update(&target, map, visited, goal_seed, START_X, START_Y);
+            memcpy(seed, target.cand, sizeof(seed));
+        } else {
+            sim_smap_seed_mask(STEP_MAP_TARGET_UNVISITED, seed);
+        }
+        maze_bitboard_build(&bb, map, 0U);
+        d = maze_bitboard_flood(&bb, seed, smap, m->x, m->y);
+        plan_us += host_now_us() - t0;
+        plans++;
+
+        if (d == MAZE_BITBOARD_UNREACHED || (targeted && target.done)) {
+            st->ok = true;
+            break;
+        }
+        if (!sim_next_move(m, &rel) || !sim_apply_move(m, rel)) {
+            break;
+        }
+        st->steps++;
+        st->search_s += explore_full_move_s(rel);
+        if (rel == 2U) {
+            st->uturns++;
+        }
+    }
+    st->plan_us = (plans > 0U) ? plan_us / (double)plans : 0.0;
+}
+
+static void explore_full_run(bool targeted, bool from_goal, uint8_t mode, uint8_t case_index,
+                             unsigned int max_steps, uint16_t true_steps, ExploreFullStat *st)
+{
+    static search_target_t bound;
+    SimMouse m = {START_X, START_Y, 0U};
+    maze_row_t goal_seed[MAZE_SIZE];
+
+    memset(st, 0, sizeof(*st));
+    sim_init_search_map();
+    if (from_goal && !explore_full_goal_phase(&m, max_steps)) {
+        return;
+    }
+    explore_full_search(&m, targeted, max_steps, st);
+    sim_smap_seed_mask(STEP_MAP_TARGET_GOAL, goal_seed);
+    for (uint8_t y = 0U; y < MAZE_SIZE; y++) {
+        for (uint8_t x = 0U; x < MAZE_SIZE; x++) {
+            st->visited += visited[y][x] ? 1U : 0U;
+            if (!visited[y][x] && ((goal_seed[y] >> x) & 1U) != 0U) {
+                st->goal_left++;
+            }
+        }
+    }
+    search_target_update(&bound, map, visited, goal_seed, START_X, START_Y);
+    st->optimal = (bound.d_wall == true_steps);
+    s_keep_search_map = true;
+    st->run_ms = explore_full_run_ms(mode, case_index);
+    s_keep_search_map = false;
+}
+
+static bool run_explore_full(const char *dir_name, uint8_t mode, uint8_t case_index,
+                             unsigned int max_steps)
+{
+    struct dirent **names = NULL;
+    ExploreFullStat sum[EXPLORE_FULL_FROM_NUM][EXPLORE_FULL_POLICY_NUM];
+    double run_known_sum = 0.0;
+    unsigned int failed = 0U;
+    int n = scandir(dir_name, &names, batch_maze_filter, alphasort);
+
+    if (n <= 0) {
+        fprintf(stderr, "no .maze files in %s\n", dir_name);
+        free(names);
+        return false;
+    }
+    memset(sum, 0, sizeof(sum));
+    printf("[explore-full] mode=%u case=%u v=%.0fmm/s a=%.0fmm/s^2 rotate=%.0fms\n",
+           (unsigned int)mode, (unsigned int)case_index,
+           (double)searchRunParams[0].velocity_turn90,
+           (double)searchRunParams[0].acceleration_straight, EXPLORE_FULL_ROTATE_MS);
+    for (int i = 0; i < n; i++) {
+        char file[1024];
+        uint16_t true_steps;
+        double run_known;
+
+        snprintf(file, sizeof(file), "%s/%s", dir_name, names[i]->d_name);
+        if (!load_maze_text_file(file)) {
+            fprintf(stderr, "[explore-full] failed on %s\n", file);
+            failed++;
+            free(names[i]);
+            continue;
+        }
+        true_steps = explore_full_true_steps();
+        run_known = explore_full_run_ms(mode, case_index); // 読み込み直後は全ての壁が既知
+        run_known_sum += run_known;
+
+        for (unsigned int f = 0U; f < EXPLORE_FULL_FROM_NUM; f++) {
+            for (unsigned int p = 0U; p < EXPLORE_FULL_POLICY_NUM; p++) {
+                ExploreFullStat st;
+                ExploreFullStat *s = &sum[f][p];
+
+                explore_full_run(p == 1U, f == 1U, mode, case_index, max_steps, true_steps, &st);
+                printf("[explore-full] %s from=%s policy=%-6s result=%s steps=%u uturns=%u visited=%u "
+                       "search_s=%.1f plan_us=%.2f run_ms=%.1f known_run_ms=%.1f optimal=%s goal_left=%u\n",
+                       names[i]->d_name, s_explore_full_from[f], s_explore_full_policy[p],
+                       st.ok ? "ok" : "NG", st.steps, st.uturns, st.visited, st.search_s,
+                       st.plan_us, st.run_ms, run_known, st.optimal ? "yes" : "no", st.goal_left);
+                if (!st.ok || !st.optimal || st.run_ms < 0.0 || st.goal_left > 0U) {
+                    failed++;
+                }
+                if (st.run_ms < run_known - EXPLORE_FULL_RUN_EPS_MS) {
+                    s->run_short++;
+                } else if (st.run_ms > run_known + EXPLORE_FULL_RUN_EPS_MS) {
+                    s->run_long++;
+                }
+                s->steps += st.steps;
+                s->uturns += st.uturns;
+                s->visited += st.visited;
+                s->search_s += st.search_s;
+                s->plan_us += st.plan_us;
+                s->run_ms += st.run_ms;
+            }
+        }
+        free(names[i]);
+    }
+    free(names);
+
+    for (unsigned int f = 0U; f < EXPLORE_FULL_FROM_NUM; f++) {
+        const ExploreFullStat *a = &sum[f][0];
+        const ExploreFullStat *t = &sum[f][1];
+        for (unsigned int p = 0U; p < EXPLORE_FULL_POLICY_NUM; p++) {
+            const ExploreFullStat *s = &sum[f][p];
+            printf("[explore-full] total from=%s policy=%-6s steps=%u uturns=%u visited=%u search_s=%.1f "
+                   "plan_us_avg=%.2f run_ms=%.1f known_run_ms=%.1f run_short=%u run_long=%u\n",
+                   s_explore_full_from[f], s_explore_full_policy[p], s->steps, s->uturns, s->visited,
+                   s->search_s, s->plan_us / (double)n, s->run_ms, run_known_sum, s->run_short,
+                   s->run_long);
+        }
+        printf("[explore-full] total from=%s target/all steps=%.1f%% visited=%.1f%% search_s=%.1f%% "
+               "run_ms=%+.1fms\n",
+               s_explore_full_from[f],
+               (a->steps > 0U) ? 100.0 * (double)t->steps / (double)a->steps : 0.0,
+               (a->visited > 0U) ? 100.0 * (double)t->visited / (double)a->visited : 0.0,
+               (a->search_s > 0.0) ? 100.0 * t->search_s / a->search_s : 0.0,
+               t->run_ms - a->run_ms);
+    }
+    printf("[explore-full] mazes=%d failed=%u\n", n, failed);
+    printf("[explore-full] result=%s\n", (failed == 0U) ? "ok" : "NG");
+    return failed == 0U;
+}
+
+//====走行パスコンパイラと従来の段ごとの書き換えの照合====
+
+typedef struct {
+    unsigned int cases;
+    unsigned int mismatches;
+    double new_us;
+    double legacy_us;
+    uint16_t bad_moves[64]; // 最初の不一致の入力（先頭 64 要素）
+    uint16_t bad_num;
+    int bad_type;
+} PathCompileStat;
+
+// moves[] を両方で変換し、path[] 全長が一致するか確かめる（従来側の printf は呼び出し側で捨てる）
+static void path_compile_compare(const uint16_t *moves, uint16_t n, int path_type, PathCompileStat *st)
+{
+    static uint16_t compiled[ROUTE_MAX_LEN];
+    path_compiler_t comp;
+    double t0 = host_now_us();
+
+    path_compile_begin(&comp, path_type);
+    for (uint16_t k = 0U; k < n; k++) {
+        path_compile_push(&comp, moves[k]);
+    }
+    path_compile_end(&comp);
+    double t1 = host_now_us();
+    memcpy(compiled, path, sizeof(compiled));
+    path_compile_legacy(moves, n, path_type);
+    double t2 = host_now_us();
+
+    st->cases++;
+    st->new_us += t1 - t0;
+    st->legacy_us += t2 - t1;
+    if (memcmp(compiled, path, sizeof(compiled)) != 0) {
+        if (st->mismatches == 0U) {
+            st->bad_num = (n < 64U) ? n : 64U;
+            memcpy(st->bad_moves, moves, st->bad_num * sizeof(moves[0]));
+            st->bad_type = path_type;
+        }
+        st->mismatches++;
+    }
+}
+
+static bool path_compile_report(const char *name, const PathCompileStat *st)
+{
+    const double cases = (st->cases > 0U) ? (double)st->cases : 1.0;
+    printf("[path-compile] %s cases=%u mismatches=%u compile_us=%.2f legacy_us=%.2f\n", name, st->cases,
+           st->mismatches, st->new_us / cases, st->legacy_us / cases);
+    if (st->mismatches != 0U) {
+        printf("[path-compile]   first: path_type=%d moves=", st->bad_type);
+        for (uint16_t k = 0U; k < st->bad_num; k++) {
+            printf("%s%c", (k == 0U) ? "" : ",",
+                   (st->bad_moves[k] == STRAIGHT) ? 'S' : (st->bad_moves[k] == TURN_R) ? 'R' : 'L');
+        }
+        printf("\n");
+    }
+    return st->mismatches == 0U;
+}
+
+// コーパスの全迷路・全モード/ケースの経路と、直進・右左折の列の総当たり（先頭は直進、長さ 1..10）・
+// 乱数列（長さ 10..400）を、走行パスコンパイラと従来の 4 関数で変換して照合する
+static bool run_path_compile_check(const char *dir_name)
+{
+    static const uint16_t kMoves[3] = {STRAIGHT, TURN_R, TURN_L};
+    static uint16_t moves[ROUTE_MAX_LEN];
+    struct dirent **names = NULL;
+    PathCompileStat corpus;
+    PathCompileStat all;
+    PathCompileStat rnd;
+    unsigned int failed = 0U;
+    int n = scandir(dir_name, &names, batch_maze_filter, alphasort);
+    int saved_stdout;
+    int null_fd;
+
+    if (n <= 0) {
+        fprintf(stderr, "no .maze files in %s\n", dir_name);
+        free(names);
+        return false;
+    }
+    memset(&corpus, 0, sizeof(corpus));
+    memset(&all, 0, sizeof(all));
+    memset(&rnd, 0, sizeof(rnd));
+
+    fflush(stdout);
+    saved_stdout = dup(STDOUT_FILENO);
+    null_fd = open("/dev/null", O_WRONLY);
+    if (saved_stdout >= 0 && null_fd >= 0) {
+        dup2(null_fd, STDOUT_FILENO);
+    }
+
+    for (int i = 0; i < n; i++) {
+        char file[1024];
+
+        snprintf(file, sizeof(file), "%s/%s", dir_name, names[i]->d_name);
+        if (!load_maze_text_file(file)) {
+            fprintf(stderr, "[path-compile] failed on %s\n", file);
+            failed++;
+            free(names[i]);
+            continue;
+        }
+        for (uint8_t mode = BATCH_MODE_FIRST; mode <= BATCH_MODE_LAST; mode++) {
+            for (uint8_t ci = 1U; ci <= BATCH_CASE_NUM; ci++) {
+                const uint16_t *last = NULL;
+                int path_type = 0;
+                static uint16_t built[ROUTE_MAX_LEN];
+
+                if (!solver_build_path(mode, ci)) {
+                    continue;
+                }
+                // solver_build_path() の出力そのものも照合する
+                memcpy(built, path, sizeof(built));
+                const uint16_t num = solver_get_last_moves(&last, &path_type);
+                memcpy(moves, last, num * sizeof(moves[0]));
+                path_compile_compare(moves, num, path_type, &corpus);
+                if (memcmp(built, path, sizeof(built)) != 0) {
+                    corpus.mismatches++;
+                }
+            }
+        }
+        free(names[i]);
+    }
+    free(names);
+
+    // 総当たり: 3^(len-1) 通り x path_type 0..2
+    for (uint16_t len = 1U; len <= 10U; len++) {
+        uint32_t total = 1U;
+        for (uint16_t k = 1U; k < len; k++) {
+            total *= 3U;
+        }
+        for (uint32_t code = 0U; code < total; code++) {
+            uint32_t c = code;
+            moves[0] = STRAIGHT;
+            for (uint16_t k = 1U; k < len; k++) {
+                moves[k] = kMoves[c % 3U];
+                c /= 3U;
+            }
+            for (int type = 0; type <= 2; type++) {
+                path_compile_compare(moves, len, type, &all);
+            }
+        }
+    }
+
+    // 乱数列: 直進の連続長と左右の偏りを変えながら生成する
+    uint32_t seed = 12345U;
+    for (unsigned int r = 0U; r < 20000U; r++) {
+        seed = seed * 1103515245U + 12345U;
+        const uint16_t len = (uint16_t)(10U + (seed >> 8) % 391U);
+        seed = seed * 1103515245U + 12345U;
+        const uint32_t straight_pct = 10U + (seed >> 8) % 71U;
+        moves[0] = STRAIGHT;
+        for (uint16_t k = 1U; k < len; k++) {
+            seed = seed * 1103515245U + 12345U;
+            const uint32_t v = (seed >> 8) % 100U;
+            moves[k] = (v < straight_pct) ? STRAIGHT : ((v & 1U) != 0U) ? TURN_R : TURN_L;
+        }
+        path_compile_compare(moves, len, (int)(r % 3U), &rnd);
+    }
+
+    fflush(stdout);
+    if (saved_stdout >= 0) {
+        dup2(saved_stdout, STDOUT_FILENO);
+        close(saved_stdout);
+    }
+    if (null_fd >= 0) {
+        close(null_fd);
+    }
+
+    bool ok = (failed == 0U);
+    ok = path_compile_report("corpus", &corpus) && ok;
+    ok = path_compile_report("exhaustive", &all) && ok;
+    ok = path_compile_report("random", &rnd) && ok;
+    printf("[path-compile] result=%s\n", ok ? "ok" : "NG");
+    return ok;
+}
+
+int main(int argc, char **argv)
+{
+    const char *maze_file = NULL;
+    const char *maze_text_file = NULL;
+    const char *search_dump_file = NULL;
+    bool top_left_origin = true;
+    bool verbose_solver = false;
+    bool explore_sim = false;
+    bool explore_verbose = false;
+    bool explore_smap_check = false;
+    bool explore_bg_check = false;
+    unsigned int max_steps = 2048U;
+    unsigned int bench_iterations = 0U;
+    bool turn_profile_check = false;
+    bool straight_profile_check = false;
+    bool speed_plan = false;
+    const char *batch_dir = NULL;
+    const char *profile_compare_dir = NULL;
+    const char *step_report_dir = NULL;
+    const char *bg_replan_dir = NULL;
+    const char *explore_full_dir = NULL;
+    const char *path_compile_dir = NULL;
+    int solver_profile = -1;
+    const char *golden_file = NULL;
+    bool update_golden = false;
+    unsigned int batch_iterations = 20U;
+    double time_tol_pct = 25.0;
+    uint8_t mode = 2U;
+    uint8_t case_index = 1U;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--maze-c-array") == 0 && (i + 1) < argc) {
+            maze_file = argv[++i];
+        } else if (strcmp(argv[i], "--maze") == 0 && (i + 1) < argc) {
+            maze_text_file = argv[++i];
+        } else if (strcmp(argv[i], "--search-dump") == 0 && (i + 1) < argc) {
+            search_dump_file = argv[++i];
+        } else if (strcmp(argv[i], "--origin") == 0 && (i + 1) < argc) {
+            const char *origin = argv[++i];
+            if (strcmp(origin, "top-left") == 0) {
+                top_left_origin = true;
+            } else if (strcmp(origin, "bottom-left") == 0) {
+                top_left_origin = false;
+            } else {
+                print_usage(argv[0]);
+                return 2;
+            }
+        } else if (strcmp(argv[i], "--mode") == 0 && (i + 1) < argc) {
+            mode = (uint8_t)strtoul(argv[++i], NULL, 0);
+        } else if (strcmp(argv[i], "--case") == 0 && (i + 1) < argc) {
+            case_index = (uint8_t)strtoul(argv[++i], NULL, 0);
+        } else if (strcmp(argv[i], "--verbose-solver") == 0) {
+            verbose_solver = true;
         } else if (strcmp(argv[i], "--explore-sim") == 0) {
             explore_sim = true;
         } else if (strcmp(argv[i], "--explore-verbose") == 0) {
             explore_verbose = true;
+        } else if (strcmp(argv[i], "--explore-smap-check") == 0) {
+            explore_smap_check = true;
+        } else if (strcmp(argv[i], "--explore-bg-check") == 0) {
+            explore_bg_check = true;
+        } else if (strcmp(argv[i], "--bg-replan-check") == 0 && (i + 1) < argc) {
+            bg_replan_dir = argv[++i];
+        } else if (strcmp(argv[i], "--explore-full") == 0 && (i + 1) < argc) {
+            explore_full_dir = argv[++i];
+        } else if (strcmp(argv[i], "--path-compile-check") == 0 && (i + 1) < argc) {
+            path_compile_dir = argv[++i];
         } else if (strcmp(argv[i], "--max-steps") == 0 && (i + 1) < argc) {
             max_steps = (unsigned int)strtoul(argv[++i], NULL, 0);
+        } else if (strcmp(argv[i], "--bench") == 0 && (i + 1) < argc) {
+            bench_iterations = (unsigned int)strtoul(argv[++i], NULL, 0);
+        } else if (strcmp(argv[i], "--speed-plan") == 0) {
+            speed_plan = true;
+        } else if (strcmp(argv[i], "--turn-profile-check") == 0) {
+            turn_profile_check = true;
+        } else if (strcmp(argv[i], "--straight-profile-check") == 0) {
+            straight_profile_check = true;
+        } else if (strcmp(argv[i], "--solver-profile") == 0 && (i + 1) < argc) {
+            solver_profile = (int)strtol(argv[++i], NULL, 0);
+        } else if (strcmp(argv[i], "--profile-compare") == 0 && (i + 1) < argc) {
+            profile_compare_dir = argv[++i];
+        } else if (strcmp(argv[i], "--step-report") == 0 && (i + 1) < argc) {
+            step_report_dir = argv[++i];
+        } else if (strcmp(argv[i], "--batch") == 0 && (i + 1) < argc) {
+            batch_dir = argv[++i];
+        } else if (strcmp(argv[i], "--golden") == 0 && (i + 1) < argc) {
+            golden_file = argv[++i];
+        } else if (strcmp(argv[i], "--update-golden") == 0) {
+            update_golden = true;
+        } else if (strcmp(argv[i], "--batch-iterations") == 0 && (i + 1) < argc) {
+            batch_iterations = (unsigned int)strtoul(argv[++i], NULL, 0);
+        } else if (strcmp(argv[i], "--time-tolerance") == 0 && (i + 1) < argc) {
+            time_tol_pct = strtod(argv[++i], NULL);
         } else if (strcmp(argv[i], "--help") == 0) {
             print_usage(argv[0]);
             return 0;
@@ -801,6 +3036,50 @@ int main(int argc, char **argv)
         }
     }
 
+    if (turn_profile_check) {
+        return run_turn_profile_check() ? 0 : 1;
+    }
+
+    if (straight_profile_check) {
+        return run_straight_profile_check() ? 0 : 1;
+    }
+
+    if (profile_compare_dir != NULL) {
+        return run_profile_compare(profile_compare_dir, verbose_solver) ? 0 : 1;
+    }
+
+    if (step_report_dir != NULL) {
+        return run_step_report(step_report_dir, batch_iterations, max_steps) ? 0 : 1;
+    }
+
+    if (bg_replan_dir != NULL) {
+        return run_bg_replan_check(bg_replan_dir, max_steps) ? 0 : 1;
+    }
+
+    if (explore_full_dir != NULL) {
+        return run_explore_full(explore_full_dir, mode, case_index, max_steps) ? 0 : 1;
+    }
+
+    if (path_compile_dir != NULL) {
+        return run_path_compile_check(path_compile_dir) ? 0 : 1;
+    }
+
+    if (solver_profile >= 0) {
+        if (solver_profile >= (int)SOLVER_PROFILE_NUM) {
+            print_usage(argv[0]);
+            return 2;
+        }
+        solver_force_profile((uint8_t)solver_profile);
+    }
+
+    if (batch_dir != NULL) {
+        if (batch_iterations == 0U || (update_golden && golden_file == NULL)) {
+            print_usage(argv[0]);
+            return 2;
+        }
+        return run_batch(batch_dir, golden_file, update_golden, batch_iterations, time_tol_pct) ? 0 : 1;
+    }
+
     if (search_dump_file != NULL) {
         if (maze_text_file != NULL || maze_file != NULL) {
             print_usage(argv[0]);
@@ -832,7 +3111,7 @@ int main(int argc, char **argv)
                (unsigned int)START_X, (unsigned int)START_Y,
                (unsigned int)GOAL_X, (unsigned int)GOAL_Y,
                max_steps, s_width, s_height);
-        return run_explore_sim(max_steps, explore_verbose) ? 0 : 1;
+        return run_explore_sim(max_steps, explore_verbose, explore_smap_check, explore_bg_check) ? 0 : 1;
     }
 
     printf("[host] solver_build_path mode=%u case=%u start=(%u,%u) goal=(%u,%u) firmware_maze_size=%u\n",
@@ -841,11 +3120,18 @@ int main(int argc, char **argv)
            (unsigned int)GOAL_X, (unsigned int)GOAL_Y,
            (unsigned int)MAZE_SIZE);
 
+    if (bench_iterations > 0U) {
+        return run_solver_bench(mode, case_index, bench_iterations) ? 0 : 1;
+    }
+
     bool ok = verbose_solver ? solver_build_path(mode, case_index) : run_solver_quiet(mode, case_index);
     printf("[host] result=%s\n", ok ? "ok" : "failed");
     if (!ok) {
         return 1;
     }
     print_path_summary();
+    if (speed_plan && !print_speed_plan(mode, case_index)) {
+        return 1;
+    }
     return 0;
 }